@@ -21,6 +21,7 @@
 #include "Simd/Simd.h"
 #include "Core/JointPose.h"
 #include "Game/Entity.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -348,6 +349,8 @@ void Animator::PushStateBlenders(int layerNum, int currentTime, int blendDuratio
 }
 
 void Animator::ComputeFrame(int currentTime) {
+    BE_PROFILE_SCOPE("Animator::ComputeFrame");
+
     const JointPose *bindPoses = animController->GetBindPoses();
     if (!bindPoses) {
         BE_WARNLOG(L"Animator::ComputeFrame: no bindPoses on '%hs'\n", animController->GetHashName());
@@ -93,12 +93,31 @@ void ComRenderable::Init() {
 
 void ComRenderable::OnActive() {
     UpdateVisuals();
+
+    if (renderObjectHandle != -1) {
+        renderWorld->ShowRenderObject(renderObjectHandle);
+    }
+}
+
+// Returns true if the entity or one of its ancestors is recycled by an entity pool.
+static bool IsInEntityPool(const Entity *entity) {
+    for (; entity; entity = entity->GetParent()) {
+        if (entity->IsPooled()) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void ComRenderable::OnInactive() {
     if (renderObjectHandle != -1) {
-        renderWorld->RemoveRenderObject(renderObjectHandle);
-        renderObjectHandle = -1;
+        if (IsInEntityPool(GetEntity())) {
+            // Keep render object allocated so that reacquiring from the pool doesn't have to recreate it
+            renderWorld->HideRenderObject(renderObjectHandle);
+        } else {
+            renderWorld->RemoveRenderObject(renderObjectHandle);
+            renderObjectHandle = -1;
+        }
     }
 }
 
@@ -127,6 +146,9 @@ void ComRenderable::UpdateVisuals() {
     } else {
         renderWorld->UpdateRenderObject(renderObjectHandle, &renderObjectDef);
     }
+
+    // Bounds for ray intersection might be changed
+    GetEntity()->InvalidateQueryBounds();
 }
 
 bool ComRenderable::IsVisibleInPreviousFrame() const {
@@ -379,7 +379,10 @@ void ComRigidBody::OnActive() {
 
 void ComRigidBody::OnInactive() {
     if (body) {
+        // Keep the body allocated, but don't carry over the velocities to the next activation (e.g. entity pooling)
         body->RemoveFromWorld();
+        body->SetLinearVelocity(Vec3::zero);
+        body->SetAngularVelocity(Vec3::zero);
     }
     collisions.Clear();
     oldCollisions.Clear();
@@ -20,6 +20,8 @@
 #include "Components/ComTransform.h"
 #include "Components/ComRigidBody.h"
 #include "Game/GameWorld.h"
+#include "Core/BinarySerializer.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -57,6 +59,8 @@ void ComScript::Purge(bool chainPurge) {
     fieldInfos.Clear();
     fieldGuids.Clear();
 
+    propertyInfoTableValid = false;
+
     if (chainPurge) {
         Component::Purge();
     }
@@ -102,12 +106,29 @@ void ComScript::SetOwnerValues() {
     owner["script"] = this;
 }
 
-void ComScript::GetPropertyInfoList(Array<PropertyInfo> &propInfos) const {
-    Component::GetPropertyInfoList(propInfos);
+const PropertyInfoTable &ComScript::GetPropertyInfoTable() const {
+    if (propertyInfoTableValid) {
+        return propertyInfoTables[currentPropertyInfoTable];
+    }
+
+    // Rebuild in the other buffer
+    currentPropertyInfoTable ^= 1;
+
+    PropertyInfoTable &propertyInfoTable = propertyInfoTables[currentPropertyInfoTable];
+    propertyInfoTable.Clear();
+
+    const PropertyInfoTable &metaPropertyInfoTable = Component::GetPropertyInfoTable();
+    for (int index = 0; index < metaPropertyInfoTable.Count(); index++) {
+        propertyInfoTable.Append(metaPropertyInfoTable[index]);
+    }
 
     for (int index = 0; index < fieldInfos.Count(); index++) {
-        propInfos.Append(fieldInfos[index]);
+        propertyInfoTable.Append(fieldInfos[index]);
     }
+
+    propertyInfoTableValid = true;
+
+    return propertyInfoTable;
 }
 
 void ComScript::Deserialize(const Json::Value &in) {
@@ -126,6 +147,38 @@ void ComScript::Deserialize(const Json::Value &in) {
     deserializing = false;
 }
 
+void ComScript::DeserializeBinary(const BinaryObject &in) {
+    // Get the script GUID in binary object
+    Variant scriptGuidValue;
+    BinaryProperty scriptProp = in.FindProperty("script");
+    const Guid scriptGuid = scriptProp.IsValid() && scriptProp.GetValue(Variant::GuidType, scriptGuidValue) ? scriptGuidValue.As<Guid>() : Guid::zero;
+
+    state = &GetGameWorld()->GetLuaVM().State();
+
+    ChangeScript(scriptGuid);
+
+    deserializing = true;
+
+    Serializable::DeserializeBinary(in);
+
+    deserializing = false;
+}
+
+void ComScript::CopyProperties(const Serializable &source, const HashTable<Guid, Guid> *remapGuidMap) {
+    const ComScript &sourceScript = static_cast<const ComScript &>(source);
+
+    state = &GetGameWorld()->GetLuaVM().State();
+
+    // Script properties are available after the script is loaded
+    ChangeScript(sourceScript.scriptGuid);
+
+    deserializing = true;
+
+    Serializable::CopyProperties(source, remapGuidMap);
+
+    deserializing = false;
+}
+
 void ComScript::ChangeScript(const Guid &scriptGuid) {
 #if 1
     // Disconnect with previously connected script asset
@@ -199,6 +252,8 @@ void ComScript::ChangeScript(const Guid &scriptGuid) {
         if (sandbox["properties"].IsTable() && sandbox["property_names"].IsTable()) {
             InitScriptFields();
         }
+
+        propertyInfoTableValid = false;
     }
 
 #if 1
@@ -866,24 +921,32 @@ void ComScript::Start() {
 }
 
 void ComScript::Update() {
+    BE_PROFILE_SCOPE("ComScript::Update");
+
     if (updateFunc.IsValid()) {
         updateFunc();
     }
 }
 
 void ComScript::LateUpdate() {
+    BE_PROFILE_SCOPE("ComScript::LateUpdate");
+
     if (lateUpdateFunc.IsValid()) {
         lateUpdateFunc();
     }
 }
 
 void ComScript::FixedUpdate(float timeStep) {
+    BE_PROFILE_SCOPE("ComScript::FixedUpdate");
+
     if (fixedUpdateFunc.IsValid()) {
         fixedUpdateFunc(timeStep);
     }
 }
 
 void ComScript::FixedLateUpdate(float timeStep) {
+    BE_PROFILE_SCOPE("ComScript::FixedLateUpdate");
+
     if (fixedLateUpdateFunc.IsValid()) {
         fixedLateUpdateFunc(timeStep);
     }
@@ -17,6 +17,8 @@
 #include "Components/ComRigidBody.h"
 #include "Components/ComVehicleWheel.h"
 #include "Game/Entity.h"
+#include "Game/GameWorld.h"
+#include "Game/TransformSystem.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -45,6 +47,18 @@ ComTransform::ComTransform() {
 }
 
 ComTransform::~ComTransform() {
+    Purge(false);
+}
+
+void ComTransform::Purge(bool chainPurge) {
+    if (transformSystem) {
+        transformSystem->Unregister(this);
+        transformSystem = nullptr;
+    }
+
+    if (chainPurge) {
+        Component::Purge();
+    }
 }
 
 ComTransform *ComTransform::GetParent() const { 
@@ -60,10 +74,32 @@ void ComTransform::Init() {
 
     UpdateWorldMatrix();
 
+    TransformSystem *transformSystem = GetGameWorld() ? GetGameWorld()->GetTransformSystem() : nullptr;
+    if (transformSystem && transformSystem->IsEnabled() && !this->transformSystem) {
+        AttachTransformSystem(transformSystem);
+    }
+
     // Mark as initialized
     SetInitialized(true);
 }
 
+void ComTransform::AttachTransformSystem(TransformSystem *transformSystem) {
+    assert(!this->transformSystem);
+
+    this->transformSystem = transformSystem;
+    transformSystem->Register(this);
+}
+
+void ComTransform::DetachTransformSystem() {
+    assert(transformSystem);
+
+    worldMatrix = transformSystem->GetWorldMatrix(transformIndex);
+    worldMatrixInvalidated = false;
+
+    transformSystem->Unregister(this);
+    transformSystem = nullptr;
+}
+
 void ComTransform::SetLocalOrigin(const Vec3 &origin) {
     this->localOrigin = origin;
 
@@ -135,21 +171,21 @@ void ComTransform::SetLocalOriginAxisScale(const Vec3 &origin, const Mat3 &axis,
 }
 
 Vec3 ComTransform::GetOrigin() const {
-    if (worldMatrixInvalidated) {
+    if (worldMatrixInvalidated || transformSystem) {
         UpdateWorldMatrix();
     }
     return worldMatrix.ToTranslationVec3();
 }
 
 Vec3 ComTransform::GetScale() const {
-    if (worldMatrixInvalidated) {
+    if (worldMatrixInvalidated || transformSystem) {
         UpdateWorldMatrix();
     }
     return worldMatrix.ToScaleVec3();
 }
 
 Quat ComTransform::GetRotation() const {
-    if (worldMatrixInvalidated) {
+    if (worldMatrixInvalidated || transformSystem) {
         UpdateWorldMatrix();
     }
     Mat3 rotation = worldMatrix.ToMat3();
@@ -158,7 +194,7 @@ Quat ComTransform::GetRotation() const {
 }
 
 Mat3 ComTransform::GetAxis() const {
-    if (worldMatrixInvalidated) {
+    if (worldMatrixInvalidated || transformSystem) {
         UpdateWorldMatrix();
     }
     Mat3 axis = worldMatrix.ToMat3();
@@ -166,8 +202,8 @@ Mat3 ComTransform::GetAxis() const {
     return axis;
 }
 
-const Mat3x4 &ComTransform::GetMatrix() const {
-    if (worldMatrixInvalidated) {
+Mat3x4 ComTransform::GetMatrix() const {
+    if (worldMatrixInvalidated || transformSystem) {
         UpdateWorldMatrix();
     }
     return worldMatrix;
@@ -298,6 +334,12 @@ void ComTransform::Rotate(const Vec3 &rotVec, float angle, TransformSpace space)
 }
 
 void ComTransform::InvalidateWorldMatrix() {
+    // Batched transform system propagates changes to the children and emits the signal once per frame
+    if (transformSystem) {
+        transformSystem->SetLocalMatrix(transformIndex, GetLocalMatrix());
+        return;
+    }
+
     // Precondition:
     // a) whenever a transform is marked worldMatrixInvalidated, all its children are marked worldMatrixInvalidated as well.
     // b) whenever a transform is cleared from being worldMatrixInvalidated, all its parents must have been cleared as well.
@@ -306,6 +348,8 @@ void ComTransform::InvalidateWorldMatrix() {
     }
     worldMatrixInvalidated = true;
 
+    GetEntity()->InvalidateQueryBounds();
+
     // World matrix should be updated so we emit this signal
     EmitSignal(&SIG_TransformUpdated, this);
 
@@ -326,6 +370,11 @@ void ComTransform::InvalidateWorldMatrix() {
 }
 
 void ComTransform::UpdateWorldMatrix() const {
+    if (transformSystem) {
+        worldMatrix = transformSystem->GetWorldMatrix(transformIndex);
+        return;
+    }
+
     Mat3x4 localTransform = GetLocalMatrix();
 
     const ComTransform *parent = GetParent();
@@ -338,4 +387,10 @@ void ComTransform::UpdateWorldMatrix() const {
     worldMatrixInvalidated = false;
 }
 
+void ComTransform::ParentChanged() {
+    if (transformSystem) {
+        transformSystem->InvalidateHierarchy(transformIndex);
+    }
+}
+
 BE_NAMESPACE_END
@@ -0,0 +1,1048 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Core/BinarySerializer.h"
+#include "Core/Object.h"
+
+BE_NAMESPACE_BEGIN
+
+static const int PropertyHeaderSize = 12;
+static const int ObjectHeaderSize = 8;
+static const int MaxObjectDepth = 64;
+
+// Returns size of a value in bytes. Returns -1 for the types that can't be serialized.
+static int ValueSize(int type) {
+    switch (type) {
+    case Variant::None:         return 0;
+    case Variant::IntType:      return sizeof(int32_t);
+    case Variant::Int64Type:    return sizeof(int64_t);
+    case Variant::BoolType:     return sizeof(uint32_t);
+    case Variant::FloatType:    return sizeof(float);
+    case Variant::DoubleType:   return sizeof(double);
+    case Variant::Vec2Type:     return sizeof(Vec2);
+    case Variant::Vec3Type:     return sizeof(Vec3);
+    case Variant::Vec4Type:     return sizeof(Vec4);
+    case Variant::Color3Type:   return sizeof(Color3);
+    case Variant::Color4Type:   return sizeof(Color4);
+    case Variant::Mat2Type:     return sizeof(Mat2);
+    case Variant::Mat3Type:     return sizeof(Mat3);
+    case Variant::Mat3x4Type:   return sizeof(Mat3x4);
+    case Variant::Mat4Type:     return sizeof(Mat4);
+    case Variant::AnglesType:   return sizeof(Angles);
+    case Variant::QuatType:     return sizeof(Quat);
+    case Variant::PointType:    return sizeof(Point);
+    case Variant::RectType:     return sizeof(Rect);
+    case Variant::GuidType:     return sizeof(Guid);
+    case Variant::StrType:      return sizeof(uint32_t);
+    default:                    return -1;
+    }
+}
+
+// Returns true if the type is stored as string in JSON.
+static bool IsStringCodedType(int type) {
+    switch (type) {
+    case Variant::Vec2Type:
+    case Variant::Vec3Type:
+    case Variant::Vec4Type:
+    case Variant::Color3Type:
+    case Variant::Color4Type:
+    case Variant::Mat2Type:
+    case Variant::Mat3Type:
+    case Variant::Mat3x4Type:
+    case Variant::Mat4Type:
+    case Variant::AnglesType:
+    case Variant::QuatType:
+    case Variant::PointType:
+    case Variant::RectType:
+    case Variant::GuidType:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool IsNumberType(int type) {
+    return type == Variant::IntType || type == Variant::Int64Type || type == Variant::BoolType || type == Variant::FloatType || type == Variant::DoubleType;
+}
+
+template <typename T>
+static BE_INLINE T ReadRaw(const byte *ptr) {
+    T value;
+    memcpy(&value, ptr, sizeof(T));
+    return value;
+}
+
+// Math types are not trivially copyable, so their components are copied through Ptr().
+template <typename T>
+static BE_INLINE T ReadComponents(const byte *ptr) {
+    T value;
+    memcpy(value.Ptr(), ptr, sizeof(T));
+    return value;
+}
+
+static double NumberAsDouble(const Variant &value) {
+    switch (value.GetType()) {
+    case Variant::IntType:      return value.As<int>();
+    case Variant::Int64Type:    return (double)value.As<int64_t>();
+    case Variant::BoolType:     return value.As<bool>() ? 1.0 : 0.0;
+    case Variant::FloatType:    return value.As<float>();
+    case Variant::DoubleType:   return value.As<double>();
+    default:                    return 0.0;
+    }
+}
+
+static int64_t NumberAsInt64(const Variant &value) {
+    switch (value.GetType()) {
+    case Variant::IntType:      return value.As<int>();
+    case Variant::Int64Type:    return value.As<int64_t>();
+    case Variant::BoolType:     return value.As<bool>() ? 1 : 0;
+    case Variant::FloatType:    return (int64_t)value.As<float>();
+    case Variant::DoubleType:   return (int64_t)value.As<double>();
+    default:                    return 0;
+    }
+}
+
+static Json::Value VariantToJson(const Variant &value);
+
+//-------------------------------------------------------------------------------------------------
+
+const char *BinaryProperty::GetName() const {
+    if (!ptr) {
+        return "";
+    }
+    return reader->GetString(ReadRaw<uint32_t>(ptr));
+}
+
+int BinaryProperty::GetType() const {
+    if (!ptr) {
+        return Variant::None;
+    }
+    return ReadRaw<int16_t>(ptr + 4);
+}
+
+bool BinaryProperty::IsArray() const {
+    if (!ptr) {
+        return false;
+    }
+    return !!(ReadRaw<uint16_t>(ptr + 6) & ArrayFlag);
+}
+
+int BinaryProperty::Count() const {
+    if (!ptr) {
+        return 0;
+    }
+    return IsArray() ? ReadRaw<uint32_t>(Payload()) : 1;
+}
+
+const byte *BinaryProperty::ElementPtr(int elementIndex) const {
+    const byte *elements = IsArray() ? Payload() + sizeof(uint32_t) : Payload();
+    return elements + elementIndex * ValueSize(GetType());
+}
+
+bool BinaryProperty::GetValue(Variant &out, int elementIndex) const {
+    if (!ptr) {
+        return false;
+    }
+
+    int type = GetType();
+    if (type == ListType) {
+        BinaryProperty element = GetListElement(elementIndex);
+        return element.IsValid() && !element.IsArray() && element.GetValue(out);
+    }
+
+    if (type == ObjectType || elementIndex < 0 || elementIndex >= Count()) {
+        return false;
+    }
+
+    const byte *src = ElementPtr(elementIndex);
+
+    switch (type) {
+    case Variant::None:         out = Variant(); break;
+    case Variant::IntType:      out = ReadRaw<int32_t>(src); break;
+    case Variant::Int64Type:    out = ReadRaw<int64_t>(src); break;
+    case Variant::BoolType:     out = ReadRaw<uint32_t>(src) != 0; break;
+    case Variant::FloatType:    out = ReadRaw<float>(src); break;
+    case Variant::DoubleType:   out = ReadRaw<double>(src); break;
+    case Variant::Vec2Type:     out = ReadComponents<Vec2>(src); break;
+    case Variant::Vec3Type:     out = ReadComponents<Vec3>(src); break;
+    case Variant::Vec4Type:     out = ReadComponents<Vec4>(src); break;
+    case Variant::Color3Type:   out = ReadComponents<Color3>(src); break;
+    case Variant::Color4Type:   out = ReadComponents<Color4>(src); break;
+    case Variant::Mat2Type:     out = ReadComponents<Mat2>(src); break;
+    case Variant::Mat3Type:     out = ReadComponents<Mat3>(src); break;
+    case Variant::Mat3x4Type:   out = ReadComponents<Mat3x4>(src); break;
+    case Variant::Mat4Type:     out = ReadComponents<Mat4>(src); break;
+    case Variant::AnglesType:   out = ReadComponents<Angles>(src); break;
+    case Variant::QuatType:     out = ReadComponents<Quat>(src); break;
+    case Variant::PointType:    out = ReadComponents<Point>(src); break;
+    case Variant::RectType:     out = ReadComponents<Rect>(src); break;
+    case Variant::GuidType:     out = ReadRaw<Guid>(src); break;
+    case Variant::StrType:      out = Str(reader->GetString(ReadRaw<uint32_t>(src))); break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+bool BinaryProperty::GetValue(Variant::Type type, Variant &out, int elementIndex) const {
+    if (!ptr) {
+        return false;
+    }
+
+    int storedType = GetType();
+    if (storedType == type) {
+        return GetValue(out, elementIndex);
+    }
+
+    if (storedType == ListType) {
+        BinaryProperty element = GetListElement(elementIndex);
+        return element.IsValid() && !element.IsArray() && element.GetValue(type, out);
+    }
+
+    if (IsStringCodedType(storedType) && type == Variant::StrType) {
+        // Strings that look like GUIDs are stored as Guid
+        Variant value;
+        if (!GetValue(value, elementIndex)) {
+            return false;
+        }
+        out = Str(VariantToJson(value).asCString());
+        return true;
+    }
+
+    if (storedType == Variant::StrType && IsStringCodedType(type)) {
+        // Values that didn't survive JSON conversion as native type are kept as strings
+        if (elementIndex < 0 || elementIndex >= Count()) {
+            return false;
+        }
+        return out.SetFromString(type, reader->GetString(ReadRaw<uint32_t>(ElementPtr(elementIndex))));
+    }
+
+    if (IsNumberType(storedType) && IsNumberType(type)) {
+        Variant number;
+        if (!GetValue(number, elementIndex)) {
+            return false;
+        }
+
+        switch (type) {
+        case Variant::IntType:      out = (int)NumberAsInt64(number); break;
+        case Variant::Int64Type:    out = NumberAsInt64(number); break;
+        case Variant::BoolType:     out = NumberAsDouble(number) != 0.0; break;
+        case Variant::FloatType:    out = (float)NumberAsDouble(number); break;
+        case Variant::DoubleType:   out = NumberAsDouble(number); break;
+        default: break;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+BinaryObject BinaryProperty::GetObject(int elementIndex) const {
+    if (!ptr) {
+        return BinaryObject();
+    }
+
+    if (GetType() == ListType) {
+        BinaryProperty element = GetListElement(elementIndex);
+        return element.IsValid() && element.IsObject() && !element.IsArray() ? element.GetObject() : BinaryObject();
+    }
+
+    if (GetType() != ObjectType || elementIndex < 0 || elementIndex >= Count()) {
+        return BinaryObject();
+    }
+
+    // Object records have variable size, so walk through the previous elements
+    const byte *objectPtr = IsArray() ? Payload() + sizeof(uint32_t) : Payload();
+    for (int i = 0; i < elementIndex; i++) {
+        objectPtr += ReadRaw<uint32_t>(objectPtr);
+    }
+    return BinaryObject(reader, objectPtr);
+}
+
+BinaryProperty BinaryProperty::GetListElement(int elementIndex) const {
+    if (!ptr || GetType() != ListType || elementIndex < 0 || elementIndex >= Count()) {
+        return BinaryProperty();
+    }
+
+    const byte *objectPtr = Payload() + sizeof(uint32_t);
+    for (int i = 0; i < elementIndex; i++) {
+        objectPtr += ReadRaw<uint32_t>(objectPtr);
+    }
+    return BinaryObject(reader, objectPtr).FirstProperty();
+}
+
+BinaryProperty BinaryProperty::Next() const {
+    if (!ptr) {
+        return BinaryProperty();
+    }
+
+    const byte *nextPtr = Payload() + ReadRaw<uint32_t>(ptr + 8);
+    if (nextPtr >= end) {
+        return BinaryProperty();
+    }
+    return BinaryProperty(reader, nextPtr, end);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+int BinaryObject::NumProperties() const {
+    if (!ptr) {
+        return 0;
+    }
+    return ReadRaw<uint32_t>(ptr + 4);
+}
+
+int BinaryObject::Size() const {
+    if (!ptr) {
+        return 0;
+    }
+    return ReadRaw<uint32_t>(ptr);
+}
+
+BinaryProperty BinaryObject::FirstProperty() const {
+    if (!ptr || NumProperties() == 0) {
+        return BinaryProperty();
+    }
+    return BinaryProperty(reader, ptr + ObjectHeaderSize, ptr + Size());
+}
+
+BinaryProperty BinaryObject::FindProperty(const char *name, const BinaryProperty &hint) const {
+    if (!ptr) {
+        return BinaryProperty();
+    }
+
+    BinaryProperty start = hint.IsValid() && hint.ptr > ptr && hint.ptr < ptr + Size() ? hint : FirstProperty();
+
+    for (BinaryProperty prop = start; prop.IsValid(); prop = prop.Next()) {
+        if (!Str::Cmp(prop.GetName(), name)) {
+            return prop;
+        }
+    }
+
+    for (BinaryProperty prop = FirstProperty(); prop.IsValid() && prop.ptr != start.ptr; prop = prop.Next()) {
+        if (!Str::Cmp(prop.GetName(), name)) {
+            return prop;
+        }
+    }
+
+    return BinaryProperty();
+}
+
+const char *BinaryObject::ClassName() const {
+    BinaryProperty prop = FindProperty("classname");
+    if (!prop.IsValid() || prop.GetType() != Variant::StrType || prop.IsArray()) {
+        return "";
+    }
+    return reader->GetString(ReadRaw<uint32_t>(prop.Payload()));
+}
+
+//-------------------------------------------------------------------------------------------------
+
+BinarySerializer::BinarySerializer() : stringHash(1024, 1024) {
+    finished = false;
+
+    data.Resize(64 * 1024);
+    data.SetCount(sizeof(BinaryDeserializer::Header));
+    memset(data.Ptr(), 0, data.Count());
+}
+
+bool BinarySerializer::IsSupportedType(Variant::Type type) {
+    return ValueSize(type) >= 0;
+}
+
+void BinarySerializer::Write(const void *src, int size) {
+    int offset = data.Count();
+    if (offset + size > data.Capacity()) {
+        // Grow geometrically, Array grows by the granularity only
+        data.Resize(Max(offset + size, data.Capacity() * 2));
+    }
+    data.SetCount(offset + size, false);
+    memcpy(data.Ptr() + offset, src, size);
+}
+
+uint32_t BinarySerializer::StringIndex(const char *string) {
+    int hash = stringHash.GenerateHash(string, true);
+    for (int i = stringHash.First(hash); i != -1; i = stringHash.Next(i)) {
+        if (!Str::Cmp(strings[i].c_str(), string)) {
+            return i;
+        }
+    }
+
+    int index = strings.Append(string);
+    stringHash.Add(hash, index);
+    return index;
+}
+
+void BinarySerializer::WriteValue(Variant::Type type, const Variant &value) {
+    switch (type) {
+    case Variant::None: break;
+    case Variant::IntType: { int32_t v = value.As<int>(); Write(&v, sizeof(v)); break; }
+    case Variant::Int64Type: { int64_t v = value.As<int64_t>(); Write(&v, sizeof(v)); break; }
+    case Variant::BoolType: WriteUInt32(value.As<bool>() ? 1 : 0); break;
+    case Variant::FloatType: { float v = value.As<float>(); Write(&v, sizeof(v)); break; }
+    case Variant::DoubleType: { double v = value.As<double>(); Write(&v, sizeof(v)); break; }
+    case Variant::Vec2Type: { Vec2 v = value.As<Vec2>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::Vec3Type: { Vec3 v = value.As<Vec3>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::Vec4Type: { Vec4 v = value.As<Vec4>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::Color3Type: { Color3 v = value.As<Color3>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::Color4Type: { Color4 v = value.As<Color4>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::Mat2Type: { Mat2 v = value.As<Mat2>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::Mat3Type: { Mat3 v = value.As<Mat3>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::Mat3x4Type: { Mat3x4 v = value.As<Mat3x4>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::Mat4Type: { Mat4 v = value.As<Mat4>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::AnglesType: { Angles v = value.As<Angles>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::QuatType: { Quat v = value.As<Quat>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::PointType: { Point v = value.As<Point>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::RectType: { Rect v = value.As<Rect>(); Write(v.Ptr(), sizeof(v)); break; }
+    case Variant::GuidType: { Guid v = value.As<Guid>(); Write(&v, sizeof(v)); break; }
+    case Variant::StrType: WriteUInt32(StringIndex(value.As<Str>().c_str())); break;
+    default:
+        assert(0);
+        break;
+    }
+}
+
+void BinarySerializer::BeginObject(bool indexed) {
+    assert(!finished);
+
+    if (propertyStack.Count() > 0) {
+        OpenRecord &prop = propertyStack.Last();
+        assert(prop.type == BinaryProperty::ObjectType || prop.type == BinaryProperty::ListType);
+        if (prop.count >= 0) {
+            // Element of object array or list property
+            prop.count++;
+        }
+    } else {
+        // Only one root object
+        assert(objectStack.Count() == 0 && data.Count() == sizeof(BinaryDeserializer::Header));
+    }
+
+    if (indexed) {
+        indexedObjects.Append(data.Count());
+    }
+
+    OpenRecord &record = objectStack.Alloc();
+    record.offset = data.Count();
+    record.type = BinaryProperty::ObjectType;
+    record.count = 0;
+
+    WriteUInt32(0);
+    WriteUInt32(0);
+}
+
+void BinarySerializer::EndObject() {
+    OpenRecord record = objectStack.TakeLast();
+
+    uint32_t header[2] = { (uint32_t)(data.Count() - record.offset), (uint32_t)record.count };
+    memcpy(data.Ptr() + record.offset, header, sizeof(header));
+}
+
+void BinarySerializer::BeginProperty(const char *name, int type, int flags) {
+    assert(objectStack.Count() > 0);
+    // Properties can't be nested without an object
+    assert(propertyStack.Count() == 0 || propertyStack.Last().offset < objectStack.Last().offset);
+
+    objectStack.Last().count++;
+
+    OpenRecord &record = propertyStack.Alloc();
+    record.offset = data.Count();
+    record.type = type;
+    record.count = (flags & BinaryProperty::ArrayFlag) ? 0 : -1;
+
+    uint16_t typeAndFlags[2] = { (uint16_t)type, (uint16_t)flags };
+    WriteUInt32(StringIndex(name));
+    Write(typeAndFlags, sizeof(typeAndFlags));
+    WriteUInt32(0);
+
+    if (flags & BinaryProperty::ArrayFlag) {
+        WriteUInt32(0);
+    }
+}
+
+void BinarySerializer::EndProperty() {
+    OpenRecord record = propertyStack.TakeLast();
+
+    uint32_t payloadSize = data.Count() - record.offset - PropertyHeaderSize;
+    memcpy(data.Ptr() + record.offset + 8, &payloadSize, sizeof(payloadSize));
+
+    if (record.count >= 0) {
+        uint32_t count = record.count;
+        memcpy(data.Ptr() + record.offset + PropertyHeaderSize, &count, sizeof(count));
+    } else if (record.type == BinaryProperty::ObjectType) {
+        assert(payloadSize > 0);
+    }
+}
+
+void BinarySerializer::WriteProperty(const char *name, const Variant &value) {
+    if (ValueSize(value.GetType()) < 0) {
+        BE_WARNLOG(L"BinarySerializer::WriteProperty: unsupported type for property '%hs'\n", name);
+        return;
+    }
+
+    BeginProperty(name, value.GetType(), 0);
+    WriteValue(value.GetType(), value);
+    EndProperty();
+}
+
+void BinarySerializer::BeginArrayProperty(const char *name, Variant::Type type) {
+    assert(ValueSize(type) >= 0);
+    BeginProperty(name, type, BinaryProperty::ArrayFlag);
+}
+
+void BinarySerializer::WriteElement(const Variant &value) {
+    OpenRecord &record = propertyStack.Last();
+    assert(record.count >= 0 && record.type != BinaryProperty::ObjectType);
+    record.count++;
+    WriteValue((Variant::Type)record.type, value);
+}
+
+void BinarySerializer::EndArrayProperty() {
+    EndProperty();
+}
+
+void BinarySerializer::BeginObjectProperty(const char *name, bool isArray) {
+    BeginProperty(name, BinaryProperty::ObjectType, isArray ? BinaryProperty::ArrayFlag : 0);
+}
+
+void BinarySerializer::EndObjectProperty() {
+    EndProperty();
+}
+
+void BinarySerializer::BeginListProperty(const char *name) {
+    BeginProperty(name, BinaryProperty::ListType, BinaryProperty::ArrayFlag);
+}
+
+void BinarySerializer::EndListProperty() {
+    EndProperty();
+}
+
+const Array<byte> &BinarySerializer::Finish(bool arrayRoot) {
+    assert(!finished && objectStack.Count() == 0 && propertyStack.Count() == 0);
+
+    BinaryDeserializer::Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = BinaryDeserializer::Magic;
+    header.version = BinaryDeserializer::Version;
+    header.flags = arrayRoot ? BinaryDeserializer::ArrayRootFlag : 0;
+    header.rootOffset = sizeof(header);
+
+    header.entityIndexOffset = data.Count();
+    header.numEntities = indexedObjects.Count();
+    if (indexedObjects.Count() > 0) {
+        Write(indexedObjects.Ptr(), indexedObjects.Count() * sizeof(uint32_t));
+    }
+
+    header.stringTableOffset = data.Count();
+    header.numStrings = strings.Count();
+
+    int stringOffsetsStart = data.Count();
+    uint32_t stringOffset = stringOffsetsStart + strings.Count() * sizeof(uint32_t);
+    for (int i = 0; i < strings.Count(); i++) {
+        WriteUInt32(stringOffset);
+        stringOffset += strings[i].Length() + 1;
+    }
+    for (int i = 0; i < strings.Count(); i++) {
+        Write(strings[i].c_str(), strings[i].Length() + 1);
+    }
+
+    static const byte zeros[4] = { 0, 0, 0, 0 };
+    Write(zeros, (4 - (data.Count() & 3)) & 3);
+
+    header.size = data.Count();
+    memcpy(data.Ptr(), &header, sizeof(header));
+
+    finished = true;
+
+    return data;
+}
+
+//-------------------------------------------------------------------------------------------------
+// JSON to binary conversion
+//
+// Values are stored as the type of the registered property if they can be converted back to
+// the exactly same JSON value. Otherwise (or for unknown properties like script fields), the type
+// is inferred from the JSON value type. Binary property values are converted to the property
+// type when deserializing, so both cases give the same result as JSON deserialization.
+//-------------------------------------------------------------------------------------------------
+
+static Variant JsonToVariant(Variant::Type type, const Json::Value &value) {
+    switch (type) {
+    case Variant::IntType:      return Variant(value.asInt());
+    case Variant::Int64Type:    return Variant((int64_t)value.asInt64());
+    case Variant::BoolType:     return Variant(value.asBool());
+    case Variant::FloatType:    return Variant(value.asFloat());
+    case Variant::DoubleType:   return Variant(value.asDouble());
+    case Variant::StrType:      return Variant(Str(value.asCString()));
+    case Variant::None:         return Variant();
+    default:                    return Variant::FromString(type, value.asCString());
+    }
+}
+
+static Json::Value VariantToJson(const Variant &value) {
+    switch (value.GetType()) {
+    case Variant::None:
+        return Json::Value();
+    case Variant::Int64Type: {
+        // Same as JSON reader that gives unsigned value for large positive numbers
+        int64_t i = value.As<int64_t>();
+        if (i > Json::Value::maxInt) {
+            return Json::Value((Json::UInt64)i);
+        }
+        return Json::Value((Json::Int64)i);
+    }
+    case Variant::FloatType:
+        return Json::Value((double)value.As<float>());
+    default:
+        return value.ToJsonValue();
+    }
+}
+
+// Returns true if the JSON value can be stored as the given type without loss.
+static bool JsonMatchesType(Variant::Type type, const Json::Value &value) {
+    switch (type) {
+    case Variant::IntType:
+        return value.type() == Json::intValue && value.isInt();
+    case Variant::Int64Type:
+        return value.type() == Json::intValue || (value.type() == Json::uintValue && value.isInt64());
+    case Variant::BoolType:
+        return value.type() == Json::booleanValue;
+    case Variant::FloatType:
+        return value.type() == Json::realValue && (double)(float)value.asDouble() == value.asDouble();
+    case Variant::DoubleType:
+        return value.type() == Json::realValue;
+    case Variant::StrType:
+        return value.type() == Json::stringValue;
+    default:
+        if (IsStringCodedType(type) && value.type() == Json::stringValue) {
+            // Text must be the same as the one written back
+            return VariantToJson(JsonToVariant(type, value)) == value;
+        }
+        return false;
+    }
+}
+
+// Returns type of the JSON value.
+// Strings of GUIDs are stored as Guid, which is 16 bytes instead of a 32 characters string.
+static Variant::Type InferJsonType(const Json::Value &value) {
+    switch (value.type()) {
+    case Json::intValue:        return value.isInt() ? Variant::IntType : Variant::Int64Type;
+    case Json::uintValue:       return value.isInt64() ? Variant::Int64Type : Variant::DoubleType;
+    case Json::realValue:       return Variant::DoubleType;
+    case Json::stringValue: {
+        const char *begin, *end;
+        if (value.getString(&begin, &end) && end - begin == 32 && JsonMatchesType(Variant::GuidType, value)) {
+            return Variant::GuidType;
+        }
+        return Variant::StrType;
+    }
+    case Json::booleanValue:    return Variant::BoolType;
+    default:                    return Variant::None;
+    }
+}
+
+void BinarySerializer::WriteJsonProperty(const char *name, const Json::Value &value, Variant::Type knownType, bool indexElements) {
+    if (value.isObject()) {
+        BeginObjectProperty(name, false);
+        BeginObject();
+        WriteJson(value);
+        EndObject();
+        EndObjectProperty();
+        return;
+    }
+
+    if (!value.isArray()) {
+        Variant::Type type = JsonMatchesType(knownType, value) ? knownType : InferJsonType(value);
+        WriteProperty(name, JsonToVariant(type, value));
+        return;
+    }
+
+    int numElements = value.size();
+
+    if (numElements == 0) {
+        if (knownType != Variant::None) {
+            BeginArrayProperty(name, knownType);
+            EndArrayProperty();
+        } else {
+            BeginObjectProperty(name, true);
+            EndObjectProperty();
+        }
+        return;
+    }
+
+    bool allObjects = true;
+    bool allKnown = knownType != Variant::None;
+    for (int i = 0; i < numElements; i++) {
+        allObjects = allObjects && value[i].isObject();
+        allKnown = allKnown && JsonMatchesType(knownType, value[i]);
+    }
+
+    if (allObjects) {
+        BeginObjectProperty(name, true);
+        for (int i = 0; i < numElements; i++) {
+            BeginObject(indexElements);
+            WriteJson(value[i]);
+            EndObject();
+        }
+        EndObjectProperty();
+        return;
+    }
+
+    Variant::Type type = allKnown ? knownType : InferJsonType(value[0]);
+    bool mixed = false;
+    if (!allKnown) {
+        for (int i = 0; i < numElements && !mixed; i++) {
+            if (value[i].isArray() || value[i].isObject() || value[i].isNull()) {
+                mixed = true;
+                break;
+            }
+            Variant::Type elementType = InferJsonType(value[i]);
+            if (elementType == type) {
+                continue;
+            }
+            if ((elementType == Variant::StrType || elementType == Variant::GuidType) && (type == Variant::StrType || type == Variant::GuidType)) {
+                // Mixed GUIDs and strings are stored as strings
+                type = Variant::StrType;
+                continue;
+            }
+            if ((elementType == Variant::IntType || elementType == Variant::Int64Type) && (type == Variant::IntType || type == Variant::Int64Type)) {
+                // Mixed 32 bits and 64 bits integers are stored as 64 bits integers, which convert back to the same JSON values
+                type = Variant::Int64Type;
+                continue;
+            }
+            mixed = true;
+        }
+    }
+
+    if (mixed) {
+        // Nested arrays and arrays of mixed types are stored element by element with their own types
+        BeginListProperty(name);
+        for (int i = 0; i < numElements; i++) {
+            BeginObject();
+            WriteJsonProperty("", value[i], knownType, false);
+            EndObject();
+        }
+        EndListProperty();
+        return;
+    }
+
+    BeginArrayProperty(name, type);
+    for (int i = 0; i < numElements; i++) {
+        WriteElement(JsonToVariant(type, value[i]));
+    }
+    EndArrayProperty();
+}
+
+void BinarySerializer::WriteJson(const Json::Value &value, const char *indexedArrayName) {
+    assert(value.isObject());
+
+    const PropertyInfoTable *propertyInfoTable = nullptr;
+
+    const Json::Value &classnameValue = value["classname"];
+    if (classnameValue.isString()) {
+        const MetaObject *metaObject = Object::FindMetaObject(classnameValue.asCString());
+        if (metaObject) {
+            propertyInfoTable = &metaObject->GetPropertyInfoTable();
+        }
+    }
+
+    // Registered properties first in the order of deserialization
+    if (propertyInfoTable) {
+        for (int i = 0; i < propertyInfoTable->Count(); i++) {
+            const PropertyInfo &propertyInfo = (*propertyInfoTable)[i];
+            const Json::Value *member = value.find(propertyInfo.GetName(), propertyInfo.GetName() + strlen(propertyInfo.GetName()));
+            if (member) {
+                WriteJsonProperty(propertyInfo.GetName(), *member, propertyInfo.GetType(), false);
+            }
+        }
+    }
+
+    for (Json::Value::const_iterator it = value.begin(); it != value.end(); ++it) {
+        const std::string name = it.name();
+        if (propertyInfoTable && propertyInfoTable->Find(name.c_str())) {
+            continue;
+        }
+
+        bool indexElements = indexedArrayName && !Str::Cmp(name.c_str(), indexedArrayName);
+        WriteJsonProperty(name.c_str(), *it, Variant::None, indexElements);
+    }
+}
+
+void BinarySerializer::FromJson(const Json::Value &value, Array<byte> &data) {
+    BinarySerializer serializer;
+
+    serializer.BeginObject();
+
+    bool arrayRoot = value.isArray();
+    if (arrayRoot) {
+        // Prefab is stored as an array of entities
+        Json::Value rootValue;
+        rootValue["entities"] = value;
+        serializer.WriteJson(rootValue, "entities");
+    } else {
+        serializer.WriteJson(value, "entities");
+    }
+
+    serializer.EndObject();
+
+    data = serializer.Finish(arrayRoot);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+BinaryDeserializer::BinaryDeserializer() {
+    data = nullptr;
+    header = nullptr;
+}
+
+bool BinaryDeserializer::IsBinary(const void *data, size_t size) {
+    return size >= sizeof(Header) && ReadRaw<uint32_t>((const byte *)data) == Magic;
+}
+
+bool BinaryDeserializer::Open(const void *data, size_t size) {
+    this->data = nullptr;
+    this->header = nullptr;
+
+    if (!IsBinary(data, size) || ((uintptr_t)data & 3)) {
+        return false;
+    }
+
+    const Header *header = (const Header *)data;
+    if (header->version < 1 || header->version > Version) {
+        BE_WARNLOG(L"BinaryDeserializer::Open: unsupported version %i\n", header->version);
+        return false;
+    }
+
+    // Offsets of the regions must be aligned and in order: root object, entity index, string table
+    if (header->size > size ||
+        header->rootOffset != sizeof(Header) ||
+        header->entityIndexOffset < header->rootOffset || header->entityIndexOffset > header->size || (header->entityIndexOffset & 3) ||
+        header->numEntities > (header->size - header->entityIndexOffset) / sizeof(uint32_t) ||
+        header->stringTableOffset < header->entityIndexOffset + header->numEntities * sizeof(uint32_t) ||
+        header->stringTableOffset > header->size || (header->stringTableOffset & 3) ||
+        header->numStrings > (header->size - header->stringTableOffset) / sizeof(uint32_t)) {
+        BE_WARNLOG(L"BinaryDeserializer::Open: corrupted header\n");
+        return false;
+    }
+
+    const byte *bytes = (const byte *)data;
+
+    // Strings must be null-terminated in the data
+    const uint32_t stringsStart = header->stringTableOffset + header->numStrings * sizeof(uint32_t);
+    for (uint32_t i = 0; i < header->numStrings; i++) {
+        uint32_t stringOffset = ReadRaw<uint32_t>(bytes + header->stringTableOffset + i * sizeof(uint32_t));
+        if (stringOffset < stringsStart || stringOffset >= header->size) {
+            BE_WARNLOG(L"BinaryDeserializer::Open: corrupted string table\n");
+            return false;
+        }
+    }
+    if (header->numStrings > 0 && bytes[header->size - 1] != 0) {
+        BE_WARNLOG(L"BinaryDeserializer::Open: corrupted string table\n");
+        return false;
+    }
+
+    this->data = bytes;
+    this->header = header;
+
+    // Validate all the records once, so that accessors don't need to check bounds
+    if (!ValidateObject(bytes + header->rootOffset, bytes + header->entityIndexOffset, 0)) {
+        BE_WARNLOG(L"BinaryDeserializer::Open: corrupted object record\n");
+        this->data = nullptr;
+        this->header = nullptr;
+        return false;
+    }
+
+    // Indexed entities are validated as a part of the root object, but the index can point anywhere
+    for (uint32_t i = 0; i < header->numEntities; i++) {
+        uint32_t entityOffset = ReadRaw<uint32_t>(bytes + header->entityIndexOffset + i * sizeof(uint32_t));
+        if (entityOffset <= header->rootOffset || entityOffset >= header->entityIndexOffset || (entityOffset & 3) ||
+            !ValidateObject(bytes + entityOffset, bytes + header->entityIndexOffset, 0)) {
+            BE_WARNLOG(L"BinaryDeserializer::Open: corrupted entity index\n");
+            this->data = nullptr;
+            this->header = nullptr;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool BinaryDeserializer::ValidateObject(const byte *ptr, const byte *end, int depth) const {
+    if (depth > MaxObjectDepth || end - ptr < ObjectHeaderSize) {
+        return false;
+    }
+
+    uint32_t size = ReadRaw<uint32_t>(ptr);
+    if (size < ObjectHeaderSize || size > (uint32_t)(end - ptr) || (size & 3)) {
+        return false;
+    }
+
+    const byte *objectEnd = ptr + size;
+    const byte *propPtr = ptr + ObjectHeaderSize;
+    uint32_t numProperties = ReadRaw<uint32_t>(ptr + 4);
+
+    for (uint32_t i = 0; i < numProperties; i++) {
+        if (objectEnd - propPtr < PropertyHeaderSize) {
+            return false;
+        }
+
+        uint32_t nameIndex = ReadRaw<uint32_t>(propPtr);
+        int type = ReadRaw<int16_t>(propPtr + 4);
+        bool isArray = !!(ReadRaw<uint16_t>(propPtr + 6) & BinaryProperty::ArrayFlag);
+        uint32_t payloadSize = ReadRaw<uint32_t>(propPtr + 8);
+        const byte *payload = propPtr + PropertyHeaderSize;
+
+        if (nameIndex >= header->numStrings || payloadSize > (uint32_t)(objectEnd - payload) || (payloadSize & 3)) {
+            return false;
+        }
+
+        const byte *payloadEnd = payload + payloadSize;
+        const byte *elements = payload;
+        uint32_t count = 1;
+
+        if (isArray) {
+            if (payloadSize < sizeof(uint32_t)) {
+                return false;
+            }
+            count = ReadRaw<uint32_t>(payload);
+            elements += sizeof(uint32_t);
+        }
+
+        if (type == BinaryProperty::ObjectType || type == BinaryProperty::ListType) {
+            if (type == BinaryProperty::ListType && !isArray) {
+                return false;
+            }
+            for (uint32_t elementIndex = 0; elementIndex < count; elementIndex++) {
+                if (!ValidateObject(elements, payloadEnd, depth + 1)) {
+                    return false;
+                }
+                // Element of list is an object with one property
+                if (type == BinaryProperty::ListType && ReadRaw<uint32_t>(elements + 4) != 1) {
+                    return false;
+                }
+                elements += ReadRaw<uint32_t>(elements);
+            }
+        } else {
+            int valueSize = ValueSize(type);
+            if (valueSize < 0 || (uint64_t)count * valueSize != (uint64_t)(payloadEnd - elements)) {
+                return false;
+            }
+            if (type == Variant::StrType) {
+                for (uint32_t elementIndex = 0; elementIndex < count; elementIndex++) {
+                    if (ReadRaw<uint32_t>(elements + elementIndex * sizeof(uint32_t)) >= header->numStrings) {
+                        return false;
+                    }
+                }
+            }
+            elements = payloadEnd;
+        }
+
+        if (elements != payloadEnd) {
+            return false;
+        }
+
+        propPtr = payloadEnd;
+    }
+
+    return propPtr == objectEnd;
+}
+
+BinaryObject BinaryDeserializer::GetRoot() const {
+    if (!header) {
+        return BinaryObject();
+    }
+    return BinaryObject(this, data + header->rootOffset);
+}
+
+BinaryObject BinaryDeserializer::GetEntity(int index) const {
+    if (!header || index < 0 || index >= (int)header->numEntities) {
+        return BinaryObject();
+    }
+    uint32_t offset = ReadRaw<uint32_t>(data + header->entityIndexOffset + index * sizeof(uint32_t));
+    return BinaryObject(this, data + offset);
+}
+
+const char *BinaryDeserializer::GetString(int index) const {
+    uint32_t offset = ReadRaw<uint32_t>(data + header->stringTableOffset + index * sizeof(uint32_t));
+    return (const char *)(data + offset);
+}
+
+void BinaryDeserializer::ToJson(const BinaryObject &object, Json::Value &value) {
+    value = Json::Value(Json::objectValue);
+
+    for (BinaryProperty prop = object.FirstProperty(); prop.IsValid(); prop = prop.Next()) {
+        ToJson(prop, value[prop.GetName()]);
+    }
+}
+
+void BinaryDeserializer::ToJson(const BinaryProperty &prop, Json::Value &value) {
+    int count = prop.Count();
+
+    if (prop.IsObject() || prop.IsList()) {
+        if (!prop.IsArray()) {
+            ToJson(prop.GetObject(0), value);
+            return;
+        }
+
+        value = Json::Value(Json::arrayValue);
+        value.resize(count);
+
+        // Walk the elements in order instead of GetObject(i) that searches from the first element
+        const byte *objectPtr = prop.Payload() + sizeof(uint32_t);
+        for (int i = 0; i < count; i++) {
+            BinaryObject element(prop.reader, objectPtr);
+            if (prop.IsList()) {
+                ToJson(element.FirstProperty(), value[i]);
+            } else {
+                ToJson(element, value[i]);
+            }
+            objectPtr += element.Size();
+        }
+        return;
+    }
+
+    Variant element;
+    if (!prop.IsArray()) {
+        prop.GetValue(element);
+        value = VariantToJson(element);
+        return;
+    }
+
+    value = Json::Value(Json::arrayValue);
+    value.resize(count);
+    for (int i = 0; i < count; i++) {
+        prop.GetValue(element, i);
+        value[i] = VariantToJson(element);
+    }
+}
+
+void BinaryDeserializer::ToJson(Json::Value &value) const {
+    if (!header) {
+        value = Json::Value();
+        return;
+    }
+
+    BinaryObject root = GetRoot();
+
+    if (header->flags & ArrayRootFlag) {
+        Json::Value rootValue;
+        ToJson(root, rootValue);
+        value = rootValue.get("entities", Json::Value(Json::arrayValue));
+        return;
+    }
+
+    ToJson(root, value);
+}
+
+BE_NAMESPACE_END
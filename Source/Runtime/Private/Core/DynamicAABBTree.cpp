@@ -518,6 +518,39 @@ int32_t DynamicAABBTree::GetMaxBalance() const {
 
 #pragma optimize("", on)
 
+// Split the tree into disjoint subtrees by replacing internal nodes with their children.
+// The query stack pops child2 before child1, so replacing a node with (child2, child1)
+// keeps the leaf visiting order of the concatenated subtree queries unchanged.
+int DynamicAABBTree::GetSubtreeRoots(int maxSubtrees, int32_t *subtreeRoots) const {
+    if (root == -1 || maxSubtrees <= 0) {
+        return 0;
+    }
+
+    int count = 1;
+    subtreeRoots[0] = root;
+
+    bool expanded = true;
+    while (expanded && count < maxSubtrees) {
+        expanded = false;
+
+        // Iterate backward so that the inserted children are not expanded in this pass
+        for (int i = count - 1; i >= 0 && count < maxSubtrees; i--) {
+            const Node *node = nodes + subtreeRoots[i];
+            if (node->IsLeaf()) {
+                continue;
+            }
+
+            memmove(&subtreeRoots[i + 2], &subtreeRoots[i + 1], (count - i - 1) * sizeof(subtreeRoots[0]));
+            subtreeRoots[i] = node->child2;
+            subtreeRoots[i + 1] = node->child1;
+            count++;
+            expanded = true;
+        }
+    }
+
+    return count;
+}
+
 void DynamicAABBTree::ValidateStructure(int32_t index) const {
     if (index == -1) {
         return;
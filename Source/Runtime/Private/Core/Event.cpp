@@ -153,22 +153,123 @@ const EventDef *EventDef::FindEvent(const char *name) {
 //-----------------------------------------------------------------------------------------
 
 bool                EventSystem::initialized = false;
-Event               EventSystem::eventPool[EventSystem::MaxEvents];
+Array<Event *>      EventSystem::eventBlocks;
 LinkList<Event>     EventSystem::freeEvents;
-LinkList<Event>     EventSystem::eventQueue;
-LinkList<Event>     EventSystem::guiEventQueue;
+EventQueue          EventSystem::eventQueue;
+EventQueue          EventSystem::guiEventQueue;
+uint32_t            EventSystem::sequenceCounter = 0;
 
 Event::~Event() {
-    EventSystem::FreeEvent(this);
+    if (data) {
+        Mem_Free(data);
+    }
+}
+
+//-----------------------------------------------------------------------------------------
+
+BE_INLINE bool EventQueue::IsEarlier(const Event *a, const Event *b) {
+    if (a->time != b->time) {
+        return a->time < b->time;
+    }
+    // Compare with the difference to handle wrap-around of the sequence counter
+    return (int32_t)(a->sequence - b->sequence) < 0;
+}
+
+BE_INLINE void EventQueue::Set(int index, Event *event) {
+    heap[index] = event;
+    event->queueIndex = index;
+}
+
+void EventQueue::SiftUp(int index) {
+    Event *event = heap[index];
+
+    while (index > 0) {
+        int parentIndex = (index - 1) >> 1;
+        if (!IsEarlier(event, heap[parentIndex])) {
+            break;
+        }
+        Set(index, heap[parentIndex]);
+        index = parentIndex;
+    }
+
+    Set(index, event);
 }
 
+void EventQueue::SiftDown(int index) {
+    Event *event = heap[index];
+    int count = heap.Count();
+
+    while (true) {
+        int childIndex = (index << 1) + 1;
+        if (childIndex >= count) {
+            break;
+        }
+        if (childIndex + 1 < count && IsEarlier(heap[childIndex + 1], heap[childIndex])) {
+            childIndex++;
+        }
+        if (!IsEarlier(heap[childIndex], event)) {
+            break;
+        }
+        Set(index, heap[childIndex]);
+        index = childIndex;
+    }
+
+    Set(index, event);
+}
+
+void EventQueue::Push(Event *event) {
+    assert(event->queueIndex == -1);
+
+    // Grow geometrically, lots of delayed events can be posted at once
+    if (heap.Count() == heap.Capacity()) {
+        heap.Resize(heap.Capacity() > 0 ? heap.Capacity() * 2 : EventSystem::EventBlockSize);
+    }
+
+    int index = heap.Append(event);
+    SiftUp(index);
+}
+
+void EventQueue::Remove(Event *event) {
+    int index = event->queueIndex;
+    assert(index >= 0 && index < heap.Count() && heap[index] == event);
+
+    event->queueIndex = -1;
+
+    Event *lastEvent = heap.TakeLast();
+    if (index == heap.Count()) {
+        return;
+    }
+
+    // Fill the hole with the last one and restore heap order
+    Set(index, lastEvent);
+
+    if (index > 0 && IsEarlier(lastEvent, heap[(index - 1) >> 1])) {
+        SiftUp(index);
+    } else {
+        SiftDown(index);
+    }
+}
+
+void EventQueue::Clear() {
+    for (int i = 0; i < heap.Count(); i++) {
+        heap[i]->queueIndex = -1;
+    }
+    heap.Clear();
+}
+
+//-----------------------------------------------------------------------------------------
+
 void EventSystem::Clear() {
-    freeEvents.Clear();
     eventQueue.Clear();
     guiEventQueue.Clear();
 
-    for (int i = 0; i < EventSystem::MaxEvents; i++) {
-        FreeEvent(&eventPool[i]);
+    // Return all the events to the free list
+    for (int blockIndex = 0; blockIndex < eventBlocks.Count(); blockIndex++) {
+        Event *block = eventBlocks[blockIndex];
+
+        for (int i = 0; i < EventBlockSize; i++) {
+            FreeEvent(&block[i]);
+        }
     }
 }
 
@@ -186,6 +287,10 @@ void EventSystem::Init() {
         return;
     }
 
+    if (eventBlocks.Count() == 0) {
+        AllocEventBlock();
+    }
+
     BE_LOG(L"...%i event definitions\n", EventDef::NumEvents());
 
     initialized = true;
@@ -201,10 +306,38 @@ void EventSystem::Shutdown() {
 
     Clear();
 
+    freeEvents.Clear();
+
+    for (int blockIndex = 0; blockIndex < eventBlocks.Count(); blockIndex++) {
+        delete [] eventBlocks[blockIndex];
+    }
+    eventBlocks.Clear();
+
     initialized = false;
 }
 
+void EventSystem::AllocEventBlock() {
+    Event *block = new Event[EventBlockSize];
+
+    eventBlocks.Append(block);
+
+    for (int i = 0; i < EventBlockSize; i++) {
+        Event *event = &block[i];
+
+        event->node.SetOwner(event);
+        event->senderNode.SetOwner(event);
+        event->node.AddToEnd(freeEvents);
+    }
+}
+
 void EventSystem::FreeEvent(Event *event) {
+    if (event->queueIndex >= 0) {
+        EventQueue &queue = event->eventDef->IsGuiEvent() ? guiEventQueue : eventQueue;
+        queue.Remove(event);
+    }
+
+    event->senderNode.Remove();
+
     if (event->data) {
         Mem_Free(event->data);
         event->data = nullptr;
@@ -214,13 +347,12 @@ void EventSystem::FreeEvent(Event *event) {
     event->time = 0;
     event->sender = nullptr;
 
-    event->node.SetOwner(event);
     event->node.AddToEnd(EventSystem::freeEvents);
 }
 
 Event *EventSystem::AllocEvent(const EventDef *evdef, int numArgs, va_list args) {
     if (freeEvents.IsListEmpty()) {
-        BE_ERRLOG(L"Event::Alloc: No more free events\n");
+        AllocEventBlock();
     }
 
     Event *newEvent = freeEvents.Next();
@@ -332,23 +464,19 @@ void EventSystem::ScheduleEvent(Event *event, Object *sender, int time) {
         return;
     }
 
+    EventQueue &queue = event->eventDef->IsGuiEvent() ? guiEventQueue : eventQueue;
+
+    if (event->queueIndex >= 0) {
+        queue.Remove(event);
+    }
+
     event->sender = sender;
     event->time = common.realTime + time;
+    event->sequence = sequenceCounter++;
     event->node.Remove();
+    event->senderNode.AddToEnd(sender->pendingEvents);
 
-    LinkList<Event> &queue = event->eventDef->IsGuiEvent() ? guiEventQueue : eventQueue;
-
-    // event queue 는 시간 순으로 정렬되어 있다.
-    Event *ev = queue.Next();
-    while (ev && (event->time >= ev->time)) {
-        ev = ev->node.Next();
-    }
-
-    if (ev) {
-        event->node.InsertBefore(ev->node);
-    } else {
-        event->node.AddToEnd(queue);
-    }
+    queue.Push(event);
 }
 
 void EventSystem::CancelEvents(const Object *sender, const EventDef *evdef) {
@@ -356,15 +484,12 @@ void EventSystem::CancelEvents(const Object *sender, const EventDef *evdef) {
         return;
     }
 
-    LinkList<Event> &queue = eventQueue; // evdef->IsGuiEvent() ? guiEventQueue : eventQueue;
-        
+    // Only visit the events posted by the sender
     Event *next;
-    for (Event *event = queue.Next(); event != nullptr; event = next) {
-        next = event->node.Next();
-        if (event->sender == sender) {
-            if (!evdef || (evdef == event->eventDef)) {
-                FreeEvent(event);
-            }
+    for (Event *event = sender->pendingEvents.Next(); event != nullptr; event = next) {
+        next = event->senderNode.Next();
+        if (!evdef || (evdef == event->eventDef)) {
+            FreeEvent(event);
         }
     }
 }
@@ -420,9 +545,11 @@ void EventSystem::ServiceEvent(Event *event) {
         }
     }
 
-    // the event is removed from its list so that if then object
+    // the event is removed from the queue and the sender so that if then object
     // is deleted, the event won't be freed twice
-    event->node.Remove();
+    EventQueue &queue = evdef->IsGuiEvent() ? guiEventQueue : eventQueue;
+    queue.Remove(event);
+    event->senderNode.Remove();
 
     assert(event->sender);
     event->sender->ProcessEventArgPtr(evdef, argPtrs);
@@ -431,48 +558,37 @@ void EventSystem::ServiceEvent(Event *event) {
     FreeEvent(event);
 }
 
-void EventSystem::ServiceEvents() {
+void EventSystem::ServiceEventQueue(EventQueue &queue) {
+    // Events scheduled while servicing are counted to detect infinite loop
+    uint32_t firstSequence = sequenceCounter;
     int processedCount = 0;
 
-    while (!eventQueue.IsListEmpty()) {
-        Event *ev = eventQueue.Next();
+    while (!queue.IsEmpty()) {
+        Event *ev = queue.Top();
         assert(ev);
 
         if (ev->time > common.realTime) {
             break;
         }
 
+        bool postedInThisFrame = (int32_t)(ev->sequence - firstSequence) >= 0;
+
         ServiceEvent(ev);
 
         // Don't allow ourselves to stay in here too long.  An abnormally high number
         // of events being processed is evidence of an infinite loop of events.
-        processedCount++;
-        if (processedCount > MaxEventsPerFrame) {
+        if (postedInThisFrame && ++processedCount > MaxEventsPerFrame) {
             BE_ERRLOG(L"Event overflow.  Possible infinite loop in script.\n");
         }
     }
 }
 
-void EventSystem::ServiceGuiEvents() {
-    int processedCount = 0;
-
-    while (!guiEventQueue.IsListEmpty()) {
-        Event *ev = guiEventQueue.Next();
-        assert(ev);
-
-        if (ev->time > common.realTime) {
-            break;
-        }
-
-        ServiceEvent(ev);
+void EventSystem::ServiceEvents() {
+    ServiceEventQueue(eventQueue);
+}
 
-        // Don't allow ourselves to stay in here too long.  An abnormally high number
-        // of events being processed is evidence of an infinite loop of events.
-        processedCount++;
-        if (processedCount > MaxEventsPerFrame) {
-            BE_ERRLOG(L"Event overflow.  Possible infinite loop in script.\n");
-        }
-    }
+void EventSystem::ServiceGuiEvents() {
+    ServiceEventQueue(guiEventQueue);
 }
 
 BE_NAMESPACE_END
@@ -14,56 +14,595 @@
 
 #include "Precompiled.h"
 #include "Core/Heap.h"
-
-#ifdef __APPLE__
-#include "malloc/malloc.h"
-#endif
+#include "Core/Str.h"
+#include "Core/WStr.h"
+#include "Core/Cmds.h"
+#include "Core/CmdArgs.h"
+#include "Platform/PlatformSystem.h"
+#include <atomic>
+#include <algorithm>
 
 BE_NAMESPACE_BEGIN
 
 //#define SJPARK
 
-#ifndef DEBUG_MEMORY
+static const uint32_t HeaderMagic = 0x4d454d42;         // "MEMB"
+static const uint32_t FreedHeaderMagic = 0xdeadbeef;
 
-void *Mem_Alloc(size_t size) {
-#ifdef SJPARK
-    void *ptr =  malloc(size);
-    memset(ptr, 0xfc, size);
-    return ptr;
+// Prefix of every heap block, keeps the alignment of the system allocator.
+struct MemHeader {
+    uint64_t                size;
+    uint32_t                magic;
+    uint16_t                tag;
+    uint16_t                sampled;
+};
+
+static_assert(sizeof(MemHeader) == 16, "MemHeader must be 16 bytes");
+
+// Allocated and freed bytes and counts are written by the owner thread only, so no locked instructions are needed.
+// Threads beyond MaxCounterThreads share the last slot with atomic additions.
+// Totals are folded from all the slots when the stats are read.
+struct alignas(64) MemThreadCounters {
+    std::atomic<int64_t>    allocBytes[MemTag::Count];
+    std::atomic<int64_t>    freeBytes[MemTag::Count];
+    std::atomic<int64_t>    numAllocs[MemTag::Count];
+    std::atomic<int64_t>    numFrees[MemTag::Count];
+};
+
+static const int            MaxCounterThreads = 256;
+
+// Highest current bytes folded so far
+static std::atomic<int64_t> peakBytes[MemTag::Count];
+static MemThreadCounters    threadCounterSlots[MaxCounterThreads + 1];
+static std::atomic<int>     numThreadCounterSlots(0);
+
+static const char *         tagNames[MemTag::Count] = {
+    "General",
+    "Image",
+    "Texture",
+    "Mesh",
+    "Anim",
+    "Sound",
+    "Physics",
+    "Lua",
+    "FrameData",
+    "Render",
+    "Game",
+    "File"
+};
+
+struct MemSample {
+    enum {
+        MaxFrames           = 14
+    };
+    void *                  ptr;                    // nullptr for empty slots
+    uint64_t                size;
+    int32_t                 tag;
+    int32_t                 numFrames;
+    void *                  frames[MaxFrames];
+};
+
+// Open addressing hash table of the live sampled allocations keyed by the address
+static const int            MaxSamples = 16384;     // Must be a power of two
+static MemSample *          samples = nullptr;
+static int                  numSamples = 0;
+static int                  numDroppedSamples = 0;
+static std::atomic<int>     sampleRate(0);
+static std::atomic_flag     sampleLock = ATOMIC_FLAG_INIT;
+
+static thread_local uint16_t threadTag = MemTag::General;
+static thread_local MemThreadCounters *threadCounters = nullptr;
+static thread_local bool    threadCountersShared = false;
+static thread_local int     sampleCountdown = 0;
+static thread_local bool    sampling = false;
+
+static BE_FORCE_INLINE void *SysAlloc(size_t size, const char *filename, int lineNumber) {
+#if defined(DEBUG_MEMORY) && defined(__WIN32__)
+    return _malloc_dbg(size, _NORMAL_BLOCK, filename, lineNumber);
 #else
     return malloc(size);
 #endif
 }
 
-void *Mem_ClearedAlloc(size_t size) {
-    void *ptr = malloc(size);
-    if (!ptr) {
+static BE_FORCE_INLINE void *SysRealloc(void *ptr, size_t size, const char *filename, int lineNumber) {
+#if defined(DEBUG_MEMORY) && defined(__WIN32__)
+    return _realloc_dbg(ptr, size, _NORMAL_BLOCK, filename, lineNumber);
+#else
+    return realloc(ptr, size);
+#endif
+}
+
+static BE_FORCE_INLINE void SysFree(void *ptr) {
+#if defined(DEBUG_MEMORY) && defined(__WIN32__)
+    _free_dbg(ptr, _NORMAL_BLOCK);
+#else
+    free(ptr);
+#endif
+}
+
+static MemThreadCounters *GetThreadCounters() {
+    if (!threadCounters) {
+        int slotIndex = numThreadCounterSlots.fetch_add(1, std::memory_order_relaxed);
+        if (slotIndex < MaxCounterThreads) {
+            threadCounters = &threadCounterSlots[slotIndex];
+        } else {
+            threadCounters = &threadCounterSlots[MaxCounterThreads];
+            threadCountersShared = true;
+        }
+    }
+    return threadCounters;
+}
+
+static BE_FORCE_INLINE void AddCount(std::atomic<int64_t> &count, int64_t value) {
+    if (!threadCountersShared) {
+        count.store(count.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    } else {
+        count.fetch_add(value, std::memory_order_relaxed);
+    }
+}
+
+static BE_FORCE_INLINE void AddBytes(int tag, int64_t size) {
+    MemThreadCounters *counters = GetThreadCounters();
+    AddCount(counters->allocBytes[tag], size);
+    AddCount(counters->numAllocs[tag], 1);
+}
+
+static BE_FORCE_INLINE void RemoveBytes(int tag, int64_t size) {
+    MemThreadCounters *counters = GetThreadCounters();
+    AddCount(counters->freeBytes[tag], size);
+    AddCount(counters->numFrees[tag], 1);
+}
+
+static void LockSamples() {
+    while (sampleLock.test_and_set(std::memory_order_acquire)) {}
+}
+
+static void UnlockSamples() {
+    sampleLock.clear(std::memory_order_release);
+}
+
+static BE_FORCE_INLINE uint32_t SampleSlot(const void *ptr) {
+    return (uint32_t)(((uint64_t)(uintptr_t)ptr * 0x9e3779b97f4a7c15ull) >> 32) & (MaxSamples - 1);
+}
+
+static void AddSample(const MemHeader *header) {
+    void *frames[MemSample::MaxFrames];
+    // Skip AddSample/TrackNewBlock
+    int numFrames = PlatformSystem::CaptureCallStack(frames, MemSample::MaxFrames, 2);
+
+    LockSamples();
+
+    if (!samples || numSamples >= MaxSamples * 3 / 4) {
+        numDroppedSamples++;
+        UnlockSamples();
+        return;
+    }
+
+    uint32_t slot = SampleSlot(header);
+    while (samples[slot].ptr) {
+        slot = (slot + 1) & (MaxSamples - 1);
+    }
+
+    MemSample &sample = samples[slot];
+    sample.ptr = (void *)header;
+    sample.size = header->size;
+    sample.tag = header->tag;
+    sample.numFrames = numFrames;
+    memcpy(sample.frames, frames, numFrames * sizeof(frames[0]));
+    numSamples++;
+
+    ((MemHeader *)header)->sampled = 1;
+
+    UnlockSamples();
+}
+
+static void RemoveSample(const MemHeader *header) {
+    LockSamples();
+
+    if (samples) {
+        uint32_t slot = SampleSlot(header);
+        while (samples[slot].ptr && samples[slot].ptr != header) {
+            slot = (slot + 1) & (MaxSamples - 1);
+        }
+
+        if (samples[slot].ptr) {
+            // Backward shift deletion keeps the probe sequences intact without tombstones
+            uint32_t hole = slot;
+            uint32_t next = (slot + 1) & (MaxSamples - 1);
+            while (samples[next].ptr) {
+                uint32_t home = SampleSlot(samples[next].ptr);
+                if (((next - home) & (MaxSamples - 1)) >= ((next - hole) & (MaxSamples - 1))) {
+                    samples[hole] = samples[next];
+                    hole = next;
+                }
+                next = (next + 1) & (MaxSamples - 1);
+            }
+            samples[hole].ptr = nullptr;
+            numSamples--;
+        }
+    }
+
+    UnlockSamples();
+}
+
+static BE_FORCE_INLINE void *TrackNewBlock(MemHeader *header, size_t size) {
+    header->size = size;
+    header->magic = HeaderMagic;
+    header->tag = threadTag;
+    header->sampled = 0;
+
+    AddBytes(header->tag, size);
+
+    if (sampleRate.load(std::memory_order_relaxed) > 0 && --sampleCountdown <= 0 && !sampling) {
+        sampleCountdown = sampleRate.load(std::memory_order_relaxed);
+        // Call stack capture may allocate
+        sampling = true;
+        AddSample(header);
+        sampling = false;
+    }
+    return header + 1;
+}
+
+static BE_FORCE_INLINE MemHeader *UntrackBlock(void *ptr) {
+    MemHeader *header = (MemHeader *)ptr - 1;
+    assert(header->magic == HeaderMagic);
+
+    if (header->sampled) {
+        RemoveSample(header);
+    }
+
+    RemoveBytes(header->tag, header->size);
+    return header;
+}
+
+static void *TrackedAlloc(size_t size, const char *filename, int lineNumber) {
+    MemHeader *header = (MemHeader *)SysAlloc(sizeof(MemHeader) + size, filename, lineNumber);
+    if (!header) {
         return nullptr;
     }
-    memset(ptr, 0, size);
+    void *ptr = TrackNewBlock(header, size);
+#ifdef SJPARK
+    memset(ptr, 0xfc, size);
+#endif
     return ptr;
 }
 
-void *Mem_Alloc16(size_t size) {
-    byte *ptr = (byte *)Mem_Alloc(size + sizeof(intptr_t) + 15);
+static void *TrackedRealloc(void *ptr, size_t size, const char *filename, int lineNumber) {
     if (!ptr) {
+        return TrackedAlloc(size, filename, lineNumber);
+    }
+
+    MemHeader *header = (MemHeader *)ptr - 1;
+    uint64_t oldSize = header->size;
+    MemTag::Enum oldTag = (MemTag::Enum)header->tag;
+
+    UntrackBlock(ptr);
+
+    MemHeader *newHeader = (MemHeader *)SysRealloc(header, sizeof(MemHeader) + size, filename, lineNumber);
+    if (!newHeader) {
+        // The old block is left untouched
+        MemTag::Enum tag = Mem_SetThreadTag(oldTag);
+        TrackNewBlock(header, oldSize);
+        Mem_SetThreadTag(tag);
         return nullptr;
     }
-    byte *alignedPtr = (byte *)((((intptr_t)ptr) + sizeof(intptr_t) + 15) & ~15);
-    *((intptr_t *)(alignedPtr - sizeof(intptr_t))) = (intptr_t)ptr;
-    return alignedPtr;
+    return TrackNewBlock(newHeader, size);
 }
 
-void *Mem_Alloc32(size_t size) {
-    byte *ptr = (byte *)Mem_Alloc(size + sizeof(intptr_t) + 31);
+static void TrackedFree(void *ptr) {
+    if (ptr) {
+        MemHeader *header = UntrackBlock(ptr);
+        header->magic = FreedHeaderMagic;
+#ifdef SJPARK
+        memset(ptr, 0xfd, header->size);
+#endif
+        SysFree(header);
+    }
+}
+
+static void *AlignedAlloc(size_t size, size_t alignment, const char *filename, int lineNumber) {
+    byte *ptr = (byte *)TrackedAlloc(size + sizeof(intptr_t) + alignment - 1, filename, lineNumber);
     if (!ptr) {
         return nullptr;
     }
-    byte *alignedPtr = (byte *)((((intptr_t)ptr) + sizeof(intptr_t) + 31) & ~31);
+    byte *alignedPtr = (byte *)((((intptr_t)ptr) + sizeof(intptr_t) + alignment - 1) & ~(intptr_t)(alignment - 1));
     *((intptr_t *)(alignedPtr - sizeof(intptr_t))) = (intptr_t)ptr;
     return alignedPtr;
 }
 
+static void AlignedFree(void *ptr) {
+    if (ptr) {
+        TrackedFree((void *)*((intptr_t *)(((byte *)ptr) - sizeof(intptr_t))));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const char *Mem_TagName(MemTag::Enum tag) {
+    assert(tag >= 0 && tag < MemTag::Count);
+    return tagNames[tag];
+}
+
+MemTag::Enum Mem_SetThreadTag(MemTag::Enum tag) {
+    assert(tag >= 0 && tag < MemTag::Count);
+    MemTag::Enum prevTag = (MemTag::Enum)threadTag;
+    threadTag = (uint16_t)tag;
+    return prevTag;
+}
+
+MemTag::Enum Mem_GetThreadTag() {
+    return (MemTag::Enum)threadTag;
+}
+
+void Mem_GetTagStats(MemTag::Enum tag, MemTagStats &stats) {
+    int64_t allocBytes = 0;
+    int64_t freeBytes = 0;
+    int64_t numAllocs = 0;
+    int64_t numFrees = 0;
+    int numSlots = Min(numThreadCounterSlots.load(std::memory_order_relaxed), MaxCounterThreads + 1);
+    for (int i = 0; i < numSlots; i++) {
+        allocBytes += threadCounterSlots[i].allocBytes[tag].load(std::memory_order_relaxed);
+        freeBytes += threadCounterSlots[i].freeBytes[tag].load(std::memory_order_relaxed);
+        numAllocs += threadCounterSlots[i].numAllocs[tag].load(std::memory_order_relaxed);
+        numFrees += threadCounterSlots[i].numFrees[tag].load(std::memory_order_relaxed);
+    }
+    stats.currentBytes = allocBytes - freeBytes;
+    stats.numLiveAllocs = numAllocs - numFrees;
+    stats.numTotalAllocs = numAllocs;
+
+    int64_t peak = peakBytes[tag].load(std::memory_order_relaxed);
+    while (stats.currentBytes > peak && !peakBytes[tag].compare_exchange_weak(peak, stats.currentBytes, std::memory_order_relaxed)) {}
+    stats.peakBytes = Max(peak, stats.currentBytes);
+}
+
+void Mem_UpdatePeaks() {
+    MemTagStats stats;
+    for (int i = 0; i < MemTag::Count; i++) {
+        Mem_GetTagStats((MemTag::Enum)i, stats);
+    }
+}
+
+void Mem_AddExternal(MemTag::Enum tag, size_t size) {
+    AddBytes(tag, size);
+}
+
+void Mem_RemoveExternal(MemTag::Enum tag, size_t size) {
+    RemoveBytes(tag, size);
+}
+
+void Mem_SetSampleRate(int rate) {
+    rate = Max(rate, 0);
+
+    LockSamples();
+
+    if (rate > 0 && !samples) {
+        samples = (MemSample *)calloc(MaxSamples, sizeof(MemSample));
+        numSamples = 0;
+        numDroppedSamples = 0;
+    } else if (rate == 0 && samples) {
+        // Blocks sampled so far will find no table on free
+        free(samples);
+        samples = nullptr;
+        numSamples = 0;
+    }
+
+    sampleRate.store(rate, std::memory_order_relaxed);
+
+    UnlockSamples();
+}
+
+int Mem_GetSampleRate() {
+    return sampleRate.load(std::memory_order_relaxed);
+}
+
+static const char *FormatBytes(int64_t bytes, char *buffer, int bufferSize) {
+    if (bytes < 1024 && bytes > -1024) {
+        Str::snPrintf(buffer, bufferSize, "%i B", (int)bytes);
+    } else if (bytes < 1024 * 1024 && bytes > -1024 * 1024) {
+        Str::snPrintf(buffer, bufferSize, "%.1f KB", bytes / 1024.0);
+    } else {
+        Str::snPrintf(buffer, bufferSize, "%.2f MB", bytes / (1024.0 * 1024.0));
+    }
+    return buffer;
+}
+
+struct MemStackSummary {
+    const MemSample *       sample;
+    int64_t                 totalBytes;
+    int                     count;
+};
+
+static void ReportSampledStacks(int maxStacks) {
+    int rate = sampleRate.load(std::memory_order_relaxed);
+    if (rate <= 0) {
+        BE_LOG(L"Allocation sampling is off. Use 'memSampling <N>' to record 1 in N allocations.\n");
+        return;
+    }
+
+    // Snapshot the table, allocations made from here are not sampled on this thread
+    sampling = true;
+
+    LockSamples();
+    int count = 0;
+    MemSample *snapshot = (MemSample *)malloc(sizeof(MemSample) * Max(numSamples, 1));
+    for (int i = 0; i < MaxSamples && snapshot; i++) {
+        if (samples[i].ptr) {
+            snapshot[count++] = samples[i];
+        }
+    }
+    int dropped = numDroppedSamples;
+    UnlockSamples();
+
+    if (!snapshot) {
+        sampling = false;
+        return;
+    }
+
+    // Group the samples by tag and call stack
+    std::sort(snapshot, snapshot + count, [](const MemSample &a, const MemSample &b) {
+        if (a.tag != b.tag) {
+            return a.tag < b.tag;
+        }
+        if (a.numFrames != b.numFrames) {
+            return a.numFrames < b.numFrames;
+        }
+        return memcmp(a.frames, b.frames, a.numFrames * sizeof(a.frames[0])) < 0;
+    });
+
+    MemStackSummary *summaries = (MemStackSummary *)malloc(sizeof(MemStackSummary) * Max(count, 1));
+    int numSummaries = 0;
+    for (int i = 0; i < count; i++) {
+        const MemSample &sample = snapshot[i];
+        if (numSummaries > 0) {
+            MemStackSummary &last = summaries[numSummaries - 1];
+            if (last.sample->tag == sample.tag && last.sample->numFrames == sample.numFrames &&
+                !memcmp(last.sample->frames, sample.frames, sample.numFrames * sizeof(sample.frames[0]))) {
+                last.totalBytes += sample.size;
+                last.count++;
+                continue;
+            }
+        }
+        MemStackSummary &summary = summaries[numSummaries++];
+        summary.sample = &sample;
+        summary.totalBytes = sample.size;
+        summary.count = 1;
+    }
+
+    std::sort(summaries, summaries + numSummaries, [](const MemStackSummary &a, const MemStackSummary &b) {
+        return a.totalBytes > b.totalBytes;
+    });
+
+    BE_LOG(L"%i live sampled allocations (1 in %i, %i dropped), top %i call stacks by estimated bytes:\n", count, rate, dropped, Min(maxStacks, numSummaries));
+
+    char bytesString[32];
+    char symbol[256];
+    for (int i = 0; i < Min(maxStacks, numSummaries); i++) {
+        const MemStackSummary &summary = summaries[i];
+        BE_LOG(L"#%i %hs ~%hs in ~%i allocs\n", i, tagNames[summary.sample->tag], FormatBytes(summary.totalBytes * rate, bytesString, sizeof(bytesString)), summary.count * rate);
+
+        for (int frameIndex = 0; frameIndex < summary.sample->numFrames; frameIndex++) {
+            PlatformSystem::AddressToSymbol(summary.sample->frames[frameIndex], symbol, sizeof(symbol));
+            BE_LOG(L"    %hs\n", symbol);
+        }
+    }
+
+    free(summaries);
+    free(snapshot);
+
+    sampling = false;
+}
+
+void Mem_Report(bool printStacks, int maxStacks) {
+    int tags[MemTag::Count];
+    MemTagStats stats[MemTag::Count];
+    MemTagStats total = { 0, 0, 0, 0 };
+
+    for (int i = 0; i < MemTag::Count; i++) {
+        tags[i] = i;
+        Mem_GetTagStats((MemTag::Enum)i, stats[i]);
+
+        total.currentBytes += stats[i].currentBytes;
+        total.peakBytes += stats[i].peakBytes;
+        total.numLiveAllocs += stats[i].numLiveAllocs;
+        total.numTotalAllocs += stats[i].numTotalAllocs;
+    }
+
+    std::sort(tags, tags + MemTag::Count, [&stats](int a, int b) {
+        return stats[a].currentBytes > stats[b].currentBytes;
+    });
+
+    char currentString[32];
+    char peakString[32];
+
+    BE_LOG(L"%-12hs %12hs %12hs %12hs %12hs\n", "tag", "current", "peak", "live allocs", "total allocs");
+    BE_LOG(L"-------------------------------------------------------------------\n");
+
+    for (int i = 0; i < MemTag::Count; i++) {
+        const MemTagStats &s = stats[tags[i]];
+        if (s.numTotalAllocs == 0) {
+            continue;
+        }
+        BE_LOG(L"%-12hs %12hs %12hs %12lld %12lld\n", tagNames[tags[i]],
+            FormatBytes(s.currentBytes, currentString, sizeof(currentString)),
+            FormatBytes(s.peakBytes, peakString, sizeof(peakString)),
+            (long long)s.numLiveAllocs, (long long)s.numTotalAllocs);
+    }
+
+    BE_LOG(L"-------------------------------------------------------------------\n");
+    BE_LOG(L"%-12hs %12hs %12hs %12lld %12lld\n", "total",
+        FormatBytes(total.currentBytes, currentString, sizeof(currentString)),
+        FormatBytes(total.peakBytes, peakString, sizeof(peakString)),
+        (long long)total.numLiveAllocs, (long long)total.numTotalAllocs);
+
+    if (printStacks) {
+        ReportSampledStacks(maxStacks);
+    }
+}
+
+static void Cmd_MemReport(const CmdArgs &args) {
+    bool printStacks = false;
+    int maxStacks = 20;
+
+    if (args.Argc() > 1 && !WStr::Icmp(args.Argv(1), L"stacks")) {
+        printStacks = true;
+        if (args.Argc() > 2) {
+            maxStacks = WStr::ToI32(args.Argv(2));
+        }
+    }
+
+    Mem_Report(printStacks, maxStacks);
+}
+
+static void Cmd_MemSampling(const CmdArgs &args) {
+    if (args.Argc() < 2) {
+        BE_LOG(L"memSampling <N> : records call stacks of 1 in N allocations (0 = off, current %i)\n", Mem_GetSampleRate());
+        return;
+    }
+
+    Mem_SetSampleRate(WStr::ToI32(args.Argv(1)));
+}
+
+void Mem_Init() {
+    cmdSystem.AddCommand(L"memReport", Cmd_MemReport, L"reports heap usage per memory tag, 'memReport stacks [N]' for sampled call stacks");
+    cmdSystem.AddCommand(L"memSampling", Cmd_MemSampling, L"records call stacks of 1 in N allocations");
+}
+
+void Mem_Shutdown() {
+    cmdSystem.RemoveCommand(L"memReport");
+    cmdSystem.RemoveCommand(L"memSampling");
+
+    Mem_SetSampleRate(0);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+#ifndef DEBUG_MEMORY
+
+void *Mem_Alloc(size_t size) {
+    return TrackedAlloc(size, nullptr, 0);
+}
+
+void *Mem_ClearedAlloc(size_t size) {
+    void *ptr = TrackedAlloc(size, nullptr, 0);
+    if (!ptr) {
+        return nullptr;
+    }
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+void *Mem_Realloc(void *ptr, size_t size) {
+    return TrackedRealloc(ptr, size, nullptr, 0);
+}
+
+void *Mem_Alloc16(size_t size) {
+    return AlignedAlloc(size, 16, nullptr, 0);
+}
+
+void *Mem_Alloc32(size_t size) {
+    return AlignedAlloc(size, 32, nullptr, 0);
+}
+
 char *Mem_AllocString(const char *str) {
     char *ptr = (char *)Mem_Alloc(strlen(str) + 1);
     if (!ptr) {
@@ -83,64 +622,38 @@ wchar_t *Mem_AllocWideString(const wchar_t *str) {
 }
 
 void Mem_Free(void *ptr) {
-    if (ptr) {
-#ifdef SJPARK
-    #ifdef __WIN32__
-        int size = _msize(ptr);
-        memset(ptr, 0xfd, size);
-    #elif defined __APPLE__
-        int size = malloc_size(ptr);
-        memset(ptr, 0xfd, size);
-    #endif
-#endif
-        free(ptr);
-    }
+    TrackedFree(ptr);
 }
 
 void Mem_AlignedFree(void *ptr) {
-    if (ptr) {
-        Mem_Free((void *)*((intptr_t *)(((byte *)ptr) - sizeof(intptr_t))));
-    }
+    AlignedFree(ptr);
 }
 
 #else
 
 void *DebugMem_Alloc(size_t size, const char *filename, const int lineNumber) {
-#ifdef __WIN32__
-    return _malloc_dbg(size, _NORMAL_BLOCK, filename, lineNumber);
-#else
-    return malloc(size);
-#endif
+    return TrackedAlloc(size, filename, lineNumber);
 }
 
 void *DebugMem_ClearedAlloc(size_t size, const char *filename, const int lineNumber) {
-#ifdef __WIN32__
-    void *r = _malloc_dbg(size, _NORMAL_BLOCK, filename, lineNumber);
-#else
-    void *r = malloc(size);
-#endif
+    void *r = TrackedAlloc(size, filename, lineNumber);
+    if (!r) {
+        return nullptr;
+    }
     memset(r, 0, size);
     return r;
 }
 
+void *DebugMem_Realloc(void *ptr, size_t size, const char *filename, const int lineNumber) {
+    return TrackedRealloc(ptr, size, filename, lineNumber);
+}
+
 void *DebugMem_Alloc16(size_t size, const char *filename, const int lineNumber) {
-    byte *ptr = (byte *)DebugMem_Alloc(size + sizeof(intptr_t) + 15, filename, lineNumber);
-    if (!ptr) {
-        return nullptr;
-    }
-    byte *alignedPtr = (byte *)((((intptr_t)ptr) + sizeof(intptr_t) + 15) & ~15);
-    *((intptr_t *)(alignedPtr - sizeof(intptr_t))) = (intptr_t)ptr;
-    return alignedPtr;
+    return AlignedAlloc(size, 16, filename, lineNumber);
 }
 
 void *DebugMem_Alloc32(size_t size, const char *filename, const int lineNumber) {
-    byte *ptr = (byte *)DebugMem_Alloc(size + sizeof(intptr_t) + 31, filename, lineNumber);
-    if (!ptr) {
-        return nullptr;
-    }
-    byte *alignedPtr = (byte *)((((intptr_t)ptr) + sizeof(intptr_t) + 31) & ~31);
-    *((intptr_t *)(alignedPtr - sizeof(intptr_t))) = (intptr_t)ptr;
-    return alignedPtr;
+    return AlignedAlloc(size, 32, filename, lineNumber);
 }
 
 char *DebugMem_AllocString(const char *str, const char *filename, const int lineNumber) {
@@ -162,17 +675,11 @@ wchar_t *DebugMem_AllocWideString(const wchar_t *str, const char *filename, cons
 }
 
 void DebugMem_Free(void *ptr) {
-#ifdef __WIN32__
-    _free_dbg(ptr, _NORMAL_BLOCK);
-#else
-    free(ptr);
-#endif
+    TrackedFree(ptr);
 }
 
 void DebugMem_AlignedFree(void *ptr) {
-    if (ptr) {
-        DebugMem_Free((void *)*((intptr_t *)(((byte *)ptr) - sizeof(intptr_t))));
-    }
+    AlignedFree(ptr);
 }
 
 #endif // DEBUG_MEMORY
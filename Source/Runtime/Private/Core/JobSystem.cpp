@@ -0,0 +1,521 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Core/Heap.h"
+#include "Platform/PlatformProcess.h"
+#include "Core/JobSystem.h"
+#include "Core/Profiler.h"
+#include <atomic>
+
+BE_NAMESPACE_BEGIN
+
+JobSystem jobSystem;
+
+struct Job {
+    jobFunction_t           function;
+    void *                  data;
+    Job *                   parent;
+    std::atomic<int32_t>    unfinishedJobs;         ///< 1 for itself + number of unfinished children
+    std::atomic<uint32_t>   generation;             ///< Incremented each time this job slot is recycled
+    std::atomic<int32_t>    numContinuations;
+    Job *                   continuations[JobSystem::MaxContinuations];
+    byte                    payload[JobSystem::JobPayloadSize];
+};
+
+struct ParallelForData {
+    JobSystem *             jobSystem;
+    parallelForFunction_t   function;
+    void *                  data;
+    JobHandle               self;
+    int                     first;
+    int                     count;
+    int                     granularity;
+};
+
+static_assert(sizeof(ParallelForData) <= JobSystem::JobPayloadSize, "ParallelForData doesn't fit in job payload");
+
+// Lock-free work-stealing deque (Chase-Lev).
+// Only the owner thread calls Push() and Pop(), any thread can call Steal().
+class JobQueue {
+public:
+    static const int64_t    Mask = JobSystem::MaxJobsPerThread - 1;
+
+    void Clear() {
+        top.store(0, std::memory_order_relaxed);
+        bottom.store(0, std::memory_order_relaxed);
+    }
+
+    bool Push(Job *job) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t > Mask) {
+            return false;
+        }
+        jobs[b & Mask].store(job, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    Job *Pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Queue is empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job *job = jobs[b & Mask].load(std::memory_order_relaxed);
+        if (t != b) {
+            // There is still more than one job left in the queue
+            return job;
+        }
+
+        // This is the last job in the queue, race against steal operations
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return job;
+    }
+
+    Job *Steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b) {
+            return nullptr;
+        }
+
+        Job *job = jobs[t & Mask].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            // Lost the race against another steal or pop operation
+            return nullptr;
+        }
+        return job;
+    }
+
+private:
+    // Keep top and bottom on separate cache lines, they are written by different threads
+    std::atomic<int64_t>    top;
+    byte                    padding0[64 - sizeof(std::atomic<int64_t>)];
+    std::atomic<int64_t>    bottom;
+    byte                    padding1[64 - sizeof(std::atomic<int64_t>)];
+    std::atomic<Job *>      jobs[JobSystem::MaxJobsPerThread];
+};
+
+struct JobThreadData {
+    JobSystem *             owner;
+    int                     index;
+    JobQueue                queue;
+    Job *                   jobPool;
+    std::atomic<uint32_t>   numAllocatedJobs;
+    uint32_t                randomSeed;
+};
+
+static const int MaxIdleSpins = 32;
+
+// Job thread data of the calling thread, nullptr if the calling thread is not a job thread.
+static thread_local JobThreadData *currentThreadData = nullptr;
+
+JobSystem::JobSystem() {
+    initialized = false;
+    numThreads = 0;
+    threadData = nullptr;
+    foreignThreadData = nullptr;
+    terminate = false;
+    sleepMutex = nullptr;
+    sleepCondition = nullptr;
+}
+
+static void InitThreadData(JobThreadData *data, JobSystem *owner, int index) {
+    data->owner = owner;
+    data->index = index;
+    data->queue.Clear();
+    data->jobPool = (Job *)Mem_Alloc32(sizeof(Job) * JobSystem::MaxJobsPerThread);
+    for (int i = 0; i < JobSystem::MaxJobsPerThread; i++) {
+        Job *job = new (&data->jobPool[i]) Job;
+        job->unfinishedJobs.store(0, std::memory_order_relaxed);
+        job->generation.store(0, std::memory_order_relaxed);
+    }
+    data->numAllocatedJobs.store(0, std::memory_order_relaxed);
+    data->randomSeed = 0x9E3779B9 * (index + 1);
+}
+
+static void FreeThreadData(JobThreadData *data) {
+    for (int i = 0; i < JobSystem::MaxJobsPerThread; i++) {
+        data->jobPool[i].~Job();
+    }
+    Mem_AlignedFree(data->jobPool);
+}
+
+void JobSystem::Init(int numWorkerThreads) {
+    if (initialized) {
+        return;
+    }
+
+    if (numWorkerThreads < 0) {
+        numWorkerThreads = Max(PlatformProcess::NumberOfLogicalProcessors() - 1, 0);
+    }
+    numWorkerThreads = Min(numWorkerThreads, (int)MaxThreads - 1);
+
+    numThreads = numWorkerThreads + 1;
+
+    threadData = new JobThreadData[numThreads];
+    for (int i = 0; i < numThreads; i++) {
+        InitThreadData(&threadData[i], this, i);
+    }
+
+    foreignThreadData = new JobThreadData;
+    InitThreadData(foreignThreadData, this, -1);
+
+    numQueuedJobs = 0;
+    numSleepingWorkers = 0;
+    terminate = false;
+
+    sleepMutex = PlatformMutex::Create();
+    sleepCondition = PlatformCondition::Create();
+
+    // The calling thread becomes the main job thread
+    currentThreadData = &threadData[0];
+
+    initialized = true;
+
+    for (int i = 1; i < numThreads; i++) {
+        PlatformThread *thread = PlatformThread::Create(WorkerThreadProc, (void *)&threadData[i], 0);
+        workerThreads.Append(thread);
+    }
+}
+
+void JobSystem::Shutdown() {
+    if (!initialized) {
+        return;
+    }
+
+    PlatformMutex::Lock(sleepMutex);
+    terminate = true;
+    PlatformCondition::Broadcast(sleepCondition);
+    PlatformMutex::Unlock(sleepMutex);
+
+    for (int i = 0; i < workerThreads.Count(); i++) {
+        PlatformThread::Wait(workerThreads[i]);
+    }
+    workerThreads.Clear();
+
+    PlatformCondition::Delete(sleepCondition);
+    PlatformMutex::Delete(sleepMutex);
+
+    if (currentThreadData && currentThreadData->owner == this) {
+        currentThreadData = nullptr;
+    }
+
+    for (int i = 0; i < numThreads; i++) {
+        FreeThreadData(&threadData[i]);
+    }
+    delete [] threadData;
+    threadData = nullptr;
+
+    FreeThreadData(foreignThreadData);
+    delete foreignThreadData;
+    foreignThreadData = nullptr;
+
+    numThreads = 0;
+
+    initialized = false;
+}
+
+int JobSystem::GetCurrentThreadIndex() const {
+    if (currentThreadData && currentThreadData->owner == this) {
+        return currentThreadData->index;
+    }
+    return -1;
+}
+
+Job *JobSystem::AllocateJob() {
+    JobThreadData *data = GetCurrentThreadIndex() >= 0 ? currentThreadData : foreignThreadData;
+
+    uint32_t index = data->numAllocatedJobs.fetch_add(1, std::memory_order_relaxed);
+    Job *job = &data->jobPool[index & (MaxJobsPerThread - 1)];
+
+    // The job slot is recycled in a ring, help to finish the previous job in this slot if it's still in flight
+    while (job->unfinishedJobs.load(std::memory_order_acquire) > 0) {
+        Job *otherJob = GetJob();
+        if (otherJob) {
+            Execute(otherJob);
+        } else {
+            PlatformProcess::Sleep(0);
+        }
+    }
+
+    job->generation.fetch_add(1, std::memory_order_relaxed);
+    job->function = nullptr;
+    job->data = nullptr;
+    job->parent = nullptr;
+    job->numContinuations.store(0, std::memory_order_relaxed);
+    job->unfinishedJobs.store(1, std::memory_order_release);
+    return job;
+}
+
+JobHandle JobSystem::CreateJob(jobFunction_t function, void *data) {
+    assert(initialized);
+
+    Job *job = AllocateJob();
+    job->function = function;
+    job->data = data;
+
+    JobHandle handle;
+    handle.job = job;
+    handle.generation = job->generation.load(std::memory_order_relaxed);
+    return handle;
+}
+
+JobHandle JobSystem::CreateChildJob(const JobHandle &parent, jobFunction_t function, void *data) {
+    assert(!IsFinished(parent));
+
+    parent.job->unfinishedJobs.fetch_add(1, std::memory_order_relaxed);
+
+    JobHandle handle = CreateJob(function, data);
+    handle.job->parent = parent.job;
+    return handle;
+}
+
+bool JobSystem::AddContinuation(const JobHandle &ancestor, const JobHandle &continuation) {
+    int32_t index = ancestor.job->numContinuations.fetch_add(1, std::memory_order_relaxed);
+    if (index >= MaxContinuations) {
+        ancestor.job->numContinuations.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    ancestor.job->continuations[index] = continuation.job;
+    return true;
+}
+
+void JobSystem::Run(const JobHandle &handle) {
+    int threadIndex = GetCurrentThreadIndex();
+    if (threadIndex < 0 || !threadData[threadIndex].queue.Push(handle.job)) {
+        // Not a job thread or the queue is full, execute immediately.
+        Execute(handle.job);
+        return;
+    }
+
+    numQueuedJobs.fetch_add(1);
+
+    WakeUpWorkers();
+}
+
+bool JobSystem::IsFinished(const JobHandle &handle) const {
+    if (!handle.job) {
+        return true;
+    }
+    if (handle.job->unfinishedJobs.load(std::memory_order_acquire) <= 0) {
+        return true;
+    }
+    return handle.job->generation.load(std::memory_order_relaxed) != handle.generation;
+}
+
+void JobSystem::Wait(const JobHandle &handle) {
+    while (!IsFinished(handle)) {
+        Job *job = GetJob();
+        if (job) {
+            Execute(job);
+        } else {
+            PlatformProcess::Sleep(0);
+        }
+    }
+}
+
+Job *JobSystem::GetJob() {
+    JobThreadData *data = nullptr;
+    int threadIndex = GetCurrentThreadIndex();
+
+    if (threadIndex >= 0) {
+        data = &threadData[threadIndex];
+
+        Job *job = data->queue.Pop();
+        if (job) {
+            numQueuedJobs.fetch_sub(1);
+            return job;
+        }
+    }
+
+    if (numQueuedJobs.load(std::memory_order_relaxed) <= 0) {
+        return nullptr;
+    }
+
+    // Our own queue is empty, try to steal from a random victim first, then from everyone else
+    uint32_t seed = data ? data->randomSeed : (uint32_t)(uintptr_t)&data;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    if (data) {
+        data->randomSeed = seed;
+    }
+
+    int start = seed % numThreads;
+    for (int i = 0; i < numThreads; i++) {
+        int victimIndex = (start + i) % numThreads;
+        if (victimIndex == threadIndex) {
+            continue;
+        }
+
+        Job *job = threadData[victimIndex].queue.Steal();
+        if (job) {
+            numQueuedJobs.fetch_sub(1);
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+void JobSystem::Execute(Job *job) {
+    job->function(job->data);
+
+    Finish(job);
+}
+
+void JobSystem::Finish(Job *job) {
+    // Copy everything we need before decrementing, the job may be recycled right after that
+    Job *parent = job->parent;
+    Job *continuations[MaxContinuations];
+    int numContinuations = job->numContinuations.load(std::memory_order_relaxed);
+    for (int i = 0; i < numContinuations; i++) {
+        continuations[i] = job->continuations[i];
+    }
+
+    if (job->unfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    if (parent) {
+        Finish(parent);
+    }
+
+    for (int i = 0; i < numContinuations; i++) {
+        JobHandle handle;
+        handle.job = continuations[i];
+        handle.generation = continuations[i]->generation.load(std::memory_order_relaxed);
+        Run(handle);
+    }
+}
+
+void JobSystem::WakeUpWorkers() {
+    if (numSleepingWorkers.load() > 0) {
+        PlatformMutex::Lock(sleepMutex);
+        PlatformCondition::Signal(sleepCondition);
+        PlatformMutex::Unlock(sleepMutex);
+    }
+}
+
+JobHandle JobSystem::CreateParallelForJob(int count, int granularity, parallelForFunction_t function, void *data) {
+    JobHandle handle = CreateJob(ParallelForJob, nullptr);
+
+    ParallelForData *pf = (ParallelForData *)handle.job->payload;
+    pf->jobSystem = this;
+    pf->function = function;
+    pf->data = data;
+    pf->self = handle;
+    pf->first = 0;
+    pf->count = count;
+    pf->granularity = Max(granularity, 1);
+
+    handle.job->data = pf;
+    return handle;
+}
+
+void JobSystem::ParallelFor(int count, int granularity, parallelForFunction_t function, void *data) {
+    if (count <= 0) {
+        return;
+    }
+
+    if (count <= granularity || numThreads <= 1) {
+        function(0, count, data);
+        return;
+    }
+
+    JobHandle handle = CreateParallelForJob(count, granularity, function, data);
+    Run(handle);
+    Wait(handle);
+}
+
+void JobSystem::ParallelForJob(void *data) {
+    const ParallelForData *pf = (const ParallelForData *)data;
+
+    if (pf->count <= pf->granularity) {
+        pf->function(pf->first, pf->first + pf->count, pf->data);
+        return;
+    }
+
+    // Split the range in half, the children keep splitting until the range is small enough
+    const int leftCount = pf->count / 2;
+
+    for (int i = 0; i < 2; i++) {
+        JobHandle child = pf->jobSystem->CreateChildJob(pf->self, ParallelForJob, nullptr);
+
+        ParallelForData *childData = (ParallelForData *)child.job->payload;
+        *childData = *pf;
+        childData->self = child;
+        childData->first = i == 0 ? pf->first : pf->first + leftCount;
+        childData->count = i == 0 ? leftCount : pf->count - leftCount;
+
+        child.job->data = childData;
+
+        pf->jobSystem->Run(child);
+    }
+}
+
+void JobSystem::WorkerThreadProc(void *param) {
+    JobThreadData *data = (JobThreadData *)param;
+    JobSystem *js = data->owner;
+
+    currentThreadData = data;
+
+    profiler.SetThreadName("Job Worker");
+
+    int idleCount = 0;
+
+    while (!js->terminate) {
+        Job *job = js->GetJob();
+        if (job) {
+            js->Execute(job);
+            idleCount = 0;
+            continue;
+        }
+
+        // Yield for a while before going to sleep, new jobs usually come in bursts
+        if (idleCount++ < MaxIdleSpins) {
+            PlatformProcess::Sleep(0);
+            continue;
+        }
+        idleCount = 0;
+
+        // Nothing to do, sleep until a job is queued
+        PlatformMutex::Lock(js->sleepMutex);
+        js->numSleepingWorkers.fetch_add(1);
+        while (!js->terminate && js->numQueuedJobs.load() <= 0) {
+            PlatformCondition::Wait(js->sleepCondition, js->sleepMutex);
+        }
+        js->numSleepingWorkers.fetch_sub(1);
+        PlatformMutex::Unlock(js->sleepMutex);
+    }
+
+    currentThreadData = nullptr;
+}
+
+BE_NAMESPACE_END
@@ -24,6 +24,8 @@ BE_NAMESPACE_BEGIN
 static MetaObject *             staticTypeList = nullptr;
 static Hierarchy<MetaObject>    classHierarchy;
 static int                      eventCallbackMemory = 0;
+static std::atomic<int>         propertyInfoVersion(1);     // increased whenever a property is registered
+static std::atomic_flag         propertyInfoTableLock = ATOMIC_FLAG_INIT;   // serializes building the flattened tables
 
 MetaObject::MetaObject(const char *visualname, const char *classname, const char *superclassname, Object *(*CreateInstance)(const Guid &guid), EventInfo<Object> *eventMap) {
     this->visualname            = visualname;
@@ -36,6 +38,7 @@ MetaObject::MetaObject(const char *visualname, const char *classname, const char
     this->eventMap              = eventMap;
     this->eventCallbacks        = nullptr;
     this->freeEventCallbacks    = false;
+    this->propertyInfoTableVersion = 0;
 
     // 자식 class 의 MetaObject 가 먼저 생성되었다면 자식 클래스를 찾아서 super 를 지정해준다
     for (MetaObject *type = staticTypeList; type; type = type->next) {
@@ -183,25 +186,49 @@ bool MetaObject::GetPropertyInfo(const char *name, PropertyInfo &propertyInfo) c
 }
 
 void MetaObject::GetPropertyInfoList(Array<PropertyInfo> &propertyInfoList) const {
-    Array<Str> names;
+    propertyInfoList.AppendArray(GetPropertyInfoTable().GetList());
+}
 
-    for (const MetaObject *t = this; t != nullptr; t = t->super) {
-        for (int index = 0; index < t->propertyInfoList.Count(); index++) {
-            const PropertyInfo &propInfo = t->propertyInfoList[index];
-            const char *propName = propInfo.GetName();
+const PropertyInfoTable &MetaObject::GetPropertyInfoTable() const {
+    // Tables are built by Object::InitPropertyInfoTables(), so this is the common path.
+    // Acquire pairs with the release below, a table seen up to date is completely built.
+    if (propertyInfoTableVersion.load(std::memory_order_acquire) == propertyInfoVersion.load(std::memory_order_relaxed)) {
+        return propertyInfoTable;
+    }
+
+    while (propertyInfoTableLock.test_and_set(std::memory_order_acquire)) {
+    }
 
-            if (!names.Find(propName)) {
-                names.Append(propName);
-                propertyInfoList.Append(propInfo);
+    // Another thread may have built the table while waiting for the lock
+    const int version = propertyInfoVersion.load(std::memory_order_relaxed);
+
+    if (propertyInfoTableVersion.load(std::memory_order_relaxed) != version) {
+        propertyInfoTable.Clear();
+
+        // Properties of this class come first, and the ones of super classes follow.
+        // Property overridden in the derived class hides the super's one with the same name.
+        for (const MetaObject *t = this; t != nullptr; t = t->super) {
+            for (int index = 0; index < t->propertyInfoList.Count(); index++) {
+                propertyInfoTable.Append(t->propertyInfoList[index]);
             }
         }
+
+        propertyInfoTableVersion.store(version, std::memory_order_release);
     }
+
+    propertyInfoTableLock.clear(std::memory_order_release);
+
+    return propertyInfoTable;
 }
 
 PropertyInfo &MetaObject::RegisterProperty(const PropertyInfo &propInfo) {
     int index = propertyInfoList.Append(propInfo);
     int hash = propertyInfoHash.GenerateHash(propInfo.GetName(), false);
     propertyInfoHash.Add(hash, index);
+
+    // Flattened tables of this and derived classes are out of date
+    propertyInfoVersion++;
+
     return propertyInfoList[index];
 }
 
@@ -257,6 +284,10 @@ bool Object::InitInstance(Guid guid) {
 }
 
 Object::~Object() {
+    // Events can't be delivered to the destroyed object
+    if (!pendingEvents.IsListEmpty()) {
+        EventSystem::CancelEvents(this);
+    }
 }
 
 void Object::Init() {
@@ -296,6 +327,16 @@ void Object::Init() {
     BE_LOG(L"...%i classes, %i bytes for event callbacks\n", types.Count(), eventCallbackMemory);
 }
 
+void Object::InitPropertyInfoTables() {
+    int numProperties = 0;
+
+    for (const MetaObject *t = staticTypeList; t != nullptr; t = t->next) {
+        numProperties += t->GetPropertyInfoTable().Count();
+    }
+
+    BE_LOG(L"...%i properties in flattened property tables\n", numProperties);
+}
+
 void Object::Shutdown() {
     cmdSystem.RemoveCommand(L"listClasses");
     
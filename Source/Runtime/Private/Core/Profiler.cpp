@@ -0,0 +1,407 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Core/Profiler.h"
+#include "Core/Cmds.h"
+#include "Platform/PlatformTime.h"
+#include "Platform/Intrinsics.h"
+#include "File/FileSystem.h"
+
+BE_NAMESPACE_BEGIN
+
+struct ProfileEvent {
+    uint64_t                ticks;
+    int32_t                 zoneIndex;
+    int32_t                 isEnd;
+};
+
+struct ProfileThreadData {
+    // Written by the owner thread
+    ProfileEvent            events[Profiler::MaxEventsPerThread];
+    std::atomic<uint32_t>   writePos;
+    std::atomic<int>        numDroppedEvents;
+
+    // Written by the thread calling SyncFrame()
+    std::atomic<uint32_t>   readPos;
+    struct {
+        int32_t             zoneIndex;
+        uint64_t            ticks;
+    }                       stack[Profiler::MaxZoneDepth];
+    int                     depth;
+    bool                    nameWritten;
+
+    int                     threadIndex;
+    char                    name[64];
+};
+
+struct ProfileThreadLocal {
+    ProfileThreadData *     data;
+    uint32_t                generation;
+    const char *            name;
+};
+
+static thread_local ProfileThreadLocal threadLocal = { nullptr, 0, nullptr };
+
+Profiler    profiler;
+
+static BE_FORCE_INLINE uint64_t ReadTicks() {
+#if defined(__WIN32__) || (defined(__UNIX__) && defined(__X86__))
+    return read_tsc();
+#else
+    return PlatformTime::Cycles();
+#endif
+}
+
+Profiler::Profiler() {
+    recording = false;
+    frameStatsEnabled = false;
+    numZones = 0;
+    numThreads = 0;
+    mutex = nullptr;
+    generation = 1;
+    baseTicks = 0;
+    baseMicroseconds = 0;
+    ticksPerMicrosecond = 1.0;
+    captureFile = nullptr;
+    captureFramesLeft = 0;
+    numCapturedEvents = 0;
+}
+
+void Profiler::Init() {
+    mutex = PlatformMutex::Create();
+
+    baseTicks = ReadTicks();
+    baseMicroseconds = PlatformTime::Microseconds();
+
+    // Rough calibration, refined every frame while not capturing
+    while (PlatformTime::Microseconds() - baseMicroseconds < 1000) {}
+    CalibrateTicks();
+
+    memset(zoneAccums, 0, sizeof(zoneAccums));
+
+    SetThreadName("Main");
+
+    cmdSystem.AddCommand(L"profileCapture", Cmd_ProfileCapture, L"captures frames to Chrome trace file");
+}
+
+void Profiler::Shutdown() {
+    cmdSystem.RemoveCommand(L"profileCapture");
+
+    StopCapture();
+
+    frameStatsEnabled = false;
+    recording = false;
+
+    for (int i = 0; i < numThreads; i++) {
+        delete threadData[i];
+    }
+    numThreads = 0;
+
+    // Invalidates thread local data of all threads
+    generation++;
+
+    frameStats.Clear();
+
+    if (mutex) {
+        PlatformMutex::Delete(mutex);
+        mutex = nullptr;
+    }
+}
+
+int Profiler::RegisterZone(const char *name) {
+    int zoneIndex = numZones.fetch_add(1);
+    if (zoneIndex >= MaxZones) {
+        numZones = MaxZones;
+        return -1;
+    }
+    zoneNames[zoneIndex] = name;
+    return zoneIndex;
+}
+
+void Profiler::SetThreadName(const char *name) {
+    threadLocal.name = name;
+
+    if (threadLocal.data && threadLocal.generation == generation) {
+        Str::Copynz(threadLocal.data->name, name, COUNT_OF(threadLocal.data->name));
+    }
+}
+
+ProfileThreadData *Profiler::GetThreadData() {
+    if (threadLocal.data && threadLocal.generation == generation) {
+        return threadLocal.data;
+    }
+
+    if (!mutex) {
+        return nullptr;
+    }
+
+    PlatformMutex::Lock(mutex);
+
+    ProfileThreadData *data = nullptr;
+
+    int threadIndex = numThreads.load(std::memory_order_relaxed);
+    if (threadIndex < MaxThreads) {
+        data = new ProfileThreadData;
+        data->writePos = 0;
+        data->numDroppedEvents = 0;
+        data->readPos = 0;
+        data->depth = 0;
+        data->nameWritten = false;
+        data->threadIndex = threadIndex;
+        if (threadLocal.name) {
+            Str::Copynz(data->name, threadLocal.name, COUNT_OF(data->name));
+        } else {
+            Str::snPrintf(data->name, COUNT_OF(data->name), "Thread %i", threadIndex);
+        }
+
+        threadData[threadIndex] = data;
+        numThreads.store(threadIndex + 1, std::memory_order_release);
+    }
+
+    PlatformMutex::Unlock(mutex);
+
+    threadLocal.data = data;
+    threadLocal.generation = generation;
+
+    return data;
+}
+
+void Profiler::RecordEvent(int zoneIndex, bool isEnd) {
+    if (zoneIndex < 0) {
+        return;
+    }
+
+    ProfileThreadData *data = GetThreadData();
+    if (!data) {
+        return;
+    }
+
+    // Single producer single consumer ring buffer
+    uint32_t writePos = data->writePos.load(std::memory_order_relaxed);
+    if (writePos - data->readPos.load(std::memory_order_acquire) >= MaxEventsPerThread) {
+        data->numDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ProfileEvent &event = data->events[writePos & (MaxEventsPerThread - 1)];
+    event.ticks = ReadTicks();
+    event.zoneIndex = zoneIndex;
+    event.isEnd = isEnd;
+
+    data->writePos.store(writePos + 1, std::memory_order_release);
+}
+
+void Profiler::CalibrateTicks() {
+    uint64_t elapsedTicks = ReadTicks() - baseTicks;
+    uint64_t elapsedMicroseconds = PlatformTime::Microseconds() - baseMicroseconds;
+
+    if (elapsedMicroseconds > 0) {
+        ticksPerMicrosecond = (double)elapsedTicks / elapsedMicroseconds;
+    }
+}
+
+double Profiler::TicksToMicroseconds(uint64_t ticks) const {
+    return (double)(int64_t)(ticks - baseTicks) / ticksPerMicrosecond;
+}
+
+void Profiler::WriteThreadName(const ProfileThreadData *data) {
+    captureFile->Printf("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+        numCapturedEvents > 0 ? ",\n" : "", data->threadIndex, data->name);
+    numCapturedEvents++;
+}
+
+void Profiler::ProcessEvents(ProfileThreadData *data) {
+    uint32_t readPos = data->readPos.load(std::memory_order_relaxed);
+    uint32_t writePos = data->writePos.load(std::memory_order_acquire);
+
+    if (captureFile && !data->nameWritten) {
+        WriteThreadName(data);
+        data->nameWritten = true;
+    }
+
+    for (; readPos != writePos; readPos++) {
+        const ProfileEvent &event = data->events[readPos & (MaxEventsPerThread - 1)];
+
+        if (!event.isEnd) {
+            if (data->depth < MaxZoneDepth) {
+                data->stack[data->depth].zoneIndex = event.zoneIndex;
+                data->stack[data->depth].ticks = event.ticks;
+            }
+            data->depth++;
+            continue;
+        }
+
+        // Ignore the end of zone which has begun before recording
+        if (data->depth == 0) {
+            continue;
+        }
+
+        data->depth--;
+        if (data->depth >= MaxZoneDepth || data->stack[data->depth].zoneIndex != event.zoneIndex) {
+            continue;
+        }
+
+        uint64_t startTicks = data->stack[data->depth].ticks;
+
+        ZoneAccum &accum = zoneAccums[event.zoneIndex];
+        accum.ticks += event.ticks - startTicks;
+        accum.calls++;
+
+        if (captureFile) {
+            double start = TicksToMicroseconds(startTicks);
+            double end = TicksToMicroseconds(event.ticks);
+
+            captureFile->Printf("%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+                numCapturedEvents > 0 ? ",\n" : "", zoneNames[event.zoneIndex], data->threadIndex, start, end - start);
+            numCapturedEvents++;
+        }
+    }
+
+    data->readPos.store(writePos, std::memory_order_release);
+}
+
+void Profiler::SyncFrame() {
+    int count = numThreads.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        ProcessEvents(threadData[i]);
+    }
+
+    int zoneCount = Min(numZones.load(), (int)MaxZones);
+
+    if (frameStatsEnabled) {
+        frameStats.SetCount(0, false);
+
+        for (int zoneIndex = 0; zoneIndex < zoneCount; zoneIndex++) {
+            const ZoneAccum &accum = zoneAccums[zoneIndex];
+            if (accum.calls == 0) {
+                continue;
+            }
+
+            ZoneStats &stats = frameStats.Alloc();
+            stats.name = zoneNames[zoneIndex];
+            stats.msec = (float)(accum.ticks / ticksPerMicrosecond * 0.001);
+            stats.calls = accum.calls;
+        }
+
+        std::sort(frameStats.Ptr(), frameStats.Ptr() + frameStats.Count(), [](const ZoneStats &a, const ZoneStats &b) {
+            return a.msec > b.msec;
+        });
+    }
+
+    memset(zoneAccums, 0, sizeof(zoneAccums[0]) * zoneCount);
+
+    if (captureFile) {
+        captureFramesLeft--;
+        if (captureFramesLeft <= 0) {
+            StopCapture();
+        }
+    } else {
+        CalibrateTicks();
+    }
+}
+
+void Profiler::UpdateRecording() {
+    bool record = captureFile != nullptr || frameStatsEnabled;
+
+    if (record && !recording) {
+        // Events recorded before would be mismatched with the new ones
+        int count = numThreads.load(std::memory_order_acquire);
+        for (int i = 0; i < count; i++) {
+            threadData[i]->depth = 0;
+        }
+    }
+
+    recording.store(record);
+}
+
+void Profiler::EnableFrameStats(bool enable) {
+    if (frameStatsEnabled == enable) {
+        return;
+    }
+
+    frameStatsEnabled = enable;
+    if (!enable) {
+        frameStats.Clear();
+    }
+
+    UpdateRecording();
+}
+
+bool Profiler::StartCapture(const char *filename, int numFrames) {
+    if (captureFile) {
+        BE_WARNLOG(L"Profiler::StartCapture: already capturing\n");
+        return false;
+    }
+
+    captureFile = fileSystem.OpenFileWrite(filename);
+    if (!captureFile) {
+        BE_WARNLOG(L"Profiler::StartCapture: couldn't open %hs\n", filename);
+        return false;
+    }
+
+    captureFile->Printf("[\n");
+
+    captureFramesLeft = Max(numFrames, 1);
+    numCapturedEvents = 0;
+
+    int count = numThreads.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        threadData[i]->nameWritten = false;
+    }
+
+    UpdateRecording();
+
+    BE_LOG(L"Capturing %i frames to %hs\n", captureFramesLeft, filename);
+    return true;
+}
+
+void Profiler::StopCapture() {
+    if (!captureFile) {
+        return;
+    }
+
+    captureFile->Printf("\n]\n");
+
+    Str filename = captureFile->GetFilePath();
+
+    fileSystem.CloseFile(captureFile);
+    captureFile = nullptr;
+
+    UpdateRecording();
+
+    int numDroppedEvents = 0;
+    int count = numThreads.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        numDroppedEvents += threadData[i]->numDroppedEvents.exchange(0);
+    }
+
+    BE_LOG(L"Wrote %i profile events to %hs (%i events dropped)\n", numCapturedEvents, filename.c_str(), numDroppedEvents);
+}
+
+void Profiler::Cmd_ProfileCapture(const CmdArgs &args) {
+    int numFrames = 10;
+    Str filename = "profile.json";
+
+    if (args.Argc() > 1) {
+        numFrames = WStr::ToI32(args.Argv(1));
+    }
+    if (args.Argc() > 2) {
+        filename = WStr::ToStr(args.Argv(2));
+    }
+
+    profiler.StartCapture(filename, numFrames);
+}
+
+BE_NAMESPACE_END
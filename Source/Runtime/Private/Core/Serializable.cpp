@@ -15,6 +15,7 @@
 #include "Precompiled.h"
 #include "Core/Serializable.h"
 #include "Core/Object.h"
+#include "Core/BinarySerializer.h"
 #include "Math/Math.h"
 
 BE_NAMESPACE_BEGIN
@@ -23,39 +24,49 @@ const SignalDef Serializable::SIG_PropertyChanged("Serializable::PropertyChanged
 const SignalDef Serializable::SIG_PropertyArrayCountChanged("Serializable::PropertyArrayCountChanged", "s");
 const SignalDef Serializable::SIG_PropertyInfoUpdated("Serializable::PropertyInfoUpdated", "i");
 
-bool Serializable::GetPropertyInfo(int index, PropertyInfo &propertyInfo) const {
-    Array<PropertyInfo> propertyInfoList;
-    GetPropertyInfoList(propertyInfoList);
+void Serializable::GetPropertyInfoList(Array<PropertyInfo> &propertyInfoList) const {
+    propertyInfoList.AppendArray(GetPropertyInfoTable().GetList());
+}
+
+const PropertyInfo *Serializable::FindPropertyInfo(int index) const {
+    const PropertyInfoTable &propertyInfoTable = GetPropertyInfoTable();
+
+    if (index < 0 || index > propertyInfoTable.Count() - 1) {
+        return nullptr;
+    }
+
+    return &propertyInfoTable[index];
+}
+
+const PropertyInfo *Serializable::FindPropertyInfo(const char *name) const {
+    return GetPropertyInfoTable().Find(name);
+}
 
-    if (index < 0 || index > propertyInfoList.Count() - 1) {
+bool Serializable::GetPropertyInfo(int index, PropertyInfo &propertyInfo) const {
+    const PropertyInfo *found = FindPropertyInfo(index);
+    if (!found) {
         return false;
     }
 
-    propertyInfo = propertyInfoList[index];
+    propertyInfo = *found;
     return true;
 }
 
 bool Serializable::GetPropertyInfo(const char *name, PropertyInfo &propertyInfo) const {
-    Array<PropertyInfo> propertyInfoList;
-    GetPropertyInfoList(propertyInfoList);
-
-    for (int i = 0; i < propertyInfoList.Count(); i++) {
-        if (!Str::Cmp(propertyInfoList[i].GetName(), name)) {
-            propertyInfo = propertyInfoList[i];
-            return true;
-        }
+    const PropertyInfo *found = FindPropertyInfo(name);
+    if (!found) {
+        return false;
     }
 
-    return false;
+    propertyInfo = *found;
+    return true;
 }
 
 void Serializable::Serialize(Json::Value &out) const {
-    Array<PropertyInfo> propertyInfoList;
-
-    GetPropertyInfoList(propertyInfoList);
+    const PropertyInfoTable &propertyInfoTable = GetPropertyInfoTable();
 
-    for (int propertyIndex = 0; propertyIndex < propertyInfoList.Count(); propertyIndex++) {
-        const PropertyInfo &propertyInfo = propertyInfoList[propertyIndex];
+    for (int propertyIndex = 0; propertyIndex < propertyInfoTable.Count(); propertyIndex++) {
+        const PropertyInfo &propertyInfo = propertyInfoTable[propertyIndex];
 
         if (propertyInfo.GetFlags() & PropertyInfo::SkipSerializationFlag) {
             continue;
@@ -66,7 +77,7 @@ void Serializable::Serialize(Json::Value &out) const {
         if (propertyInfo.GetFlags() & PropertyInfo::ArrayFlag) {
             out[name] = Json::arrayValue;
 
-            for (int elementIndex = 0; elementIndex < GetPropertyArrayCount(propertyIndex); elementIndex++) {
+            for (int elementIndex = 0; elementIndex < GetPropertyArrayCount(propertyInfo); elementIndex++) {
                 Variant value;
                 GetArrayProperty(propertyInfo, elementIndex, value);
 
@@ -82,12 +93,10 @@ void Serializable::Serialize(Json::Value &out) const {
 }
 
 void Serializable::Deserialize(const Json::Value &node) {
-    Array<PropertyInfo> propertyInfoList;
+    const PropertyInfoTable &propertyInfoTable = GetPropertyInfoTable();
 
-    GetPropertyInfoList(propertyInfoList);
-
-    for (int propertyIndex = 0; propertyIndex < propertyInfoList.Count(); propertyIndex++) {
-        const PropertyInfo &propertyInfo = propertyInfoList[propertyIndex];
+    for (int propertyIndex = 0; propertyIndex < propertyInfoTable.Count(); propertyIndex++) {
+        const PropertyInfo &propertyInfo = propertyInfoTable[propertyIndex];
 
         if (propertyInfo.GetFlags() & PropertyInfo::ReadOnlyFlag) {
             continue;
@@ -95,123 +104,123 @@ void Serializable::Deserialize(const Json::Value &node) {
 
         const char *name = propertyInfo.name.c_str();
         const Variant::Type type = propertyInfo.GetType();
-        const Variant defaultValue = propertyInfo.GetDefaultValue();
+        const Variant &defaultValue = propertyInfo.GetDefaultValue();
 
         if (propertyInfo.GetFlags() & PropertyInfo::ArrayFlag) {
             const Json::Value subNode = node.get(name, Json::Value());
 
-            SetPropertyArrayCount(propertyIndex, subNode.size());
+            SetPropertyArrayCount(propertyInfo, subNode.size());
 
             for (int elementIndex = 0; elementIndex < subNode.size(); elementIndex++) {
                 switch (type) {
                 case Variant::IntType: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<int>());
-                    SetArrayProperty(propertyIndex, elementIndex, value.asInt());
+                    SetArrayProperty(propertyInfo, elementIndex, value.asInt());
                     break;
                 }
                 case Variant::Int64Type: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<int64_t>());
-                    SetArrayProperty(propertyIndex, elementIndex, value.asInt64());
+                    SetArrayProperty(propertyInfo, elementIndex, value.asInt64());
                     break;
                 }
                 case Variant::BoolType: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<bool>());
-                    SetArrayProperty(propertyIndex, elementIndex, value.asBool());
+                    SetArrayProperty(propertyInfo, elementIndex, value.asBool());
                     break; 
                 }
                 case Variant::FloatType: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<float>());
-                    SetArrayProperty(propertyIndex, elementIndex, value.asFloat());
+                    SetArrayProperty(propertyInfo, elementIndex, value.asFloat());
                     break; 
                 }
                 case Variant::Vec2Type: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Vec2>().ToString());
                     Vec2 v = value.type() == Json::stringValue ? Vec2::FromString(value.asCString()) : defaultValue.As<Vec2>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break; 
                 }
                 case Variant::Vec3Type: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Vec3>().ToString());
                     Vec3 v = value.type() == Json::stringValue ? Vec3::FromString(value.asCString()) : defaultValue.As<Vec3>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break; 
                 }
                 case Variant::Vec4Type: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Vec4>().ToString());
                     Vec4 v = value.type() == Json::stringValue ? Vec4::FromString(value.asCString()) : defaultValue.As<Vec4>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break; 
                 }
                 case Variant::Color3Type: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Color3>().ToString());
                     Color3 v = value.type() == Json::stringValue ? Color3::FromString(value.asCString()) : defaultValue.As<Color3>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break; 
                 }
                 case Variant::Color4Type: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Color4>().ToString());
                     Color4 v = value.type() == Json::stringValue ? Color4::FromString(value.asCString()) : defaultValue.As<Color4>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break; 
                 }
                 case Variant::Mat2Type: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Mat2>().ToString());
                     Mat2 v = value.type() == Json::stringValue ? Mat2::FromString(value.asCString()) : defaultValue.As<Mat2>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break;
                 }
                 case Variant::Mat3Type: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Mat3>().ToString());
                     Mat3 v = value.type() == Json::stringValue ? Mat3::FromString(value.asCString()) : defaultValue.As<Mat3>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break;
                 }
                 case Variant::Mat3x4Type: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Mat3x4>().ToString());
                     Mat3x4 v = value.type() == Json::stringValue ? Mat3x4::FromString(value.asCString()) : defaultValue.As<Mat3x4>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break;
                 }
                 case Variant::Mat4Type: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Mat4>().ToString());
                     Mat4 v = value.type() == Json::stringValue ? Mat4::FromString(value.asCString()) : defaultValue.As<Mat4>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break;
                 }
                 case Variant::AnglesType: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Angles>().ToString());
                     Angles v = value.type() == Json::stringValue ? Angles::FromString(value.asCString()) : defaultValue.As<Angles>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break; 
                 }
                 case Variant::QuatType: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Quat>().ToString());
                     Quat v = value.type() == Json::stringValue ? Quat::FromString(value.asCString()) : defaultValue.As<Quat>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break;
                 }
                 case Variant::PointType: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Point>().ToString());
                     Point v = value.type() == Json::stringValue ? Point::FromString(value.asCString()) : defaultValue.As<Point>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break;
                 }
                 case Variant::RectType: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Rect>().ToString());
                     Rect v = value.type() == Json::stringValue ? Rect::FromString(value.asCString()) : defaultValue.As<Rect>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break;
                 }
                 case Variant::GuidType: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Guid>().ToString());
                     Guid v = value.type() == Json::stringValue ? Guid::FromString(value.asCString()) : defaultValue.As<Guid>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break;
                 }
                 case Variant::StrType: {
                     const Json::Value value = subNode.get(elementIndex, defaultValue.As<Str>().c_str());
                     Str v = value.type() == Json::stringValue ? Str(value.asCString()) : defaultValue.As<Str>();
-                    SetArrayProperty(propertyIndex, elementIndex, v);
+                    SetArrayProperty(propertyInfo, elementIndex, v);
                     break;
                 }
                 default:
@@ -224,90 +233,90 @@ void Serializable::Deserialize(const Json::Value &node) {
 
             switch (type) {
             case Variant::IntType:
-                SetProperty(propertyIndex, value.asInt());
+                SetProperty(propertyInfo, value.asInt());
                 break;
             case Variant::Int64Type:
-                SetProperty(propertyIndex, value.asInt64());
+                SetProperty(propertyInfo, value.asInt64());
                 break;
             case Variant::BoolType:
-                SetProperty(propertyIndex, value.asBool());
+                SetProperty(propertyInfo, value.asBool());
                 break;
             case Variant::FloatType:
-                SetProperty(propertyIndex, value.asFloat());
+                SetProperty(propertyInfo, value.asFloat());
                 break;
             case Variant::Vec2Type: {
                 Vec2 v = value.type() == Json::stringValue ? Vec2::FromString(value.asCString()) : defaultValue.As<Vec2>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::Vec3Type: {
                 Vec3 v = value.type() == Json::stringValue ? Vec3::FromString(value.asCString()) : defaultValue.As<Vec3>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::Vec4Type: {
                 Vec4 v = value.type() == Json::stringValue ? Vec4::FromString(value.asCString()) : defaultValue.As<Vec4>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::Color3Type: {
                 Color3 v = value.type() == Json::stringValue ? Color3::FromString(value.asCString()) : defaultValue.As<Color3>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::Color4Type: {
                 Color4 v = value.type() == Json::stringValue ? Color4::FromString(value.asCString()) : defaultValue.As<Color4>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::Mat2Type: {
                 Mat2 v = value.type() == Json::stringValue ? Mat2::FromString(value.asCString()) : defaultValue.As<Mat2>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::Mat3Type: {
                 Mat3 v = value.type() == Json::stringValue ? Mat3::FromString(value.asCString()) : defaultValue.As<Mat3>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::Mat3x4Type: {
                 Mat3x4 v = value.type() == Json::stringValue ? Mat3x4::FromString(value.asCString()) : defaultValue.As<Mat3x4>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::Mat4Type: {
                 Mat4 v = value.type() == Json::stringValue ? Mat4::FromString(value.asCString()) : defaultValue.As<Mat4>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::AnglesType: {
                 Angles v = value.type() == Json::stringValue ? Angles::FromString(value.asCString()) : defaultValue.As<Angles>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::QuatType: {
                 Quat v = value.type() == Json::stringValue ? Quat::FromString(value.asCString()) : defaultValue.As<Quat>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::PointType: {
                 Point v = value.type() == Json::stringValue ? Point::FromString(value.asCString()) : defaultValue.As<Point>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::RectType: {
                 Rect v = value.type() == Json::stringValue ? Rect::FromString(value.asCString()) : defaultValue.As<Rect>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::GuidType: {
                 Guid v = value.type() == Json::stringValue ? Guid::FromString(value.asCString()) : defaultValue.As<Guid>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             case Variant::StrType: {
                 Str v = value.type() == Json::stringValue ? Str(value.asCString()) : defaultValue.As<Str>();
-                SetProperty(propertyIndex, v);
+                SetProperty(propertyInfo, v);
                 break;
             }
             default:
@@ -318,55 +327,190 @@ void Serializable::Deserialize(const Json::Value &node) {
     }
 }
 
+void Serializable::SerializeBinary(BinarySerializer &out) const {
+    const PropertyInfoTable &propertyInfoTable = GetPropertyInfoTable();
+
+    for (int propertyIndex = 0; propertyIndex < propertyInfoTable.Count(); propertyIndex++) {
+        const PropertyInfo &propertyInfo = propertyInfoTable[propertyIndex];
+
+        if (propertyInfo.GetFlags() & PropertyInfo::SkipSerializationFlag) {
+            continue;
+        }
+
+        const char *name = propertyInfo.name.c_str();
+
+        if (!BinarySerializer::IsSupportedType(propertyInfo.GetType())) {
+            BE_WARNLOG(L"Serializable::SerializeBinary: unsupported type for property '%hs'\n", name);
+            continue;
+        }
+
+        if (propertyInfo.GetFlags() & PropertyInfo::ArrayFlag) {
+            out.BeginArrayProperty(name, propertyInfo.GetType());
+
+            for (int elementIndex = 0; elementIndex < GetPropertyArrayCount(propertyInfo); elementIndex++) {
+                Variant value;
+                GetArrayProperty(propertyInfo, elementIndex, value);
+
+                out.WriteElement(value);
+            }
+
+            out.EndArrayProperty();
+        } else {
+            Variant value;
+            GetProperty(propertyInfo, value);
+
+            out.WriteProperty(name, value);
+        }
+    }
+}
+
+void Serializable::DeserializeBinary(const BinaryObject &in) {
+    const PropertyInfoTable &propertyInfoTable = GetPropertyInfoTable();
+
+    // Properties are mostly stored in the same order, so searching from the next of the previous one is fast
+    BinaryProperty hint;
+
+    for (int propertyIndex = 0; propertyIndex < propertyInfoTable.Count(); propertyIndex++) {
+        const PropertyInfo &propertyInfo = propertyInfoTable[propertyIndex];
+
+        if (propertyInfo.GetFlags() & PropertyInfo::ReadOnlyFlag) {
+            continue;
+        }
+
+        const Variant::Type type = propertyInfo.GetType();
+
+        BinaryProperty prop = in.FindProperty(propertyInfo.name.c_str(), hint);
+        if (prop.IsValid()) {
+            hint = prop.Next();
+        }
+
+        Variant value;
+
+        if (propertyInfo.GetFlags() & PropertyInfo::ArrayFlag) {
+            int numElements = prop.IsValid() && prop.IsArray() && !prop.IsObject() ? prop.Count() : 0;
+
+            SetPropertyArrayCount(propertyInfo, numElements);
+
+            for (int elementIndex = 0; elementIndex < numElements; elementIndex++) {
+                if (!prop.GetValue(type, value, elementIndex)) {
+                    value = propertyInfo.GetDefaultValue();
+                }
+                SetArrayProperty(propertyInfo, elementIndex, value);
+            }
+        } else {
+            if (!prop.IsValid() || prop.IsArray() || !prop.GetValue(type, value)) {
+                value = propertyInfo.GetDefaultValue();
+            }
+            SetProperty(propertyInfo, value);
+        }
+    }
+}
+
+void Serializable::CopyProperties(const Serializable &source, const HashTable<Guid, Guid> *remapGuidMap) {
+    const PropertyInfoTable &propertyInfoTable = GetPropertyInfoTable();
+    const PropertyInfoTable &sourcePropertyInfoTable = source.GetPropertyInfoTable();
+
+    Variant value;
+    Guid toGuid;
+
+    for (int propertyIndex = 0; propertyIndex < propertyInfoTable.Count(); propertyIndex++) {
+        const PropertyInfo &propertyInfo = propertyInfoTable[propertyIndex];
+
+        if (propertyInfo.GetFlags() & PropertyInfo::ReadOnlyFlag) {
+            continue;
+        }
+
+        const Variant::Type type = propertyInfo.GetType();
+        const bool isArray = !!(propertyInfo.GetFlags() & PropertyInfo::ArrayFlag);
+
+        // Tables are shared by the objects of the same class, except for the ones with dynamic properties
+        const PropertyInfo *sourcePropertyInfo = &sourcePropertyInfoTable == &propertyInfoTable ? &propertyInfo : sourcePropertyInfoTable.Find(propertyInfo.name);
+
+        // Properties skipped in serialization get default value as if deserialized
+        if (sourcePropertyInfo && (
+            (sourcePropertyInfo->GetFlags() & PropertyInfo::SkipSerializationFlag) ||
+            sourcePropertyInfo->GetType() != type ||
+            !!(sourcePropertyInfo->GetFlags() & PropertyInfo::ArrayFlag) != isArray)) {
+            sourcePropertyInfo = nullptr;
+        }
+
+        if (isArray) {
+            int numElements = sourcePropertyInfo ? source.GetPropertyArrayCount(*sourcePropertyInfo) : 0;
+
+            SetPropertyArrayCount(propertyInfo, numElements);
+
+            for (int elementIndex = 0; elementIndex < numElements; elementIndex++) {
+                source.GetArrayProperty(*sourcePropertyInfo, elementIndex, value);
+
+                if (type == Variant::GuidType && remapGuidMap && remapGuidMap->Get(value.As<Guid>(), &toGuid)) {
+                    value = toGuid;
+                }
+                SetArrayProperty(propertyInfo, elementIndex, value);
+            }
+        } else {
+            if (sourcePropertyInfo) {
+                source.GetProperty(*sourcePropertyInfo, value);
+
+                if (type == Variant::GuidType && remapGuidMap && remapGuidMap->Get(value.As<Guid>(), &toGuid)) {
+                    value = toGuid;
+                }
+            } else {
+                value = propertyInfo.GetDefaultValue();
+            }
+            SetProperty(propertyInfo, value);
+        }
+    }
+}
+
 Variant Serializable::GetPropertyDefault(const char *name) const {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(name);
     Variant out;
 
-    if (!GetPropertyInfo(name, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::GetPropertyDefault: invalid property name '%hs'\n", name);
         return out;
     }
 
-    out = propertyInfo.GetDefaultValue();
+    out = propertyInfo->GetDefaultValue();
     return out;
 }
 
 Variant Serializable::GetPropertyDefault(int index) const {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(index);
     Variant out;
 
-    if (!GetPropertyInfo(index, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::GetPropertyDefault: invalid property index %i\n", index);
         return out;
     }
 
-    out = propertyInfo.GetDefaultValue();
+    out = propertyInfo->GetDefaultValue();
     return out;
 }
 
 Variant Serializable::GetProperty(int index) const {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(index);
     Variant out;
 
-    if (!GetPropertyInfo(index, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::GetProperty: invalid property index %i\n", index);
         return out;
     }
 
-    GetProperty(propertyInfo, out);
+    GetProperty(*propertyInfo, out);
     return out;
 }
 
 Variant Serializable::GetProperty(const char *name) const {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(name);
     Variant out;
 
-    if (!GetPropertyInfo(name, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::GetProperty: invalid property name '%hs'\n", name);
         return out;
     }
 
-    GetProperty(propertyInfo, out);
+    GetProperty(*propertyInfo, out);
     return out;
 }
 
@@ -451,28 +595,28 @@ void Serializable::GetProperty(const PropertyInfo &propertyInfo, Variant &out) c
 }
 
 Variant Serializable::GetArrayProperty(int index, int elementIndex) const {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(index);
     Variant out;
 
-    if (!GetPropertyInfo(index, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::GetArrayProperty: invalid property index %i\n", index);
         return out;
     }
 
-    GetArrayProperty(propertyInfo, elementIndex, out);
+    GetArrayProperty(*propertyInfo, elementIndex, out);
     return out;
 }
 
 Variant Serializable::GetArrayProperty(const char *name, int elementIndex) const {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(name);
     Variant out;
 
-    if (!GetPropertyInfo(name, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::GetArrayProperty: invalid property name '%hs'\n", name);
         return out;
     }
 
-    GetArrayProperty(propertyInfo, elementIndex, out);
+    GetArrayProperty(*propertyInfo, elementIndex, out);
     return out;
 }
 
@@ -560,25 +704,25 @@ void Serializable::GetArrayProperty(const PropertyInfo &propertyInfo, int elemen
 }
 
 bool Serializable::SetProperty(const char *name, const Variant &value, bool forceWrite) {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(name);
 
-    if (!GetPropertyInfo(name, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::SetProperty: invalid property name '%hs'\n", name);
         return false;
     }
 
-    return SetProperty(propertyInfo, value, forceWrite);
+    return SetProperty(*propertyInfo, value, forceWrite);
 }
 
 bool Serializable::SetProperty(int index, const Variant &value, bool forceWrite) {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(index);
 
-    if (!GetPropertyInfo(index, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::SetProperty: invalid property index %i\n", index);
         return false;
     }
 
-    return SetProperty(propertyInfo, value, forceWrite);
+    return SetProperty(*propertyInfo, value, forceWrite);
 }
 
 bool Serializable::SetProperty(const PropertyInfo &propertyInfo, const Variant &value, bool forceWrite) {
@@ -820,25 +964,25 @@ bool Serializable::SetProperty(const PropertyInfo &propertyInfo, const Variant &
 }
 
 bool Serializable::SetArrayProperty(const char *name, int elementIndex, const Variant &value, bool forceWrite) {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(name);
 
-    if (!GetPropertyInfo(name, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::SetArrayProperty: invalid property name '%hs'\n", name);
         return false;
     }
 
-    return SetArrayProperty(propertyInfo, elementIndex, value, forceWrite);
+    return SetArrayProperty(*propertyInfo, elementIndex, value, forceWrite);
 }
 
 bool Serializable::SetArrayProperty(int index, int elementIndex, const Variant &value, bool forceWrite) {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(index);
 
-    if (!GetPropertyInfo(index, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::SetArrayProperty: invalid property index %i\n", index);
         return false;
     }
 
-    return SetArrayProperty(propertyInfo, elementIndex, value, forceWrite);
+    return SetArrayProperty(*propertyInfo, elementIndex, value, forceWrite);
 }
 
 bool Serializable::SetArrayProperty(const PropertyInfo &propertyInfo, int elementIndex, const Variant &value, bool forceWrite) {
@@ -1084,25 +1228,25 @@ bool Serializable::SetArrayProperty(const PropertyInfo &propertyInfo, int elemen
 }
 
 int Serializable::GetPropertyArrayCount(const char *name) const {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(name);
 
-    if (!GetPropertyInfo(name, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::GetPropertyArrayCount: invalid property name '%hs'\n", name);
         return 0;
     }
 
-    return GetPropertyArrayCount(propertyInfo);
+    return GetPropertyArrayCount(*propertyInfo);
 }
 
 int Serializable::GetPropertyArrayCount(int index) const {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(index);
 
-    if (!GetPropertyInfo(index, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::GetPropertyArrayCount: invalid property index %i\n", index);
         return 0;
     }
 
-    return GetPropertyArrayCount(propertyInfo);
+    return GetPropertyArrayCount(*propertyInfo);
 }
 
 int Serializable::GetPropertyArrayCount(const PropertyInfo &propertyInfo) const {
@@ -1120,25 +1264,25 @@ int Serializable::GetPropertyArrayCount(const PropertyInfo &propertyInfo) const
 }
 
 void Serializable::SetPropertyArrayCount(const char *name, int count) {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(name);
 
-    if (!GetPropertyInfo(name, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::SetPropertyArrayCount: invalid property name '%hs'\n", name);
         return;
     }
 
-    SetPropertyArrayCount(propertyInfo, count);
+    SetPropertyArrayCount(*propertyInfo, count);
 }
 
 void Serializable::SetPropertyArrayCount(int index, int count) {
-    PropertyInfo propertyInfo;
+    const PropertyInfo *propertyInfo = FindPropertyInfo(index);
 
-    if (!GetPropertyInfo(index, propertyInfo)) {
+    if (!propertyInfo) {
         BE_WARNLOG(L"Serializable::SetPropertyArrayCount: invalid property index %i'\n", index);
         return;
     }
 
-    SetPropertyArrayCount(propertyInfo, count);
+    SetPropertyArrayCount(*propertyInfo, count);
 }
 
 void Serializable::SetPropertyArrayCount(const PropertyInfo &propertyInfo, int count) {
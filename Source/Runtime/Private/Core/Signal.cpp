@@ -154,20 +154,24 @@ const SignalDef *SignalDef::FindSignal(const char *name) {
 //-----------------------------------------------------------------------------------------
 
 bool                SignalSystem::initialized = false;
+Array<Signal *>     SignalSystem::signalBlocks;
 LinkList<Signal>    SignalSystem::freeSignals;
 LinkList<Signal>    SignalSystem::signalQueue;
-Signal              SignalSystem::signalPool[SignalSystem::MaxSignals];
 
 Signal::~Signal() {
-    SignalSystem::FreeSignal(this);
+    if (data) {
+        Mem_Free(data);
+    }
 }
 
 void SignalSystem::Clear() {
-    freeSignals.Clear();
-    signalQueue.Clear();
+    // Return all the signals to the free list
+    for (int blockIndex = 0; blockIndex < signalBlocks.Count(); blockIndex++) {
+        Signal *block = signalBlocks[blockIndex];
 
-    for (int i = 0; i < SignalSystem::MaxSignals; i++) {
-        FreeSignal(&signalPool[i]);
+        for (int i = 0; i < SignalBlockSize; i++) {
+            FreeSignal(&block[i]);
+        }
     }
 }
 
@@ -185,6 +189,10 @@ void SignalSystem::Init() {
         return;
     }
 
+    if (signalBlocks.Count() == 0) {
+        AllocSignalBlock();
+    }
+
     BE_LOG(L"...%i signal definitions\n", SignalDef::NumSignals());
 
     initialized = true;
@@ -200,9 +208,30 @@ void SignalSystem::Shutdown() {
 
     Clear();
 
+    freeSignals.Clear();
+
+    for (int blockIndex = 0; blockIndex < signalBlocks.Count(); blockIndex++) {
+        delete [] signalBlocks[blockIndex];
+    }
+    signalBlocks.Clear();
+
     initialized = false;
 }
 
+void SignalSystem::AllocSignalBlock() {
+    Signal *block = new Signal[SignalBlockSize];
+
+    signalBlocks.Append(block);
+
+    for (int i = 0; i < SignalBlockSize; i++) {
+        Signal *signal = &block[i];
+
+        signal->node.SetOwner(signal);
+        signal->receiverNode.SetOwner(signal);
+        signal->node.AddToEnd(freeSignals);
+    }
+}
+
 void SignalSystem::FreeSignal(Signal *signal) {
     if (signal->data) {
         Mem_Free(signal->data);
@@ -213,13 +242,13 @@ void SignalSystem::FreeSignal(Signal *signal) {
     signal->receiver = nullptr;
     signal->callback = nullptr;
 
-    signal->node.SetOwner(signal);
+    signal->receiverNode.Remove();
     signal->node.AddToEnd(SignalSystem::freeSignals);
 }
 
-Signal *SignalSystem::AllocSignal(const SignalDef *sigdef, const SignalCallback callback, int numArgs, va_list args) {
+Signal *SignalSystem::AllocSignal(const SignalDef *sigdef, const SignalCallback callback, int numArgs, const VariantArg *args) {
     if (freeSignals.IsListEmpty()) {
-        BE_ERRLOG(L"SignalSystem::AllocSignal: No more free signals\n");
+        AllocSignalBlock();
     }
 
     Signal *newSignal = freeSignals.Next();
@@ -242,7 +271,7 @@ Signal *SignalSystem::AllocSignal(const SignalDef *sigdef, const SignalCallback
     // Copy arguments to signal data
     const char *format = sigdef->GetArgFormat();
     for (int argIndex = 0; argIndex < numArgs; argIndex++) {
-        VariantArg *arg = va_arg(args, VariantArg *);
+        const VariantArg *arg = &args[argIndex];
         if (format[argIndex] != arg->type) {
             BE_ERRLOG(L"SignalSystem::AllocSignal: Wrong type passed in for arg #%d on '%hs' signal.\n", argIndex, sigdef->GetName());
         }
@@ -308,7 +337,7 @@ Signal *SignalSystem::AllocSignal(const SignalDef *sigdef, const SignalCallback
     return newSignal;
 }
 
-void SignalSystem::CopyArgPtrs(const SignalDef *sigdef, int numArgs, va_list args, intptr_t argPtrs[EventDef::MaxArgs]) {
+void SignalSystem::CopyArgPtrs(const SignalDef *sigdef, int numArgs, const VariantArg *args, intptr_t argPtrs[EventDef::MaxArgs]) {
     if (numArgs != sigdef->GetNumArgs()) { 
         BE_ERRLOG(L"SignalSystem::CopyArgPtrs: Wrong number of args for '%hs' signal.\n", sigdef->GetName());
     }
@@ -316,7 +345,7 @@ void SignalSystem::CopyArgPtrs(const SignalDef *sigdef, int numArgs, va_list arg
     const char *format = sigdef->GetArgFormat();
 
     for (int argIndex = 0; argIndex < numArgs; argIndex++) {
-        VariantArg *arg = va_arg(args, VariantArg *);
+        const VariantArg *arg = &args[argIndex];
         if (format[argIndex] != arg->type) {
             BE_ERRLOG(L"SignalSystem::CopyArgPtrs: Wrong type passed in for arg #%d on '%hs' signal.\n", argIndex, sigdef->GetName());
         }
@@ -333,8 +362,8 @@ void SignalSystem::ScheduleSignal(Signal *signal, SignalObject *receiver) {
 
     signal->receiver = receiver;
 
-    signal->node.Remove();
     signal->node.AddToEnd(signalQueue);
+    signal->receiverNode.AddToEnd(receiver->pendingSignals);
 }
 
 void SignalSystem::CancelSignal(const SignalObject *receiver, const SignalDef *sigdef) {
@@ -342,15 +371,12 @@ void SignalSystem::CancelSignal(const SignalObject *receiver, const SignalDef *s
         return;
     }
 
-    LinkList<Signal> &queue = signalQueue;
-
+    // Only visit the signals queued for the receiver
     Signal *next;
-    for (Signal *signal = queue.Next(); signal != nullptr; signal = next) {
-        next = signal->node.Next();
-        if (signal->receiver == receiver) {
-            if (!sigdef || (sigdef == signal->signalDef)) {
-                FreeSignal(signal);
-            }
+    for (Signal *signal = receiver->pendingSignals.Next(); signal != nullptr; signal = next) {
+        next = signal->receiverNode.Next();
+        if (!sigdef || (sigdef == signal->signalDef)) {
+            FreeSignal(signal);
         }
     }
 }
@@ -373,13 +399,13 @@ void SignalSystem::ServiceSignal(Signal *signal) {
             argPtrs[i] = *reinterpret_cast<int *>(&data[offset]);
             break;
         case VariantArg::FloatType:
-            argPtrs[i] = *reinterpret_cast<float *>(&data[offset]);
+            *reinterpret_cast<float *>(&argPtrs[i]) = *reinterpret_cast<float *>(&data[offset]);
             break; 
         case VariantArg::PointerType:
             *reinterpret_cast<void **>(&argPtrs[i]) = *reinterpret_cast<void **>(&data[offset]);
             break;
         case VariantArg::PointType:
-            *reinterpret_cast<Point **>(argPtrs[i]) = reinterpret_cast<Point *>(&data[offset]);
+            *reinterpret_cast<Point **>(&argPtrs[i]) = reinterpret_cast<Point *>(&data[offset]);
             break;
         case VariantArg::RectType:
             *reinterpret_cast<Rect **>(&argPtrs[i]) = reinterpret_cast<Rect *>(&data[offset]);
@@ -410,6 +436,7 @@ void SignalSystem::ServiceSignal(Signal *signal) {
     // the signal is removed from its list so that if then object
     // is deleted, the signal won't be freed twice
     signal->node.Remove();
+    signal->receiverNode.Remove();
     assert(signal->receiver);
     signal->receiver->ExecuteCallback(signal->callback, sigdef, argPtrs);
 
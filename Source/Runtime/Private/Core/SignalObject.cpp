@@ -19,9 +19,10 @@
 BE_NAMESPACE_BEGIN
 
 SignalObject::~SignalObject() {
-    while (publications.Count() > 0) {
-        const Connection *con = publications[0];
-        con->sender->Disconnect(con->signalDef, con->receiver, con->function);
+    for (int listIndex = 0; listIndex < publications.Count(); listIndex++) {
+        while (publications[listIndex].connections.Count() > 0) {
+            RemovePublication(listIndex, publications[listIndex].connections.Count() - 1);
+        }
     }
 
     while (subscriptions.Count() > 0) {
@@ -29,13 +30,45 @@ SignalObject::~SignalObject() {
         con->sender->Disconnect(con->signalDef, con->receiver, con->function);
     }
 
-    SignalSystem::CancelSignal(this);
+    if (!pendingSignals.IsListEmpty()) {
+        SignalSystem::CancelSignal(this);
+    }
+}
+
+int SignalObject::FindPublications(const SignalDef *sigdef) const {
+    for (int listIndex = 0; listIndex < publications.Count(); listIndex++) {
+        if (publications[listIndex].signalDef == sigdef) {
+            return listIndex;
+        }
+    }
+    return -1;
+}
+
+void SignalObject::RemovePublication(int listIndex, int connectionIndex) {
+    Array<Connection *> &connections = publications[listIndex].connections;
+    Connection *con = connections[connectionIndex];
+
+    // remove receiver's subscription
+    con->receiver->subscriptions.RemoveFast(con);
+
+    // remove sender's publication.
+    // keeps the order of connections because this can be called while emitting.
+    connections.RemoveIndex(connectionIndex);
+
+    delete con;
 }
 
 bool SignalObject::IsConnected(const SignalDef *sigdef, SignalObject *receiver, SignalCallback function) const {
-    for (int i = 0; i < publications.Count(); i++) {
-        const Connection *con = publications[i];
-        if (con->signalDef == sigdef && con->sender == this && con->receiver == receiver && con->function == function) {
+    int listIndex = FindPublications(sigdef);
+    if (listIndex < 0) {
+        return false;
+    }
+
+    const Array<Connection *> &connections = publications[listIndex].connections;
+
+    for (int i = 0; i < connections.Count(); i++) {
+        const Connection *con = connections[i];
+        if (con->receiver == receiver && con->function == function) {
             return true;
         }
     }
@@ -44,9 +77,15 @@ bool SignalObject::IsConnected(const SignalDef *sigdef, SignalObject *receiver,
 }
 
 bool SignalObject::IsConnected(const SignalDef *sigdef, SignalObject *receiver) const {
-    for (int i = 0; i < publications.Count(); i++) {
-        const Connection *con = publications[i];
-        if (con->signalDef == sigdef && con->sender == this && con->receiver == receiver) {
+    int listIndex = FindPublications(sigdef);
+    if (listIndex < 0) {
+        return false;
+    }
+
+    const Array<Connection *> &connections = publications[listIndex].connections;
+
+    for (int i = 0; i < connections.Count(); i++) {
+        if (connections[i]->receiver == receiver) {
             return true;
         }
     }
@@ -56,15 +95,19 @@ bool SignalObject::IsConnected(const SignalDef *sigdef, SignalObject *receiver)
 
 bool SignalObject::Connect(const SignalDef *sigdef, SignalObject *receiver, SignalCallback function, int connectionType) {
     if (connectionType == Unique) {
-        for (int i = 0; i < publications.Count(); i++) {
-            const Connection *con = publications[i];
-
-            if (con->signalDef == sigdef && con->sender == this && con->receiver == receiver && con->function == function) {
-                return false;
-            }
+        if (IsConnected(sigdef, receiver, function)) {
+            return false;
         }
     }
 
+    int listIndex = FindPublications(sigdef);
+    if (listIndex < 0) {
+        listIndex = publications.Count();
+
+        ConnectionList &list = publications.Alloc();
+        list.signalDef = sigdef;
+    }
+
     Connection *con = new Connection;
     con->signalDef = sigdef;
     con->connectionType = connectionType;
@@ -73,23 +116,24 @@ bool SignalObject::Connect(const SignalDef *sigdef, SignalObject *receiver, Sign
     con->function = function;
 
     // connection pointer is shared among sender's publications and receiver's subscriptions.
-    this->publications.Append(con);
+    publications[listIndex].connections.Append(con);
     receiver->subscriptions.Append(con);
 
     return true;
 }
 
 bool SignalObject::Disconnect(const SignalDef *sigdef, SignalObject *receiver, SignalCallback function) {
-    for (int i = 0; i < publications.Count(); i++) {
-        const Connection *con = publications[i];
-        if (con->signalDef == sigdef && con->receiver == receiver && con->function == function) {
-            // remove receiver's subscription
-            int index = con->receiver->subscriptions.FindIndex(publications[i]);
-            con->receiver->subscriptions.RemoveIndexFast(index);
-
-            // remove sender's publication
-            delete publications[i];
-            publications.RemoveIndexFast(i);
+    int listIndex = FindPublications(sigdef);
+    if (listIndex < 0) {
+        return false;
+    }
+
+    const Array<Connection *> &connections = publications[listIndex].connections;
+
+    for (int i = 0; i < connections.Count(); i++) {
+        const Connection *con = connections[i];
+        if (con->receiver == receiver && con->function == function) {
+            RemovePublication(listIndex, i);
             return true;
         }
     }
@@ -98,60 +142,43 @@ bool SignalObject::Disconnect(const SignalDef *sigdef, SignalObject *receiver, S
 }
 
 bool SignalObject::Disconnect(const SignalDef *sigdef, SignalObject *receiver) {
-    int *removeIndexes = (int *)_alloca(sizeof(removeIndexes[0]) * publications.Count());
-    int count = 0;
-
-    for (int i = 0; i < publications.Count(); i++) {
-        const Connection *con = publications[i];
-        if (con->signalDef == sigdef && con->receiver == receiver) {
-            // remove receiver's subscription
-            int index = con->receiver->subscriptions.FindIndex(publications[i]);
-            con->receiver->subscriptions.RemoveIndexFast(index);
-
-            // stack sender's publication for remove
-            removeIndexes[count++] = i;	
-        }
+    int listIndex = FindPublications(sigdef);
+    if (listIndex < 0) {
+        return false;
     }
 
-    if (count > 0) {
-        for (int i = 0; i < count; i++) {
-            delete publications[removeIndexes[i]];
-            publications.RemoveIndexFast(removeIndexes[i]);
+    const Array<Connection *> &connections = publications[listIndex].connections;
+    bool disconnected = false;
+
+    for (int i = connections.Count() - 1; i >= 0; i--) {
+        if (connections[i]->receiver == receiver) {
+            RemovePublication(listIndex, i);
+            disconnected = true;
         }
-        return true;
     }
 
-    return false;
+    return disconnected;
 }
 
 bool SignalObject::Disconnect(const SignalDef *sigdef) {
-    int *removeIndexes = (int *)_alloca(sizeof(removeIndexes[0]) * publications.Count());
-    int count = 0;
-
-    for (int i = 0; i < publications.Count(); i++) {
-        const Connection *con = publications[i];
-        if (con->signalDef == sigdef) {
-            // remove receiver's subscription
-            int index = con->receiver->subscriptions.FindIndex(publications[i]);
-            con->receiver->subscriptions.RemoveIndexFast(index);
-            
-            // stack sender's publication for remove
-            removeIndexes[count++] = i;
-        }
+    int listIndex = FindPublications(sigdef);
+    if (listIndex < 0) {
+        return false;
     }
 
-    if (count > 0) {
-        for (int i = 0; i < count; i++) {
-            delete publications[removeIndexes[i]];
-            publications.RemoveIndexFast(removeIndexes[i]);
-        }
-        return true;
+    const Array<Connection *> &connections = publications[listIndex].connections;
+    if (connections.Count() == 0) {
+        return false;
     }
 
-    return false;
+    while (connections.Count() > 0) {
+        RemovePublication(listIndex, connections.Count() - 1);
+    }
+
+    return true;
 }
 
-bool SignalObject::EmitSignalArgs(const SignalDef *sigdef, int numArgs, ...) {
+bool SignalObject::EmitSignalArgs(const SignalDef *sigdef, int numArgs, const VariantArg *args) {
     assert(sigdef);
     assert(SignalSystem::initialized);
 
@@ -159,24 +186,21 @@ bool SignalObject::EmitSignalArgs(const SignalDef *sigdef, int numArgs, ...) {
         return false;
     }
 
+    int listIndex = FindPublications(sigdef);
+    if (listIndex < 0 || publications[listIndex].connections.Count() == 0) {
+        return true;
+    }
+
     intptr_t argPtrs[EventDef::MaxArgs];
 
-    va_list args;
-    va_start(args, numArgs);
     SignalSystem::CopyArgPtrs(sigdef, numArgs, args, argPtrs);
-    va_end(args);
 
-    for (int i = 0; i < publications.Count(); i++) {
-        const Connection *con = publications[i];
-
-        if (con->signalDef != sigdef) {
-            continue;
-        }
+    // Callbacks can connect or disconnect signals, so don't keep the reference of the list
+    for (int i = 0; i < publications[listIndex].connections.Count(); i++) {
+        const Connection *con = publications[listIndex].connections[i];
 
         if (con->connectionType & Queued) {
-            va_start(args, numArgs);
             Signal *signal = SignalSystem::AllocSignal(sigdef, con->function, numArgs, args);
-            va_end(args);
 
             SignalSystem::ScheduleSignal(signal, con->receiver);
             continue;
@@ -26,6 +26,8 @@
 #include "Core/CVars.h"
 #include "Core/Cmds.h"
 #include "File/FileSystem.h"
+#include "File/AsyncFileIO.h"
+#include "Render/Render.h"
 #include "Game/GameSettings.h"
 
 BE_NAMESPACE_BEGIN
@@ -174,7 +176,16 @@ void Common::RunFrame(int frameMsec) {
 
     ProcessPlatformEvent();
 
+    // Async file reads are delivered here, once per frame
+    asyncFileIO.DispatchCompletions();
+
+    // Streamed mipmaps are requested and uploaded after the reads are delivered, for the editor and the players
+    textureManager.UpdateStreaming();
+
     cmdSystem.ExecuteCommandBuffer();
+
+    // Heap counters are per thread, so peak usage is sampled once per frame
+    Mem_UpdatePeaks();
 }
 
 Common::PlatformId Common::GetPlatformId() const {
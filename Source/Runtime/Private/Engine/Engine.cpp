@@ -42,6 +42,8 @@ void Engine::InitBase(const char *baseDir, bool forceGenericSIMD, const streamOu
 
     cmdSystem.Init();
 
+    Mem_Init();
+
     cvarSystem.Init();
 
     fileSystem.Init(baseDir);
@@ -53,9 +55,21 @@ void Engine::InitBase(const char *baseDir, bool forceGenericSIMD, const streamOu
     PlatformTime::Init();
 
     Math::Init();
+
+    profiler.Init();
+
+    jobSystem.Init();
+
+    asyncFileIO.Init();
 }
 
 void Engine::ShutdownBase() {
+    asyncFileIO.Shutdown();
+
+    jobSystem.Shutdown();
+
+    profiler.Shutdown();
+
     PlatformTime::Shutdown();
     
     SIMD::Shutdown();
@@ -64,6 +78,8 @@ void Engine::ShutdownBase() {
 
     cvarSystem.Shutdown();
 
+    Mem_Shutdown();
+
     cmdSystem.Shutdown();
 }
 
@@ -133,6 +149,9 @@ static void RegisterEngineObjects() {
     TagLayerSettings::RegisterProperties();
     PhysicsSettings::RegisterProperties();
     PlayerSettings::RegisterProperties();
+
+    // Flatten property tables of all classes once, so that (de)serialization doesn't need to
+    Object::InitPropertyInfoTables();
 }
 
 void Engine::Init(const InitParms *initParms) {
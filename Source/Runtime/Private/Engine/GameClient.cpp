@@ -17,6 +17,7 @@
 #include "Core/Cmds.h"
 #include "Core/CVars.h"
 #include "Core/Vec4Color.h"
+#include "Core/Profiler.h"
 #include "Render/Render.h"
 #include "Physics/Physics.h"
 #include "Input/KeyCmd.h"
@@ -47,6 +48,7 @@ static CVAR(cl_conNoPrint, L"1", CVar::Bool, L"");
 static CVAR(cl_conNotifyTime, L"3.0", CVar::Float | CVar::Archive, L"");
 static CVAR(cl_showFps, L"0", CVar::Bool, L"");
 static CVAR(cl_showTimer, L"0", CVar::Bool, L"");
+static CVAR(cl_showProfile, L"0", CVar::Bool, L"show per-zone CPU time of the last frame");
 
 GameClient      gameClient;
 
@@ -208,6 +210,9 @@ void GameClient::RunFrame() {
 
 void GameClient::EndFrame() {
     inputSystem.EndFrame();
+
+    profiler.EnableFrameStats(cl_showProfile.GetBool());
+    profiler.SyncFrame();
 }
 
 void GameClient::UpdateConsole() {
@@ -476,6 +481,20 @@ void GameClient::DrawConsole() {
         DrawString(0, CONSOLE_FONT_HEIGHT, wva(L"%02i:%02i:%02i", hours, minutes, seconds), -1, DTF_RIGHT | DTF_DROPSHADOW);
     }
 
+    if (cl_showProfile.GetBool()) {
+        SetTextColor(Color4::white);
+
+        const Array<Profiler::ZoneStats> &zoneStats = profiler.GetFrameStats();
+        int numLines = Min(zoneStats.Count(), 20);
+        int y = CONSOLE_FONT_HEIGHT * 2;
+
+        for (int i = 0; i < numLines; i++) {
+            const Profiler::ZoneStats &stats = zoneStats[i];
+            DrawString(0, y, wva(L"%hs: %.2fms (%i)", stats.name, stats.msec, stats.calls), -1, DTF_DROPSHADOW);
+            y += CONSOLE_FONT_HEIGHT;
+        }
+    }
+
     if (consoleHeight > 0.0f) {
         DrawConsoleScreen();
     } else {
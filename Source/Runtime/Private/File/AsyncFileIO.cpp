@@ -0,0 +1,685 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "Precompiled.h"
+#include "Core/Heap.h"
+#include "Core/Profiler.h"
+#include "Platform/PlatformProcess.h"
+#include "Platform/PlatformTime.h"
+#include "File/FileSystem.h"
+#include "File/ZipArchive.h"
+#include "File/AsyncFileIO.h"
+#include <atomic>
+
+BE_NAMESPACE_BEGIN
+
+AsyncFileIO asyncFileIO;
+
+struct AsyncIORequest {
+    Str                     filename;
+    uint64_t                offset;
+    size_t                  size;
+    void *                  buffer;
+    bool                    ownsBuffer;
+    AsyncIOPriority::Enum   priority;
+    uint64_t                sequence;
+    asyncIOCallback_t       callback;
+    void *                  userData;
+    AsyncIOStatus::Enum     status;
+    AsyncIOStatus::Enum     readStatus;         ///< Result of the read, written by the I/O thread without the lock
+    uint32_t                generation;         ///< Incremented each time this request is recycled
+    size_t                  chargedBytes;       ///< Bytes counted in the outstanding bytes
+    bool                    resolved;
+    bool                    resolving;
+    std::atomic<bool>       cancelRequested;
+    FileLocation            location;
+    uint64_t                physicalStart;      ///< Position of the data to read in the file or the archive mapping
+    uint64_t                physicalEnd;
+};
+
+// Thread that receives the completions, set by Init()
+static thread_local const AsyncFileIO *completionThreadOwner = nullptr;
+
+static bool InSameFile(const AsyncIORequest *a, const AsyncIORequest *b) {
+    if (a->location.archive != b->location.archive) {
+        return false;
+    }
+    if (a->location.archive) {
+        return a->location.entryIndex == b->location.entryIndex;
+    }
+    return !Str::IcmpPath(a->location.path, b->location.path);
+}
+
+// Returns true if the next request can be read in the same batch right after the previous one.
+static bool FollowsRequest(const AsyncIORequest *prev, const AsyncIORequest *next) {
+    if (InSameFile(prev, next)) {
+        return next->offset == prev->offset + prev->size;
+    }
+    if (prev->location.archive && prev->location.archive == next->location.archive) {
+        return next->physicalStart >= prev->physicalEnd && next->physicalStart - prev->physicalEnd <= AsyncFileIO::MaxCoalesceGap;
+    }
+    return false;
+}
+
+AsyncFileIO::AsyncFileIO() {
+    initialized = false;
+    terminate = false;
+    sequence = 0;
+    outstandingBytes = 0;
+    maxOutstandingBytes = 0;
+    bandwidthLimit = 0;
+    throttleTime = 0;
+    mutex = nullptr;
+    requestCondition = nullptr;
+    finishCondition = nullptr;
+}
+
+void AsyncFileIO::Init(int numThreads) {
+    if (initialized) {
+        return;
+    }
+
+    Clamp(numThreads, 1, (int)MaxThreads);
+
+    mutex = PlatformMutex::Create();
+    requestCondition = PlatformCondition::Create();
+    finishCondition = PlatformCondition::Create();
+
+    terminate = false;
+    outstandingBytes = 0;
+    throttleTime = 0;
+
+    completionThreadOwner = this;
+
+    initialized = true;
+
+    for (int i = 0; i < numThreads; i++) {
+        PlatformThread *thread = PlatformThread::Create(IOThreadProc, (void *)this, 0);
+        ioThreads.Append(thread);
+    }
+}
+
+void AsyncFileIO::Shutdown() {
+    if (!initialized) {
+        return;
+    }
+
+    PlatformMutex::Lock(mutex);
+    terminate = true;
+    PlatformCondition::Broadcast(requestCondition);
+    PlatformMutex::Unlock(mutex);
+
+    for (int i = 0; i < ioThreads.Count(); i++) {
+        PlatformThread::Wait(ioThreads[i]);
+    }
+    ioThreads.Clear();
+
+    // Requests that are not delivered yet are dropped without calling their callbacks
+    for (int i = 0; i < allRequests.Count(); i++) {
+        AsyncIORequest *request = allRequests[i];
+        if (request->ownsBuffer) {
+            Mem_Free(request->buffer);
+        }
+        delete request;
+    }
+    allRequests.Clear();
+    freeRequests.Clear();
+    pendingRequests.Clear();
+    finishedRequests.Clear();
+
+    PlatformCondition::Delete(finishCondition);
+    PlatformCondition::Delete(requestCondition);
+    PlatformMutex::Delete(mutex);
+
+    if (completionThreadOwner == this) {
+        completionThreadOwner = nullptr;
+    }
+
+    initialized = false;
+}
+
+AsyncIORequest *AsyncFileIO::AllocRequest() {
+    AsyncIORequest *request;
+    if (freeRequests.Count() > 0) {
+        request = freeRequests.Last();
+        freeRequests.RemoveIndex(freeRequests.Count() - 1);
+    } else {
+        request = new AsyncIORequest;
+        request->generation = 0;
+        allRequests.Append(request);
+    }
+    return request;
+}
+
+void AsyncFileIO::FreeRequest(AsyncIORequest *request) {
+    request->generation++;
+    request->filename.Clear();
+    request->location.path.Clear();
+    request->buffer = nullptr;
+    request->ownsBuffer = false;
+    freeRequests.Append(request);
+}
+
+AsyncIORequest *AsyncFileIO::GetRequest(const AsyncIOHandle &handle) const {
+    if (!handle.request || handle.request->generation != handle.generation) {
+        return nullptr;
+    }
+    return handle.request;
+}
+
+AsyncIOHandle AsyncFileIO::Read(const char *filename, uint64_t offset, size_t size, void *buffer, AsyncIOPriority::Enum priority, asyncIOCallback_t callback, void *userData) {
+    assert(initialized);
+    // A caller's buffer needs to know how much to read
+    assert(!buffer || size > 0);
+
+    PlatformMutex::Lock(mutex);
+
+    AsyncIORequest *request = AllocRequest();
+    request->filename = filename;
+    request->offset = offset;
+    request->size = size;
+    request->buffer = buffer;
+    request->ownsBuffer = false;
+    request->priority = priority;
+    request->sequence = sequence++;
+    request->callback = callback;
+    request->userData = userData;
+    request->status = AsyncIOStatus::Pending;
+    request->readStatus = AsyncIOStatus::Pending;
+    request->chargedBytes = 0;
+    request->resolved = false;
+    request->resolving = false;
+    request->cancelRequested = false;
+
+    pendingRequests.Append(request);
+
+    AsyncIOHandle handle;
+    handle.request = request;
+    handle.generation = request->generation;
+
+    PlatformCondition::Signal(requestCondition);
+    PlatformMutex::Unlock(mutex);
+
+    return handle;
+}
+
+AsyncIOHandle AsyncFileIO::ReadFile(const char *filename, AsyncIOPriority::Enum priority, asyncIOCallback_t callback, void *userData) {
+    return Read(filename, 0, 0, nullptr, priority, callback, userData);
+}
+
+bool AsyncFileIO::Cancel(const AsyncIOHandle &handle) {
+    PlatformMutex::Lock(mutex);
+
+    AsyncIORequest *request = GetRequest(handle);
+    if (!request) {
+        PlatformMutex::Unlock(mutex);
+        return false;
+    }
+
+    switch (request->status) {
+    case AsyncIOStatus::Pending:
+        if (request->resolving) {
+            // The resolving thread finishes the request
+            request->cancelRequested = true;
+        } else {
+            pendingRequests.RemoveFast(request);
+            request->status = AsyncIOStatus::Cancelled;
+            finishedRequests.Append(request);
+            PlatformCondition::Broadcast(finishCondition);
+        }
+        break;
+    case AsyncIOStatus::InFlight:
+        request->cancelRequested = true;
+        break;
+    default:
+        request->status = AsyncIOStatus::Cancelled;
+        break;
+    }
+
+    PlatformMutex::Unlock(mutex);
+    return true;
+}
+
+bool AsyncFileIO::SetPriority(const AsyncIOHandle &handle, AsyncIOPriority::Enum priority) {
+    PlatformMutex::Lock(mutex);
+
+    AsyncIORequest *request = GetRequest(handle);
+    bool result = request && request->status == AsyncIOStatus::Pending;
+    if (result) {
+        request->priority = priority;
+    }
+
+    PlatformMutex::Unlock(mutex);
+    return result;
+}
+
+bool AsyncFileIO::IsFinished(const AsyncIOHandle &handle) const {
+    PlatformMutex::Lock(mutex);
+
+    const AsyncIORequest *request = GetRequest(handle);
+    bool finished = !request || (request->status != AsyncIOStatus::Pending && request->status != AsyncIOStatus::InFlight);
+
+    PlatformMutex::Unlock(mutex);
+    return finished;
+}
+
+void AsyncFileIO::Wait(const AsyncIOHandle &handle) {
+    PlatformMutex::Lock(mutex);
+
+    AsyncIORequest *request = GetRequest(handle);
+    if (!request) {
+        PlatformMutex::Unlock(mutex);
+        return;
+    }
+
+    // Nobody should wait behind the requests we are blocking on
+    if (request->status == AsyncIOStatus::Pending) {
+        request->priority = AsyncIOPriority::Critical;
+        PlatformCondition::Broadcast(requestCondition);
+    }
+
+    while (request->generation == handle.generation && (request->status == AsyncIOStatus::Pending || request->status == AsyncIOStatus::InFlight)) {
+        PlatformCondition::Wait(finishCondition, mutex);
+    }
+
+    bool deliver = completionThreadOwner == this && request->generation == handle.generation && finishedRequests.Remove(request);
+
+    PlatformMutex::Unlock(mutex);
+
+    if (deliver) {
+        Deliver(request);
+
+        PlatformMutex::Lock(mutex);
+        outstandingBytes -= request->chargedBytes;
+        FreeRequest(request);
+        PlatformCondition::Broadcast(requestCondition);
+        PlatformMutex::Unlock(mutex);
+    }
+}
+
+void AsyncFileIO::DispatchCompletions() {
+    if (!initialized) {
+        return;
+    }
+    assert(completionThreadOwner == this);
+
+    BE_PROFILE_SCOPE("AsyncFileIO::DispatchCompletions");
+
+    Array<AsyncIORequest *> requests;
+
+    PlatformMutex::Lock(mutex);
+    requests.Swap(finishedRequests);
+    PlatformMutex::Unlock(mutex);
+
+    if (requests.Count() == 0) {
+        return;
+    }
+
+    for (int i = 0; i < requests.Count(); i++) {
+        Deliver(requests[i]);
+    }
+
+    PlatformMutex::Lock(mutex);
+    for (int i = 0; i < requests.Count(); i++) {
+        outstandingBytes -= requests[i]->chargedBytes;
+        FreeRequest(requests[i]);
+    }
+    PlatformCondition::Broadcast(requestCondition);
+    PlatformMutex::Unlock(mutex);
+}
+
+void AsyncFileIO::Deliver(AsyncIORequest *request) {
+    // Status may be changed by Cancel() until the request is taken out of the finished list
+    PlatformMutex::Lock(mutex);
+    AsyncIOStatus::Enum status = request->status;
+    PlatformMutex::Unlock(mutex);
+
+    AsyncIOResult result;
+    result.handle.request = request;
+    result.handle.generation = request->generation;
+    result.filename = request->filename;
+    result.status = status;
+    result.data = status == AsyncIOStatus::Completed ? request->buffer : nullptr;
+    result.size = status == AsyncIOStatus::Completed ? request->size : 0;
+    result.ownsData = request->ownsBuffer && status == AsyncIOStatus::Completed;
+
+    if (request->callback) {
+        request->callback(result, request->userData);
+    }
+
+    if (request->ownsBuffer && (status != AsyncIOStatus::Completed || result.ownsData)) {
+        Mem_Free(request->buffer);
+    }
+    request->buffer = nullptr;
+    request->ownsBuffer = false;
+}
+
+void AsyncFileIO::SetMaxOutstandingBytes(size_t bytes) {
+    PlatformMutex::Lock(mutex);
+    maxOutstandingBytes = bytes;
+    PlatformCondition::Broadcast(requestCondition);
+    PlatformMutex::Unlock(mutex);
+}
+
+void AsyncFileIO::SetBandwidthLimit(size_t bytesPerSecond) {
+    PlatformMutex::Lock(mutex);
+    bandwidthLimit = bytesPerSecond;
+    throttleTime = 0;
+    PlatformMutex::Unlock(mutex);
+}
+
+int AsyncFileIO::NumPendingRequests() const {
+    PlatformMutex::Lock(mutex);
+    int count = pendingRequests.Count();
+    PlatformMutex::Unlock(mutex);
+    return count;
+}
+
+size_t AsyncFileIO::GetOutstandingBytes() const {
+    PlatformMutex::Lock(mutex);
+    size_t bytes = outstandingBytes;
+    PlatformMutex::Unlock(mutex);
+    return bytes;
+}
+
+// Called with the lock held. The lock is released while the files are located.
+void AsyncFileIO::ResolveRequests() {
+    AsyncIORequest *requests[MaxBatchRequests];
+    int numRequests = 0;
+
+    for (int i = 0; i < pendingRequests.Count() && numRequests < MaxBatchRequests; i++) {
+        AsyncIORequest *request = pendingRequests[i];
+        if (!request->resolved && !request->resolving) {
+            request->resolving = true;
+            requests[numRequests++] = request;
+        }
+    }
+
+    PlatformMutex::Unlock(mutex);
+
+    for (int i = 0; i < numRequests; i++) {
+        AsyncIORequest *request = requests[i];
+        FileLocation &location = request->location;
+
+        request->readStatus = AsyncIOStatus::Failed;
+
+        if (!fileSystem.LocateFile(request->filename, true, location) || request->offset > location.size) {
+            continue;
+        }
+
+        size_t availableSize = location.size - (size_t)request->offset;
+        request->size = request->size ? Min(request->size, availableSize) : availableSize;
+
+        if (location.archive) {
+            const byte *data = location.archive->GetEntryData(location.entryIndex);
+            if (!data) {
+                continue;
+            }
+            const ZipEntry &entry = location.archive->GetEntry(location.entryIndex);
+            if (entry.method == ZipEntry::Stored) {
+                request->physicalStart = (uint64_t)(uintptr_t)data + request->offset;
+                request->physicalEnd = request->physicalStart + request->size;
+            } else {
+                // Deflated data can't be addressed partially, the whole entry is read through
+                request->physicalStart = (uint64_t)(uintptr_t)data;
+                request->physicalEnd = request->physicalStart + entry.compressedSize;
+            }
+        } else {
+            request->physicalStart = request->offset;
+            request->physicalEnd = request->offset + request->size;
+        }
+
+        request->readStatus = AsyncIOStatus::Pending;
+    }
+
+    PlatformMutex::Lock(mutex);
+
+    bool finished = false;
+
+    for (int i = 0; i < numRequests; i++) {
+        AsyncIORequest *request = requests[i];
+        request->resolving = false;
+        request->resolved = true;
+
+        if (request->cancelRequested || request->readStatus == AsyncIOStatus::Failed) {
+            if (request->readStatus == AsyncIOStatus::Failed) {
+                BE_WARNLOG(L"AsyncFileIO: couldn't read '%hs'\n", request->filename.c_str());
+            }
+            pendingRequests.RemoveFast(request);
+            request->status = request->cancelRequested ? AsyncIOStatus::Cancelled : AsyncIOStatus::Failed;
+            finishedRequests.Append(request);
+            finished = true;
+        }
+    }
+
+    if (finished) {
+        PlatformCondition::Broadcast(finishCondition);
+    }
+}
+
+// Returns the resolved pending request with the highest priority, the oldest one first in the same priority.
+AsyncIORequest *AsyncFileIO::PickRequest() const {
+    AsyncIORequest *best = nullptr;
+
+    for (int i = 0; i < pendingRequests.Count(); i++) {
+        AsyncIORequest *request = pendingRequests[i];
+        if (!request->resolved || request->resolving) {
+            continue;
+        }
+        if (!best || request->priority > best->priority || (request->priority == best->priority && request->sequence < best->sequence)) {
+            best = request;
+        }
+    }
+    return best;
+}
+
+// Extends the batch with the pending requests that are adjacent to it in the same file or archive.
+// The batch is kept in the order of the file.
+void AsyncFileIO::BuildBatch(AsyncIORequest *head, Array<AsyncIORequest *> &batch) {
+    batch.Clear();
+    batch.Append(head);
+
+    size_t batchSize = head->size;
+
+    while (batch.Count() < MaxBatchRequests) {
+        AsyncIORequest *front = batch.First();
+        AsyncIORequest *tail = batch.Last();
+        AsyncIORequest *next = nullptr;
+        AsyncIORequest *prev = nullptr;
+
+        for (int i = 0; i < pendingRequests.Count(); i++) {
+            AsyncIORequest *request = pendingRequests[i];
+            if (!request->resolved || request->resolving || batch.Find(request)) {
+                continue;
+            }
+            // Prefer the closest ones
+            if (FollowsRequest(tail, request)) {
+                if (!next || request->physicalStart < next->physicalStart || (request->physicalStart == next->physicalStart && request->offset < next->offset)) {
+                    next = request;
+                }
+            } else if (FollowsRequest(request, front)) {
+                if (!prev || request->physicalEnd > prev->physicalEnd || (request->physicalEnd == prev->physicalEnd && request->offset > prev->offset)) {
+                    prev = request;
+                }
+            }
+        }
+
+        AsyncIORequest *request = next ? next : prev;
+        if (!request || batchSize + request->size > MaxBatchSize) {
+            break;
+        }
+        if (maxOutstandingBytes && outstandingBytes + batchSize + request->size > maxOutstandingBytes) {
+            break;
+        }
+
+        if (request == next) {
+            batch.Append(request);
+        } else {
+            batch.Insert(request, 0);
+        }
+        batchSize += request->size;
+    }
+}
+
+void AsyncFileIO::ProcessBatch(const Array<AsyncIORequest *> &batch) {
+    BE_PROFILE_SCOPE("AsyncFileIO::ProcessBatch");
+
+    File *file = nullptr;
+    const AsyncIORequest *fileRequest = nullptr;
+
+    for (int i = 0; i < batch.Count(); i++) {
+        AsyncIORequest *request = batch[i];
+
+        if (request->cancelRequested) {
+            request->readStatus = AsyncIOStatus::Cancelled;
+            continue;
+        }
+
+        // Keep reading through the open file if the request continues where the previous one ended
+        if (!file || !InSameFile(fileRequest, request) || (uint64_t)file->Tell() != request->offset) {
+            if (file) {
+                fileSystem.CloseFile(file);
+            }
+            if (request->location.archive) {
+                file = request->location.archive->OpenEntry(request->location.entryIndex, request->filename);
+            } else {
+                file = fileSystem.OpenFileRead(request->location.path, false);
+            }
+            if (file && request->offset > 0 && file->Seek(request->offset) != 0) {
+                fileSystem.CloseFile(file);
+                file = nullptr;
+            }
+            if (!file) {
+                request->readStatus = AsyncIOStatus::Failed;
+                continue;
+            }
+        }
+        fileRequest = request;
+
+        if (!request->buffer) {
+            MemTagScope memTagScope(MemTag::File);
+            request->buffer = Mem_Alloc(request->size + 1);
+            ((byte *)request->buffer)[request->size] = 0;
+            request->ownsBuffer = true;
+        }
+
+        request->readStatus = AsyncIOStatus::Completed;
+
+        size_t bytesRead = 0;
+        while (bytesRead < request->size) {
+            if (request->cancelRequested) {
+                request->readStatus = AsyncIOStatus::Cancelled;
+                break;
+            }
+            size_t bytesToRead = Min(request->size - bytesRead, (size_t)ReadChunkSize);
+            if (file->Read((byte *)request->buffer + bytesRead, bytesToRead) != bytesToRead) {
+                request->readStatus = AsyncIOStatus::Failed;
+                break;
+            }
+            bytesRead += bytesToRead;
+        }
+
+        if (request->readStatus != AsyncIOStatus::Completed) {
+            // Don't reuse the file at an unknown position
+            fileSystem.CloseFile(file);
+            file = nullptr;
+        }
+    }
+
+    if (file) {
+        fileSystem.CloseFile(file);
+    }
+}
+
+void AsyncFileIO::IOThreadProc(void *param) {
+    AsyncFileIO *io = (AsyncFileIO *)param;
+
+    profiler.SetThreadName("File IO");
+
+    Array<AsyncIORequest *> batch;
+
+    PlatformMutex::Lock(io->mutex);
+
+    while (!io->terminate) {
+        bool needsResolve = false;
+        for (int i = 0; i < io->pendingRequests.Count(); i++) {
+            if (!io->pendingRequests[i]->resolved && !io->pendingRequests[i]->resolving) {
+                needsResolve = true;
+                break;
+            }
+        }
+        if (needsResolve) {
+            io->ResolveRequests();
+            continue;
+        }
+
+        AsyncIORequest *head = io->PickRequest();
+        if (!head) {
+            PlatformCondition::Wait(io->requestCondition, io->mutex);
+            continue;
+        }
+
+        // Critical requests ignore the outstanding bytes limit, someone is blocked on them
+        if (io->maxOutstandingBytes && io->outstandingBytes > 0 && head->priority != AsyncIOPriority::Critical &&
+            io->outstandingBytes + head->size > io->maxOutstandingBytes) {
+            PlatformCondition::Wait(io->requestCondition, io->mutex);
+            continue;
+        }
+
+        io->BuildBatch(head, batch);
+
+        size_t batchSize = 0;
+        for (int i = 0; i < batch.Count(); i++) {
+            AsyncIORequest *request = batch[i];
+            io->pendingRequests.RemoveFast(request);
+            request->status = AsyncIOStatus::InFlight;
+            request->chargedBytes = request->size;
+            batchSize += request->size;
+        }
+        io->outstandingBytes += batchSize;
+
+        uint64_t waitTime = 0;
+        if (io->bandwidthLimit > 0) {
+            uint64_t now = PlatformTime::Microseconds();
+            uint64_t startTime = Max(now, io->throttleTime);
+            io->throttleTime = startTime + (uint64_t)batchSize * 1000000 / io->bandwidthLimit;
+            waitTime = startTime - now;
+        }
+
+        PlatformMutex::Unlock(io->mutex);
+
+        if (waitTime > 0) {
+            PlatformProcess::Sleep(waitTime / 1000000.0f);
+        }
+
+        io->ProcessBatch(batch);
+
+        PlatformMutex::Lock(io->mutex);
+
+        for (int i = 0; i < batch.Count(); i++) {
+            AsyncIORequest *request = batch[i];
+            if (request->readStatus == AsyncIOStatus::Failed) {
+                BE_WARNLOG(L"AsyncFileIO: couldn't read '%hs'\n", request->filename.c_str());
+            }
+            request->status = request->cancelRequested ? AsyncIOStatus::Cancelled : request->readStatus;
+            io->finishedRequests.Append(request);
+        }
+        PlatformCondition::Broadcast(io->finishCondition);
+    }
+
+    PlatformMutex::Unlock(io->mutex);
+}
+
+BE_NAMESPACE_END
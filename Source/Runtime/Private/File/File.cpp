@@ -17,7 +17,7 @@
 #include "Core/Guid.h"
 #include "Core/Object.h"
 #include "File/File.h"
-#include "minizip/unzip.h"
+#include "zlib.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -285,13 +285,45 @@ bool FileReal::Write(const void *buffer, size_t bytesToWrite) {
 // FileInZip
 //---------------------------------------------------------------
 
-FileInZip::FileInZip(const char *filename, void *pointer) {
+FileInZip::FileInZip(const char *filename, const byte *data, size_t compressedSize, size_t size, bool deflated, uint32_t expectedChecksum) {
     Str::Copynz(this->filename, filename, COUNT_OF(this->filename));
-    this->pointer = pointer;
+    this->data = data;
+    this->compressedSize = compressedSize;
+    this->size = size;
+    this->deflated = deflated;
+    this->offset = 0;
+    this->stream = nullptr;
+    this->expectedChecksum = expectedChecksum;
+    this->checksum = 0;
 }
 
 FileInZip::~FileInZip() {
-    unzCloseCurrentFile(pointer);
+    if (stream) {
+        inflateEnd((z_stream *)stream);
+        delete (z_stream *)stream;
+    }
+}
+
+bool FileInZip::ResetStream() const {
+    z_stream *zs = (z_stream *)stream;
+    if (!zs) {
+        zs = new z_stream;
+        memset(zs, 0, sizeof(*zs));
+        // Negative window bits for raw deflate data without zlib header
+        if (inflateInit2(zs, -MAX_WBITS) != Z_OK) {
+            delete zs;
+            return false;
+        }
+        stream = zs;
+    } else {
+        inflateReset(zs);
+    }
+
+    zs->next_in = (Bytef *)data;
+    zs->avail_in = 0;
+    offset = 0;
+    checksum = crc32(0, Z_NULL, 0);
+    return true;
 }
 
 size_t FileInZip::Size() const {
@@ -299,21 +331,96 @@ size_t FileInZip::Size() const {
 }
 
 int FileInZip::Tell() const {
-    return (int)unztell(pointer);
+    return (int)offset;
 }
 
 int FileInZip::Seek(int64_t offset) {
-    BE_FATALERROR(L"ZIP FILE FSEEK NOT YET IMPLEMENTED");
+    if (offset < 0 || offset > (int64_t)size) {
+        return -1;
+    }
+
+    if (!deflated) {
+        this->offset = (size_t)offset;
+        return 0;
+    }
+
+    // Deflate streams can only go forward, so seeking backward restarts from the beginning.
+    if (!stream || (size_t)offset < this->offset) {
+        if (!ResetStream()) {
+            return -1;
+        }
+    }
+
+    byte skipBuffer[4096];
+    while (this->offset < (size_t)offset) {
+        size_t bytesToSkip = Min((size_t)offset - this->offset, sizeof(skipBuffer));
+        if (Read(skipBuffer, bytesToSkip) != bytesToSkip) {
+            return -1;
+        }
+    }
     return 0;
 }
 
 int FileInZip::SeekFromEnd(int64_t offset) {
-    BE_FATALERROR(L"ZIP FILE FSEEK NOT YET IMPLEMENTED");
-    return 0;
+    return Seek((int64_t)size - offset);
 }
 
 size_t FileInZip::Read(void *buffer, size_t bytesToRead) const {
-    return unzReadCurrentFile(pointer, buffer, (unsigned int)bytesToRead);
+    if (offset >= size) {
+        return 0;
+    }
+    bytesToRead = Min(bytesToRead, size - offset);
+
+    if (!deflated) {
+        memcpy(buffer, data + offset, bytesToRead);
+        offset += bytesToRead;
+        return bytesToRead;
+    }
+
+    if (!stream && !ResetStream()) {
+        return 0;
+    }
+
+    // Inflate straight into the caller's buffer, feeding input from the mapping.
+    z_stream *zs = (z_stream *)stream;
+    zs->next_out = (Bytef *)buffer;
+    zs->avail_out = 0;
+
+    size_t bytesRead = 0;
+    while (bytesRead < bytesToRead) {
+        if (zs->avail_in == 0) {
+            size_t consumed = zs->next_in - data;
+            zs->avail_in = (uInt)Min(compressedSize - consumed, (size_t)0x40000000);
+        }
+        zs->avail_out = (uInt)Min(bytesToRead - bytesRead, (size_t)0x40000000);
+
+        uInt availOut = zs->avail_out;
+        int ret = inflate(zs, Z_NO_FLUSH);
+        bytesRead += availOut - zs->avail_out;
+
+        if (ret == Z_STREAM_END) {
+            break;
+        }
+        if (ret != Z_OK) {
+            BE_WARNLOG(L"FileInZip::Read: inflate error %i in '%hs'\n", ret, filename);
+            break;
+        }
+    }
+
+    // Inflated data is always read in order from the start, seeking reads the skipped data too
+    for (size_t checked = 0; checked < bytesRead; ) {
+        uInt length = (uInt)Min(bytesRead - checked, (size_t)0x40000000);
+        checksum = crc32(checksum, (const Bytef *)buffer + checked, length);
+        checked += length;
+    }
+
+    offset += bytesRead;
+
+    if (offset == size && checksum != expectedChecksum) {
+        BE_WARNLOG(L"FileInZip::Read: CRC mismatch in '%hs'\n", filename);
+        return 0;
+    }
+    return bytesRead;
 }
 
 bool FileInZip::Write(const void *buffer, size_t len) {
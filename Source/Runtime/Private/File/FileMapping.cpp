@@ -73,7 +73,7 @@ bool FileMapping::Open(const TCHAR *filename) {
     }
     off_t nDelta = nStart & g_nPageMask;
     void *map = mmap(NULL, size + nDelta, PROT_READ, MAP_FILE | MAP_SHARED, hFile, nStart - nDelta);
-    if (map == NULL) {
+    if (map == MAP_FAILED) {
         BE_ERRLOG(L"_FileMapping::Open: Could not map %ls to memory\n", towcs(filename));
         assert(0);
         close(hFile);
@@ -92,11 +92,16 @@ bool FileMapping::Open(const TCHAR *filename) {
     fstat(fd, &fs);
     size = fs.st_size;
 
-    data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
-    if (data == NULL) {
+    void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
         BE_ERRLOG(L"_FileMapping::Open: Could not map %ls to memory\n", towcs(filename));
+        close(fd);
+        size = 0;
         return false;
     }
+    data = map;
+    // Keep the descriptor so that Close() can release it
+    hFile = fd;
 
     // close fd is error 
     //if (close(fd) != 0) {
@@ -160,11 +165,14 @@ void FileMapping::Close() {
         BE_ERRLOG(L"_FileMapping::Close: unable to unmap memory\n");
     }
     close(hFile);
+    hFile = -1;
 #elif defined(__WIN32__)
     UnmapViewOfFile(data);
     CloseHandle(hMapping);
     CloseHandle(hFile);
 #endif
+    data = NULL;
+    size = 0;
 }
 
 BE_NAMESPACE_END
@@ -19,8 +19,7 @@
 #include "Platform/PlatformSystem.h"
 #include "Platform/PlatformProcess.h"
 #include "File/FileSystem.h"
-#include "minizip/zip.h"
-#include "minizip/unzip.h"
+#include "File/ZipArchive.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -31,28 +30,6 @@ static CVar                 fs_debug(L"fs_debug", L"0", CVar::Bool, L"");
 
 FileSystem                  fileSystem;
 
-//--------------------------------------------------------------------------------------------------
-//
-// ZIP archive
-//
-//--------------------------------------------------------------------------------------------------
-
-struct ZipEntry {
-    char                    name[MaxRelativePath];
-    size_t                  compressedSize;
-    size_t                  uncompressedSize;
-    uLong                   unzOffset;
-};
-
-struct ZipArchive {
-    char                    name[MaxRelativePath];
-    char                    fullPath[MaxAbsolutePath];
-    unzFile                 unzArchive;
-    int                     numEntries;
-    Array<ZipEntry *>       entryList;
-    HashIndex               entryHash;
-};
-
 //--------------------------------------------------------------------------------------------------
 //
 // FileSystem
@@ -66,9 +43,6 @@ void FileSystem::ClearSearchPath() {
         next = s->next;
         
         if (s->archive) {
-            s->archive->entryList.DeleteContents(true);
-            s->archive->entryHash.Free();
-            unzClose(s->archive->unzArchive);
             delete s->archive;
         } else if (s->pathname) {
             delete[] s->pathname;
@@ -123,139 +97,24 @@ void FileSystem::AddSearchPath(const char *path) {
     }
 }
 
-#if defined(__ANDROID__) 
-
-static voidpf ZCALLBACK _fopen_file_func(voidpf opaque, const char* filename, int mode) {
-    PlatformFile *file = nullptr;
-    PlatformFile *(*mode_fopen)(const char *filename) = nullptr;
-    if ((mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER) == ZLIB_FILEFUNC_MODE_READ) {
-        mode_fopen = PlatformFile::OpenFileRead;
-    } else {
-        if (mode & ZLIB_FILEFUNC_MODE_EXISTING) {
-            mode_fopen = PlatformFile::OpenFileAppend;
-        } else {
-            if (mode & ZLIB_FILEFUNC_MODE_CREATE) {
-                mode_fopen = PlatformFile::OpenFileWrite;
-            }
-        }
-    }
-
-    if ((filename != nullptr) && (mode_fopen != nullptr)) {
-        file = (*mode_fopen)(filename);
-    }
-    return (FILE *) file;
-}
-
-static uLong ZCALLBACK _fread_file_func(voidpf opaque, voidpf stream, void* buf, uLong size) {
-    if (((PlatformFile *)stream)->Read(buf, size)) {
-        return size;
-    }
-    return -1;
-}
-
-static uLong ZCALLBACK _fwrite_file_func(voidpf opaque, voidpf stream, const void* buf, uLong size) {
-    if (((PlatformFile *)stream)->Write(buf, size)) {
-        return size;
-    }
-    return -1;
-}
-
-static long ZCALLBACK _ftell_file_func(voidpf opaque, voidpf stream) {
-    return ((PlatformFile *)stream)->Tell();
-}
-
-static long ZCALLBACK _fseek_file_func(voidpf  opaque, voidpf stream, uLong offset, int origin) {
-    enum PlatformFile::Origin fseek_origin;
-    switch (origin) {
-    case ZLIB_FILEFUNC_SEEK_CUR:
-        fseek_origin = PlatformFile::Current;
-        break;
-    case ZLIB_FILEFUNC_SEEK_END:
-        fseek_origin = PlatformFile::End;
-        break;
-    case ZLIB_FILEFUNC_SEEK_SET:
-        fseek_origin = PlatformFile::Start;
-        break;
-    default:
-        return -1;
-    }
-    return ((PlatformFile *)stream)->Seek(offset, fseek_origin);
-}
-
-static int ZCALLBACK _fclose_file_func(voidpf opaque, voidpf stream) {
-    delete ((PlatformFile *)stream);
-    return 0;
-}
-
-static int ZCALLBACK _ferror_file_func(voidpf opaque, voidpf stream) {
-    return 0;
-}
-
-static void _fill_fopen_filefunc(zlib_filefunc_def* pzlib_filefunc_def) {
-    pzlib_filefunc_def->zopen_file = _fopen_file_func;
-    pzlib_filefunc_def->zread_file = _fread_file_func;
-    pzlib_filefunc_def->zwrite_file = _fwrite_file_func;
-    pzlib_filefunc_def->ztell_file = _ftell_file_func;
-    pzlib_filefunc_def->zseek_file = _fseek_file_func;
-    pzlib_filefunc_def->zclose_file = _fclose_file_func;
-    pzlib_filefunc_def->zerror_file = _ferror_file_func;
-    pzlib_filefunc_def->opaque = nullptr;
-}
-
-#endif
-
 void FileSystem::AddSearchPath_ZIP(const char *path, const char *filename) {
     char fullpath[MaxAbsolutePath];
     fileSystem.MakeFullPath(fullpath, sizeof(fullpath), path, "", filename);
-    
-    unz_global_info z_global_info;
+
+    ZipArchive *archive = new ZipArchive;
 #if defined(__ANDROID__) 
-    zlib_filefunc_def zlib_filefunc32_def;
-    _fill_fopen_filefunc(&zlib_filefunc32_def);
-    unzFile z_file = unzOpen2(ToRelativePath(fullpath), &zlib_filefunc32_def);
+    // Android assets are opened with the path relative to the base directory
+    bool opened = archive->Open(ToRelativePath(fullpath));
 #else
-    unzFile z_file = unzOpen(fullpath);
+    bool opened = archive->Open(fullpath);
 #endif
-    if (unzGetGlobalInfo(z_file, &z_global_info) != UNZ_OK) {
+    if (!opened) {
+        delete archive;
         return;
     }
 
-    ZipArchive *archive = new ZipArchive;
-        
-    strcpy(archive->fullPath, fullpath);
-    strcpy(archive->name, filename);
-
-    archive->unzArchive = z_file;
-    archive->numEntries = (int)z_global_info.number_entry;
-    
-    archive->entryList.Resize((int)z_global_info.number_entry);
-    
-    // Set the current file of the zipfile to the first file.
-    unzGoToFirstFile(z_file);
-    
-    for (int i = 0; i < z_global_info.number_entry; i++) {
-        unz_file_info z_entry_info;
-        char entryFilename[MaxRelativePath];
-
-        if (unzGetCurrentFileInfo(z_file, &z_entry_info, entryFilename, COUNT_OF(entryFilename), nullptr, 0, nullptr, 0) != UNZ_OK) {
-            break;
-        }
-
-        Str::ConvertPathSeperator(entryFilename, PATHSEPERATOR_CHAR);
-
-        ZipEntry *entry = new ZipEntry;
-        strcpy(entry->name, entryFilename);
-        entry->unzOffset = unzGetOffset(z_file);
-        entry->compressedSize = z_entry_info.compressed_size;
-        entry->uncompressedSize = z_entry_info.uncompressed_size;
-
-        archive->entryList.Append(entry);
-        archive->entryHash.Add(archive->entryHash.GenerateHash(entryFilename, false), i);
-    
-        unzGoToNextFile(z_file);
-    }
-
     SearchPath *search = new SearchPath;
+    search->pathname = nullptr;
     search->archive = archive;
     search->next = searchPath;
     searchPath = search;
@@ -270,7 +129,7 @@ void FileSystem::Init(const char *baseDir) {
     BE_LOG(L"Current search path:\n");
     for (SearchPath *s = searchPath; s; s = s->next) {
         if (s->archive) {
-            BE_LOG(L"%hs (%i files)\n", s->archive->fullPath, s->archive->numEntries);
+            BE_LOG(L"%hs (%i files)\n", s->archive->GetName(), s->archive->NumEntries());
         } else {
             BE_LOG(L"%hs\n", s->pathname);
         }
@@ -572,32 +431,18 @@ File *FileSystem::OpenFileRead(const char *filename, bool useSearchPath, size_t
     
     for (SearchPath *s = searchPath; s; s = s->next) {
         if (s->archive) {
-            ZipArchive *archive = s->archive;
-            ZipEntry *entry;
-
-            Str entryFilename = filename;
-            Str::ConvertPathSeperator(entryFilename, PATHSEPERATOR_CHAR);
-
-            int hash = archive->entryHash.GenerateHash(entryFilename, false);
-            int	i;
-            for (i = archive->entryHash.First(hash); i != -1; i = archive->entryHash.Next(i)) {
-                if (!Str::Icmp(archive->entryList[i]->name, entryFilename)) {
-                    entry = archive->entryList[i];
-                    break;
-                }
-            }
-                        
-            if (i != -1) {
+            const ZipArchive *archive = s->archive;
+
+            int entryIndex = archive->FindEntry(filename);
+            if (entryIndex != -1) {
                 if (fs_debug.GetBool()) {
-                    BE_LOG(L"FileSystem::OpenFileRead: %hs (found in '%hs')\n", filename, archive->name);
+                    BE_LOG(L"FileSystem::OpenFileRead: %hs (found in '%hs')\n", filename, archive->GetName());
                 }
 
-                unzSetOffset(archive->unzArchive, entry->unzOffset);
-                unzOpenCurrentFile(archive->unzArchive);
-                FileInZip *file = new FileInZip(filename, (void *)archive->unzArchive);
-
-                if (fileSize) {
-                    file->size = *fileSize = entry->uncompressedSize;
+                // Every entry is read through its own file object so this is safe from any thread.
+                File *file = archive->OpenEntry(entryIndex, filename);
+                if (file && fileSize) {
+                    *fileSize = file->Size();
                 }
 
                 resultFile = file;
@@ -629,6 +474,47 @@ File *FileSystem::OpenFileRead(const char *filename, bool useSearchPath, size_t
     return resultFile;
 }
 
+bool FileSystem::LocateFile(const char *filename, bool useSearchPath, FileLocation &location) const {
+    location.archive = nullptr;
+    location.entryIndex = -1;
+    location.size = 0;
+
+    if (PlatformFile::FileExists(filename)) {
+        location.path = filename;
+        location.size = PlatformFile::FileSize(filename);
+        return true;
+    }
+
+    if (!useSearchPath) {
+        return false;
+    }
+
+    for (SearchPath *s = searchPath; s; s = s->next) {
+        if (s->archive) {
+            int entryIndex = s->archive->FindEntry(filename);
+            if (entryIndex != -1) {
+                location.archive = s->archive;
+                location.entryIndex = entryIndex;
+                location.path = filename;
+                location.size = (size_t)s->archive->GetEntry(entryIndex).uncompressedSize;
+                return true;
+            }
+        } else {
+            Str relativePath = Str(s->pathname).ToRelativePath(Str(fs_baseDir.GetString()));
+            relativePath.AppendPath(filename);
+            relativePath.CleanPath();
+
+            if (PlatformFile::FileExists(relativePath)) {
+                location.path = relativePath;
+                location.size = PlatformFile::FileSize(relativePath);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 File *FileSystem::OpenFileWrite(const char *filename) {
     if (fs_debug.GetBool()) {
         BE_LOG(L"FileSystem::OpenFileWrite: %hs\n", filename);
@@ -745,6 +631,8 @@ bool FileSystem::RemoveDirectory(const char *dirname, bool tree) const {
 //-------------------------------------------------------------------------------
 
 size_t FileSystem::LoadFile(const char *path, bool searchDirs, void **buffer) {
+    MemTagScope memTagScope(MemTag::File);
+
     if (!path || !path[0]) {
         BE_ERRLOG(L"FileSystem::LoadFile: empty filename\n");
         if (buffer) {
@@ -786,6 +674,38 @@ void FileSystem::FreeFile(void *buffer) const {
     Mem_Free(buffer);
 }
 
+size_t FileSystem::MapFile(const char *path, bool searchDirs, const void **data) {
+    FileLocation location;
+    if (path && path[0] && LocateFile(path, searchDirs, location) && location.archive) {
+        // Stored entries are returned in place without copying.
+        const ZipEntry &entry = location.archive->GetEntry(location.entryIndex);
+        if (entry.method == ZipEntry::Stored) {
+            const byte *entryData = location.archive->GetEntryData(location.entryIndex);
+            if (entryData) {
+                *data = entryData;
+                return location.size;
+            }
+        }
+    }
+
+    return LoadFile(path, searchDirs, (void **)data);
+}
+
+void FileSystem::UnmapFile(const void *data) const {
+    if (!data) {
+        BE_FATALERROR(L"FileSystem::UnmapFile: nullptr pointer");
+        return;
+    }
+
+    for (SearchPath *s = searchPath; s; s = s->next) {
+        if (s->archive && s->archive->IsMappedData(data)) {
+            return;
+        }
+    }
+
+    Mem_Free((void *)data);
+}
+
 void FileSystem::WriteFile(const char *filename, const void *buffer, int size) {
     if (!filename || !buffer) {
         BE_FATALERROR(L"FileSystem::WriteFile: nullptr parameter");
@@ -873,11 +793,11 @@ int FileSystem::ListFiles(const char *findPath, const char *nameFilter, FileArra
 
         for (SearchPath *s = searchPath; s; s = s->next) {
             if (s->archive) {
-                ZipArchive *archive = s->archive;
-                int numEntries = archive->numEntries;
+                const ZipArchive *archive = s->archive;
+                int numEntries = archive->NumEntries();
             
                 for (int i = 0; i < numEntries; i++) {
-                    ZipEntry *entry = archive->entryList[i];
+                    const ZipEntry *entry = &archive->GetEntry(i);
 
                     // check directory
                     if (Str::Icmpn(entry->name, findPath, findPathLen)) {
@@ -885,11 +805,11 @@ int FileSystem::ListFiles(const char *findPath, const char *nameFilter, FileArra
                     }
                 
                     // check extension
-                    if (Str::Filter(nameFilter, entry->name + findPathLen + 1)) {
+                    if (Str::Filter(nameFilter, entry->name.c_str() + findPathLen + 1)) {
                         continue;
                     }
 
-                    char *name = entry->name + findPathLen + 1;
+                    const char *name = entry->name.c_str() + findPathLen + 1;
 
                     fileInfo.isSubDir = false;
                     //fileInfo.size = entry->size;
@@ -966,7 +886,7 @@ void FileSystem::Cmd_Path(const CmdArgs &args) {
     BE_LOG(L"Current search path:\n");
     for (s = fileSystem.searchPath; s; s = s->next) {
         if (s->archive) {
-            BE_LOG(L"%hs (%i files)\n", s->archive->fullPath, s->archive->numEntries);
+            BE_LOG(L"%hs (%i files)\n", s->archive->GetName(), s->archive->NumEntries());
         } else {
             BE_LOG(L"%hs\n", s->pathname);
         }
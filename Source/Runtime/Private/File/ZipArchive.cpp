@@ -0,0 +1,262 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "Precompiled.h"
+#include "Core/ByteOrder.h"
+#include "File/File.h"
+#include "File/ZipArchive.h"
+
+BE_NAMESPACE_BEGIN
+
+#define ZIP_LOCAL_HEADER_SIGNATURE          0x04034b50
+#define ZIP_CENTRAL_HEADER_SIGNATURE        0x02014b50
+#define ZIP_END_OF_CENTRAL_DIR_SIGNATURE    0x06054b50
+#define ZIP64_END_OF_CENTRAL_DIR_SIGNATURE  0x06064b50
+#define ZIP64_END_OF_CENTRAL_DIR_LOCATOR    0x07064b50
+#define ZIP64_EXTRA_FIELD_ID                0x0001
+
+#define ZIP_LOCAL_HEADER_SIZE               30
+#define ZIP_CENTRAL_HEADER_SIZE             46
+#define ZIP_END_OF_CENTRAL_DIR_SIZE         22
+#define ZIP64_END_OF_CENTRAL_DIR_SIZE       56
+#define ZIP64_END_OF_CENTRAL_DIR_LOCATOR_SIZE 20
+
+#define ZIP_FLAG_ENCRYPTED                  0x0001
+
+#define ZIP_ENTRY_HASH_SIZE                 1024
+
+template <typename T>
+static BE_INLINE T ReadLE(const byte *ptr) {
+    T value;
+    memcpy(&value, ptr, sizeof(value));
+    ByteOrder::LittleEndianToSystem(value);
+    return value;
+}
+
+bool ZipArchive::Open(const char *filename) {
+    Close();
+
+    if (!mapping.Open(Str(filename))) {
+        return false;
+    }
+
+    name = filename;
+
+    if (!ReadCentralDirectory()) {
+        BE_WARNLOG(L"ZipArchive::Open: invalid zip file '%hs'\n", filename);
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void ZipArchive::Close() {
+    mapping.Close();
+    entries.Clear();
+    entryHash.Free();
+    name.Clear();
+}
+
+bool ZipArchive::ReadCentralDirectory() {
+    const byte *base = (const byte *)mapping.GetData();
+    const uint64_t size = mapping.GetSize();
+
+    if (!base || size < ZIP_END_OF_CENTRAL_DIR_SIZE) {
+        return false;
+    }
+
+    // The end of central directory record is followed by a comment of at most 65535 bytes.
+    const uint64_t searchEnd = size > ZIP_END_OF_CENTRAL_DIR_SIZE + 0xFFFF ? size - ZIP_END_OF_CENTRAL_DIR_SIZE - 0xFFFF : 0;
+    int64_t eocdOffset = -1;
+    for (int64_t offset = size - ZIP_END_OF_CENTRAL_DIR_SIZE; offset >= (int64_t)searchEnd; offset--) {
+        if (ReadLE<uint32_t>(base + offset) == ZIP_END_OF_CENTRAL_DIR_SIGNATURE) {
+            eocdOffset = offset;
+            break;
+        }
+    }
+    if (eocdOffset < 0) {
+        return false;
+    }
+
+    const byte *eocd = base + eocdOffset;
+    uint64_t numEntries = ReadLE<uint16_t>(eocd + 10);
+    uint64_t centralDirSize = ReadLE<uint32_t>(eocd + 12);
+    uint64_t centralDirOffset = ReadLE<uint32_t>(eocd + 16);
+
+    // Zip64 archives keep the real values in the zip64 end of central directory record.
+    if (eocdOffset >= ZIP64_END_OF_CENTRAL_DIR_LOCATOR_SIZE) {
+        const byte *locator = eocd - ZIP64_END_OF_CENTRAL_DIR_LOCATOR_SIZE;
+        if (ReadLE<uint32_t>(locator) == ZIP64_END_OF_CENTRAL_DIR_LOCATOR) {
+            uint64_t zip64EocdOffset = ReadLE<uint64_t>(locator + 8);
+            if (zip64EocdOffset + ZIP64_END_OF_CENTRAL_DIR_SIZE > size) {
+                return false;
+            }
+            const byte *zip64Eocd = base + zip64EocdOffset;
+            if (ReadLE<uint32_t>(zip64Eocd) != ZIP64_END_OF_CENTRAL_DIR_SIGNATURE) {
+                return false;
+            }
+            numEntries = ReadLE<uint64_t>(zip64Eocd + 32);
+            centralDirSize = ReadLE<uint64_t>(zip64Eocd + 40);
+            centralDirOffset = ReadLE<uint64_t>(zip64Eocd + 48);
+        }
+    }
+
+    if (centralDirOffset > size || centralDirSize > size - centralDirOffset) {
+        return false;
+    }
+
+    // Every entry has a central header at least, so more entries than that is corrupted
+    if (numEntries > centralDirSize / ZIP_CENTRAL_HEADER_SIZE) {
+        return false;
+    }
+
+    int hashSize = ZIP_ENTRY_HASH_SIZE;
+    while (hashSize < (int64_t)numEntries) {
+        hashSize <<= 1;
+    }
+
+    entries.Clear();
+    entries.Resize((int)numEntries);
+    entryHash.Clear(hashSize, (int)numEntries);
+
+    const byte *ptr = base + centralDirOffset;
+    const byte *end = ptr + centralDirSize;
+
+    for (uint64_t i = 0; i < numEntries; i++) {
+        if (ptr + ZIP_CENTRAL_HEADER_SIZE > end || ReadLE<uint32_t>(ptr) != ZIP_CENTRAL_HEADER_SIGNATURE) {
+            return false;
+        }
+
+        uint16_t flags = ReadLE<uint16_t>(ptr + 8);
+        uint16_t method = ReadLE<uint16_t>(ptr + 10);
+        uint32_t crc32 = ReadLE<uint32_t>(ptr + 16);
+        uint64_t compressedSize = ReadLE<uint32_t>(ptr + 20);
+        uint64_t uncompressedSize = ReadLE<uint32_t>(ptr + 24);
+        uint16_t nameLength = ReadLE<uint16_t>(ptr + 28);
+        uint16_t extraLength = ReadLE<uint16_t>(ptr + 30);
+        uint16_t commentLength = ReadLE<uint16_t>(ptr + 32);
+        uint64_t localHeaderOffset = ReadLE<uint32_t>(ptr + 42);
+
+        const byte *namePtr = ptr + ZIP_CENTRAL_HEADER_SIZE;
+        const byte *extraPtr = namePtr + nameLength;
+        const byte *next = extraPtr + extraLength + commentLength;
+        if (next > end) {
+            return false;
+        }
+
+        // Values saturated to 0xFFFFFFFF are stored in the zip64 extended information field, in this order.
+        for (const byte *extra = extraPtr; extra + 4 <= extraPtr + extraLength; ) {
+            uint16_t id = ReadLE<uint16_t>(extra);
+            uint16_t length = ReadLE<uint16_t>(extra + 2);
+            const byte *data = extra + 4;
+            const byte *dataEnd = data + length;
+            if (dataEnd > extraPtr + extraLength) {
+                break;
+            }
+            if (id == ZIP64_EXTRA_FIELD_ID) {
+                if (uncompressedSize == 0xFFFFFFFF && data + 8 <= dataEnd) {
+                    uncompressedSize = ReadLE<uint64_t>(data);
+                    data += 8;
+                }
+                if (compressedSize == 0xFFFFFFFF && data + 8 <= dataEnd) {
+                    compressedSize = ReadLE<uint64_t>(data);
+                    data += 8;
+                }
+                if (localHeaderOffset == 0xFFFFFFFF && data + 8 <= dataEnd) {
+                    localHeaderOffset = ReadLE<uint64_t>(data);
+                }
+                break;
+            }
+            extra = dataEnd;
+        }
+
+        ptr = next;
+
+        // Skip directories, encrypted entries and unsupported compression methods.
+        if (nameLength == 0 || namePtr[nameLength - 1] == '/' || namePtr[nameLength - 1] == '\\') {
+            continue;
+        }
+        if (flags & ZIP_FLAG_ENCRYPTED) {
+            continue;
+        }
+        if (method != ZipEntry::Stored && method != ZipEntry::Deflated) {
+            BE_WARNLOG(L"ZipArchive::ReadCentralDirectory: unsupported compression method %i in '%hs'\n", (int)method, name.c_str());
+            continue;
+        }
+        if (localHeaderOffset + ZIP_LOCAL_HEADER_SIZE > size) {
+            continue;
+        }
+
+        ZipEntry &entry = entries.Alloc();
+        entry.name.Append((const char *)namePtr, nameLength);
+        Str::ConvertPathSeperator(entry.name, PATHSEPERATOR_CHAR);
+        entry.localHeaderOffset = localHeaderOffset;
+        entry.compressedSize = compressedSize;
+        entry.uncompressedSize = uncompressedSize;
+        entry.crc32 = crc32;
+        entry.method = method;
+
+        entryHash.Add(entryHash.GenerateHash(entry.name, false), entries.Count() - 1);
+    }
+
+    return true;
+}
+
+int ZipArchive::FindEntry(const char *entryName) const {
+    Str entryFilename = entryName;
+    Str::ConvertPathSeperator(entryFilename, PATHSEPERATOR_CHAR);
+
+    int hash = entryHash.GenerateHash(entryFilename, false);
+    for (int i = entryHash.First(hash); i != -1; i = entryHash.Next(i)) {
+        if (!Str::Icmp(entries[i].name, entryFilename)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+const byte *ZipArchive::GetEntryData(int index) const {
+    const ZipEntry &entry = entries[index];
+    const byte *base = (const byte *)mapping.GetData();
+    const uint64_t size = mapping.GetSize();
+
+    // The local header has its own name and extra field lengths which may differ from the central directory.
+    const byte *localHeader = base + entry.localHeaderOffset;
+    if (ReadLE<uint32_t>(localHeader) != ZIP_LOCAL_HEADER_SIGNATURE) {
+        return nullptr;
+    }
+
+    uint64_t dataOffset = entry.localHeaderOffset + ZIP_LOCAL_HEADER_SIZE + ReadLE<uint16_t>(localHeader + 26) + ReadLE<uint16_t>(localHeader + 28);
+    if (dataOffset > size || entry.compressedSize > size - dataOffset) {
+        return nullptr;
+    }
+
+    return base + dataOffset;
+}
+
+File *ZipArchive::OpenEntry(int index, const char *filename) const {
+    const byte *data = GetEntryData(index);
+    if (!data) {
+        BE_WARNLOG(L"ZipArchive::OpenEntry: corrupted entry '%hs' in '%hs'\n", entries[index].name.c_str(), name.c_str());
+        return nullptr;
+    }
+
+    const ZipEntry &entry = entries[index];
+    return new FileInZip(filename, data, (size_t)entry.compressedSize, (size_t)entry.uncompressedSize, entry.method == ZipEntry::Deflated, entry.crc32);
+}
+
+BE_NAMESPACE_END
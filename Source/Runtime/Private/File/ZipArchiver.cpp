@@ -27,7 +27,7 @@ static int ToZCompressLevel(ZipArchiver::CompressionLevel compressionLevel) {
 
     switch (compressionLevel) {
     case ZipArchiver::NoCompression:
-        ret = Z_DEFAULT_COMPRESSION;
+        ret = Z_NO_COMPRESSION;
         break;
     case ZipArchiver::BestCompression:
         ret = Z_BEST_COMPRESSION;
@@ -19,6 +19,7 @@
 #include "Components/ComScript.h"
 #include "Game/Entity.h"
 #include "Game/GameWorld.h"
+#include "Core/BinarySerializer.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -425,6 +426,71 @@ void Entity::SerializeHierarchy(const Entity *entity, Json::Value &entitiesValue
     }
 }
 
+void Entity::SerializeBinary(BinarySerializer &out) const {
+    Serializable::SerializeBinary(out);
+
+    out.BeginObjectProperty("components", true);
+
+    for (int componentIndex = 0; componentIndex < components.Count(); componentIndex++) {
+        Component *component = components[componentIndex];
+
+        if (component) {
+            out.BeginObject();
+            component->SerializeBinary(out);
+            out.EndObject();
+        }
+    }
+
+    out.EndObjectProperty();
+}
+
+void Entity::DeserializeBinary(const BinaryObject &in) {
+    Serializable::DeserializeBinary(in);
+
+    BinaryProperty componentsProp = in.FindProperty("components");
+    if (!componentsProp.IsValid() || !componentsProp.IsObject()) {
+        return;
+    }
+
+    for (int i = 0; i < componentsProp.Count(); i++) {
+        const BinaryObject componentObject = componentsProp.GetObject(i);
+
+        const char *classname = componentObject.ClassName();
+        MetaObject *metaComponent = Object::FindMetaObject(classname);
+
+        if (metaComponent) {
+            if (metaComponent->IsTypeOf(Component::metaObject)) {
+                Variant guidValue;
+                BinaryProperty guidProp = componentObject.FindProperty("guid");
+                Guid componentGuid = guidProp.IsValid() && guidProp.GetValue(Variant::GuidType, guidValue) ? guidValue.As<Guid>() : Guid::zero;
+                if (componentGuid.IsZero()) {
+                    componentGuid = Guid::CreateGuid();
+                }
+
+                Component *component = static_cast<Component *>(metaComponent->CreateInstance(componentGuid));
+                component->SetEntity(this);
+                component->DeserializeBinary(componentObject);
+
+                AddComponent(component);
+            } else {
+                BE_WARNLOG(L"'%hs' is not a component class\n", classname);
+            }
+        } else {
+            BE_WARNLOG(L"Unknown component class '%hs'\n", classname);
+        }
+    }
+}
+
+void Entity::SerializeHierarchyBinary(const Entity *entity, BinarySerializer &out) {
+    out.BeginObject(true);
+    entity->SerializeBinary(out);
+    out.EndObject();
+
+    for (Entity *child = entity->GetNode().GetChild(); child; child = child->GetNode().GetNextSibling()) {
+        Entity::SerializeHierarchyBinary(child, out);
+    }
+}
+
 void Entity::SetActive(bool active) {
     if (active == activeSelf) {
         return;
@@ -564,6 +630,12 @@ bool Entity::RayIntersection(const Vec3 &start, const Vec3 &dir, bool backFaceCu
     return false;
 }
 
+void Entity::InvalidateQueryBounds() {
+    if (gameWorld) {
+        gameWorld->InvalidateEntityQueryBounds(this);
+    }
+}
+
 void Entity::DestroyInstance(Entity *entity) {
     EntityPtrArray children;
     entity->GetChildren(children);
@@ -626,6 +698,8 @@ void Entity::SetParentGuid(const Guid &parentGuid) {
     }
 
     if (initialized) {
+        GetTransform()->ParentChanged();
+
         EmitSignal(&SIG_ParentChanged, this, parentEntity);
     }
 }
@@ -670,6 +744,56 @@ Entity *Entity::CreateEntity(Json::Value &entityValue, GameWorld *gameWorld, int
     return entity;
 }
 
+Entity *Entity::CreateEntity(const BinaryObject &object, GameWorld *gameWorld, int sceneIndex) {
+    Variant guidValue;
+    BinaryProperty guidProp = object.FindProperty("guid");
+    Guid entityGuid = guidProp.IsValid() && guidProp.GetValue(Variant::GuidType, guidValue) ? guidValue.As<Guid>() : Guid::zero;
+    if (entityGuid.IsZero()) {
+        entityGuid = Guid::CreateGuid();
+    }
+
+    Entity *entity = static_cast<Entity *>(Entity::metaObject.CreateInstance(entityGuid));
+
+    entity->gameWorld = gameWorld;
+    entity->sceneIndex = sceneIndex;
+    entity->DeserializeBinary(object);
+
+    return entity;
+}
+
+Entity *Entity::CreateEntity(const Entity *sourceEntity, const HashTable<Guid, Guid> &remapGuidMap, GameWorld *gameWorld, int sceneIndex) {
+    Guid entityGuid;
+    if (!remapGuidMap.Get(sourceEntity->GetGuid(), &entityGuid) || entityGuid.IsZero()) {
+        entityGuid = Guid::CreateGuid();
+    }
+
+    Entity *entity = static_cast<Entity *>(Entity::metaObject.CreateInstance(entityGuid));
+
+    entity->gameWorld = gameWorld;
+    entity->sceneIndex = sceneIndex;
+    entity->CopyProperties(*sourceEntity, &remapGuidMap);
+
+    for (int componentIndex = 0; componentIndex < sourceEntity->components.Count(); componentIndex++) {
+        const Component *sourceComponent = sourceEntity->components[componentIndex];
+        if (!sourceComponent) {
+            continue;
+        }
+
+        Guid componentGuid;
+        if (!remapGuidMap.Get(sourceComponent->GetGuid(), &componentGuid) || componentGuid.IsZero()) {
+            componentGuid = Guid::CreateGuid();
+        }
+
+        Component *component = static_cast<Component *>(sourceComponent->GetMetaObject()->CreateInstance(componentGuid));
+        component->SetEntity(entity);
+        component->CopyProperties(*sourceComponent, &remapGuidMap);
+
+        entity->AddComponent(component);
+    }
+
+    return entity;
+}
+
 Json::Value Entity::CloneEntityValue(const Json::Value &entityValue, HashTable<Guid, Guid> &oldToNewGuidMap) {
     // Copy entity JSON value
     Json::Value newEntityValue = entityValue;
@@ -709,18 +833,16 @@ Json::Value Entity::CloneEntitiesValue(const Json::Value &entitiesValue, HashTab
 }
 
 void Entity::RemapGuids(Entity *entity, const HashTable<Guid, Guid> &remapGuidMap) {
-    PropertyInfo propInfo;
     Guid toGuid;
 
-    Array<PropertyInfo> propertyInfoList;
-    entity->GetPropertyInfoList(propertyInfoList);
+    const PropertyInfoTable &propertyInfoTable = entity->GetPropertyInfoTable();
 
-    for (int propIndex = 0; propIndex < propertyInfoList.Count(); propIndex++) {
-        const auto &propInfo = propertyInfoList[propIndex];
+    for (int propIndex = 0; propIndex < propertyInfoTable.Count(); propIndex++) {
+        const auto &propInfo = propertyInfoTable[propIndex];
             
         if (propInfo.GetType() == Variant::GuidType) {
             if (propInfo.GetFlags() & PropertyInfo::ArrayFlag) {
-                for (int arrayIndex = 0; arrayIndex < entity->GetPropertyArrayCount(propInfo.GetName()); arrayIndex++) {
+                for (int arrayIndex = 0; arrayIndex < entity->GetPropertyArrayCount(propInfo); arrayIndex++) {
                     const Guid fromGuid = entity->GetArrayProperty(propIndex, arrayIndex).As<Guid>();
 
                     if (remapGuidMap.Get(fromGuid, &toGuid)) {
@@ -740,15 +862,14 @@ void Entity::RemapGuids(Entity *entity, const HashTable<Guid, Guid> &remapGuidMa
     for (int componentIndex = 0; componentIndex < entity->NumComponents(); componentIndex++) {
         Component *component = entity->GetComponent(componentIndex);
 
-        Array<PropertyInfo> propertyInfoList;
-        component->GetPropertyInfoList(propertyInfoList);
+        const PropertyInfoTable &propertyInfoTable = component->GetPropertyInfoTable();
 
-        for (int propIndex = 0; propIndex < propertyInfoList.Count(); propIndex++) {
-            const auto &propInfo = propertyInfoList[propIndex];
+        for (int propIndex = 0; propIndex < propertyInfoTable.Count(); propIndex++) {
+            const auto &propInfo = propertyInfoTable[propIndex];
 
             if (propInfo.GetType() == Variant::GuidType) {
                 if (propInfo.GetFlags() & PropertyInfo::ArrayFlag) {
-                    for (int arrayIndex = 0; arrayIndex < component->GetPropertyArrayCount(propInfo.GetName()); arrayIndex++) {
+                    for (int arrayIndex = 0; arrayIndex < component->GetPropertyArrayCount(propInfo); arrayIndex++) {
                         const Guid fromGuid = component->GetArrayProperty(propIndex, arrayIndex).As<Guid>();
 
                         if (remapGuidMap.Get(fromGuid, &toGuid)) {
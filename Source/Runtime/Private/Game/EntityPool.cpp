@@ -0,0 +1,118 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Components/ComTransform.h"
+#include "Game/EntityPool.h"
+#include "Game/GameWorld.h"
+
+BE_NAMESPACE_BEGIN
+
+EntityPool::EntityPool(GameWorld *gameWorld, const Entity *originalEntity, int sceneIndex) {
+    this->gameWorld = gameWorld;
+    this->sceneIndex = sceneIndex;
+    this->originalGuid = originalEntity->GetGuid();
+}
+
+EntityPool::~EntityPool() {
+    // Remaining entities are owned by the game world
+    for (int i = 0; i < entities.Count(); i++) {
+        entities[i]->pool = nullptr;
+        entities[i]->poolFreeIndex = -1;
+    }
+}
+
+bool EntityPool::Grow(int count) {
+    // Look up the original entity every time, it might be destroyed or reloaded (prefab) since the last growth
+    Object *originalObject = Entity::FindInstance(originalGuid);
+    const Entity *originalEntity = originalObject ? originalObject->Cast<Entity>() : nullptr;
+    if (!originalEntity) {
+        BE_WARNLOG(L"EntityPool::Grow: original entity %hs is not found\n", originalGuid.ToString());
+        return false;
+    }
+
+    entityTemplate.Init(originalEntity);
+
+    entities.Resize(entities.Count() + count);
+    freeEntities.Resize(freeEntities.Count() + count);
+
+    for (int i = 0; i < count; i++) {
+        Entity *entity = entityTemplate.Instantiate(gameWorld, sceneIndex);
+        entity->pool = this;
+        entity->SetActive(false);
+
+        gameWorld->RegisterEntityHierarchy(entity);
+
+        entities.Append(entity);
+        entity->poolFreeIndex = freeEntities.Append(entity);
+    }
+
+    return true;
+}
+
+void EntityPool::WarmUp(int count) {
+    if (freeEntities.Count() < count) {
+        Grow(count - freeEntities.Count());
+    }
+}
+
+Entity *EntityPool::Acquire(const Vec3 &origin, const Quat &rotation) {
+    if (freeEntities.Count() == 0 && !Grow(1)) {
+        return nullptr;
+    }
+
+    Entity *entity = freeEntities.TakeLast();
+    entity->poolFreeIndex = -1;
+
+    // Place it before activation so that render objects and rigid bodies are relinked at the new position
+    entity->GetTransform()->SetLocalOriginRotation(origin, rotation);
+    entity->SetActive(true);
+
+    return entity;
+}
+
+void EntityPool::Release(Entity *entity) {
+    assert(entity->pool == this);
+
+    if (entity->poolFreeIndex >= 0) {
+        BE_WARNLOG(L"EntityPool::Release: entity '%hs' is already released\n", entity->GetName().c_str());
+        return;
+    }
+
+    entity->SetActive(false);
+
+    // Detach from the parent, so that it's not destroyed together with the parent
+    if (entity->GetParent()) {
+        entity->SetParentGuid(Guid::zero);
+    }
+
+    entity->poolFreeIndex = freeEntities.Append(entity);
+}
+
+void EntityPool::Forget(Entity *entity) {
+    assert(entity->pool == this);
+
+    entities.RemoveFast(entity);
+
+    if (entity->poolFreeIndex >= 0) {
+        // The last free entity is moved into the hole
+        freeEntities.Last()->poolFreeIndex = entity->poolFreeIndex;
+        freeEntities.RemoveIndexFast(entity->poolFreeIndex);
+    }
+
+    entity->pool = nullptr;
+    entity->poolFreeIndex = -1;
+}
+
+BE_NAMESPACE_END
@@ -0,0 +1,119 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Components/Component.h"
+#include "Game/EntityTemplate.h"
+#include "Game/GameWorld.h"
+
+BE_NAMESPACE_BEGIN
+
+void EntityTemplate::Init(const Entity *rootEntity) {
+    Clear();
+
+    if (!rootEntity) {
+        return;
+    }
+
+    // Same order with Entity::SerializeHierarchy()
+    EntityPtrArray children;
+    rootEntity->GetChildren(children);
+
+    sourceEntities.Resize(children.Count() + 1);
+    sourceEntities.Append(rootEntity);
+    for (int i = 0; i < children.Count(); i++) {
+        sourceEntities.Append(children[i]);
+    }
+
+    Guid zeroGuid;
+
+    for (int entityIndex = 0; entityIndex < sourceEntities.Count(); entityIndex++) {
+        const Entity *sourceEntity = sourceEntities[entityIndex];
+
+        sourceGuids.Append(sourceEntity->GetGuid());
+
+        for (int componentIndex = 0; componentIndex < sourceEntity->NumComponents(); componentIndex++) {
+            const Component *sourceComponent = sourceEntity->GetComponent(componentIndex);
+
+            if (sourceComponent) {
+                sourceGuids.Append(sourceComponent->GetGuid());
+            }
+        }
+    }
+
+    // Keys are fixed, only values are updated for each copy
+    for (int i = 0; i < sourceGuids.Count(); i++) {
+        guidMap.Set(sourceGuids[i], zeroGuid);
+    }
+}
+
+void EntityTemplate::Clear() {
+    sourceEntities.Clear();
+    sourceGuids.Clear();
+    guidMap.Clear();
+}
+
+void EntityTemplate::GenerateGuids() const {
+    for (int i = 0; i < sourceGuids.Count(); i++) {
+        guidMap[sourceGuids[i]] = Guid::CreateGuid();
+    }
+}
+
+Entity *EntityTemplate::CreateEntity(int entityIndex, GameWorld *gameWorld, int sceneIndex) const {
+    const Entity *sourceEntity = sourceEntities[entityIndex];
+
+    // Parents are created first, so the parent GUID is remapped to the existing copy
+    Entity *entity = Entity::CreateEntity(sourceEntity, guidMap, gameWorld, sceneIndex);
+
+    // If source entity is prefab source, mark cloned entity originated from prefab entity
+    if (sourceEntity->IsPrefabSource()) {
+        entity->SetProperty("prefabSource", sourceEntity->GetGuid());
+        entity->SetProperty("prefab", false);
+    }
+
+    return entity;
+}
+
+void EntityTemplate::CreateEntities(GameWorld *gameWorld, int sceneIndex, EntityPtrArray &entities) const {
+    GenerateGuids();
+
+    for (int entityIndex = 0; entityIndex < sourceEntities.Count(); entityIndex++) {
+        entities.Append(CreateEntity(entityIndex, gameWorld, sceneIndex));
+    }
+}
+
+Entity *EntityTemplate::Instantiate(GameWorld *gameWorld, int sceneIndex) const {
+    if (sourceEntities.Count() == 0) {
+        return nullptr;
+    }
+
+    GenerateGuids();
+
+    Entity *rootEntity = nullptr;
+
+    for (int entityIndex = 0; entityIndex < sourceEntities.Count(); entityIndex++) {
+        Entity *entity = CreateEntity(entityIndex, gameWorld, sceneIndex);
+
+        entity->Init();
+        entity->InitComponents();
+
+        if (!rootEntity) {
+            rootEntity = entity;
+        }
+    }
+
+    return rootEntity;
+}
+
+BE_NAMESPACE_END
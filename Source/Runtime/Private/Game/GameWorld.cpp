@@ -14,6 +14,8 @@
 
 #include "Precompiled.h"
 #include "File/FileSystem.h"
+#include "File/FileMapping.h"
+#include "Core/BinarySerializer.h"
 #include "Render/Render.h"
 #include "Physics/Collider.h"
 #include "Physics/Physics.h"
@@ -24,12 +26,16 @@
 #include "Components/ComCamera.h"
 #include "Components/ComScript.h"
 #include "Game/Entity.h"
+#include "Game/EntityTemplate.h"
+#include "Game/EntityPool.h"
+#include "Game/Prefab.h"
 #include "Game/MapRenderSettings.h"
 #include "Game/GameWorld.h"
 #include "Game/GameSettings.h"
 #include "Scripting/LuaVM.h"
 #include "StaticBatching/StaticBatch.h"
 #include "../StaticBatching/MeshCombiner.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -135,6 +141,10 @@ void GameWorld::ClearEntities(bool clearAll) {
 
         entities[entityNum] = nullptr;
     }
+
+    if (clearAll) {
+        ClearEntityPools();
+    }
 }
 
 Entity *GameWorld::FindEntityByName(const char *name) const {
@@ -318,6 +328,8 @@ void GameWorld::RegisterEntity(Entity *ent, int entityIndex) {
     entityHash.Add(nameHash, entityIndex);
     entityTagHash.Add(tagHash, entityIndex);
 
+    InvalidateEntityQueryBounds(ent);
+
     if (!isMapLoading) {
         if (gameAwaking) {
             ent->Awake();
@@ -349,39 +361,35 @@ void GameWorld::UnregisterEntity(Entity *ent) {
     ent->entityNum = BadEntityNum;
     entities[index] = nullptr;
 
+    if (ent->queryProxyId != -1) {
+        entityDbvt.DestroyProxy(ent->queryProxyId);
+        ent->queryProxyId = -1;
+    }
+    ent->queryBoundsInvalidated = false;
+
+    if (ent->pool) {
+        ent->pool->Forget(ent);
+    }
+
     EmitSignal(&SIG_EntityUnregistered, ent);
 }
 
 Entity *GameWorld::CloneEntity(const Entity *originalEntity) {
-    // Serialize source entity and it's children
-    Json::Value originalEntitiesValue;
-    Entity::SerializeHierarchy(originalEntity, originalEntitiesValue);
-
-    // Clone entities value which is replaced by new GUIDs
-    HashTable<Guid, Guid> guidMap;
-    Json::Value clonedEntitiesValue = Entity::CloneEntitiesValue(originalEntitiesValue, guidMap);
+    // Copy source entity and it's children directly without serialization
+    EntityTemplate entityTemplate(originalEntity);
 
-    EntityPtrArray clonedEntities;
-
-    for (int i = 0; i < clonedEntitiesValue.size(); i++) {
-        // Create cloned entity
-        Entity *clonedEntity = Entity::CreateEntity(clonedEntitiesValue[i], this, originalEntity->sceneIndex);
-        clonedEntities.Append(clonedEntity);
+    return entityTemplate.Instantiate(this, originalEntity->sceneIndex);
+}
 
-        // Remap all GUID references to newly created
-        Entity::RemapGuids(clonedEntity, guidMap);
+void GameWorld::RegisterEntityHierarchy(Entity *rootEntity) {
+    RegisterEntity(rootEntity);
 
-        // If source entity is prefab source, mark cloned entity originated from prefab entity
-        if (originalEntitiesValue[i]["prefab"].asBool()) {
-            clonedEntity->SetProperty("prefabSource", Guid::FromString(originalEntitiesValue[i]["guid"].asCString()));
-            clonedEntity->SetProperty("prefab", false);
-        }
+    EntityPtrArray children;
+    rootEntity->GetChildren(children);
 
-        clonedEntity->Init();
-        clonedEntity->InitComponents();
+    for (int i = 0; i < children.Count(); i++) {
+        RegisterEntity(children[i]);
     }
-
-    return clonedEntities[0];
 }
 
 Entity *GameWorld::CreateEmptyEntity(const char *name) {
@@ -405,14 +413,7 @@ Entity *GameWorld::CreateEmptyEntity(const char *name) {
 Entity *GameWorld::InstantiateEntity(const Entity *originalEntity) {
     Entity *clonedEntity = CloneEntity(originalEntity);
 
-    RegisterEntity(clonedEntity);
-
-    EntityPtrArray children;
-    clonedEntity->GetChildren(children);
-
-    for (int i = 0; i < children.Count(); i++) {
-        RegisterEntity(children[i]);
-    }
+    RegisterEntityHierarchy(clonedEntity);
 
     return clonedEntity;
 }
@@ -423,18 +424,102 @@ Entity *GameWorld::InstantiateEntityWithTransform(const Entity *originalEntity,
     ComTransform *transform = clonedEntity->GetTransform();
     transform->SetLocalOriginRotation(origin, rotation);
 
-    RegisterEntity(clonedEntity);
+    RegisterEntityHierarchy(clonedEntity);
 
-    EntityPtrArray children;
-    clonedEntity->GetChildren(children);
+    return clonedEntity;
+}
 
-    for (int i = 0; i < children.Count(); i++) {
-        RegisterEntity(children[i]);
+Entity *GameWorld::InstantiateTemplate(const EntityTemplate &entityTemplate) {
+    if (!entityTemplate.IsValid()) {
+        return nullptr;
     }
 
+    Entity *clonedEntity = entityTemplate.Instantiate(this, entityTemplate.GetRootEntity()->sceneIndex);
+
+    RegisterEntityHierarchy(clonedEntity);
+
     return clonedEntity;
 }
 
+void GameWorld::InstantiateTemplate(const EntityTemplate &entityTemplate, int count, EntityPtrArray &rootEntities) {
+    if (!entityTemplate.IsValid()) {
+        return;
+    }
+
+    int sceneIndex = entityTemplate.GetRootEntity()->sceneIndex;
+
+    rootEntities.Resize(rootEntities.Count() + count);
+
+    for (int i = 0; i < count; i++) {
+        Entity *clonedEntity = entityTemplate.Instantiate(this, sceneIndex);
+
+        RegisterEntityHierarchy(clonedEntity);
+
+        rootEntities.Append(clonedEntity);
+    }
+}
+
+EntityPool *GameWorld::GetEntityPool(const Entity *originalEntity, int sceneIndex) {
+    EntityPool *pool;
+    if (!entityPools.Get(originalEntity->GetGuid(), &pool)) {
+        pool = new EntityPool(this, originalEntity, sceneIndex);
+        entityPools.Set(originalEntity->GetGuid(), pool);
+    }
+    return pool;
+}
+
+void GameWorld::WarmUpEntityPool(const Entity *originalEntity, int count) {
+    int sceneIndex = originalEntity->gameWorld == this ? originalEntity->sceneIndex : 0;
+
+    GetEntityPool(originalEntity, sceneIndex)->WarmUp(count);
+}
+
+Entity *GameWorld::AcquireEntity(const Entity *originalEntity) {
+    const ComTransform *transform = originalEntity->GetTransform();
+
+    return AcquireEntityWithTransform(originalEntity, transform->GetLocalOrigin(), transform->GetLocalRotation());
+}
+
+Entity *GameWorld::AcquireEntityWithTransform(const Entity *originalEntity, const Vec3 &origin, const Quat &rotation) {
+    int sceneIndex = originalEntity->gameWorld == this ? originalEntity->sceneIndex : 0;
+
+    return GetEntityPool(originalEntity, sceneIndex)->Acquire(origin, rotation);
+}
+
+void GameWorld::ReleaseEntity(Entity *entity) {
+    if (!entity->pool) {
+        Entity::DestroyInstance(entity);
+        return;
+    }
+
+    entity->pool->Release(entity);
+}
+
+void GameWorld::ClearEntityPools() {
+    entityPools.DeleteContents();
+}
+
+const EntityPool *GameWorld::FindEntityPool(const Entity *originalEntity) const {
+    EntityPool *pool = nullptr;
+    entityPools.Get(originalEntity->GetGuid(), &pool);
+    return pool;
+}
+
+void GameWorld::WarmUpEntityPools(int sceneIndex) {
+    for (int i = 0; i < entityPoolSettings.Count(); i++) {
+        const EntityPoolSetting &setting = entityPoolSettings[i];
+
+        Prefab *prefab = prefabManager.GetPrefab(setting.prefabFilename);
+        Entity *originalEntity = prefab ? prefab->GetRootEntity() : nullptr;
+        if (!originalEntity) {
+            BE_WARNLOG(L"GameWorld::WarmUpEntityPools: Couldn't load prefab '%hs'\n", setting.prefabFilename.c_str());
+            continue;
+        }
+
+        GetEntityPool(originalEntity, sceneIndex)->WarmUp(setting.warmUpCount);
+    }
+}
+
 Entity *GameWorld::SpawnEntityFromJson(Json::Value &entityValue, int sceneIndex) {
     const char *classname = entityValue["classname"].asCString();
     if (Str::Cmp(classname, Entity::metaObject.ClassName()) != 0) {
@@ -462,6 +547,36 @@ void GameWorld::SpawnEntitiesFromJson(Json::Value &entitiesValue, int sceneIndex
     }
 }
 
+Entity *GameWorld::SpawnEntityFromBinary(const BinaryObject &entityObject, int sceneIndex) {
+    const char *classname = entityObject.ClassName();
+    if (Str::Cmp(classname, Entity::metaObject.ClassName()) != 0) {
+        BE_WARNLOG(L"GameWorld::SpawnEntityFromBinary: Bad classname '%hs' for entity\n", classname);
+        return nullptr;
+    }
+
+    int spawn_entnum = -1;
+    Variant spawnEntnumValue;
+    BinaryProperty spawnEntnumProp = entityObject.FindProperty("spawn_entnum");
+    if (spawnEntnumProp.IsValid() && spawnEntnumProp.GetValue(Variant::IntType, spawnEntnumValue)) {
+        spawn_entnum = spawnEntnumValue.As<int>();
+    }
+
+    Entity *entity = Entity::CreateEntity(entityObject, this, sceneIndex);
+
+    entity->Init();
+    entity->InitComponents();
+
+    RegisterEntity(entity, spawn_entnum);
+
+    return entity;
+}
+
+void GameWorld::SpawnEntitiesFromBinary(const BinaryDeserializer &reader, int sceneIndex) {
+    for (int i = 0; i < reader.NumEntities(); i++) {
+        SpawnEntityFromBinary(reader.GetEntity(i), sceneIndex);
+    }
+}
+
 void GameWorld::BeginMapLoading() {
     isMapLoading = true;
 }
@@ -590,10 +705,15 @@ void GameWorld::NewMap() {
 
     ClearEntities();
 
+    entityPoolSettings.Clear();
+
     Reset();
 }
 
 bool GameWorld::LoadMap(const char *filename, LoadSceneMode mode) {
+    BE_PROFILE_SCOPE("GameWorld::LoadMap");
+    MemTagScope memTagScope(MemTag::Game);
+
     BE_LOG(L"Loading map '%hs'...\n", filename);
 
     if (mode != LoadSceneMode::Additive) {
@@ -604,9 +724,27 @@ bool GameWorld::LoadMap(const char *filename, LoadSceneMode mode) {
 
     BeginMapLoading();
 
-    char *text = nullptr;
-    fileSystem.LoadFile(filename, true, (void **)&text);
-    if (!text) {
+    // Map files in the real file system are memory mapped, and the others (in archives) are loaded to memory
+    FileMapping fileMapping;
+    char *loadedData = nullptr;
+    const char *data = nullptr;
+    size_t size = 0;
+
+    File *fp = fileSystem.OpenFileRead(filename, true);
+    if (fp) {
+        Str filePath = fp->GetFilePath();
+        fileSystem.CloseFile(fp);
+
+        if (PlatformFile::FileExists(filePath) && fileMapping.Open(filePath)) {
+            data = fileMapping.GetData();
+            size = fileMapping.GetSize();
+        }
+    }
+    if (!data) {
+        size = fileSystem.LoadFile(filename, true, (void **)&loadedData);
+        data = loadedData;
+    }
+    if (!data) {
         BE_WARNLOG(L"Couldn't load '%hs'\n", filename);
         FinishMapLoading();
         return false;
@@ -614,15 +752,45 @@ bool GameWorld::LoadMap(const char *filename, LoadSceneMode mode) {
 
     mapName = filename;
 
+    int sceneIndex = 0;
+    for (; sceneIndex < COUNT_OF(scenes); sceneIndex++) {
+        if (!scenes[sceneIndex].root.GetChild()) {
+            break;
+        }
+    }
+
+    assert(sceneIndex < COUNT_OF(scenes));
+
+    bool loaded;
+    if (BinaryDeserializer::IsBinary(data, size)) {
+        loaded = LoadMapBinary(data, size, sceneIndex);
+    } else {
+        loaded = LoadMapJson(data, size, sceneIndex);
+    }
+
+    if (loadedData) {
+        fileSystem.FreeFile(loadedData);
+    }
+    fileMapping.Close();
+
+    if (!loaded) {
+        FinishMapLoading();
+        return false;
+    }
+
+    FinishMapLoading();
+
+    return true;
+}
+
+bool GameWorld::LoadMapJson(const char *text, size_t size, int sceneIndex) {
     Json::Value map;
     Json::Reader jsonReader;
-    if (!jsonReader.parse(text, map)) {
+    if (!jsonReader.parse(text, text + size, map)) {
         BE_WARNLOG(L"Failed to parse JSON text\n");
         return false;
     }
 
-    fileSystem.FreeFile(text);
-
     // Read map version
     int mapVersion = map["version"].asInt();
 
@@ -630,26 +798,107 @@ bool GameWorld::LoadMap(const char *filename, LoadSceneMode mode) {
     mapRenderSettings->Deserialize(map["renderSettings"]);
     mapRenderSettings->Init();
 
-    int sceneIndex = 0;
-    for (; sceneIndex < COUNT_OF(scenes); sceneIndex++) {
-        if (!scenes[sceneIndex].root.GetChild()) {
-            break;
-        }
+    // Read and spawn entities
+    SpawnEntitiesFromJson(map["entities"], sceneIndex);
+
+    // Read entity pool settings and warm up pools
+    const Json::Value &entityPoolsValue = map["entityPools"];
+
+    entityPoolSettings.SetCount(entityPoolsValue.size());
+
+    for (int i = 0; i < entityPoolsValue.size(); i++) {
+        entityPoolSettings[i].prefabFilename = entityPoolsValue[i]["prefab"].asCString();
+        entityPoolSettings[i].warmUpCount = entityPoolsValue[i]["count"].asInt();
     }
 
-    assert(sceneIndex < COUNT_OF(scenes));
+    WarmUpEntityPools(sceneIndex);
 
-    // Read and spawn entities
-    SpawnEntitiesFromJson(map["entities"], sceneIndex);
+    return true;
+}
 
-    FinishMapLoading();
+bool GameWorld::LoadMapBinary(const char *data, size_t size, int sceneIndex) {
+    BinaryDeserializer reader;
+    if (!reader.Open(data, size)) {
+        BE_WARNLOG(L"Failed to open binary map data\n");
+        return false;
+    }
+
+    const BinaryObject map = reader.GetRoot();
+
+    // Read map render settings, missing render settings are read as default values like JSON map
+    const BinaryProperty renderSettingsProp = map.FindProperty("renderSettings");
+    mapRenderSettings->DeserializeBinary(renderSettingsProp.IsValid() && renderSettingsProp.IsObject() ? renderSettingsProp.GetObject() : BinaryObject());
+    mapRenderSettings->Init();
+
+    // Read and spawn entities in the entity index
+    SpawnEntitiesFromBinary(reader, sceneIndex);
+
+    // Read entity pool settings and warm up pools
+    const BinaryProperty entityPoolsProp = map.FindProperty("entityPools");
+
+    entityPoolSettings.SetCount(entityPoolsProp.IsValid() ? entityPoolsProp.Count() : 0);
+
+    for (int i = 0; i < entityPoolSettings.Count(); i++) {
+        const BinaryObject poolObject = entityPoolsProp.GetObject(i);
+
+        Variant prefabValue, countValue;
+        poolObject.FindProperty("prefab").GetValue(Variant::StrType, prefabValue);
+        poolObject.FindProperty("count").GetValue(Variant::IntType, countValue);
+
+        entityPoolSettings[i].prefabFilename = prefabValue.As<Str>();
+        entityPoolSettings[i].warmUpCount = countValue.As<int>();
+    }
+
+    WarmUpEntityPools(sceneIndex);
 
     return true;
 }
 
-void GameWorld::SaveMap(const char *filename) {
+void GameWorld::SaveMap(const char *filename, bool binary) {
     BE_LOG(L"Saving map '%hs'...\n", filename);
 
+    if (binary) {
+        BinarySerializer out;
+        out.BeginObject();
+
+        // Write map version
+        out.WriteProperty("version", 1);
+
+        // Write map render settings
+        out.BeginObjectProperty("renderSettings", false);
+        out.BeginObject();
+        mapRenderSettings->SerializeBinary(out);
+        out.EndObject();
+        out.EndObjectProperty();
+
+        // Write entities except for the pooled ones
+        out.BeginObjectProperty("entities", true);
+        for (Entity *ent = scenes[0].root.GetChild(); ent; ent = ent->node.GetNextSibling()) {
+            if (!ent->pool) {
+                Entity::SerializeHierarchyBinary(ent, out);
+            }
+        }
+        out.EndObjectProperty();
+
+        // Write entity pool settings
+        if (entityPoolSettings.Count() > 0) {
+            out.BeginObjectProperty("entityPools", true);
+            for (int i = 0; i < entityPoolSettings.Count(); i++) {
+                out.BeginObject();
+                out.WriteProperty("prefab", entityPoolSettings[i].prefabFilename);
+                out.WriteProperty("count", entityPoolSettings[i].warmUpCount);
+                out.EndObject();
+            }
+            out.EndObjectProperty();
+        }
+
+        out.EndObject();
+
+        const Array<byte> &data = out.Finish();
+        fileSystem.WriteFile(filename, data.Ptr(), data.Count());
+        return;
+    }
+
     Json::Value map;
 
     // Write map version
@@ -658,9 +907,20 @@ void GameWorld::SaveMap(const char *filename) {
     // Write map render settings
     mapRenderSettings->Serialize(map["renderSettings"]);
 
-    // Write entities
+    // Write entities except for the pooled ones
     for (Entity *ent = scenes[0].root.GetChild(); ent; ent = ent->node.GetNextSibling()) {
-        Entity::SerializeHierarchy(ent, map["entities"]);
+        if (!ent->pool) {
+            Entity::SerializeHierarchy(ent, map["entities"]);
+        }
+    }
+
+    // Write entity pool settings
+    for (int i = 0; i < entityPoolSettings.Count(); i++) {
+        Json::Value poolValue;
+        poolValue["prefab"] = entityPoolSettings[i].prefabFilename.c_str();
+        poolValue["count"] = entityPoolSettings[i].warmUpCount;
+
+        map["entityPools"].append(poolValue);
     }
 
     Json::StyledWriter jsonWriter;
@@ -670,6 +930,8 @@ void GameWorld::SaveMap(const char *filename) {
 }
 
 void GameWorld::Update(int elapsedTime) {
+    BE_PROFILE_SCOPE("GameWorld::Update");
+
     if (isDebuggable) {
         luaVM.PollDebuggee();
     }
@@ -696,6 +958,37 @@ void GameWorld::Update(int elapsedTime) {
 
         luaVM.State().ForceGC();
     }
+
+    // Update world matrices of the transforms changed in this frame
+    transformSystem.Update();
+}
+
+void GameWorld::SetBatchedTransformsEnabled(bool enable) {
+    if (transformSystem.IsEnabled() == enable) {
+        return;
+    }
+
+    if (!enable) {
+        // Resolve all the pending changes before detaching
+        transformSystem.Update();
+    }
+
+    transformSystem.SetEnabled(enable);
+
+    for (int sceneIndex = 0; sceneIndex < COUNT_OF(scenes); sceneIndex++) {
+        for (Entity *ent = scenes[sceneIndex].root.GetChild(); ent; ent = ent->node.GetNext()) {
+            ComTransform *transform = ent->GetTransform();
+            if (!transform->IsInitialized()) {
+                continue;
+            }
+
+            if (enable) {
+                transform->AttachTransformSystem(&transformSystem);
+            } else {
+                transform->DetachTransformSystem();
+            }
+        }
+    }
 }
 
 void GameWorld::FixedUpdateEntities(float timeStep) {
@@ -774,54 +1067,139 @@ void GameWorld::ProcessPointerInput() {
     }
 }
 
-Entity *GameWorld::RayIntersection(const Vec3 &start, const Vec3 &dir, int layerMask) const {
-    Entity *minEntity = nullptr;
+void GameWorld::InvalidateEntityQueryBounds(Entity *ent) {
+    if (ent->queryBoundsInvalidated || !IsRegisteredEntity(ent)) {
+        return;
+    }
+    ent->queryBoundsInvalidated = true;
+
+    queryBoundsInvalidatedEntities.Append(ent->entityNum);
+}
 
-    float minScale = FLT_MAX;
+void GameWorld::UpdateEntityQueryProxies() const {
+    for (int i = 0; i < queryBoundsInvalidatedEntities.Count(); i++) {
+        Entity *ent = entities[queryBoundsInvalidatedEntities[i]];
+        // Entity might have been unregistered or updated already
+        if (!ent || !ent->queryBoundsInvalidated) {
+            continue;
+        }
+        ent->queryBoundsInvalidated = false;
 
-    for (int sceneIndex = 0; sceneIndex < COUNT_OF(scenes); sceneIndex++) {
-        for (Entity *ent = scenes[sceneIndex].root.GetChild(); ent; ent = ent->node.GetNext()) {
-            if (!(BIT(ent->GetLayer()) & layerMask)) {
-                continue;
+        // Entities that have only a transform component can't be hit
+        if (ent->components.Count() <= 1) {
+            if (ent->queryProxyId != -1) {
+                entityDbvt.DestroyProxy(ent->queryProxyId);
+                ent->queryProxyId = -1;
             }
+            continue;
+        }
 
-            if (ent->RayIntersection(start, dir, true, minScale)) {
-                minEntity = ent;
-            }
+        AABB worldAabb = ent->GetWorldAABB();
+
+        if (ent->queryProxyId == -1) {
+            ent->queryProxyId = entityDbvt.CreateProxy(worldAabb, MeterToUnit(0.5f), ent);
+        } else {
+            entityDbvt.MoveProxy(ent->queryProxyId, worldAabb, MeterToUnit(0.5f), worldAabb.Center() - ent->queryBounds.Center());
+        }
+
+        ent->queryBounds = worldAabb;
+    }
+
+    queryBoundsInvalidatedEntities.SetCount(0, false);
+}
+
+Entity *GameWorld::RayCastEntities(const Vec3 &start, const Vec3 &dir, int layerMask, const Array<Entity *> *excludingArray, float &scale) const {
+    UpdateEntityQueryProxies();
+
+    HashIndex excludingHash;
+    if (excludingArray) {
+        for (int i = 0; i < excludingArray->Count(); i++) {
+            excludingHash.Add((*excludingArray)[i]->entityNum, i);
         }
     }
 
+    Entity *minEntity = nullptr;
+
+    // Leaves are visited front-to-back, and the subtrees behind the closest hit so far are skipped
+    auto rayCastCallback = [&](int32_t proxyId, float maxScale) -> float {
+        Entity *ent = (Entity *)entityDbvt.GetUserData(proxyId);
+
+        if (!(BIT(ent->GetLayer()) & layerMask)) {
+            return maxScale;
+        }
+
+        if (excludingArray) {
+            for (int i = excludingHash.First(ent->entityNum); i != -1; i = excludingHash.Next(i)) {
+                if ((*excludingArray)[i] == ent) {
+                    return maxScale;
+                }
+            }
+        }
+
+        if (ent->RayIntersection(start, dir, true, maxScale)) {
+            minEntity = ent;
+            scale = maxScale;
+        }
+        return maxScale;
+    };
+
+    scale = FLT_MAX;
+    entityDbvt.RayCast(start, dir, FLT_MAX, rayCastCallback);
+
     return minEntity;
 }
 
+Entity *GameWorld::RayIntersection(const Vec3 &start, const Vec3 &dir, int layerMask) const {
+    float scale;
+    return RayCastEntities(start, dir, layerMask, nullptr, scale);
+}
+
 Entity *GameWorld::RayIntersection(const Vec3 &start, const Vec3 &dir, int layerMask, const Array<Entity *> &excludingArray, float *scale) const {
-    Entity *minEntity = nullptr;
+    float minScale;
+    Entity *minEntity = RayCastEntities(start, dir, layerMask, &excludingArray, minScale);
 
-    float minScale = FLT_MAX;
     if (scale) {
         *scale = minScale;
     }
+    return minEntity;
+}
 
-    for (int sceneIndex = 0; sceneIndex < COUNT_OF(scenes); sceneIndex++) {
-        for (Entity *ent = scenes[sceneIndex].root.GetChild(); ent; ent = ent->node.GetNext()) {
-            if (!(BIT(ent->GetLayer()) & layerMask)) {
-                continue;
-            }
+const EntityPtrArray GameWorld::OverlapSphere(const Sphere &sphere, int layerMask) const {
+    UpdateEntityQueryProxies();
 
-            if (excludingArray.Find(ent)) {
-                continue;
-            }
+    EntityPtrArray resultEntities;
 
-            if (ent->RayIntersection(start, dir, true, minScale)) {
-                minEntity = ent;
-                if (scale) {
-                    *scale = minScale;
-                }
-            }
+    auto queryCallback = [&](int32_t proxyId) -> bool {
+        Entity *ent = (Entity *)entityDbvt.GetUserData(proxyId);
+
+        if ((BIT(ent->GetLayer()) & layerMask) && sphere.IsIntersectAABB(ent->queryBounds)) {
+            resultEntities.Append(ent);
         }
-    }
+        return true;
+    };
 
-    return minEntity;
+    entityDbvt.Query(sphere, queryCallback);
+
+    return resultEntities;
+}
+
+const EntityPtrArray GameWorld::OverlapAABB(const AABB &aabb, int layerMask) const {
+    UpdateEntityQueryProxies();
+
+    EntityPtrArray resultEntities;
+
+    auto queryCallback = [&](int32_t proxyId) -> bool {
+        Entity *ent = (Entity *)entityDbvt.GetUserData(proxyId);
+
+        if ((BIT(ent->GetLayer()) & layerMask) && aabb.IsIntersectAABB(ent->queryBounds)) {
+            resultEntities.Append(ent);
+        }
+        return true;
+    };
+
+    entityDbvt.Query(aabb, queryCallback);
+
+    return resultEntities;
 }
 
 void GameWorld::Render() {
@@ -17,6 +17,8 @@
 #include "Game/Prefab.h"
 #include "Game/GameWorld.h"
 #include "File/FileSystem.h"
+#include "Core/BinarySerializer.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -67,15 +69,61 @@ bool Prefab::Create(const Json::Value &entitiesValue) {
     return true;
 }
 
+bool Prefab::Create(const BinaryDeserializer &reader) {
+    Clear();
+
+    for (int entityIndex = 0; entityIndex < reader.NumEntities(); entityIndex++) {
+        const BinaryObject entityObject = reader.GetEntity(entityIndex);
+
+        const char *classname = entityObject.ClassName();
+
+        if (!Str::Cmp(classname, Entity::metaObject.ClassName())) {
+            Entity *entity = Entity::CreateEntity(entityObject, prefabManager.GetPrefabWorld());
+            assert(entity->GetProperty("prefab").As<bool>());
+
+            Variant parentGuidValue;
+            BinaryProperty parentProp = entityObject.FindProperty("parent");
+            const Guid parentGuid = parentProp.IsValid() && parentProp.GetValue(Variant::GuidType, parentGuidValue) ? parentGuidValue.As<Guid>() : Guid::zero;
+            if (parentGuid.IsZero()) { // GUID 0 means a root entity
+                entity->node.SetParent(entityHierarchy);
+            }
+
+            entity->Init();
+
+            entities.Append(entity);
+        } else {
+            BE_WARNLOG(L"Unknown classname '%hs'\n", classname);
+        }
+    }
+
+    return true;
+}
+
 bool Prefab::Load(const char *filename) {
+    BE_PROFILE_SCOPE("Prefab::Load");
+
     char *text = nullptr;
 
-    fileSystem.LoadFile(filename, true, (void **)&text);
+    size_t size = fileSystem.LoadFile(filename, true, (void **)&text);
     if (!text) {
         BE_WARNLOG(L"Couldn't load '%hs'\n", filename);
         return false;
     }
 
+    if (BinaryDeserializer::IsBinary(text, size)) {
+        BinaryDeserializer reader;
+        if (!reader.Open(text, size)) {
+            BE_WARNLOG(L"Failed to open binary prefab data\n");
+            fileSystem.FreeFile(text);
+            return false;
+        }
+
+        Create(reader);
+
+        fileSystem.FreeFile(text);
+        return true;
+    }
+
     Json::Value entitiesValue;
     Json::Reader jsonReader;
 
@@ -92,7 +140,20 @@ bool Prefab::Load(const char *filename) {
     return true;
 }
 
-void Prefab::Write(const char *filename) {
+void Prefab::Write(const char *filename, bool binary) {
+    if (binary) {
+        BinarySerializer out;
+        out.BeginObject();
+        out.BeginObjectProperty("entities", true);
+        Entity::SerializeHierarchyBinary(entityHierarchy.GetChild(), out);
+        out.EndObjectProperty();
+        out.EndObject();
+
+        const Array<byte> &data = out.Finish(true);
+        fileSystem.WriteFile(filename, data.Ptr(), data.Count());
+        return;
+    }
+
     // Serialize root entity and it's children
     Json::Value entitiesValue;
     Entity::SerializeHierarchy(entityHierarchy.GetChild(), entitiesValue);
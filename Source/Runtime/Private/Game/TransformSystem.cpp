@@ -0,0 +1,350 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Components/ComTransform.h"
+#include "Game/Entity.h"
+#include "Game/TransformSystem.h"
+#include "Simd/Simd.h"
+#include "Core/JobSystem.h"
+#include "Core/Profiler.h"
+
+BE_NAMESPACE_BEGIN
+
+TransformSystem::TransformSystem() {
+    numDirty = 0;
+    numFreeSlots = 0;
+    hierarchyInvalidated = false;
+    notifying = false;
+    enabled = false;
+}
+
+void TransformSystem::Clear() {
+    for (int i = 0; i < transforms.Count(); i++) {
+        if (transforms[i]) {
+            transforms[i]->transformIndex = -1;
+        }
+    }
+
+    transforms.Clear();
+    localMatrices.Clear();
+    worldMatrices.Clear();
+    parents.Clear();
+    dirtyFlags.Clear();
+    changedFlags.Clear();
+    batches.Clear();
+    updatedIndexes.Clear();
+
+    numDirty = 0;
+    numFreeSlots = 0;
+    hierarchyInvalidated = false;
+}
+
+void TransformSystem::Register(ComTransform *transform) {
+    assert(transform->transformIndex < 0);
+
+    // Grow geometrically, there can be tens of thousands of transforms
+    if (transforms.Count() == transforms.Capacity()) {
+        int newCapacity = Max(transforms.Capacity() * 2, MinBatchSize);
+
+        transforms.Resize(newCapacity);
+        localMatrices.Resize(newCapacity);
+        worldMatrices.Resize(newCapacity);
+        parents.Resize(newCapacity);
+        dirtyFlags.Resize(newCapacity);
+        changedFlags.Resize(newCapacity);
+    }
+
+    int index = transforms.Append(transform);
+    localMatrices.Append(transform->GetLocalMatrix());
+    worldMatrices.Append(Mat3x4::identity);
+    parents.Append(-1);
+    dirtyFlags.Append(1);
+    changedFlags.Append(0);
+
+    numDirty++;
+
+    transform->transformIndex = index;
+
+    hierarchyInvalidated = true;
+}
+
+void TransformSystem::Unregister(ComTransform *transform) {
+    int index = transform->transformIndex;
+    assert(index >= 0 && transforms[index] == transform);
+
+    // Free slots are compacted when the hierarchy is rebuilt
+    transforms[index] = nullptr;
+    numFreeSlots++;
+
+    if (dirtyFlags[index]) {
+        dirtyFlags[index] = 0;
+        numDirty--;
+    }
+
+    transform->transformIndex = -1;
+
+    hierarchyInvalidated = true;
+}
+
+void TransformSystem::SetLocalMatrix(int index, const Mat3x4 &localMatrix) {
+    localMatrices[index] = localMatrix;
+
+    if (!dirtyFlags[index]) {
+        dirtyFlags[index] = 1;
+        numDirty++;
+    }
+}
+
+void TransformSystem::InvalidateHierarchy(int index) {
+    if (!dirtyFlags[index]) {
+        dirtyFlags[index] = 1;
+        numDirty++;
+    }
+
+    hierarchyInvalidated = true;
+}
+
+void TransformSystem::RebuildHierarchy() {
+    BE_PROFILE_SCOPE("TransformSystem::RebuildHierarchy");
+
+    const int numTransforms = transforms.Count() - numFreeSlots;
+
+    // Old indices in the new order, and the new index of each old index
+    Array<int> order;
+    order.Resize(numTransforms);
+    Array<int> newIndexes;
+    newIndexes.SetCount(transforms.Count());
+
+    batches.SetCount(0, false);
+
+    Batch batch;
+    batch.first = 0;
+
+    for (int i = 0; i < transforms.Count(); i++) {
+        const ComTransform *transform = transforms[i];
+        if (!transform) {
+            continue;
+        }
+
+        // Transforms that have registered parent will be added with their root
+        const ComTransform *parent = transform->GetParent();
+        if (parent && parent->transformIndex >= 0) {
+            continue;
+        }
+
+        // Breadth-first traversal puts each subtree in a contiguous range ordered by depth
+        int subtreeFirst = order.Count();
+        order.Append(i);
+
+        for (int j = subtreeFirst; j < order.Count(); j++) {
+            newIndexes[order[j]] = j;
+
+            const Entity *entity = transforms[order[j]]->GetEntity();
+
+            for (const Entity *child = entity->GetNode().GetChild(); child; child = child->GetNode().GetNextSibling()) {
+                int childIndex = child->GetTransform()->transformIndex;
+                if (childIndex >= 0) {
+                    order.Append(childIndex);
+                }
+            }
+        }
+
+        if (order.Count() - batch.first >= MinBatchSize) {
+            batch.last = order.Count() - 1;
+            batches.Append(batch);
+            batch.first = order.Count();
+        }
+    }
+
+    if (batch.first < order.Count()) {
+        batch.last = order.Count() - 1;
+        batches.Append(batch);
+    }
+
+    assert(order.Count() == numTransforms);
+
+    Array<ComTransform *> newTransforms;
+    Array<Mat3x4> newLocalMatrices;
+    Array<Mat3x4> newWorldMatrices;
+    Array<int> newParents;
+    Array<byte> newDirtyFlags;
+
+    int newCapacity = Max(transforms.Capacity(), MinBatchSize);
+    newTransforms.Resize(newCapacity);
+    newLocalMatrices.Resize(newCapacity);
+    newWorldMatrices.Resize(newCapacity);
+    newParents.Resize(newCapacity);
+    newDirtyFlags.Resize(newCapacity);
+
+    for (int i = 0; i < order.Count(); i++) {
+        int oldIndex = order[i];
+        ComTransform *transform = transforms[oldIndex];
+
+        const ComTransform *parent = transform->GetParent();
+        int parentIndex = parent && parent->transformIndex >= 0 ? newIndexes[parent->transformIndex] : -1;
+
+        newTransforms.Append(transform);
+        newLocalMatrices.Append(localMatrices[oldIndex]);
+        newWorldMatrices.Append(worldMatrices[oldIndex]);
+        newParents.Append(parentIndex);
+        newDirtyFlags.Append(dirtyFlags[oldIndex]);
+    }
+
+    for (int i = 0; i < newTransforms.Count(); i++) {
+        newTransforms[i]->transformIndex = i;
+    }
+
+    transforms.Swap(newTransforms);
+    localMatrices.Swap(newLocalMatrices);
+    worldMatrices.Swap(newWorldMatrices);
+    parents.Swap(newParents);
+    dirtyFlags.Swap(newDirtyFlags);
+
+    changedFlags.Resize(newCapacity);
+    changedFlags.SetCount(numTransforms, false);
+    changedFlags.Fill(0);
+
+    numFreeSlots = 0;
+
+    hierarchyInvalidated = false;
+}
+
+int TransformSystem::ParentIndex(int index) const {
+    if (!hierarchyInvalidated) {
+        return parents[index];
+    }
+
+    // Parent indices are stale until the hierarchy is rebuilt, so follow the entity hierarchy instead
+    const ComTransform *parent = transforms[index]->GetParent();
+    return parent ? parent->transformIndex : -1;
+}
+
+Mat3x4 TransformSystem::ResolveWorldMatrix(int index, int topIndex) const {
+    const int parentIndex = ParentIndex(index);
+
+    if (index == topIndex) {
+        // Ancestors of the top most dirty transform are up to date
+        return parentIndex >= 0 ? worldMatrices[parentIndex] * localMatrices[index] : localMatrices[index];
+    }
+    return ResolveWorldMatrix(parentIndex, topIndex) * localMatrices[index];
+}
+
+Mat3x4 TransformSystem::GetWorldMatrix(int index) const {
+    // World matrices are valid in any order if nothing is dirty
+    if (numDirty == 0) {
+        return worldMatrices[index];
+    }
+
+    // Find the top most dirty transform among this and its ancestors
+    int topIndex = -1;
+    for (int i = index; i >= 0; i = ParentIndex(i)) {
+        if (dirtyFlags[i]) {
+            topIndex = i;
+        }
+    }
+
+    if (topIndex < 0) {
+        return worldMatrices[index];
+    }
+    return ResolveWorldMatrix(index, topIndex);
+}
+
+void TransformSystem::UpdateBatch(const Batch &batch) {
+    const int *parentPtr = parents.Ptr();
+    byte *dirtyPtr = dirtyFlags.Ptr();
+    byte *changedPtr = changedFlags.Ptr();
+
+    // Parents come before their children, so the changes propagate down in a single pass
+    for (int i = batch.first; i <= batch.last; i++) {
+        const int parentIndex = parentPtr[i];
+        changedPtr[i] = dirtyPtr[i] | (parentIndex >= 0 ? changedPtr[parentIndex] : 0);
+        dirtyPtr[i] = 0;
+    }
+
+    // Transform each run of changed matrices in place by their parent world matrices
+    int i = batch.first;
+    while (i <= batch.last) {
+        if (!changedPtr[i]) {
+            i++;
+            continue;
+        }
+
+        const int runFirst = i;
+        while (i <= batch.last && changedPtr[i]) {
+            i++;
+        }
+        const int runLast = i - 1;
+
+        memcpy(worldMatrices[runFirst].Ptr(), localMatrices[runFirst].Ptr(), (runLast - runFirst + 1) * sizeof(Mat3x4));
+
+        simdProcessor->TransformJoints(worldMatrices.Ptr(), parentPtr, runFirst, runLast);
+    }
+}
+
+void TransformSystem::Update() {
+    BE_PROFILE_SCOPE("TransformSystem::Update");
+
+    // Indexes of the transforms being notified are valid until the hierarchy is rebuilt
+    assert(!notifying);
+
+    if (hierarchyInvalidated) {
+        RebuildHierarchy();
+    }
+
+    if (numDirty == 0) {
+        return;
+    }
+
+    auto updateBatches = [this](int first, int last) {
+        for (int batchIndex = first; batchIndex < last; batchIndex++) {
+            UpdateBatch(batches[batchIndex]);
+        }
+    };
+
+    jobSystem.ParallelFor(batches.Count(), 1, updateBatches);
+
+    numDirty = 0;
+
+    if (updatedIndexes.Capacity() < transforms.Count()) {
+        updatedIndexes.Resize(transforms.Count());
+    }
+
+    for (int i = 0; i < transforms.Count(); i++) {
+        if (changedFlags[i]) {
+            changedFlags[i] = 0;
+            updatedIndexes.Append(i);
+        }
+    }
+
+    // Notify the changes once per transform in hierarchy order.
+    // Listeners may register or unregister transforms while being notified.
+    // Unregistered slots are cleared and new transforms are appended, so the indexes stay valid.
+    notifying = true;
+
+    for (int i = 0; i < updatedIndexes.Count(); i++) {
+        ComTransform *transform = transforms[updatedIndexes[i]];
+        if (transform) {
+            transform->GetEntity()->InvalidateQueryBounds();
+
+            transform->EmitSignal(&ComTransform::SIG_TransformUpdated, transform);
+        }
+    }
+
+    notifying = false;
+
+    updatedIndexes.SetCount(0, false);
+}
+
+BE_NAMESPACE_END
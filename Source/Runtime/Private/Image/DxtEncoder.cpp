@@ -14,9 +14,13 @@
 
 #include "Precompiled.h"
 #include "Core/Task.h"
+#include "Core/JobSystem.h"
 #include "Math/Math.h"
 #include "Image/DxtEncoder.h"
 #include "Eigen/Eigen/Dense"
+#if defined(__X86__)
+#include <emmintrin.h>
+#endif
 
 BE_NAMESPACE_BEGIN
 
@@ -26,6 +30,9 @@ BE_NAMESPACE_BEGIN
 #define C565_5_MASK             0xF8    // 0xFF minus last three bits
 #define C565_6_MASK             0xFC    // 0xFF minus last two bits
 
+#define MAX_REFINE_ITERATIONS   4       // least squares refinement passes of the HQ color end points
+#define MIN_BLOCKS_PER_JOB      256     // blocks encoded per job at least
+
 static void SwapColors(byte *c1, byte *c2) {
     byte tm[3];
     memcpy(tm, c1, 3);
@@ -603,6 +610,78 @@ int DXTEncoder::ComputeColorIndices(const byte *colorBlock, const uint16_t color
     return error;
 }
 
+static uint16_t Vec3ToRGB565(const Vec3 &v) {
+    int r = (int)(v.x * (31.0f / 255.0f) + 0.5f);
+    int g = (int)(v.y * (63.0f / 255.0f) + 0.5f);
+    int b = (int)(v.z * (31.0f / 255.0f) + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+int DXTEncoder::RefineColorEndPoints(const byte *colorBlock, uint16_t &color0, uint16_t &color1, uint32_t &indexes, int error) {
+    // weight of color0 for each index in 4-color mode
+    static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+    for (int iteration = 0; iteration < MAX_REFINE_ITERATIONS && error > 0; iteration++) {
+        if (color0 <= color1) {
+            break;
+        }
+
+        // minimize sum of |a * e0 + b * e1 - x|^2 with a = weight, b = 1 - weight
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        Vec3 ax = Vec3::zero;
+        Vec3 bx = Vec3::zero;
+
+        for (int i = 0; i < 16; i++) {
+            float a = weights[(indexes >> (i << 1)) & 3];
+            float b = 1.0f - a;
+            Vec3 x((float)colorBlock[i * 4 + 0], (float)colorBlock[i * 4 + 1], (float)colorBlock[i * 4 + 2]);
+
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            ax += a * x;
+            bx += b * x;
+        }
+
+        // all the colors use the same index
+        float det = aa * bb - ab * ab;
+        if (Math::Fabs(det) < FLT_EPSILON) {
+            break;
+        }
+
+        float invDet = 1.0f / det;
+        Vec3 e0 = (ax * bb - bx * ab) * invDet;
+        Vec3 e1 = (bx * aa - ax * ab) * invDet;
+
+        e0.Clamp(Vec3::zero, Vec3(255.0f));
+        e1.Clamp(Vec3::zero, Vec3(255.0f));
+
+        uint16_t newColor0 = Vec3ToRGB565(e0);
+        uint16_t newColor1 = Vec3ToRGB565(e1);
+        if (newColor0 == newColor1) {
+            break;
+        }
+        if (newColor0 < newColor1) {
+            uint16_t temp = newColor0;
+            newColor0 = newColor1;
+            newColor1 = temp;
+        }
+
+        uint32_t newIndexes;
+        int newError = ComputeColorIndices(colorBlock, newColor0, newColor1, newIndexes);
+        if (newError >= error) {
+            break;
+        }
+
+        color0 = newColor0;
+        color1 = newColor1;
+        indexes = newIndexes;
+        error = newError;
+    }
+
+    return error;
+}
+
 void DXTEncoder::EncodeDXT1BlockFast(const byte *colorBlock, byte **dstPtr) {
     ALIGN16(byte minColor[4]);
     ALIGN16(byte maxColor[4]);
@@ -688,7 +767,7 @@ void DXTEncoder::EncodeDXN2BlockFast(const byte *colorBlock, byte **dstPtr) {
     }
 }
 
-void DXTEncoder::EncodeDXT1BlockHQ(const byte *colorBlock, byte **dstPtr) {
+void DXTEncoder::EncodeDXT1BlockHQ(const byte *colorBlock, byte **dstPtr, bool refine) {
     ALIGN16(byte minColor[4]);
     ALIGN16(byte maxColor[4]);
     ALIGN16(DXTBlock::ColorBlock dxtColorBlock);
@@ -714,13 +793,17 @@ void DXTEncoder::EncodeDXT1BlockHQ(const byte *colorBlock, byte **dstPtr) {
         dxtColorBlock.color1 = maxColor565;
     }
 
-    ComputeColorIndices(colorBlock, dxtColorBlock.color0, dxtColorBlock.color1, dxtColorBlock.indexes);
+    int error = ComputeColorIndices(colorBlock, dxtColorBlock.color0, dxtColorBlock.color1, dxtColorBlock.indexes);
+
+    if (refine && !transparent) {
+        RefineColorEndPoints(colorBlock, dxtColorBlock.color0, dxtColorBlock.color1, dxtColorBlock.indexes, error);
+    }
 
     memcpy(*dstPtr, &dxtColorBlock, sizeof(dxtColorBlock));
     *dstPtr += sizeof(DXTBlock::ColorBlock);
 }
 
-void DXTEncoder::EncodeDXT3BlockHQ(const byte *colorBlock, byte **dstPtr) {
+void DXTEncoder::EncodeDXT3BlockHQ(const byte *colorBlock, byte **dstPtr, bool refine) {
     ALIGN16(byte minColor[4]);
     ALIGN16(byte maxColor[4]);
     ALIGN16(DXTBlock::ColorBlock dxtColorBlock);
@@ -736,13 +819,17 @@ void DXTEncoder::EncodeDXT3BlockHQ(const byte *colorBlock, byte **dstPtr) {
     dxtColorBlock.color0 = RGB888To565(maxColor);
     dxtColorBlock.color1 = RGB888To565(minColor);
 
-    ComputeColorIndices(colorBlock, dxtColorBlock.color0, dxtColorBlock.color1, dxtColorBlock.indexes);
+    int error = ComputeColorIndices(colorBlock, dxtColorBlock.color0, dxtColorBlock.color1, dxtColorBlock.indexes);
+
+    if (refine) {
+        RefineColorEndPoints(colorBlock, dxtColorBlock.color0, dxtColorBlock.color1, dxtColorBlock.indexes, error);
+    }
 
     memcpy(*dstPtr, &dxtColorBlock, sizeof(dxtColorBlock));
     *dstPtr += sizeof(dxtColorBlock);
 }
 
-void DXTEncoder::EncodeDXT5BlockHQ(const byte *colorBlock, byte **dstPtr) {
+void DXTEncoder::EncodeDXT5BlockHQ(const byte *colorBlock, byte **dstPtr, bool refine) {
     ALIGN16(byte minColor[4]);
     ALIGN16(byte maxColor[4]);
     ALIGN16(DXTBlock::ColorBlock dxtColorBlock);
@@ -772,7 +859,11 @@ void DXTEncoder::EncodeDXT5BlockHQ(const byte *colorBlock, byte **dstPtr) {
     dxtColorBlock.color0 = RGB888To565(maxColor);
     dxtColorBlock.color1 = RGB888To565(minColor);
 
-    ComputeColorIndices(colorBlock, dxtColorBlock.color0, dxtColorBlock.color1, dxtColorBlock.indexes);
+    int error = ComputeColorIndices(colorBlock, dxtColorBlock.color0, dxtColorBlock.color1, dxtColorBlock.indexes);
+
+    if (refine) {
+        RefineColorEndPoints(colorBlock, dxtColorBlock.color0, dxtColorBlock.color1, dxtColorBlock.indexes, error);
+    }
 
     memcpy(*dstPtr, &dxtColorBlock, sizeof(dxtColorBlock));
     *dstPtr += sizeof(dxtColorBlock);
@@ -807,162 +898,366 @@ void DXTEncoder::EncodeDXN2BlockHQ(const byte *colorBlock, byte **dstPtr) {
 }
 
 
-BE_INLINE void DXTEncoder::ExtractBlock(const byte *src, int srcPitch, int blockWidth, int blockHeight, byte *colorBlock) {
-    for (int by = 0; by < 4; by++) {
-        const byte *srcPtrY = src + srcPitch * (by % blockHeight);
+#if defined(__X86__)
 
-        for (int bx = 0; bx < 4; bx++) {
-            const byte *srcPtrX = srcPtrY + 4 * (bx % blockWidth);
+void DXTEncoder::GetMinMaxBBoxSSE2(const byte *colorBlock, byte *minColor, byte *maxColor) {
+    const __m128i *pixels = (const __m128i *)colorBlock;
+    __m128i c0 = _mm_load_si128(pixels + 0);
+    __m128i c1 = _mm_load_si128(pixels + 1);
+    __m128i c2 = _mm_load_si128(pixels + 2);
+    __m128i c3 = _mm_load_si128(pixels + 3);
 
-            for (int i = 0; i < 4; i++) {
-                *colorBlock++ = srcPtrX[i];
-            }
-        }
-    }
+    __m128i minValue = _mm_min_epu8(_mm_min_epu8(c0, c1), _mm_min_epu8(c2, c3));
+    __m128i maxValue = _mm_max_epu8(_mm_max_epu8(c0, c1), _mm_max_epu8(c2, c3));
+
+    // reduce the four pixels left to one
+    minValue = _mm_min_epu8(minValue, _mm_shuffle_epi32(minValue, _MM_SHUFFLE(2, 3, 0, 1)));
+    minValue = _mm_min_epu8(minValue, _mm_shuffle_epi32(minValue, _MM_SHUFFLE(1, 0, 3, 2)));
+    maxValue = _mm_max_epu8(maxValue, _mm_shuffle_epi32(maxValue, _MM_SHUFFLE(2, 3, 0, 1)));
+    maxValue = _mm_max_epu8(maxValue, _mm_shuffle_epi32(maxValue, _MM_SHUFFLE(1, 0, 3, 2)));
+
+    int32_t minPacked = _mm_cvtsi128_si32(minValue);
+    int32_t maxPacked = _mm_cvtsi128_si32(maxValue);
+    memcpy(minColor, &minPacked, 4);
+    memcpy(maxColor, &maxPacked, 4);
 }
 
-void DXTEncoder::CompressImageDXT1Fast(const byte *src, const int width, const int height, const int depth, byte *dst) {
-    ALIGN16(byte colorBlock[4 * 16]);
-    byte *dstPtr = dst;
-    
-    for (int z = 0; z < depth; z++) {
-        for (int y = 0; y < height; y += 4, src += width * 4 * 4) {
-            for (int x = 0; x < width; x += 4) {
-                int bw = Min(4, width - x);
-                int bh = Min(4, height - y);
+void DXTEncoder::InsetColorsBBoxSSE2(byte *minColor, byte *maxColor) {
+    int32_t minPacked, maxPacked;
+    memcpy(&minPacked, minColor, 4);
+    memcpy(&maxPacked, maxColor, 4);
 
-                ExtractBlock(src + 4 * x, 4 * width, bw, bh, colorBlock);
+    __m128i minValue = _mm_cvtsi32_si128(minPacked);
+    __m128i maxValue = _mm_cvtsi32_si128(maxPacked);
 
-                EncodeDXT1BlockFast(colorBlock, &dstPtr);
-            }
-        }
+    __m128i inset = _mm_subs_epu8(maxValue, minValue);
+    inset = _mm_and_si128(_mm_srli_epi16(inset, INSET_COLOR_SHIFT), _mm_set1_epi8((char)(0xFF >> INSET_COLOR_SHIFT)));
+
+    minPacked = _mm_cvtsi128_si32(_mm_adds_epu8(minValue, inset));
+    maxPacked = _mm_cvtsi128_si32(_mm_subs_epu8(maxValue, inset));
+    memcpy(minColor, &minPacked, 4);
+    memcpy(maxColor, &maxPacked, 4);
+}
+
+void DXTEncoder::ComputeAlphaIndicesFastSSE2(const byte *colorBlock, const int alphaOffset, const byte maxAlpha, const byte minAlpha, byte *out) {
+    assert(maxAlpha >= minAlpha);
+    const int ALPHA_RANGE = 7;
+
+    byte ab[7];
+    ab[0] = (13 * maxAlpha +  1 * minAlpha + ALPHA_RANGE) / (ALPHA_RANGE * 2);
+    ab[1] = (11 * maxAlpha +  3 * minAlpha + ALPHA_RANGE) / (ALPHA_RANGE * 2);
+    ab[2] = ( 9 * maxAlpha +  5 * minAlpha + ALPHA_RANGE) / (ALPHA_RANGE * 2);
+    ab[3] = ( 7 * maxAlpha +  7 * minAlpha + ALPHA_RANGE) / (ALPHA_RANGE * 2);
+    ab[4] = ( 5 * maxAlpha +  9 * minAlpha + ALPHA_RANGE) / (ALPHA_RANGE * 2);
+    ab[5] = ( 3 * maxAlpha + 11 * minAlpha + ALPHA_RANGE) / (ALPHA_RANGE * 2);
+    ab[6] = ( 1 * maxAlpha + 13 * minAlpha + ALPHA_RANGE) / (ALPHA_RANGE * 2);
+
+    // gather the alpha values of the 16 pixels in bytes
+    const __m128i *pixels = (const __m128i *)colorBlock;
+    const __m128i shift = _mm_cvtsi32_si128(alphaOffset * 8);
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+
+    __m128i a0 = _mm_and_si128(_mm_srl_epi32(_mm_load_si128(pixels + 0), shift), byteMask);
+    __m128i a1 = _mm_and_si128(_mm_srl_epi32(_mm_load_si128(pixels + 1), shift), byteMask);
+    __m128i a2 = _mm_and_si128(_mm_srl_epi32(_mm_load_si128(pixels + 2), shift), byteMask);
+    __m128i a3 = _mm_and_si128(_mm_srl_epi32(_mm_load_si128(pixels + 3), shift), byteMask);
+    __m128i alphas = _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3));
+
+    // count the thresholds below each alpha, -1 per threshold
+    __m128i count = _mm_setzero_si128();
+    for (int i = 0; i < 7; i++) {
+        __m128i threshold = _mm_set1_epi8((char)ab[i]);
+        count = _mm_add_epi8(count, _mm_cmpeq_epi8(_mm_max_epu8(alphas, threshold), alphas));
     }
+
+    __m128i indexes = _mm_and_si128(_mm_add_epi8(count, _mm_set1_epi8(8)), _mm_set1_epi8(7));
+    indexes = _mm_xor_si128(indexes, _mm_and_si128(_mm_cmplt_epi8(indexes, _mm_set1_epi8(2)), _mm_set1_epi8(1)));
+
+    // pack 3 bit indexes, 8 pixels in each 64 bits half
+    indexes = _mm_and_si128(_mm_or_si128(indexes, _mm_srli_epi16(indexes, 8 - 3)), _mm_set1_epi16(0x003F));
+    indexes = _mm_and_si128(_mm_or_si128(indexes, _mm_srli_epi32(indexes, 16 - 6)), _mm_set1_epi32(0x0FFF));
+    indexes = _mm_and_si128(_mm_or_si128(indexes, _mm_srli_epi64(indexes, 32 - 12)), _mm_set_epi32(0, 0xFFFFFF, 0, 0xFFFFFF));
+
+    uint32_t lo = (uint32_t)_mm_cvtsi128_si32(indexes);
+    uint32_t hi = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(indexes, 8));
+
+    out[0] = byte(lo);
+    out[1] = byte(lo >> 8);
+    out[2] = byte(lo >> 16);
+
+    out[3] = byte(hi);
+    out[4] = byte(hi >> 8);
+    out[5] = byte(hi >> 16);
 }
 
-void DXTEncoder::CompressImageDXT1HQ(const byte *src, const int width, const int height, const int depth, byte *dst) {
-    ALIGN16(byte colorBlock[4 * 16]);
-    byte *dstPtr = dst;
+void DXTEncoder::ComputeColorIndicesFastSSE2(const byte *colorBlock, const byte *maxColor, const byte *minColor, uint32_t *out) {
+    int colors[4][3];
 
-    for (int z = 0; z < depth; z++) {
-        for (int y = 0; y < height; y += 4, src += width * 4 * 4) {
-            for (int x = 0; x < width; x += 4) {
-                int bw = Min(4, width - x);
-                int bh = Min(4, height - y);
+    colors[0][0] = (maxColor[0] & C565_5_MASK) | (maxColor[0] >> 5);
+    colors[0][1] = (maxColor[1] & C565_6_MASK) | (maxColor[1] >> 6);
+    colors[0][2] = (maxColor[2] & C565_5_MASK) | (maxColor[2] >> 5);
+    colors[1][0] = (minColor[0] & C565_5_MASK) | (minColor[0] >> 5);
+    colors[1][1] = (minColor[1] & C565_6_MASK) | (minColor[1] >> 6);
+    colors[1][2] = (minColor[2] & C565_5_MASK) | (minColor[2] >> 5);
+    colors[2][0] = (2 * colors[0][0] + 1 * colors[1][0]) / 3;
+    colors[2][1] = (2 * colors[0][1] + 1 * colors[1][1]) / 3;
+    colors[2][2] = (2 * colors[0][2] + 1 * colors[1][2]) / 3;
+    colors[3][0] = (1 * colors[0][0] + 2 * colors[1][0]) / 3;
+    colors[3][1] = (1 * colors[0][1] + 2 * colors[1][1]) / 3;
+    colors[3][2] = (1 * colors[0][2] + 2 * colors[1][2]) / 3;
 
-                ExtractBlock(src + 4 * x, 4 * width, bw, bh, colorBlock);
+    __m128i palette[4];
+    for (int i = 0; i < 4; i++) {
+        palette[i] = _mm_set1_epi32(colors[i][0] | (colors[i][1] << 8) | (colors[i][2] << 16));
+    }
 
-                EncodeDXT1BlockHQ(colorBlock, &dstPtr);
-            }
+    const __m128i *pixels = (const __m128i *)colorBlock;
+    const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    __m128i indexes[4];
+
+    // uses sum of absolute differences instead of squared distance to find the best match, 4 pixels at a time
+    for (int i = 0; i < 4; i++) {
+        __m128i c = _mm_and_si128(_mm_load_si128(pixels + i), rgbMask);
+        __m128i d[4];
+
+        for (int j = 0; j < 4; j++) {
+            __m128i diff = _mm_or_si128(_mm_subs_epu8(c, palette[j]), _mm_subs_epu8(palette[j], c));
+            d[j] = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(diff, byteMask), _mm_and_si128(_mm_srli_epi32(diff, 8), byteMask)), _mm_srli_epi32(diff, 16));
         }
+
+        __m128i b0 = _mm_cmpgt_epi32(d[0], d[3]);
+        __m128i b1 = _mm_cmpgt_epi32(d[1], d[2]);
+        __m128i b2 = _mm_cmpgt_epi32(d[0], d[2]);
+        __m128i b3 = _mm_cmpgt_epi32(d[1], d[3]);
+        __m128i b4 = _mm_cmpgt_epi32(d[2], d[3]);
+
+        __m128i x0 = _mm_and_si128(b1, b2);
+        __m128i x1 = _mm_and_si128(b0, b3);
+        __m128i x2 = _mm_and_si128(b0, b4);
+
+        indexes[i] = _mm_or_si128(_mm_and_si128(x2, one), _mm_and_si128(_mm_or_si128(x0, x1), two));
     }
+
+    // pack 2 bit indexes, 8 pixels in each 64 bits half
+    __m128i packed = _mm_packus_epi16(_mm_packs_epi32(indexes[0], indexes[1]), _mm_packs_epi32(indexes[2], indexes[3]));
+    packed = _mm_and_si128(_mm_or_si128(packed, _mm_srli_epi16(packed, 8 - 2)), _mm_set1_epi16(0x000F));
+    packed = _mm_and_si128(_mm_or_si128(packed, _mm_srli_epi32(packed, 16 - 4)), _mm_set1_epi32(0x00FF));
+    packed = _mm_and_si128(_mm_or_si128(packed, _mm_srli_epi64(packed, 32 - 8)), _mm_set_epi32(0, 0xFFFF, 0, 0xFFFF));
+
+    *out = (uint32_t)_mm_cvtsi128_si32(packed) | ((uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(packed, 8)) << 16);
 }
 
-void DXTEncoder::CompressImageDXT3Fast(const byte *src, const int width, const int height, const int depth, byte *dst) {
-    ALIGN16(byte colorBlock[4 * 16]);
-    byte *dstPtr = dst;
+void DXTEncoder::EncodeDXT1BlockFastSSE2(const byte *colorBlock, byte **dstPtr) {
+    ALIGN16(byte minColor[4]);
+    ALIGN16(byte maxColor[4]);
+    ALIGN16(DXTBlock::ColorBlock dxtColorBlock);
 
-    for (int z = 0; z < depth; z++) {
-        for (int y = 0; y < height; y += 4, src += width * 4 * 4) {
-            for (int x = 0; x < width; x += 4) {
-                int bw = Min(4, width - x);
-                int bh = Min(4, height - y);
+    GetMinMaxBBoxSSE2(colorBlock, minColor, maxColor);
+    InsetColorsBBoxSSE2(minColor, maxColor);
 
-                ExtractBlock(src + 4 * x, 4 * width, bw, bh, colorBlock);
+    dxtColorBlock.color0 = RGB888To565(maxColor);
+    dxtColorBlock.color1 = RGB888To565(minColor);
 
-                EncodeDXT3BlockFast(colorBlock, &dstPtr);
-            }
-        }
-    }
+    ComputeColorIndicesFastSSE2(colorBlock, maxColor, minColor, &dxtColorBlock.indexes);
+
+    memcpy(*dstPtr, &dxtColorBlock, sizeof(dxtColorBlock));
+    *dstPtr += sizeof(dxtColorBlock);
 }
 
-void DXTEncoder::CompressImageDXT3HQ(const byte *src, const int width, const int height, const int depth, byte *dst) {
-    ALIGN16(byte colorBlock[4 * 16]);
-    byte *dstPtr = dst;
+void DXTEncoder::EncodeDXT3BlockFastSSE2(const byte *colorBlock, byte **dstPtr) {
+    ALIGN16(byte minColor[4]);
+    ALIGN16(byte maxColor[4]);
+    ALIGN16(DXTBlock::ColorBlock dxtColorBlock);
+    ALIGN16(DXTBlock::AlphaExplicitBlock dxtAlphaBlock);
 
-    for (int z = 0; z < depth; z++) {
-        for (int y = 0; y < height; y += 4, src += width * 4 * 4) {
-            for (int x = 0; x < width; x += 4) {
-                int bw = Min(4, width - x);
-                int bh = Min(4, height - y);
+    GetMinMaxBBoxSSE2(colorBlock, minColor, maxColor);
+    InsetColorsBBoxSSE2(minColor, maxColor);
 
-                ExtractBlock(src + 4 * x, 4 * width, bw, bh, colorBlock);
+    Compute4BitsAlpha(colorBlock, 3, dxtAlphaBlock.row);
 
-                EncodeDXT3BlockHQ(colorBlock, &dstPtr);
-            }
-        }
+    memcpy(*dstPtr, &dxtAlphaBlock, sizeof(dxtAlphaBlock));
+    *dstPtr += sizeof(dxtAlphaBlock);
+
+    dxtColorBlock.color0 = RGB888To565(maxColor);
+    dxtColorBlock.color1 = RGB888To565(minColor);
+
+    ComputeColorIndicesFastSSE2(colorBlock, maxColor, minColor, &dxtColorBlock.indexes);
+
+    memcpy(*dstPtr, &dxtColorBlock, sizeof(dxtColorBlock));
+    *dstPtr += sizeof(dxtColorBlock);
+}
+
+void DXTEncoder::EncodeDXT5BlockFastSSE2(const byte *colorBlock, byte **dstPtr) {
+    ALIGN16(byte minColor[4]);
+    ALIGN16(byte maxColor[4]);
+    ALIGN16(DXTBlock::ColorBlock dxtColorBlock);
+    ALIGN16(DXTBlock::AlphaBlock dxtAlphaBlock);
+
+    GetMinMaxBBoxSSE2(colorBlock, minColor, maxColor);
+    InsetColorsBBoxSSE2(minColor, maxColor);
+
+    dxtAlphaBlock.alpha0 = maxColor[3];
+    dxtAlphaBlock.alpha1 = minColor[3];
+
+    ComputeAlphaIndicesFastSSE2(colorBlock, 3, maxColor[3], minColor[3], dxtAlphaBlock.indexes);
+
+    memcpy(*dstPtr, &dxtAlphaBlock, sizeof(dxtAlphaBlock));
+    *dstPtr += sizeof(dxtAlphaBlock);
+
+    dxtColorBlock.color0 = RGB888To565(maxColor);
+    dxtColorBlock.color1 = RGB888To565(minColor);
+
+    ComputeColorIndicesFastSSE2(colorBlock, maxColor, minColor, &dxtColorBlock.indexes);
+
+    memcpy(*dstPtr, &dxtColorBlock, sizeof(dxtColorBlock));
+    *dstPtr += sizeof(dxtColorBlock);
+}
+
+void DXTEncoder::EncodeDXN2BlockFastSSE2(const byte *colorBlock, byte **dstPtr) {
+    ALIGN16(byte minNormal[4]);
+    ALIGN16(byte maxNormal[4]);
+    ALIGN16(DXTBlock::AlphaBlock dxtAlphaBlock);
+
+    GetMinMaxBBoxSSE2(colorBlock, minNormal, maxNormal);
+    InsetNormalsBBox3Dc(minNormal, maxNormal);
+
+    for (int i = 0; i < 2; i++) {
+        dxtAlphaBlock.alpha0 = maxNormal[i];
+        dxtAlphaBlock.alpha1 = minNormal[i];
+
+        ComputeAlphaIndicesFastSSE2(colorBlock, i, maxNormal[i], minNormal[i], dxtAlphaBlock.indexes);
+
+        memcpy(*dstPtr, &dxtAlphaBlock, sizeof(dxtAlphaBlock));
+        *dstPtr += sizeof(dxtAlphaBlock);
     }
 }
 
-void DXTEncoder::CompressImageDXT5Fast(const byte *src, const int width, const int height, const int depth, byte *dst) {
-    ALIGN16(byte colorBlock[4 * 16]);
-    byte *dstPtr = dst;
+#endif // defined(__X86__)
 
-    for (int z = 0; z < depth; z++) {
-        for (int y = 0; y < height; y += 4, src += width * 4 * 4) {
-            for (int x = 0; x < width; x += 4) {
-                int bw = Min(4, width - x);
-                int bh = Min(4, height - y);
+BE_INLINE void DXTEncoder::ExtractBlock(const byte *src, int srcPitch, int blockWidth, int blockHeight, byte *colorBlock) {
+    for (int by = 0; by < 4; by++) {
+        const byte *srcPtrY = src + srcPitch * (by % blockHeight);
 
-                ExtractBlock(src + 4 * x, 4 * width, bw, bh, colorBlock);
+        for (int bx = 0; bx < 4; bx++) {
+            const byte *srcPtrX = srcPtrY + 4 * (bx % blockWidth);
 
-                EncodeDXT5BlockFast(colorBlock, &dstPtr);
+            for (int i = 0; i < 4; i++) {
+                *colorBlock++ = srcPtrX[i];
             }
         }
     }
 }
 
-void DXTEncoder::CompressImageDXT5HQ(const byte *src, const int width, const int height, const int depth, byte *dst) {
-    ALIGN16(byte colorBlock[4 * 16]);
-    byte *dstPtr = dst;
+template <typename EncodeBlockFunc>
+void DXTEncoder::CompressImage(const byte *src, const int width, const int height, const int depth, byte *dst, const int blockSize, const int flags, const EncodeBlockFunc &encodeBlock) {
+    const int numBlocksX = (width + 3) / 4;
+    const int numBlocksY = (height + 3) / 4;
+    const int numRows = numBlocksY * depth;
+
+    // Each row of blocks is written at a fixed offset, so rows can be encoded in any order
+    auto compressRows = [&](int firstRow, int lastRow) {
+        ALIGN16(byte colorBlock[4 * 16]);
+
+        for (int row = firstRow; row < lastRow; row++) {
+            const int z = row / numBlocksY;
+            const int y = (row % numBlocksY) * 4;
+            const int bh = Min(4, height - y);
+            const byte *srcRow = src + ((size_t)z * height + y) * width * 4;
+            byte *dstPtr = dst + (size_t)row * numBlocksX * blockSize;
 
-    for (int z = 0; z < depth; z++) {
-        for (int y = 0; y < height; y += 4, src += width * 4 * 4) {
             for (int x = 0; x < width; x += 4) {
                 int bw = Min(4, width - x);
-                int bh = Min(4, height - y);
 
-                ExtractBlock(src + 4 * x, 4 * width, bw, bh, colorBlock);
+                ExtractBlock(srcRow + 4 * x, 4 * width, bw, bh, colorBlock);
 
-                EncodeDXT5BlockHQ(colorBlock, &dstPtr);
+                encodeBlock(colorBlock, &dstPtr);
             }
         }
+    };
+
+    if (flags & Flag::SingleThread) {
+        compressRows(0, numRows);
+    } else {
+        jobSystem.ParallelFor(numRows, Max(MIN_BLOCKS_PER_JOB / numBlocksX, 1), compressRows);
     }
 }
 
-void DXTEncoder::CompressImageDXN2Fast(const byte *src, const int width, const int height, const int depth, byte *dst) {
-    ALIGN16(byte colorBlock[4 * 16]);
-    byte *dstPtr = dst;
+void DXTEncoder::CompressImageDXT1Fast(const byte *src, const int width, const int height, const int depth, byte *dst, int flags) {
+#if defined(__X86__)
+    if (!(flags & Flag::NoSIMD)) {
+        CompressImage(src, width, height, depth, dst, sizeof(DXTBlock::ColorBlock), flags, EncodeDXT1BlockFastSSE2);
+        return;
+    }
+#endif
+    CompressImage(src, width, height, depth, dst, sizeof(DXTBlock::ColorBlock), flags, EncodeDXT1BlockFast);
+}
 
-    for (int z = 0; z < depth; z++) {
-        for (int y = 0; y < height; y += 4, src += width * 4 * 4) {
-            for (int x = 0; x < width; x += 4) {
-                int bw = Min(4, width - x);
-                int bh = Min(4, height - y);
+void DXTEncoder::CompressImageDXT1HQ(const byte *src, const int width, const int height, const int depth, byte *dst, int flags) {
+    const bool refine = !(flags & Flag::NoRefinement);
 
-                ExtractBlock(src + 4 * x, 4 * width, bw, bh, colorBlock);
+    CompressImage(src, width, height, depth, dst, sizeof(DXTBlock::ColorBlock), flags, [refine](const byte *colorBlock, byte **dstPtr) {
+        EncodeDXT1BlockHQ(colorBlock, dstPtr, refine);
+    });
+}
 
-                EncodeDXN2BlockFast(colorBlock, &dstPtr);
-            }
-        }
+void DXTEncoder::CompressImageDXT3Fast(const byte *src, const int width, const int height, const int depth, byte *dst, int flags) {
+    const int blockSize = sizeof(DXTBlock::AlphaExplicitBlock) + sizeof(DXTBlock::ColorBlock);
+#if defined(__X86__)
+    if (!(flags & Flag::NoSIMD)) {
+        CompressImage(src, width, height, depth, dst, blockSize, flags, EncodeDXT3BlockFastSSE2);
+        return;
     }
+#endif
+    CompressImage(src, width, height, depth, dst, blockSize, flags, EncodeDXT3BlockFast);
 }
 
-void DXTEncoder::CompressImageDXN2HQ(const byte *src, const int width, const int height, const int depth, byte *dst) {
-    ALIGN16(byte colorBlock[4 * 16]);
-    byte *dstPtr = dst;
+void DXTEncoder::CompressImageDXT3HQ(const byte *src, const int width, const int height, const int depth, byte *dst, int flags) {
+    const int blockSize = sizeof(DXTBlock::AlphaExplicitBlock) + sizeof(DXTBlock::ColorBlock);
+    const bool refine = !(flags & Flag::NoRefinement);
 
-    for (int z = 0; z < depth; z++) {
-        for (int y = 0; y < height; y += 4, src += width * 4 * 4) {
-            for (int x = 0; x < width; x += 4) {
-                int bw = Min(4, width - x);
-                int bh = Min(4, height - y);
+    CompressImage(src, width, height, depth, dst, blockSize, flags, [refine](const byte *colorBlock, byte **dstPtr) {
+        EncodeDXT3BlockHQ(colorBlock, dstPtr, refine);
+    });
+}
 
-                ExtractBlock(src + 4 * x, 4 * width, bw, bh, colorBlock);
+void DXTEncoder::CompressImageDXT5Fast(const byte *src, const int width, const int height, const int depth, byte *dst, int flags) {
+    const int blockSize = sizeof(DXTBlock::AlphaBlock) + sizeof(DXTBlock::ColorBlock);
+#if defined(__X86__)
+    if (!(flags & Flag::NoSIMD)) {
+        CompressImage(src, width, height, depth, dst, blockSize, flags, EncodeDXT5BlockFastSSE2);
+        return;
+    }
+#endif
+    CompressImage(src, width, height, depth, dst, blockSize, flags, EncodeDXT5BlockFast);
+}
 
-                EncodeDXN2BlockHQ(colorBlock, &dstPtr);
-            }
-        }
+void DXTEncoder::CompressImageDXT5HQ(const byte *src, const int width, const int height, const int depth, byte *dst, int flags) {
+    const int blockSize = sizeof(DXTBlock::AlphaBlock) + sizeof(DXTBlock::ColorBlock);
+    const bool refine = !(flags & Flag::NoRefinement);
+
+    CompressImage(src, width, height, depth, dst, blockSize, flags, [refine](const byte *colorBlock, byte **dstPtr) {
+        EncodeDXT5BlockHQ(colorBlock, dstPtr, refine);
+    });
+}
+
+void DXTEncoder::CompressImageDXN2Fast(const byte *src, const int width, const int height, const int depth, byte *dst, int flags) {
+    const int blockSize = sizeof(DXTBlock::AlphaBlock) * 2;
+#if defined(__X86__)
+    if (!(flags & Flag::NoSIMD)) {
+        CompressImage(src, width, height, depth, dst, blockSize, flags, EncodeDXN2BlockFastSSE2);
+        return;
     }
+#endif
+    CompressImage(src, width, height, depth, dst, blockSize, flags, EncodeDXN2BlockFast);
+}
+
+void DXTEncoder::CompressImageDXN2HQ(const byte *src, const int width, const int height, const int depth, byte *dst, int flags) {
+    const int blockSize = sizeof(DXTBlock::AlphaBlock) * 2;
+
+    CompressImage(src, width, height, depth, dst, blockSize, flags, EncodeDXN2BlockHQ);
 }
 
 BE_NAMESPACE_END
@@ -26,10 +26,13 @@ bool Image::Load(const char *filename) {
         return false;
     }
 
+    MemTagScope memTagScope(MemTag::Image);
+
     Str name = filename;
 
-    byte *data;
-    size_t size = fileSystem.LoadFile(name, true, (void **)&data);
+    // Stored entries of zip archives are decoded straight from the mapping
+    const byte *data;
+    size_t size = fileSystem.MapFile(name, true, (const void **)&data);
     if (data) {
         // 확장자에 맞춰서 로딩함수 call
         if (name.CheckExtension(".btex")) {
@@ -52,7 +55,7 @@ bool Image::Load(const char *filename) {
             LoadHDRFromMemory(name, data, size);
         }
 
-        fileSystem.FreeFile(data);
+        fileSystem.UnmapFile(data);
 
         if (pic) {
             return true;
@@ -66,7 +69,7 @@ bool Image::Load(const char *filename) {
     for (int i = 0; i < COUNT_OF(extensions); i++) {
         Str name2 = name + extensions[i];
 
-        size_t size = fileSystem.LoadFile(name2, true, (void **)&data);
+        size_t size = fileSystem.MapFile(name2, true, (const void **)&data);
         if (data) {
             if (name2.CheckExtension(".dds")) {
                 LoadDDSFromMemory(name2, data, size);
@@ -86,7 +89,7 @@ bool Image::Load(const char *filename) {
                 LoadHDRFromMemory(name2, data, size);
             }
 
-            fileSystem.FreeFile(data);
+            fileSystem.UnmapFile(data);
 
             if (pic) {
                 return true;
@@ -98,6 +101,135 @@ bool Image::Load(const char *filename) {
     return false;
 }
 
+static BE_INLINE uint32_t ReadLE16(const byte *ptr) { return ptr[0] | (ptr[1] << 8); }
+static BE_INLINE uint32_t ReadLE32(const byte *ptr) { return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t)ptr[3] << 24); }
+static BE_INLINE uint32_t ReadBE16(const byte *ptr) { return (ptr[0] << 8) | ptr[1]; }
+static BE_INLINE uint32_t ReadBE32(const byte *ptr) { return ((uint32_t)ptr[0] << 24) | (ptr[1] << 16) | (ptr[2] << 8) | ptr[3]; }
+
+// Finds the frame header of JPEG by walking the marker segments.
+static bool ReadJPGDimensions(const byte *data, size_t size, int *width, int *height) {
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        return false;
+    }
+
+    size_t offset = 2;
+    while (offset + 4 <= size) {
+        if (data[offset] != 0xFF) {
+            return false;
+        }
+        byte marker = data[offset + 1];
+        if (marker == 0xFF) {
+            // Fill byte
+            offset++;
+            continue;
+        }
+        // SOF0-SOF15 except DHT, JPG and DAC
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (offset + 9 > size) {
+                return false;
+            }
+            *height = ReadBE16(data + offset + 5);
+            *width = ReadBE16(data + offset + 7);
+            return true;
+        }
+        offset += 2 + ReadBE16(data + offset + 2);
+    }
+    return false;
+}
+
+// Parses "-Y <height> +X <width>" resolution string after the header lines of Radiance HDR.
+static bool ReadHDRDimensions(const byte *data, size_t size, int *width, int *height) {
+    for (size_t offset = 0; offset + 1 < size; offset++) {
+        if (data[offset] == '\n' && data[offset + 1] == '\n') {
+            char resolution[64];
+            size_t length = Min(size - (offset + 2), sizeof(resolution) - 1);
+            memcpy(resolution, data + offset + 2, length);
+            resolution[length] = 0;
+            return sscanf(resolution, "-Y %i +X %i", height, width) == 2;
+        }
+    }
+    return false;
+}
+
+bool Image::LoadDimensions(const char *filename, int *width, int *height) {
+    // Enough for the headers, JPEG files with larger metadata in front of the frame header are not parsed
+    static const size_t maxHeaderSize = 64 * 1024;
+
+    Str name = filename;
+
+    File *fp = fileSystem.OpenFileRead(name, true);
+    if (!fp) {
+        return false;
+    }
+
+    size_t size = Min(fp->Size(), maxHeaderSize);
+    byte *data = (byte *)Mem_Alloc(size);
+    size = fp->Read(data, size);
+    fileSystem.CloseFile(fp);
+
+    int w = 0;
+    int h = 0;
+    bool ok = false;
+
+    if (name.CheckExtension(".dds")) {
+        // Magic followed by DdsFileHeader
+        if (size >= 128 && ReadLE32(data) == MAKE_FOURCC('D', 'D', 'S', ' ')) {
+            h = ReadLE32(data + 12);
+            w = ReadLE32(data + 16);
+            ok = true;
+        }
+    } else if (name.CheckExtension(".pvr")) {
+        if (size >= 52 && ReadLE32(data) == MAKE_FOURCC('P', 'V', 'R', 3)) {
+            h = ReadLE32(data + 24);
+            w = ReadLE32(data + 28);
+            ok = true;
+        } else if (size >= 52 && ReadLE32(data + 44) == MAKE_FOURCC('P', 'V', 'R', '!')) {
+            h = ReadLE32(data + 4);
+            w = ReadLE32(data + 8);
+            ok = true;
+        }
+    } else if (name.CheckExtension(".tga")) {
+        if (size >= 18) {
+            w = ReadLE16(data + 12);
+            h = ReadLE16(data + 14);
+            ok = true;
+        }
+    } else if (name.CheckExtension(".jpg")) {
+        ok = ReadJPGDimensions(data, size, &w, &h);
+    } else if (name.CheckExtension(".png")) {
+        // Signature followed by IHDR chunk
+        if (size >= 24 && ReadBE32(data) == 0x89504E47 && ReadBE32(data + 12) == 0x49484452) {
+            w = ReadBE32(data + 16);
+            h = ReadBE32(data + 20);
+            ok = true;
+        }
+    } else if (name.CheckExtension(".bmp")) {
+        if (size >= 26 && data[0] == 'B' && data[1] == 'M') {
+            w = (int32_t)ReadLE32(data + 18);
+            h = Math::Abs((int32_t)ReadLE32(data + 22));
+            ok = true;
+        }
+    } else if (name.CheckExtension(".pcx")) {
+        if (size >= 128 && data[0] == 0x0A) {
+            w = ReadLE16(data + 8) - ReadLE16(data + 4) + 1;
+            h = ReadLE16(data + 10) - ReadLE16(data + 6) + 1;
+            ok = true;
+        }
+    } else if (name.CheckExtension(".hdr")) {
+        ok = ReadHDRDimensions(data, size, &w, &h);
+    }
+
+    Mem_Free(data);
+
+    if (!ok || w <= 0 || h <= 0) {
+        return false;
+    }
+
+    *width = w;
+    *height = h;
+    return true;
+}
+
 bool Image::Write(const char *filename) const {
     if (!filename || filename[0] == 0) {
         return false;
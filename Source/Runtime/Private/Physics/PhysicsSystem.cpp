@@ -35,7 +35,20 @@ static bool CustomMaterialCombinerCallback(btManifoldPoint &cp, const btCollisio
     return false;
 }
 
+static void *PhysicsAlloc(size_t size) {
+    MemTagScope memTagScope(MemTag::Physics);
+    return Mem_Alloc(size);
+}
+
+static void PhysicsFree(void *ptr) {
+    Mem_Free(ptr);
+}
+
 void PhysicsSystem::Init() {
+    // Account Bullet allocations to the physics memory tag.
+    // Must be set before any Bullet objects are allocated.
+    btAlignedAllocSetCustom(PhysicsAlloc, PhysicsFree);
+
     gContactAddedCallback = CustomMaterialCombinerCallback;
 
     emptyShape = new btEmptyShape;
@@ -71,6 +71,10 @@ const wchar_t *PlatformBaseProcess::UserName() {
     return L"";
 }
 
+int PlatformBaseProcess::NumberOfLogicalProcessors() {
+    return 1;
+}
+
 ProcessHandle PlatformBaseProcess::CreateProccess(const wchar_t *appPath, const wchar_t *args, const wchar_t *workingPath) {
     return ProcessHandle();
 }
@@ -16,6 +16,10 @@
 #include "Core/WStr.h"
 #include "Platform/PlatformSystem.h"
 #include "Platform/PlatformFile.h"
+#if defined(__UNIX__)
+#include <unwind.h>
+#include <dlfcn.h>
+#endif
 
 BE_NAMESPACE_BEGIN
 
@@ -41,4 +45,66 @@ const char *PlatformBaseSystem::UserTempDir() {
     return PlatformFile::ExecutablePath();
 }
 
+#if defined(__UNIX__)
+
+struct UnwindState {
+    void **                 frames;
+    int32_t                 maxFrames;
+    int32_t                 skipFrames;
+    int32_t                 numFrames;
+};
+
+static _Unwind_Reason_Code UnwindCallback(struct _Unwind_Context *context, void *arg) {
+    UnwindState *state = (UnwindState *)arg;
+    uintptr_t pc = _Unwind_GetIP(context);
+    if (pc) {
+        if (state->skipFrames > 0) {
+            state->skipFrames--;
+        } else {
+            state->frames[state->numFrames++] = (void *)pc;
+            if (state->numFrames == state->maxFrames) {
+                return _URC_END_OF_STACK;
+            }
+        }
+    }
+    return _URC_NO_REASON;
+}
+
+int32_t PlatformBaseSystem::CaptureCallStack(void **frames, int32_t maxFrames, int32_t skipFrames) {
+    if (maxFrames <= 0) {
+        return 0;
+    }
+    // Skip this function too
+    UnwindState state = { frames, maxFrames, skipFrames + 1, 0 };
+    _Unwind_Backtrace(UnwindCallback, &state);
+    return state.numFrames;
+}
+
+void PlatformBaseSystem::AddressToSymbol(const void *address, char *symbol, uint32_t symbolLength) {
+    Dl_info info;
+    if (dladdr(address, &info) && info.dli_fname) {
+        const char *moduleName = strrchr(info.dli_fname, '/');
+        moduleName = moduleName ? moduleName + 1 : info.dli_fname;
+        if (info.dli_sname) {
+            snprintf(symbol, symbolLength, "%s!%s+0x%lx", moduleName, info.dli_sname, (unsigned long)((const byte *)address - (const byte *)info.dli_saddr));
+        } else {
+            snprintf(symbol, symbolLength, "%s+0x%lx", moduleName, (unsigned long)((const byte *)address - (const byte *)info.dli_fbase));
+        }
+    } else {
+        snprintf(symbol, symbolLength, "0x%p", address);
+    }
+}
+
+#else
+
+int32_t PlatformBaseSystem::CaptureCallStack(void **frames, int32_t maxFrames, int32_t skipFrames) {
+    return 0;
+}
+
+void PlatformBaseSystem::AddressToSymbol(const void *address, char *symbol, uint32_t symbolLength) {
+    snprintf(symbol, symbolLength, "0x%p", address);
+}
+
+#endif
+
 BE_NAMESPACE_END
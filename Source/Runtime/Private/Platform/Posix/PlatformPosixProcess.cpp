@@ -54,6 +54,12 @@ void PlatformPosixProcess::CloseLibrary(SharedLib lib) {
     }
 }
 
+// return the number of logical threads of the system
+int PlatformPosixProcess::NumberOfLogicalProcessors() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
 void PlatformPosixProcess::Sleep(float seconds) {
     const uint32_t usec = seconds * 1000000.0f;
     if (usec > 0) {
@@ -39,11 +39,13 @@ static void SetAffinity(int affinity) {
 #else
 
 static void SetAffinity(int affinity) {
-    cpu_set_t cset;
-    CPU_ZERO(&cset);
-    CPU_SET(affinity, &cset);
-    if (pthread_setaffinity_np(pthread_self(), sizeof(cset), &cset) != 0) {
-        std::cerr << "Thread: cannot set affinity" << std::endl;
+    if (affinity >= 0) {
+        cpu_set_t cset;
+        CPU_ZERO(&cset);
+        CPU_SET(affinity, &cset);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cset), &cset) != 0) {
+            std::cerr << "Thread: cannot set affinity" << std::endl;
+        }
     }
 }
 
@@ -195,6 +197,10 @@ bool PlatformPosixCondition::TimedWait(const PlatformPosixCondition *posixCondit
     return true;
 }
 
+void PlatformPosixCondition::Signal(const PlatformPosixCondition *posixCondition) {
+    pthread_cond_signal(posixCondition->cond);
+}
+
 void PlatformPosixCondition::Broadcast(const PlatformPosixCondition *posixCondition) {
     pthread_cond_broadcast(posixCondition->cond);
 }
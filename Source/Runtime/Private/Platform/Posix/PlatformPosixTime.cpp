@@ -52,7 +52,10 @@ uint32_t PlatformPosixTime::Milliseconds() {
 }
 
 uint64_t PlatformPosixTime::Microseconds() {
-    return (uint64_t)(PlatformPosixTime::Seconds() * 1000000.0f);
+    // Don't go through Seconds(), float can't hold microseconds since the epoch
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (((uint64_t)tv.tv_sec) * 1000000ULL) + (((uint64_t)tv.tv_usec));
 }
 
 uint64_t PlatformPosixTime::Cycles() {
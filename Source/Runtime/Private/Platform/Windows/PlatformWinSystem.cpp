@@ -89,6 +89,29 @@ const char *PlatformWinSystem::UserTempDir() {
     return path;
 }
 
+int32_t PlatformWinSystem::CaptureCallStack(void **frames, int32_t maxFrames, int32_t skipFrames) {
+    if (maxFrames <= 0) {
+        return 0;
+    }
+    // Skip this function too
+    return (int32_t)::RtlCaptureStackBackTrace(skipFrames + 1, maxFrames, frames, nullptr);
+}
+
+void PlatformWinSystem::AddressToSymbol(const void *address, char *symbol, uint32_t symbolLength) {
+    HMODULE module = nullptr;
+    char modulePath[MAX_PATH];
+
+    if (::GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, (LPCSTR)address, &module) &&
+        ::GetModuleFileNameA(module, modulePath, COUNT_OF(modulePath))) {
+        const char *moduleName = strrchr(modulePath, '\\');
+        moduleName = moduleName ? moduleName + 1 : modulePath;
+        // Resolve module+offset with the PDB of the module
+        _snprintf_s(symbol, symbolLength, _TRUNCATE, "%s+0x%Ix", moduleName, (size_t)((const byte *)address - (const byte *)module));
+    } else {
+        _snprintf_s(symbol, symbolLength, _TRUNCATE, "0x%p", address);
+    }
+}
+
 int32_t PlatformWinSystem::NumCPUCores() {
     static int32_t numCores = 0;
     if (numCores == 0) {
@@ -0,0 +1,261 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Precompiled.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+
+BE_NAMESPACE_BEGIN
+
+RHI::Handle NullRHI::CreateBuffer(BufferType type, BufferUsage usage, int size, int pitch, const void *data) {
+    NullRHIBuffer *buffer = new NullRHIBuffer;
+    memset(buffer, 0, sizeof(*buffer));
+    buffer->type = type;
+    buffer->usage = usage;
+    buffer->size = size;
+    buffer->pitch = pitch;
+    buffer->bindingIndex = -1;
+
+    if (size > 0) {
+        buffer->data = (byte *)Mem_Alloc16(size);
+        if (data) {
+            memcpy(buffer->data, data, size);
+            frameStats.bufferUploadBytes += size;
+        }
+    }
+
+    int handle = bufferList.FindNull();
+    if (handle == -1) {
+        handle = bufferList.Append(buffer);
+    } else {
+        bufferList[handle] = buffer;
+    }
+
+    memoryStats.numBuffers++;
+    memoryStats.bufferBytes += size;
+
+    NULLRHI_RECORD(NullRHICmd_CreateBuffer, handle, type, usage, size, pitch, data ? 1 : 0);
+
+    return (Handle)handle;
+}
+
+void NullRHI::DestroyBuffer(Handle bufferHandle) {
+    NULLRHI_RECORD(NullRHICmd_DestroyBuffer, bufferHandle);
+
+    NullRHIBuffer *buffer = bufferList[bufferHandle];
+
+    for (int i = 0; i < COUNT_OF(currentContext->state->bufferHandles); i++) {
+        if (bufferHandle == currentContext->state->bufferHandles[i]) {
+            currentContext->state->bufferHandles[i] = NullBuffer;
+            break;
+        }
+    }
+
+    memoryStats.numBuffers--;
+    memoryStats.bufferBytes -= buffer->size;
+
+    Mem_AlignedFree(buffer->data);
+
+    delete buffer;
+    bufferList[bufferHandle] = nullptr;
+}
+
+void NullRHI::BindBuffer(BufferType type, Handle bufferHandle) {
+    Handle *bufferHandlePtr = &currentContext->state->bufferHandles[type];
+    if (*bufferHandlePtr != bufferHandle) {
+        NULLRHI_RECORD(NullRHICmd_BindBuffer, type, bufferHandle);
+
+        *bufferHandlePtr = bufferHandle;
+        frameStats.numBufferChanges++;
+    }
+}
+
+void NullRHI::BindIndexedBuffer(BufferType type, int bindingIndex, Handle bufferHandle) {
+    NullRHIBuffer *buffer = bufferList[bufferHandle];
+    BindIndexedBufferRange(type, bindingIndex, bufferHandle, 0, buffer->size);
+}
+
+void NullRHI::BindIndexedBufferRange(BufferType type, int bindingIndex, Handle bufferHandle, int offset, int size) {
+    // Allowed only target UniformBuffer or TransformFeedbackBuffer
+    assert(type == UniformBuffer || type == TransformFeedbackBuffer);
+    int targetIndex = type - UniformBuffer;
+    Handle *bufferHandlePtr = &currentContext->state->indexedBufferHandles[targetIndex];
+    NullRHIBuffer *buffer = bufferList[bufferHandle];
+    if (*bufferHandlePtr != bufferHandle || buffer->bindingIndex != bindingIndex || buffer->bindingOffset != offset || buffer->bindingSize != size) {
+        NULLRHI_RECORD(NullRHICmd_BindIndexedBufferRange, type, bindingIndex, bufferHandle, offset, size);
+
+        *bufferHandlePtr = bufferHandle;
+        buffer->bindingIndex = bindingIndex;
+        buffer->bindingOffset = offset;
+        buffer->bindingSize = size;
+        frameStats.numBufferChanges++;
+    }
+}
+
+void *NullRHI::MapBufferRange(Handle bufferHandle, BufferLockMode lockMode, int offset, int size) {
+    NullRHIBuffer *buffer = bufferList[bufferHandle];
+
+    if (size < 0) {
+        size = buffer->size;
+    }
+
+    assert(offset + size <= buffer->size);
+
+    NULLRHI_RECORD(NullRHICmd_MapBufferRange, bufferHandle, lockMode, offset, size);
+
+    buffer->lockMode = lockMode;
+    buffer->mappedOffset = offset;
+    buffer->mappedSize = size;
+
+    return buffer->data + offset;
+}
+
+bool NullRHI::UnmapBuffer(Handle bufferHandle) {
+    NULLRHI_RECORD(NullRHICmd_UnmapBuffer, bufferHandle);
+
+    NullRHIBuffer *buffer = bufferList[bufferHandle];
+
+    // Explicitly flushed ranges are counted in FlushMappedBufferRange()
+    if (buffer->lockMode == WriteOnly) {
+        frameStats.bufferUploadBytes += buffer->mappedSize;
+    }
+
+    buffer->mappedOffset = 0;
+    buffer->mappedSize = 0;
+
+    return true;
+}
+
+void NullRHI::FlushMappedBufferRange(Handle bufferHandle, int offset, int size) {
+    NullRHIBuffer *buffer = bufferList[bufferHandle];
+
+    if (size < 0) {
+        size = buffer->size;
+    }
+
+    assert(offset + size <= buffer->size);
+
+    NULLRHI_RECORD(NullRHICmd_FlushMappedBufferRange, bufferHandle, offset, size);
+
+    frameStats.bufferUploadBytes += size;
+}
+
+int NullRHI::BufferDiscardWrite(Handle bufferHandle, int size, const void *data) {
+    NULLRHI_RECORD(NullRHICmd_BufferDiscardWrite, bufferHandle, size);
+
+    NullRHIBuffer *buffer = bufferList[bufferHandle];
+
+    if (size > buffer->size) {
+        memoryStats.bufferBytes += size - buffer->size;
+
+        Mem_AlignedFree(buffer->data);
+        buffer->data = (byte *)Mem_Alloc16(size);
+        buffer->size = size;
+    }
+
+    if (data) {
+        memcpy(buffer->data, data, size);
+    }
+
+    buffer->writeOffset = 0;
+
+    frameStats.bufferUploadBytes += size;
+
+    return 0;
+}
+
+int NullRHI::BufferWrite(Handle bufferHandle, int alignSize, int size, const void *data) {
+    NullRHIBuffer *writeBuffer = bufferList[bufferHandle];
+
+    if (writeBuffer->pitch > 0 && size > writeBuffer->pitch) {
+        return -1;
+    }
+
+    int base = writeBuffer->writeOffset + alignSize - 1;
+    base -= base % alignSize;
+
+    if (writeBuffer->pitch > 0) {
+        int startRow = base / writeBuffer->pitch;
+        int endRow = (base + size) / writeBuffer->pitch;
+
+        if (endRow > startRow) {
+            base -= base % writeBuffer->pitch;
+            base += writeBuffer->pitch;
+        }
+    }
+
+    int endPos = base + size;
+
+    if (endPos > writeBuffer->size) {
+        return -1;
+    }
+
+    NULLRHI_RECORD(NullRHICmd_BufferWrite, bufferHandle, alignSize, size, data ? 1 : 0);
+
+    // If date == nullptr, buffer memory is reserved
+    if (data) {
+        memcpy(writeBuffer->data + base, data, size);
+
+        frameStats.bufferUploadBytes += size;
+    }
+
+    writeBuffer->writeOffset = endPos;
+
+    return base;
+}
+
+int NullRHI::BufferCopy(Handle readBufferHandle, Handle writeBufferHandle, int alignSize, int size) {
+    NullRHIBuffer *writeBuffer = bufferList[writeBufferHandle];
+    const NullRHIBuffer *readBuffer = bufferList[readBufferHandle];
+
+    if (writeBuffer->pitch > 0 && size > writeBuffer->pitch) {
+        return -1;
+    }
+
+    int base = writeBuffer->writeOffset + alignSize - 1;
+    base -= base % alignSize;
+
+    if (writeBuffer->pitch > 0) {
+        int startRow = base / writeBuffer->pitch;
+        int endRow = (base + size) / writeBuffer->pitch;
+
+        if (endRow > startRow) {
+            base -= base % writeBuffer->pitch;
+            base += writeBuffer->pitch;
+        }
+    }
+
+    int endPos = base + size;
+
+    if (endPos > writeBuffer->size) {
+        return -1;
+    }
+
+    NULLRHI_RECORD(NullRHICmd_BufferCopy, readBufferHandle, writeBufferHandle, alignSize, size);
+
+    memcpy(writeBuffer->data + base, readBuffer->data, size);
+
+    writeBuffer->writeOffset = endPos;
+
+    return base;
+}
+
+void NullRHI::BufferRewind(Handle bufferHandle) {
+    NULLRHI_RECORD(NullRHICmd_BufferRewind, bufferHandle);
+
+    NullRHIBuffer *buffer = bufferList[bufferHandle];
+
+    buffer->writeOffset = 0;
+}
+
+BE_NAMESPACE_END
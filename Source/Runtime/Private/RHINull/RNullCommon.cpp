@@ -0,0 +1,497 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Precompiled.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+
+BE_NAMESPACE_BEGIN
+
+NullRHI         rhi;
+
+CVar            rnull_screenWidth(L"rnull_screenWidth", L"1280", CVar::Integer, L"screen width of the null renderer");
+CVar            rnull_screenHeight(L"rnull_screenHeight", L"720", CVar::Integer, L"screen height of the null renderer");
+
+NullRHI::NullRHI() {
+    initialized = false;
+    currentContext = nullptr;
+    mainContext = nullptr;
+    recordFile = nullptr;
+    replaying = false;
+}
+
+void NullRHI::Init(WindowHandle windowHandle, const Settings *settings) {
+    BE_LOG(L"Initializing Null Renderer...\n");
+
+    InitHandles();
+
+    // Limits of a typical desktop GPU
+    hwLimit.maxTextureSize = 16384;
+    hwLimit.max3dTextureSize = 2048;
+    hwLimit.maxCubeMapTextureSize = 16384;
+    hwLimit.maxRectangleTextureSize = 16384;
+    hwLimit.maxTextureBufferSize = 134217728;
+    hwLimit.maxTextureAnisotropy = 16;
+    hwLimit.maxTextureImageUnits = MaxTMU;
+    hwLimit.maxVertexAttribs = 16;
+    hwLimit.maxVertexUniformComponents = 4096;
+    hwLimit.maxVertexUniformVectors = 1024;
+    hwLimit.maxVertexTextureImageUnits = MaxTMU;
+    hwLimit.maxFragmentUniformComponents = 4096;
+    hwLimit.maxFragmentUniformVectors = 1024;
+    hwLimit.maxFragmentInputComponents = 128;
+    hwLimit.maxGeometryTextureImageUnits = MaxTMU;
+    hwLimit.maxGeometryOutputVertices = 1024;
+    hwLimit.maxUniformBufferBindings = 84;
+    hwLimit.maxUniformBlockSize = 65536;
+    hwLimit.uniformBufferOffsetAlignment = 256;
+    hwLimit.maxRenderBufferSize = 16384;
+    hwLimit.maxColorAttachments = 8;
+    hwLimit.maxDrawBuffers = 8;
+    hwLimit.nvVertexProgramVersion = 0;
+    hwLimit.nvFragmentProgramVersion = 0;
+
+    // Create main context
+    mainContext = new NullRHIContext;
+    memset(mainContext, 0, sizeof(*mainContext));
+    mainContext->windowHandle = windowHandle;
+    mainContext->state = new NullRHIState;
+    contextList[0] = mainContext;
+
+    currentContext = mainContext;
+
+    SetDefaultState();
+
+    memset(&frameStats, 0, sizeof(frameStats));
+    memset(&lastFrameStats, 0, sizeof(lastFrameStats));
+    memset(&memoryStats, 0, sizeof(memoryStats));
+
+    initialized = true;
+}
+
+void NullRHI::Shutdown() {
+    BE_LOG(L"Shutting down Null Renderer...\n");
+
+    EndRecording();
+
+    initialized = false;
+
+    delete mainContext->state;
+
+    currentContext = nullptr;
+    mainContext = nullptr;
+
+    FreeHandles();
+}
+
+void NullRHI::InitHandles() {
+    contextList.SetGranularity(16);
+    contextList.Append(nullptr);
+
+    stencilStateList.SetGranularity(32);
+    NullRHIStencilState *zeroStencilState = new NullRHIStencilState;
+    memset(zeroStencilState, 0, sizeof(*zeroStencilState));
+    stencilStateList.Append(zeroStencilState);
+
+    bufferList.SetGranularity(1024);
+    NullRHIBuffer *zeroBuffer = new NullRHIBuffer;
+    memset(zeroBuffer, 0, sizeof(*zeroBuffer));
+    bufferList.Append(zeroBuffer);
+
+    syncList.SetGranularity(8);
+    NullRHISync *zeroSync = new NullRHISync;
+    memset(zeroSync, 0, sizeof(*zeroSync));
+    syncList.Append(zeroSync);
+
+    textureList.SetGranularity(1024);
+    NullRHITexture *zeroTexture = new NullRHITexture;
+    memset(zeroTexture, 0, sizeof(*zeroTexture));
+    textureList.Append(zeroTexture);
+
+    shaderList.SetGranularity(1024);
+    NullRHIShader *zeroShader = new NullRHIShader;
+    memset(zeroShader, 0, sizeof(*zeroShader));
+    shaderList.Append(zeroShader);
+
+    vertexFormatList.SetGranularity(64);
+    NullRHIVertexFormat *zeroVertexFormat = new NullRHIVertexFormat;
+    memset(zeroVertexFormat, 0, sizeof(*zeroVertexFormat));
+    vertexFormatList.Append(zeroVertexFormat);
+
+    // render target 0 is the default frame buffer
+    renderTargetList.SetGranularity(64);
+    NullRHIRenderTarget *zeroRenderTarget = new NullRHIRenderTarget;
+    memset(zeroRenderTarget, 0, sizeof(*zeroRenderTarget));
+    zeroRenderTarget->sRGB = true;
+    renderTargetList.Append(zeroRenderTarget);
+
+    queryList.SetGranularity(32);
+    NullRHIQuery *zeroQuery = new NullRHIQuery;
+    memset(zeroQuery, 0, sizeof(*zeroQuery));
+    queryList.Append(zeroQuery);
+}
+
+void NullRHI::FreeHandles() {
+    for (int i = 0; i < bufferList.Count(); i++) {
+        if (bufferList[i]) {
+            Mem_AlignedFree(bufferList[i]->data);
+        }
+    }
+
+    for (int i = 0; i < shaderList.Count(); i++) {
+        NullRHIShader *shader = shaderList[i];
+        if (shader) {
+            for (int j = 0; j < shader->numSamplers; j++) {
+                Mem_Free(shader->samplers[j].name);
+            }
+            for (int j = 0; j < shader->numUniforms; j++) {
+                Mem_Free(shader->uniforms[j].name);
+            }
+            for (int j = 0; j < shader->numUniformBlocks; j++) {
+                Mem_Free(shader->uniformBlocks[j].name);
+            }
+            Mem_Free(shader->samplers);
+            Mem_Free(shader->uniforms);
+            Mem_Free(shader->uniformBlocks);
+        }
+    }
+
+    contextList.DeleteContents(true);
+    stencilStateList.DeleteContents(true);
+    bufferList.DeleteContents(true);
+    syncList.DeleteContents(true);
+    textureList.DeleteContents(true);
+    shaderList.DeleteContents(true);
+    vertexFormatList.DeleteContents(true);
+    renderTargetList.DeleteContents(true);
+    queryList.DeleteContents(true);
+}
+
+Str NullRHI::GetGPUString() const {
+    return "Null Renderer";
+}
+
+bool NullRHI::SupportsPolygonMode() const {
+    return true;
+}
+
+bool NullRHI::SupportsPackedFloat() const {
+    return true;
+}
+
+bool NullRHI::SupportsDepthBufferFloat() const {
+    return true;
+}
+
+bool NullRHI::SupportsPixelBufferObject() const {
+    return true;
+}
+
+bool NullRHI::SupportsTextureRectangle() const {
+    return true;
+}
+
+bool NullRHI::SupportsTextureArray() const {
+    return true;
+}
+
+bool NullRHI::SupportsTextureBufferObject() const {
+    return true;
+}
+
+bool NullRHI::SupportsTextureCompressionS3TC() const {
+    return true;
+}
+
+bool NullRHI::SupportsTextureCompressionLATC() const {
+    return false;
+}
+
+bool NullRHI::SupportsTextureCompressionETC2() const {
+    return false;
+}
+
+bool NullRHI::SupportsInstancedArrays() const {
+    return true;
+}
+
+bool NullRHI::SupportsBufferStorage() const {
+    return false;
+}
+
+bool NullRHI::SupportsMultiDrawIndirect() const {
+    return false;
+}
+
+bool NullRHI::SupportsDebugLabel() const {
+    return false;
+}
+
+RHI::Handle NullRHI::CreateContext(RHI::WindowHandle windowHandle, bool useSharedContext) {
+    NullRHIContext *ctx = new NullRHIContext;
+    memset(ctx, 0, sizeof(*ctx));
+
+    int handle = contextList.FindNull();
+    if (handle == -1) {
+        handle = contextList.Append(ctx);
+    } else {
+        contextList[handle] = ctx;
+    }
+
+    ctx->handle = (Handle)handle;
+    ctx->windowHandle = windowHandle;
+    ctx->state = useSharedContext ? new NullRHIState : mainContext->state;
+
+    SetContext((Handle)handle);
+
+    SetDefaultState();
+
+    return (Handle)handle;
+}
+
+void NullRHI::DestroyContext(Handle ctxHandle) {
+    NullRHIContext *ctx = contextList[ctxHandle];
+
+    if (ctx->state != mainContext->state) {
+        delete ctx->state;
+    }
+
+    if (currentContext == ctx) {
+        currentContext = mainContext;
+    }
+
+    delete ctx;
+    contextList[ctxHandle] = nullptr;
+}
+
+void NullRHI::ActivateSurface(Handle ctxHandle, RHI::WindowHandle windowHandle) {
+    NullRHIContext *ctx = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
+    ctx->windowHandle = windowHandle;
+}
+
+void NullRHI::DeactivateSurface(Handle ctxHandle) {
+}
+
+void NullRHI::SetContext(Handle ctxHandle) {
+    currentContext = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
+}
+
+void NullRHI::SetContextDisplayFunc(Handle ctxHandle, DisplayContextFunc displayFunc, void *displayFuncDataPtr, bool onDemandDrawing) {
+    NullRHIContext *ctx = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
+
+    ctx->displayFunc = displayFunc;
+    ctx->displayFuncDataPtr = displayFuncDataPtr;
+    ctx->onDemandDrawing = onDemandDrawing;
+}
+
+void NullRHI::DisplayContext(Handle ctxHandle) {
+    NullRHIContext *ctx = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
+
+    ctx->displayFunc(ctxHandle, ctx->displayFuncDataPtr);
+}
+
+RHI::WindowHandle NullRHI::GetWindowHandleFromContext(Handle ctxHandle) {
+    const NullRHIContext *ctx = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
+    return ctx->windowHandle;
+}
+
+void NullRHI::GetDisplayMetrics(Handle ctxHandle, DisplayMetrics *displayMetrics) const {
+    displayMetrics->screenWidth = rnull_screenWidth.GetInteger();
+    displayMetrics->screenHeight = rnull_screenHeight.GetInteger();
+    displayMetrics->backingWidth = displayMetrics->screenWidth;
+    displayMetrics->backingHeight = displayMetrics->screenHeight;
+    displayMetrics->safeAreaInsets.Set(0, 0, 0, 0);
+}
+
+bool NullRHI::IsFullscreen() const {
+    return false;
+}
+
+bool NullRHI::SetFullscreen(Handle ctxHandle, int width, int height) {
+    return false;
+}
+
+void NullRHI::ResetFullscreen(Handle ctxHandle) {
+}
+
+void NullRHI::GetGammaRamp(unsigned short ramp[768]) const {
+    for (int i = 0; i < 256; i++) {
+        ramp[i] = ramp[i + 256] = ramp[i + 512] = (unsigned short)(i * 257);
+    }
+}
+
+void NullRHI::SetGammaRamp(unsigned short ramp[768]) const {
+}
+
+bool NullRHI::SwapBuffers() {
+    NULLRHI_RECORD0(NullRHICmd_SwapBuffers);
+
+    EndFrame();
+    return true;
+}
+
+void NullRHI::SwapInterval(int interval) const {
+}
+
+void NullRHI::EndFrame() {
+    lastFrameStats = frameStats;
+    memset(&frameStats, 0, sizeof(frameStats));
+}
+
+void NullRHI::Clear(int clearBits, const Color4 &color, float depth, unsigned int stencil) {
+    NULLRHI_RECORD(NullRHICmd_Clear, clearBits, NullRHIFloatArg(color.r), NullRHIFloatArg(color.g), NullRHIFloatArg(color.b), NullRHIFloatArg(color.a), NullRHIFloatArg(depth), (int32_t)stencil);
+}
+
+void NullRHI::ReadPixels(int x, int y, int width, int height, Image::Format imageFormat, byte *data) {
+    memset(data, 0, Image::MemRequired(width, height, 1, 1, imageFormat));
+}
+
+void NullRHI::CountDrawCall(int numVerts, int instanceCount) const {
+    frameStats.numDrawCalls++;
+    frameStats.numInstances += instanceCount;
+    frameStats.numVerts += numVerts * instanceCount;
+}
+
+void NullRHI::DrawArrays(Primitive primitives, int startVertex, int numVerts) const {
+    NULLRHI_RECORD(NullRHICmd_Draw, primitives, numVerts, 1);
+    CountDrawCall(numVerts, 1);
+}
+
+void NullRHI::DrawArraysInstanced(Primitive primitives, int startVertex, int numVerts, int instanceCount) const {
+    NULLRHI_RECORD(NullRHICmd_Draw, primitives, numVerts, instanceCount);
+    CountDrawCall(numVerts, instanceCount);
+}
+
+void NullRHI::DrawElements(Primitive primitives, int startIndex, int numIndices, int indexSize, const void *ptr) const {
+    NULLRHI_RECORD(NullRHICmd_Draw, primitives, numIndices, 1);
+    CountDrawCall(numIndices, 1);
+}
+
+void NullRHI::DrawElementsInstanced(Primitive primitives, int startIndex, int numIndices, int indexSize, const void *ptr, int instanceCount) const {
+    NULLRHI_RECORD(NullRHICmd_Draw, primitives, numIndices, instanceCount);
+    CountDrawCall(numIndices, instanceCount);
+}
+
+void NullRHI::DrawElementsBaseVertex(Primitive primitives, int startIndex, int numIndices, int indexSize, const void *ptr, int baseVertexIndex) const {
+    NULLRHI_RECORD(NullRHICmd_Draw, primitives, numIndices, 1);
+    CountDrawCall(numIndices, 1);
+}
+
+void NullRHI::DrawElementsInstancedBaseVertex(Primitive primitives, int startIndex, int numIndices, int indexSize, const void *ptr, int instanceCount, int baseVertexIndex) const {
+    NULLRHI_RECORD(NullRHICmd_Draw, primitives, numIndices, instanceCount);
+    CountDrawCall(numIndices, instanceCount);
+}
+
+void NullRHI::DrawElementsIndirect(Primitive primitives, int indexSize, int indirectBufferOffset) const {
+    const NullRHIBuffer *buffer = bufferList[currentContext->state->bufferHandles[DrawIndirectBuffer]];
+    const DrawElementsIndirectCommand *command = (const DrawElementsIndirectCommand *)(buffer->data + indirectBufferOffset);
+
+    NULLRHI_RECORD(NullRHICmd_Draw, primitives, (int32_t)command->vertexCount, (int32_t)command->instanceCount);
+    CountDrawCall(command->vertexCount, command->instanceCount);
+}
+
+void NullRHI::MultiDrawElementsIndirect(Primitive primitives, int indexSize, int indirectBufferOffset, int drawCount, int stride) const {
+    const NullRHIBuffer *buffer = bufferList[currentContext->state->bufferHandles[DrawIndirectBuffer]];
+
+    if (stride == 0) {
+        stride = sizeof(DrawElementsIndirectCommand);
+    }
+
+    for (int i = 0; i < drawCount; i++) {
+        const DrawElementsIndirectCommand *command = (const DrawElementsIndirectCommand *)(buffer->data + indirectBufferOffset + i * stride);
+
+        NULLRHI_RECORD(NullRHICmd_Draw, primitives, (int32_t)command->vertexCount, (int32_t)command->instanceCount);
+        CountDrawCall(command->vertexCount, command->instanceCount);
+    }
+}
+
+RHI::Handle NullRHI::CreateSync() {
+    NullRHISync *sync = new NullRHISync;
+    sync->fenced = false;
+
+    int handle = syncList.FindNull();
+    if (handle == -1) {
+        handle = syncList.Append(sync);
+    } else {
+        syncList[handle] = sync;
+    }
+
+    return (Handle)handle;
+}
+
+void NullRHI::DestroySync(Handle syncHandle) {
+    delete syncList[syncHandle];
+    syncList[syncHandle] = nullptr;
+}
+
+bool NullRHI::IsSync(Handle syncHandle) const {
+    return syncList[syncHandle]->fenced;
+}
+
+void NullRHI::FenceSync(Handle syncHandle) {
+    syncList[syncHandle]->fenced = true;
+}
+
+void NullRHI::DeleteSync(Handle syncHandle) {
+    syncList[syncHandle]->fenced = false;
+}
+
+void NullRHI::WaitSync(Handle syncHandle) {
+}
+
+RHI::Handle NullRHI::CreateQuery() {
+    NullRHIQuery *query = new NullRHIQuery;
+    query->active = false;
+    query->result = 0;
+
+    int handle = queryList.FindNull();
+    if (handle == -1) {
+        handle = queryList.Append(query);
+    } else {
+        queryList[handle] = query;
+    }
+
+    return (Handle)handle;
+}
+
+void NullRHI::DestroyQuery(Handle queryHandle) {
+    delete queryList[queryHandle];
+    queryList[queryHandle] = nullptr;
+}
+
+void NullRHI::BeginQuery(Handle queryHandle) {
+    NullRHIQuery *query = queryList[queryHandle];
+    query->active = true;
+    query->result = 0;
+}
+
+void NullRHI::EndQuery() {
+    for (int i = 1; i < queryList.Count(); i++) {
+        if (queryList[i] && queryList[i]->active) {
+            queryList[i]->active = false;
+        }
+    }
+}
+
+bool NullRHI::QueryResultAvailable(Handle queryHandle) const {
+    return !queryList[queryHandle]->active;
+}
+
+unsigned int NullRHI::QueryResult(Handle queryHandle) const {
+    return queryList[queryHandle]->result;
+}
+
+void NullRHI::CheckError(const char *fmt, ...) const {
+}
+
+BE_NAMESPACE_END
@@ -0,0 +1,239 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "Core/Heap.h"
+#include "Core/CVars.h"
+
+BE_NAMESPACE_BEGIN
+
+// Commands of the recorded call stream.
+// Each command is written as int16 command, int16 number of arguments, followed by int32 arguments.
+enum NullRHICommand {
+    NullRHICmd_SwapBuffers,
+    NullRHICmd_Clear,
+    NullRHICmd_SetStateBits,
+    NullRHICmd_SetCullFace,
+    NullRHICmd_SetDepthBias,
+    NullRHICmd_SetDepthRange,
+    NullRHICmd_SetViewport,
+    NullRHICmd_SetScissor,
+    NullRHICmd_SetSRGBWrite,
+    NullRHICmd_SetLineWidth,
+    NullRHICmd_CreateStencilState,
+    NullRHICmd_DestroyStencilState,
+    NullRHICmd_SetStencilState,
+    NullRHICmd_CreateTexture,
+    NullRHICmd_DestroyTexture,
+    NullRHICmd_SelectTextureUnit,
+    NullRHICmd_BindTexture,
+    NullRHICmd_SetTextureImage,
+    NullRHICmd_SetTextureSubImage,
+    NullRHICmd_CreateRenderTarget,
+    NullRHICmd_DestroyRenderTarget,
+    NullRHICmd_BeginRenderTarget,
+    NullRHICmd_EndRenderTarget,
+    NullRHICmd_CreateShader,
+    NullRHICmd_DestroyShader,
+    NullRHICmd_BindShader,
+    NullRHICmd_SetShaderConstant,
+    NullRHICmd_SetShaderConstantBlock,
+    NullRHICmd_CreateBuffer,
+    NullRHICmd_DestroyBuffer,
+    NullRHICmd_BindBuffer,
+    NullRHICmd_BindIndexedBufferRange,
+    NullRHICmd_MapBufferRange,
+    NullRHICmd_UnmapBuffer,
+    NullRHICmd_FlushMappedBufferRange,
+    NullRHICmd_BufferDiscardWrite,
+    NullRHICmd_BufferWrite,
+    NullRHICmd_BufferCopy,
+    NullRHICmd_BufferRewind,
+    NullRHICmd_CreateVertexFormat,
+    NullRHICmd_DestroyVertexFormat,
+    NullRHICmd_SetVertexFormat,
+    NullRHICmd_SetStreamSource,
+    NullRHICmd_Draw,
+    NullRHICmd_MaxCommands
+};
+
+#define NULLRHI_RECORD(cmd, ...) \
+    if (recordFile) { \
+        const int32_t recordArgs[] = { __VA_ARGS__ }; \
+        Record(cmd, COUNT_OF(recordArgs), recordArgs); \
+    }
+
+#define NULLRHI_RECORD0(cmd) \
+    if (recordFile) { \
+        Record(cmd, 0, nullptr); \
+    }
+
+BE_INLINE int32_t NullRHIFloatArg(float f) {
+    int32_t i;
+    memcpy(&i, &f, sizeof(i));
+    return i;
+}
+
+BE_INLINE float NullRHIArgFloat(int32_t i) {
+    float f;
+    memcpy(&f, &i, sizeof(f));
+    return f;
+}
+
+struct NullRHIState {
+    unsigned int        tmu; // current texture map unit
+    RHI::Handle         textureHandles[RHI::MaxTMU];
+    RHI::Handle         shaderHandle;
+    RHI::Handle         bufferHandles[RHI::MaxBufferTypes];
+    RHI::Handle         indexedBufferHandles[2]; // 0: UniformBuffer, 1: TransformFeedbackBuffer
+    RHI::Handle         vertexFormatHandle;
+    RHI::Handle         streamHandles[RHI::MaxVertexStream];
+    RHI::Handle         renderTargetHandle;
+    RHI::Handle         renderTargetHandleStack[16];
+    int                 renderTargetHandleStackDepth;
+    RHI::Handle         stencilStateHandle;
+    int                 stencilRef;
+
+    unsigned int        renderState;
+    int                 cull;
+    Rect                viewportRect;
+    Rect                scissorRect;
+    float               depthRange[2];
+    float               depthBias[2];
+    float               lineWidth;
+    bool                sRGBWrite;
+
+    NullRHIState() : tmu(0), 
+        shaderHandle(RHI::NullShader), vertexFormatHandle(RHI::NullVertexFormat), renderTargetHandle(RHI::NullRenderTarget), renderTargetHandleStackDepth(0), 
+        stencilStateHandle(RHI::NullStencilState), stencilRef(0), renderState(0), cull(RHI::BackCull), viewportRect(Rect::empty), scissorRect(Rect::empty),
+        lineWidth(1.0f), sRGBWrite(false) {
+        memset(textureHandles, 0, sizeof(textureHandles));
+        memset(bufferHandles, 0, sizeof(bufferHandles));
+        memset(indexedBufferHandles, 0, sizeof(indexedBufferHandles));
+        memset(streamHandles, 0, sizeof(streamHandles));
+        depthRange[0] = 0.0f;
+        depthRange[1] = 1.0f;
+        depthBias[0] = 0.0f;
+        depthBias[1] = 0.0f;
+    }
+};
+
+struct NullRHIContext {
+    RHI::Handle         handle;
+    RHI::WindowHandle   windowHandle;
+    RHI::DisplayContextFunc displayFunc;
+    void *              displayFuncDataPtr;
+    bool                onDemandDrawing;
+    NullRHIState *      state;
+};
+
+struct NullRHIStencilState {
+    int                 readMask;
+    int                 writeMask;
+};
+
+struct NullRHITexture {
+    int                 type;
+    int                 width;
+    int                 height;
+    int                 depth;
+    int                 numMipmaps;
+    int                 numSlices;
+    Image::Format       format;
+    int64_t             memSize;
+};
+
+struct NullRHIBuffer {
+    int                 type;
+    int                 usage;
+    int                 size;
+    int                 pitch;
+    int                 writeOffset;
+    byte *              data;               // system memory backing store, so that the buffer can be mapped
+    int                 mappedOffset;
+    int                 mappedSize;
+    int                 lockMode;
+    int                 bindingIndex;
+    int                 bindingOffset;
+    int                 bindingSize;
+};
+
+struct NullRHISync {
+    bool                fenced;
+};
+
+struct NullRHIName {
+    bool                operator==(const NullRHIName &other) const { return Str::Cmp(name, other.name) == 0; }
+    bool                operator<(const NullRHIName &other) const { return Str::Cmp(name, other.name) < 0; }
+    bool                operator>(const NullRHIName &other) const { return Str::Cmp(name, other.name) > 0; }
+
+    char *              name;
+    int                 index;
+};
+
+struct NullRHIShader {
+    char                name[64];
+    int                 numSamplers;
+    NullRHIName *       samplers;           // sorted by name, index is the texture unit
+    int                 numUniforms;
+    NullRHIName *       uniforms;           // sorted by name
+    int                 numUniformBlocks;
+    NullRHIName *       uniformBlocks;      // sorted by name
+};
+
+struct NullRHIVertexFormat {
+    int                 numElements;
+    RHI::VertexElement  elements[RHI::VertexElement::MaxUsages];
+    int                 vertexSize[RHI::MaxVertexStream];
+};
+
+struct NullRHIRenderTarget {
+    int                 type;
+    int                 flags;
+    int                 width;
+    int                 height;
+    int                 numColorTextures;
+    RHI::Handle         colorTextureHandles[16];
+    RHI::Handle         depthTextureHandle;
+    bool                sRGB;
+    int64_t             memSize;            // memory of depth/stencil render buffers which are not textures
+};
+
+struct NullRHIQuery {
+    bool                active;
+    unsigned int        result;
+};
+
+// Maps handles of the recorded stream to the handles created on replay.
+struct NullRHIReplayState {
+    Array<int>          handleMaps[NullRHICmd_MaxCommands];
+
+    int                 Get(int createCmd, int recordedHandle) const {
+        const Array<int> &map = handleMaps[createCmd];
+        return recordedHandle < map.Count() ? map[recordedHandle] : 0;
+    }
+
+    void                Set(int createCmd, int recordedHandle, int handle) {
+        Array<int> &map = handleMaps[createCmd];
+        while (map.Count() <= recordedHandle) {
+            map.Append(0);
+        }
+        map[recordedHandle] = handle;
+    }
+};
+
+extern CVar             rnull_screenWidth;
+extern CVar             rnull_screenHeight;
+
+BE_NAMESPACE_END
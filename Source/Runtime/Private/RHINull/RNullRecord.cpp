@@ -0,0 +1,317 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Precompiled.h"
+#include "RHI/RHINull.h"
+#include "File/FileSystem.h"
+#include "RNullInternal.h"
+
+BE_NAMESPACE_BEGIN
+
+#define NULLRHI_RECORD_IDENT    (('R' << 24) + ('H' << 16) + ('R' << 8) + 'B')
+#define NULLRHI_RECORD_VERSION  1
+
+bool NullRHI::BeginRecording(const char *filename) {
+    if (replaying) {
+        BE_WARNLOG(L"NullRHI::BeginRecording: can't record while replaying\n");
+        return false;
+    }
+
+    EndRecording();
+
+    recordFile = fileSystem.OpenFileWrite(filename);
+    if (!recordFile) {
+        BE_WARNLOG(L"NullRHI::BeginRecording: failed to open file '%hs'\n", filename);
+        return false;
+    }
+
+    recordFile->WriteInt32(NULLRHI_RECORD_IDENT);
+    recordFile->WriteInt32(NULLRHI_RECORD_VERSION);
+
+    // Resources created before recording are not in the stream,
+    // so the stream should be recorded from the start of the renderer to be replayed.
+    BE_LOG(L"Recording RHI calls to '%hs'\n", filename);
+    return true;
+}
+
+void NullRHI::EndRecording() {
+    if (recordFile) {
+        fileSystem.CloseFile(recordFile);
+        recordFile = nullptr;
+    }
+}
+
+void NullRHI::Record(int cmd, int numArgs, const int32_t *args) const {
+    int16_t header[2];
+    header[0] = (int16_t)cmd;
+    header[1] = (int16_t)numArgs;
+
+    recordFile->Write(header, sizeof(header));
+    if (numArgs > 0) {
+        recordFile->Write(args, numArgs * sizeof(args[0]));
+    }
+}
+
+int NullRHI::Replay(const char *filename) {
+    if (recordFile) {
+        BE_WARNLOG(L"NullRHI::Replay: can't replay while recording\n");
+        return -1;
+    }
+
+    byte *data;
+    size_t size = fileSystem.LoadFile(filename, true, (void **)&data);
+    if (!data) {
+        BE_WARNLOG(L"NullRHI::Replay: failed to load file '%hs'\n", filename);
+        return -1;
+    }
+
+    const byte *ptr = data;
+    const byte *end = data + size;
+
+    int32_t ident, version;
+    if (size < sizeof(ident) + sizeof(version)) {
+        fileSystem.FreeFile(data);
+        return -1;
+    }
+    memcpy(&ident, ptr, sizeof(ident));
+    memcpy(&version, ptr + sizeof(ident), sizeof(version));
+    ptr += sizeof(ident) + sizeof(version);
+
+    if (ident != NULLRHI_RECORD_IDENT || version != NULLRHI_RECORD_VERSION) {
+        BE_WARNLOG(L"NullRHI::Replay: '%hs' is not a valid RHI record file\n", filename);
+        fileSystem.FreeFile(data);
+        return -1;
+    }
+
+    NullRHIReplayState *replayState = new NullRHIReplayState;
+    int32_t args[256];
+    int numFrames = 0;
+
+    replaying = true;
+
+    while (ptr + sizeof(int16_t) * 2 <= end) {
+        int16_t header[2];
+        memcpy(header, ptr, sizeof(header));
+        ptr += sizeof(header);
+
+        int cmd = header[0];
+        int numArgs = header[1];
+        if (numArgs < 0 || numArgs > COUNT_OF(args) || ptr + numArgs * sizeof(int32_t) > end) {
+            BE_WARNLOG(L"NullRHI::Replay: corrupted command stream\n");
+            break;
+        }
+
+        memcpy(args, ptr, numArgs * sizeof(int32_t));
+        ptr += numArgs * sizeof(int32_t);
+
+        if (!ReplayCommand(replayState, cmd, numArgs, args)) {
+            BE_WARNLOG(L"NullRHI::Replay: unknown command %i\n", cmd);
+            break;
+        }
+
+        if (cmd == NullRHICmd_SwapBuffers) {
+            numFrames++;
+        }
+    }
+
+    replaying = false;
+
+    delete replayState;
+
+    fileSystem.FreeFile(data);
+
+    return numFrames;
+}
+
+bool NullRHI::ReplayCommand(NullRHIReplayState *replayState, int cmd, int numArgs, const int32_t *args) {
+#define STENCIL_STATE(i)    ((Handle)replayState->Get(NullRHICmd_CreateStencilState, args[i]))
+#define TEXTURE(i)          ((Handle)replayState->Get(NullRHICmd_CreateTexture, args[i]))
+#define RENDER_TARGET(i)    ((Handle)replayState->Get(NullRHICmd_CreateRenderTarget, args[i]))
+#define SHADER(i)           ((Handle)replayState->Get(NullRHICmd_CreateShader, args[i]))
+#define BUFFER(i)           ((Handle)replayState->Get(NullRHICmd_CreateBuffer, args[i]))
+#define VERTEX_FORMAT(i)    ((Handle)replayState->Get(NullRHICmd_CreateVertexFormat, args[i]))
+
+    switch (cmd) {
+    case NullRHICmd_SwapBuffers:
+        SwapBuffers();
+        break;
+    case NullRHICmd_Clear:
+        Clear(args[0], Color4(NullRHIArgFloat(args[1]), NullRHIArgFloat(args[2]), NullRHIArgFloat(args[3]), NullRHIArgFloat(args[4])), NullRHIArgFloat(args[5]), args[6]);
+        break;
+    case NullRHICmd_SetStateBits:
+        SetStateBits(args[0]);
+        break;
+    case NullRHICmd_SetCullFace:
+        SetCullFace(args[0]);
+        break;
+    case NullRHICmd_SetDepthBias:
+        SetDepthBias(NullRHIArgFloat(args[0]), NullRHIArgFloat(args[1]));
+        break;
+    case NullRHICmd_SetDepthRange:
+        SetDepthRange(NullRHIArgFloat(args[0]), NullRHIArgFloat(args[1]));
+        break;
+    case NullRHICmd_SetViewport:
+        SetViewport(Rect(args[0], args[1], args[2], args[3]));
+        break;
+    case NullRHICmd_SetScissor:
+        SetScissor(Rect(args[0], args[1], args[2], args[3]));
+        break;
+    case NullRHICmd_SetSRGBWrite:
+        SetSRGBWrite(!!args[0]);
+        break;
+    case NullRHICmd_SetLineWidth:
+        SetLineWidth(NullRHIArgFloat(args[0]));
+        break;
+    case NullRHICmd_CreateStencilState:
+        replayState->Set(cmd, args[0], CreateStencilState(args[1], args[2], (StencilFunc)args[3], args[4], args[5], args[6], (StencilFunc)args[7], args[8], args[9], args[10]));
+        break;
+    case NullRHICmd_DestroyStencilState:
+        DestroyStencilState(STENCIL_STATE(0));
+        break;
+    case NullRHICmd_SetStencilState:
+        SetStencilState(STENCIL_STATE(0), args[1]);
+        break;
+    case NullRHICmd_CreateTexture:
+        replayState->Set(cmd, args[0], CreateTexture((TextureType)args[1]));
+        break;
+    case NullRHICmd_DestroyTexture:
+        DestroyTexture(TEXTURE(0));
+        break;
+    case NullRHICmd_SelectTextureUnit:
+        SelectTextureUnit(args[0]);
+        break;
+    case NullRHICmd_BindTexture:
+        BindTexture(TEXTURE(0));
+        break;
+    case NullRHICmd_SetTextureImage:
+        SetTextureStorage((TextureType)args[0], args[1], args[2], args[3], args[4], args[5], (Image::Format)args[6], (uint32_t)args[7]);
+        break;
+    case NullRHICmd_SetTextureSubImage:
+        frameStats.textureUploadBytes += args[0];
+        break;
+    case NullRHICmd_CreateRenderTarget: {
+        Handle colorTextureHandles[16];
+        int numColorTextures = args[4];
+        for (int i = 0; i < numColorTextures; i++) {
+            colorTextureHandles[i] = TEXTURE(5 + i);
+        }
+        int i = 5 + numColorTextures;
+        replayState->Set(cmd, args[0], CreateRenderTarget((RenderTargetType)args[1], args[2], args[3], numColorTextures, colorTextureHandles, TEXTURE(i), !!args[i + 1], args[i + 2]));
+        break;
+    }
+    case NullRHICmd_DestroyRenderTarget:
+        DestroyRenderTarget(RENDER_TARGET(0));
+        break;
+    case NullRHICmd_BeginRenderTarget:
+        BeginRenderTarget(RENDER_TARGET(0), args[1], args[2], args[3]);
+        break;
+    case NullRHICmd_EndRenderTarget:
+        EndRenderTarget();
+        break;
+    case NullRHICmd_CreateShader:
+        replayState->Set(cmd, args[0], CreateShader("replay", "", ""));
+        break;
+    case NullRHICmd_DestroyShader:
+        DestroyShader(SHADER(0));
+        break;
+    case NullRHICmd_BindShader:
+        BindShader(SHADER(0));
+        break;
+    case NullRHICmd_SetShaderConstant:
+        SetShaderConstantGeneric(args[0], args[1]);
+        break;
+    case NullRHICmd_SetShaderConstantBlock:
+        SetShaderConstantBlock(args[0], args[1]);
+        break;
+    case NullRHICmd_CreateBuffer:
+        replayState->Set(cmd, args[0], CreateBuffer((BufferType)args[1], (BufferUsage)args[2], args[3], args[4], nullptr));
+        if (args[5]) {
+            frameStats.bufferUploadBytes += args[3];
+        }
+        break;
+    case NullRHICmd_DestroyBuffer:
+        DestroyBuffer(BUFFER(0));
+        break;
+    case NullRHICmd_BindBuffer:
+        BindBuffer((BufferType)args[0], BUFFER(1));
+        break;
+    case NullRHICmd_BindIndexedBufferRange:
+        BindIndexedBufferRange((BufferType)args[0], args[1], BUFFER(2), args[3], args[4]);
+        break;
+    case NullRHICmd_MapBufferRange:
+        MapBufferRange(BUFFER(0), (BufferLockMode)args[1], args[2], args[3]);
+        break;
+    case NullRHICmd_UnmapBuffer:
+        UnmapBuffer(BUFFER(0));
+        break;
+    case NullRHICmd_FlushMappedBufferRange:
+        FlushMappedBufferRange(BUFFER(0), args[1], args[2]);
+        break;
+    case NullRHICmd_BufferDiscardWrite:
+        BufferDiscardWrite(BUFFER(0), args[1], nullptr);
+        break;
+    case NullRHICmd_BufferWrite:
+        BufferWrite(BUFFER(0), args[1], args[2], nullptr);
+        if (args[3]) {
+            frameStats.bufferUploadBytes += args[2];
+        }
+        break;
+    case NullRHICmd_BufferCopy:
+        BufferCopy(BUFFER(0), BUFFER(1), args[2], args[3]);
+        break;
+    case NullRHICmd_BufferRewind:
+        BufferRewind(BUFFER(0));
+        break;
+    case NullRHICmd_CreateVertexFormat: {
+        VertexElement elements[VertexElement::MaxUsages];
+        int numElements = args[1];
+        for (int i = 0; i < numElements; i++) {
+            const int32_t *elementArgs = &args[2 + i * 7];
+            elements[i].stream = elementArgs[0];
+            elements[i].offset = elementArgs[1];
+            elements[i].usage = (VertexElement::Usage)elementArgs[2];
+            elements[i].components = elementArgs[3];
+            elements[i].type = (VertexElement::Type)elementArgs[4];
+            elements[i].normalize = !!elementArgs[5];
+            elements[i].divisor = elementArgs[6];
+        }
+        replayState->Set(cmd, args[0], CreateVertexFormat(numElements, elements));
+        break;
+    }
+    case NullRHICmd_DestroyVertexFormat:
+        DestroyVertexFormat(VERTEX_FORMAT(0));
+        break;
+    case NullRHICmd_SetVertexFormat:
+        SetVertexFormat(VERTEX_FORMAT(0));
+        break;
+    case NullRHICmd_SetStreamSource:
+        SetStreamSource(args[0], BUFFER(1), args[2], args[3]);
+        break;
+    case NullRHICmd_Draw:
+        CountDrawCall(args[1], args[2]);
+        break;
+    default:
+        return false;
+    }
+
+#undef STENCIL_STATE
+#undef TEXTURE
+#undef RENDER_TARGET
+#undef SHADER
+#undef BUFFER
+#undef VERTEX_FORMAT
+
+    return true;
+}
+
+BE_NAMESPACE_END
@@ -0,0 +1,131 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Precompiled.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+
+BE_NAMESPACE_BEGIN
+
+RHI::Handle NullRHI::CreateRenderTarget(RenderTargetType type, int width, int height, int numColorTextures, Handle *colorTextureHandles, Handle depthTextureHandle, bool sRGB, int flags) {
+    NullRHIRenderTarget *renderTarget = new NullRHIRenderTarget;
+    memset(renderTarget, 0, sizeof(*renderTarget));
+    renderTarget->type = type;
+    renderTarget->flags = flags;
+    renderTarget->width = width;
+    renderTarget->height = height;
+    renderTarget->numColorTextures = numColorTextures;
+    for (int i = 0; i < numColorTextures; i++) {
+        renderTarget->colorTextureHandles[i] = colorTextureHandles[i];
+    }
+    renderTarget->depthTextureHandle = depthTextureHandle;
+    renderTarget->sRGB = sRGB;
+
+    // Render buffers which are created if there are no textures to attach
+    int numSlices = type == RenderTargetCubeMap ? 6 : 1;
+    if (numColorTextures == 0 && (flags & HasColorBuffer)) {
+        renderTarget->memSize += (int64_t)Image::MemRequired(width, height, 1, 1, Image::RGBA_8_8_8_8) * numSlices;
+    }
+    if (depthTextureHandle == NullTexture && (flags & HasDepthBuffer)) {
+        renderTarget->memSize += (int64_t)Image::MemRequired(width, height, 1, 1, (flags & HasStencilBuffer) ? Image::DepthStencil_24_8 : Image::Depth_24) * numSlices;
+    }
+
+    memoryStats.textureBytes += renderTarget->memSize;
+
+    int handle = renderTargetList.FindNull();
+    if (handle == -1) {
+        handle = renderTargetList.Append(renderTarget);
+    } else {
+        renderTargetList[handle] = renderTarget;
+    }
+
+    if (recordFile) {
+        int32_t args[5 + COUNT_OF(renderTarget->colorTextureHandles) + 3];
+        int numArgs = 0;
+        args[numArgs++] = handle;
+        args[numArgs++] = type;
+        args[numArgs++] = width;
+        args[numArgs++] = height;
+        args[numArgs++] = numColorTextures;
+        for (int i = 0; i < numColorTextures; i++) {
+            args[numArgs++] = colorTextureHandles[i];
+        }
+        args[numArgs++] = depthTextureHandle;
+        args[numArgs++] = sRGB ? 1 : 0;
+        args[numArgs++] = flags;
+        Record(NullRHICmd_CreateRenderTarget, numArgs, args);
+    }
+
+    return (Handle)handle;
+}
+
+void NullRHI::DestroyRenderTarget(Handle renderTargetHandle) {
+    if (renderTargetHandle == NullRenderTarget) {
+        BE_WARNLOG(L"NullRHI::DestroyRenderTarget: invalid render target\n");
+        return;
+    }
+
+    if (currentContext->state->renderTargetHandleStackDepth > 0 && 
+        currentContext->state->renderTargetHandleStack[currentContext->state->renderTargetHandleStackDepth - 1] == renderTargetHandle) {
+        BE_WARNLOG(L"NullRHI::DestroyRenderTarget: render target is using\n");
+        return;
+    }
+
+    NULLRHI_RECORD(NullRHICmd_DestroyRenderTarget, renderTargetHandle);
+
+    NullRHIRenderTarget *renderTarget = renderTargetList[renderTargetHandle];
+
+    memoryStats.textureBytes -= renderTarget->memSize;
+
+    delete renderTarget;
+    renderTargetList[renderTargetHandle] = nullptr;
+}
+
+void NullRHI::BeginRenderTarget(Handle renderTargetHandle, int level, int sliceIndex, unsigned int mrtBitMask) {
+    if (currentContext->state->renderTargetHandleStackDepth > 0 && currentContext->state->renderTargetHandleStack[currentContext->state->renderTargetHandleStackDepth - 1] == renderTargetHandle) {
+        BE_WARNLOG(L"NullRHI::BeginRenderTarget: same render target\n");
+    }
+
+    NULLRHI_RECORD(NullRHICmd_BeginRenderTarget, renderTargetHandle, level, sliceIndex, (int32_t)mrtBitMask);
+
+    const NullRHIRenderTarget *renderTarget = renderTargetList[renderTargetHandle];
+    currentContext->state->renderTargetHandleStack[currentContext->state->renderTargetHandleStackDepth++] = currentContext->state->renderTargetHandle;
+    currentContext->state->renderTargetHandle = renderTargetHandle;
+
+    frameStats.numRenderTargetChanges++;
+
+    SetSRGBWrite(renderTarget->sRGB);
+}
+
+void NullRHI::EndRenderTarget() {
+    if (currentContext->state->renderTargetHandleStackDepth == 0) {
+        BE_WARNLOG(L"unmatched BeginRenderTarget() / EndRenderTarget()\n");
+        return;
+    }
+
+    NULLRHI_RECORD0(NullRHICmd_EndRenderTarget);
+
+    Handle oldRenderTargetHandle = currentContext->state->renderTargetHandleStack[--currentContext->state->renderTargetHandleStackDepth];
+    const NullRHIRenderTarget *oldRenderTarget = renderTargetList[oldRenderTargetHandle];
+
+    currentContext->state->renderTargetHandle = oldRenderTargetHandle;
+
+    frameStats.numRenderTargetChanges++;
+
+    SetSRGBWrite(oldRenderTarget->sRGB);
+}
+
+void NullRHI::BlitRenderTarget(Handle srcRenderTargetHandle, const Rect &srcRect, Handle dstRenderTargetHandle, const Rect &dstRect, int mask, int filter) const {
+}
+
+BE_NAMESPACE_END
@@ -0,0 +1,320 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Precompiled.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+#include "Containers/BinSearch.h"
+
+BE_NAMESPACE_BEGIN
+
+static bool IsTokenDelimiter(char c) {
+    return c == ';' || c == ',' || c == '[' || c == ']' || c == '{' || c == '}' || c == '(' || c == ')' || c == '=';
+}
+
+static const char *ReadToken(const char *text, char *token, int tokenSize) {
+    while (*text && (*text <= ' ' || (IsTokenDelimiter(*text) && *text != '{'))) {
+        text++;
+    }
+
+    int length = 0;
+    if (*text == '{') {
+        token[length++] = *text++;
+    } else {
+        while (*text > ' ' && !IsTokenDelimiter(*text)) {
+            if (length < tokenSize - 1) {
+                token[length++] = *text;
+            }
+            text++;
+        }
+    }
+    token[length] = '\0';
+    return text;
+}
+
+// Collects names of uniforms declared in GLSL source text.
+// The source is not preprocessed, so uniforms in inactive #if blocks are also collected.
+static void ParseUniforms(const char *text, Array<Str> &samplerNames, Array<Str> &uniformNames, Array<Str> &uniformBlockNames) {
+    char token[256];
+    char typeName[256];
+
+    while (*text) {
+        text = ReadToken(text, token, sizeof(token));
+        if (Str::Cmp(token, "uniform")) {
+            continue;
+        }
+
+        do {
+            text = ReadToken(text, typeName, sizeof(typeName));
+        } while (!Str::Cmp(typeName, "lowp") || !Str::Cmp(typeName, "mediump") || !Str::Cmp(typeName, "highp"));
+
+        text = ReadToken(text, token, sizeof(token));
+        if (!token[0]) {
+            break;
+        }
+
+        if (!Str::Cmp(token, "{")) {
+            uniformBlockNames.AddUnique(Str(typeName));
+        } else if (!Str::Cmpn(typeName, "sampler", 7)) {
+            samplerNames.AddUnique(Str(token));
+        } else {
+            uniformNames.AddUnique(Str(token));
+        }
+    }
+}
+
+static NullRHIName *AllocNames(const Array<Str> &names) {
+    if (names.Count() == 0) {
+        return nullptr;
+    }
+
+    NullRHIName *sortedNames = (NullRHIName *)Mem_Alloc(sizeof(NullRHIName) * names.Count());
+    for (int i = 0; i < names.Count(); i++) {
+        sortedNames[i].name = Mem_AllocString(names[i].c_str());
+        sortedNames[i].index = i;
+    }
+
+    std::sort(sortedNames, sortedNames + names.Count(), std::less<NullRHIName>());
+    return sortedNames;
+}
+
+RHI::Handle NullRHI::CreateShader(const char *name, const char *vsText, const char *fsText) {
+    Array<Str> samplerNames;
+    Array<Str> uniformNames;
+    Array<Str> uniformBlockNames;
+
+    ParseUniforms(vsText, samplerNames, uniformNames, uniformBlockNames);
+    ParseUniforms(fsText, samplerNames, uniformNames, uniformBlockNames);
+
+    NullRHIShader *shader = new NullRHIShader;
+    Str::Copynz(shader->name, name, COUNT_OF(shader->name));
+    shader->numSamplers = samplerNames.Count();
+    shader->samplers = AllocNames(samplerNames);
+    shader->numUniforms = uniformNames.Count();
+    shader->uniforms = AllocNames(uniformNames);
+    shader->numUniformBlocks = uniformBlockNames.Count();
+    shader->uniformBlocks = AllocNames(uniformBlockNames);
+
+    int handle = shaderList.FindNull();
+    if (handle == -1) {
+        handle = shaderList.Append(shader);
+    } else {
+        shaderList[handle] = shader;
+    }
+
+    NULLRHI_RECORD(NullRHICmd_CreateShader, handle);
+
+    return (Handle)handle;
+}
+
+void NullRHI::DestroyShader(Handle shaderHandle) {
+    if (currentContext->state->shaderHandle == shaderHandle) {
+        BindShader(NullShader);
+    }
+
+    NULLRHI_RECORD(NullRHICmd_DestroyShader, shaderHandle);
+
+    NullRHIShader *shader = shaderList[shaderHandle];
+    for (int i = 0; i < shader->numSamplers; i++) {
+        Mem_Free(shader->samplers[i].name);
+    }
+    for (int i = 0; i < shader->numUniforms; i++) {
+        Mem_Free(shader->uniforms[i].name);
+    }
+    for (int i = 0; i < shader->numUniformBlocks; i++) {
+        Mem_Free(shader->uniformBlocks[i].name);
+    }
+    Mem_Free(shader->samplers);
+    Mem_Free(shader->uniforms);
+    Mem_Free(shader->uniformBlocks);
+
+    delete shader;
+    shaderList[shaderHandle] = nullptr;
+}
+
+void NullRHI::BindShader(Handle shaderHandle) {
+    if (currentContext->state->shaderHandle == shaderHandle) {
+        return;
+    }
+
+    NULLRHI_RECORD(NullRHICmd_BindShader, shaderHandle);
+
+    currentContext->state->shaderHandle = shaderHandle;
+    frameStats.numShaderChanges++;
+}
+
+int NullRHI::GetSamplerUnit(Handle shaderHandle, const char *name) const {
+    const NullRHIShader *shader = shaderList[shaderHandle];
+    NullRHIName find;
+    find.name = const_cast<char *>(name);
+    int index = BinSearch_Equal<NullRHIName>(shader->samplers, shader->numSamplers, find);
+    if (index >= 0) {
+        return shader->samplers[index].index;
+    }
+    return -1;
+}
+
+void NullRHI::SetTexture(int unit, Handle textureHandle) {
+    SelectTextureUnit(unit);
+    BindTexture(textureHandle);
+}
+
+int NullRHI::GetShaderConstantIndex(int shaderHandle, const char *name) const {
+    const NullRHIShader *shader = shaderList[shaderHandle];
+    NullRHIName find;
+    find.name = const_cast<char *>(name);
+    return BinSearch_Equal<NullRHIName>(shader->uniforms, shader->numUniforms, find);
+}
+
+int NullRHI::GetShaderConstantBlockIndex(int shaderHandle, const char *name) const {
+    const NullRHIShader *shader = shaderList[shaderHandle];
+    NullRHIName find;
+    find.name = const_cast<char *>(name);
+    return BinSearch_Equal<NullRHIName>(shader->uniformBlocks, shader->numUniformBlocks, find);
+}
+
+void NullRHI::SetShaderConstantGeneric(int index, int bytes) const {
+    if (index < 0) {
+        return;
+    }
+
+    NULLRHI_RECORD(NullRHICmd_SetShaderConstant, index, bytes);
+
+    frameStats.numConstantUpdates++;
+}
+
+void NullRHI::SetShaderConstant1i(int index, const int constant) const {
+    SetShaderConstantGeneric(index, sizeof(int));
+}
+
+void NullRHI::SetShaderConstant2i(int index, const int *constant) const {
+    SetShaderConstantGeneric(index, sizeof(int) * 2);
+}
+
+void NullRHI::SetShaderConstant3i(int index, const int *constant) const {
+    SetShaderConstantGeneric(index, sizeof(int) * 3);
+}
+
+void NullRHI::SetShaderConstant4i(int index, const int *constant) const {
+    SetShaderConstantGeneric(index, sizeof(int) * 4);
+}
+
+void NullRHI::SetShaderConstant1f(int index, const float constant) const {
+    SetShaderConstantGeneric(index, sizeof(float));
+}
+
+void NullRHI::SetShaderConstant2f(int index, const float *constant) const {
+    SetShaderConstantGeneric(index, sizeof(float) * 2);
+}
+
+void NullRHI::SetShaderConstant3f(int index, const float *constant) const {
+    SetShaderConstantGeneric(index, sizeof(float) * 3);
+}
+
+void NullRHI::SetShaderConstant4f(int index, const float *constant) const {
+    SetShaderConstantGeneric(index, sizeof(float) * 4);
+}
+
+void NullRHI::SetShaderConstant2f(int index, const Vec2 &constant) const {
+    SetShaderConstantGeneric(index, sizeof(Vec2));
+}
+
+void NullRHI::SetShaderConstant3f(int index, const Vec3 &constant) const {
+    SetShaderConstantGeneric(index, sizeof(Vec3));
+}
+
+void NullRHI::SetShaderConstant4f(int index, const Vec4 &constant) const {
+    SetShaderConstantGeneric(index, sizeof(Vec4));
+}
+
+void NullRHI::SetShaderConstant2x2f(int index, bool rowMajor, const Mat2 &constant) const {
+    SetShaderConstantGeneric(index, sizeof(Mat2));
+}
+
+void NullRHI::SetShaderConstant3x3f(int index, bool rowMajor, const Mat3 &constant) const {
+    SetShaderConstantGeneric(index, sizeof(Mat3));
+}
+
+void NullRHI::SetShaderConstant4x4f(int index, bool rowMajor, const Mat4 &constant) const {
+    SetShaderConstantGeneric(index, sizeof(Mat4));
+}
+
+void NullRHI::SetShaderConstant4x3f(int index, bool rowMajor, const Mat3x4 &constant) const {
+    SetShaderConstantGeneric(index, sizeof(Mat3x4));
+}
+
+void NullRHI::SetShaderConstantArray1i(int index, int count, const int *constant) const {
+    SetShaderConstantGeneric(index, sizeof(int) * count);
+}
+
+void NullRHI::SetShaderConstantArray2i(int index, int count, const int *constant) const {
+    SetShaderConstantGeneric(index, sizeof(int) * 2 * count);
+}
+
+void NullRHI::SetShaderConstantArray3i(int index, int count, const int *constant) const {
+    SetShaderConstantGeneric(index, sizeof(int) * 3 * count);
+}
+
+void NullRHI::SetShaderConstantArray4i(int index, int count, const int *constant) const {
+    SetShaderConstantGeneric(index, sizeof(int) * 4 * count);
+}
+
+void NullRHI::SetShaderConstantArray1f(int index, int count, const float *constant) const {
+    SetShaderConstantGeneric(index, sizeof(float) * count);
+}
+
+void NullRHI::SetShaderConstantArray2f(int index, int count, const float *constant) const {
+    SetShaderConstantGeneric(index, sizeof(float) * 2 * count);
+}
+
+void NullRHI::SetShaderConstantArray3f(int index, int count, const float *constant) const {
+    SetShaderConstantGeneric(index, sizeof(float) * 3 * count);
+}
+
+void NullRHI::SetShaderConstantArray4f(int index, int count, const float *constant) const {
+    SetShaderConstantGeneric(index, sizeof(float) * 4 * count);
+}
+
+void NullRHI::SetShaderConstantArray2f(int index, int count, const Vec2 *constant) const {
+    SetShaderConstantGeneric(index, sizeof(Vec2) * count);
+}
+
+void NullRHI::SetShaderConstantArray3f(int index, int count, const Vec3 *constant) const {
+    SetShaderConstantGeneric(index, sizeof(Vec3) * count);
+}
+
+void NullRHI::SetShaderConstantArray4f(int index, int count, const Vec4 *constant) const {
+    SetShaderConstantGeneric(index, sizeof(Vec4) * count);
+}
+
+void NullRHI::SetShaderConstantArray2x2f(int index, bool rowMajor, int count, const Mat2 *constant) const {
+    SetShaderConstantGeneric(index, sizeof(Mat2) * count);
+}
+
+void NullRHI::SetShaderConstantArray3x3f(int index, bool rowMajor, int count, const Mat3 *constant) const {
+    SetShaderConstantGeneric(index, sizeof(Mat3) * count);
+}
+
+void NullRHI::SetShaderConstantArray4x4f(int index, bool rowMajor, int count, const Mat4 *constant) const {
+    SetShaderConstantGeneric(index, sizeof(Mat4) * count);
+}
+
+void NullRHI::SetShaderConstantArray4x3f(int index, bool rowMajor, int count, const Mat3x4 *constant) const {
+    SetShaderConstantGeneric(index, sizeof(Mat3x4) * count);
+}
+
+void NullRHI::SetShaderConstantBlock(int index, int bindingIndex) {
+    NULLRHI_RECORD(NullRHICmd_SetShaderConstantBlock, index, bindingIndex);
+}
+
+BE_NAMESPACE_END
@@ -0,0 +1,170 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Precompiled.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+
+BE_NAMESPACE_BEGIN
+
+void NullRHI::SetDefaultState() {
+    *currentContext->state = NullRHIState();
+
+    SetStateBits(ColorWrite | AlphaWrite | DepthWrite | DF_LEqual);
+    SetCullFace(BackCull);
+}
+
+void NullRHI::SetStateBits(unsigned int stateBits) {
+    if (currentContext->state->renderState != stateBits) {
+        NULLRHI_RECORD(NullRHICmd_SetStateBits, (int32_t)stateBits);
+
+        currentContext->state->renderState = stateBits;
+        frameStats.numStateChanges++;
+    }
+}
+
+void NullRHI::SetCullFace(int cull) {
+    if (currentContext->state->cull != cull) {
+        NULLRHI_RECORD(NullRHICmd_SetCullFace, cull);
+
+        currentContext->state->cull = cull;
+        frameStats.numStateChanges++;
+    }
+}
+
+void NullRHI::SetDepthBias(float slopeScaleBias, float constantBias) {
+    float *depthBias = currentContext->state->depthBias;
+    if (depthBias[0] != slopeScaleBias || depthBias[1] != constantBias) {
+        NULLRHI_RECORD(NullRHICmd_SetDepthBias, NullRHIFloatArg(slopeScaleBias), NullRHIFloatArg(constantBias));
+
+        depthBias[0] = slopeScaleBias;
+        depthBias[1] = constantBias;
+        frameStats.numStateChanges++;
+    }
+}
+
+void NullRHI::SetDepthRange(float znear, float zfar) {
+    float *depthRange = currentContext->state->depthRange;
+    if (depthRange[0] != znear || depthRange[1] != zfar) {
+        NULLRHI_RECORD(NullRHICmd_SetDepthRange, NullRHIFloatArg(znear), NullRHIFloatArg(zfar));
+
+        depthRange[0] = znear;
+        depthRange[1] = zfar;
+        frameStats.numStateChanges++;
+    }
+}
+
+void NullRHI::SetDepthClamp(bool enable) {
+}
+
+void NullRHI::SetDepthBounds(float zmin, float zmax) {
+}
+
+void NullRHI::SetViewport(const Rect &viewportRect) {
+    if (currentContext->state->viewportRect != viewportRect) {
+        NULLRHI_RECORD(NullRHICmd_SetViewport, viewportRect.x, viewportRect.y, viewportRect.w, viewportRect.h);
+
+        currentContext->state->viewportRect = viewportRect;
+        frameStats.numStateChanges++;
+    }
+}
+
+void NullRHI::SetScissor(const Rect &scissorRect) {
+    if (currentContext->state->scissorRect != scissorRect) {
+        NULLRHI_RECORD(NullRHICmd_SetScissor, scissorRect.x, scissorRect.y, scissorRect.w, scissorRect.h);
+
+        currentContext->state->scissorRect = scissorRect;
+        frameStats.numStateChanges++;
+    }
+}
+
+void NullRHI::SetSRGBWrite(bool enable) {
+    if (currentContext->state->sRGBWrite != enable) {
+        NULLRHI_RECORD(NullRHICmd_SetSRGBWrite, enable ? 1 : 0);
+
+        currentContext->state->sRGBWrite = enable;
+        frameStats.numStateChanges++;
+    }
+}
+
+void NullRHI::EnableLineSmooth(bool enable) {
+}
+
+float NullRHI::GetLineWidth() const {
+    return currentContext->state->lineWidth;
+}
+
+void NullRHI::SetLineWidth(float width) {
+    if (currentContext->state->lineWidth != width) {
+        NULLRHI_RECORD(NullRHICmd_SetLineWidth, NullRHIFloatArg(width));
+
+        currentContext->state->lineWidth = width;
+        frameStats.numStateChanges++;
+    }
+}
+
+RHI::Handle NullRHI::CreateStencilState(int readMask, int writeMask, StencilFunc funcBack, int failBack, int zfailBack, int zpassBack, StencilFunc funcFront, int failFront, int zfailFront, int zpassFront) {
+    NullRHIStencilState *stencilState = new NullRHIStencilState;
+    stencilState->readMask = readMask;
+    stencilState->writeMask = writeMask;
+
+    int handle = stencilStateList.FindNull();
+    if (handle == -1) {
+        handle = stencilStateList.Append(stencilState);
+    } else {
+        stencilStateList[handle] = stencilState;
+    }
+
+    NULLRHI_RECORD(NullRHICmd_CreateStencilState, handle, readMask, writeMask, funcBack, failBack, zfailBack, zpassBack, funcFront, failFront, zfailFront, zpassFront);
+
+    return (Handle)handle;
+}
+
+void NullRHI::DestroyStencilState(Handle stencilStateHandle) {
+    NULLRHI_RECORD(NullRHICmd_DestroyStencilState, stencilStateHandle);
+
+    if (currentContext->state->stencilStateHandle == stencilStateHandle) {
+        currentContext->state->stencilStateHandle = NullStencilState;
+    }
+
+    delete stencilStateList[stencilStateHandle];
+    stencilStateList[stencilStateHandle] = nullptr;
+}
+
+void NullRHI::SetStencilState(Handle stencilStateHandle, int ref) {
+    if (currentContext->state->stencilStateHandle != stencilStateHandle || currentContext->state->stencilRef != ref) {
+        NULLRHI_RECORD(NullRHICmd_SetStencilState, stencilStateHandle, ref);
+
+        currentContext->state->stencilStateHandle = stencilStateHandle;
+        currentContext->state->stencilRef = ref;
+        frameStats.numStateChanges++;
+    }
+}
+
+unsigned int NullRHI::GetStateBits() const { 
+    return currentContext->state->renderState;
+}
+
+const Rect &NullRHI::GetViewport() const { 
+    return currentContext->state->viewportRect;
+}
+
+int NullRHI::GetCullFace() const { 
+    return currentContext->state->cull;
+}
+
+const Rect &NullRHI::GetScissor() const { 
+    return currentContext->state->scissorRect;
+}
+
+BE_NAMESPACE_END
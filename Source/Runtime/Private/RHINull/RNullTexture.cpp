@@ -0,0 +1,302 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Precompiled.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+
+BE_NAMESPACE_BEGIN
+
+static int NumMipmapLevels(int width, int height, int depth) {
+    int maxSize = Max3(width, height, depth);
+    int numLevels = 1;
+    while (maxSize > 1) {
+        maxSize >>= 1;
+        numLevels++;
+    }
+    return numLevels;
+}
+
+RHI::Handle NullRHI::CreateTexture(TextureType type) {
+    NullRHITexture *texture = new NullRHITexture;
+    memset(texture, 0, sizeof(*texture));
+    texture->type = type;
+    texture->format = Image::UnknownFormat;
+
+    int handle = textureList.FindNull();
+    if (handle == -1) {
+        handle = textureList.Append(texture);
+    } else {
+        textureList[handle] = texture;
+    }
+
+    memoryStats.numTextures++;
+
+    NULLRHI_RECORD(NullRHICmd_CreateTexture, handle, type);
+
+    return (Handle)handle;
+}
+
+void NullRHI::DestroyTexture(Handle textureHandle) {
+    NULLRHI_RECORD(NullRHICmd_DestroyTexture, textureHandle);
+
+    NullRHITexture *texture = textureList[textureHandle];
+    assert(texture);
+
+    for (int i = 0; i < MaxTMU; i++) {
+        if (currentContext->state->textureHandles[i] == textureHandle) {
+            currentContext->state->textureHandles[i] = NullTexture;
+        }
+    }
+
+    memoryStats.numTextures--;
+    memoryStats.textureBytes -= texture->memSize;
+
+    delete texture;
+    textureList[textureHandle] = nullptr;
+}
+
+void NullRHI::SelectTextureUnit(unsigned int unit) {
+    assert(unit < MaxTMU);
+
+    if (currentContext->state->tmu != unit) {
+        NULLRHI_RECORD(NullRHICmd_SelectTextureUnit, (int32_t)unit);
+
+        currentContext->state->tmu = unit;
+    }
+}
+
+void NullRHI::BindTexture(Handle textureHandle) {
+    Handle *textureHandlePtr = &currentContext->state->textureHandles[currentContext->state->tmu];
+    if (*textureHandlePtr != textureHandle) {
+        NULLRHI_RECORD(NullRHICmd_BindTexture, textureHandle);
+
+        *textureHandlePtr = textureHandle;
+        frameStats.numTextureChanges++;
+    }
+}
+
+void NullRHI::SetTextureAddressMode(AddressMode addressMode) {
+}
+
+void NullRHI::SetTextureFilter(TextureFilter filter) {
+}
+
+void NullRHI::SetTextureAnisotropy(int aniso) {
+}
+
+void NullRHI::SetTextureBorderColor(const Color4 &rgba) {
+}
+
+void NullRHI::SetTextureShadowFunc(bool set) {
+}
+
+void NullRHI::SetTextureLODBias(float bias) {
+}
+
+void NullRHI::SetTextureLevel(int baseLevel, int maxLevel) {
+}
+
+void NullRHI::GenerateMipmap() {
+    NullRHITexture *texture = textureList[currentContext->state->textureHandles[currentContext->state->tmu]];
+    assert(texture);
+
+    int numMipmaps = NumMipmapLevels(texture->width, texture->height, texture->depth);
+    if (texture->numMipmaps != numMipmaps) {
+        SetTextureStorage((TextureType)texture->type, texture->width, texture->height, texture->depth, numMipmaps, texture->numSlices, texture->format, 0);
+    }
+}
+
+void NullRHI::AdjustTextureSize(TextureType type, bool useNPOT, int inWidth, int inHeight, int inDepth, int *outWidth, int *outHeight, int *outDepth) {
+    int w, h, d;
+
+    if (useNPOT || type == TextureRectangle) {
+        w = inWidth;
+        h = inHeight;
+        d = inDepth;
+    } else {
+        w = Math::CeilPowerOfTwo(inWidth);
+        h = Math::CeilPowerOfTwo(inHeight);
+        d = Math::CeilPowerOfTwo(inDepth);
+    }
+
+    switch (type) {
+    case Texture2D:
+    case Texture2DArray:
+        if (w > hwLimit.maxTextureSize) w = hwLimit.maxTextureSize;
+        if (h > hwLimit.maxTextureSize) h = hwLimit.maxTextureSize;
+        break;
+    case Texture3D:
+        if (w > hwLimit.max3dTextureSize) w = hwLimit.max3dTextureSize;
+        if (h > hwLimit.max3dTextureSize) h = hwLimit.max3dTextureSize;
+        if (d > hwLimit.max3dTextureSize) d = hwLimit.max3dTextureSize;
+        break;
+    case TextureCubeMap:
+        if (w > hwLimit.maxCubeMapTextureSize) w = hwLimit.maxCubeMapTextureSize;
+        if (h > hwLimit.maxCubeMapTextureSize) h = hwLimit.maxCubeMapTextureSize;
+
+        if (w < h) {
+            h = w;
+        } else {
+            w = h;
+        }
+        break;
+    case TextureRectangle:
+        if (w > hwLimit.maxRectangleTextureSize) w = hwLimit.maxRectangleTextureSize;
+        if (h > hwLimit.maxRectangleTextureSize) h = hwLimit.maxRectangleTextureSize;
+        break;
+    default:
+        assert(0);
+        break;
+    }
+
+    if (outWidth) *outWidth = w;
+    if (outHeight) *outHeight = h;
+    if (outDepth) *outDepth = d;
+}
+
+void NullRHI::AdjustTextureFormat(TextureType type, bool useCompression, bool useNormalMap, Image::Format inFormat, Image::Format *outFormat) {
+    // The null device stores any format, so the source format is kept unless compression is requested
+    if (!useCompression || Image::IsCompressed(inFormat) || Image::IsDepthFormat(inFormat) || Image::IsDepthStencilFormat(inFormat)) {
+        *outFormat = inFormat;
+        return;
+    }
+
+    int redBits, greenBits, blueBits, alphaBits;
+    Image::GetBits(inFormat, &redBits, &greenBits, &blueBits, &alphaBits);
+
+    *outFormat = inFormat;
+
+    if (redBits > 0 && greenBits > 0 && blueBits > 0) {
+        if (Image::IsFloatFormat(inFormat)) {
+            if (alphaBits == 0) {
+                *outFormat = Image::RGBE_9_9_9_5;
+            }
+        } else if (useNormalMap) {
+            *outFormat = Image::DXN2;
+        } else if (alphaBits <= 1) {
+            *outFormat = Image::RGBA_DXT1;
+        } else if (alphaBits <= 4) {
+            *outFormat = Image::RGBA_DXT3;
+        } else {
+            *outFormat = Image::RGBA_DXT5;
+        }
+    }
+}
+
+void NullRHI::SetTextureStorage(TextureType type, int width, int height, int depth, int numMipmaps, int numSlices, Image::Format format, int64_t uploadBytes) {
+    NULLRHI_RECORD(NullRHICmd_SetTextureImage, type, width, height, depth, numMipmaps, numSlices, format, (int32_t)uploadBytes);
+
+    NullRHITexture *texture = textureList[currentContext->state->textureHandles[currentContext->state->tmu]];
+    assert(texture);
+
+    memoryStats.textureBytes -= texture->memSize;
+
+    texture->width = width;
+    texture->height = height;
+    texture->depth = depth;
+    texture->numMipmaps = numMipmaps;
+    texture->numSlices = numSlices;
+    texture->format = format;
+    texture->memSize = (type == TextureBuffer) ? 0 : (int64_t)Image::MemRequired(width, height, depth, numMipmaps, format) * numSlices;
+
+    memoryStats.textureBytes += texture->memSize;
+
+    frameStats.textureUploadBytes += uploadBytes;
+}
+
+void NullRHI::SetTextureImage(TextureType textureType, const Image *srcImage, Image::Format dstFormat, bool useMipmaps, bool useSRGB) {
+    int numMipmaps = srcImage->NumMipmaps();
+    if (useMipmaps && numMipmaps == 1) {
+        numMipmaps = NumMipmapLevels(srcImage->GetWidth(), srcImage->GetHeight(), srcImage->GetDepth());
+    }
+
+    int64_t uploadBytes = srcImage->GetPixels() ? (int64_t)srcImage->GetSliceSize(0, srcImage->NumMipmaps()) * srcImage->NumSlices() : 0;
+
+    SetTextureStorage(textureType, srcImage->GetWidth(), srcImage->GetHeight(), srcImage->GetDepth(), numMipmaps, srcImage->NumSlices(), dstFormat, uploadBytes);
+}
+
+void NullRHI::SetTextureImageBuffer(Image::Format dstFormat, bool useSRGB, int bufferHandle) {
+    NullRHITexture *texture = textureList[currentContext->state->textureHandles[currentContext->state->tmu]];
+    assert(texture);
+
+    texture->format = dstFormat;
+}
+
+void NullRHI::SetTextureSubImage2D(int level, int xoffset, int yoffset, int width, int height, Image::Format srcFormat, const void *pixels) {
+    int size = Image::MemRequired(width, height, 1, 1, srcFormat);
+
+    NULLRHI_RECORD(NullRHICmd_SetTextureSubImage, size);
+
+    frameStats.textureUploadBytes += size;
+}
+
+void NullRHI::SetTextureSubImage3D(int level, int xoffset, int yoffset, int zoffset, int width, int height, int depth, Image::Format srcFormat, const void *pixels) {
+    int size = Image::MemRequired(width, height, depth, 1, srcFormat);
+
+    NULLRHI_RECORD(NullRHICmd_SetTextureSubImage, size);
+
+    frameStats.textureUploadBytes += size;
+}
+
+void NullRHI::SetTextureSubImage2DArray(int level, int xoffset, int yoffset, int zoffset, int width, int height, int arrays, Image::Format srcFormat, const void *pixels) {
+    int size = Image::MemRequired(width, height, 1, 1, srcFormat) * arrays;
+
+    NULLRHI_RECORD(NullRHICmd_SetTextureSubImage, size);
+
+    frameStats.textureUploadBytes += size;
+}
+
+void NullRHI::SetTextureSubImageCube(CubeMapFace face, int level, int xoffset, int yoffset, int width, int height, Image::Format srcFormat, const void *pixels) {
+    int size = Image::MemRequired(width, height, 1, 1, srcFormat);
+
+    NULLRHI_RECORD(NullRHICmd_SetTextureSubImage, size);
+
+    frameStats.textureUploadBytes += size;
+}
+
+void NullRHI::SetTextureSubImageRect(int xoffset, int yoffset, int width, int height, Image::Format srcFormat, const void *pixels) {
+    int size = Image::MemRequired(width, height, 1, 1, srcFormat);
+
+    NULLRHI_RECORD(NullRHICmd_SetTextureSubImage, size);
+
+    frameStats.textureUploadBytes += size;
+}
+
+void NullRHI::CopyTextureSubImage2D(int xoffset, int yoffset, int x, int y, int width, int height) {
+}
+
+void NullRHI::GetTextureImage2D(int level, Image::Format dstFormat, void *pixels) {
+    const NullRHITexture *texture = textureList[currentContext->state->textureHandles[currentContext->state->tmu]];
+    int w = Max(texture->width >> level, 1);
+    int h = Max(texture->height >> level, 1);
+    memset(pixels, 0, Image::MemRequired(w, h, 1, 1, dstFormat));
+}
+
+void NullRHI::GetTextureImage3D(int level, Image::Format dstFormat, void *pixels) {
+    const NullRHITexture *texture = textureList[currentContext->state->textureHandles[currentContext->state->tmu]];
+    int w = Max(texture->width >> level, 1);
+    int h = Max(texture->height >> level, 1);
+    int d = Max(texture->depth >> level, 1);
+    memset(pixels, 0, Image::MemRequired(w, h, d, 1, dstFormat));
+}
+
+void NullRHI::GetTextureImageCube(CubeMapFace face, int level, Image::Format dstFormat, void *pixels) {
+    GetTextureImage2D(level, dstFormat, pixels);
+}
+
+void NullRHI::GetTextureImageRect(Image::Format dstFormat, void *pixels) {
+    GetTextureImage2D(0, dstFormat, pixels);
+}
+
+BE_NAMESPACE_END
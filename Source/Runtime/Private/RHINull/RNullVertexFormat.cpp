@@ -0,0 +1,106 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Precompiled.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+
+BE_NAMESPACE_BEGIN
+
+static const int typeSize[] = {
+    sizeof(int8_t),
+    sizeof(uint8_t),
+    sizeof(int32_t),
+    sizeof(uint32_t),
+    sizeof(float),
+    sizeof(uint16_t)
+};
+
+RHI::Handle NullRHI::CreateVertexFormat(int numElements, const VertexElement *elements) {
+    NullRHIVertexFormat *vertexFormat = new NullRHIVertexFormat;
+    vertexFormat->numElements = numElements;
+
+    memset(vertexFormat->vertexSize, 0, sizeof(vertexFormat->vertexSize));
+
+    for (int i = 0; i < numElements; i++) {
+        const VertexElement *element = &elements[i];
+
+        vertexFormat->elements[i] = *element;
+        vertexFormat->vertexSize[element->stream] += GetTypeSize(element->type) * element->components;
+    }
+
+    int handle = vertexFormatList.FindNull();
+    if (handle == -1) {
+        handle = vertexFormatList.Append(vertexFormat);
+    } else {
+        vertexFormatList[handle] = vertexFormat;
+    }
+
+    if (recordFile) {
+        int32_t args[2 + VertexElement::MaxUsages * 7];
+        int numArgs = 0;
+        args[numArgs++] = handle;
+        args[numArgs++] = numElements;
+        for (int i = 0; i < numElements; i++) {
+            args[numArgs++] = elements[i].stream;
+            args[numArgs++] = elements[i].offset;
+            args[numArgs++] = elements[i].usage;
+            args[numArgs++] = elements[i].components;
+            args[numArgs++] = elements[i].type;
+            args[numArgs++] = elements[i].normalize ? 1 : 0;
+            args[numArgs++] = elements[i].divisor;
+        }
+        Record(NullRHICmd_CreateVertexFormat, numArgs, args);
+    }
+
+    return (Handle)handle;
+}
+
+void NullRHI::DestroyVertexFormat(Handle vertexFormatHandle) {
+    if (currentContext->state->vertexFormatHandle == vertexFormatHandle) {
+        SetVertexFormat(NullVertexFormat);
+    }
+
+    NULLRHI_RECORD(NullRHICmd_DestroyVertexFormat, vertexFormatHandle);
+
+    delete vertexFormatList[vertexFormatHandle];
+    vertexFormatList[vertexFormatHandle] = nullptr;
+}
+
+int NullRHI::GetTypeSize(const VertexElement::Type type) const {
+    return typeSize[type];
+}
+
+void NullRHI::SetVertexFormat(Handle vertexFormatHandle) {
+    if (currentContext->state->vertexFormatHandle == vertexFormatHandle) {
+        return;
+    }
+
+    NULLRHI_RECORD(NullRHICmd_SetVertexFormat, vertexFormatHandle);
+
+    currentContext->state->vertexFormatHandle = vertexFormatHandle;
+    frameStats.numStateChanges++;
+}
+
+void NullRHI::SetStreamSource(int stream, Handle vertexBufferHandle, int base, int stride) {
+    assert(stream >= 0 && stream < MaxVertexStream);
+
+    NULLRHI_RECORD(NullRHICmd_SetStreamSource, stream, vertexBufferHandle, base, stride);
+
+    if (currentContext->state->streamHandles[stream] != vertexBufferHandle) {
+        currentContext->state->streamHandles[stream] = vertexBufferHandle;
+        frameStats.numBufferChanges++;
+    }
+}
+
+BE_NAMESPACE_END
@@ -17,6 +17,7 @@
 #include "Core/JointPose.h"
 #include "Simd/Simd.h"
 #include "Simd/Simd.h"
+#include "Core/Profiler.h"
 
 //#define CYCLIC_DELTA_MOVEMENT
 
@@ -217,6 +218,9 @@ Anim *Anim::CreateAdditiveAnim(const Anim *refAnim, int numJointIndexes, const i
 }
 
 bool Anim::Load(const char *filename) {
+    BE_PROFILE_SCOPE("Anim::Load");
+    MemTagScope memTagScope(MemTag::Anim);
+
     Purge();
 
     Str bAnimFilename = filename;
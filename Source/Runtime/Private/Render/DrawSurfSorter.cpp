@@ -0,0 +1,140 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Render/Render.h"
+#include "Core/JobSystem.h"
+
+BE_NAMESPACE_BEGIN
+
+static const int RadixBits = 8;
+static const int RadixSize = 1 << RadixBits;
+static const int NumPasses = 64 / RadixBits;
+
+// Calls func(chunkIndex) for each chunk, in parallel if there are more than one chunk.
+template <typename Func>
+static void ForEachChunk(int numChunks, const Func &func) {
+    if (numChunks > 1) {
+        jobSystem.ParallelFor(numChunks, 1, [&func](int first, int last) {
+            for (int chunkIndex = first; chunkIndex < last; chunkIndex++) {
+                func(chunkIndex);
+            }
+        });
+    } else {
+        func(0);
+    }
+}
+
+DrawSurfSorter::SortKey *DrawSurfSorter::SetKeys(int count) {
+    keys[0].SetCount(count, false);
+    keys[1].SetCount(count, false);
+
+    return keys[0].Ptr();
+}
+
+const DrawSurfSorter::SortKey *DrawSurfSorter::Sort(bool allowParallel) {
+    const int numKeys = keys[0].Count();
+    if (numKeys == 0) {
+        return keys[0].Ptr();
+    }
+
+    int numChunks = 1;
+    if (allowParallel && numKeys >= MinParallelKeys && jobSystem.IsInitialized() && jobSystem.NumThreads() > 1) {
+        numChunks = Min(jobSystem.NumThreads(), (int)MaxChunks);
+    }
+    const int chunkSize = (numKeys + numChunks - 1) / numChunks;
+
+    histograms.SetCount(numChunks * NumPasses * RadixSize, false);
+    offsets.SetCount(numChunks * RadixSize, false);
+
+    SortKey *src = keys[0].Ptr();
+    SortKey *dst = keys[1].Ptr();
+    uint32_t *chunkHistograms = histograms.Ptr();
+    uint32_t *chunkOffsets = offsets.Ptr();
+
+    // Count all the byte histograms at once
+    ForEachChunk(numChunks, [=](int chunkIndex) {
+        const int first = chunkIndex * chunkSize;
+        const int last = Min(first + chunkSize, numKeys);
+        uint32_t *histogram = chunkHistograms + chunkIndex * NumPasses * RadixSize;
+
+        memset(histogram, 0, NumPasses * RadixSize * sizeof(histogram[0]));
+
+        for (int i = first; i < last; i++) {
+            const uint64_t sortKey = src[i].sortKey;
+
+            for (int pass = 0; pass < NumPasses; pass++) {
+                histogram[pass * RadixSize + ((sortKey >> (pass * RadixBits)) & (RadixSize - 1))]++;
+            }
+        }
+    });
+
+    bool firstPass = true;
+
+    for (int pass = 0; pass < NumPasses; pass++) {
+        const int shift = pass * RadixBits;
+
+        // Skip this pass if all keys have the same byte
+        const int firstByte = (src[0].sortKey >> shift) & (RadixSize - 1);
+        int sameByteCount = 0;
+        for (int chunkIndex = 0; chunkIndex < numChunks; chunkIndex++) {
+            sameByteCount += chunkHistograms[(chunkIndex * NumPasses + pass) * RadixSize + firstByte];
+        }
+        if (sameByteCount == numKeys) {
+            continue;
+        }
+
+        // Chunk histograms are counted in the original order, so recount them for the reordered keys.
+        // A single chunk histogram covers all the keys and doesn't depend on the order.
+        if (numChunks > 1 && !firstPass) {
+            ForEachChunk(numChunks, [=](int chunkIndex) {
+                const int first = chunkIndex * chunkSize;
+                const int last = Min(first + chunkSize, numKeys);
+                uint32_t *histogram = chunkHistograms + (chunkIndex * NumPasses + pass) * RadixSize;
+
+                memset(histogram, 0, RadixSize * sizeof(histogram[0]));
+
+                for (int i = first; i < last; i++) {
+                    histogram[(src[i].sortKey >> shift) & (RadixSize - 1)]++;
+                }
+            });
+        }
+        firstPass = false;
+
+        // Destination offsets of each bucket in each chunk, chunks in order to keep the sort stable
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < RadixSize; bucket++) {
+            for (int chunkIndex = 0; chunkIndex < numChunks; chunkIndex++) {
+                chunkOffsets[chunkIndex * RadixSize + bucket] = offset;
+                offset += chunkHistograms[(chunkIndex * NumPasses + pass) * RadixSize + bucket];
+            }
+        }
+
+        ForEachChunk(numChunks, [=](int chunkIndex) {
+            const int first = chunkIndex * chunkSize;
+            const int last = Min(first + chunkSize, numKeys);
+            uint32_t *bucketOffsets = chunkOffsets + chunkIndex * RadixSize;
+
+            for (int i = first; i < last; i++) {
+                dst[bucketOffsets[(src[i].sortKey >> shift) & (RadixSize - 1)]++] = src[i];
+            }
+        });
+
+        Swap(src, dst);
+    }
+
+    return src;
+}
+
+BE_NAMESPACE_END
@@ -20,87 +20,206 @@
 
 BE_NAMESPACE_BEGIN
 
-static const int MEMORY_BLOCK_SIZE = 0x100000;
+// Allocations larger than this fraction of the block size get dedicated blocks
+static const int LARGE_ALLOC_DIVISOR = 4;
 
 FrameData   frameData;
 
-void FrameData::Init() {
-    Shutdown();
+struct FrameDataThreadArena {
+    void *                  block;
+    uint32_t                frameCount;
+};
+
+// Memory block of the calling thread, valid only while frameCount matches
+static thread_local FrameDataThreadArena threadArena = { nullptr, 0 };
+
+FrameData::MemBlock *FrameData::AllocMemBlock(int size) {
+    MemTagScope memTagScope(MemTag::FrameData);
 
-    int size = MEMORY_BLOCK_SIZE;
     MemBlock *block = (MemBlock *)Mem_Alloc(sizeof(*block) + 15 + size);
     if (!block) {
-        BE_FATALERROR(L"FrameData::Init: failed to allocate memory");
+        BE_FATALERROR(L"FrameData::AllocMemBlock: Mem_Alloc() failed");
     }
     block->base = (byte *)AlignUp((intptr_t)block + sizeof(*block), 16);
     block->size = size;
     block->used = 0;
     block->next = nullptr;
+    block->nextFree = nullptr;
+    return block;
+}
+
+void FrameData::Init() {
+    Shutdown();
+
+    blockSize = AlignUp(Max(r_frameDataBlockSize.GetInteger(), 64) * 1024, 16);
 
-    this->mem = block;
-    this->alloc = block;
-    this->commands.used = 0;
+    for (int i = 0; i < NumFrames; i++) {
+        Frame *frame = &frames[i];
+
+        MemBlock *block = AllocMemBlock(blockSize);
+        frame->blocks.store(block);
+        frame->freeBlocks.store(block);
+        frame->largeBlocks.store(nullptr);
+        frame->commands.used = 0;
+    }
+
+    currentFrame = 0;
+    // Keep increasing so that thread local blocks of the previous initialization are never used
+    frameCount++;
+
+    memset(&lastFrameStats, 0, sizeof(lastFrameStats));
+    memset(&peakStats, 0, sizeof(peakStats));
 }
 
 void FrameData::Shutdown() {
-    MemBlock *nextBlock;
-    for (MemBlock *block = this->mem; block; block = nextBlock) {
-        nextBlock = block->next;
-        Mem_Free(block);
+    for (int i = 0; i < NumFrames; i++) {
+        MemBlock *nextBlock;
+        for (MemBlock *block = frames[i].blocks.load(); block; block = nextBlock) {
+            nextBlock = block->next;
+            Mem_Free(block);
+        }
+        for (MemBlock *block = frames[i].largeBlocks.load(); block; block = nextBlock) {
+            nextBlock = block->next;
+            Mem_Free(block);
+        }
+
+        frames[i].blocks.store(nullptr);
+        frames[i].freeBlocks.store(nullptr);
+        frames[i].largeBlocks.store(nullptr);
     }
-    
-    this->mem = nullptr;
+
+    blockSize = 0;
+    // Invalidates thread local blocks which are freed above
+    frameCount++;
 }
 
-void FrameData::ToggleFrame() {
-    // reset the mem allocation to the first block
-    this->alloc = this->mem;
+void FrameData::UpdateStats() {
+    const Frame *frame = &frames[currentFrame];
 
-    // clear all the blocks
-    for (MemBlock *block = this->mem; block; block = block->next) {
-        block->used = 0;
+    memset(&lastFrameStats, 0, sizeof(lastFrameStats));
+
+    for (const MemBlock *block = frame->blocks.load(); block; block = block->next) {
+        if (block->used > 0) {
+            lastFrameStats.usedBytes += block->used;
+            lastFrameStats.numBlocks++;
+        }
+    }
+
+    for (const MemBlock *block = frame->largeBlocks.load(); block; block = block->next) {
+        lastFrameStats.largeBytes += block->size;
+        lastFrameStats.numLargeAllocs++;
+    }
+
+    lastFrameStats.usedBytes += lastFrameStats.largeBytes;
+
+    peakStats.usedBytes = Max(peakStats.usedBytes, lastFrameStats.usedBytes);
+    peakStats.largeBytes = Max(peakStats.largeBytes, lastFrameStats.largeBytes);
+    peakStats.numBlocks = Max(peakStats.numBlocks, lastFrameStats.numBlocks);
+    peakStats.numLargeAllocs = Max(peakStats.numLargeAllocs, lastFrameStats.numLargeAllocs);
+
+    if (r_showFrameData.GetBool()) {
+        BE_LOG(L"%08d: used(%hs) blocks(%i) large(%hs, %i) : used(%hs) blocks(%i) large(%hs, %i)\n", 
+            frameCount,
+            Str::FormatBytes((int)lastFrameStats.usedBytes).c_str(), lastFrameStats.numBlocks,
+            Str::FormatBytes((int)lastFrameStats.largeBytes).c_str(), lastFrameStats.numLargeAllocs,
+            Str::FormatBytes((int)peakStats.usedBytes).c_str(), peakStats.numBlocks,
+            Str::FormatBytes((int)peakStats.largeBytes).c_str(), peakStats.numLargeAllocs);
     }
 }
 
-void *FrameData::Alloc(int bytes) {
-    bytes = AlignUp(bytes, 16);
-    MemBlock *block = this->alloc;
+void FrameData::ToggleFrame() {
+    // Gather memory usage of the frame built by the front end
+    UpdateStats();
 
-    if (block->size - block->used >= bytes) {
-        void *buf = block->base + block->used;
-        block->used += bytes;
-        return buf;
+    currentFrame = (currentFrame + 1) % NumFrames;
+
+    Frame *frame = &frames[currentFrame];
+
+    // Free dedicated blocks for large allocations
+    MemBlock *nextBlock;
+    for (MemBlock *block = frame->largeBlocks.load(); block; block = nextBlock) {
+        nextBlock = block->next;
+        Mem_Free(block);
     }
+    frame->largeBlocks.store(nullptr);
 
-    // advance to the next mem block if available
-    block = block->next;
-    // create a new block if we are at the end of the chain
-    if (!block) {
-        int size = MEMORY_BLOCK_SIZE;
-        block = (MemBlock *)Mem_Alloc(sizeof(*block) + 15 + size);
-        if (!block) {
-            BE_FATALERROR(L"FrameData::Alloc: Mem_Alloc() failed");
-        }
-        block->base = (byte *)AlignUp((intptr_t)block + sizeof(*block), 16);
-        block->size = size;
+    // Clear all the blocks and put them back to the free list
+    for (MemBlock *block = frame->blocks.load(); block; block = block->next) {
         block->used = 0;
-        block->next = nullptr;
-        this->alloc->next = block;
+        block->nextFree = block->next;
     }
+    frame->freeBlocks.store(frame->blocks.load());
+
+    // Invalidates thread local blocks
+    frameCount++;
 
-    if (bytes > block->size) {
-        BE_FATALERROR(L"FrameData::Alloc of %i exceeded MEMORY_BLOCK_SIZE", bytes);
+    frame->commands.used = 0;
+}
+
+// Pops a block from the free list of the current frame, or allocates a new one.
+// Blocks are pushed to the free list only in ToggleFrame(), so popping is free from the ABA problem.
+FrameData::MemBlock *FrameData::GrabMemBlock() {
+    Frame *frame = &frames[currentFrame];
+
+    MemBlock *block = frame->freeBlocks.load(std::memory_order_acquire);
+    while (block && !frame->freeBlocks.compare_exchange_weak(block, block->nextFree, std::memory_order_acq_rel, std::memory_order_acquire)) {}
+
+    if (!block) {
+        block = AllocMemBlock(blockSize);
+
+        // Link to the frame so that it is reused in the following frames
+        block->next = frame->blocks.load(std::memory_order_relaxed);
+        while (!frame->blocks.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed)) {}
     }
 
-    this->alloc = block;
+    return block;
+}
+
+void *FrameData::AllocLarge(int bytes) {
+    Frame *frame = &frames[currentFrame];
+
+    MemBlock *block = AllocMemBlock(bytes);
     block->used = bytes;
 
+    block->next = frame->largeBlocks.load(std::memory_order_relaxed);
+    while (!frame->largeBlocks.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed)) {}
+
     return block->base;
 }
 
+void *FrameData::Alloc(int bytes) {
+    // Not initialized or already shut down
+    if (blockSize == 0) {
+        return nullptr;
+    }
+
+    bytes = AlignUp(bytes, 16);
+
+    if (bytes > blockSize / LARGE_ALLOC_DIVISOR) {
+        return AllocLarge(bytes);
+    }
+
+    FrameDataThreadArena &arena = threadArena;
+    MemBlock *block = (MemBlock *)arena.block;
+
+    if (arena.frameCount != frameCount || block->size - block->used < bytes) {
+        // The rest of the previous block is wasted
+        block = GrabMemBlock();
+
+        arena.block = block;
+        arena.frameCount = frameCount;
+    }
+
+    void *buf = block->base + block->used;
+    block->used += bytes;
+    return buf;
+}
+
 void *FrameData::ClearedAlloc(int bytes) {
     void *r = Alloc(bytes);
-    simdProcessor->Memset(r, 0, bytes);
+    if (r) {
+        simdProcessor->Memset(r, 0, bytes);
+    }
     //memset(r, 0, bytes);
     return r;
 }
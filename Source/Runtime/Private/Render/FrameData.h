@@ -15,32 +15,81 @@
 #pragma once
 
 #include "RenderCmd.h"
+#include <atomic>
 
 BE_NAMESPACE_BEGIN
 
 /// All of the information needed by the back end must be contained in.
+/// Frame data is double buffered so that the front end can build the next frame
+/// while the back end is consuming the previous one on the render thread.
+///
+/// Each thread allocates from its own memory block with a thread local bump pointer.
+/// Blocks are grabbed from the lock-free free list of the frame, so several threads
+/// can allocate in the same frame without locks.
 class FrameData {
 public:
+    enum { NumFrames = 2 };
+
+    struct Stats {
+        int64_t             usedBytes;      ///< Bytes allocated including large allocations
+        int64_t             largeBytes;     ///< Bytes allocated in dedicated blocks
+        int                 numBlocks;      ///< Number of memory blocks used
+        int                 numLargeAllocs; ///< Number of dedicated blocks for large allocations
+    };
+
     void                    Init();
     void                    Shutdown();
+
+                            /// Switches to the other frame and resets it.
+                            /// The back end must have finished with the frame switched to.
+                            /// No allocation should be in progress on any thread.
     void                    ToggleFrame();
 
+                            /// Allocates memory from the frame which is being built by the front end.
+                            /// Safe to call from multiple threads. Returns nullptr if not initialized.
     void *                  Alloc(int bytes);
     void *                  ClearedAlloc(int bytes);
 
-    RenderCommandBuffer *   GetCommands() { return &commands; }
+                            /// Returns command buffer of the frame which is being built by the front end.
+    RenderCommandBuffer *   GetCommands() { return &frames[currentFrame].commands; }
+
+                            /// Returns number of the frames toggled so far. Commands of the current frame are not issued yet.
+    uint32_t                GetFrameCount() const { return frameCount; }
+
+                            /// Returns memory usage of the last built frame.
+    const Stats &           GetLastFrameStats() const { return lastFrameStats; }
+
+                            /// Returns high-water mark of memory usage since Init().
+    const Stats &           GetPeakStats() const { return peakStats; }
 
 private:
     struct MemBlock {
-        MemBlock *          next;
+        MemBlock *          next;           ///< Next block owned by the same frame
+        MemBlock *          nextFree;       ///< Next block in the free list
         int32_t             size;
-        int32_t             used;
+        int32_t             used;           ///< Modified only by the thread which grabbed this block
         byte *              base;
     };
 
-    MemBlock *              mem;
-    MemBlock *              alloc;
-    RenderCommandBuffer     commands;
+    struct Frame {
+        std::atomic<MemBlock *> blocks;     ///< All memory blocks owned by this frame
+        std::atomic<MemBlock *> freeBlocks; ///< Blocks not grabbed by any thread yet
+        std::atomic<MemBlock *> largeBlocks;///< Dedicated blocks for large allocations, freed when the frame is reset
+        RenderCommandBuffer commands;
+    };
+
+    static MemBlock *       AllocMemBlock(int size);
+    MemBlock *              GrabMemBlock();
+    void *                  AllocLarge(int bytes);
+    void                    UpdateStats();
+
+    Frame                   frames[NumFrames];
+    int                     currentFrame;
+    uint32_t                frameCount;     ///< Increased every frame to invalidate thread local blocks
+    int                     blockSize;
+
+    Stats                   lastFrameStats;
+    Stats                   peakStats;
 };
 
 extern FrameData            frameData;
@@ -0,0 +1,545 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Render/Render.h"
+#include "Core/JobSystem.h"
+#if defined(__X86__)
+#include <emmintrin.h>
+#endif
+
+BE_NAMESPACE_BEGIN
+
+static BE_INLINE int CountBits(uint32_t v) {
+    v = v - ((v >> 1) & 0x55555555);
+    v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+    return (((v + (v >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+// Returns index of the lowest set bit.
+static BE_INLINE int LowestBitIndex(uint32_t v) {
+    return CountBits((v & (~v + 1)) - 1);
+}
+
+LightClusterGrid::LightVolume LightClusterGrid::LightVolume::FromSphere(const Vec3 &center, float radius) {
+    LightVolume volume;
+    volume.origin = center;
+    volume.direction = Vec3::unitX;
+    volume.radius = radius;
+    volume.cosAngle = 1.0f;
+    volume.sinAngle = 0.0f;
+    volume.isCone = false;
+    return volume;
+}
+
+LightClusterGrid::LightVolume LightClusterGrid::LightVolume::FromCone(const Vec3 &apex, const Vec3 &direction, float range, float halfAngle) {
+    LightVolume volume;
+    volume.origin = apex;
+    volume.direction = direction;
+    volume.radius = range;
+    Math::SinCos(halfAngle, volume.sinAngle, volume.cosAngle);
+    volume.isCone = true;
+    return volume;
+}
+
+LightClusterGrid::LightClusterGrid() {
+    numTilesX = 0;
+    numTilesY = 0;
+    numSlices = 0;
+    numLights = 0;
+    numLightWords = 0;
+    viewOrigin = Vec3::origin;
+    viewAxis[0] = Vec3::unitX;
+    viewAxis[1] = Vec3::unitY;
+    viewAxis[2] = Vec3::unitZ;
+    tanHalfFovX = 1.0f;
+    tanHalfFovY = 1.0f;
+    zNear = 1.0f;
+    zFar = 2.0f;
+    gridFar = 2.0f;
+    sliceScale = 0.0f;
+}
+
+LightClusterGrid::~LightClusterGrid() {
+    Shutdown();
+}
+
+void LightClusterGrid::Init(int numTilesX, int numTilesY, int numSlices) {
+    Shutdown();
+
+    this->numTilesX = Max(numTilesX, 1);
+    this->numTilesY = Max(numTilesY, 1);
+    this->numSlices = Max(numSlices, 1);
+
+    // Padded to read 4 tiles at a time from any tile
+    tileMinX.SetCount(this->numTilesX + 4);
+    tileMaxX.SetCount(this->numTilesX + 4);
+
+    for (int x = 0; x < tileMinX.Count(); x++) {
+        tileMinX[x] = -1.0f + 2.0f * x / this->numTilesX;
+        tileMaxX[x] = -1.0f + 2.0f * (x + 1) / this->numTilesX;
+    }
+
+    sliceDepths.SetCount(this->numSlices + 1);
+
+    clusterOffsets.SetCount(NumClusters() + 1);
+    memset(clusterOffsets.Ptr(), 0, clusterOffsets.MemoryUsed());
+
+    SetupSlices(zFar);
+}
+
+void LightClusterGrid::Shutdown() {
+    numTilesX = 0;
+    numTilesY = 0;
+    numSlices = 0;
+    numLights = 0;
+    numLightWords = 0;
+
+    tileMinX.Clear();
+    tileMaxX.Clear();
+    sliceDepths.Clear();
+    clusterLights.Clear();
+    clusterMasks.Clear();
+    clusterOffsets.Clear();
+    clusterLightIndexes.Clear();
+}
+
+void LightClusterGrid::SetView(const Vec3 &origin, const Mat3 &axis, float tanHalfFovX, float tanHalfFovY, float zNear, float zFar) {
+    this->viewOrigin = origin;
+    this->viewAxis[0] = axis[0];
+    this->viewAxis[1] = axis[1];
+    this->viewAxis[2] = axis[2];
+    this->tanHalfFovX = tanHalfFovX;
+    this->tanHalfFovY = tanHalfFovY;
+    this->zNear = zNear;
+    this->zFar = Max(zFar, zNear * 1.01f);
+
+    SetupSlices(this->zFar);
+}
+
+void LightClusterGrid::SetupSlices(float gridFar) {
+    this->gridFar = Max(gridFar, zNear * 1.01f);
+
+    if (!numSlices) {
+        return;
+    }
+
+    float ratio = this->gridFar / zNear;
+    sliceScale = numSlices / Math::Log(ratio);
+
+    // Exponential slices keep the clusters roughly cubic in view space
+    for (int z = 0; z < numSlices; z++) {
+        sliceDepths[z] = zNear * Math::Pow(ratio, (float)z / numSlices);
+    }
+    sliceDepths[numSlices] = this->gridFar;
+}
+
+void LightClusterGrid::ToViewSpace(const Vec3 &worldPoint, float viewPoint[3]) const {
+    Vec3 v = worldPoint - viewOrigin;
+    viewPoint[0] = viewAxis[0].Dot(v);
+    viewPoint[1] = viewAxis[1].Dot(v);
+    viewPoint[2] = viewAxis[2].Dot(v);
+}
+
+int LightClusterGrid::SliceFromDepth(float depth) const {
+    int slice = Clamp((int)(Math::Log(depth / zNear) * sliceScale), 0, numSlices - 1);
+
+    // Match the slice boundaries exactly
+    while (slice > 0 && depth < sliceDepths[slice]) {
+        slice--;
+    }
+    while (slice < numSlices - 1 && depth >= sliceDepths[slice + 1]) {
+        slice++;
+    }
+    return slice;
+}
+
+int LightClusterGrid::FindCluster(const Vec3 &worldPoint) const {
+    float p[3];
+    ToViewSpace(worldPoint, p);
+
+    if (p[0] < zNear || p[0] > gridFar) {
+        return -1;
+    }
+
+    float sx = p[1] / (p[0] * tanHalfFovX);
+    float sy = p[2] / (p[0] * tanHalfFovY);
+    if (sx < -1.0f || sx > 1.0f || sy < -1.0f || sy > 1.0f) {
+        return -1;
+    }
+
+    int x = Min((int)((sx + 1.0f) * 0.5f * numTilesX), numTilesX - 1);
+    int y = Min((int)((sy + 1.0f) * 0.5f * numTilesY), numTilesY - 1);
+    int z = SliceFromDepth(p[0]);
+
+    return GetClusterIndex(x, y, z);
+}
+
+void LightClusterGrid::Build(const LightVolume *lights, int numLights, bool parallel) {
+    this->numLights = Min(numLights, (int)MaxLights);
+    this->numLightWords = (this->numLights + 31) >> 5;
+
+    clusterLights.SetCount(this->numLights, false);
+
+    float farthest = zNear;
+
+    for (int lightIndex = 0; lightIndex < this->numLights; lightIndex++) {
+        const LightVolume &volume = lights[lightIndex];
+        ClusterLight &light = clusterLights[lightIndex];
+
+        if (volume.isCone) {
+            // Bounding sphere of the cone
+            Vec3 center;
+            float radius;
+            if (volume.cosAngle < Math::SqrtOneOverTwo) {
+                // Centered at the cap for wide cones
+                center = volume.origin + volume.direction * volume.radius;
+                radius = volume.radius * volume.sinAngle / volume.cosAngle;
+            } else {
+                // Passes through the apex and the rim of the cap
+                radius = volume.radius / (2.0f * volume.cosAngle * volume.cosAngle);
+                center = volume.origin + volume.direction * radius;
+            }
+
+            ToViewSpace(center, light.center);
+            light.radius = radius;
+
+            ToViewSpace(volume.origin, light.apex);
+            light.direction[0] = viewAxis[0].Dot(volume.direction);
+            light.direction[1] = viewAxis[1].Dot(volume.direction);
+            light.direction[2] = viewAxis[2].Dot(volume.direction);
+            light.range = volume.radius;
+            light.cosAngle = volume.cosAngle;
+            light.sinAngle = volume.sinAngle;
+            light.isCone = true;
+        } else {
+            ToViewSpace(volume.origin, light.center);
+            light.radius = volume.radius;
+            light.isCone = false;
+        }
+
+        farthest = Max(farthest, light.center[0] + light.radius);
+    }
+
+    SetupSlices(Min(farthest, zFar));
+
+    // Conservative cluster ranges of each light
+    for (int lightIndex = 0; lightIndex < this->numLights; lightIndex++) {
+        ClusterLight &light = clusterLights[lightIndex];
+
+        // Empty range by default
+        light.minSlice = light.minTileX = light.minTileY = 1;
+        light.maxSlice = light.maxTileX = light.maxTileY = 0;
+
+        float minDepth = Max(light.center[0] - light.radius, zNear);
+        float maxDepth = Min(light.center[0] + light.radius, gridFar);
+        if (minDepth > maxDepth) {
+            continue;
+        }
+
+        // Smallest screen coordinates come from the nearest depth if negative, otherwise from the farthest depth
+        float minLeft = light.center[1] - light.radius;
+        float maxLeft = light.center[1] + light.radius;
+        float minUp = light.center[2] - light.radius;
+        float maxUp = light.center[2] + light.radius;
+
+        float minSx = minLeft / ((minLeft < 0.0f ? minDepth : maxDepth) * tanHalfFovX);
+        float maxSx = maxLeft / ((maxLeft > 0.0f ? minDepth : maxDepth) * tanHalfFovX);
+        float minSy = minUp / ((minUp < 0.0f ? minDepth : maxDepth) * tanHalfFovY);
+        float maxSy = maxUp / ((maxUp > 0.0f ? minDepth : maxDepth) * tanHalfFovY);
+
+        if (maxSx < -1.0f || minSx > 1.0f || maxSy < -1.0f || minSy > 1.0f) {
+            continue;
+        }
+
+        light.minTileX = Clamp((int)Math::Floor((minSx + 1.0f) * 0.5f * numTilesX), 0, numTilesX - 1);
+        light.maxTileX = Clamp((int)Math::Floor((maxSx + 1.0f) * 0.5f * numTilesX), 0, numTilesX - 1);
+        light.minTileY = Clamp((int)Math::Floor((minSy + 1.0f) * 0.5f * numTilesY), 0, numTilesY - 1);
+        light.maxTileY = Clamp((int)Math::Floor((maxSy + 1.0f) * 0.5f * numTilesY), 0, numTilesY - 1);
+        light.minSlice = SliceFromDepth(minDepth);
+        light.maxSlice = SliceFromDepth(maxDepth);
+    }
+
+    clusterMasks.SetCount(NumClusters() * numLightWords, false);
+    if (clusterMasks.Count() > 0) {
+        memset(clusterMasks.Ptr(), 0, clusterMasks.MemoryUsed());
+    }
+
+    // Each slice only writes to its own clusters
+    auto binSlices = [this](int first, int last) {
+        for (int slice = first; slice < last; slice++) {
+            BinSlice(slice);
+        }
+    };
+
+    if (parallel && this->numLights > 0) {
+        jobSystem.ParallelFor(numSlices, 1, binSlices);
+    } else {
+        binSlices(0, numSlices);
+    }
+
+    // Prefix sum of the light counts in each cluster
+    int numClusters = NumClusters();
+    int numIndexes = 0;
+
+    for (int clusterIndex = 0; clusterIndex < numClusters; clusterIndex++) {
+        const uint32_t *mask = clusterMasks.Ptr() + clusterIndex * numLightWords;
+
+        clusterOffsets[clusterIndex] = numIndexes;
+        for (int word = 0; word < numLightWords; word++) {
+            numIndexes += CountBits(mask[word]);
+        }
+    }
+    clusterOffsets[numClusters] = numIndexes;
+
+    clusterLightIndexes.SetCount(numIndexes, false);
+
+    auto compactSlices = [this](int first, int last) {
+        for (int slice = first; slice < last; slice++) {
+            CompactSlice(slice);
+        }
+    };
+
+    if (parallel && numIndexes > 0) {
+        jobSystem.ParallelFor(numSlices, 1, compactSlices);
+    } else {
+        compactSlices(0, numSlices);
+    }
+}
+
+void LightClusterGrid::BinSlice(int slice) {
+    const float d0 = sliceDepths[slice];
+    const float d1 = sliceDepths[slice + 1];
+
+    uint32_t *sliceMasks = clusterMasks.Ptr() + GetClusterIndex(0, 0, slice) * numLightWords;
+
+    for (int lightIndex = 0; lightIndex < numLights; lightIndex++) {
+        const ClusterLight &light = clusterLights[lightIndex];
+
+        if (slice < light.minSlice || slice > light.maxSlice) {
+            continue;
+        }
+
+        const float radiusSqr = light.radius * light.radius;
+        const float dd = Max(d0 - light.center[0], 0.0f) + Max(light.center[0] - d1, 0.0f);
+        const float distSqrZ = dd * dd;
+
+        if (distSqrZ > radiusSqr) {
+            continue;
+        }
+
+        const int word = lightIndex >> 5;
+        const uint32_t bit = 1u << (lightIndex & 31);
+
+        for (int y = light.minTileY; y <= light.maxTileY; y++) {
+            // Cluster bounds in up axis
+            const float sy0 = -1.0f + 2.0f * y / numTilesY;
+            const float sy1 = -1.0f + 2.0f * (y + 1) / numTilesY;
+            const float minUp = Min(sy0 * d0, sy0 * d1) * tanHalfFovY;
+            const float maxUp = Max(sy1 * d0, sy1 * d1) * tanHalfFovY;
+
+            const float du = Max(minUp - light.center[2], 0.0f) + Max(light.center[2] - maxUp, 0.0f);
+            const float distSqrZY = distSqrZ + du * du;
+
+            if (distSqrZY > radiusSqr) {
+                continue;
+            }
+
+            uint32_t *rowMasks = sliceMasks + y * numTilesX * numLightWords;
+
+#if defined(__X86__)
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 depth0 = _mm_set1_ps(d0 * tanHalfFovX);
+            const __m128 depth1 = _mm_set1_ps(d1 * tanHalfFovX);
+            const __m128 centerLeft = _mm_set1_ps(light.center[1]);
+            const __m128 distZY = _mm_set1_ps(distSqrZY);
+            const __m128 radiusSq = _mm_set1_ps(radiusSqr);
+
+            for (int x = light.minTileX; x <= light.maxTileX; x += 4) {
+                // Cluster bounds in left axis for 4 tiles
+                __m128 sx0 = _mm_loadu_ps(&tileMinX[x]);
+                __m128 sx1 = _mm_loadu_ps(&tileMaxX[x]);
+                __m128 minLeft = _mm_min_ps(_mm_mul_ps(sx0, depth0), _mm_mul_ps(sx0, depth1));
+                __m128 maxLeft = _mm_max_ps(_mm_mul_ps(sx1, depth0), _mm_mul_ps(sx1, depth1));
+
+                // Sphere vs cluster AABB
+                __m128 dl = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minLeft, centerLeft), zero), _mm_max_ps(_mm_sub_ps(centerLeft, maxLeft), zero));
+                __m128 distSqr = _mm_add_ps(distZY, _mm_mul_ps(dl, dl));
+                __m128 inside = _mm_cmple_ps(distSqr, radiusSq);
+
+                if (light.isCone && _mm_movemask_ps(inside)) {
+                    // Cone vs bounding sphere of the cluster
+                    const __m128 half = _mm_set1_ps(0.5f);
+                    __m128 vd = _mm_set1_ps((d0 + d1) * 0.5f - light.apex[0]);
+                    __m128 vl = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(minLeft, maxLeft), half), _mm_set1_ps(light.apex[1]));
+                    __m128 vu = _mm_set1_ps((minUp + maxUp) * 0.5f - light.apex[2]);
+                    __m128 sizeL = _mm_sub_ps(maxLeft, minLeft);
+                    __m128 sizeDU = _mm_set1_ps((d1 - d0) * (d1 - d0) + (maxUp - minUp) * (maxUp - minUp));
+                    __m128 clusterRadius = _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(sizeDU, _mm_mul_ps(sizeL, sizeL))), half);
+
+                    __m128 lenSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vd, vd), _mm_mul_ps(vl, vl)), _mm_mul_ps(vu, vu));
+                    __m128 v1Len = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vd, _mm_set1_ps(light.direction[0])), _mm_mul_ps(vl, _mm_set1_ps(light.direction[1]))), 
+                        _mm_mul_ps(vu, _mm_set1_ps(light.direction[2])));
+                    __m128 distClosest = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(light.cosAngle), _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lenSqr, _mm_mul_ps(v1Len, v1Len)), zero))), 
+                        _mm_mul_ps(v1Len, _mm_set1_ps(light.sinAngle)));
+
+                    __m128 angleInside = _mm_cmple_ps(distClosest, clusterRadius);
+                    __m128 frontInside = _mm_cmple_ps(v1Len, _mm_add_ps(clusterRadius, _mm_set1_ps(light.range)));
+                    __m128 backInside = _mm_cmpge_ps(v1Len, _mm_sub_ps(zero, clusterRadius));
+                    inside = _mm_and_ps(inside, _mm_and_ps(angleInside, _mm_and_ps(frontInside, backInside)));
+                }
+
+                int laneMask = _mm_movemask_ps(inside);
+                if (light.maxTileX - x < 3) {
+                    laneMask &= (1 << (light.maxTileX - x + 1)) - 1;
+                }
+
+                while (laneMask) {
+                    int lane = LowestBitIndex(laneMask);
+                    rowMasks[(x + lane) * numLightWords + word] |= bit;
+                    laneMask &= laneMask - 1;
+                }
+            }
+#else
+            for (int x = light.minTileX; x <= light.maxTileX; x++) {
+                // Cluster bounds in left axis
+                const float minLeft = Min(tileMinX[x] * d0, tileMinX[x] * d1) * tanHalfFovX;
+                const float maxLeft = Max(tileMaxX[x] * d0, tileMaxX[x] * d1) * tanHalfFovX;
+
+                // Sphere vs cluster AABB
+                const float dl = Max(minLeft - light.center[1], 0.0f) + Max(light.center[1] - maxLeft, 0.0f);
+                if (distSqrZY + dl * dl > radiusSqr) {
+                    continue;
+                }
+
+                if (light.isCone) {
+                    // Cone vs bounding sphere of the cluster
+                    const Vec3 v((d0 + d1) * 0.5f - light.apex[0], (minLeft + maxLeft) * 0.5f - light.apex[1], (minUp + maxUp) * 0.5f - light.apex[2]);
+                    const float clusterRadius = Vec3(d1 - d0, maxLeft - minLeft, maxUp - minUp).Length() * 0.5f;
+                    const float lenSqr = v.LengthSqr();
+                    const float v1Len = v.Dot(Vec3(light.direction[0], light.direction[1], light.direction[2]));
+                    const float distClosest = light.cosAngle * Math::Sqrt(Max(lenSqr - v1Len * v1Len, 0.0f)) - v1Len * light.sinAngle;
+
+                    if (distClosest > clusterRadius || v1Len > clusterRadius + light.range || v1Len < -clusterRadius) {
+                        continue;
+                    }
+                }
+
+                rowMasks[x * numLightWords + word] |= bit;
+            }
+#endif
+        }
+    }
+}
+
+void LightClusterGrid::CompactSlice(int slice) {
+    int firstCluster = GetClusterIndex(0, 0, slice);
+    int lastCluster = firstCluster + numTilesX * numTilesY;
+
+    for (int clusterIndex = firstCluster; clusterIndex < lastCluster; clusterIndex++) {
+        const uint32_t *mask = clusterMasks.Ptr() + clusterIndex * numLightWords;
+        int32_t *lightIndexes = clusterLightIndexes.Ptr() + clusterOffsets[clusterIndex];
+
+        for (int word = 0; word < numLightWords; word++) {
+            for (uint32_t bits = mask[word]; bits; bits &= bits - 1) {
+                *lightIndexes++ = (word << 5) + LowestBitIndex(bits);
+            }
+        }
+    }
+}
+
+int LightClusterGrid::FindLights(const AABB &worldAABB, Array<int32_t> &lightIndexes) const {
+    lightIndexes.SetCount(0, false);
+
+    if (numLights == 0 || worldAABB.IsCleared()) {
+        return 0;
+    }
+
+    Vec3 points[8];
+    worldAABB.ToPoints(points);
+
+    float minDepth = Math::Infinity;
+    float maxDepth = -Math::Infinity;
+    float minSx = Math::Infinity;
+    float maxSx = -Math::Infinity;
+    float minSy = Math::Infinity;
+    float maxSy = -Math::Infinity;
+    bool crossesNear = false;
+
+    for (int i = 0; i < 8; i++) {
+        float p[3];
+        ToViewSpace(points[i], p);
+
+        minDepth = Min(minDepth, p[0]);
+        maxDepth = Max(maxDepth, p[0]);
+
+        if (p[0] < zNear) {
+            crossesNear = true;
+            continue;
+        }
+
+        float sx = p[1] / (p[0] * tanHalfFovX);
+        float sy = p[2] / (p[0] * tanHalfFovY);
+        minSx = Min(minSx, sx);
+        maxSx = Max(maxSx, sx);
+        minSy = Min(minSy, sy);
+        maxSy = Max(maxSy, sy);
+    }
+
+    if (maxDepth < zNear || minDepth > gridFar) {
+        return 0;
+    }
+
+    // Projection of the box is unbounded if it crosses the near plane
+    if (crossesNear) {
+        minSx = minSy = -1.0f;
+        maxSx = maxSy = 1.0f;
+    } else if (maxSx < -1.0f || minSx > 1.0f || maxSy < -1.0f || minSy > 1.0f) {
+        return 0;
+    }
+
+    int minTileX = Clamp((int)Math::Floor((minSx + 1.0f) * 0.5f * numTilesX), 0, numTilesX - 1);
+    int maxTileX = Clamp((int)Math::Floor((maxSx + 1.0f) * 0.5f * numTilesX), 0, numTilesX - 1);
+    int minTileY = Clamp((int)Math::Floor((minSy + 1.0f) * 0.5f * numTilesY), 0, numTilesY - 1);
+    int maxTileY = Clamp((int)Math::Floor((maxSy + 1.0f) * 0.5f * numTilesY), 0, numTilesY - 1);
+    int minSlice = SliceFromDepth(Max(minDepth, zNear));
+    int maxSlice = SliceFromDepth(Min(maxDepth, gridFar));
+
+    // Union of the light masks of the overlapped clusters
+    uint32_t mask[MaxLights / 32];
+    memset(mask, 0, numLightWords * sizeof(mask[0]));
+
+    for (int z = minSlice; z <= maxSlice; z++) {
+        for (int y = minTileY; y <= maxTileY; y++) {
+            const uint32_t *clusterMask = clusterMasks.Ptr() + GetClusterIndex(minTileX, y, z) * numLightWords;
+
+            for (int x = minTileX; x <= maxTileX; x++) {
+                for (int word = 0; word < numLightWords; word++) {
+                    mask[word] |= clusterMask[word];
+                }
+                clusterMask += numLightWords;
+            }
+        }
+    }
+
+    for (int word = 0; word < numLightWords; word++) {
+        for (uint32_t bits = mask[word]; bits; bits &= bits - 1) {
+            lightIndexes.Append((word << 5) + LowestBitIndex(bits));
+        }
+    }
+
+    return lightIndexes.Count();
+}
+
+BE_NAMESPACE_END
@@ -18,6 +18,7 @@
 #include "Asset/Asset.h"
 #include "Asset/GuidMapper.h"
 #include "File/FileSystem.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -921,6 +922,8 @@ bool Material::ShaderPass::GetTextureMatrix(const float *evalShaderRegisters, fl
 */
 
 bool Material::Load(const char *hashName) {
+    BE_PROFILE_SCOPE("Material::Load");
+
     char *data;
     int size = (int)fileSystem.LoadFile(hashName, true, (void **)&data);
     if (!data) {
@@ -18,6 +18,7 @@
 #include "Core/JointPose.h"
 #include "Simd/Simd.h"
 #include "Core/Heap.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -353,6 +354,9 @@ const Vec3 Mesh::ComputeCentroid() const {
 }
 
 bool Mesh::Load(const char *filename) {
+    BE_PROFILE_SCOPE("Mesh::Load");
+    MemTagScope memTagScope(MemTag::Mesh);
+
     Purge();
 
     Str bMeshFilename = filename;
@@ -0,0 +1,427 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Render/Render.h"
+#include "Core/Heap.h"
+#include "Core/JobSystem.h"
+#if defined(__X86__)
+#include <xmmintrin.h>
+#endif
+
+BE_NAMESPACE_BEGIN
+
+OcclusionBuffer::OcclusionBuffer() {
+    width = 0;
+    height = 0;
+    numTilesX = 0;
+    numTilesY = 0;
+    numBlocksX = 0;
+    numBlocksY = 0;
+    depthBuffer = nullptr;
+    blockMinDepth = nullptr;
+    blockMaxDepth = nullptr;
+    tileBins = nullptr;
+}
+
+OcclusionBuffer::~OcclusionBuffer() {
+    Shutdown();
+}
+
+void OcclusionBuffer::Init(int width, int height) {
+    MemTagScope memTagScope(MemTag::Render);
+
+    Shutdown();
+
+    this->numTilesX = (width + TileWidth - 1) / TileWidth;
+    this->numTilesY = (height + TileHeight - 1) / TileHeight;
+    this->width = numTilesX * TileWidth;
+    this->height = numTilesY * TileHeight;
+    this->numBlocksX = this->width / BlockSize;
+    this->numBlocksY = this->height / BlockSize;
+
+    depthBuffer = (float *)Mem_Alloc16(sizeof(float) * this->width * this->height);
+    blockMinDepth = (float *)Mem_Alloc16(sizeof(float) * numBlocksX * numBlocksY);
+    blockMaxDepth = (float *)Mem_Alloc16(sizeof(float) * numBlocksX * numBlocksY);
+
+    tileBins = new Array<int32_t>[numTilesX * numTilesY];
+
+    Clear();
+}
+
+void OcclusionBuffer::Shutdown() {
+    if (depthBuffer) {
+        Mem_AlignedFree(depthBuffer);
+        Mem_AlignedFree(blockMinDepth);
+        Mem_AlignedFree(blockMaxDepth);
+        depthBuffer = nullptr;
+        blockMinDepth = nullptr;
+        blockMaxDepth = nullptr;
+    }
+
+    if (tileBins) {
+        delete [] tileBins;
+        tileBins = nullptr;
+    }
+
+    triangles.Clear();
+    clipVerts.Clear();
+
+    width = 0;
+    height = 0;
+    numTilesX = 0;
+    numTilesY = 0;
+    numBlocksX = 0;
+    numBlocksY = 0;
+}
+
+void OcclusionBuffer::Clear() {
+    memset(depthBuffer, 0, sizeof(float) * width * height);
+    memset(blockMinDepth, 0, sizeof(float) * numBlocksX * numBlocksY);
+    memset(blockMaxDepth, 0, sizeof(float) * numBlocksX * numBlocksY);
+
+    // Keep the memory for the next frame
+    triangles.SetCount(0, false);
+
+    for (int tileIndex = 0; tileIndex < numTilesX * numTilesY; tileIndex++) {
+        tileBins[tileIndex].SetCount(0, false);
+    }
+}
+
+void OcclusionBuffer::AddOccluder(const Mat4 &modelViewProjMatrix, const Vec3 *positions, int positionStride, int numVerts, const TriIndex *indexes, int numIndexes) {
+    clipVerts.SetCount(numVerts, false);
+
+    for (int i = 0; i < numVerts; i++) {
+        const Vec3 &p = *(const Vec3 *)((const byte *)positions + i * positionStride);
+        clipVerts[i] = modelViewProjMatrix * Vec4(p, 1.0f);
+    }
+
+    for (int i = 0; i < numIndexes; i += 3) {
+        AddTriangle(clipVerts[indexes[i]], clipVerts[indexes[i + 1]], clipVerts[indexes[i + 2]]);
+    }
+}
+
+// Clips a triangle in clip space against the near plane (z = -w) and bins the result.
+void OcclusionBuffer::AddTriangle(const Vec4 &clip0, const Vec4 &clip1, const Vec4 &clip2) {
+    const Vec4 *in[3] = { &clip0, &clip1, &clip2 };
+    float dist[3];
+    int numInside = 0;
+
+    for (int i = 0; i < 3; i++) {
+        dist[i] = in[i]->z + in[i]->w;
+        if (dist[i] >= 0.0f) {
+            numInside++;
+        }
+    }
+
+    if (numInside == 0) {
+        return;
+    }
+
+    // Trivially reject triangles outside of the same side plane
+    if ((clip0.x > clip0.w && clip1.x > clip1.w && clip2.x > clip2.w) ||
+        (clip0.x < -clip0.w && clip1.x < -clip1.w && clip2.x < -clip2.w) ||
+        (clip0.y > clip0.w && clip1.y > clip1.w && clip2.y > clip2.w) ||
+        (clip0.y < -clip0.w && clip1.y < -clip1.w && clip2.y < -clip2.w)) {
+        return;
+    }
+
+    Vec4 clipped[4];
+    int numClipped = 0;
+
+    if (numInside == 3) {
+        clipped[0] = clip0;
+        clipped[1] = clip1;
+        clipped[2] = clip2;
+        numClipped = 3;
+    } else {
+        for (int i = 0; i < 3; i++) {
+            int j = (i + 1) % 3;
+
+            if (dist[i] >= 0.0f) {
+                clipped[numClipped++] = *in[i];
+            }
+            if ((dist[i] >= 0.0f) != (dist[j] >= 0.0f)) {
+                float f = dist[i] / (dist[i] - dist[j]);
+                clipped[numClipped++] = *in[i] + (*in[j] - *in[i]) * f;
+            }
+        }
+    }
+
+    // Project to screen space (rows from bottom to top), z holds 1/w
+    Vec3 screen[4];
+    for (int i = 0; i < numClipped; i++) {
+        if (clipped[i].w <= 0.0f) {
+            return;
+        }
+        float invW = 1.0f / clipped[i].w;
+        screen[i].x = (clipped[i].x * invW * 0.5f + 0.5f) * width;
+        screen[i].y = (clipped[i].y * invW * 0.5f + 0.5f) * height;
+        screen[i].z = invW;
+    }
+
+    for (int i = 2; i < numClipped; i++) {
+        BinTriangle(screen[0], screen[i - 1], screen[i]);
+    }
+}
+
+void OcclusionBuffer::BinTriangle(const Vec3 &v0, const Vec3 &v1, const Vec3 &v2) {
+    // Counter clock-wise triangles are front facing
+    // Also rejects NaN and overflowed areas of the vertices projected with w near 0
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (!(area > 0.0f) || area >= Math::Infinity) {
+        return;
+    }
+
+    // Pixels whose centers are in the bounding rectangle.
+    // Bounds are clamped to the buffer before the int conversion, which is undefined out of the int range.
+    int minX = (int)Math::Ceil(Max(Min3(v0.x, v1.x, v2.x) - 0.5f, 0.0f));
+    int minY = (int)Math::Ceil(Max(Min3(v0.y, v1.y, v2.y) - 0.5f, 0.0f));
+    int maxX = (int)Math::Floor(Min(Max3(v0.x, v1.x, v2.x) - 0.5f, (float)(width - 1)));
+    int maxY = (int)Math::Floor(Min(Max3(v0.y, v1.y, v2.y) - 0.5f, (float)(height - 1)));
+
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+
+    ScreenTriangle &tri = triangles.Alloc();
+
+    const Vec3 *v[3] = { &v0, &v1, &v2 };
+    for (int i = 0; i < 3; i++) {
+        const Vec3 &a = *v[i];
+        const Vec3 &b = *v[(i + 1) % 3];
+        tri.edgeA[i] = a.y - b.y;
+        tri.edgeB[i] = b.x - a.x;
+        tri.edgeC[i] = -(tri.edgeA[i] * a.x + tri.edgeB[i] * a.y);
+    }
+
+    // Barycentric weight of each vertex is the edge function of the opposite edge
+    float invArea = 1.0f / area;
+    tri.depthA = (tri.edgeA[1] * v0.z + tri.edgeA[2] * v1.z + tri.edgeA[0] * v2.z) * invArea;
+    tri.depthB = (tri.edgeB[1] * v0.z + tri.edgeB[2] * v1.z + tri.edgeB[0] * v2.z) * invArea;
+    tri.depthC = (tri.edgeC[1] * v0.z + tri.edgeC[2] * v1.z + tri.edgeC[0] * v2.z) * invArea;
+
+    tri.minX = minX;
+    tri.minY = minY;
+    tri.maxX = maxX;
+    tri.maxY = maxY;
+
+    int triangleIndex = triangles.Count() - 1;
+
+    for (int tileY = minY / TileHeight; tileY <= maxY / TileHeight; tileY++) {
+        for (int tileX = minX / TileWidth; tileX <= maxX / TileWidth; tileX++) {
+            tileBins[tileY * numTilesX + tileX].Append(triangleIndex);
+        }
+    }
+}
+
+void OcclusionBuffer::Rasterize(bool parallel) {
+    int numTiles = numTilesX * numTilesY;
+
+    auto rasterizeTiles = [this](int first, int last) {
+        for (int tileIndex = first; tileIndex < last; tileIndex++) {
+            RasterizeTile(tileIndex);
+            UpdateHierarchy(tileIndex);
+        }
+    };
+
+    if (parallel && jobSystem.IsInitialized()) {
+        jobSystem.ParallelFor(numTiles, 1, rasterizeTiles);
+    } else {
+        rasterizeTiles(0, numTiles);
+    }
+}
+
+void OcclusionBuffer::RasterizeTile(int tileIndex) {
+    const Array<int32_t> &bin = tileBins[tileIndex];
+
+    int tileMinX = (tileIndex % numTilesX) * TileWidth;
+    int tileMinY = (tileIndex / numTilesX) * TileHeight;
+    int tileMaxX = tileMinX + TileWidth - 1;
+    int tileMaxY = tileMinY + TileHeight - 1;
+
+    for (int binIndex = 0; binIndex < bin.Count(); binIndex++) {
+        const ScreenTriangle &tri = triangles[bin[binIndex]];
+
+        // Tile widths are multiple of 4, so 4 pixel groups never cross the tile
+        int minX = Max(tri.minX, tileMinX) & ~3;
+        int maxX = Min(tri.maxX, tileMaxX);
+        int minY = Max(tri.minY, tileMinY);
+        int maxY = Min(tri.maxY, tileMaxY);
+
+#if defined(__X86__)
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 stepX = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 edgeA0 = _mm_set1_ps(tri.edgeA[0]);
+        const __m128 edgeA1 = _mm_set1_ps(tri.edgeA[1]);
+        const __m128 edgeA2 = _mm_set1_ps(tri.edgeA[2]);
+        const __m128 depthA = _mm_set1_ps(tri.depthA);
+
+        for (int y = minY; y <= maxY; y++) {
+            float py = y + 0.5f;
+            const __m128 rowEdge0 = _mm_set1_ps(tri.edgeB[0] * py + tri.edgeC[0]);
+            const __m128 rowEdge1 = _mm_set1_ps(tri.edgeB[1] * py + tri.edgeC[1]);
+            const __m128 rowEdge2 = _mm_set1_ps(tri.edgeB[2] * py + tri.edgeC[2]);
+            const __m128 rowDepth = _mm_set1_ps(tri.depthB * py + tri.depthC);
+
+            float *depthRow = &depthBuffer[y * width];
+
+            for (int x = minX; x <= maxX; x += 4) {
+                __m128 px = _mm_add_ps(_mm_set1_ps((float)x), stepX);
+
+                __m128 e0 = _mm_add_ps(_mm_mul_ps(edgeA0, px), rowEdge0);
+                __m128 e1 = _mm_add_ps(_mm_mul_ps(edgeA1, px), rowEdge1);
+                __m128 e2 = _mm_add_ps(_mm_mul_ps(edgeA2, px), rowEdge2);
+
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside) == 0) {
+                    continue;
+                }
+
+                __m128 depth = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+                __m128 oldDepth = _mm_load_ps(&depthRow[x]);
+                __m128 newDepth = _mm_max_ps(oldDepth, depth);
+
+                _mm_store_ps(&depthRow[x], _mm_or_ps(_mm_and_ps(inside, newDepth), _mm_andnot_ps(inside, oldDepth)));
+            }
+        }
+#else
+        for (int y = minY; y <= maxY; y++) {
+            float py = y + 0.5f;
+            float *depthRow = &depthBuffer[y * width];
+
+            for (int x = minX; x <= maxX; x++) {
+                float px = x + 0.5f;
+
+                if (tri.edgeA[0] * px + (tri.edgeB[0] * py + tri.edgeC[0]) < 0.0f ||
+                    tri.edgeA[1] * px + (tri.edgeB[1] * py + tri.edgeC[1]) < 0.0f ||
+                    tri.edgeA[2] * px + (tri.edgeB[2] * py + tri.edgeC[2]) < 0.0f) {
+                    continue;
+                }
+
+                float depth = tri.depthA * px + (tri.depthB * py + tri.depthC);
+                depthRow[x] = Max(depthRow[x], depth);
+            }
+        }
+#endif
+    }
+}
+
+void OcclusionBuffer::UpdateHierarchy(int tileIndex) {
+    int blockMinX = (tileIndex % numTilesX) * (TileWidth / BlockSize);
+    int blockMinY = (tileIndex / numTilesX) * (TileHeight / BlockSize);
+
+    for (int by = blockMinY; by < blockMinY + TileHeight / BlockSize; by++) {
+        for (int bx = blockMinX; bx < blockMinX + TileWidth / BlockSize; bx++) {
+            const float *depthRow = &depthBuffer[by * BlockSize * width + bx * BlockSize];
+            float minDepth = depthRow[0];
+            float maxDepth = depthRow[0];
+
+            for (int y = 0; y < BlockSize; y++, depthRow += width) {
+                for (int x = 0; x < BlockSize; x++) {
+                    minDepth = Min(minDepth, depthRow[x]);
+                    maxDepth = Max(maxDepth, depthRow[x]);
+                }
+            }
+
+            blockMinDepth[by * numBlocksX + bx] = minDepth;
+            blockMaxDepth[by * numBlocksX + bx] = maxDepth;
+        }
+    }
+}
+
+bool OcclusionBuffer::IsOccluded(const AABB &worldAABB, const Mat4 &viewProjMatrix) const {
+    // Transform the corners incrementally from the minimum corner
+    const Vec4 base = viewProjMatrix * Vec4(worldAABB[0], 1.0f);
+    const Vec3 size = worldAABB[1] - worldAABB[0];
+    const Vec4 axisX(viewProjMatrix[0][0] * size.x, viewProjMatrix[1][0] * size.x, viewProjMatrix[2][0] * size.x, viewProjMatrix[3][0] * size.x);
+    const Vec4 axisY(viewProjMatrix[0][1] * size.y, viewProjMatrix[1][1] * size.y, viewProjMatrix[2][1] * size.y, viewProjMatrix[3][1] * size.y);
+    const Vec4 axisZ(viewProjMatrix[0][2] * size.z, viewProjMatrix[1][2] * size.z, viewProjMatrix[2][2] * size.z, viewProjMatrix[3][2] * size.z);
+
+    float minX = Math::Infinity;
+    float minY = Math::Infinity;
+    float maxX = -Math::Infinity;
+    float maxY = -Math::Infinity;
+    float nearestDepth = 0.0f;
+
+    for (int i = 0; i < 8; i++) {
+        Vec4 corner = base;
+        if (i & 1) corner += axisX;
+        if (i & 2) corner += axisY;
+        if (i & 4) corner += axisZ;
+
+        // Treat as visible if the bounds cross the near plane
+        if (corner.z + corner.w < 0.0f || corner.w <= 0.0f) {
+            return false;
+        }
+
+        float invW = 1.0f / corner.w;
+        float x = (corner.x * invW * 0.5f + 0.5f) * width;
+        float y = (corner.y * invW * 0.5f + 0.5f) * height;
+
+        minX = Min(minX, x);
+        minY = Min(minY, y);
+        maxX = Max(maxX, x);
+        maxY = Max(maxY, y);
+        nearestDepth = Max(nearestDepth, invW);
+    }
+
+    // All pixels touched by the screen bounds, clamped to the buffer before the int conversion
+    int x0 = (int)Math::Floor(Max(minX, 0.0f));
+    int y0 = (int)Math::Floor(Max(minY, 0.0f));
+    int x1 = (int)Math::Ceil(Min(maxX, (float)width)) - 1;
+    int y1 = (int)Math::Ceil(Min(maxY, (float)height)) - 1;
+
+    if (x0 > x1 || y0 > y1) {
+        // Left to the frustum culling
+        return false;
+    }
+
+    for (int by = y0 / BlockSize; by <= y1 / BlockSize; by++) {
+        for (int bx = x0 / BlockSize; bx <= x1 / BlockSize; bx++) {
+            int blockIndex = by * numBlocksX + bx;
+
+            // Every pixel in the block is nearer than the bounds
+            if (blockMinDepth[blockIndex] > nearestDepth) {
+                continue;
+            }
+
+            int px0 = Max(x0, bx * BlockSize);
+            int py0 = Max(y0, by * BlockSize);
+            int px1 = Min(x1, bx * BlockSize + BlockSize - 1);
+            int py1 = Min(y1, by * BlockSize + BlockSize - 1);
+
+            // No pixel in the block is nearer than the bounds
+            if (blockMaxDepth[blockIndex] <= nearestDepth &&
+                px0 == bx * BlockSize && px1 == bx * BlockSize + BlockSize - 1 &&
+                py0 == by * BlockSize && py1 == by * BlockSize + BlockSize - 1) {
+                return false;
+            }
+
+            for (int y = py0; y <= py1; y++) {
+                const float *depthRow = &depthBuffer[y * width];
+
+                for (int x = px0; x <= px1; x++) {
+                    if (depthRow[x] <= nearestDepth) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+BE_NAMESPACE_END
@@ -17,6 +17,7 @@
 #include "Render/Render.h"
 #include "RenderInternal.h"
 #include "File/FileSystem.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -852,6 +853,9 @@ void ParticleSystem::SwapStages(int stageIndex0, int stageIndex1) {
 }
 
 bool ParticleSystem::Load(const char *filename) {
+    BE_PROFILE_SCOPE("ParticleSystem::Load");
+    MemTagScope memTagScope(MemTag::Render);
+
     Purge();
 
     Str prtSysFilename = filename;
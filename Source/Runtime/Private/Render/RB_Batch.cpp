@@ -315,7 +315,7 @@ static Vec4 MakeVec4Id(uint32_t id) {
 }
 
 void Batch::Flush_SelectionPass() {
-    const Vec3 id = MakeVec3Id(surfSpace->def->index);
+    const Vec3 id = MakeVec3Id(surfSpace->objectIndex);
 
     const Material::ShaderPass *mtrlPass = material->GetPass();
 
@@ -496,10 +496,10 @@ void Batch::Flush_TrisPass() {
     if (r_showWireframe.GetInteger() > 0) {
         wireframeMode = r_showWireframe.GetInteger();
     } else {
-        wireframeMode = surfSpace->def->state.wireframeMode;
+        wireframeMode = surfSpace->wireframeMode;
     }
 
-    DrawDebugWireframe(wireframeMode, surfSpace->def->state.wireframeColor);
+    DrawDebugWireframe(wireframeMode, surfSpace->wireframeColor);
 }
 
 void Batch::Flush_VelocityMapPass() {
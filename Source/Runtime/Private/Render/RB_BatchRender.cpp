@@ -34,14 +34,14 @@ void Batch::DrawPrimitives() const {
     int instanceCount = Max(numInstances, 1);
 
     if (flushType == ShadowFlush) {
-        backEnd.ctx->renderCounter.shadowDrawCalls++;
-        backEnd.ctx->renderCounter.shadowDrawIndexes += numIndexes * instanceCount;
-        backEnd.ctx->renderCounter.shadowDrawVerts += numVerts * instanceCount;
+        backEnd.ctx->backEndCounter.shadowDrawCalls++;
+        backEnd.ctx->backEndCounter.shadowDrawIndexes += numIndexes * instanceCount;
+        backEnd.ctx->backEndCounter.shadowDrawVerts += numVerts * instanceCount;
     }
 
-    backEnd.ctx->renderCounter.drawCalls++;
-    backEnd.ctx->renderCounter.drawIndexes += numIndexes * instanceCount;
-    backEnd.ctx->renderCounter.drawVerts += numVerts * instanceCount;
+    backEnd.ctx->backEndCounter.drawCalls++;
+    backEnd.ctx->backEndCounter.drawIndexes += numIndexes * instanceCount;
+    backEnd.ctx->backEndCounter.drawVerts += numVerts * instanceCount;
 }
 
 void Batch::SetShaderProperties(const Shader *shader, const StrHashMap<Shader::Property> &shaderProperties) const {
@@ -213,7 +213,7 @@ void Batch::SetSkinningConstants(const Shader *shader, const SkinningJointCache
 
 void Batch::SetEntityConstants(const Material::ShaderPass *mtrlPass, const Shader *shader) const {
     if (subMesh->useGpuSkinning) {
-        SetSkinningConstants(shader, surfSpace->def->state.mesh->skinningJointCache);
+        SetSkinningConstants(shader, surfSpace->skinningJointCache);
     }
 
     if (numIndirectCommands > 0) {
@@ -230,21 +230,21 @@ void Batch::SetEntityConstants(const Material::ShaderPass *mtrlPass, const Shade
         shader->SetConstantArray1i(shader->builtInConstantIndices[Shader::InstanceIndexesConst], numInstances, instanceLocalIndexes);
     } else {
         if (shader->builtInConstantIndices[Shader::LocalToWorldMatrixSConst] >= 0) {
-            const Mat3x4 &localToWorldMatrix = surfSpace->def->GetObjectToWorldMatrix();
+            const Mat3x4 &localToWorldMatrix = surfSpace->objectToWorldMatrix;
             shader->SetConstant4f(shader->builtInConstantIndices[Shader::LocalToWorldMatrixSConst], localToWorldMatrix[0]);
             shader->SetConstant4f(shader->builtInConstantIndices[Shader::LocalToWorldMatrixTConst], localToWorldMatrix[1]);
             shader->SetConstant4f(shader->builtInConstantIndices[Shader::LocalToWorldMatrixRConst], localToWorldMatrix[2]);
         }
 
         if (shader->builtInConstantIndices[Shader::WorldToLocalMatrixSConst] >= 0) {
-            Mat3x4 worldToLocalMatrix = Mat3x4(surfSpace->def->state.axis.Transpose(), -surfSpace->def->state.origin);
+            Mat3x4 worldToLocalMatrix = Mat3x4(surfSpace->axis.Transpose(), -surfSpace->origin);
             shader->SetConstant4f(shader->builtInConstantIndices[Shader::WorldToLocalMatrixSConst], worldToLocalMatrix[0]);
             shader->SetConstant4f(shader->builtInConstantIndices[Shader::WorldToLocalMatrixTConst], worldToLocalMatrix[1]);
             shader->SetConstant4f(shader->builtInConstantIndices[Shader::WorldToLocalMatrixRConst], worldToLocalMatrix[2]);
         }
 
         if (shader->builtInConstantIndices[Shader::ConstantColorConst] >= 0) {
-            const Color4 &color = mtrlPass->useOwnerColor ? reinterpret_cast<const Color4 &>(surfSpace->def->state.materialParms[RenderObject::RedParm]) : mtrlPass->constantColor;
+            const Color4 &color = mtrlPass->useOwnerColor ? reinterpret_cast<const Color4 &>(surfSpace->materialParms[RenderObject::RedParm]) : mtrlPass->constantColor;
             shader->SetConstant4f(shader->builtInConstantIndices[Shader::ConstantColorConst], color);
         }
     }
@@ -396,7 +396,7 @@ void Batch::RenderVelocity(const Material::ShaderPass *mtrlPass) const {
 
     SetMatrixConstants(shader);
 
-    Mat4 prevModelViewMatrix = backEnd.view->def->viewMatrix * surfSpace->def->prevWorldMatrix;
+    Mat4 prevModelViewMatrix = backEnd.view->def->viewMatrix * surfSpace->prevObjectToWorldMatrix;
     //shader->SetConstantMatrix4fv("prevModelViewMatrix", 1, true, prevModelViewMatrix);
 
     Mat4 prevModelViewProjMatrix = backEnd.view->def->projMatrix * prevModelViewMatrix;
@@ -421,7 +421,7 @@ void Batch::RenderVelocity(const Material::ShaderPass *mtrlPass) const {
     }
 
     if (subMesh->useGpuSkinning) {
-        SetSkinningConstants(shader, surfSpace->def->state.mesh->skinningJointCache);
+        SetSkinningConstants(shader, surfSpace->skinningJointCache);
     }
 
     DrawPrimitives();
@@ -617,7 +617,7 @@ void Batch::RenderAmbient_DirectLit(const Material::ShaderPass *mtrlPass, float
 
     bool useShadowMap = false;
     if (r_shadows.GetInteger()) {
-        if ((surfLight->def->state.flags & RenderLight::CastShadowsFlag) && (surfSpace->def->state.flags & RenderObject::ReceiveShadowsFlag)) {
+        if ((surfLight->def->state.flags & RenderLight::CastShadowsFlag) && (surfSpace->flags & RenderObject::ReceiveShadowsFlag)) {
             shader = GetShadowShader(shader, surfLight->def->state.type);
             useShadowMap = true;
         }
@@ -679,7 +679,7 @@ void Batch::RenderAmbientLit_DirectLit(const Material::ShaderPass *mtrlPass, flo
 
     bool useShadowMap = false;
     if (r_shadows.GetInteger()) {
-        if ((surfLight->def->state.flags & RenderLight::CastShadowsFlag) && (surfSpace->def->state.flags & RenderObject::ReceiveShadowsFlag)) {
+        if ((surfLight->def->state.flags & RenderLight::CastShadowsFlag) && (surfSpace->flags & RenderObject::ReceiveShadowsFlag)) {
             shader = GetShadowShader(shader, surfLight->def->state.type);
             useShadowMap = true;
         }
@@ -855,7 +855,7 @@ void Batch::RenderLightInteraction(const Material::ShaderPass *mtrlPass) const {
 
     bool useShadowMap = false;
     if (r_shadows.GetInteger()) {
-        if ((surfLight->def->state.flags & RenderLight::CastShadowsFlag) && (surfSpace->def->state.flags & RenderObject::ReceiveShadowsFlag)) {
+        if ((surfLight->def->state.flags & RenderLight::CastShadowsFlag) && (surfSpace->flags & RenderObject::ReceiveShadowsFlag)) {
             shader = GetShadowShader(shader, surfLight->def->state.type);
             useShadowMap = true;
         }
@@ -919,7 +919,7 @@ void Batch::RenderFogLightInteraction(const Material::ShaderPass *mtrlPass) cons
     shader->Bind();
 
     // light texture transform matrix
-    Mat4 viewProjScaleBiasMat = surfLight->def->GetViewProjScaleBiasMatrix() * surfSpace->def->GetObjectToWorldMatrix();
+    Mat4 viewProjScaleBiasMat = surfLight->def->GetViewProjScaleBiasMatrix() * surfSpace->objectToWorldMatrix;
     shader->SetConstant4x4f(shader->builtInConstantIndices[Shader::LightTextureMatrixConst], true, viewProjScaleBiasMat);
     shader->SetConstant3f("fogColor", &surfLight->def->state.materialParms[RenderObject::RedParm]);
 
@@ -965,7 +965,7 @@ void Batch::RenderBlendLightInteraction(const Material::ShaderPass *mtrlPass) co
     shader->Bind();
 
     // light texture transform matrix
-    Mat4 viewProjScaleBiasMat = surfLight->def->GetViewProjScaleBiasMatrix() * surfSpace->def->GetObjectToWorldMatrix();
+    Mat4 viewProjScaleBiasMat = surfLight->def->GetViewProjScaleBiasMatrix() * surfSpace->objectToWorldMatrix;
     shader->SetConstant4x4f(shader->builtInConstantIndices[Shader::LightTextureMatrixConst], true, viewProjScaleBiasMat);
     shader->SetConstant3f("blendColor", blendColor);
 
@@ -1000,7 +1000,7 @@ void Batch::RenderGui(const Material::ShaderPass *mtrlPass) const {
 
     Color4 color;
     if (mtrlPass->useOwnerColor) {
-        color = Color4(&surfSpace->def->state.materialParms[RenderObject::RedParm]);
+        color = Color4(&surfSpace->materialParms[RenderObject::RedParm]);
     } else {
         color = mtrlPass->constantColor;
     }
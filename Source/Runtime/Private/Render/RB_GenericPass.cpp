@@ -85,7 +85,7 @@ void RB_SelectionPass(int numDrawSurfs, DrawSurf **drawSurfs) {
         bool isDifferentMaterial = surf->material != prevMaterial;
 
         if (isDifferentMaterial || isDifferentObject) {
-            if (surf->space->def->state.flags & RenderObject::SkipSelectionFlag) {
+            if (surf->space->flags & RenderObject::SkipSelectionFlag) {
                 continue;
             }
 
@@ -102,7 +102,7 @@ void RB_SelectionPass(int numDrawSurfs, DrawSurf **drawSurfs) {
             prevMaterial = surf->material;
 
             if (isDifferentObject) {
-                bool depthHack = !!(surf->space->def->state.flags & RenderObject::DepthHackFlag);
+                bool depthHack = !!(surf->space->flags & RenderObject::DepthHackFlag);
 
                 if (prevDepthHack != depthHack) {
                     if (depthHack) {
@@ -155,7 +155,7 @@ void RB_OccluderPass(int numDrawSurfs, DrawSurf **drawSurfs) {
         bool isDifferentMaterial = surf->material != prevMaterial;
             
         if (isDifferentMaterial || isDifferentObject) {
-            if (!(surf->space->def->state.flags & RenderObject::OccluderFlag)) {
+            if (!(surf->space->flags & RenderObject::OccluderFlag)) {
                 continue;
             }
 
@@ -175,7 +175,7 @@ void RB_OccluderPass(int numDrawSurfs, DrawSurf **drawSurfs) {
             prevMaterial = surf->material;
 
             if (isDifferentObject) {
-                bool depthHack = !!(surf->space->def->state.flags & RenderObject::DepthHackFlag);
+                bool depthHack = !!(surf->space->flags & RenderObject::DepthHackFlag);
 
                 if (prevDepthHack != depthHack) {
                     if (depthHack) {
@@ -232,7 +232,7 @@ void RB_DepthPrePass(int numDrawSurfs, DrawSurf **drawSurfs) {
         bool isDifferentObject = surf->space != prevSpace;
         bool isDifferentSubMesh = prevSubMesh ? !surf->subMesh->IsShared(prevSubMesh) : true;
         bool isDifferentMaterial = surf->material != prevMaterial;
-        bool isDifferentInstance = !(surf->flags & DrawSurf::UseInstancing) || isDifferentMaterial || isDifferentSubMesh || !prevSpace || prevSpace->def->state.flags != surf->space->def->state.flags || prevSpace->def->state.layer != surf->space->def->state.layer ? true : false;
+        bool isDifferentInstance = !(surf->flags & DrawSurf::UseInstancing) || isDifferentMaterial || isDifferentSubMesh || !prevSpace || prevSpace->flags != surf->space->flags || prevSpace->layer != surf->space->layer ? true : false;
 
         if (isDifferentObject || isDifferentSubMesh || isDifferentMaterial) {
             if (prevMaterial && isDifferentInstance) {
@@ -245,7 +245,7 @@ void RB_DepthPrePass(int numDrawSurfs, DrawSurf **drawSurfs) {
             prevMaterial = surf->material;
 
             if (isDifferentObject) {
-                bool depthHack = !!(surf->space->def->state.flags & RenderObject::DepthHackFlag);
+                bool depthHack = !!(surf->space->flags & RenderObject::DepthHackFlag);
 
                 if (prevDepthHack != depthHack) {
                     if (surf->flags & DrawSurf::UseInstancing) {
@@ -308,7 +308,7 @@ void RB_UnlitPass(int numDrawSurfs, DrawSurf **drawSurfs) {
         bool isDifferentObject = surf->space != prevSpace;
         bool isDifferentSubMesh = prevSubMesh ? !surf->subMesh->IsShared(prevSubMesh) : true;
         bool isDifferentMaterial = surf->material != prevMaterial;
-        bool isDifferentInstance = !(surf->flags & DrawSurf::UseInstancing) || isDifferentMaterial || isDifferentSubMesh || !prevSpace || prevSpace->def->state.flags != surf->space->def->state.flags || prevSpace->def->state.layer != surf->space->def->state.layer ? true : false;
+        bool isDifferentInstance = !(surf->flags & DrawSurf::UseInstancing) || isDifferentMaterial || isDifferentSubMesh || !prevSpace || prevSpace->flags != surf->space->flags || prevSpace->layer != surf->space->layer ? true : false;
 
         if (isDifferentObject || isDifferentSubMesh || isDifferentMaterial) {
             if (prevMaterial && isDifferentInstance) {
@@ -321,7 +321,7 @@ void RB_UnlitPass(int numDrawSurfs, DrawSurf **drawSurfs) {
             prevMaterial = surf->material;
 
             if (isDifferentObject) {
-                bool depthHack = !!(surf->space->def->state.flags & RenderObject::DepthHackFlag);
+                bool depthHack = !!(surf->space->flags & RenderObject::DepthHackFlag);
 
                 if (prevDepthHack != depthHack) {
                     if (surf->flags & DrawSurf::UseInstancing) {
@@ -402,9 +402,9 @@ void RB_VelocityMapPass(int numDrawSurfs, DrawSurf **drawSurfs) {
             prevMaterial = surf->material;
 
             if (isDifferentObject) {
-                Mesh *mesh = surf->space->def->state.mesh;
+                Mesh *mesh = surf->space->mesh;
 
-                if (!mesh->IsSkinnedMesh() && (surf->space->def->worldMatrix == surf->space->def->prevWorldMatrix)) {
+                if (!mesh->IsSkinnedMesh() && (surf->space->objectToWorldMatrix == surf->space->prevObjectToWorldMatrix)) {
                     skipObject = surf->space;
                     continue;
                 }
@@ -484,7 +484,7 @@ void RB_FinalPass(int numDrawSurfs, DrawSurf **drawSurfs) {
         bool isDifferentObject = surf->space != prevSpace;
         bool isDifferentSubMesh = prevSubMesh ? !surf->subMesh->IsShared(prevSubMesh) : true;
         bool isDifferentMaterial = surf->material != prevMaterial;
-        bool isDifferentInstance = !(surf->flags & DrawSurf::UseInstancing) || isDifferentMaterial || isDifferentSubMesh || !prevSpace || prevSpace->def->state.flags != surf->space->def->state.flags || prevSpace->def->state.layer != surf->space->def->state.layer ? true : false;
+        bool isDifferentInstance = !(surf->flags & DrawSurf::UseInstancing) || isDifferentMaterial || isDifferentSubMesh || !prevSpace || prevSpace->flags != surf->space->flags || prevSpace->layer != surf->space->layer ? true : false;
 
         if (isDifferentObject || isDifferentSubMesh || isDifferentMaterial) {
             if (prevMaterial && isDifferentInstance) {
@@ -497,7 +497,7 @@ void RB_FinalPass(int numDrawSurfs, DrawSurf **drawSurfs) {
             prevMaterial = surf->material;
 
             if (isDifferentObject) {
-                bool depthHack = !!(surf->space->def->state.flags & RenderObject::DepthHackFlag);
+                bool depthHack = !!(surf->space->flags & RenderObject::DepthHackFlag);
 
                 if (prevDepthHack != depthHack) {
                     if (surf->flags & DrawSurf::UseInstancing) {
@@ -562,7 +562,7 @@ void RB_GuiPass(int numDrawSurfs, DrawSurf **drawSurfs) {
             prevMaterial = surf->material;
 
             if (isDifferentObject) {
-                bool depthHack = !!(surf->space->def->state.flags & RenderObject::DepthHackFlag);
+                bool depthHack = !!(surf->space->flags & RenderObject::DepthHackFlag);
 
                 if (prevDepthHack != depthHack) {
                     if (depthHack) {
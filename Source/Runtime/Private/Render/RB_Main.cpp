@@ -17,6 +17,7 @@
 #include "RenderInternal.h"
 #include "Platform/PlatformTime.h"
 #include "RBackEnd.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -122,6 +123,8 @@ static const void *RB_ExecuteBeginContext(const void *data) {
 
     backEnd.ctx = cmd->renderContext;
 
+    memset(&backEnd.ctx->backEndCounter, 0, sizeof(backEnd.ctx->backEndCounter));
+
     return (const void *)(cmd + 1);
 }
 
@@ -382,7 +385,7 @@ static void RB_GenerateOcclusionMapHierarchy() {
 
     rhi.SetViewport(prevViewportRect);
 
-    backEnd.ctx->renderCounter.homGenMsec = PlatformTime::Milliseconds() - startTime;
+    backEnd.ctx->backEndCounter.homGenMsec = PlatformTime::Milliseconds() - startTime;
 }
 
 static void RB_QueryOccludeeAABBs(int numAmbientOccludees, const AABB *occludeeAABB) {
@@ -441,7 +444,7 @@ static void RB_QueryOccludeeAABBs(int numAmbientOccludees, const AABB *occludeeA
 
     rhi.SetViewport(prevViewportRect);
 
-    backEnd.ctx->renderCounter.homQueryMsec = PlatformTime::Milliseconds() - startTime;
+    backEnd.ctx->backEndCounter.homQueryMsec = PlatformTime::Milliseconds() - startTime;
 }
 
 static void RB_MarkOccludeeVisibility(int numAmbientOccludees, const int *occludeeSurfIndexes, int numDrawSurfs, DrawSurf **drawSurfs) {	
@@ -463,7 +466,7 @@ static void RB_MarkOccludeeVisibility(int numAmbientOccludees, const int *occlud
 
             surf->flags &= ~DrawSurf::AmbientVisible;
 
-            if (space->def->state.joints) {
+            if (space->skinned) {
                 int sameEntityIndex = index + 1;
                 while (sameEntityIndex < numDrawSurfs) {
                     surf = drawSurfs[sameEntityIndex];
@@ -479,7 +482,7 @@ static void RB_MarkOccludeeVisibility(int numAmbientOccludees, const int *occlud
         visibilityPtr += 4;
     }
 
-    backEnd.ctx->renderCounter.homCullMsec = PlatformTime::Milliseconds() - startTime;
+    backEnd.ctx->backEndCounter.homCullMsec = PlatformTime::Milliseconds() - startTime;
 }
 
 static void RB_TestOccludeeBounds(int numDrawSurfs, DrawSurf **drawSurfs) {
@@ -502,13 +505,13 @@ static void RB_TestOccludeeBounds(int numDrawSurfs, DrawSurf **drawSurfs) {
 
         const VisibleObject *space = surf->space;
 
-        if (space->def->state.joints) {
+        if (space->skinned) {
             if (space == prevSpace) {
                 continue;
             }
-            occludeeAABB[numAmbientOccludees].SetFromTransformedAABB(space->def->GetLocalAABB(), space->def->state.origin, space->def->state.axis);
+            occludeeAABB[numAmbientOccludees].SetFromTransformedAABB(space->localAABB, space->origin, space->axis);
         } else {	
-            occludeeAABB[numAmbientOccludees].SetFromTransformedAABB(surf->subMesh->GetAABB() * space->def->state.scale, space->def->state.origin, space->def->state.axis);
+            occludeeAABB[numAmbientOccludees].SetFromTransformedAABB(surf->subMesh->GetAABB() * space->scale, space->origin, space->axis);
         }
         
         //BE_LOG(L"%.2f %.2f %.2f %.2f\n", nearPlane.a, nearPlane.b, nearPlane.c, nearPlane.d);
@@ -1067,11 +1070,27 @@ static const void *RB_ExecuteSwapBuffers(const void *data) {
     }
 
     rhi.SwapBuffers();
+
+    // Place a fence for the buffer cache of this frame
+    bufferCacheManager.EndDrawCommand();
     
     return (const void *)(cmd + 1);
 }
 
+static const void *RB_ExecuteUploadTexture(const void *data) {
+    UploadTextureRenderCommand *cmd = (UploadTextureRenderCommand *)data;
+
+    // Canceled if the texture is deleted or uploaded again in the same frame
+    if (cmd->texture) {
+        cmd->texture->CreateStreamedMips(cmd->mips, cmd->format, cmd->useSRGB, cmd->width, cmd->height);
+    }
+
+    return (const void *)(cmd + 1);
+}
+
 void RB_Execute(const void *data) {
+    BE_PROFILE_SCOPE("RB_Execute");
+
     int t1, t2;
 
     t1 = PlatformTime::Milliseconds();
@@ -1094,9 +1113,12 @@ void RB_Execute(const void *data) {
         case SwapBuffersCommand:
             data = RB_ExecuteSwapBuffers(data);
             continue;
+        case UploadTextureCommand:
+            data = RB_ExecuteUploadTexture(data);
+            continue;
         case EndOfCommand:
             t2 = PlatformTime::Milliseconds();
-            backEnd.ctx->renderCounter.backEndMsec = t2 - t1;
+            backEnd.ctx->backEndCounter.backEndMsec = t2 - t1;
             return;
         }
     }
@@ -214,7 +214,7 @@ static bool RB_ShadowCubeMapFacePass(const VisibleLight *visLight, const Mat4 &l
         bool isDifferentObject = surf->space != prevSpace;
         bool isDifferentSubMesh = prevSubMesh ? !surf->subMesh->IsShared(prevSubMesh) : true;
         bool isDifferentMaterial = surf->material != prevMaterial;
-        bool isDifferentInstance = !(surf->flags & DrawSurf::UseInstancing) || isDifferentMaterial || isDifferentSubMesh || !prevSpace || prevSpace->def->state.flags != surf->space->def->state.flags || prevSpace->def->state.layer != surf->space->def->state.layer ? true : false;
+        bool isDifferentInstance = !(surf->flags & DrawSurf::UseInstancing) || isDifferentMaterial || isDifferentSubMesh || !prevSpace || prevSpace->flags != surf->space->flags || prevSpace->layer != surf->space->layer ? true : false;
 
         if (isDifferentObject || isDifferentSubMesh || isDifferentMaterial) {
             if (prevMaterial && isDifferentInstance) {
@@ -229,11 +229,11 @@ static bool RB_ShadowCubeMapFacePass(const VisibleLight *visLight, const Mat4 &l
             if (isDifferentObject) {
                 prevSpace = surf->space;
 
-                if (!(surf->space->def->state.flags & RenderObject::CastShadowsFlag)) {
+                if (!(surf->space->flags & RenderObject::CastShadowsFlag)) {
                     continue;
                 }
 
-                OBB obb(surf->space->def->GetLocalAABB(), surf->space->def->state.origin, surf->space->def->state.axis);
+                OBB obb(surf->space->localAABB, surf->space->origin, surf->space->axis);
                 if (lightFrustum.CullOBB(obb)) {
                     skipObject = surf->space;
                     continue;
@@ -243,8 +243,8 @@ static bool RB_ShadowCubeMapFacePass(const VisibleLight *visLight, const Mat4 &l
             }
         }
 
-        if (!surf->space->def->state.joints) {
-            OBB obb(surf->subMesh->GetAABB() * surf->space->def->state.scale, surf->space->def->state.origin, surf->space->def->state.axis);
+        if (!surf->space->skinned) {
+            OBB obb(surf->subMesh->GetAABB() * surf->space->scale, surf->space->origin, surf->space->axis);
             if (lightFrustum.CullOBB(obb)) {
                 continue;
             }
@@ -277,7 +277,7 @@ static bool RB_ShadowCubeMapFacePass(const VisibleLight *visLight, const Mat4 &l
 
         if (surf->space != entity2) {
             if (!(surf->flags & DrawSurf::UseInstancing)) {
-                backEnd.modelViewMatrix = lightViewMatrix * surf->space->def->GetObjectToWorldMatrix();
+                backEnd.modelViewMatrix = lightViewMatrix * surf->space->objectToWorldMatrix;
                 backEnd.modelViewProjMatrix = backEnd.projMatrix * backEnd.modelViewMatrix;
             } else {
                 backEnd.batch.AddInstance(surf);
@@ -379,7 +379,7 @@ static void RB_ShadowCubeMapPass(const VisibleLight *visLight, const Frustum &vi
     rhi.SetScissor(prevScissorRect);
     rhi.SetViewport(backEnd.renderRect);
 
-    backEnd.ctx->renderCounter.numShadowMapDraw += shadowMapDraw;
+    backEnd.ctx->backEndCounter.numShadowMapDraw += shadowMapDraw;
 }
 
 // TODO: cascade 별로 컬링해야함
@@ -432,7 +432,7 @@ static bool RB_ShadowMapPass(const VisibleLight *visLight, const Frustum &viewFr
         bool isDifferentObject = surf->space != prevSpace;
         bool isDifferentSubMesh = prevSubMesh ? !surf->subMesh->IsShared(prevSubMesh) : true;
         bool isDifferentMaterial = surf->material != prevMaterial;
-        bool isDifferentInstance = !(surf->flags & DrawSurf::UseInstancing) || isDifferentMaterial || isDifferentSubMesh || !prevSpace || prevSpace->def->state.flags != surf->space->def->state.flags || prevSpace->def->state.layer != surf->space->def->state.layer ? true : false;
+        bool isDifferentInstance = !(surf->flags & DrawSurf::UseInstancing) || isDifferentMaterial || isDifferentSubMesh || !prevSpace || prevSpace->flags != surf->space->flags || prevSpace->layer != surf->space->layer ? true : false;
 
         if (isDifferentObject || isDifferentSubMesh || isDifferentMaterial) {
             if (prevMaterial && isDifferentInstance) {
@@ -446,7 +446,7 @@ static bool RB_ShadowMapPass(const VisibleLight *visLight, const Frustum &viewFr
 
             if (isDifferentObject) {
                 if (!(surf->flags & DrawSurf::UseInstancing)) {
-                    backEnd.modelViewMatrix = visLight->def->viewMatrix * surf->space->def->GetObjectToWorldMatrix();
+                    backEnd.modelViewMatrix = visLight->def->viewMatrix * surf->space->objectToWorldMatrix;
                     backEnd.modelViewProjMatrix = backEnd.shadowProjectionMatrix * backEnd.modelViewMatrix;
                 }
 
@@ -534,7 +534,7 @@ static void RB_OrthogonalShadowMapPass(const VisibleLight *visLight, const Frust
     backEnd.shadowViewProjectionScaleBiasMatrix[0] = textureScaleBiasMatrix * backEnd.shadowProjectionMatrix * visLight->def->viewMatrix;
 
     if (RB_ShadowMapPass(visLight, viewFrustum, 0, false)) {
-        backEnd.ctx->renderCounter.numShadowMapDraw++;
+        backEnd.ctx->backEndCounter.numShadowMapDraw++;
     }
 }
 
@@ -579,7 +579,7 @@ static void RB_ProjectedShadowMapPass(const VisibleLight *visLight, const Frustu
     backEnd.shadowViewProjectionScaleBiasMatrix[0] = textureScaleBiasMatrix * backEnd.shadowProjectionMatrix * visLight->def->viewMatrix;
 
     if (RB_ShadowMapPass(visLight, viewFrustum, 0, false)) {
-        backEnd.ctx->renderCounter.numShadowMapDraw++;
+        backEnd.ctx->backEndCounter.numShadowMapDraw++;
     }
 }
 
@@ -685,7 +685,7 @@ static void RB_CascadedShadowMapPass(const VisibleLight *visLight) {
         splitViewFrustum.MoveFarDistance(dFar);
 
         if (RB_SingleCascadedShadowMapPass(visLight, splitViewFrustum, cascadeIndex, true)) {
-            backEnd.ctx->renderCounter.numShadowMapDraw++;
+            backEnd.ctx->backEndCounter.numShadowMapDraw++;
         }
     }
 }
@@ -61,6 +61,13 @@ CVAR(r_optimizedShadowProjection, L"1", CVar::Integer, L"");
 
 CVAR(r_HOM, L"0", CVar::Bool, L"use hierarchical occlusion map culling");
 CVAR(r_HOM_debug, L"0", CVar::Bool, L"");
+CVAR(r_occlusionCulling, L"0", CVar::Bool, L"use CPU software occlusion culling with occluder flagged objects");
+CVAR(r_occlusionBufferWidth, L"256", CVar::Integer, L"width of the software occlusion buffer");
+CVAR(r_occlusionBufferHeight, L"128", CVar::Integer, L"height of the software occlusion buffer");
+CVAR(r_clusteredLighting, L"0", CVar::Bool, L"assign non-shadowing point/spot lights to surfaces with a CPU light cluster grid");
+CVAR(r_lightClusterTilesX, L"16", CVar::Integer, L"number of light cluster tiles in horizontal axis");
+CVAR(r_lightClusterTilesY, L"8", CVar::Integer, L"number of light cluster tiles in vertical axis");
+CVAR(r_lightClusterSlices, L"24", CVar::Integer, L"number of light cluster slices in depth");
 
 CVAR(r_ambientLit, L"1", CVar::Bool | CVar::Archive, L"use ambient lighting");
 CVAR(r_ambientScale, L"0.5", CVar::Float | CVar::Archive, L"ambient light intensities are mutipled by this");
@@ -70,6 +77,8 @@ CVAR(r_offsetUnits, L"2", CVar::Float, L"polygon offset parameter");
 CVAR(r_queryWaitFrames, L"10", CVar::Integer, L"");
 CVAR(r_instancing, L"2", CVar::Integer | CVar::Archive, L"");
 CVAR(r_maxInstancingCount, L"1024", CVar::Integer | CVar::Archive, L"");
+CVAR(r_frameDataBlockSize, L"1024", CVar::Integer, L"size of frame data memory block in KB");
+CVAR(r_parallelVisibility, L"1", CVar::Bool, L"split visibility determination across the job threads");
 
 CVAR(r_HDR, L"2", CVar::Integer | CVar::Archive, L"HDR rendering type, 0 = no HDR, 1 = FP11 or FP16, 2 = FP16, 3 = FP32");
 CVAR(r_HDR_debug, L"0", CVar::Integer, L"");
@@ -114,6 +123,7 @@ CVAR(r_useLightScissors, L"1", CVar::Bool, L"use custom scissor rectangle for ea
 CVAR(r_useLightOcclusionQuery, L"0", CVar::Bool, L"");
 CVAR(r_usePostProcessing, L"1", CVar::Bool | CVar::Archive, L"");
 
+CVAR(r_smp, L"0", CVar::Bool, L"run the back end on a render thread overlapped with the next frame of the front end");
 CVAR(r_skipBackEnd, L"0", CVar::Bool, L"don't draw anything");
 CVAR(r_skipAmbientPass, L"0", CVar::Bool, L"skip ambient draw pass");
 CVAR(r_skipShadowAndLitPass, L"0", CVar::Bool, L"skip shadow and lighting pass");
@@ -124,6 +134,7 @@ CVAR(r_skipFinalPass, L"0", CVar::Bool, L"skip final draw pass");
 
 CVAR(r_showStats, L"0", CVar::Integer, L"show rendering statistics");
 CVAR(r_showBufferCache, L"0", CVar::Bool, L"print dynamic buffer usage every frame");
+CVAR(r_showFrameData, L"0", CVar::Bool, L"print frame data memory usage and its high-water mark every frame");
 CVAR(r_showBufferCacheTiming, L"1", CVar::Bool, L"print dynamic buffer map/unmap timing every frame");
 CVAR(r_showAABB, L"0", CVar::Integer, L"show axis-aligned bounding boxes");
 CVAR(r_showWireframe, L"0", CVar::Integer, L"show wireframe");
@@ -70,6 +70,13 @@ extern CVar     r_optimizedShadowProjection;
 
 extern CVar     r_HOM;
 extern CVar     r_HOM_debug;
+extern CVar     r_occlusionCulling;
+extern CVar     r_occlusionBufferWidth;
+extern CVar     r_occlusionBufferHeight;
+extern CVar     r_clusteredLighting;
+extern CVar     r_lightClusterTilesX;
+extern CVar     r_lightClusterTilesY;
+extern CVar     r_lightClusterSlices;
 
 extern CVar     r_ambientLit;
 extern CVar     r_ambientScale;
@@ -79,6 +86,8 @@ extern CVar     r_offsetUnits;
 extern CVar     r_queryWaitFrames;
 extern CVar     r_instancing;
 extern CVar     r_maxInstancingCount;
+extern CVar     r_frameDataBlockSize;
+extern CVar     r_parallelVisibility;
 
 extern CVar     r_HDR;
 extern CVar     r_HDR_debug;
@@ -123,6 +132,7 @@ extern CVar     r_useLightScissors;
 extern CVar     r_useLightOcclusionQuery;
 extern CVar     r_usePostProcessing;
 
+extern CVar     r_smp;
 extern CVar     r_skipBackEnd;
 extern CVar     r_skipAmbientPass;
 extern CVar     r_skipShadowAndLitPass;
@@ -132,6 +142,7 @@ extern CVar     r_skipFinalPass;
 
 extern CVar     r_showStats;
 extern CVar     r_showBufferCache;
+extern CVar     r_showFrameData;
 extern CVar     r_showBufferCacheTiming;
 extern CVar     r_showAABB;
 extern CVar     r_showWireframe;
@@ -31,7 +31,8 @@ enum RenderCommand {
     BeginContextCommand,
     DrawViewCommand,
     ScreenShotCommand,
-    SwapBuffersCommand
+    SwapBuffersCommand,
+    UploadTextureCommand
 };
 
 struct RenderCommandBuffer {
@@ -62,4 +63,14 @@ struct SwapBuffersRenderCommand {
     int             commandId;
 };
 
+struct UploadTextureRenderCommand {
+    int             commandId;
+    Texture *       texture;        // null if the upload is canceled
+    Image::Format   format;         // internal format to create the texture with
+    bool            useSRGB;
+    int             width;          // size of the full image
+    int             height;
+    Image           mips;           // refers to the texels copied in the frame data
+};
+
 BE_NAMESPACE_END
@@ -28,6 +28,9 @@ RenderContext::RenderContext() {
 
     frameCount = 0;
 
+    memset(&renderCounter, 0, sizeof(renderCounter));
+    memset(&backEndCounter, 0, sizeof(backEndCounter));
+
     screenColorTexture = nullptr;
     screenDepthTexture = nullptr;
     screenNormalTexture = nullptr;
@@ -75,6 +78,8 @@ RenderContext::RenderContext() {
 }
 
 void RenderContext::Init(RHI::WindowHandle hwnd, int renderingWidth, int renderingHeight, RHI::DisplayContextFunc displayFunc, void *displayFuncDataPtr, int flags) {
+    MemTagScope memTagScope(MemTag::Render);
+
     this->contextHandle = rhi.CreateContext(hwnd, (flags & Flag::UseSharedContext) ? true : false);
     this->flags = flags;
 
@@ -525,6 +530,9 @@ void RenderContext::BeginFrame() {
 
     // Window size have changed since last call of BeginFrame()
     if (renderingWidth != screenRT->GetWidth() || renderingHeight != screenRT->GetHeight()) {
+        // The render thread may still be drawing the previous frame into the old render targets
+        renderSystem.SyncRenderThread();
+
         FreeScreenMapRT();
         FreeHdrMapRT();
 
@@ -535,8 +543,6 @@ void RenderContext::BeginFrame() {
     BeginContextRenderCommand *cmd = (BeginContextRenderCommand *)renderSystem.GetCommandBuffer(sizeof(BeginContextRenderCommand));
     cmd->commandId = BeginContextCommand;
     cmd->renderContext = this;
-
-    bufferCacheManager.BeginWrite();
 }
 
 void RenderContext::EndFrame() {
@@ -549,11 +555,21 @@ void RenderContext::EndFrame() {
     SwapBuffersRenderCommand *cmd = (SwapBuffersRenderCommand *)renderSystem.GetCommandBuffer(sizeof(SwapBuffersRenderCommand));
     cmd->commandId = SwapBuffersCommand;
 
+    // Buffer cache switching rewinds the buffers which the previous frame reads from,
+    // so the render thread should finish the previous frame first.
+    renderSystem.SyncRenderThread();
+
+    // Back end counters are of the last finished frame.
+    // It is the previous frame, because the back end runs after this point even without the render thread.
+    GatherBackEndCounter();
+
     bufferCacheManager.BeginBackEnd();
-    
-    renderSystem.IssueCommands();
 
-    bufferCacheManager.EndDrawCommand();
+    // Wait until the GPU is no longer using the buffers to be written by the next frame
+    bufferCacheManager.BeginWrite();
+
+    // EndDrawCommand() is called by the back end after swapping buffers
+    renderSystem.IssueCommands();
 
     guiMesh.Clear();
 
@@ -582,6 +598,23 @@ void RenderContext::EndFrame() {
     renderSystem.currentContext = nullptr;
 }
 
+void RenderContext::GatherBackEndCounter() {
+    renderCounter.backEndMsec = backEndCounter.backEndMsec;
+    renderCounter.homGenMsec = backEndCounter.homGenMsec;
+    renderCounter.homQueryMsec = backEndCounter.homQueryMsec;
+    renderCounter.homCullMsec = backEndCounter.homCullMsec;
+
+    renderCounter.drawCalls = backEndCounter.drawCalls;
+    renderCounter.drawVerts = backEndCounter.drawVerts;
+    renderCounter.drawIndexes = backEndCounter.drawIndexes;
+
+    renderCounter.shadowDrawCalls = backEndCounter.shadowDrawCalls;
+    renderCounter.shadowDrawVerts = backEndCounter.shadowDrawVerts;
+    renderCounter.shadowDrawIndexes = backEndCounter.shadowDrawIndexes;
+
+    renderCounter.numShadowMapDraw = backEndCounter.numShadowMapDraw;
+}
+
 void RenderContext::AdjustFrom640x480(float *x, float *y, float *w, float *h) const {
     float xScale = deviceWidth / 640.0f;
     float yScale = deviceHeight / 480.0f;
@@ -22,8 +22,28 @@ class VisibleObject {
 public:
     int                     index;
 
+                            // Used only by the front end, the game thread keeps updating it while the back end runs
     const RenderObject *    def;
 
+                            // Render object states for the back end, copied from def when registered
+    int                     objectIndex;
+    int                     flags;
+    int                     layer;
+    Vec3                    origin;
+    Vec3                    scale;
+    Mat3                    axis;
+    AABB                    localAABB;
+    Mat3x4                  objectToWorldMatrix;
+    Mat3x4                  prevObjectToWorldMatrix;
+    float                   materialParms[RenderObject::MaxMaterialParms];
+    RenderObject::WireframeMode wireframeMode;
+    Color4                  wireframeColor;
+    Mesh *                  mesh;
+    bool                    skinned;
+
+                            // Copy of the joint cache of the mesh, made after the front end updates it
+    const SkinningJointCache *skinningJointCache;
+
     Mat3x4                  modelViewMatrix;
     Mat4                    modelViewProjMatrix;
 
@@ -39,12 +59,14 @@ class VisibleLight {
 public:
     int                     index;
 
+                            // Copy of the render light in the frame data
     const RenderLight *     def;
 
     float *                 materialRegisters;
 
     Rect                    scissorRect;        // y 좌표는 밑에서 부터 증가
     bool                    occlusionVisible;
+    bool                    clustered;          // lit surfaces are found with the light cluster grid
 
     Mat4                    viewProjTexMatrix;
 
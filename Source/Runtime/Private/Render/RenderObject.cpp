@@ -35,6 +35,8 @@ RenderObject::RenderObject() {
     numMeshSurfProxies = 0;
 
     firstUpdate = true;
+    hidden = false;
+    occluderIndex = -1;
 }
 
 RenderObject::~RenderObject() {
@@ -19,6 +19,7 @@
 #include "RBackEnd.h"
 #include "Render/Font.h"
 #include "Core/Cmds.h"
+#include "Core/Profiler.h"
 #include "File/FileSystem.h"
 
 BE_NAMESPACE_BEGIN
@@ -28,6 +29,11 @@ RenderSystem        renderSystem;
 
 void RenderSystem::Init(void *windowHandle, const RHI::Settings *settings) {
     cmdSystem.AddCommand(L"screenshot", Cmd_ScreenShot);
+#ifdef USE_NULL_RHI
+    cmdSystem.AddCommand(L"recordRHI", Cmd_RecordRHI);
+    cmdSystem.AddCommand(L"replayRHI", Cmd_ReplayRHI);
+    cmdSystem.AddCommand(L"rhiStats", Cmd_RHIStats);
+#endif
 
     // Initialize OpenGL renderer
     rhi.Init(windowHandle, settings);
@@ -104,6 +110,13 @@ void RenderSystem::Init(void *windowHandle, const RHI::Settings *settings) {
 
 void RenderSystem::Shutdown() {
     cmdSystem.RemoveCommand(L"screenshot");
+#ifdef USE_NULL_RHI
+    cmdSystem.RemoveCommand(L"recordRHI");
+    cmdSystem.RemoveCommand(L"replayRHI");
+    cmdSystem.RemoveCommand(L"rhiStats");
+#endif
+
+    StopRenderThread();
 
     frameData.Shutdown();
 
@@ -234,6 +247,32 @@ void RenderSystem::CmdScreenshot(int x, int y, int width, int height, const char
     Str::Copynz(cmd->filename, filename, COUNT_OF(cmd->filename));
 }
 
+// Texels are copied to the frame data which lives until the back end has executed the command.
+UploadTextureRenderCommand *RenderSystem::CmdUploadTexture(Texture *texture, const Image &mips, Image::Format format, bool useSRGB, int width, int height) {
+    void *cmdBuffer = GetCommandBuffer(sizeof(UploadTextureRenderCommand));
+    if (!cmdBuffer) {
+        return nullptr;
+    }
+
+    int size = mips.GetSize(0, mips.NumMipmaps());
+    byte *texels = (byte *)frameData.Alloc(size);
+    memcpy(texels, mips.GetPixels(), size);
+
+    UploadTextureRenderCommand *cmd = new (cmdBuffer) UploadTextureRenderCommand;
+    cmd->commandId      = UploadTextureCommand;
+    cmd->texture        = texture;
+    cmd->format         = format;
+    cmd->useSRGB        = useSRGB;
+    cmd->width          = width;
+    cmd->height         = height;
+    cmd->mips.InitFromMemory(mips.GetWidth(), mips.GetHeight(), 1, 1, mips.NumMipmaps(), mips.GetFormat(), texels, mips.GetFlags());
+
+    return cmd;
+}
+
+// Issues the commands of the current frame to the back end.
+// In SMP mode, waits for the render thread to finish the previous frame (which ended with SwapBuffersCommand),
+// and then hands the commands over to the render thread so that the front end can build the next frame meanwhile.
 void RenderSystem::IssueCommands() {
     RenderCommandBuffer *cmds = frameData.GetCommands();
     // add an end-of-list command
@@ -242,12 +281,120 @@ void RenderSystem::IssueCommands() {
     // clear it out, in case this is a sync and not a buffer flip
     cmds->used = 0;
 
+    if (r_smp.GetBool() != IsRenderThreadRunning()) {
+        if (r_smp.GetBool()) {
+            StartRenderThread();
+        } else {
+            StopRenderThread();
+        }
+    }
+
+    if (renderThread) {
+        SyncRenderThread();
+
+        PlatformMutex::Lock(renderThreadMutex);
+        renderThreadCommands = cmds->data;
+        PlatformCondition::Signal(renderThreadCondition);
+        PlatformMutex::Unlock(renderThreadMutex);
+        return;
+    }
+
     if (!r_skipBackEnd.GetBool()) {
         RB_Execute(cmds->data);
     }
 }
 
+void RenderSystem::SyncRenderThread() {
+    if (!renderThread) {
+        return;
+    }
+
+    PlatformMutex::Lock(renderThreadMutex);
+    while (renderThreadCommands) {
+        PlatformCondition::Wait(backEndFinishedCondition, renderThreadMutex);
+    }
+    PlatformMutex::Unlock(renderThreadMutex);
+}
+
+void RenderSystem::StartRenderThread() {
+    if (renderThread) {
+        return;
+    }
+
+    renderThreadMutex = PlatformMutex::Create();
+    renderThreadCondition = PlatformCondition::Create();
+    backEndFinishedCondition = PlatformCondition::Create();
+    renderThreadCommands = nullptr;
+    renderThreadTerminate = false;
+
+    renderThread = PlatformThread::Create(RenderThreadProc, this);
+    if (!renderThread) {
+        BE_WARNLOG(L"RenderSystem::StartRenderThread: failed to create render thread\n");
+
+        PlatformCondition::Delete(backEndFinishedCondition);
+        PlatformCondition::Delete(renderThreadCondition);
+        PlatformMutex::Delete(renderThreadMutex);
+        r_smp.SetBool(false);
+    }
+}
+
+void RenderSystem::StopRenderThread() {
+    if (!renderThread) {
+        return;
+    }
+
+    SyncRenderThread();
+
+    PlatformMutex::Lock(renderThreadMutex);
+    renderThreadTerminate = true;
+    PlatformCondition::Signal(renderThreadCondition);
+    PlatformMutex::Unlock(renderThreadMutex);
+
+    // Wait() deletes the thread
+    PlatformThread::Wait(renderThread);
+    renderThread = nullptr;
+
+    PlatformCondition::Delete(backEndFinishedCondition);
+    PlatformCondition::Delete(renderThreadCondition);
+    PlatformMutex::Delete(renderThreadMutex);
+}
+
+void RenderSystem::RenderThreadProc(void *param) {
+    RenderSystem *rs = (RenderSystem *)param;
+
+    profiler.SetThreadName("Render");
+
+    PlatformMutex::Lock(rs->renderThreadMutex);
+
+    while (1) {
+        while (!rs->renderThreadCommands && !rs->renderThreadTerminate) {
+            PlatformCondition::Wait(rs->renderThreadCondition, rs->renderThreadMutex);
+        }
+
+        if (rs->renderThreadTerminate) {
+            break;
+        }
+
+        const void *cmds = rs->renderThreadCommands;
+
+        PlatformMutex::Unlock(rs->renderThreadMutex);
+
+        if (!r_skipBackEnd.GetBool()) {
+            RB_Execute(cmds);
+        }
+
+        PlatformMutex::Lock(rs->renderThreadMutex);
+
+        rs->renderThreadCommands = nullptr;
+        PlatformCondition::Broadcast(rs->backEndFinishedCondition);
+    }
+
+    PlatformMutex::Unlock(rs->renderThreadMutex);
+}
+
 void RenderSystem::RecreateScreenMapRT() {
+    SyncRenderThread();
+
     for (int i = 0; i < renderContexts.Count(); i++) {
         RenderContext *rc = renderContexts[i];
         rc->FreeScreenMapRT();
@@ -256,6 +403,8 @@ void RenderSystem::RecreateScreenMapRT() {
 }
 
 void RenderSystem::RecreateHDRMapRT() {
+    SyncRenderThread();
+
     for (int i = 0; i < renderContexts.Count(); i++) {
         RenderContext *rc = renderContexts[i];
         rc->FreeHdrMapRT();
@@ -264,6 +413,8 @@ void RenderSystem::RecreateHDRMapRT() {
 }
 
 void RenderSystem::RecreateShadowMapRT() {
+    SyncRenderThread();
+
     for (int i = 0; i < renderContexts.Count(); i++) {
         RenderContext *rc = renderContexts[i];
         rc->FreeShadowMapRT();
@@ -526,4 +677,55 @@ void RenderSystem::Cmd_ScreenShot(const CmdArgs &args) {
     renderSystem.CmdScreenshot(0, 0, renderSystem.currentContext->GetDeviceWidth(), renderSystem.currentContext->GetDeviceHeight(), path);
 }
 
+#ifdef USE_NULL_RHI
+
+void RenderSystem::Cmd_RecordRHI(const CmdArgs &args) {
+    // RHI calls are made by the render thread, so switch files between frames.
+    renderSystem.SyncRenderThread();
+
+    if (args.Argc() < 2) {
+        if (rhi.IsRecording()) {
+            rhi.EndRecording();
+            BE_LOG(L"RHI recording stopped\n");
+        } else {
+            BE_LOG(L"recordRHI <filename> : starts recording RHI calls, without arguments stops recording\n");
+        }
+        return;
+    }
+
+    rhi.BeginRecording(WStr::ToStr(args.Argv(1)));
+}
+
+void RenderSystem::Cmd_ReplayRHI(const CmdArgs &args) {
+    if (args.Argc() < 2) {
+        BE_LOG(L"replayRHI <filename> : replays recorded RHI calls\n");
+        return;
+    }
+
+    renderSystem.SyncRenderThread();
+
+    int numFrames = rhi.Replay(WStr::ToStr(args.Argv(1)));
+    if (numFrames >= 0) {
+        const NullRHI::FrameStats &stats = rhi.GetFrameStats();
+        BE_LOG(L"%i frames replayed, last frame: %i draws, %i verts\n", numFrames, stats.numDrawCalls, stats.numVerts);
+    }
+}
+
+void RenderSystem::Cmd_RHIStats(const CmdArgs &args) {
+    const NullRHI::FrameStats &frameStats = rhi.GetFrameStats();
+    const NullRHI::MemoryStats &memoryStats = rhi.GetMemoryStats();
+
+    BE_LOG(L"draws: %i, instances: %i, verts: %i\n", frameStats.numDrawCalls, frameStats.numInstances, frameStats.numVerts);
+    BE_LOG(L"state changes: %i, shader: %i, texture: %i, buffer: %i, render target: %i, constants: %i\n",
+        frameStats.numStateChanges, frameStats.numShaderChanges, frameStats.numTextureChanges, 
+        frameStats.numBufferChanges, frameStats.numRenderTargetChanges, frameStats.numConstantUpdates);
+    BE_LOG(L"uploaded: buffer %hs, texture %hs\n", 
+        Str::FormatBytes((int)frameStats.bufferUploadBytes).c_str(), Str::FormatBytes((int)frameStats.textureUploadBytes).c_str());
+    BE_LOG(L"%i buffers (%hs), %i textures (%hs)\n", 
+        memoryStats.numBuffers, Str::FormatBytes((int)memoryStats.bufferBytes).c_str(),
+        memoryStats.numTextures, Str::FormatBytes((int)memoryStats.textureBytes).c_str());
+}
+
+#endif
+
 BE_NAMESPACE_END
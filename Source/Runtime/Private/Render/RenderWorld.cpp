@@ -19,6 +19,7 @@
 #include "Core/JointPose.h"
 #include "Core/Heap.h"
 #include "Platform/PlatformTime.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -44,6 +45,8 @@ void RenderWorld::ClearScene() {
     lightDbvt.Purge();
     staticMeshDbvt.Purge();
 
+    occluderObjects.Clear();
+
     for (int i = 0; i < renderObjects.Count(); i++) {
         SAFE_DELETE(renderObjects[i]);
     }
@@ -113,6 +116,12 @@ void RenderWorld::UpdateRenderObject(int handle, const RenderObject::State *obje
                 meshSurfProxy->id = staticMeshDbvt.CreateProxy(renderObject->meshSurfProxies[surfaceIndex].worldAABB, MeterToUnit(0.0f), &renderObject->meshSurfProxies[surfaceIndex]);
             }
         }
+
+        UpdateOccluderLink(renderObject);
+    } else if (renderObject->hidden) {
+        // Hidden objects are not linked in the DBVTs, so just keep the state.
+        // Proxies will be relinked with the latest state in ShowRenderObject().
+        renderObject->Update(objectDef);
     } else {
         bool originMatch    = (objectDef->origin == renderObject->state.origin);
         bool axisMatch      = (objectDef->axis == renderObject->state.axis);
@@ -158,6 +167,9 @@ void RenderWorld::UpdateRenderObject(int handle, const RenderObject::State *obje
         }
 
         renderObject->Update(objectDef);
+
+        // Occluder flag might be changed
+        UpdateOccluderLink(renderObject);
     }
 }
 
@@ -173,13 +185,122 @@ void RenderWorld::RemoveRenderObject(int handle) {
         return;
     }
 
+    if (!renderObject->hidden) {
+        objectDbvt.DestroyProxy(renderObject->proxy->id);
+        for (int i = 0; i < renderObject->numMeshSurfProxies; i++) {
+            staticMeshDbvt.DestroyProxy(renderObject->meshSurfProxies[i].id);
+        }
+    }
+
+    UnlinkOccluder(renderObject);
+
+    delete renderObjects[handle];
+    renderObjects[handle] = nullptr;
+}
+
+void RenderWorld::HideRenderObject(int handle) {
+    if (handle < 0 || handle >= renderObjects.Count()) {
+        BE_WARNLOG(L"RenderWorld::HideRenderObject: handle %i > %i\n", handle, renderObjects.Count() - 1);
+        return;
+    }
+
+    RenderObject *renderObject = renderObjects[handle];
+    if (!renderObject) {
+        BE_WARNLOG(L"RenderWorld::HideRenderObject: handle %i is nullptr\n", handle);
+        return;
+    }
+
+    if (renderObject->hidden) {
+        return;
+    }
+
+    // Unlink proxies from the DBVTs but keep them allocated
     objectDbvt.DestroyProxy(renderObject->proxy->id);
+    renderObject->proxy->id = -1;
+
     for (int i = 0; i < renderObject->numMeshSurfProxies; i++) {
         staticMeshDbvt.DestroyProxy(renderObject->meshSurfProxies[i].id);
+        renderObject->meshSurfProxies[i].id = -1;
     }
 
-    delete renderObjects[handle];
-    renderObjects[handle] = nullptr;
+    renderObject->hidden = true;
+
+    UnlinkOccluder(renderObject);
+}
+
+void RenderWorld::ShowRenderObject(int handle) {
+    if (handle < 0 || handle >= renderObjects.Count()) {
+        BE_WARNLOG(L"RenderWorld::ShowRenderObject: handle %i > %i\n", handle, renderObjects.Count() - 1);
+        return;
+    }
+
+    RenderObject *renderObject = renderObjects[handle];
+    if (!renderObject) {
+        BE_WARNLOG(L"RenderWorld::ShowRenderObject: handle %i is nullptr\n", handle);
+        return;
+    }
+
+    if (!renderObject->hidden) {
+        return;
+    }
+
+    const RenderObject::State &state = renderObject->state;
+
+    renderObject->proxy->worldAABB.SetFromTransformedAABB(state.localAABB * state.scale, state.origin, state.axis);
+    renderObject->proxy->id = objectDbvt.CreateProxy(renderObject->proxy->worldAABB, MeterToUnit(0.5f), renderObject->proxy);
+
+    if (state.mesh && !state.joints) {
+        // Mesh might be changed while hidden
+        if (state.mesh->NumSurfaces() != renderObject->numMeshSurfProxies) {
+            if (renderObject->meshSurfProxies) {
+                Mem_Free(renderObject->meshSurfProxies);
+            }
+            renderObject->numMeshSurfProxies = state.mesh->NumSurfaces();
+            renderObject->meshSurfProxies = (DbvtProxy *)Mem_ClearedAlloc(renderObject->numMeshSurfProxies * sizeof(DbvtProxy));
+        }
+
+        for (int surfaceIndex = 0; surfaceIndex < state.mesh->NumSurfaces(); surfaceIndex++) {
+            const MeshSurf *meshSurf = state.mesh->GetSurface(surfaceIndex);
+
+            DbvtProxy *meshSurfProxy = &renderObject->meshSurfProxies[surfaceIndex];
+            meshSurfProxy->renderObject = renderObject;
+            meshSurfProxy->mesh = state.mesh;
+            meshSurfProxy->meshSurfIndex = surfaceIndex;
+            meshSurfProxy->worldAABB.SetFromTransformedAABB(meshSurf->subMesh->GetAABB() * state.scale, state.origin, state.axis);
+            meshSurfProxy->id = staticMeshDbvt.CreateProxy(meshSurfProxy->worldAABB, MeterToUnit(0.0f), meshSurfProxy);
+        }
+    } else if (renderObject->meshSurfProxies) {
+        Mem_Free(renderObject->meshSurfProxies);
+        renderObject->meshSurfProxies = nullptr;
+        renderObject->numMeshSurfProxies = 0;
+    }
+
+    renderObject->hidden = false;
+
+    UpdateOccluderLink(renderObject);
+}
+
+// Links the render object to the occluder objects if it is a shown occluder, or unlinks it.
+void RenderWorld::UpdateOccluderLink(RenderObject *renderObject) {
+    if (renderObject->hidden || !(renderObject->state.flags & RenderObject::OccluderFlag)) {
+        UnlinkOccluder(renderObject);
+        return;
+    }
+
+    if (renderObject->occluderIndex < 0) {
+        renderObject->occluderIndex = occluderObjects.Append(renderObject);
+    }
+}
+
+void RenderWorld::UnlinkOccluder(RenderObject *renderObject) {
+    if (renderObject->occluderIndex < 0) {
+        return;
+    }
+
+    // Last occluder is moved to the removed index
+    occluderObjects.Last()->occluderIndex = renderObject->occluderIndex;
+    occluderObjects.RemoveIndexFast(renderObject->occluderIndex);
+    renderObject->occluderIndex = -1;
 }
 
 const RenderLight *RenderWorld::GetRenderLight(int handle) const {
@@ -275,6 +396,8 @@ void RenderWorld::FinishMapLoading() {
 }
 
 void RenderWorld::RenderScene(const RenderView *renderView) {
+    BE_PROFILE_SCOPE("RenderWorld::RenderScene");
+
     if (renderView->state.renderRect.w <= 0.0f || renderView->state.renderRect.h <= 0.0f) {
         return;
     }
@@ -285,7 +408,8 @@ void RenderWorld::RenderScene(const RenderView *renderView) {
 
     // Create current visible view in frame data
     currentView = (VisibleView *)frameData.ClearedAlloc(sizeof(*currentView));
-    currentView->def = renderView;
+    // Copy the view definition so that the back end doesn't depend on the caller's one
+    currentView->def = new (frameData.Alloc(sizeof(RenderView))) RenderView(*renderView);
     currentView->maxDrawSurfs = MaxViewDrawSurfs;
     currentView->drawSurfs = (DrawSurf **)frameData.Alloc(currentView->maxDrawSurfs * sizeof(DrawSurf *));
     currentView->instanceBufferCache = (BufferCache *)frameData.ClearedAlloc(sizeof(BufferCache));
@@ -315,9 +439,8 @@ void RenderWorld::EmitGuiFullScreen(GuiMesh &guiMesh) {
     renderViewDef.axis          = Mat3::identity;
     renderViewDef.origin        = Vec3::origin;
 
-    static RenderView renderView;
-    new (&renderView) RenderView();
-    renderView.Update(&renderViewDef);
+    RenderView *renderView = new (frameData.Alloc(sizeof(RenderView))) RenderView();
+    renderView->Update(&renderViewDef);
 
     // GUI object def
     RenderObject::State objectDef;
@@ -330,13 +453,12 @@ void RenderWorld::EmitGuiFullScreen(GuiMesh &guiMesh) {
     objectDef.materialParms[RenderObject::AlphaParm] = 1.0f;
     objectDef.materialParms[RenderObject::TimeScaleParm] = 1.0f;
     
-    static RenderObject renderObject;
-    new (&renderObject) RenderObject();
-    renderObject.Update(&objectDef);
+    RenderObject *renderObject = new (frameData.Alloc(sizeof(RenderObject))) RenderObject();
+    renderObject->Update(&objectDef);
 
     // GUI view
     VisibleView *guiView    = (VisibleView *)frameData.ClearedAlloc(sizeof(*guiView));
-    guiView->def            = &renderView;
+    guiView->def            = renderView;
     guiView->is2D           = true;
     guiView->maxDrawSurfs   = guiMesh.NumSurfaces();
     guiView->drawSurfs      = (DrawSurf **)frameData.Alloc(guiView->maxDrawSurfs * sizeof(DrawSurf *));
@@ -348,7 +470,7 @@ void RenderWorld::EmitGuiFullScreen(GuiMesh &guiMesh) {
     Mat4 projMatrix;
     projMatrix.SetOrtho(0, renderSystem.currentContext->GetDeviceWidth(), renderSystem.currentContext->GetDeviceHeight(), 0, -1.0, 1.0);
 
-    VisibleObject *visObject = RegisterVisibleObject(guiView, &renderObject);
+    VisibleObject *visObject = RegisterVisibleObject(guiView, renderObject);
     visObject->modelViewMatrix.SetIdentity();
     visObject->modelViewMatrix.Scale(renderSystem.currentContext->GetUpscaleFactorX(), renderSystem.currentContext->GetUpscaleFactorY(), 1.0f);
     visObject->modelViewProjMatrix = projMatrix * visObject->modelViewMatrix;
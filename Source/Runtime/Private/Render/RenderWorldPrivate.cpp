@@ -15,6 +15,7 @@
 #include "Precompiled.h"
 #include "Render/Render.h"
 #include "RenderInternal.h"
+#include "Core/JobSystem.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -36,6 +37,28 @@ VisibleObject *RenderWorld::RegisterVisibleObject(VisibleView *visView, RenderOb
 
     visObject->def = renderObject;
 
+    // Copy the states that the back end needs, it may run while the game thread updates the render object
+    const RenderObject::State &state = renderObject->state;
+    visObject->objectIndex = renderObject->index;
+    visObject->flags = state.flags;
+    visObject->layer = state.layer;
+    visObject->origin = state.origin;
+    visObject->scale = state.scale;
+    visObject->axis = state.axis;
+    if (state.mesh || state.joints) {
+        visObject->localAABB = renderObject->GetLocalAABB();
+    } else {
+        visObject->localAABB.Clear();
+    }
+    visObject->objectToWorldMatrix = renderObject->worldMatrix;
+    visObject->prevObjectToWorldMatrix = renderObject->prevWorldMatrix;
+    memcpy(visObject->materialParms, state.materialParms, sizeof(visObject->materialParms));
+    visObject->wireframeMode = state.wireframeMode;
+    visObject->wireframeColor = state.wireframeColor;
+    visObject->mesh = state.mesh;
+    visObject->skinned = state.joints != nullptr;
+    visObject->skinningJointCache = nullptr;
+
     // Connect visible object to render object for use in this view frame
     renderObject->visObject = visObject;
 
@@ -45,6 +68,17 @@ VisibleObject *RenderWorld::RegisterVisibleObject(VisibleView *visView, RenderOb
     return visObject;
 }
 
+// Updates the joint cache of the skinned mesh and hands a copy of it to the back end.
+void RenderWorld::UpdateSkinningJointCache(VisibleObject *visObject) {
+    const RenderObject::State &renderObjectDef = visObject->def->state;
+
+    renderObjectDef.mesh->UpdateSkinningJointCache(renderObjectDef.skeleton, renderObjectDef.joints);
+
+    if (renderObjectDef.mesh->skinningJointCache && !visObject->skinningJointCache) {
+        visObject->skinningJointCache = renderObjectDef.mesh->skinningJointCache->CopyToFrameData();
+    }
+}
+
 // Add visible light from render light.
 // Prevent to add multiple times in same view.
 VisibleLight *RenderWorld::RegisterVisibleLight(VisibleView *visView, RenderLight *renderLight) {
@@ -61,7 +95,8 @@ VisibleLight *RenderWorld::RegisterVisibleLight(VisibleView *visView, RenderLigh
 
     visLight->index = visView->numVisibleLights++;
 
-    visLight->def = renderLight;
+    // Copy the light so that the back end doesn't depend on the live one
+    visLight->def = new (frameData.Alloc(sizeof(RenderLight))) RenderLight(*renderLight);
 
     visLight->litSurfsAABB.Clear();
     visLight->shadowCasterAABB.Clear();
@@ -75,95 +110,155 @@ VisibleLight *RenderWorld::RegisterVisibleLight(VisibleView *visView, RenderLigh
     return visLight;
 }
 
+// Calls func(subtreeIndex, proxyId) for each proxy intersecting with the bounding volume.
+// Each subtree is queried in a separate job, so func should write only to the results of its own subtree.
+template <typename BV, typename Func>
+static void QuerySubtrees(const DynamicAABBTree &tree, const BV &boundingVolume, const int32_t *subtreeRoots, int numSubtrees, const Func &func) {
+    auto querySubtrees = [&tree, &boundingVolume, subtreeRoots, &func](int first, int last) {
+        for (int subtreeIndex = first; subtreeIndex < last; subtreeIndex++) {
+            auto callback = [&func, subtreeIndex](int32_t proxyId) -> bool {
+                func(subtreeIndex, proxyId);
+                return true;
+            };
+            tree.Query(boundingVolume, callback, subtreeRoots[subtreeIndex]);
+        }
+    };
+
+    if (numSubtrees > 1) {
+        jobSystem.ParallelFor(numSubtrees, 1, querySubtrees);
+    } else {
+        querySubtrees(0, numSubtrees);
+    }
+}
+
+// Same as above, but skips the subtrees of the nodes for which cullNode(aabb) returns true.
+template <typename Func, typename CullFunc>
+static void QuerySubtrees(const DynamicAABBTree &tree, const Frustum &frustum, const int32_t *subtreeRoots, int numSubtrees, const Func &func, const CullFunc &cullNode) {
+    auto querySubtrees = [&tree, &frustum, subtreeRoots, &func, &cullNode](int first, int last) {
+        for (int subtreeIndex = first; subtreeIndex < last; subtreeIndex++) {
+            auto callback = [&func, subtreeIndex](int32_t proxyId) -> bool {
+                func(subtreeIndex, proxyId);
+                return true;
+            };
+            tree.Query(frustum, callback, cullNode, subtreeRoots[subtreeIndex]);
+        }
+    };
+
+    if (numSubtrees > 1) {
+        jobSystem.ParallelFor(numSubtrees, 1, querySubtrees);
+    } else {
+        querySubtrees(0, numSubtrees);
+    }
+}
+
+// Split the tree into subtrees to query in parallel.
+int RenderWorld::GetVisibilitySubtrees(const DynamicAABBTree &tree, int32_t *subtreeRoots) const {
+    int maxSubtrees = 1;
+
+    if (r_parallelVisibility.GetBool() && jobSystem.IsInitialized() && jobSystem.NumThreads() > 1) {
+        // A few subtrees per thread to balance unevenly culled subtrees
+        maxSubtrees = Min(jobSystem.NumThreads() * 4, (int)MaxVisibilitySubtrees);
+    }
+
+    return tree.GetSubtreeRoots(maxSubtrees, subtreeRoots);
+}
+
 // Add visible lights/objects using view volume.
+// Tree traversal and culling are done per subtree in parallel, and then the results are registered
+// in subtree order so that the visible indices and the sort keys are the same as in a single threaded query.
 void RenderWorld::FindVisibleLightsAndObjects(VisibleView *visView) {
+    int32_t subtreeRoots[MaxVisibilitySubtrees];
+
     viewCount++;
 
     visView->worldAABB.Clear();
     visView->visLights.Clear();
     visView->visObjects.Clear();
 
+    // Occluders are rasterized first, so that the occluded objects and the subtrees of the occluded nodes are skipped while querying.
+    // 1/w depth of the occlusion buffer is constant in orthogonal projection.
+    const bool occlusionCulling = r_occlusionCulling.GetBool() && !visView->def->state.orthogonal && RasterizeOccluders(visView);
+
     // Called for each scene lights that intersects with visView frustum.
-    // Returns true if it want to proceed next query.
-    auto addVisibleLights = [this, visView](int32_t proxyId) -> bool {
-        DbvtProxy *proxy = (DbvtProxy *)lightDbvt.GetUserData(proxyId);
+    auto findVisibleLights = [this, visView](int subtreeIndex, int32_t proxyId) {
+        const DbvtProxy *proxy = (const DbvtProxy *)lightDbvt.GetUserData(proxyId);
         RenderLight *renderLight = proxy->renderLight;
 
         if (!renderLight) {
-            return true;
+            return;
         }
 
         // Skip if object layer is not visible with this visView
         if (!(BIT(renderLight->state.layer) & visView->def->state.layerMask)) {
-            return true;
+            return;
         }
 
         // Skip if a light is farther than maximum visible distance
         if (renderLight->state.origin.DistanceSqr(visView->def->state.origin) > renderLight->state.maxVisDist * renderLight->state.maxVisDist) {
-            return true;
+            return;
         }
 
         // Cull exact light bounding volume
         if (visView->def->state.orthogonal) {
             if (renderLight->Cull(visView->def->box)) {
-                return true;
+                return;
             }
         } else {
             if (renderLight->Cull(visView->def->frustum)) {
-                return true;
+                return;
             }
         }
 
         // Calculate light scissor rect
         Rect screenClipRect;
         if (!renderLight->ComputeScreenClipRect(visView->def, screenClipRect)) {
-            return true;
+            return;
         }
 
-        VisibleLight *visLight = RegisterVisibleLight(visView, renderLight);
-        visLight->scissorRect = screenClipRect;
-        // glScissor 의 x, y 좌표는 lower left corner 이므로 y 좌표를 밑에서 증가되도록 뒤집는다.
-        visLight->scissorRect.y = renderSystem.currentContext->GetRenderingHeight() - (screenClipRect.y + screenClipRect.h);
-
-        return true;
+        VisibleLightCandidate &candidate = visLightCandidates[subtreeIndex].Alloc();
+        candidate.renderLight = renderLight;
+        candidate.screenClipRect = screenClipRect;
     };
 
     // Called for each scene objects that intersects with visView frustum.
-    // Returns true if it want to proceed next query.
-    auto addVisibleObjects = [this, visView](int32_t proxyId) -> bool {
+    auto findVisibleObjects = [this, visView, occlusionCulling](int subtreeIndex, int32_t proxyId) {
         DbvtProxy *proxy = (DbvtProxy *)objectDbvt.GetUserData(proxyId);
-        RenderObject *renderObject = proxy->renderObject;
+        const RenderObject *renderObject = proxy->renderObject;
 
         if (!renderObject) {
-            return true;
+            return;
         }
 
         // Skip if object layer is not visible with this visView
         if (!(BIT(renderObject->state.layer) & visView->def->state.layerMask)) {
-            return true;
+            return;
         }
 
         // Skip first person visView only object in sub camera
         if ((renderObject->state.flags & RenderObject::FirstPersonOnlyFlag) && visView->isSubview) {
-            return true;
+            return;
         }
 
         // Skip 3rd person visView only object in sub camera
         if ((renderObject->state.flags & RenderObject::ThirdPersonOnlyFlag) && !visView->isSubview) {
-            return true;
+            return;
         }
 
         // Skip if a entity is farther than maximum visible distance
         if (renderObject->state.origin.DistanceSqr(visView->def->state.origin) > renderObject->state.maxVisDist * renderObject->state.maxVisDist) {
-            return true;
+            return;
         }
 
-        // Register visible object form the render object
-        VisibleObject *visObject = RegisterVisibleObject(visView, renderObject);
+        // Skip if hidden behind the occluders. Occluders are not tested against themselves.
+        if (occlusionCulling && !(renderObject->state.flags & RenderObject::OccluderFlag) &&
+            occlusionBuffer.IsOccluded(proxy->worldAABB, visView->def->viewProjMatrix)) {
+            return;
+        }
 
-        visObject->ambientVisible = true;
-        visObject->modelViewMatrix = visView->def->viewMatrix * renderObject->GetObjectToWorldMatrix();
-        visObject->modelViewProjMatrix = visView->def->viewProjMatrix * renderObject->GetObjectToWorldMatrix();
+        VisibleObjectCandidate &candidate = visObjectCandidates[subtreeIndex].Alloc();
+        candidate.proxy = proxy;
+        candidate.modelViewMatrix = visView->def->viewMatrix * renderObject->GetObjectToWorldMatrix();
+        candidate.modelViewProjMatrix = visView->def->viewProjMatrix * renderObject->GetObjectToWorldMatrix();
 
         if (renderObject->state.flags & RenderObject::BillboardFlag) {
             Mat3 inverse = (visView->def->viewMatrix.ToMat3() * renderObject->GetObjectToWorldMatrix().ToMat3()).Inverse();
@@ -172,48 +267,158 @@ void RenderWorld::FindVisibleLightsAndObjects(VisibleView *visView) {
             Swap(inverse[1], inverse[2]);
 
             Mat3 billboardMatrix = inverse * Mat3::FromScale(renderObject->state.scale);
-            visObject->modelViewMatrix *= billboardMatrix;
-            visObject->modelViewProjMatrix *= billboardMatrix;
+            candidate.modelViewMatrix *= billboardMatrix;
+            candidate.modelViewProjMatrix *= billboardMatrix;
         }
+    };
 
-        visView->worldAABB.AddAABB(proxy->worldAABB);
+    int numLightSubtrees = GetVisibilitySubtrees(lightDbvt, subtreeRoots);
+    for (int subtreeIndex = 0; subtreeIndex < numLightSubtrees; subtreeIndex++) {
+        visLightCandidates[subtreeIndex].SetCount(0, false);
+    }
 
-        if (r_showAABB.GetInteger() > 0) {
-            SetDebugColor(Color4::blue, Color4::zero);
-            DebugAABB(proxy->worldAABB, 1, true, r_showAABB.GetInteger() == 1 ? true : false);
+    if (visView->def->state.orthogonal) {
+        QuerySubtrees(lightDbvt, visView->def->box, subtreeRoots, numLightSubtrees, findVisibleLights);
+    } else {
+        QuerySubtrees(lightDbvt, visView->def->frustum, subtreeRoots, numLightSubtrees, findVisibleLights);
+    }
+
+    int numObjectSubtrees = GetVisibilitySubtrees(objectDbvt, subtreeRoots);
+    for (int subtreeIndex = 0; subtreeIndex < numObjectSubtrees; subtreeIndex++) {
+        visObjectCandidates[subtreeIndex].SetCount(0, false);
+    }
+
+    if (visView->def->state.orthogonal) {
+        QuerySubtrees(objectDbvt, visView->def->box, subtreeRoots, numObjectSubtrees, findVisibleObjects);
+    } else if (occlusionCulling) {
+        // Nodes enclose their occluders, so the subtrees of the occluders are never culled by themselves
+        auto isNodeOccluded = [this, visView](const AABB &aabb) -> bool {
+            return occlusionBuffer.IsOccluded(aabb, visView->def->viewProjMatrix);
+        };
+        QuerySubtrees(objectDbvt, visView->def->frustum, subtreeRoots, numObjectSubtrees, findVisibleObjects, isNodeOccluded);
+    } else {
+        QuerySubtrees(objectDbvt, visView->def->frustum, subtreeRoots, numObjectSubtrees, findVisibleObjects);
+    }
+
+    // Register visible lights in subtree order
+    for (int subtreeIndex = 0; subtreeIndex < numLightSubtrees; subtreeIndex++) {
+        const Array<VisibleLightCandidate> &candidates = visLightCandidates[subtreeIndex];
+
+        for (int i = 0; i < candidates.Count(); i++) {
+            const VisibleLightCandidate &candidate = candidates[i];
+
+            VisibleLight *visLight = RegisterVisibleLight(visView, candidate.renderLight);
+            visLight->scissorRect = candidate.screenClipRect;
+            // glScissor 의 x, y 좌표는 lower left corner 이므로 y 좌표를 밑에서 증가되도록 뒤집는다.
+            visLight->scissorRect.y = renderSystem.currentContext->GetRenderingHeight() - (candidate.screenClipRect.y + candidate.screenClipRect.h);
         }
+    }
+
+    // Register visible objects in subtree order
+    for (int subtreeIndex = 0; subtreeIndex < numObjectSubtrees; subtreeIndex++) {
+        const Array<VisibleObjectCandidate> &candidates = visObjectCandidates[subtreeIndex];
+
+        for (int i = 0; i < candidates.Count(); i++) {
+            const VisibleObjectCandidate &candidate = candidates[i];
+            const DbvtProxy *proxy = candidate.proxy;
+
+            // Register visible object form the render object
+            VisibleObject *visObject = RegisterVisibleObject(visView, proxy->renderObject);
 
-        if (visObject->def->state.numJoints > 0 && r_showSkeleton.GetInteger() > 0) {
-            DebugJoints(visObject->def, r_showSkeleton.GetInteger() == 2, visView->def->state.axis);
+            visObject->ambientVisible = true;
+            visObject->modelViewMatrix = candidate.modelViewMatrix;
+            visObject->modelViewProjMatrix = candidate.modelViewProjMatrix;
+
+            visView->worldAABB.AddAABB(proxy->worldAABB);
+
+            if (r_showAABB.GetInteger() > 0) {
+                SetDebugColor(Color4::blue, Color4::zero);
+                DebugAABB(proxy->worldAABB, 1, true, r_showAABB.GetInteger() == 1 ? true : false);
+            }
+
+            if (visObject->def->state.numJoints > 0 && r_showSkeleton.GetInteger() > 0) {
+                DebugJoints(visObject->def, r_showSkeleton.GetInteger() == 2, visView->def->state.axis);
+            }
         }
+    }
+}
 
-        return true;
-    };
+// Rasterize the occluder objects in the view into the software occlusion buffer.
+// Returns false if nothing is rasterized, so there is nothing to be occluded.
+bool RenderWorld::RasterizeOccluders(const VisibleView *visView) {
+    // Buffer size is rounded up to a multiple of the tile size
+    int width = (Max(r_occlusionBufferWidth.GetInteger(), 1) + OcclusionBuffer::TileWidth - 1) & ~(OcclusionBuffer::TileWidth - 1);
+    int height = (Max(r_occlusionBufferHeight.GetInteger(), 1) + OcclusionBuffer::TileHeight - 1) & ~(OcclusionBuffer::TileHeight - 1);
 
-    if (visView->def->state.orthogonal) {
-        lightDbvt.Query(visView->def->box, addVisibleLights);
-        objectDbvt.Query(visView->def->box, addVisibleObjects);
+    if (occlusionBuffer.GetWidth() != width || occlusionBuffer.GetHeight() != height) {
+        occlusionBuffer.Init(width, height);
     } else {
-        lightDbvt.Query(visView->def->frustum, addVisibleLights);
-        objectDbvt.Query(visView->def->frustum, addVisibleObjects);
+        occlusionBuffer.Clear();
     }
+
+    for (int i = 0; i < occluderObjects.Count(); i++) {
+        const RenderObject *renderObject = occluderObjects[i];
+        const RenderObject::State &renderObjectDef = renderObject->state;
+
+        // Same conditions as the visible objects, billboards are not occluders
+        if (!renderObjectDef.mesh || renderObjectDef.joints || (renderObjectDef.flags & RenderObject::BillboardFlag)) {
+            continue;
+        }
+
+        if (!(BIT(renderObjectDef.layer) & visView->def->state.layerMask)) {
+            continue;
+        }
+
+        if (((renderObjectDef.flags & RenderObject::FirstPersonOnlyFlag) && visView->isSubview) ||
+            ((renderObjectDef.flags & RenderObject::ThirdPersonOnlyFlag) && !visView->isSubview)) {
+            continue;
+        }
+
+        if (renderObjectDef.origin.DistanceSqr(visView->def->state.origin) > renderObjectDef.maxVisDist * renderObjectDef.maxVisDist) {
+            continue;
+        }
+
+        if (visView->def->frustum.CullAABB(renderObject->proxy->worldAABB)) {
+            continue;
+        }
+
+        const Mat4 modelViewProjMatrix = visView->def->viewProjMatrix * renderObject->GetObjectToWorldMatrix();
+
+        for (int surfaceIndex = 0; surfaceIndex < renderObjectDef.mesh->NumSurfaces(); surfaceIndex++) {
+            const SubMesh *subMesh = renderObjectDef.mesh->GetSurface(surfaceIndex)->subMesh;
+
+            occlusionBuffer.AddOccluder(modelViewProjMatrix, &subMesh->Verts()->xyz, sizeof(VertexGenericLit), 
+                subMesh->NumVerts(), subMesh->Indexes(), subMesh->NumIndexes());
+        }
+    }
+
+    if (occlusionBuffer.NumTriangles() == 0) {
+        return false;
+    }
+
+    bool parallel = r_parallelVisibility.GetBool() && jobSystem.IsInitialized() && jobSystem.NumThreads() > 1;
+
+    occlusionBuffer.Rasterize(parallel);
+
+    return true;
 }
 
 // Add drawSurf for visible static meshes.
 void RenderWorld::AddStaticMeshes(VisibleView *visView) {
+    int32_t subtreeRoots[MaxVisibilitySubtrees];
+
     // Called for each static mesh surfaces intersecting with visView frustum 
-    // Returns true if it want to proceed next query
-    auto addStaticMeshSurfs = [this, visView](int32_t proxyId) -> bool {
-        DbvtProxy *proxy = (DbvtProxy *)staticMeshDbvt.GetUserData(proxyId);
-        MeshSurf *surf = proxy->mesh->GetSurface(proxy->meshSurfIndex);
+    auto findStaticMeshSurfs = [this](int subtreeIndex, int32_t proxyId) {
+        const DbvtProxy *proxy = (const DbvtProxy *)staticMeshDbvt.GetUserData(proxyId);
+        const MeshSurf *surf = proxy->mesh->GetSurface(proxy->meshSurfIndex);
 
         // surf 가 없다면 static mesh 가 아님
         if (!surf) {
-            return true;
+            return;
         }
 
         if (proxy->renderObject->viewCount != this->viewCount) {
-            return true;
+            return;
         }
 
         /*if (proxy->lodGroup >= 0) {
@@ -229,36 +434,48 @@ void RenderWorld::AddStaticMeshes(VisibleView *visView) {
         // More accurate OBB culling
         OBB obb = OBB(proxy->renderObject->GetAABB(), proxy->renderObject->state.origin, proxy->renderObject->state.axis);
         if (visView->def->frustum.CullOBB(obb)) {
-            return true;
+            return;
         }
 #endif
 
-        int flags = DrawSurf::AmbientVisible;
-        if (proxy->renderObject->state.wireframeMode != RenderObject::WireframeMode::ShowNone || r_showWireframe.GetInteger() > 0) {
-            flags |= DrawSurf::ShowWires;
-        }
+        staticMeshCandidates[subtreeIndex].Append(proxyId);
+    };
 
-        VisibleObject *visObject = proxy->renderObject->visObject;
-        AddDrawSurf(visView, nullptr, visObject, visObject->def->state.materials[surf->materialIndex], surf->subMesh, flags);
+    int numSubtrees = GetVisibilitySubtrees(staticMeshDbvt, subtreeRoots);
+    for (int subtreeIndex = 0; subtreeIndex < numSubtrees; subtreeIndex++) {
+        staticMeshCandidates[subtreeIndex].SetCount(0, false);
+    }
 
-        visView->numAmbientSurfs++;
+    if (visView->def->state.orthogonal) {
+        QuerySubtrees(staticMeshDbvt, visView->def->box, subtreeRoots, numSubtrees, findStaticMeshSurfs);
+    } else {
+        QuerySubtrees(staticMeshDbvt, visView->def->frustum, subtreeRoots, numSubtrees, findStaticMeshSurfs);
+    }
 
-        surf->viewCount = this->viewCount;
-        surf->drawSurf = visView->drawSurfs[visView->numDrawSurfs - 1];
+    // Add drawSurfs in subtree order
+    for (int subtreeIndex = 0; subtreeIndex < numSubtrees; subtreeIndex++) {
+        const Array<int32_t> &candidates = staticMeshCandidates[subtreeIndex];
 
-        if (r_showAABB.GetInteger() > 0) {
-            SetDebugColor(Color4(1, 1, 1, 0.5), Color4::zero);
-            DebugAABB(proxy->worldAABB, 1, true, r_showAABB.GetInteger() == 1 ? true : false);
-        }
+        for (int i = 0; i < candidates.Count(); i++) {
+            const DbvtProxy *proxy = (const DbvtProxy *)staticMeshDbvt.GetUserData(candidates[i]);
+            MeshSurf *surf = proxy->mesh->GetSurface(proxy->meshSurfIndex);
 
-        return true;
-    };
+            int flags = DrawSurf::AmbientVisible;
+            if (proxy->renderObject->state.wireframeMode != RenderObject::WireframeMode::ShowNone || r_showWireframe.GetInteger() > 0) {
+                flags |= DrawSurf::ShowWires;
+            }
 
-    if (visView->def->state.orthogonal) {
-        staticMeshDbvt.Query(visView->def->box, addStaticMeshSurfs);
-    } else {
-        staticMeshDbvt.Query(visView->def->frustum, addStaticMeshSurfs);
+            VisibleObject *visObject = proxy->renderObject->visObject;
+            RequestAmbientSurf(visObject, visObject->def->state.materials[surf->materialIndex], surf, flags);
+
+            if (r_showAABB.GetInteger() > 0) {
+                SetDebugColor(Color4(1, 1, 1, 0.5), Color4::zero);
+                DebugAABB(proxy->worldAABB, 1, true, r_showAABB.GetInteger() == 1 ? true : false);
+            }
+        }
     }
+
+    AddAmbientSurfs(visView);
 }
 
 // Add drawSurf for visible skinned meshes.
@@ -289,20 +506,17 @@ void RenderWorld::AddSkinnedMeshes(VisibleView *visView) {
 
         if (renderObjectDef.skeleton && renderObjectDef.joints) {
             // Update skinning joint cache for GPU skinning
-            renderObjectDef.mesh->UpdateSkinningJointCache(renderObjectDef.skeleton, renderObjectDef.joints);
+            UpdateSkinningJointCache(visObject);
         }
 
         for (int surfaceIndex = 0; surfaceIndex < renderObjectDef.mesh->NumSurfaces(); surfaceIndex++) {
             MeshSurf *surf = renderObjectDef.mesh->GetSurface(surfaceIndex);
 
-            AddDrawSurf(visView, nullptr, visObject, renderObjectDef.materials[surf->materialIndex], surf->subMesh, flags);
-
-            visView->numAmbientSurfs++;
-
-            surf->viewCount = viewCount;
-            surf->drawSurf = visView->drawSurfs[visView->numDrawSurfs - 1];
+            RequestAmbientSurf(visObject, renderObjectDef.materials[surf->materialIndex], surf, flags);
         }
     }
+
+    AddAmbientSurfs(visView);
 }
 
 // Add drawSurf for visible particle meshes.
@@ -418,21 +632,20 @@ void RenderWorld::AddSkyBoxMeshes(VisibleView *visView) {
     renderObjectDef.axis = Mat3::identity;
     renderObjectDef.materialParms[RenderObject::TimeScaleParm] = 1.0f;
 
-    static RenderObject renderObject;
-    new (&renderObject) RenderObject();
-    renderObject.Update(&renderObjectDef);
+    RenderObject *renderObject = new (frameData.Alloc(sizeof(RenderObject))) RenderObject();
+    renderObject->Update(&renderObjectDef);
 
     // Add skybox object
-    VisibleObject *visObject = RegisterVisibleObject(visView, &renderObject);
+    VisibleObject *visObject = RegisterVisibleObject(visView, renderObject);
 
     if (visView->def->state.orthogonal) {
         Mat4 projMatrix;
         R_SetPerspectiveProjectionMatrix(45, 45, 0.01, 1000, false, projMatrix);
-        visObject->modelViewMatrix = visView->def->viewMatrix * renderObject.GetObjectToWorldMatrix();
+        visObject->modelViewMatrix = visView->def->viewMatrix * renderObject->GetObjectToWorldMatrix();
         visObject->modelViewProjMatrix = projMatrix * visObject->modelViewMatrix;
     } else {
-        visObject->modelViewMatrix = visView->def->viewMatrix * renderObject.GetObjectToWorldMatrix();
-        visObject->modelViewProjMatrix = visView->def->viewProjMatrix * renderObject.GetObjectToWorldMatrix();
+        visObject->modelViewMatrix = visView->def->viewMatrix * renderObject->GetObjectToWorldMatrix();
+        visObject->modelViewProjMatrix = visView->def->viewProjMatrix * renderObject->GetObjectToWorldMatrix();
     }
 
     MeshSurf *meshSurf = meshManager.defaultBoxMesh->GetSurface(0);
@@ -523,6 +736,11 @@ void RenderWorld::AddStaticMeshesForLights(VisibleView *visView) {
             continue;
         }
 
+        // Lit surfaces are added in AddMeshesForClusteredLights()
+        if (visLight->clustered) {
+            continue;
+        }
+
         switch (renderLight->state.type) {
         case RenderLight::DirectionalLight:
             staticMeshDbvt.Query(renderLight->worldOBB, addStaticMeshSurfsForLights);
@@ -610,7 +828,7 @@ void RenderWorld::AddSkinnedMeshesForLights(VisibleView *visView) {
                 }
 
                 if (shadowCasterObject->def->state.skeleton && shadowCasterObject->def->state.joints) {
-                    shadowCasterObject->def->state.mesh->UpdateSkinningJointCache(shadowCasterObject->def->state.skeleton, shadowCasterObject->def->state.joints);
+                    UpdateSkinningJointCache(shadowCasterObject);
                 }
 
                 AddDrawSurf(visView, visLight, shadowCasterObject, material, surf->subMesh, DrawSurf::ShadowCaster);
@@ -633,6 +851,11 @@ void RenderWorld::AddSkinnedMeshesForLights(VisibleView *visView) {
             continue;
         }
 
+        // Lit surfaces are added in AddMeshesForClusteredLights()
+        if (visLight->clustered) {
+            continue;
+        }
+
         switch (renderLight->state.type) {
         case RenderLight::DirectionalLight:
             objectDbvt.Query(renderLight->worldOBB, addShadowCasterObjects);
@@ -653,6 +876,139 @@ void RenderWorld::AddSkinnedMeshesForLights(VisibleView *visView) {
     }
 }
 
+// Bin visible lights which don't cast shadows into the light cluster grid of the view.
+// Shadow casters outside of the view frustum can't be found from the clusters,
+// so shadow casting lights are still handled by querying each light volume.
+void RenderWorld::AssignLightsToClusters(VisibleView *visView) {
+    clusteredLights.SetCount(0, false);
+    clusteredLightVolumes.SetCount(0, false);
+
+    if (!r_clusteredLighting.GetBool() || visView->def->state.orthogonal) {
+        return;
+    }
+
+    for (VisibleLight *visLight = visView->visLights.Next(); visLight; visLight = visLight->node.Next()) {
+        const RenderLight *renderLight = visLight->def;
+
+        if (renderLight->state.flags & RenderLight::CastShadowsFlag) {
+            continue;
+        }
+
+        if (clusteredLights.Count() >= LightClusterGrid::MaxLights) {
+            break;
+        }
+
+        if (renderLight->state.type == RenderLight::PointLight) {
+            clusteredLightVolumes.Append(LightClusterGrid::LightVolume::FromSphere(renderLight->GetOrigin(), renderLight->GetMajorRadius()));
+        } else if (renderLight->state.type == RenderLight::SpotLight) {
+            // Bounding cone of the light frustum
+            const Frustum &frustum = renderLight->GetWorldFrustum();
+            float farDistance = frustum.GetFarDistance();
+            float halfAngle = Math::ATan(Math::Sqrt(frustum.GetLeft() * frustum.GetLeft() + frustum.GetUp() * frustum.GetUp()), farDistance);
+
+            clusteredLightVolumes.Append(LightClusterGrid::LightVolume::FromCone(renderLight->GetOrigin(), frustum.GetAxis()[0], farDistance, halfAngle));
+        } else {
+            continue;
+        }
+
+        visLight->clustered = true;
+        clusteredLights.Append(visLight);
+    }
+
+    if (clusteredLights.Count() == 0) {
+        return;
+    }
+
+    int numTilesX = Max(r_lightClusterTilesX.GetInteger(), 1);
+    int numTilesY = Max(r_lightClusterTilesY.GetInteger(), 1);
+    int numSlices = Max(r_lightClusterSlices.GetInteger(), 1);
+
+    if (lightClusterGrid.NumTilesX() != numTilesX || lightClusterGrid.NumTilesY() != numTilesY || lightClusterGrid.NumSlices() != numSlices) {
+        lightClusterGrid.Init(numTilesX, numTilesY, numSlices);
+    }
+
+    const RenderView *viewDef = visView->def;
+
+    lightClusterGrid.SetView(viewDef->state.origin, viewDef->state.axis, 
+        Math::Tan(DEG2RAD(viewDef->state.fovX) * 0.5f), Math::Tan(DEG2RAD(viewDef->state.fovY) * 0.5f), viewDef->zNear, viewDef->zFar);
+
+    bool parallel = r_parallelVisibility.GetBool() && jobSystem.IsInitialized() && jobSystem.NumThreads() > 1;
+
+    lightClusterGrid.Build(clusteredLightVolumes.Ptr(), clusteredLightVolumes.Count(), parallel);
+}
+
+// Add lit drawSurfs for visible surfaces by looking up lights in the clusters which each surface overlaps.
+void RenderWorld::AddMeshesForClusteredLights(VisibleView *visView) {
+    if (clusteredLights.Count() == 0) {
+        return;
+    }
+
+    for (VisibleObject *visObject = visView->visObjects.Next(); visObject; visObject = visObject->node.Next()) {
+        if (!visObject->ambientVisible) {
+            continue;
+        }
+
+        const RenderObject *renderObject = visObject->def;
+        const RenderObject::State &renderObjectDef = renderObject->state;
+
+        if (!renderObjectDef.mesh) {
+            continue;
+        }
+
+        if (renderObjectDef.joints) {
+            // Skinned mesh surfaces share the bounds of the object
+            const AABB &worldAABB = renderObject->proxy->worldAABB;
+
+            lightClusterGrid.FindLights(worldAABB, clusterLightIndexes);
+            if (clusterLightIndexes.Count() == 0) {
+                continue;
+            }
+
+            for (int surfaceIndex = 0; surfaceIndex < renderObjectDef.mesh->NumSurfaces(); surfaceIndex++) {
+                const MeshSurf *surf = renderObjectDef.mesh->GetSurface(surfaceIndex);
+
+                if (surf->viewCount == viewCount) {
+                    AddClusteredLitSurf(visView, worldAABB, surf->drawSurf);
+                }
+            }
+        } else {
+            for (int surfaceIndex = 0; surfaceIndex < renderObject->numMeshSurfProxies; surfaceIndex++) {
+                const DbvtProxy *proxy = &renderObject->meshSurfProxies[surfaceIndex];
+                const MeshSurf *surf = proxy->mesh->GetSurface(proxy->meshSurfIndex);
+
+                if (!surf || surf->viewCount != viewCount) {
+                    continue;
+                }
+
+                lightClusterGrid.FindLights(proxy->worldAABB, clusterLightIndexes);
+
+                AddClusteredLitSurf(visView, proxy->worldAABB, surf->drawSurf);
+            }
+        }
+    }
+}
+
+// Add lit drawSurfs from the ambient drawSurf for each clustered light found in clusterLightIndexes.
+void RenderWorld::AddClusteredLitSurf(VisibleView *visView, const AABB &surfAABB, const DrawSurf *ambientDrawSurf) {
+    if (!(ambientDrawSurf->flags & DrawSurf::AmbientVisible) || !ambientDrawSurf->material->IsLitSurface()) {
+        return;
+    }
+
+    for (int i = 0; i < clusterLightIndexes.Count(); i++) {
+        VisibleLight *visLight = clusteredLights[clusterLightIndexes[i]];
+
+        // Clusters are conservative, so test exact light bounding volume
+        if (!visLight->def->IsIntersectAABB(surfAABB)) {
+            continue;
+        }
+
+        AddDrawSurfFromAmbient(visView, visLight, false, ambientDrawSurf);
+
+        visLight->numDrawSurfs++;
+        visLight->litSurfsAABB.AddAABB(surfAABB);
+    }
+}
+
 void RenderWorld::CacheInstanceBuffer(VisibleView *visView) {
     int numInstances = 0;
 
@@ -814,10 +1170,15 @@ void RenderWorld::RenderCamera(VisibleView *visView) {
         }
     }*/
     
+    // Bin lights without shadows into the light cluster grid
+    AssignLightsToClusters(visView);
+
     AddStaticMeshesForLights(visView);
 
     AddSkinnedMeshesForLights(visView);
 
+    AddMeshesForClusteredLights(visView);
+
     OptimizeLights(visView);
 
     if (renderGlobal.instancingMethod != Mesh::NoInstancing) {
@@ -832,12 +1193,45 @@ void RenderWorld::RenderCamera(VisibleView *visView) {
 void RenderWorld::RenderSubCamera(VisibleObject *visObject, const DrawSurf *drawSurf, const Material *material) {
 }
 
-void RenderWorld::AddDrawSurf(VisibleView *visView, VisibleLight *visLight, VisibleObject *visObject, const Material *material, SubMesh *subMesh, int flags) {
-    if (visView->numDrawSurfs + 1 > visView->maxDrawSurfs) {
-        BE_WARNLOG(L"RenderWorld::AddDrawSurf: not enough renderable surfaces\n");
-        return;
+// Reports the projected size of the object to the textures of the material, so that the texture streamer can choose the mips to keep resident.
+static void ReportTextureScreenSize(const VisibleView *visView, const VisibleObject *visObject, const Material *material) {
+    const RenderView::State &viewState = visView->def->state;
+    const OBB &worldOBB = visObject->def->GetWorldOBB();
+
+    float radius = worldOBB.Extents().Length();
+    float screenSize;
+
+    if (viewState.orthogonal) {
+        screenSize = radius * viewState.renderRect.h / viewState.sizeY;
+    } else {
+        float distance = viewState.origin.Distance(worldOBB.Center());
+        if (distance > radius) {
+            screenSize = radius * viewState.renderRect.h / (distance * Math::Tan(DEG2RAD(viewState.fovY * 0.5f)));
+        } else {
+            screenSize = (float)Max(viewState.renderRect.w, viewState.renderRect.h);
+        }
+    }
+
+    const Material::ShaderPass *pass = material->GetPass();
+
+    // Tiled textures need more texels
+    screenSize *= Max(Math::Fabs(pass->tcScale.x), Math::Fabs(pass->tcScale.y));
+
+    if (pass->texture) {
+        pass->texture->ReportScreenSize(screenSize);
     }
 
+    for (int i = 0; i < pass->shaderProperties.Count(); i++) {
+        const Texture *texture = pass->shaderProperties.GetByIndex(i)->second.texture;
+        if (texture) {
+            texture->ReportScreenSize(screenSize);
+        }
+    }
+}
+
+// Resolves the material to draw with and caches the geometry of the sub mesh.
+// Buffer cache allocations are not thread safe, so this is called before the drawSurfs are generated in parallel.
+const Material *RenderWorld::CacheDrawSurfSubMesh(const VisibleObject *visObject, const Material *material, SubMesh *subMesh) {
     const Material *actualMaterial = material;
     if (!actualMaterial) {
         actualMaterial = materialManager.defaultMaterial;
@@ -847,13 +1241,6 @@ void RenderWorld::AddDrawSurf(VisibleView *visView, VisibleLight *visLight, Visi
     //  actualMaterial = (visObject->def->state.customSkin)->RemapMaterialBySkin(material);
     //}
 
-    /*float *outputValues = (float *)frameData.Alloc(actualMaterial->GetExprChunk()->NumRegisters() * sizeof(float));
-    float localParms[MAX_EXPR_LOCALPARMS];
-    localParms[0] = visView->def->state.time * 0.001f;
-    memcpy(&localParms[1], visObject->def->state.materialParms, sizeof(visObject->def->state.materialParms));
-
-    actualMaterial->GetExprChunk()->Evaluate(localParms, outputValues);*/
-
     if (!bufferCacheManager.IsCached(subMesh->vertexCache)) {
         if (subMesh->GetType() == Mesh::ReferenceMesh ||
             subMesh->GetType() == Mesh::StaticMesh ||
@@ -864,6 +1251,84 @@ void RenderWorld::AddDrawSurf(VisibleView *visView, VisibleLight *visLight, Visi
         }
     }
 
+    return actualMaterial;
+}
+
+void RenderWorld::AddDrawSurf(VisibleView *visView, VisibleLight *visLight, VisibleObject *visObject, const Material *material, SubMesh *subMesh, int flags) {
+    if (visView->numDrawSurfs + 1 > visView->maxDrawSurfs) {
+        BE_WARNLOG(L"RenderWorld::AddDrawSurf: not enough renderable surfaces\n");
+        return;
+    }
+
+    const Material *actualMaterial = CacheDrawSurfSubMesh(visObject, material, subMesh);
+
+    visView->drawSurfs[visView->numDrawSurfs++] = AllocDrawSurf(visView, visLight, visObject, actualMaterial, subMesh, flags);
+}
+
+// Minimum number of ambient drawSurfs to generate in parallel
+static const int MinParallelDrawSurfs = 1024;
+
+// Queues an ambient drawSurf to be generated by AddAmbientSurfs().
+void RenderWorld::RequestAmbientSurf(VisibleObject *visObject, const Material *material, MeshSurf *surf, int flags) {
+    AmbientSurfRequest &request = ambientSurfRequests.Alloc();
+    request.visObject = visObject;
+    request.material = CacheDrawSurfSubMesh(visObject, material, surf->subMesh);
+    request.surf = surf;
+    request.flags = flags;
+    request.drawSurf = nullptr;
+}
+
+// Generates the requested ambient drawSurfs in parallel, and then registers them in request order
+// so that the drawSurfs are the same as the ones added one by one.
+void RenderWorld::AddAmbientSurfs(VisibleView *visView) {
+    int numRequests = ambientSurfRequests.Count();
+
+    if (visView->numDrawSurfs + numRequests > visView->maxDrawSurfs) {
+        BE_WARNLOG(L"RenderWorld::AddAmbientSurfs: not enough renderable surfaces\n");
+        numRequests = visView->maxDrawSurfs - visView->numDrawSurfs;
+    }
+
+    auto allocDrawSurfs = [this, visView](int first, int last) {
+        for (int i = first; i < last; i++) {
+            AmbientSurfRequest &request = ambientSurfRequests[i];
+            request.drawSurf = AllocDrawSurf(visView, nullptr, request.visObject, request.material, request.surf->subMesh, request.flags);
+        }
+    };
+
+    // Each job writes only to its own range of the requests
+    if (numRequests >= MinParallelDrawSurfs && r_parallelVisibility.GetBool() && jobSystem.IsInitialized() && jobSystem.NumThreads() > 1) {
+        jobSystem.ParallelFor(numRequests, MinParallelDrawSurfs / 4, allocDrawSurfs);
+    } else {
+        allocDrawSurfs(0, numRequests);
+    }
+
+    for (int i = 0; i < numRequests; i++) {
+        const AmbientSurfRequest &request = ambientSurfRequests[i];
+
+        visView->drawSurfs[visView->numDrawSurfs++] = request.drawSurf;
+        visView->numAmbientSurfs++;
+
+        request.surf->viewCount = viewCount;
+        request.surf->drawSurf = request.drawSurf;
+    }
+
+    ambientSurfRequests.SetCount(0, false);
+}
+
+// Returns a new drawSurf with its sort key. The geometry of the sub mesh should be cached by CacheDrawSurfSubMesh().
+// This is thread safe, frame data is allocated from the memory block of the calling thread.
+DrawSurf *RenderWorld::AllocDrawSurf(const VisibleView *visView, const VisibleLight *visLight, VisibleObject *visObject, const Material *actualMaterial, SubMesh *subMesh, int flags) const {
+    if ((flags & DrawSurf::AmbientVisible) && !visView->is2D && TextureManager::texture_streaming.GetBool()) {
+        ReportTextureScreenSize(visView, visObject, actualMaterial);
+    }
+
+    /*float *outputValues = (float *)frameData.Alloc(actualMaterial->GetExprChunk()->NumRegisters() * sizeof(float));
+    float localParms[MAX_EXPR_LOCALPARMS];
+    localParms[0] = visView->def->state.time * 0.001f;
+    memcpy(&localParms[1], visObject->def->state.materialParms, sizeof(visObject->def->state.materialParms));
+
+    actualMaterial->GetExprChunk()->Evaluate(localParms, outputValues);*/
+
     if (renderGlobal.instancingMethod != Mesh::NoInstancing) {
         if (actualMaterial->GetPass()->instancingEnabled) {
             if (subMesh->IsGpuSkinning()) {
@@ -922,7 +1387,7 @@ void RenderWorld::AddDrawSurf(VisibleView *visView, VisibleLight *visLight, Visi
         drawSurf->sortKey = ((visLightIndex << 52) | (materialSort << 48) | (subMeshIndex << 32) | (materialIndex << 16) | visObjectIndex);
     }
 
-    visView->drawSurfs[visView->numDrawSurfs++] = drawSurf;
+    return drawSurf;
 }
 
 void RenderWorld::AddDrawSurfFromAmbient(VisibleView *visView, const VisibleLight *visLight, bool isShadowCaster, const DrawSurf *ambientDrawSurf) {
@@ -942,37 +1407,63 @@ void RenderWorld::AddDrawSurfFromAmbient(VisibleView *visView, const VisibleLigh
     visView->drawSurfs[visView->numDrawSurfs++] = drawSurf;
 }
 
-static int BE_CDECL _CompareDrawSurf(const void *elem1, const void *elem2) {
-    const uint64_t sortKey1 = (*(DrawSurf **)elem1)->sortKey;
-    const uint64_t sortKey2 = (*(DrawSurf **)elem2)->sortKey;
-
-    if (sortKey1 < sortKey2) {
-        return -1;
+// Sorts drawSurfs in increasing order of sort key with DrawSurfSorter.
+// firstDrawSurf of each visible light is found while gathering the sorted drawSurfs.
+void RenderWorld::SortDrawSurfs(VisibleView *visView) {
+    const int numDrawSurfs = visView->numDrawSurfs;
+    if (numDrawSurfs == 0) {
+        return;
     }
-    if (sortKey1 > sortKey2) {
-        return 1;
+
+    DrawSurf **drawSurfs = visView->drawSurfs;
+
+    unsortedDrawSurfs.SetCount(numDrawSurfs, false);
+    DrawSurf **unsorted = unsortedDrawSurfs.Ptr();
+
+    DrawSurfSorter::SortKey *keys = drawSurfSorter.SetKeys(numDrawSurfs);
+    for (int i = 0; i < numDrawSurfs; i++) {
+        keys[i].sortKey = drawSurfs[i]->sortKey;
+        keys[i].index = i;
+        unsorted[i] = drawSurfs[i];
     }
-    return 0;
-}
 
-void RenderWorld::SortDrawSurfs(VisibleView *visView) {
-    qsort(visView->drawSurfs, visView->numDrawSurfs, sizeof(DrawSurf *), _CompareDrawSurf);
+    const DrawSurfSorter::SortKey *sortedKeys = drawSurfSorter.Sort();
 
-    VisibleLight *visLight = visView->visLights.Next();
+    // Table to find visible light by light index in the sort key
+    int numLights = 0;
+    for (VisibleLight *visLight = visView->visLights.Next(); visLight; visLight = visLight->node.Next()) {
+        numLights = Max(numLights, visLight->index + 1);
+    }
+    drawSurfSortLights.SetCount(numLights, false);
+    VisibleLight **lights = drawSurfSortLights.Ptr();
+    for (int i = 0; i < numLights; i++) {
+        lights[i] = nullptr;
+    }
+    for (VisibleLight *visLight = visView->visLights.Next(); visLight; visLight = visLight->node.Next()) {
+        lights[visLight->index] = visLight;
+    }
 
-    for (int i = 0; i < visView->numDrawSurfs; i++) {
-        if (!visLight) {
-            break;
-        }
-        
-        int lightIndex = (visView->drawSurfs[i]->sortKey & 0xFFF0000000000000) >> 52;
+    // Gather sorted drawSurfs and mark the first drawSurf of each light
+    auto gatherDrawSurfs = [=](int first, int last) {
+        for (int i = first; i < last; i++) {
+            drawSurfs[i] = unsorted[sortedKeys[i].index];
 
-        if (lightIndex - 1 == visLight->index) {
-            visLight->firstDrawSurf = i;
-            assert(i + visLight->numDrawSurfs <= visView->numDrawSurfs);
+            const int lightIndex = (int)((sortedKeys[i].sortKey & 0xFFF0000000000000) >> 52);
 
-            visLight = visLight->node.Next();
+            if (lightIndex > 0 && (i == 0 || lightIndex != (int)((sortedKeys[i - 1].sortKey & 0xFFF0000000000000) >> 52))) {
+                if (lightIndex - 1 < numLights && lights[lightIndex - 1]) {
+                    VisibleLight *visLight = lights[lightIndex - 1];
+                    visLight->firstDrawSurf = i;
+                    assert(i + visLight->numDrawSurfs <= numDrawSurfs);
+                }
+            }
         }
+    };
+
+    if (numDrawSurfs >= DrawSurfSorter::MinParallelKeys && jobSystem.IsInitialized() && jobSystem.NumThreads() > 1) {
+        jobSystem.ParallelFor(numDrawSurfs, DrawSurfSorter::MinParallelKeys / 4, gatherDrawSurfs);
+    } else {
+        gatherDrawSurfs(0, numDrawSurfs);
     }
 }
 
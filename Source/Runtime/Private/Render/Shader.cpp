@@ -19,6 +19,7 @@
 #include "File/FileSystem.h"
 #include "Asset/Asset.h"
 #include "Asset/GuidMapper.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -1622,6 +1623,8 @@ void Shader::SetTexture(int unit, const Texture *texture) const {
         return;
     }
 
+    texture->MarkUsed();
+
     rhi.SetTexture(unit, texture->textureHandle);
 }
 
@@ -1632,6 +1635,8 @@ void Shader::SetTexture(const char *name, const Texture *texture) const {
         return;
     }
 
+    texture->MarkUsed();
+
     rhi.SetTexture(unit, texture->textureHandle);
 }
 
@@ -1651,11 +1656,15 @@ void Shader::SetTextureArray(const char *name, int num, const Texture **textures
             return;
         }
 
+        textures[i]->MarkUsed();
+
         rhi.SetTexture(unit, textures[i]->textureHandle);
     }
 }
 
 bool Shader::Load(const char *hashName) {
+    BE_PROFILE_SCOPE("Shader::Load");
+
     Str filename = hashName;
     filename.DefaultFileExtension(".shader");
 
@@ -20,6 +20,7 @@
 #include "Core/Heap.h"
 #include "Simd/Simd.h"
 #include "File/FileSystem.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -97,6 +98,9 @@ void Skeleton::CreateDefaultSkeleton() {
 }
 
 bool Skeleton::Load(const char *filename) {
+    BE_PROFILE_SCOPE("Skeleton::Load");
+    MemTagScope memTagScope(MemTag::Anim);
+
     Purge();
 
     Str bSkelFilename = filename;
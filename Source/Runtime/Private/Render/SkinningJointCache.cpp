@@ -69,6 +69,21 @@ void SkinningJointCache::Update(const Skeleton *skeleton, const Mat3x4 *jointMat
     }
 }
 
+const SkinningJointCache *SkinningJointCache::CopyToFrameData() const {
+    SkinningJointCache *cache = (SkinningJointCache *)frameData.Alloc(sizeof(SkinningJointCache));
+    memcpy(cache, this, sizeof(SkinningJointCache));
+
+    // Joint matrices are read by the back end only for vertex shader skinning, VTF skinning reads them from the buffer cache
+    if (renderGlobal.skinningMethod == SkinningJointCache::VertexShaderSkinning) {
+        cache->skinningJoints = (Mat3x4 *)frameData.Alloc(sizeof(Mat3x4) * numJoints);
+        memcpy(cache->skinningJoints, skinningJoints, sizeof(Mat3x4) * numJoints);
+    } else {
+        cache->skinningJoints = nullptr;
+    }
+
+    return cache;
+}
+
 bool SkinningJointCache::CapableGPUJointSkinning(SkinningMethod skinningMethod, int numJoints) {
     assert(numJoints > 0 && numJoints < 256);
 
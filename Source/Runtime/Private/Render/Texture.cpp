@@ -15,6 +15,8 @@
 #include "Precompiled.h"
 #include "Render/Render.h"
 #include "RenderInternal.h"
+#include "Core/Profiler.h"
+#include "File/FileSystem.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -574,6 +576,16 @@ void Texture::Upload(const Image *srcImage) {
 
     rhi.SetTextureImage(type, srcImage, dstFormat, hasMipmaps, useSRGB);
 
+    if (gpuMemSize > 0) {
+        Mem_RemoveExternal(MemTag::Texture, gpuMemSize);
+    }
+    gpuMemSize = MemRequired(hasMipmaps) * Max(numSlices, 1);
+    Mem_AddExternal(MemTag::Texture, gpuMemSize);
+
+    SetSamplerState();
+}
+
+void Texture::SetSamplerState() {
     rhi.SetTextureAddressMode(addressMode);
 
     if (hasMipmaps) {
@@ -587,6 +599,74 @@ void Texture::Upload(const Image *srcImage) {
     }
 }
 
+// Queues the resident mip chain of the streamed texture to the back end as a render command,
+// so the front end never waits for the render thread here.
+void Texture::UploadStreamedMips(const Image &mips) {
+    bool useNormalMap   = (flags & Flag::NormalMap) ? true : false;
+    bool useCompression = !(flags & Flag::NoCompression) ? TextureManager::texture_useCompression.GetBool() : false;
+    bool useSRGB        = ((flags & Flag::SRGBColorSpace) && TextureManager::texture_sRGB.GetBool()) ? true : false;
+
+    Image::Format dstFormat;
+    rhi.AdjustTextureFormat(RHI::Texture2D, useCompression, useNormalMap, mips.GetFormat(), &dstFormat);
+
+    // Size of the full image is kept, so the streaming is transparent to the users of the texture.
+    // Image properties are read by the back end, so they are changed with the texture handle in CreateStreamedMips().
+    int fullWidth = streamedTexture->GetWidth();
+    int fullHeight = streamedTexture->GetHeight();
+
+    if (gpuMemSize > 0) {
+        Mem_RemoveExternal(MemTag::Texture, gpuMemSize);
+    }
+    gpuMemSize = Image::MemRequired(mips.GetWidth(), mips.GetHeight(), 1, mips.NumMipmaps(), dstFormat);
+    Mem_AddExternal(MemTag::Texture, gpuMemSize);
+
+    // Upload queued in this frame is superseded
+    CancelQueuedUpload();
+
+    queuedUpload = renderSystem.CmdUploadTexture(this, mips, dstFormat, useSRGB, fullWidth, fullHeight);
+    queuedUploadFrame = frameData.GetFrameCount();
+
+    if (!queuedUpload) {
+        // Command buffer is full
+        renderSystem.SyncRenderThread();
+        CreateStreamedMips(mips, dstFormat, useSRGB, fullWidth, fullHeight);
+    }
+}
+
+// Immutable texture storage can't grow, so the handle is recreated every time the resident mips change.
+// The old handle is destroyed after the new one is made, in order with the draws of the back end.
+void Texture::CreateStreamedMips(const Image &mips, Image::Format dstFormat, bool useSRGB, int fullWidth, int fullHeight) {
+    RHI::Handle oldTextureHandle = textureHandle;
+
+    this->type          = RHI::Texture2D;
+    this->srcDepth      = 1;
+    this->numSlices     = 1;
+    this->format        = dstFormat;
+    this->width         = fullWidth;
+    this->height        = fullHeight;
+    this->depth         = 1;
+    this->hasMipmaps    = true;
+
+    textureHandle = rhi.CreateTexture(RHI::Texture2D);
+
+    rhi.BindTexture(textureHandle);
+    rhi.SetTextureImage(RHI::Texture2D, &mips, dstFormat, true, useSRGB);
+
+    SetSamplerState();
+
+    if (oldTextureHandle != RHI::NullTexture) {
+        rhi.DestroyTexture(oldTextureHandle);
+    }
+}
+
+// Cancels the upload of the streamed mips if it is not issued to the back end yet.
+void Texture::CancelQueuedUpload() {
+    if (queuedUpload && queuedUploadFrame == frameData.GetFrameCount()) {
+        queuedUpload->texture = nullptr;
+    }
+    queuedUpload = nullptr;
+}
+
 void Texture::Update2D(int xoffset, int yoffset, int width, int height, Image::Format format, const byte *data) {
     rhi.SetTextureSubImage2D(0, xoffset, yoffset, width, height, format, data);	
 }
@@ -624,12 +704,21 @@ void Texture::Purge() {
         rhi.DestroyTexture(textureHandle);
     }
 
+    if (gpuMemSize > 0) {
+        Mem_RemoveExternal(MemTag::Texture, gpuMemSize);
+        gpuMemSize = 0;
+    }
+
     textureHandle = RHI::NullTexture;
 }
 
 bool Texture::Load(const char *filename, int flags) {
+    BE_PROFILE_SCOPE("Texture::Load");
+
     flags |= LoadedFromFile;
 
+    StopStreaming();
+
     if (flags & (CubeMap | CameraCubeMap)) {
         Str name = filename;
         name.StripFileExtension();
@@ -651,6 +740,18 @@ bool Texture::Load(const char *filename, int flags) {
         cubeImage.CreateCubeFrom6Faces(images);
         Create(RHI::TextureCubeMap, cubeImage, flags);
     } else {
+        if (StartStreaming(filename, flags)) {
+            return true;
+        }
+
+        TextureCache::Key cacheKey;
+        bool useCache = TextureManager::texture_cache.GetBool() && textureManager.ComputeCacheKey(filename, flags, cacheKey);
+
+        if (useCache && LoadCooked(cacheKey, flags)) {
+            BE_LOG(L"Loaded cooked texture '%hs'\n", filename);
+            return true;
+        }
+
         BE_LOG(L"Loading texture '%hs'...\n", filename);
 
         Image image;
@@ -671,12 +772,139 @@ bool Texture::Load(const char *filename, int flags) {
             textureType = RHI::Texture2D;
         }
 
+        if (useCache && textureType == RHI::Texture2D && image.NumSlices() == 1 && Cook(cacheKey, image, flags)) {
+            return true;
+        }
+
         Create(textureType, image, flags);
     }
 
     return true;
 }
 
+void Texture::GetCookParms(const Image &srcImage, int flags, TextureCookParms &parms) {
+    bool useNormalMap   = (flags & Flag::NormalMap) ? true : false;
+    bool useCompression = !(flags & Flag::NoCompression) ? TextureManager::texture_useCompression.GetBool() : false;
+
+    rhi.AdjustTextureFormat(RHI::Texture2D, useCompression, useNormalMap, srcImage.GetFormat(), &parms.format);
+
+    // XGBR_DXT5 can't be encoded by Image, it is swizzled and compressed by the RHI at upload
+    if (parms.format == Image::XGBR_DXT5) {
+        parms.format = Image::RGBA_8_8_8_8;
+    }
+
+    GetCookSize(srcImage.GetWidth(), srcImage.GetHeight(), flags, parms.width, parms.height);
+
+    parms.useMipmaps = !(flags & (Flag::NoMipmaps | Flag::NonPowerOfTwo));
+}
+
+void Texture::GetCookSize(int srcWidth, int srcHeight, int flags, int &width, int &height) {
+    bool useNPOT        = (flags & Flag::NonPowerOfTwo) ? true : false;
+
+    int depth;
+    rhi.AdjustTextureSize(RHI::Texture2D, useNPOT, srcWidth, srcHeight, 1, &width, &height, &depth);
+
+    // Apply scale down mip level
+    int mipLevel = !(flags & Flag::NoScaleDown) ? TextureManager::texture_mipLevel.GetInteger() : 0;
+    if (mipLevel > 0) {
+        width = Max(width >> mipLevel, 1);
+        height = Max(height >> mipLevel, 1);
+    }
+}
+
+bool Texture::LoadCooked(const TextureCache::Key &key, int flags) {
+    CookedTexture cookedTexture;
+    if (!textureManager.textureCache.Load(key, cookedTexture)) {
+        return false;
+    }
+
+    // Texels are uploaded straight from the mapping
+    CreateCooked(cookedTexture.GetImage(), cookedTexture.GetSrcWidth(), cookedTexture.GetSrcHeight(), flags);
+    return true;
+}
+
+bool Texture::Cook(const TextureCache::Key &key, const Image &srcImage, int flags) {
+    TextureCookParms parms;
+    GetCookParms(srcImage, flags, parms);
+
+    Image cookedImage;
+    if (!TextureCache::CookImage(srcImage, parms, cookedImage)) {
+        return false;
+    }
+
+    textureManager.textureCache.Store(key, cookedImage, srcImage.GetWidth(), srcImage.GetHeight());
+
+    CreateCooked(cookedImage, srcImage.GetWidth(), srcImage.GetHeight(), flags);
+    return true;
+}
+
+void Texture::CreateCooked(const Image &cookedImage, int srcWidth, int srcHeight, int flags) {
+    // The cooked image is scaled down already, so texture_mipLevel must not be applied again
+    Create(RHI::Texture2D, cookedImage, flags | NoScaleDown);
+
+    this->flags = (this->flags & ~NoScaleDown) | (flags & NoScaleDown);
+    this->srcWidth = srcWidth;
+    this->srcHeight = srcHeight;
+}
+
+// Creates a placeholder and starts streaming the mips of the image in the background.
+// Returns false if the texture can't be streamed.
+bool Texture::StartStreaming(const char *filename, int flags) {
+    if (!TextureManager::texture_streaming.GetBool()) {
+        return false;
+    }
+
+    if (flags & (NoMipmaps | NonPowerOfTwo | Nearest | Shadow | ZeroClamp | Permanence)) {
+        return false;
+    }
+
+    // Size is reported from the start, textures are sized by the users before the first decode
+    int imageWidth, imageHeight;
+    if (!Image::LoadDimensions(filename, &imageWidth, &imageHeight)) {
+        return false;
+    }
+
+    BE_LOG(L"Streaming texture '%hs'...\n", filename);
+
+    // Neutral placeholder until the mip tail is decoded
+    Image image;
+    image.Create2D(4, 4, 1, Image::RGBA_8_8_8_8, nullptr, (flags & NormalMap) ? Image::LinearSpaceFlag : 0);
+    byte *dst = image.GetPixels();
+
+    for (int i = 0; i < 4 * 4; i++) {
+        if (flags & NormalMap) {
+            dst[4 * i + 0] = 127;
+            dst[4 * i + 1] = 127;
+            dst[4 * i + 2] = 255;
+        } else {
+            dst[4 * i + 0] = 128;
+            dst[4 * i + 1] = 128;
+            dst[4 * i + 2] = 128;
+        }
+        dst[4 * i + 3] = 255;
+    }
+
+    Create(RHI::Texture2D, image, flags);
+
+    this->srcWidth = imageWidth;
+    this->srcHeight = imageHeight;
+    GetCookSize(imageWidth, imageHeight, flags, this->width, this->height);
+
+    streamedTexture = textureManager.textureStreamer.Register(filename, this);
+    return true;
+}
+
+void Texture::StopStreaming() {
+    if (streamedTexture) {
+        // Texture may be deleted or reloaded before the back end runs the uploads
+        CancelQueuedUpload();
+        renderSystem.SyncRenderThread();
+
+        textureManager.textureStreamer.Unregister(streamedTexture);
+        streamedTexture = nullptr;
+    }
+}
+
 bool Texture::Reload() {
     if (!(flags & LoadedFromFile)) {
         return false;
@@ -0,0 +1,269 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "Precompiled.h"
+#include "Render/TextureCache.h"
+#include "Render/TextureStreamer.h"
+#include "Core/Checksum_MD5.h"
+#include "Core/Profiler.h"
+#include "File/FileSystem.h"
+#include "Platform/PlatformFile.h"
+#include <atomic>
+
+BE_NAMESPACE_BEGIN
+
+// Header of .btex files. The mip chain follows at dataOffset.
+// The cache is local to the machine, so the header is stored in the system byte order.
+struct CookedTextureHeader {
+    uint32_t                magic;
+    uint32_t                version;
+    uint32_t                format;                 // Image::Format
+    uint32_t                flags;                  // Image::Flag
+    uint32_t                width;
+    uint32_t                height;
+    uint32_t                numMipmaps;
+    uint32_t                srcWidth;
+    uint32_t                srcHeight;
+    uint32_t                dataOffset;
+    uint32_t                dataSize;
+};
+
+static const uint32_t       cookedTextureMagic = ('X' << 24) | ('E' << 16) | ('T' << 8) | 'B';
+// Bump this when the cooking changes, to invalidate all entries
+static const uint32_t       cookedTextureVersion = 1;
+static const uint32_t       cookedTextureDataAlignment = 16;
+// Mip chain of the largest texture in 16 bytes per pixel format fits in int size
+static const uint32_t       cookedTextureMaxSize = 8192;
+
+static std::atomic<uint32_t> tempFileCounter(0);
+
+Str TextureCache::Key::ToString() const {
+    static const char hexDigits[] = "0123456789abcdef";
+    char str[sizeof(digest) * 2 + 1];
+
+    for (size_t i = 0; i < sizeof(digest); i++) {
+        str[i * 2 + 0] = hexDigits[digest[i] >> 4];
+        str[i * 2 + 1] = hexDigits[digest[i] & 15];
+    }
+    str[sizeof(digest) * 2] = '\0';
+
+    return Str(str);
+}
+
+CookedTexture::CookedTexture() {
+    srcWidth = 0;
+    srcHeight = 0;
+}
+
+void CookedTexture::Close() {
+    image.Clear();
+    mapping.Close();
+    srcWidth = 0;
+    srcHeight = 0;
+}
+
+TextureCache::TextureCache() {
+}
+
+void TextureCache::Init(const char *cacheDir) {
+    this->cacheDir = cacheDir;
+
+    if (!PlatformFile::DirectoryExists(cacheDir)) {
+        PlatformFile::CreateDirectoryTree(cacheDir);
+    }
+}
+
+void TextureCache::Shutdown() {
+    cacheDir.Clear();
+}
+
+bool TextureCache::ComputeKey(const char *filename, const char *target, Key &key) {
+    BE_PROFILE_SCOPE("TextureCache::ComputeKey");
+
+    const byte *data;
+    size_t size = fileSystem.MapFile(filename, true, (const void **)&data);
+    if (!data) {
+        return false;
+    }
+
+    MD5_CTX ctx;
+    MD5_Init(&ctx);
+    MD5_Update(&ctx, (const unsigned char *)&cookedTextureVersion, sizeof(cookedTextureVersion));
+    MD5_Update(&ctx, (const unsigned char *)target, strlen(target) + 1);
+    MD5_Update(&ctx, data, size);
+    MD5_Final(&ctx, key.digest);
+
+    fileSystem.UnmapFile(data);
+    return true;
+}
+
+Str TextureCache::EntryFilename(const Key &key) const {
+    Str filename = cacheDir;
+    filename.AppendPath(key.ToString());
+    filename.SetFileExtension(".btex");
+    return filename;
+}
+
+bool TextureCache::Contains(const Key &key) const {
+    return PlatformFile::FileExists(EntryFilename(key));
+}
+
+bool TextureCache::Load(const Key &key, CookedTexture &cookedTexture) const {
+    BE_PROFILE_SCOPE("TextureCache::Load");
+
+    cookedTexture.Close();
+
+    Str filename = EntryFilename(key);
+    if (!PlatformFile::FileExists(filename)) {
+        return false;
+    }
+
+    if (!cookedTexture.mapping.Open(fileSystem.ToAbsolutePath(filename))) {
+        return false;
+    }
+
+    const byte *base = (const byte *)cookedTexture.mapping.GetData();
+    size_t size = cookedTexture.mapping.GetSize();
+
+    CookedTextureHeader header;
+    if (size < sizeof(header)) {
+        BE_WARNLOG(L"TextureCache::Load: invalid entry '%hs'\n", filename.c_str());
+        cookedTexture.Close();
+        return false;
+    }
+    memcpy(&header, base, sizeof(header));
+
+    if (header.magic != cookedTextureMagic || header.version != cookedTextureVersion ||
+        header.format == Image::UnknownFormat || header.format >= Image::NumImageFormats ||
+        header.width == 0 || header.width > cookedTextureMaxSize || header.height == 0 || header.height > cookedTextureMaxSize ||
+        header.numMipmaps == 0 || (int)header.numMipmaps > Image::MaxMipMapLevels(header.width, header.height, 1) ||
+        header.dataOffset < sizeof(header) || (size_t)header.dataOffset + header.dataSize > size ||
+        header.dataSize != (uint32_t)Image::MemRequired(header.width, header.height, 1, header.numMipmaps, (Image::Format)header.format)) {
+        BE_WARNLOG(L"TextureCache::Load: invalid entry '%hs'\n", filename.c_str());
+        cookedTexture.Close();
+        return false;
+    }
+
+    cookedTexture.image.InitFromMemory(header.width, header.height, 1, 1, header.numMipmaps, (Image::Format)header.format,
+        (byte *)base + header.dataOffset, header.flags);
+    cookedTexture.srcWidth = header.srcWidth;
+    cookedTexture.srcHeight = header.srcHeight;
+    return true;
+}
+
+bool TextureCache::Store(const Key &key, const Image &cookedImage, int srcWidth, int srcHeight) const {
+    BE_PROFILE_SCOPE("TextureCache::Store");
+
+    if (cookedImage.IsEmpty() || cookedImage.GetDepth() > 1 || cookedImage.NumSlices() > 1 ||
+        cookedImage.GetWidth() > (int)cookedTextureMaxSize || cookedImage.GetHeight() > (int)cookedTextureMaxSize) {
+        return false;
+    }
+
+    CookedTextureHeader header;
+    header.magic        = cookedTextureMagic;
+    header.version      = cookedTextureVersion;
+    header.format       = cookedImage.GetFormat();
+    header.flags        = cookedImage.GetFlags();
+    header.width        = cookedImage.GetWidth();
+    header.height       = cookedImage.GetHeight();
+    header.numMipmaps   = cookedImage.NumMipmaps();
+    header.srcWidth     = srcWidth;
+    header.srcHeight    = srcHeight;
+    header.dataOffset   = (sizeof(header) + cookedTextureDataAlignment - 1) & ~(cookedTextureDataAlignment - 1);
+    header.dataSize     = cookedImage.GetSize(0, cookedImage.NumMipmaps());
+
+    Str filename = EntryFilename(key);
+
+    // Written to a temporary file first, so that a partially written entry is never mapped
+    char tempFilename[MaxAbsolutePath];
+    Str::snPrintf(tempFilename, sizeof(tempFilename), "%s.%u.tmp", filename.c_str(), tempFileCounter.fetch_add(1, std::memory_order_relaxed));
+
+    PlatformBaseFile *file = PlatformFile::OpenFileWrite(tempFilename);
+    if (!file) {
+        BE_WARNLOG(L"TextureCache::Store: couldn't write '%hs'\n", tempFilename);
+        return false;
+    }
+
+    static const byte padding[cookedTextureDataAlignment] = { 0 };
+
+    bool written = file->Write(&header, sizeof(header)) &&
+        file->Write(padding, header.dataOffset - sizeof(header)) &&
+        file->Write(cookedImage.GetPixels(), header.dataSize);
+    delete file;
+
+    if (!written || !PlatformFile::MoveFile(tempFilename, filename)) {
+        PlatformFile::RemoveFile(tempFilename);
+        // Another thread may have stored the same entry
+        return Contains(key);
+    }
+
+    return true;
+}
+
+void TextureCache::Clear() const {
+    Array<FileInfo> files;
+    PlatformFile::ListFiles(cacheDir, "*.btex", false, false, files);
+
+    for (int i = 0; i < files.Count(); i++) {
+        Str filename = cacheDir;
+        filename.AppendPath(files[i].relativePath);
+        PlatformFile::RemoveFile(filename);
+    }
+}
+
+bool TextureCache::CookImage(const Image &srcImage, const TextureCookParms &parms, Image &cookedImage) {
+    BE_PROFILE_SCOPE("TextureCache::CookImage");
+
+    if (srcImage.IsEmpty() || srcImage.GetDepth() > 1 || srcImage.NumSlices() > 1) {
+        return false;
+    }
+
+    if (parms.useMipmaps) {
+        return TextureStreamer::PrepareMips(srcImage, parms.width, parms.height, parms.format, cookedImage);
+    }
+
+    const Image *image = &srcImage;
+    Image rgba8888Image;
+    Image scaledImage;
+
+    if (image->GetWidth() != parms.width || image->GetHeight() != parms.height) {
+        if (image->IsCompressed() || image->IsPacked()) {
+            if (!image->ConvertFormat(Image::RGBA_8_8_8_8, rgba8888Image)) {
+                return false;
+            }
+            image = &rgba8888Image;
+        }
+
+        if (!image->Resize(parms.width, parms.height, Image::Bicubic, scaledImage)) {
+            return false;
+        }
+        image = &scaledImage;
+    }
+
+    // Only mip 0 is kept
+    Image mip0Image;
+    if (image->NumMipmaps() > 1) {
+        mip0Image.Create(image->GetWidth(), image->GetHeight(), 1, 1, 1, image->GetFormat(), image->GetPixels(), image->GetFlags());
+        image = &mip0Image;
+    }
+
+    if (image->GetFormat() == parms.format) {
+        cookedImage = *image;
+        return true;
+    }
+    return image->ConvertFormat(parms.format, cookedImage);
+}
+
+BE_NAMESPACE_END
@@ -17,6 +17,8 @@
 #include "RenderInternal.h"
 #include "Core/Cmds.h"
 #include "File/FileSystem.h"
+#include "Platform/PlatformProcess.h"
+#include "Platform/PlatformTime.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -41,14 +43,118 @@ CVar TextureManager::texture_sRGB(L"texture_sRGB", L"1", CVar::Archive | CVar::B
 CVar TextureManager::texture_useCompression(L"texture_useCompression", L"1", CVar::Archive | CVar::Bool, L"");
 CVar TextureManager::texture_useNormalCompression(L"texture_useNormalCompression", L"1", CVar::Bool | CVar::Archive, L"normal map compression");
 CVar TextureManager::texture_mipLevel(L"texture_mipLevel", L"0", CVar::Archive | CVar::Integer, L"");
+CVar TextureManager::texture_streaming(L"texture_streaming", L"1", CVar::Archive | CVar::Bool, L"streams mipmaps of textures in the background");
+CVar TextureManager::texture_streamingUploadBudget(L"texture_streamingUploadBudget", L"4096", CVar::Archive | CVar::Integer, L"texture streaming upload budget per frame in KB");
+CVar TextureManager::texture_streamingMemoryBudget(L"texture_streamingMemoryBudget", L"256", CVar::Archive | CVar::Integer, L"texture streaming memory budget in MB");
+CVar TextureManager::texture_streamingTailSize(L"texture_streamingTailSize", L"64", CVar::Archive | CVar::Integer, L"mipmaps no larger than this size are always resident");
+CVar TextureManager::texture_streamingMaxRequests(L"texture_streamingMaxRequests", L"4", CVar::Integer, L"maximum number of textures decoded at the same time");
+CVar TextureManager::texture_streamingMipBias(L"texture_streamingMipBias", L"0", CVar::Archive | CVar::Float, L"bias of the streamed mipmap level");
+CVar TextureManager::texture_cache(L"texture_cache", L"1", CVar::Archive | CVar::Bool, L"loads cooked textures from the texture cache");
+
+static const char *textureCacheDir = "Cache/Textures";
+
+// Connects the texture streamer to the textures
+class TextureStreamingBackend : public TextureStreamerBackend {
+public:
+    virtual void            AdjustImage(const StreamedTexture *streamedTexture, const Image &srcImage, int &width, int &height, Image::Format &format) const override;
+    virtual bool            LoadCookedMips(const StreamedTexture *streamedTexture, int firstMip, int &width, int &height, Image::Format &format, Image &mips) const override;
+    virtual void            StoreCookedMips(const StreamedTexture *streamedTexture, const Image &srcImage, const Image &mips) const override;
+    virtual void            UploadMips(StreamedTexture *streamedTexture, const Image &mips) override;
+};
+
+static TextureStreamingBackend textureStreamingBackend;
+
+void TextureStreamingBackend::AdjustImage(const StreamedTexture *streamedTexture, const Image &srcImage, int &width, int &height, Image::Format &format) const {
+    const Texture *texture = (const Texture *)streamedTexture->GetUserData();
+
+    // Streamed textures are prepared like cooked textures
+    TextureCookParms parms;
+    Texture::GetCookParms(srcImage, texture->flags, parms);
+
+    width = parms.width;
+    height = parms.height;
+    format = parms.format;
+}
+
+bool TextureStreamingBackend::LoadCookedMips(const StreamedTexture *streamedTexture, int firstMip, int &width, int &height, Image::Format &format, Image &mips) const {
+    const Texture *texture = (const Texture *)streamedTexture->GetUserData();
+
+    TextureCache::Key key;
+    if (!TextureManager::texture_cache.GetBool() || !textureManager.ComputeCacheKey(streamedTexture->GetFilename(), texture->flags, key)) {
+        return false;
+    }
+
+    CookedTexture cookedTexture;
+    if (!textureManager.textureCache.Load(key, cookedTexture)) {
+        return false;
+    }
+
+    const Image &cookedImage = cookedTexture.GetImage();
+    const int numMips = cookedImage.NumMipmaps();
+    if (numMips != Image::MaxMipMapLevels(cookedImage.GetWidth(), cookedImage.GetHeight(), 1)) {
+        return false;
+    }
+
+    width = cookedImage.GetWidth();
+    height = cookedImage.GetHeight();
+    format = cookedImage.GetFormat();
+
+    // The mips outlive the cooked texture, so only the requested ones are copied out of the mapping
+    TextureStreamer::CopyMipChain(cookedImage, Min(firstMip, numMips - 1), mips);
+    return true;
+}
+
+void TextureStreamingBackend::StoreCookedMips(const StreamedTexture *streamedTexture, const Image &srcImage, const Image &mips) const {
+    const Texture *texture = (const Texture *)streamedTexture->GetUserData();
+
+    TextureCache::Key key;
+    if (!TextureManager::texture_cache.GetBool() || !textureManager.ComputeCacheKey(streamedTexture->GetFilename(), texture->flags, key)) {
+        return;
+    }
+
+    textureManager.textureCache.Store(key, mips, srcImage.GetWidth(), srcImage.GetHeight());
+}
+
+void TextureStreamingBackend::UploadMips(StreamedTexture *streamedTexture, const Image &mips) {
+    Texture *texture = (Texture *)streamedTexture->GetUserData();
+
+    if (!streamedTexture->IsStreamable()) {
+        // Cube maps, 3D and array images are made resident as a whole once after the first decode.
+        // The texture type changes, so the render thread must not be using the texture.
+        renderSystem.SyncRenderThread();
+
+        RHI::TextureType type;
+        if (mips.GetDepth() > 1) {
+            type = RHI::Texture3D;
+        } else if (mips.IsCubeMap()) {
+            type = RHI::TextureCubeMap;
+        } else {
+            type = RHI::Texture2DArray;
+        }
+
+        texture->Purge();
+        texture->type = type;
+        texture->textureHandle = rhi.CreateTexture(type);
+        texture->Upload(&mips);
+        return;
+    }
+
+    texture->UploadStreamedMips(mips);
+}
 
 void TextureManager::Init() {
     cmdSystem.AddCommand(L"listTextures", Cmd_ListTextures);
     cmdSystem.AddCommand(L"reloadTexture", Cmd_ReloadTexture);
     cmdSystem.AddCommand(L"convertNormalAR2RGB", Cmd_ConvertNormalAR2RGB);
+    cmdSystem.AddCommand(L"cookTextures", Cmd_CookTextures);
+    cmdSystem.AddCommand(L"clearTextureCache", Cmd_ClearTextureCache);
 
     textureHashMap.Init(1024, 1024, 1024);
 
+    textureCache.Init(textureCacheDir);
+
+    textureStreamer.Init(&textureStreamingBackend);
+
     // Set texture filtering mode
     SetFilter(WStr::ToStr(texture_filter.GetString()));//"LinearMipmapNearest");
 
@@ -63,8 +169,14 @@ void TextureManager::Shutdown() {
     cmdSystem.RemoveCommand(L"listTextures");
     cmdSystem.RemoveCommand(L"reloadTexture");
     cmdSystem.RemoveCommand(L"convertNormalAR2RGB");
+    cmdSystem.RemoveCommand(L"cookTextures");
+    cmdSystem.RemoveCommand(L"clearTextureCache");
 
     textureHashMap.DeleteContents(true);
+
+    textureStreamer.Shutdown();
+
+    textureCache.Shutdown();
 }
 
 void TextureManager::CreateEngineTextures() {
@@ -216,6 +328,127 @@ void TextureManager::SetLodBias(float lodBias) const {
     SelectTextureUnit(0);*/
 }
 
+void TextureManager::UpdateStreaming() {
+    textureStreamer.SetUploadBudget((size_t)Max(texture_streamingUploadBudget.GetInteger(), 1) * 1024);
+    textureStreamer.SetMemoryBudget((size_t)Max(texture_streamingMemoryBudget.GetInteger(), 1) * 1024 * 1024);
+    textureStreamer.SetTailSize(texture_streamingTailSize.GetInteger());
+    textureStreamer.SetMaxRequests(texture_streamingMaxRequests.GetInteger());
+    textureStreamer.SetMipBias(texture_streamingMipBias.GetFloat());
+
+    textureStreamer.Update();
+}
+
+bool TextureManager::ComputeCacheKey(const char *filename, int flags, TextureCache::Key &key) const {
+    // Only the flags which change the cooked image
+    flags &= (Texture::NoMipmaps | Texture::NoScaleDown | Texture::NoCompression | Texture::NonPowerOfTwo | Texture::NormalMap);
+
+    bool useNormalMap   = (flags & Texture::NormalMap) ? true : false;
+    bool useCompression = !(flags & Texture::NoCompression) ? texture_useCompression.GetBool() : false;
+    bool useNPOT        = (flags & Texture::NonPowerOfTwo) ? true : false;
+    int mipLevel        = !(flags & Texture::NoScaleDown) ? texture_mipLevel.GetInteger() : 0;
+
+    // What the RHI makes of the common formats and sizes stands for the target platform
+    Image::Format rgbFormat, rgbaFormat;
+    rhi.AdjustTextureFormat(RHI::Texture2D, useCompression, useNormalMap, Image::RGB_8_8_8, &rgbFormat);
+    rhi.AdjustTextureFormat(RHI::Texture2D, useCompression, useNormalMap, Image::RGBA_8_8_8_8, &rgbaFormat);
+
+    int npotWidth, npotHeight, npotDepth;
+    rhi.AdjustTextureSize(RHI::Texture2D, useNPOT, 3, 3, 1, &npotWidth, &npotHeight, &npotDepth);
+
+    char target[256];
+    Str::snPrintf(target, sizeof(target), "%s flags=%x mipLevel=%i compression=%i formats=%s,%s npot=%i",
+        PlatformProcess::PlatformName(), flags, mipLevel, useCompression ? 1 : 0, Image::FormatName(rgbFormat), Image::FormatName(rgbaFormat), npotWidth);
+
+    return TextureCache::ComputeKey(filename, target, key);
+}
+
+int TextureManager::CookTextures(const char *dirname, bool recursive) {
+    static const char *imageExtensions[] = { ".tga", ".png", ".jpg", ".bmp", ".pcx", ".hdr", ".dds", ".pvr" };
+
+    struct CookEntry {
+        Str                 filename;
+        int                 flags;
+        TextureCache::Key   key;
+        bool                cooked;
+    };
+
+    FileArray fileArray;
+    int numFiles = fileSystem.ListFiles(dirname, "*", fileArray, true, false, false, recursive);
+
+    Array<CookEntry> entries;
+    int numCached = 0;
+
+    for (int i = 0; i < numFiles; i++) {
+        Str filename = dirname;
+        filename.AppendPath(fileArray.GetFilename(i));
+
+        bool isImage = false;
+        for (int j = 0; j < COUNT_OF(imageExtensions); j++) {
+            if (filename.CheckExtension(imageExtensions[j])) {
+                isImage = true;
+                break;
+            }
+        }
+        if (!isImage) {
+            continue;
+        }
+
+        int flags = LoadTextureInfo(filename + ".texinfo");
+        if (flags & (Texture::CubeMap | Texture::CameraCubeMap)) {
+            continue;
+        }
+
+        CookEntry entry;
+        entry.filename = filename;
+        entry.flags = flags;
+        entry.cooked = false;
+
+        if (!ComputeCacheKey(filename, flags, entry.key)) {
+            continue;
+        }
+
+        if (textureCache.Contains(entry.key)) {
+            numCached++;
+            continue;
+        }
+
+        entries.Append(entry);
+    }
+
+    BE_LOG(L"cooking %i textures (%i already cooked)...\n", entries.Count(), numCached);
+
+    // Decoding, resizing, mipmapping and compression of each texture run on the job threads
+    jobSystem.ParallelFor(entries.Count(), 1, [this, &entries](int first, int last) {
+        for (int i = first; i < last; i++) {
+            CookEntry &entry = entries[i];
+
+            Image image;
+            if (!image.Load(entry.filename) || image.GetDepth() > 1 || image.NumSlices() > 1) {
+                continue;
+            }
+
+            TextureCookParms parms;
+            Texture::GetCookParms(image, entry.flags, parms);
+
+            Image cookedImage;
+            if (TextureCache::CookImage(image, parms, cookedImage)) {
+                entry.cooked = textureCache.Store(entry.key, cookedImage, image.GetWidth(), image.GetHeight());
+            }
+        }
+    });
+
+    int numCooked = 0;
+    for (int i = 0; i < entries.Count(); i++) {
+        if (entries[i].cooked) {
+            numCooked++;
+        } else {
+            BE_WARNLOG(L"Couldn't cook texture '%hs'\n", entries[i].filename.c_str());
+        }
+    }
+
+    return numCooked;
+}
+
 Texture *TextureManager::AllocTexture(const char *hashName) {
     if (textureHashMap.Get(hashName)) {
         BE_FATALERROR(L"%hs texture already allocated", hashName);
@@ -447,6 +680,10 @@ void TextureManager::Cmd_ListTextures(const CmdArgs &args) {
 
     BE_LOG(L"total %hs (including mipmaps)\n", Str::FormatBytes(totalBytes).c_str());
     BE_LOG(L"total %i textures\n", count);
+
+    const TextureStreamer::Stats &stats = textureManager.textureStreamer.GetStats();
+    BE_LOG(L"streaming %i textures, %hs resident, %hs prepared, %i decodes in flight\n",
+        stats.numTextures, Str::FormatBytes((int)stats.residentSize).c_str(), Str::FormatBytes((int)stats.preparedSize).c_str(), stats.numRequests);
 }
 
 void TextureManager::Cmd_ReloadTexture(const CmdArgs &args) {
@@ -523,4 +760,24 @@ void TextureManager::Cmd_ConvertNormalAR2RGB(const CmdArgs &args) {
     BE_LOG(L"all done\n");
 }
 
+void TextureManager::Cmd_CookTextures(const CmdArgs &args) {
+    if (args.Argc() < 2) {
+        BE_LOG(L"cookTextures <dir> [-norecurse]\n");
+        return;
+    }
+
+    bool recursive = !(args.Argc() > 2 && !WStr::Icmp(args.Argv(2), L"-norecurse"));
+
+    int startTime = PlatformTime::Milliseconds();
+    int numCooked = textureManager.CookTextures(WStr::ToStr(args.Argv(1)), recursive);
+
+    BE_LOG(L"%i textures cooked in %i ms\n", numCooked, PlatformTime::Milliseconds() - startTime);
+}
+
+void TextureManager::Cmd_ClearTextureCache(const CmdArgs &args) {
+    textureManager.textureCache.Clear();
+
+    BE_LOG(L"texture cache cleared\n");
+}
+
 BE_NAMESPACE_END
@@ -0,0 +1,552 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "Precompiled.h"
+#include "Render/TextureStreamer.h"
+#include "Core/Profiler.h"
+
+BE_NAMESPACE_BEGIN
+
+struct StreamingRequest {
+    struct State {
+        enum Enum {
+            Running,
+            Succeeded,
+            Failed
+        };
+    };
+
+    StreamedTexture *       streamedTexture;
+    TextureStreamerBackend *backend;
+    Str                     filename;
+    int                     firstMip;               // finest mip to prepare
+    JobHandle               job;
+    std::atomic<int32_t>    state;
+
+    bool                    streamable;
+    int                     width;
+    int                     height;
+    Image::Format           format;
+    Image                   mips;                   // mip chain from firstMip
+};
+
+// A used texture without a screen size is taken as a non-world texture (GUI, post process)
+// if the front end hasn't reported it for this number of frames.
+static const int            reportGraceFrames = 2;
+
+StreamedTexture::StreamedTexture() : reportedSize(0), used(false) {
+    userData            = nullptr;
+    index               = -1;
+    streamable          = true;
+    failed              = false;
+    width               = 0;
+    height              = 0;
+    format              = Image::Format::UnknownFormat;
+    numMips             = 0;
+    tailMip             = 0;
+    residentMip         = 0;
+    desiredMip          = 0;
+    screenSize          = 0;
+    lastReportedFrame   = -1;
+    lastUsedFrame       = -1;
+    preparedMip         = -1;
+    request             = nullptr;
+}
+
+size_t StreamedTexture::MipChainSize(int firstMip) const {
+    if (!streamable || firstMip >= numMips) {
+        return 0;
+    }
+    return Image::MemRequired(Max(width >> firstMip, 1), Max(height >> firstMip, 1), 1, numMips - firstMip, format);
+}
+
+void StreamedTexture::ReportScreenSize(float size) {
+    int32_t pixels = (int32_t)Math::Ceil(Min(size, 65536.0f));
+    int32_t current = reportedSize.load(std::memory_order_relaxed);
+    while (pixels > current && !reportedSize.compare_exchange_weak(current, pixels, std::memory_order_relaxed)) {
+    }
+}
+
+TextureStreamer::TextureStreamer() {
+    backend         = nullptr;
+    uploadBudget    = 4 * 1024 * 1024;
+    memoryBudget    = 256 * 1024 * 1024;
+    tailSize        = 64;
+    maxRequests     = 4;
+    mipBias         = 0.0f;
+    residentSize    = 0;
+    frameCount      = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+TextureStreamer::~TextureStreamer() {
+    Shutdown();
+}
+
+void TextureStreamer::Init(TextureStreamerBackend *backend) {
+    this->backend = backend;
+}
+
+void TextureStreamer::Shutdown() {
+    while (textures.Count() > 0) {
+        Unregister(textures.Last());
+    }
+    textures.Clear();
+
+    backend = nullptr;
+}
+
+StreamedTexture *TextureStreamer::Register(const char *filename, void *userData) {
+    StreamedTexture *streamedTexture = new StreamedTexture;
+    streamedTexture->filename = filename;
+    streamedTexture->userData = userData;
+    streamedTexture->index = textures.Append(streamedTexture);
+
+    // Size of the image is not known until the first decode, so the whole mip chain is prepared
+    StartRequest(streamedTexture, 0);
+
+    return streamedTexture;
+}
+
+void TextureStreamer::Unregister(StreamedTexture *streamedTexture) {
+    if (streamedTexture->request) {
+        jobSystem.Wait(streamedTexture->request->job);
+        delete streamedTexture->request;
+    }
+
+    residentSize -= streamedTexture->ResidentSize();
+
+    int index = streamedTexture->index;
+    textures.RemoveIndexFast(index);
+    if (index < textures.Count()) {
+        textures[index]->index = index;
+    }
+
+    delete streamedTexture;
+}
+
+void TextureStreamer::StartRequest(StreamedTexture *streamedTexture, int firstMip) {
+    StreamingRequest *request = new StreamingRequest;
+    request->streamedTexture = streamedTexture;
+    request->backend = backend;
+    request->filename = streamedTexture->filename;
+    request->firstMip = firstMip;
+    request->state = StreamingRequest::State::Running;
+    request->streamable = true;
+    request->width = 0;
+    request->height = 0;
+    request->format = Image::Format::UnknownFormat;
+
+    streamedTexture->request = request;
+
+    request->job = jobSystem.CreateJob(PrepareJob, request);
+    jobSystem.Run(request->job);
+}
+
+void TextureStreamer::PrepareJob(void *data) {
+    BE_PROFILE_SCOPE("TextureStreamer::PrepareJob");
+
+    StreamingRequest *request = (StreamingRequest *)data;
+    StreamingRequest::State::Enum state = StreamingRequest::State::Failed;
+
+    Image mips;
+    bool prepared = false;
+
+    if (request->backend->LoadCookedMips(request->streamedTexture, request->firstMip, request->width, request->height, request->format, request->mips)) {
+        // Only the requested mips are copied out of the cache
+        request->firstMip = Min(request->firstMip, Image::MaxMipMapLevels(request->width, request->height, 1) - 1);
+        state = StreamingRequest::State::Succeeded;
+    } else {
+        Image srcImage;
+        if (srcImage.Load(request->filename)) {
+            if (srcImage.GetDepth() > 1 || srcImage.NumSlices() > 1) {
+                request->streamable = false;
+                request->mips = std::move(srcImage);
+                state = StreamingRequest::State::Succeeded;
+            } else {
+                request->backend->AdjustImage(request->streamedTexture, srcImage, request->width, request->height, request->format);
+
+                if (PrepareMips(srcImage, request->width, request->height, request->format, mips)) {
+                    request->backend->StoreCookedMips(request->streamedTexture, srcImage, mips);
+                    prepared = true;
+                }
+            }
+        }
+    }
+
+    if (prepared) {
+        request->firstMip = Min(request->firstMip, mips.NumMipmaps() - 1);
+        if (request->firstMip > 0) {
+            CopyMipChain(mips, request->firstMip, request->mips);
+        } else {
+            request->mips = std::move(mips);
+        }
+        state = StreamingRequest::State::Succeeded;
+    }
+
+    // The request may be deleted as soon as the state is stored
+    request->state.store(state, std::memory_order_release);
+}
+
+void TextureStreamer::CopyMipChain(const Image &srcMips, int firstLevel, Image &dstMips) {
+    // Mip levels of a 2D image are contiguous, so the chain from firstLevel can be copied at once
+    dstMips.Create(srcMips.GetWidth(firstLevel), srcMips.GetHeight(firstLevel), 1, 1, srcMips.NumMipmaps() - firstLevel,
+        srcMips.GetFormat(), srcMips.GetPixels(firstLevel), srcMips.GetFlags());
+}
+
+bool TextureStreamer::PrepareMips(const Image &srcImage, int width, int height, Image::Format format, Image &mips) {
+    int numMips = Image::MaxMipMapLevels(width, height, 1);
+
+    if (srcImage.GetFormat() == format && srcImage.GetWidth() == width && srcImage.GetHeight() == height && srcImage.NumMipmaps() == numMips) {
+        mips = srcImage;
+        return true;
+    }
+
+    const Image *image = &srcImage;
+    Image rgba8888Image;
+    Image scaledImage;
+
+    // Mipmaps are built in a plain format
+    if (image->IsCompressed() || image->IsPacked()) {
+        if (!image->ConvertFormat(Image::RGBA_8_8_8_8, rgba8888Image)) {
+            return false;
+        }
+        image = &rgba8888Image;
+    }
+
+    if (image->GetWidth() != width || image->GetHeight() != height) {
+        if (!image->Resize(width, height, Image::Bicubic, scaledImage)) {
+            return false;
+        }
+        image = &scaledImage;
+    }
+
+    Image mipmappedImage;
+    mipmappedImage.Create(width, height, 1, 1, numMips, image->GetFormat(), nullptr, image->GetFlags());
+    mipmappedImage.CopyFrom(*image, 0, 1);
+    mipmappedImage.GenerateMipmaps();
+
+    if (mipmappedImage.GetFormat() == format) {
+        mips = std::move(mipmappedImage);
+        return true;
+    }
+    return mipmappedImage.ConvertFormat(format, mips);
+}
+
+int TextureStreamer::DesiredMip(int width, int height, float screenSize, float mipBias, int coarsestMip) {
+    if (screenSize < 1.0f) {
+        return coarsestMip;
+    }
+
+    float texelsPerPixel = Max(width, height) / screenSize;
+    int mip = (int)Math::Floor(Math::Log(2.0f, Max(texelsPerPixel, 1.0f)) + mipBias);
+    Clamp(mip, 0, coarsestMip);
+    return mip;
+}
+
+void TextureStreamer::WaitRequests() {
+    for (int i = 0; i < textures.Count(); i++) {
+        if (textures[i]->request) {
+            jobSystem.Wait(textures[i]->request->job);
+        }
+    }
+}
+
+void TextureStreamer::Update() {
+    BE_PROFILE_SCOPE("TextureStreamer::Update");
+
+    frameCount++;
+
+    stats.uploadedSize = 0;
+    stats.numEvicted = 0;
+
+    for (int i = 0; i < textures.Count(); i++) {
+        StreamedTexture *streamedTexture = textures[i];
+
+        UpdateDesiredMip(streamedTexture);
+
+        if (streamedTexture->request) {
+            // Without worker threads, decodes are executed here
+            if (jobSystem.NumWorkerThreads() == 0) {
+                jobSystem.Wait(streamedTexture->request->job);
+            }
+
+            if (streamedTexture->request->state.load(std::memory_order_acquire) != StreamingRequest::State::Running) {
+                FinishRequest(streamedTexture);
+            }
+        }
+
+        // Free the prepared mips which are not wanted anymore
+        if (streamedTexture->preparedMip >= 0 && streamedTexture->desiredMip >= streamedTexture->residentMip) {
+            streamedTexture->preparedMips.Clear();
+            streamedTexture->preparedMip = -1;
+        }
+    }
+
+    // Drop back textures in case the memory budget has been lowered
+    MakeRoom(0, nullptr);
+
+    StartRequests();
+
+    UploadMips();
+
+    stats.numTextures = textures.Count();
+    stats.numRequests = 0;
+    stats.residentSize = residentSize;
+    stats.preparedSize = 0;
+
+    for (int i = 0; i < textures.Count(); i++) {
+        const StreamedTexture *streamedTexture = textures[i];
+        if (streamedTexture->request) {
+            stats.numRequests++;
+        }
+        if (streamedTexture->preparedMip >= 0) {
+            stats.preparedSize += streamedTexture->MipChainSize(streamedTexture->preparedMip);
+        }
+    }
+}
+
+void TextureStreamer::UpdateDesiredMip(StreamedTexture *streamedTexture) {
+    int32_t reportedSize = streamedTexture->reportedSize.exchange(0, std::memory_order_relaxed);
+    bool used = streamedTexture->used.exchange(false, std::memory_order_relaxed);
+
+    if (reportedSize > 0) {
+        streamedTexture->screenSize = reportedSize;
+        streamedTexture->lastReportedFrame = frameCount;
+        streamedTexture->lastUsedFrame = frameCount;
+    } else if (used) {
+        if (streamedTexture->lastReportedFrame < 0 || frameCount - streamedTexture->lastReportedFrame > reportGraceFrames) {
+            streamedTexture->screenSize = 65536;
+        }
+        streamedTexture->lastUsedFrame = frameCount;
+    }
+
+    if (streamedTexture->IsReady() && streamedTexture->streamable) {
+        streamedTexture->desiredMip = DesiredMip(streamedTexture->width, streamedTexture->height, (float)streamedTexture->screenSize, mipBias, streamedTexture->tailMip);
+    }
+}
+
+void TextureStreamer::FinishRequest(StreamedTexture *streamedTexture) {
+    StreamingRequest *request = streamedTexture->request;
+    streamedTexture->request = nullptr;
+
+    if (request->state.load(std::memory_order_relaxed) == StreamingRequest::State::Failed) {
+        if (!streamedTexture->IsReady()) {
+            BE_WARNLOG(L"Couldn't load texture \"%hs\"\n", streamedTexture->filename.c_str());
+            streamedTexture->failed = true;
+        }
+        delete request;
+        return;
+    }
+
+    if (!request->streamable) {
+        streamedTexture->streamable = false;
+        streamedTexture->width = request->mips.GetWidth();
+        streamedTexture->height = request->mips.GetHeight();
+        streamedTexture->format = request->mips.GetFormat();
+        streamedTexture->numMips = request->mips.NumMipmaps();
+
+        backend->UploadMips(streamedTexture, request->mips);
+        delete request;
+        return;
+    }
+
+    bool firstDecode = !streamedTexture->IsReady();
+    if (firstDecode) {
+        streamedTexture->width = request->width;
+        streamedTexture->height = request->height;
+        streamedTexture->format = request->mips.GetFormat();
+        streamedTexture->numMips = Image::MaxMipMapLevels(request->width, request->height, 1);
+        streamedTexture->residentMip = streamedTexture->numMips;
+
+        int tailMip = 0;
+        while (tailMip < streamedTexture->numMips - 1 && Max(request->width >> tailMip, request->height >> tailMip) > tailSize) {
+            tailMip++;
+        }
+        streamedTexture->tailMip = tailMip;
+
+        CopyMipChain(request->mips, tailMip - request->firstMip, streamedTexture->tailMips);
+
+        UpdateDesiredMip(streamedTexture);
+    }
+
+    // Keep the mips which are still wanted
+    int keepMip = Max(streamedTexture->desiredMip, request->firstMip);
+    if (keepMip < streamedTexture->tailMip && keepMip < streamedTexture->residentMip) {
+        if (keepMip == request->firstMip) {
+            streamedTexture->preparedMips = std::move(request->mips);
+        } else {
+            CopyMipChain(request->mips, keepMip - request->firstMip, streamedTexture->preparedMips);
+        }
+        streamedTexture->preparedMip = keepMip;
+    }
+
+    delete request;
+
+    // The mip tail is made resident immediately, regardless of the budgets
+    if (firstDecode) {
+        MakeResident(streamedTexture, streamedTexture->tailMip, streamedTexture->tailMips);
+    }
+}
+
+void TextureStreamer::StartRequests() {
+    Array<StreamedTexture *> candidates;
+    int numRequests = 0;
+
+    for (int i = 0; i < textures.Count(); i++) {
+        StreamedTexture *streamedTexture = textures[i];
+
+        if (streamedTexture->request) {
+            numRequests++;
+            continue;
+        }
+        if (!streamedTexture->IsReady() || !streamedTexture->streamable) {
+            continue;
+        }
+        if (streamedTexture->desiredMip >= streamedTexture->residentMip) {
+            continue;
+        }
+        if (streamedTexture->preparedMip >= 0 && streamedTexture->preparedMip <= streamedTexture->desiredMip) {
+            continue;
+        }
+        candidates.Append(streamedTexture);
+    }
+
+    if (numRequests >= maxRequests || candidates.Count() == 0) {
+        return;
+    }
+
+    // Most recently used first, and then the ones missing the most mips
+    candidates.Sort([](const StreamedTexture *a, const StreamedTexture *b) {
+        if (a->lastUsedFrame != b->lastUsedFrame) {
+            return a->lastUsedFrame > b->lastUsedFrame;
+        }
+        return a->residentMip - a->desiredMip > b->residentMip - b->desiredMip;
+    });
+
+    for (int i = 0; i < candidates.Count() && numRequests < maxRequests; i++, numRequests++) {
+        StartRequest(candidates[i], candidates[i]->desiredMip);
+    }
+}
+
+void TextureStreamer::UploadMips() {
+    Array<StreamedTexture *> candidates;
+
+    for (int i = 0; i < textures.Count(); i++) {
+        StreamedTexture *streamedTexture = textures[i];
+
+        if (streamedTexture->preparedMip >= 0 && Max(streamedTexture->desiredMip, streamedTexture->preparedMip) < streamedTexture->residentMip) {
+            candidates.Append(streamedTexture);
+        }
+    }
+
+    candidates.Sort([](const StreamedTexture *a, const StreamedTexture *b) {
+        if (a->lastUsedFrame != b->lastUsedFrame) {
+            return a->lastUsedFrame > b->lastUsedFrame;
+        }
+        return a->residentMip - a->desiredMip > b->residentMip - b->desiredMip;
+    });
+
+    size_t budget = uploadBudget;
+
+    for (int i = 0; i < candidates.Count(); i++) {
+        StreamedTexture *streamedTexture = candidates[i];
+
+        // May have been evicted to make room for a previous candidate
+        if (streamedTexture->preparedMip < 0) {
+            continue;
+        }
+
+        int targetMip = Max(streamedTexture->desiredMip, streamedTexture->preparedMip);
+
+        // Finest mip fitting in the remaining budget. One mip is uploaded per update at least
+        int mip = streamedTexture->residentMip - 1;
+        if (streamedTexture->MipChainSize(mip) > budget && stats.uploadedSize > 0) {
+            continue;
+        }
+        while (mip > targetMip && streamedTexture->MipChainSize(mip - 1) <= budget) {
+            mip--;
+        }
+
+        size_t size = streamedTexture->MipChainSize(mip);
+        if (!MakeRoom(size - streamedTexture->ResidentSize(), streamedTexture)) {
+            continue;
+        }
+
+        Image mips;
+        CopyMipChain(streamedTexture->preparedMips, mip - streamedTexture->preparedMip, mips);
+        MakeResident(streamedTexture, mip, mips);
+
+        budget -= Min(size, budget);
+        stats.uploadedSize += size;
+
+        if (mip == targetMip) {
+            streamedTexture->preparedMips.Clear();
+            streamedTexture->preparedMip = -1;
+        }
+    }
+}
+
+bool TextureStreamer::MakeRoom(size_t size, const StreamedTexture *exclude) {
+    if (residentSize + size <= memoryBudget) {
+        return true;
+    }
+
+    // Textures used in the last frame are never evicted
+    Array<StreamedTexture *> candidates;
+
+    for (int i = 0; i < textures.Count(); i++) {
+        StreamedTexture *streamedTexture = textures[i];
+
+        if (streamedTexture != exclude && streamedTexture->IsReady() && streamedTexture->streamable &&
+            streamedTexture->residentMip < streamedTexture->tailMip && streamedTexture->lastUsedFrame < frameCount) {
+            candidates.Append(streamedTexture);
+        }
+    }
+
+    // Least recently used first
+    candidates.Sort([](const StreamedTexture *a, const StreamedTexture *b) {
+        return a->lastUsedFrame < b->lastUsedFrame;
+    });
+
+    for (int i = 0; i < candidates.Count(); i++) {
+        Evict(candidates[i]);
+
+        if (residentSize + size <= memoryBudget) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TextureStreamer::Evict(StreamedTexture *streamedTexture) {
+    streamedTexture->preparedMips.Clear();
+    streamedTexture->preparedMip = -1;
+
+    MakeResident(streamedTexture, streamedTexture->tailMip, streamedTexture->tailMips);
+
+    stats.numEvicted++;
+}
+
+void TextureStreamer::MakeResident(StreamedTexture *streamedTexture, int mip, const Image &mips) {
+    residentSize -= streamedTexture->ResidentSize();
+    streamedTexture->residentMip = mip;
+    residentSize += streamedTexture->ResidentSize();
+
+    backend->UploadMips(streamedTexture, mips);
+}
+
+BE_NAMESPACE_END
@@ -35,8 +35,14 @@ void LuaVM::RegisterGameWorld(LuaCpp::Module &module) {
         "find_entity_by_tag", &GameWorld::FindEntityByTag,
         "find_entities_by_tag", &GameWorld::FindEntitiesByTag,
         "ray_intersection", static_cast<Entity*(GameWorld::*)(const Vec3 &, const Vec3 &, int)const>(&GameWorld::RayIntersection),
+        "overlap_sphere", &GameWorld::OverlapSphere,
+        "overlap_aabb", &GameWorld::OverlapAABB,
         "instantiate_entity", &GameWorld::InstantiateEntity,
         "instantiate_entity_with_transform", &GameWorld::InstantiateEntityWithTransform,
+        "warm_up_entity_pool", &GameWorld::WarmUpEntityPool,
+        "acquire_entity", &GameWorld::AcquireEntity,
+        "acquire_entity_with_transform", &GameWorld::AcquireEntityWithTransform,
+        "release_entity", &GameWorld::ReleaseEntity,
         "dont_destroy_on_load", &GameWorld::DontDestroyOnLoad,
         "map_name", &GameWorld::MapName,
         "restart_game", &GameWorld::RestartGame,
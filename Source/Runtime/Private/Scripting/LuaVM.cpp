@@ -14,6 +14,7 @@
 
 #include "Precompiled.h"
 #include "Scripting/LuaVM.h"
+#include "Core/Heap.h"
 #include "Game/GameWorld.h"
 #include "File/FileSystem.h"
 #include "File/File.h"
@@ -51,12 +52,21 @@ static const struct luaL_Reg printlib[] = {
     { nullptr, nullptr }
 };
 
+static void *LuaAlloc(void *ud, void *ptr, size_t osize, size_t nsize) {
+    if (nsize == 0) {
+        Mem_Free(ptr);
+        return nullptr;
+    }
+    MemTagScope memTagScope(MemTag::Lua);
+    return Mem_Realloc(ptr, nsize);
+}
+
 void LuaVM::Init() {
     if (state) {
         Shutdown();
     }
 
-    state = new LuaCpp::State(true);
+    state = new LuaCpp::State(LuaAlloc, nullptr, true);
 
     //BE_LOG(L"Lua version %.1f\n", state->Version());
 
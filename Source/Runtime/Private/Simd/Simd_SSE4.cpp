@@ -442,6 +442,40 @@ void BE_FASTCALL SIMD_SSE4::MatrixMultiply(float *dst, const float *src0, const
     _mm_store_ps(dst + 12, a0);
 }
 
+// dst = parent * child for 3x4 matrices with implicit last row (0, 0, 0, 1)
+static BE_FORCE_INLINE void SSE_MultiplyMat3x4(float *dst, const float *parent, const float *child) {
+    const __m128 translationMask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+
+    const __m128 c0 = _mm_loadu_ps(child);
+    const __m128 c1 = _mm_loadu_ps(child + 4);
+    const __m128 c2 = _mm_loadu_ps(child + 8);
+
+    for (int row = 0; row < 3; row++) {
+        const __m128 p = _mm_loadu_ps(parent + row * 4);
+
+        __m128 r = _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0)), c0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)), c1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2)), c2));
+        r = _mm_add_ps(r, _mm_and_ps(p, translationMask));
+        _mm_storeu_ps(dst + row * 4, r);
+    }
+}
+
+void BE_FASTCALL SIMD_SSE4::TransformJoints(Mat3x4 *jointMats, const int *parents, const int firstJoint, const int lastJoint) {
+    for (int i = firstJoint; i <= lastJoint; i++) {
+        assert(parents[i] < i);
+        if (parents[i] >= 0) {
+            SSE_MultiplyMat3x4(jointMats[i].Ptr(), jointMats[parents[i]].Ptr(), jointMats[i].Ptr());
+        }
+    }
+}
+
+void BE_FASTCALL SIMD_SSE4::MultiplyJoints(Mat3x4 *result, const Mat3x4 *joints1, const Mat3x4 *joints2, const int numJoints) {
+    for (int i = 0; i < numJoints; i++) {
+        SSE_MultiplyMat3x4(result[i].Ptr(), joints1[i].Ptr(), joints2[i].Ptr());
+    }
+}
+
 #if 0
 
 static void SSE_Memcpy64B(void *dst, const void *src, const int count) {
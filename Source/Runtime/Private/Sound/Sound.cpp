@@ -18,6 +18,7 @@
 #include "Core/Cmds.h"
 #include "Platform/PlatformTime.h"
 #include "Sound/SoundSystem.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -268,6 +269,9 @@ void Sound::UpdatePosition(const Vec3 &origin) {
 }
 
 bool Sound::Load(const char *filename) {
+    BE_PROFILE_SCOPE("Sound::Load");
+    MemTagScope memTagScope(MemTag::Sound);
+
     Purge();
 
     BE_LOG(L"Loading sound '%hs'...\n", filename);
@@ -73,6 +73,8 @@
 #include "File/File.h"
 #include "File/FileMapping.h"
 #include "File/FileSystem.h"
+#include "File/AsyncFileIO.h"
+#include "File/ZipArchive.h"
 #include "File/ZipArchiver.h"
 
 // Utils
@@ -85,6 +87,8 @@
 #include "Core/CVars.h"
 #include "Core/Cmds.h"
 #include "Core/Task.h"
+#include "Core/JobSystem.h"
+#include "Core/Profiler.h"
 #include "Core/Vertex.h"
 #include "Core/JointPose.h"
 
@@ -94,6 +98,7 @@
 #include "Core/SignalObject.h"
 #include "Core/Property.h"
 #include "Core/Object.h"
+#include "Core/BinarySerializer.h"
 
 // SIMD
 #include "Simd/Simd.h"
@@ -108,7 +113,11 @@
 #include "Sound/SoundSystem.h"
 
 // RHI
+#ifdef USE_NULL_RHI
+#include "RHI/RHINull.h"
+#else
 #include "RHI/RHIOpenGL.h"
+#endif
 
 // Platform
 #include "Platform/Platform.h"
@@ -183,7 +192,10 @@
 
 // GameWorld
 #include "Game/Entity.h"
+#include "Game/EntityTemplate.h"
+#include "Game/EntityPool.h"
 #include "Game/Prefab.h"
+#include "Game/TransformSystem.h"
 #include "Game/MapRenderSettings.h"
 #include "Game/GameWorld.h"
 
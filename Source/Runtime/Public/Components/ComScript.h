@@ -33,11 +33,15 @@ public:
                             /// Returns true if the same component is allowed.
     virtual bool            AllowSameComponent() const override { return true; }
 
-                            /// Gets full list of property info including script properties.
-    virtual void            GetPropertyInfoList(Array<PropertyInfo> &propertyInfoList) const override;
+                            /// Returns flattened property info table including script properties.
+    virtual const PropertyInfoTable &GetPropertyInfoTable() const override;
 
                             /// Deserialize from JSON value.
     virtual void            Deserialize(const Json::Value &in) override;
+                            /// Deserialize from binary object.
+    virtual void            DeserializeBinary(const BinaryObject &in) override;
+                            /// Copies script and script property values from the source script component.
+    virtual void            CopyProperties(const Serializable &source, const HashTable<Guid, Guid> *remapGuidMap = nullptr) override;
 
     virtual void            Purge(bool chainPurge = true) override;
 
@@ -124,6 +128,9 @@ protected:
 
     Array<PropertyInfo>     fieldInfos;                 ///< Script variable infos
     HashMap<Str, Variant>   fieldGuids;                 ///< Script variable GUIDs
+    mutable PropertyInfoTable propertyInfoTables[2];    ///< Double buffered to keep property info in use valid while the script changes
+    mutable int             currentPropertyInfoTable = 0;
+    mutable bool            propertyInfoTableValid = false;
 
     LuaCpp::Selector        awakeFunc;
     LuaCpp::Selector        startFunc;
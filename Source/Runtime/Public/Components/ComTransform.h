@@ -18,8 +18,12 @@
 
 BE_NAMESPACE_BEGIN
 
+class TransformSystem;
+
 class ComTransform : public Component {
     friend class Entity;
+    friend class GameWorld;
+    friend class TransformSystem;
 
 public:
     OBJECT_PROTOTYPE(ComTransform);
@@ -32,6 +36,8 @@ public:
     ComTransform();
     virtual ~ComTransform();
 
+    virtual void            Purge(bool chainPurge = true) override;
+
                             /// Initializes this component. Called after deserialization.
     virtual void            Init() override;
 
@@ -86,7 +92,7 @@ public:
                             /// Returns rotation angles in world space.
     Angles                  GetAngles() const { return GetAxis().ToAngles(); }
                             /// Returns world space transform matrix.
-    const Mat3x4 &          GetMatrix() const;
+    Mat3x4                  GetMatrix() const;
                             /// Returns world space transform matrix without scaling.
     Mat3x4                  GetMatrixNoScale() const;
 
@@ -126,6 +132,11 @@ public:
 
     void                    SetPhysicsUpdating(bool updating) { physicsUpdating = updating; }
 
+                            /// Moves world matrix calculation to the batched transform system.
+    void                    AttachTransformSystem(TransformSystem *transformSystem);
+                            /// Takes back world matrix calculation from the batched transform system.
+    void                    DetachTransformSystem();
+
     static const SignalDef  SIG_TransformUpdated;
 
 protected:
@@ -133,6 +144,8 @@ protected:
     void                    InvalidateWorldMatrix();
                             /// Recalculate world matrix
     void                    UpdateWorldMatrix() const;
+                            /// Called when the parent entity is changed.
+    void                    ParentChanged();
 
     Vec3                    localOrigin;            ///< Position in local space.
     Vec3                    localScale;             ///< Scale in local space.
@@ -141,6 +154,9 @@ protected:
     mutable Mat3x4          worldMatrix;
     mutable bool            worldMatrixInvalidated;
     bool                    physicsUpdating;
+
+    TransformSystem *       transformSystem = nullptr;
+    int                     transformIndex = -1;    ///< Index in the transform system, -1 if not batched
 };
 
 BE_NAMESPACE_END
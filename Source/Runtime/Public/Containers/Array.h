@@ -25,14 +25,20 @@
     in adjacent memory locations and provides fast index-based access.
 
     Array<T> does not allocate memory until the first item is added. Likewise 
-    std::vector, Array<T> does reallocate and copy memory if it exceed the 
-    capacity. To avoid reallocation, you can use Reserve() to ensure a certain 
-    capacity before you really need it. And you can avoid frequent reallocation 
-    by modifying granularity.
+    std::vector, Array<T> does reallocate memory if it exceed the capacity. 
+    To avoid reallocation, you can use Reserve() to ensure a certain capacity 
+    before you really need it. And you can avoid frequent reallocation by 
+    modifying granularity.
+
+    Memory is allocated as raw aligned storage, and only the elements in use 
+    are constructed. Elements are moved to the new storage on reallocation, 
+    and trivially copyable elements are relocated with memcpy.
 
 -------------------------------------------------------------------------------
 */
 
+#include "Core/Heap.h"
+
 BE_NAMESPACE_BEGIN
 
 /// Templated dynamic array
@@ -44,7 +50,6 @@ public:
     static constexpr int DefaultGranularity = 16;
 
     using CmpFunc = int(const T *, const T *);
-    using NewFunc = T();
 
     /// Constructs empty array with granularity.
     Array(int newGranularity = DefaultGranularity);
@@ -52,8 +57,14 @@ public:
     /// Constructs from another array.
     Array(const Array<T> &array);
 
+    /// Moves from another array. The other array becomes empty.
+    Array(Array<T> &&array) noexcept;
+
     /// Assigns from another array, replacing its current contents.
     Array<T> &operator=(const Array<T> &rhs);
+
+    /// Moves from another array, replacing its current contents. The other array becomes empty.
+    Array<T> &operator=(Array<T> &&rhs) noexcept;
     
     /// Aggregates initialization constructor.
     Array(const std::initializer_list<T> &array);
@@ -130,30 +141,32 @@ public:
     void            Squeeze();
 
                     /// Sets count of array to 'newCount'. If 'newCount' is greater than current count, elements are added to the end. 
-                    /// The new elements are initialized with a default constructor.
+                    /// The new elements are initialized with a default constructor, and the removed elements are destructed.
     void            SetCount(int newCount, bool forceResize = true);
 
                     /// Sets capacity of array to 'newCapacity'. If 'newCapacity' is greater than current capacity, memory will be resized.
-                    /// The new elements are initialized with a default constructor.
+                    /// No elements are constructed until they are added.
     void            Reserve(int newCapacity);
 
-                    /// Sets capacity of array to 'newCapacity'. If 'newCapacity' is greater than current capacity, memory will be resized.
-                    /// The new elements are initialized with a default constructor and assigned with initialValue.
-    void            Reserve(int newCapacity, const T &initialValue);
-
-                    /// Sets capacity of array to 'newCapacity'. If 'newCapacity' is greater than current capacity, memory will be resized.
-                    /// The new elements are initialized with a default constructor and assigned with allocator function.
-                    /// This is valid operation only for pointer typed array.
-    void            ReserveAlloc(int newCapacity, NewFunc *allocator);
-
                     /// Sets the capacity of this array.
-                    /// Occurs reallocation and copy memory if capicity changed.
+                    /// Occurs reallocation and moves elements if capicity changed.
     void            Resize(int newCapacity);
     void            Resize(int newCapacity, int newGranularity);
 
                     /// Appends new element and returns reference of it.
+                    /// The new element is initialized with a default constructor.
     T &             Alloc();
 
+                    /// Constructs new element at the end of the array with the given arguments.
+                    /// Returns reference of the new element.
+    template <typename... Args>
+    T &             Emplace(Args&&... args);
+
+                    /// Constructs new element at index position 'index' with the given arguments.
+                    /// Returns reference of the new element.
+    template <typename... Args>
+    T &             EmplaceAt(int index, Args&&... args);
+
                     /// Inserts 'value' at index position 'index'.
                     /// Returns index of the inserted element.
     template <typename CompatibleT>
@@ -169,6 +182,10 @@ public:
     int             Append(CompatibleT &&value, Rest&&... rest);
     int             Append() { return count - 1; }
 
+                    /// Moves 'value' to the end of the array.
+                    /// Returns index of the appended element.
+    int             Append(T &&value);
+
                     /// Appends the items of the array 'array' to this array.
                     /// Returns index of the last appended element.
     int             AppendArray(const Array<T> &array);
@@ -268,28 +285,109 @@ public:
     void            Swap(Array<T> &array);
 
 private:
+    static T *      AllocElements(int capacity);
+    static void     FreeElements(T *elements);
+    static void     ConstructElements(T *elements, int count);
+    static void     DestructElements(T *elements, int count);
+                    /// Moves elements to the uninitialized memory 'dest', and destructs the source elements.
+    static void     RelocateElements(T *dest, T *src, int count);
+
+                    /// Returns capacity rounded up to the granularity for at least 'minCapacity' elements.
+    int             GrowCapacity(int minCapacity);
+
     int             count;          ///< Number of elements in use
     int             capacity;       ///< Size of elements allocated for
     int             granularity;    ///< Allocation granularity
     T *             elements;       ///< Elements pointer
 };
 
+template <typename T>
+BE_INLINE T *Array<T>::AllocElements(int capacity) {
+    if (alignof(T) > 16) {
+        return (T *)Mem_Alloc32(capacity * sizeof(T));
+    }
+    return (T *)Mem_Alloc16(capacity * sizeof(T));
+}
+
+template <typename T>
+BE_INLINE void Array<T>::FreeElements(T *elements) {
+    Mem_AlignedFree(elements);
+}
+
+template <typename T>
+BE_INLINE void Array<T>::ConstructElements(T *elements, int count) {
+    // Default initialization like new T[], which leaves trivial types uninitialized
+    if (!std::is_trivially_default_constructible<T>::value) {
+        for (int i = 0; i < count; i++) {
+            new (&elements[i]) T;
+        }
+    }
+}
+
+template <typename T>
+BE_INLINE void Array<T>::DestructElements(T *elements, int count) {
+    if (!std::is_trivially_destructible<T>::value) {
+        for (int i = 0; i < count; i++) {
+            elements[i].~T();
+        }
+    }
+}
+
+template <typename T>
+BE_INLINE void Array<T>::RelocateElements(T *dest, T *src, int count) {
+    if (std::is_trivially_copyable<T>::value) {
+        if (count > 0) {
+            memcpy((void *)dest, (const void *)src, count * sizeof(T));
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            new (&dest[i]) T(std::move(src[i]));
+            src[i].~T();
+        }
+    }
+}
+
+template <typename T>
+BE_INLINE int Array<T>::GrowCapacity(int minCapacity) {
+    if (granularity == 0) { // hack to fix memset
+        granularity = DefaultGranularity;
+    }
+
+    int newCapacity = minCapacity + granularity - 1;
+    return newCapacity - newCapacity % granularity;
+}
+
 template <typename T>
 BE_INLINE Array<T>::Array(int newGranularity) {
     assert(newGranularity > 0);
 
     elements = nullptr;
+    count = 0;
+    capacity = 0;
     granularity = newGranularity;
-
-    Clear();
 }
 
 template <typename T>
 BE_INLINE Array<T>::Array(const Array<T> &array) {
     elements = nullptr;
+    count = 0;
+    capacity = 0;
+    granularity = DefaultGranularity;
     *this = array;
 }
 
+template <typename T>
+BE_INLINE Array<T>::Array(Array<T> &&array) noexcept {
+    count = array.count;
+    capacity = array.capacity;
+    granularity = array.granularity;
+    elements = array.elements;
+
+    array.count = 0;
+    array.capacity = 0;
+    array.elements = nullptr;
+}
+
 template <typename T>
 BE_INLINE Array<T> &Array<T>::operator=(const Array<T> &rhs) {
     // In case of self-assignment do nothing
@@ -299,15 +397,40 @@ BE_INLINE Array<T> &Array<T>::operator=(const Array<T> &rhs) {
 
     Clear();
 
-    count = rhs.count;
-    capacity = rhs.capacity;
     granularity = rhs.granularity;
 
-    if (capacity) {
-        elements = new T[capacity];
-        for (int i = 0; i < count; i++) {
-            elements[i] = rhs.elements[i];
+    if (rhs.capacity) {
+        elements = AllocElements(rhs.capacity);
+        capacity = rhs.capacity;
+
+        if (std::is_trivially_copyable<T>::value) {
+            if (rhs.count > 0) {
+                memcpy((void *)elements, (const void *)rhs.elements, rhs.count * sizeof(T));
+            }
+        } else {
+            for (int i = 0; i < rhs.count; i++) {
+                new (&elements[i]) T(rhs.elements[i]);
+            }
         }
+        count = rhs.count;
+    }
+
+    return *this;
+}
+
+template <typename T>
+BE_INLINE Array<T> &Array<T>::operator=(Array<T> &&rhs) noexcept {
+    if (&rhs != this) {
+        Clear();
+
+        count = rhs.count;
+        capacity = rhs.capacity;
+        granularity = rhs.granularity;
+        elements = rhs.elements;
+
+        rhs.count = 0;
+        rhs.capacity = 0;
+        rhs.elements = nullptr;
     }
 
     return *this;
@@ -360,53 +483,19 @@ BE_INLINE void Array<T>::SetCount(int newCount, bool forceResize) {
         Resize(newCount);
     }
 
-    count = newCount;
-}
-
-template <typename T>
-BE_INLINE void Array<T>::Reserve(int newCapacity) {
-    if (newCapacity > capacity) {
-        if (granularity == 0) { // hack to fix memset
-            granularity = DefaultGranularity;
-        }
-
-        newCapacity += granularity - 1;
-        newCapacity -= newCapacity % granularity;
-        Resize(newCapacity);
+    if (newCount > count) {
+        ConstructElements(elements + count, newCount - count);
+    } else {
+        DestructElements(elements + newCount, count - newCount);
     }
-}
-
-template <typename T>
-BE_INLINE void Array<T>::Reserve(int newCapacity, const T &initialValue) {
-    if (newCapacity > capacity) {
-        if (granularity == 0) { // hack to fix memset
-            granularity = DefaultGranularity;
-        }
 
-        newCapacity += granularity - 1;
-        newCapacity -= newCapacity % granularity;
-        Resize(newCapacity);
-
-        for (int i = count; i < newCapacity; i++) {
-            elements[i] = initialValue;
-        }
-    }
+    count = newCount;
 }
 
 template <typename T>
-BE_INLINE void Array<T>::ReserveAlloc(int newCapacity, NewFunc *allocator) {
+BE_INLINE void Array<T>::Reserve(int newCapacity) {
     if (newCapacity > capacity) {
-        if (granularity == 0) { // hack to fix memset
-            granularity = DefaultGranularity;
-        }
-
-        newCapacity += granularity - 1;
-        newCapacity -= newCapacity % granularity;
-        Resize(newCapacity);
-
-        for (int i = count; i < newCapacity; i++) {
-            elements[i] = (*allocator)();
-        }
+        Resize(GrowCapacity(newCapacity));
     }
 }
 
@@ -425,18 +514,18 @@ BE_INLINE void Array<T>::Resize(int newCapacity) {
     }
 
     T *temp = elements;
-    capacity = newCapacity;
-    if (capacity < count) {
-        count = capacity;
-    }
 
-    elements = new T[capacity];
-    for (int i = 0; i < count; i++) {
-        elements[i] = temp[i];
+    if (newCapacity < count) {
+        DestructElements(temp + newCapacity, count - newCapacity);
+        count = newCapacity;
     }
 
+    elements = AllocElements(newCapacity);
+    capacity = newCapacity;
+
     if (temp) {
-        delete [] temp;
+        RelocateElements(elements, temp, count);
+        FreeElements(temp);
     }
 }
 
@@ -447,25 +536,7 @@ BE_INLINE void Array<T>::Resize(int newCapacity, int newGranularity) {
     assert(newGranularity > 0);
     granularity = newGranularity;
 
-    if (newCapacity <= 0) {
-        Clear();
-        return;
-    }
-
-    T *temp = elements;
-    capacity = newCapacity;
-    if (capacity < count) {
-        count = capacity;
-    }
-
-    elements = new T[capacity];
-    for (int i = 0; i < count; i++) {
-        elements[i] = temp[i];
-    }
-
-    if (temp) {
-        delete [] temp;
-    }
+    Resize(newCapacity);
 }
 
 template <typename T>
@@ -516,45 +587,72 @@ BE_INLINE bool Array<T>::operator!=(const Array<T> &rhs) const {
 
 template <typename T>
 BE_INLINE T &Array<T>::Alloc() {
-    if (granularity == 0) { // hack to fix memset
-        granularity = DefaultGranularity;
+    if (count == capacity) {
+        Resize(GrowCapacity(capacity + 1));
     }
 
-    if (!elements) {
-        Resize(granularity);
+    T *element = &elements[count++];
+    ConstructElements(element, 1);
+    return *element;
+}
+
+template <typename T>
+template <typename... Args>
+BE_INLINE T &Array<T>::Emplace(Args&&... args) {
+    if (count < capacity) {
+        T *element = new (&elements[count]) T(std::forward<Args>(args)...);
+        count++;
+        return *element;
     }
 
-    if (count == capacity) {
-        Resize(capacity + granularity);
+    // Construct the new element before the old elements are released, 
+    // because the arguments might refer to them.
+    int newCapacity = GrowCapacity(capacity + 1);
+    T *newElements = AllocElements(newCapacity);
+    T *element = new (&newElements[count]) T(std::forward<Args>(args)...);
+
+    if (elements) {
+        RelocateElements(newElements, elements, count);
+        FreeElements(elements);
     }
 
-    return elements[count++];
+    elements = newElements;
+    capacity = newCapacity;
+    count++;
+
+    return *element;
 }
 
 template <typename T>
-template <typename CompatibleT>
-BE_INLINE int Array<T>::Insert(CompatibleT &&value, int index) {
+template <typename... Args>
+BE_INLINE T &Array<T>::EmplaceAt(int index, Args&&... args) {
     assert(index >= 0 && index <= count);
 
-    if (!elements) {
-        Resize(granularity);
+    if (index == count) {
+        return Emplace(std::forward<Args>(args)...);
     }
 
-    if (count == capacity) {
-        if (granularity == 0) { // hack to fix memset
-            granularity = DefaultGranularity;
-        }
+    // Construct a temporary first since the arguments might refer to the elements to be shifted
+    T value(std::forward<Args>(args)...);
 
-        int newCapacity = capacity + granularity;
-        Resize(newCapacity - newCapacity % granularity);
+    if (count == capacity) {
+        Resize(GrowCapacity(capacity + 1));
     }
 
-    for (int i = count; i > index; --i) {
-        elements[i] = elements[i - 1];
+    new (&elements[count]) T(std::move(elements[count - 1]));
+    for (int i = count - 1; i > index; --i) {
+        elements[i] = std::move(elements[i - 1]);
     }
-    elements[index] = std::forward<CompatibleT>(value);
+    elements[index] = std::move(value);
     count++;
 
+    return elements[index];
+}
+
+template <typename T>
+template <typename CompatibleT>
+BE_INLINE int Array<T>::Insert(CompatibleT &&value, int index) {
+    EmplaceAt(index, std::forward<CompatibleT>(value));
     return index;
 }
 
@@ -562,39 +660,47 @@ template <typename T>
 BE_INLINE int Array<T>::InsertArray(const Array<T> &array, int index) {
     assert(index >= 0 && index <= count);
 
-    if (!elements) {
-        Resize(granularity);
-    }
+    const int numInserted = array.count;
 
-    if (count + array.count > capacity) {
-        if (granularity == 0) { // hack to fix memset
-            granularity = DefaultGranularity;
-        }
-
-        int newCapacity = capacity + array.count + granularity - 1;
-        Resize(newCapacity - newCapacity % granularity);
+    if (count + numInserted > capacity) {
+        Resize(GrowCapacity(count + numInserted));
     }
 
+    // Shift the elements after 'index', constructing the ones moved past the current count
     for (int i = count - 1; i >= index; --i) {
-        elements[i + array.count] = elements[i];
+        if (i + numInserted >= count) {
+            new (&elements[i + numInserted]) T(std::move(elements[i]));
+        } else {
+            elements[i + numInserted] = std::move(elements[i]);
+        }
     }
 
-    for (int i = 0; i < array.count; i++) {
-        elements[index + i] = array.elements[i];
+    for (int i = 0; i < numInserted; i++) {
+        if (index + i >= count) {
+            new (&elements[index + i]) T(array.elements[i]);
+        } else {
+            elements[index + i] = array.elements[i];
+        }
     }
 
-    count += array.count;
+    count += numInserted;
 
-    return index + array.count - 1;
+    return index + numInserted - 1;
 }
 
 template <typename T>
 template <typename CompatibleT, typename... Rest>
 BE_INLINE int Array<T>::Append(CompatibleT &&value, Rest&&... rest) {
-    Insert(std::forward<CompatibleT>(value), count);
+    Emplace(std::forward<CompatibleT>(value));
     return Append(std::forward<Rest>(rest)...);
 }
 
+template <typename T>
+BE_INLINE int Array<T>::Append(T &&value) {
+    Emplace(std::move(value));
+    return count - 1;
+}
+
 template <typename T>
 BE_INLINE int Array<T>::AppendArray(const Array<T> &array) {
     return InsertArray(array, count);
@@ -704,8 +810,9 @@ BE_INLINE bool Array<T>::RemoveIndex(int index) {
 
     count--;
     for (int i = index; i < count; i++) {
-        elements[i] = elements[i + 1];
+        elements[i] = std::move(elements[i + 1]);
     }
+    DestructElements(elements + count, 1);
 
     return true;
 }
@@ -718,8 +825,9 @@ BE_INLINE bool Array<T>::RemoveIndexFast(int index) {
 
     count--;
     if (index != count) {
-        elements[index] = elements[count];
+        elements[index] = std::move(elements[count]);
     }
+    DestructElements(elements + count, 1);
 
     return true;
 }
@@ -779,7 +887,7 @@ BE_INLINE T Array<T>::TakeAt(int index) {
         return T();
     }
 
-    T value = (*this)[index];
+    T value = std::move((*this)[index]);
     RemoveIndex(index);
     return value;
 }
@@ -787,7 +895,8 @@ BE_INLINE T Array<T>::TakeAt(int index) {
 template <typename T> 
 BE_INLINE void Array<T>::Clear() {
     if (elements) {
-        delete [] elements;
+        DestructElements(elements, count);
+        FreeElements(elements);
     }
 
     elements = nullptr;
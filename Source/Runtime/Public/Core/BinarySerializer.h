@@ -0,0 +1,289 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Binary Serializer
+
+    Compact binary encoding of the Serializable property model.
+    Values are stored in their native types, so decoding doesn't need to parse
+    vectors or colors from strings, and objects are read in place from the
+    (memory mapped) data without building an intermediate DOM.
+
+    All the fields are little endian and 4 bytes aligned.
+
+    File layout:
+        Header
+        Root object record
+        Entity index            uint32 offset of each indexed object record
+        String table            uint32 offset of each string, then null-terminated UTF-8 strings
+
+    Object record:
+        uint32                  record size in bytes including this header
+        uint32                  number of property records
+        property records
+
+    Property record:
+        uint32                  name string index
+        int16                   type (Variant::Type or ObjectType)
+        uint16                  flags (ArrayFlag)
+        uint32                  payload size in bytes
+        payload                 single value, or uint32 element count followed by elements.
+                                Str is stored as string index, object as object record.
+                                Elements of list are object records with one unnamed property each,
+                                so JSON arrays of mixed types or nested arrays keep the type of each element.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/Array.h"
+#include "Containers/HashIndex.h"
+#include "Core/Variant.h"
+
+BE_NAMESPACE_BEGIN
+
+class BinaryDeserializer;
+class BinaryObject;
+
+/// Read-only view of a property record.
+/// Accessors of an invalid property return empty values, so missing properties can be chained safely.
+class BE_API BinaryProperty {
+    friend class BinaryObject;
+    friend class BinaryDeserializer;
+
+public:
+    enum Flag {
+        ArrayFlag           = BIT(0)
+    };
+
+    enum {
+        ObjectType          = 0x100,    ///< Type of nested objects
+        ListType            = 0x101     ///< Type of arrays whose elements have their own types
+    };
+
+    BinaryProperty() : reader(nullptr), ptr(nullptr), end(nullptr) {}
+
+    bool                    IsValid() const { return ptr != nullptr; }
+
+                            /// Returns property name.
+    const char *            GetName() const;
+
+                            /// Returns Variant::Type, ObjectType or ListType.
+    int                     GetType() const;
+
+    bool                    IsArray() const;
+    bool                    IsObject() const { return GetType() == ObjectType; }
+    bool                    IsList() const { return GetType() == ListType; }
+
+                            /// Returns number of elements. Returns 1 if the property is not an array.
+    int                     Count() const;
+
+                            /// Reads a value of non-object property.
+    bool                    GetValue(Variant &out, int elementIndex = 0) const;
+
+                            /// Reads a value converted to the given type.
+                            /// Str values are parsed to math types, and numbers are converted each other.
+    bool                    GetValue(Variant::Type type, Variant &out, int elementIndex = 0) const;
+
+                            /// Returns nested object by element index.
+    BinaryObject            GetObject(int elementIndex = 0) const;
+
+                            /// Returns element of list property as an unnamed property.
+    BinaryProperty          GetListElement(int elementIndex) const;
+
+                            /// Returns next property in the same object. Returns invalid property at the end.
+    BinaryProperty          Next() const;
+
+private:
+    BinaryProperty(const BinaryDeserializer *reader, const byte *ptr, const byte *end) : reader(reader), ptr(ptr), end(end) {}
+
+    const byte *            Payload() const { return ptr + 12; }
+    const byte *            ElementPtr(int elementIndex) const;
+
+    const BinaryDeserializer *reader;
+    const byte *            ptr;            ///< Start of the property record
+    const byte *            end;            ///< End of the owner object record
+};
+
+/// Read-only view of an object record.
+class BE_API BinaryObject {
+    friend class BinaryProperty;
+    friend class BinaryDeserializer;
+
+public:
+    BinaryObject() : reader(nullptr), ptr(nullptr) {}
+
+    bool                    IsValid() const { return ptr != nullptr; }
+
+                            /// Returns number of properties.
+    int                     NumProperties() const;
+
+                            /// Returns the first property.
+    BinaryProperty          FirstProperty() const;
+
+                            /// Finds property with the given name. Returns invalid property if not found.
+                            /// Searching starts from hint and wraps around, so finding properties in
+                            /// the written order with the previous result's Next() is linear in total.
+    BinaryProperty          FindProperty(const char *name, const BinaryProperty &hint = BinaryProperty()) const;
+
+                            /// Returns value of the "classname" property. Returns empty string if not found.
+    const char *            ClassName() const;
+
+                            /// Returns the size of the object record in bytes.
+    int                     Size() const;
+
+private:
+    BinaryObject(const BinaryDeserializer *reader, const byte *ptr) : reader(reader), ptr(ptr) {}
+
+    const BinaryDeserializer *reader;
+    const byte *            ptr;
+};
+
+/// Writes objects into binary serialized data.
+class BE_API BinarySerializer {
+public:
+    BinarySerializer();
+
+                            /// Returns true if values of the given type can be serialized.
+    static bool             IsSupportedType(Variant::Type type);
+
+                            /// Begins an object record. Root object first, and then nested objects in object properties.
+                            /// Indexed objects are listed in the entity index.
+    void                    BeginObject(bool indexed = false);
+    void                    EndObject();
+
+                            /// Writes a property with single value.
+    void                    WriteProperty(const char *name, const Variant &value);
+
+                            /// Begins array property. Write elements with WriteElement().
+    void                    BeginArrayProperty(const char *name, Variant::Type type);
+    void                    WriteElement(const Variant &value);
+    void                    EndArrayProperty();
+
+                            /// Begins object property. Write each element with BeginObject() and EndObject().
+    void                    BeginObjectProperty(const char *name, bool isArray);
+    void                    EndObjectProperty();
+
+                            /// Begins list property. Write each element with BeginObject(), one unnamed property and EndObject().
+    void                    BeginListProperty(const char *name);
+    void                    EndListProperty();
+
+                            /// Writes members of JSON object into the current object.
+                            /// Value types are taken from the property infos of "classname" if possible.
+                            /// Elements of the array member named indexedArrayName are listed in the entity index.
+    void                    WriteJson(const Json::Value &value, const char *indexedArrayName = nullptr);
+
+                            /// Finishes writing and returns the serialized data.
+    const Array<byte> &     Finish(bool arrayRoot = false);
+
+                            /// Converts JSON value to binary serialized data.
+                            /// Root JSON array is stored as "entities" property of the root object.
+    static void             FromJson(const Json::Value &value, Array<byte> &data);
+
+private:
+    struct OpenRecord {
+        int                 offset;         ///< Record offset in data
+        int                 type;           ///< Property type
+        int                 count;          ///< Number of elements or properties
+    };
+
+    void                    Write(const void *src, int size);
+    void                    WriteUInt32(uint32_t value) { Write(&value, sizeof(value)); }
+    void                    WriteValue(Variant::Type type, const Variant &value);
+    void                    BeginProperty(const char *name, int type, int flags);
+    void                    EndProperty();
+    uint32_t                StringIndex(const char *string);
+    void                    WriteJsonProperty(const char *name, const Json::Value &value, Variant::Type knownType, bool indexElements);
+
+    Array<byte>             data;
+    Array<OpenRecord>       objectStack;
+    Array<OpenRecord>       propertyStack;
+    Array<uint32_t>         indexedObjects;
+    Array<Str>              strings;
+    HashIndex               stringHash;
+    bool                    finished;
+};
+
+/// Reads binary serialized data in place.
+class BE_API BinaryDeserializer {
+    friend class BinaryProperty;
+    friend class BinaryObject;
+
+public:
+    enum {
+        Magic               = 0x42534542,   ///< 'BESB'
+        Version             = 2             ///< Version 2 adds list properties
+    };
+
+    enum HeaderFlag {
+        ArrayRootFlag       = BIT(0)        ///< Root object wraps JSON array in "entities" property
+    };
+
+    struct Header {
+        uint32_t            magic;
+        uint32_t            version;
+        uint32_t            flags;
+        uint32_t            size;           ///< Total size in bytes
+        uint32_t            rootOffset;
+        uint32_t            entityIndexOffset;
+        uint32_t            numEntities;
+        uint32_t            stringTableOffset;
+        uint32_t            numStrings;
+        uint32_t            reserved[3];
+    };
+
+    BinaryDeserializer();
+
+                            /// Returns true if the data starts with binary serializer header.
+    static bool             IsBinary(const void *data, size_t size);
+
+                            /// Validates and opens the data. The data must stay valid while reading.
+    bool                    Open(const void *data, size_t size);
+
+    bool                    IsOpened() const { return header != nullptr; }
+
+    const Header *          GetHeader() const { return header; }
+
+                            /// Returns the root object.
+    BinaryObject            GetRoot() const;
+
+                            /// Returns number of indexed objects.
+    int                     NumEntities() const { return header ? header->numEntities : 0; }
+
+                            /// Returns indexed object.
+    BinaryObject            GetEntity(int index) const;
+
+                            /// Returns string in the string table.
+    const char *            GetString(int index) const;
+
+                            /// Converts opened data to JSON value.
+    void                    ToJson(Json::Value &value) const;
+
+                            /// Converts object to JSON value.
+    static void             ToJson(const BinaryObject &object, Json::Value &value);
+
+                            /// Converts value of property to JSON value.
+    static void             ToJson(const BinaryProperty &prop, Json::Value &value);
+
+private:
+    bool                    ValidateObject(const byte *ptr, const byte *end, int depth) const;
+
+    const byte *            data;
+    const Header *          header;
+};
+
+BE_NAMESPACE_END
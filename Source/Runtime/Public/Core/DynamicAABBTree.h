@@ -25,10 +25,19 @@
 #include "Containers/Stack.h"
 #include "Math/Math.h"
 
+#if defined(__X86__)
+#include <xmmintrin.h>
+#endif
+
 BE_NAMESPACE_BEGIN
 
 class BE_API DynamicAABBTree {
 public:
+    enum FrustumCullMethod {
+        AllPlanesCull,      ///< Tests all the frustum planes on every visited node
+        PlaneMaskCull       ///< Skips the planes that contain the parent node and tests both children against the rest of the planes at once with SIMD
+    };
+
     DynamicAABBTree();
     ~DynamicAABBTree();
 
@@ -69,14 +78,43 @@ public:
                     /// Build an optimal tree. Very expensive. For testing.
     void            RebuildBottomUp();
 
+                    /// Get roots of at most maxSubtrees disjoint subtrees that cover the whole tree. Returns number of subtrees.
+                    /// Querying each subtree in the returned order visits the leaves in the same order as querying from the root.
+    int             GetSubtreeRoots(int maxSubtrees, int32_t *subtreeRoots) const;
+
+    template <typename F>
+    void            Query(const Sphere &boundingVolume, F &callback) const { Query(boundingVolume, callback, root); }
+    template <typename F>
+    void            Query(const AABB &boundingVolume, F &callback) const { Query(boundingVolume, callback, root); }
+    template <typename F>
+    void            Query(const OBB &boundingVolume, F &callback) const { Query(boundingVolume, callback, root); }
+    template <typename F>
+    void            Query(const Frustum &boundingVolume, F &callback) const { Query(boundingVolume, callback, root); }
+
+                    /// Query only the subtree rooted at startNodeId.
+    template <typename F>
+    void            Query(const Sphere &boundingVolume, F &callback, int32_t startNodeId) const;
     template <typename F>
-    void            Query(const Sphere &boundingVolume, F &callback) const;
+    void            Query(const AABB &boundingVolume, F &callback, int32_t startNodeId) const;
     template <typename F>
-    void            Query(const AABB &boundingVolume, F &callback) const;
+    void            Query(const OBB &boundingVolume, F &callback, int32_t startNodeId) const;
+    template <typename F>
+    void            Query(const Frustum &boundingVolume, F &callback, int32_t startNodeId) const { QueryFrustum(boundingVolume, callback, startNodeId, PlaneMaskCull); }
+
+                    /// Query only the subtree rooted at startNodeId, and skip the subtrees of the internal nodes for which cullNode(aabb) returns true.
+                    /// Used to skip the nodes occluded in the view.
+    template <typename F, typename C>
+    void            Query(const Frustum &boundingVolume, F &callback, C &cullNode, int32_t startNodeId) const { QueryFrustum(boundingVolume, callback, cullNode, startNodeId, PlaneMaskCull); }
+
+                    /// Frustum query with the given cull method. Returns the number of visited nodes. For testing.
     template <typename F>
-    void            Query(const OBB &boundingVolume, F &callback) const;
+    int             QueryFrustum(const Frustum &frustum, F &callback, FrustumCullMethod cullMethod) const { return QueryFrustum(frustum, callback, root, cullMethod); }
+
+                    /// Casts a ray against the fat AABBs. Leaves are visited in front-to-back order of their entry distances,
+                    /// and nodes that the ray enters at or beyond maxScale are skipped.
+                    /// callback(proxyId, maxScale) returns the new maxScale, so a closer hit prunes the rest of the traversal.
     template <typename F>
-    void            Query(const Frustum &boundingVolume, F &callback) const;
+    void            RayCast(const Vec3 &start, const Vec3 &dir, float maxScale, F &callback) const;
 
 private:
     int             AllocNode();
@@ -87,12 +125,54 @@ private:
 
     int             Balance(int32_t index);
 
+    template <typename F>
+    int             QueryFrustum(const Frustum &frustum, F &callback, int32_t startNodeId, FrustumCullMethod cullMethod) const;
+    template <typename F, typename C>
+    int             QueryFrustum(const Frustum &frustum, F &callback, C &cullNode, int32_t startNodeId, FrustumCullMethod cullMethod) const;
+
     int             ComputeHeight() const;
     int             ComputeHeight(int32_t nodeId) const;
 
     void            ValidateStructure(int32_t index) const;
     void            ValidateMetrics(int32_t index) const;
 
+    // Frustum planes packed for culling AABBs against all of them at once
+    struct FrustumCullPlanes {
+        enum { AllPlanesMask = BIT(6) - 1 };
+
+        void        Set(const Frustum &frustum);
+
+                    // Returns true if the AABB is outside of any plane in planeMask.
+                    // Otherwise clears the bits of the planes which have the AABB completely inside.
+        bool        CullAABB(const AABB &aabb, int &planeMask) const;
+
+                    // Culls two AABBs against the same planes at once, typically the children of a node.
+                    // Returns bit 0 if the first AABB is culled and bit 1 if the second AABB is culled.
+        int         CullAABBs(const AABB &aabb1, const AABB &aabb2, int &planeMask1, int &planeMask2) const;
+
+#if defined(__X86__)
+        __m128      normalX[2];     // 6 planes + 2 padding planes that contain everything
+        __m128      normalY[2];
+        __m128      normalZ[2];
+        __m128      absNormalX[2];
+        __m128      absNormalY[2];
+        __m128      absNormalZ[2];
+        __m128      dist[2];
+#else
+        Plane       planes[6];
+#endif
+    };
+
+    struct FrustumQueryNode {
+        int32_t     nodeId;
+        int32_t     planeMask;      // planes that are not known to contain the node yet
+    };
+
+    struct RayCastNode {
+        int32_t     nodeId;
+        float       entryScale;
+    };
+
     struct Node {
         bool        IsLeaf() const { return child1 == -1; }
         
@@ -134,9 +214,9 @@ BE_INLINE const AABB &DynamicAABBTree::GetRootFatAABB() const {
 }
 
 template <typename F>
-BE_INLINE void DynamicAABBTree::Query(const Sphere &sphere, F &callback) const {
+BE_INLINE void DynamicAABBTree::Query(const Sphere &sphere, F &callback, int32_t startNodeId) const {
     Stack<int32_t> stack(256);
-    stack.Push(root);
+    stack.Push(startNodeId);
 
     while (!stack.IsEmpty()) {
         int32_t nodeId = stack.Pop();
@@ -161,9 +241,9 @@ BE_INLINE void DynamicAABBTree::Query(const Sphere &sphere, F &callback) const {
 }
 
 template <typename F>
-BE_INLINE void DynamicAABBTree::Query(const AABB &aabb, F &callback) const {
+BE_INLINE void DynamicAABBTree::Query(const AABB &aabb, F &callback, int32_t startNodeId) const {
     Stack<int32_t> stack(256);
-    stack.Push(root);
+    stack.Push(startNodeId);
 
     while (!stack.IsEmpty()) {
         int32_t nodeId = stack.Pop();
@@ -188,9 +268,60 @@ BE_INLINE void DynamicAABBTree::Query(const AABB &aabb, F &callback) const {
 }
 
 template <typename F>
-BE_INLINE void DynamicAABBTree::Query(const OBB &obb, F &callback) const {
+BE_INLINE void DynamicAABBTree::RayCast(const Vec3 &start, const Vec3 &dir, float maxScale, F &callback) const {
+    if (root == -1) {
+        return;
+    }
+
+    float rootScale = nodes[root].aabb.RayIntersection(start, dir);
+    if (rootScale >= maxScale) {
+        return;
+    }
+
+    Stack<RayCastNode> stack(256);
+    stack.Push({ root, rootScale });
+
+    while (!stack.IsEmpty()) {
+        const RayCastNode entry = stack.Pop();
+
+        // A closer hit may have been found after this node was pushed
+        if (entry.entryScale >= maxScale) {
+            continue;
+        }
+
+        const Node *node = nodes + entry.nodeId;
+
+        if (node->IsLeaf()) {
+            maxScale = callback(entry.nodeId, maxScale);
+            continue;
+        }
+
+        float scale1 = nodes[node->child1].aabb.RayIntersection(start, dir);
+        float scale2 = nodes[node->child2].aabb.RayIntersection(start, dir);
+
+        // Push the farther child first so that the nearer one is visited first
+        if (scale1 < scale2) {
+            if (scale2 < maxScale) {
+                stack.Push({ node->child2, scale2 });
+            }
+            if (scale1 < maxScale) {
+                stack.Push({ node->child1, scale1 });
+            }
+        } else {
+            if (scale1 < maxScale) {
+                stack.Push({ node->child1, scale1 });
+            }
+            if (scale2 < maxScale) {
+                stack.Push({ node->child2, scale2 });
+            }
+        }
+    }
+}
+
+template <typename F>
+BE_INLINE void DynamicAABBTree::Query(const OBB &obb, F &callback, int32_t startNodeId) const {
     Stack<int32_t> stack(256);
-    stack.Push(root);
+    stack.Push(startNodeId);
 
     while (!stack.IsEmpty()) {
         int32_t nodeId = stack.Pop();
@@ -214,31 +345,280 @@ BE_INLINE void DynamicAABBTree::Query(const OBB &obb, F &callback) const {
     }
 }
 
-template <typename F>
-BE_INLINE void DynamicAABBTree::Query(const Frustum &frustum, F &callback) const {
-    Stack<int32_t> stack(256);
-    stack.Push(root);
+// Frustum planes in world space, pointing outwards.
+BE_INLINE void DynamicAABBTree::FrustumCullPlanes::Set(const Frustum &frustum) {
+    const Vec3 &origin = frustum.GetOrigin();
+    const Mat3 &axis = frustum.GetAxis();
+    const float dNear = frustum.GetNearDistance();
+    const float dFar = frustum.GetFarDistance();
+    const float dLeft = frustum.GetLeft();
+    const float dUp = frustum.GetUp();
+
+    // Planes in frustum local space
+    Vec3 localNormals[6];
+    float localDists[6];
+    localNormals[0] = Vec3(-1.0f, 0.0f, 0.0f);      localDists[0] = dNear;
+    localNormals[1] = Vec3(1.0f, 0.0f, 0.0f);       localDists[1] = -dFar;
+    localNormals[2] = Vec3(-dLeft, dFar, 0.0f);     localDists[2] = 0.0f;
+    localNormals[3] = Vec3(-dLeft, -dFar, 0.0f);    localDists[3] = 0.0f;
+    localNormals[4] = Vec3(-dUp, 0.0f, dFar);       localDists[4] = 0.0f;
+    localNormals[5] = Vec3(-dUp, 0.0f, -dFar);      localDists[5] = 0.0f;
+
+    Plane worldPlanes[8];
+    for (int i = 0; i < 6; i++) {
+        localNormals[i].Normalize();
+
+        Vec3 normal = axis[0] * localNormals[i].x + axis[1] * localNormals[i].y + axis[2] * localNormals[i].z;
+        worldPlanes[i] = Plane(normal, localDists[i] - normal.Dot(origin));
+    }
 
-    while (!stack.IsEmpty()) {
-        int32_t nodeId = stack.Pop();
-        if (nodeId == -1) {
+#if defined(__X86__)
+    worldPlanes[6] = Plane(0.0f, 0.0f, 0.0f, -1.0f);
+    worldPlanes[7] = Plane(0.0f, 0.0f, 0.0f, -1.0f);
+
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    for (int i = 0; i < 2; i++) {
+        const Plane *p = &worldPlanes[i * 4];
+
+        normalX[i] = _mm_setr_ps(p[0].a, p[1].a, p[2].a, p[3].a);
+        normalY[i] = _mm_setr_ps(p[0].b, p[1].b, p[2].b, p[3].b);
+        normalZ[i] = _mm_setr_ps(p[0].c, p[1].c, p[2].c, p[3].c);
+        absNormalX[i] = _mm_andnot_ps(signMask, normalX[i]);
+        absNormalY[i] = _mm_andnot_ps(signMask, normalY[i]);
+        absNormalZ[i] = _mm_andnot_ps(signMask, normalZ[i]);
+        dist[i] = _mm_setr_ps(p[0].d, p[1].d, p[2].d, p[3].d);
+    }
+#else
+    for (int i = 0; i < 6; i++) {
+        planes[i] = worldPlanes[i];
+    }
+#endif
+}
+
+BE_INLINE bool DynamicAABBTree::FrustumCullPlanes::CullAABB(const AABB &aabb, int &planeMask) const {
+    const Vec3 center = aabb.Center();
+    const Vec3 extents = aabb[1] - center;
+
+#if defined(__X86__)
+    const __m128 centerX = _mm_set1_ps(center.x);
+    const __m128 centerY = _mm_set1_ps(center.y);
+    const __m128 centerZ = _mm_set1_ps(center.z);
+    const __m128 extentsX = _mm_set1_ps(extents.x);
+    const __m128 extentsY = _mm_set1_ps(extents.y);
+    const __m128 extentsZ = _mm_set1_ps(extents.z);
+    const __m128 zero = _mm_setzero_ps();
+
+    int outsideBits = 0;
+    int insideBits = 0;
+
+    for (int i = 0; i < 2; i++) {
+        // Signed distances of the box center and the projected radii of the box for 4 planes
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX[i], centerX), _mm_mul_ps(normalY[i], centerY)), _mm_add_ps(_mm_mul_ps(normalZ[i], centerZ), dist[i]));
+        __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absNormalX[i], extentsX), _mm_mul_ps(absNormalY[i], extentsY)), _mm_mul_ps(absNormalZ[i], extentsZ));
+
+        outsideBits |= _mm_movemask_ps(_mm_cmpgt_ps(_mm_sub_ps(d, r), zero)) << (i * 4);
+        insideBits |= _mm_movemask_ps(_mm_cmple_ps(_mm_add_ps(d, r), zero)) << (i * 4);
+    }
+
+    if (outsideBits & planeMask) {
+        return true;
+    }
+
+    planeMask &= ~insideBits;
+#else
+    for (int i = 0; i < 6; i++) {
+        if (!(planeMask & BIT(i))) {
             continue;
         }
 
-        const Node *node = nodes + nodeId;
+        float d = planes[i].Distance(center);
+        float r = Math::Fabs(planes[i].a * extents.x) + Math::Fabs(planes[i].b * extents.y) + Math::Fabs(planes[i].c * extents.z);
+
+        if (d - r > 0.0f) {
+            return true;
+        }
+
+        if (d + r <= 0.0f) {
+            planeMask &= ~BIT(i);
+        }
+    }
+#endif
+    return false;
+}
+
+BE_INLINE int DynamicAABBTree::FrustumCullPlanes::CullAABBs(const AABB &aabb1, const AABB &aabb2, int &planeMask1, int &planeMask2) const {
+#if defined(__X86__)
+    const Vec3 center1 = aabb1.Center();
+    const Vec3 extents1 = aabb1[1] - center1;
+    const Vec3 center2 = aabb2.Center();
+    const Vec3 extents2 = aabb2[1] - center2;
+
+    const __m128 centerX1 = _mm_set1_ps(center1.x);
+    const __m128 centerY1 = _mm_set1_ps(center1.y);
+    const __m128 centerZ1 = _mm_set1_ps(center1.z);
+    const __m128 extentsX1 = _mm_set1_ps(extents1.x);
+    const __m128 extentsY1 = _mm_set1_ps(extents1.y);
+    const __m128 extentsZ1 = _mm_set1_ps(extents1.z);
+    const __m128 centerX2 = _mm_set1_ps(center2.x);
+    const __m128 centerY2 = _mm_set1_ps(center2.y);
+    const __m128 centerZ2 = _mm_set1_ps(center2.z);
+    const __m128 extentsX2 = _mm_set1_ps(extents2.x);
+    const __m128 extentsY2 = _mm_set1_ps(extents2.y);
+    const __m128 extentsZ2 = _mm_set1_ps(extents2.z);
+    const __m128 zero = _mm_setzero_ps();
+
+    int outsideBits1 = 0;
+    int insideBits1 = 0;
+    int outsideBits2 = 0;
+    int insideBits2 = 0;
+
+    // Each plane batch is loaded once for both boxes, and the two independent chains of arithmetic interleave
+    for (int i = 0; i < 2; i++) {
+        const __m128 nx = normalX[i];
+        const __m128 ny = normalY[i];
+        const __m128 nz = normalZ[i];
+        const __m128 anx = absNormalX[i];
+        const __m128 any = absNormalY[i];
+        const __m128 anz = absNormalZ[i];
+        const __m128 nd = dist[i];
+
+        __m128 d1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, centerX1), _mm_mul_ps(ny, centerY1)), _mm_add_ps(_mm_mul_ps(nz, centerZ1), nd));
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, centerX2), _mm_mul_ps(ny, centerY2)), _mm_add_ps(_mm_mul_ps(nz, centerZ2), nd));
+        __m128 r1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(anx, extentsX1), _mm_mul_ps(any, extentsY1)), _mm_mul_ps(anz, extentsZ1));
+        __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(anx, extentsX2), _mm_mul_ps(any, extentsY2)), _mm_mul_ps(anz, extentsZ2));
+
+        outsideBits1 |= _mm_movemask_ps(_mm_cmpgt_ps(_mm_sub_ps(d1, r1), zero)) << (i * 4);
+        insideBits1 |= _mm_movemask_ps(_mm_cmple_ps(_mm_add_ps(d1, r1), zero)) << (i * 4);
+        outsideBits2 |= _mm_movemask_ps(_mm_cmpgt_ps(_mm_sub_ps(d2, r2), zero)) << (i * 4);
+        insideBits2 |= _mm_movemask_ps(_mm_cmple_ps(_mm_add_ps(d2, r2), zero)) << (i * 4);
+    }
+
+    int culledBits = 0;
+
+    if (outsideBits1 & planeMask1) {
+        culledBits |= 1;
+    } else {
+        planeMask1 &= ~insideBits1;
+    }
+
+    if (outsideBits2 & planeMask2) {
+        culledBits |= 2;
+    } else {
+        planeMask2 &= ~insideBits2;
+    }
+
+    return culledBits;
+#else
+    return (CullAABB(aabb1, planeMask1) ? 1 : 0) | (CullAABB(aabb2, planeMask2) ? 2 : 0);
+#endif
+}
+
+template <typename F>
+BE_INLINE int DynamicAABBTree::QueryFrustum(const Frustum &frustum, F &callback, int32_t startNodeId, FrustumCullMethod cullMethod) const {
+    auto cullNothing = [](const AABB &aabb) -> bool { return false; };
+    return QueryFrustum(frustum, callback, cullNothing, startNodeId, cullMethod);
+}
+
+template <typename F, typename C>
+BE_INLINE int DynamicAABBTree::QueryFrustum(const Frustum &frustum, F &callback, C &cullNode, int32_t startNodeId, FrustumCullMethod cullMethod) const {
+    FrustumCullPlanes cullPlanes;
+    if (cullMethod == PlaneMaskCull) {
+        cullPlanes.Set(frustum);
+    }
+
+    Stack<FrustumQueryNode> stack(256);
+    FrustumQueryNode &startNode = stack.Push();
+    startNode.nodeId = startNodeId;
+    startNode.planeMask = FrustumCullPlanes::AllPlanesMask;
+
+    int numVisitedNodes = 0;
+
+    if (cullMethod == PlaneMaskCull) {
+        if (startNodeId == -1) {
+            return 0;
+        }
+
+        numVisitedNodes++;
+
+        if (cullPlanes.CullAABB(nodes[startNodeId].aabb, startNode.planeMask)) {
+            return numVisitedNodes;
+        }
+
+        // Nodes on the stack have already passed the test.
+        // Both children of a node are tested at once before they are pushed.
+        while (!stack.IsEmpty()) {
+            FrustumQueryNode queryNode = stack.Pop();
+
+            const Node *node = nodes + queryNode.nodeId;
 
-        if (!frustum.CullAABB(node->aabb)) {
             if (node->IsLeaf()) {
-                bool proceed = callback(nodeId);
+                bool proceed = callback(queryNode.nodeId);
                 if (proceed == false) {
-                    return;
+                    break;
                 }
-            } else {
-                stack.Push(node->child1);
-                stack.Push(node->child2);
+                continue;
+            }
+
+            if (cullNode(node->aabb)) {
+                continue;
+            }
+
+            int planeMask1 = queryNode.planeMask;
+            int planeMask2 = queryNode.planeMask;
+
+            numVisitedNodes += 2;
+
+            // No more plane tests for the nodes which are completely inside of the frustum
+            int culledBits = queryNode.planeMask ? cullPlanes.CullAABBs(nodes[node->child1].aabb, nodes[node->child2].aabb, planeMask1, planeMask2) : 0;
+
+            if (!(culledBits & 1)) {
+                FrustumQueryNode &child1 = stack.Push();
+                child1.nodeId = node->child1;
+                child1.planeMask = planeMask1;
+            }
+
+            if (!(culledBits & 2)) {
+                FrustumQueryNode &child2 = stack.Push();
+                child2.nodeId = node->child2;
+                child2.planeMask = planeMask2;
             }
         }
+
+        return numVisitedNodes;
     }
+
+    while (!stack.IsEmpty()) {
+        FrustumQueryNode queryNode = stack.Pop();
+        if (queryNode.nodeId == -1) {
+            continue;
+        }
+
+        const Node *node = nodes + queryNode.nodeId;
+
+        numVisitedNodes++;
+
+        if (frustum.CullAABB(node->aabb)) {
+            continue;
+        }
+
+        if (node->IsLeaf()) {
+            bool proceed = callback(queryNode.nodeId);
+            if (proceed == false) {
+                break;
+            }
+        } else if (!cullNode(node->aabb)) {
+            FrustumQueryNode &child1 = stack.Push();
+            child1.nodeId = node->child1;
+            child1.planeMask = queryNode.planeMask;
+
+            FrustumQueryNode &child2 = stack.Push();
+            child2.nodeId = node->child2;
+            child2.planeMask = queryNode.planeMask;
+        }
+    }
+
+    return numVisitedNodes;
 }
 
 BE_NAMESPACE_END
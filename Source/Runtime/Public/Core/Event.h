@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include "Containers/Array.h"
 #include "Containers/LinkList.h"
 
 BE_NAMESPACE_BEGIN
@@ -66,6 +67,7 @@ private:
 
 class BE_API Event {
     friend class EventSystem;
+    friend class EventQueue;
 
 public:
     Event() = default;
@@ -74,16 +76,43 @@ public:
     byte *                  GetData() { return data; }
 
 private:
-    const EventDef *        eventDef;
-    byte *                  data;
-    int                     time;
-    Object *                sender;
-    LinkList<Event>         node;
+    const EventDef *        eventDef = nullptr;
+    byte *                  data = nullptr;
+    int                     time = 0;
+    uint32_t                sequence = 0;       ///< Scheduled order to keep FIFO order of the events at the same time
+    int                     queueIndex = -1;    ///< Index in the event queue heap, -1 if not scheduled
+    Object *                sender = nullptr;
+    LinkList<Event>         node;               ///< Node in the free event list
+    LinkList<Event>         senderNode;         ///< Node in the pending event list of the sender
+};
+
+/// Indexed binary min-heap of the scheduled events ordered by time.
+/// Each event knows its index in the heap, so removing an arbitrary event is O(log n).
+class BE_API EventQueue {
+public:
+    bool                    IsEmpty() const { return heap.Count() == 0; }
+    int                     Count() const { return heap.Count(); }
+
+                            /// Returns the earliest event
+    Event *                 Top() const { return heap[0]; }
+
+    void                    Push(Event *event);
+    void                    Remove(Event *event);
+
+    void                    Clear();
+
+private:
+    static bool             IsEarlier(const Event *a, const Event *b);
+    void                    Set(int index, Event *event);
+    void                    SiftUp(int index);
+    void                    SiftDown(int index);
+
+    Array<Event *>          heap;
 };
 
 class BE_API EventSystem {
 public:
-    static const int MaxEvents = 4096;
+    static const int EventBlockSize = 1024;
 
     static void             Init();
     static void             Shutdown();
@@ -101,18 +130,24 @@ public:
                             /// Cancels a event which is posted by sender in event queue
     static void             CancelEvents(const Object *sender, const EventDef *eventDef = nullptr);
 
+                            /// Returns number of scheduled events
+    static int              NumPendingEvents() { return eventQueue.Count() + guiEventQueue.Count(); }
+
     static void             ServiceEvents();
     static void             ServiceGuiEvents();
 
     static bool             initialized;
 
 private:
+    static void             AllocEventBlock();
     static void             ServiceEvent(Event *event);
+    static void             ServiceEventQueue(EventQueue &queue);
 
-    static Event            eventPool[MaxEvents];
+    static Array<Event *>   eventBlocks;        ///< Event pool grows by EventBlockSize events
     static LinkList<Event>  freeEvents;
-    static LinkList<Event>  eventQueue;
-    static LinkList<Event>  guiEventQueue;
+    static EventQueue       eventQueue;
+    static EventQueue       guiEventQueue;
+    static uint32_t         sequenceCounter;
 };
 
 BE_NAMESPACE_END
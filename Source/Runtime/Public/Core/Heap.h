@@ -19,6 +19,19 @@
 
     Heap memory management
 
+    Every block allocated by Mem_* functions carries a small header with its
+    size and memory tag, so current/peak bytes and allocation counts of each
+    subsystem are available in release builds too. Allocations are tagged by
+    the innermost MemTagScope of the calling thread.
+
+    Each thread counts its own allocated and freed bytes without locked
+    instructions, and the totals are folded when the stats are read. Peak bytes
+    are the highest current bytes seen at those points, Mem_UpdatePeaks() is
+    called every frame.
+
+    Call stacks of 1 in N allocations can be recorded with memSampling <N> to
+    find where the live memory of each tag comes from (memReport stacks).
+
 -------------------------------------------------------------------------------
 */
 
@@ -26,10 +39,67 @@ BE_NAMESPACE_BEGIN
 
 //#define DEBUG_MEMORY
 
+struct MemTag {
+    enum Enum {
+        General,
+        Image,
+        Texture,
+        Mesh,
+        Anim,
+        Sound,
+        Physics,
+        Lua,
+        FrameData,
+        Render,
+        Game,
+        File,
+        Count
+    };
+};
+
+struct MemTagStats {
+    int64_t             currentBytes;
+    int64_t             peakBytes;
+    int64_t             numLiveAllocs;
+    int64_t             numTotalAllocs;
+};
+
+                    /// Initializes console commands of memory reports. Allocations are tracked before calling this.
+void BE_API         Mem_Init();
+void BE_API         Mem_Shutdown();
+
+                    /// Returns the name of the memory tag.
+const char * BE_API Mem_TagName(MemTag::Enum tag);
+
+                    /// Sets the memory tag of the calling thread and returns the previous one.
+MemTag::Enum BE_API Mem_SetThreadTag(MemTag::Enum tag);
+
+                    /// Returns the memory tag of the calling thread.
+MemTag::Enum BE_API Mem_GetThreadTag();
+
+                    /// Gets the statistics of the memory tag. Peak bytes of the tag are updated with the current bytes.
+void BE_API         Mem_GetTagStats(MemTag::Enum tag, MemTagStats &stats);
+
+                    /// Updates peak bytes of all the memory tags with their current bytes.
+void BE_API         Mem_UpdatePeaks();
+
+                    /// Accounts memory allocated outside the heap (ex. GPU resources) to the memory tag.
+void BE_API         Mem_AddExternal(MemTag::Enum tag, size_t size);
+void BE_API         Mem_RemoveExternal(MemTag::Enum tag, size_t size);
+
+                    /// Records call stacks of 1 in sampleRate allocations. 0 disables sampling.
+void BE_API         Mem_SetSampleRate(int sampleRate);
+int BE_API          Mem_GetSampleRate();
+
+                    /// Logs current/peak usage of each memory tag sorted by current bytes.
+                    /// Call stacks of the sampled live allocations are logged if printStacks is true.
+void BE_API         Mem_Report(bool printStacks = false, int maxStacks = 20);
+
 #ifndef DEBUG_MEMORY
 
 void * BE_API       Mem_Alloc(size_t size);
 void * BE_API       Mem_ClearedAlloc(size_t size);
+void * BE_API       Mem_Realloc(void *ptr, size_t size);
 void * BE_API       Mem_Alloc16(size_t size);
 void * BE_API       Mem_Alloc32(size_t size);
 char * BE_API       Mem_AllocString(const char *str);
@@ -41,6 +111,7 @@ void BE_API         Mem_AlignedFree(void *ptr);
 
 void * BE_API       DebugMem_Alloc(size_t size, const char *filename, const int lineNumber);
 void * BE_API       DebugMem_ClearedAlloc(size_t size, const char *filename, const int lineNumber);
+void * BE_API       DebugMem_Realloc(void *ptr, size_t size, const char *filename, const int lineNumber);
 void * BE_API       DebugMem_Alloc16(size_t size, const char *filename, const int lineNumber);
 void * BE_API       DebugMem_Alloc32(size_t size, const char *filename, const int lineNumber);
 char * BE_API       DebugMem_AllocString(const char *str, const char *filename, const int lineNumber);
@@ -50,6 +121,7 @@ void BE_API         DebugMem_AlignedFree(void *ptr);
 
 #define Mem_Alloc(size)         DebugMem_Alloc(size, __FILE__, __LINE__)
 #define Mem_ClearedAlloc(size)  DebugMem_ClearedAlloc(size, __FILE__, __LINE__)
+#define Mem_Realloc(ptr, size)  DebugMem_Realloc(ptr, size, __FILE__, __LINE__)
 #define Mem_Alloc16(size)       DebugMem_Alloc16(size, __FILE__, __LINE__)
 #define Mem_Alloc32(size)       DebugMem_Alloc32(size, __FILE__, __LINE__)
 #define Mem_AllocString(s)      DebugMem_AllocString(s, __FILE__, __LINE__)
@@ -59,4 +131,14 @@ void BE_API         DebugMem_AlignedFree(void *ptr);
 
 #endif // DEBUG_MEMORY
 
+/// Tags the heap allocations of the calling thread in its lifetime.
+class MemTagScope {
+public:
+    MemTagScope(MemTag::Enum tag) : prevTag(Mem_SetThreadTag(tag)) {}
+    ~MemTagScope() { Mem_SetThreadTag(prevTag); }
+
+private:
+    MemTag::Enum        prevTag;
+};
+
 BE_NAMESPACE_END
@@ -0,0 +1,161 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Job System
+
+    Work-stealing job scheduler.
+
+    Every worker thread, and the thread that initialized the job system, owns
+    a lock-free deque of jobs. The owner pushes and pops jobs at the bottom of
+    its deque (LIFO), while idle threads steal jobs from the top of the other
+    deques (FIFO).
+
+    A job can be created as a child of another job. A parent job is finished
+    only after it and all of its children have finished. Continuations are jobs
+    that are run automatically when the job they are attached to is finished.
+
+    Wait() never blocks the calling thread. It executes pending jobs until the
+    given job is finished.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/Array.h"
+#include "Platform/PlatformThread.h"
+#include <atomic>
+
+BE_NAMESPACE_BEGIN
+
+struct Job;
+struct JobThreadData;
+
+typedef void (*jobFunction_t)(void *data);
+typedef void (*parallelForFunction_t)(int first, int last, void *data);
+
+/// Handle to a job.
+/// Stays safe to query after the job has been recycled, in which case the job is reported as finished.
+class JobHandle {
+    friend class JobSystem;
+
+public:
+    JobHandle() : job(nullptr), generation(0) {}
+
+    bool                    IsValid() const { return job != nullptr; }
+
+private:
+    Job *                   job;
+    uint32_t                generation;
+};
+
+class BE_API JobSystem {
+public:
+    enum {
+        MaxThreads          = 128,
+        MaxJobsPerThread    = 4096,     ///< Maximum number of unfinished jobs created by a single thread. Must be a power of two.
+        MaxContinuations    = 4,
+        JobPayloadSize      = 64
+    };
+
+    JobSystem();
+
+                            /// Initializes the job system. The calling thread becomes the main job thread (index 0).
+                            /// If numWorkerThreads is negative, one worker thread is created per logical processor except the calling one.
+    void                    Init(int numWorkerThreads = -1);
+    void                    Shutdown();
+
+    bool                    IsInitialized() const { return initialized; }
+
+                            /// Returns number of worker threads.
+    int                     NumWorkerThreads() const { return numThreads - 1; }
+
+                            /// Returns number of job threads including the main job thread.
+    int                     NumThreads() const { return numThreads; }
+
+                            /// Returns index of the calling thread, -1 if the calling thread is not a job thread.
+    int                     GetCurrentThreadIndex() const;
+
+                            /// Creates a job. The job is not scheduled until Run() is called.
+    JobHandle               CreateJob(jobFunction_t function, void *data);
+
+                            /// Creates a job as a child of parent. The parent will not be finished until this job is finished.
+                            /// Must be called before the parent is finished.
+    JobHandle               CreateChildJob(const JobHandle &parent, jobFunction_t function, void *data);
+
+                            /// Runs continuation when ancestor is finished.
+                            /// Must be called before the ancestor is run. Returns false if there is no room for a continuation.
+    bool                    AddContinuation(const JobHandle &ancestor, const JobHandle &continuation);
+
+                            /// Schedules a job to be executed.
+                            /// Jobs run from a thread that is not a job thread are executed immediately.
+    void                    Run(const JobHandle &handle);
+
+                            /// Executes pending jobs until the given job is finished.
+    void                    Wait(const JobHandle &handle);
+
+                            /// Returns true if the given job and all of its children are finished.
+    bool                    IsFinished(const JobHandle &handle) const;
+
+                            /// Creates a job that calls function over [0, count) in parallel, split into ranges no smaller than granularity.
+                            /// The job is not scheduled until Run() is called.
+    JobHandle               CreateParallelForJob(int count, int granularity, parallelForFunction_t function, void *data);
+
+                            /// Calls function over [0, count) in parallel and waits until it is finished.
+    void                    ParallelFor(int count, int granularity, parallelForFunction_t function, void *data);
+
+                            /// Calls func(first, last) over [0, count) in parallel and waits until it is finished.
+    template <typename Func>
+    void                    ParallelFor(int count, int granularity, const Func &func);
+
+private:
+    Job *                   AllocateJob();
+    Job *                   GetJob();
+    void                    Execute(Job *job);
+    void                    Finish(Job *job);
+    void                    WakeUpWorkers();
+
+    static void             ParallelForJob(void *data);
+    static void             WorkerThreadProc(void *param);
+
+    bool                    initialized;
+    int                     numThreads;
+    JobThreadData *         threadData;
+    JobThreadData *         foreignThreadData;      ///< Job pool for threads that are not job threads
+    Array<PlatformThread *> workerThreads;
+
+    std::atomic<int32_t>    numQueuedJobs;          ///< Number of jobs waiting in the queues
+    std::atomic<int32_t>    numSleepingWorkers;
+
+    std::atomic<bool>       terminate;
+    PlatformMutex *         sleepMutex;
+    PlatformCondition *     sleepCondition;
+};
+
+template <typename Func>
+BE_INLINE void JobSystem::ParallelFor(int count, int granularity, const Func &func) {
+    struct Local {
+        static void Call(int first, int last, void *data) {
+            (*(const Func *)data)(first, last);
+        }
+    };
+    ParallelFor(count, granularity, Local::Call, (void *)&func);
+}
+
+extern JobSystem            jobSystem;
+
+BE_NAMESPACE_END
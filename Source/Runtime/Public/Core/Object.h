@@ -30,6 +30,7 @@
 #include "Event.h"
 #include "Property.h"
 #include "Serializable.h"
+#include <atomic>
 
 BE_NAMESPACE_BEGIN
 
@@ -144,6 +145,11 @@ public:
                                 /// Returns property info list including parent meta object.
     void                        GetPropertyInfoList(Array<PropertyInfo> &propertyInfoList) const;
 
+                                /// Returns flattened property info table including parent meta object.
+                                /// Tables are built by Object::InitPropertyInfoTables(), and rebuilt on next use if a property is registered afterwards.
+                                /// Safe to call from multiple threads, but registering properties is not.
+    const PropertyInfoTable &   GetPropertyInfoTable() const;
+
                                 /// 
     PropertyInfo &              RegisterProperty(const PropertyInfo &propertyInfo);
 
@@ -162,12 +168,17 @@ private:
     Array<PropertyInfo>         propertyInfoList;
     HashIndex                   propertyInfoHash;
 
+    mutable PropertyInfoTable   propertyInfoTable;  // flattened property infos of this and super classes
+    mutable std::atomic<int>    propertyInfoTableVersion;
+
     EventInfo<Object> *         eventMap;
     EventCallback *             eventCallbacks;
     bool                        freeEventCallbacks;
 };
 
 class BE_API Object : public Serializable {
+    friend class EventSystem;
+
 public:
     ABSTRACT_PROTOTYPE(Object);
 
@@ -225,12 +236,16 @@ public:
                                 /// Cancels a event in event queue.
     void                        CancelEvents(const EventDef *evdef);
 
-                                /// Gets full list of property info.
-    virtual void                GetPropertyInfoList(Array<PropertyInfo> &propertyInfoList) const { GetMetaObject()->GetPropertyInfoList(propertyInfoList); }
+                                /// Gets flattened property info table.
+    virtual const PropertyInfoTable &GetPropertyInfoTable() const override { return GetMetaObject()->GetPropertyInfoTable(); }
     
     static void                 Init();
     static void                 Shutdown();
 
+                                /// Builds flattened property info tables of all the meta objects.
+                                /// Should be called after all the properties are registered.
+    static void                 InitPropertyInfoTables();
+
                                 /// Finds meta object with the given name.
     static MetaObject *         FindMetaObject(const char *name);
 
@@ -256,6 +271,7 @@ private:
 
     Guid                        guid;
     int                         instanceID;
+    LinkList<Event>             pendingEvents;  // events posted by this object
 
     static bool                 initialized;
     static Array<MetaObject *>  types;          // in alphabetical order
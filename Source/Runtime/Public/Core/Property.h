@@ -21,6 +21,7 @@
 #include "Core/Range.h"
 #include "Core/Variant.h"
 #include "Containers/StrArray.h"
+#include "Containers/HashIndex.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -147,6 +148,72 @@ BE_INLINE PropertyInfo::PropertyInfo(const char *_name, const char *_label, Vari
     flags(_flags) {
 }
 
+/// Flattened list of property infos with hashed name lookup.
+/// Property names are unique in the table, and the first one appended wins.
+class BE_API PropertyInfoTable {
+public:
+    PropertyInfoTable() : nameHash(64, 64) {}
+
+                            /// Returns number of property infos.
+    int                     Count() const { return infos.Count(); }
+
+                            /// Returns property info by index.
+    const PropertyInfo &    operator[](int index) const { return infos[index]; }
+
+                            /// Returns all the property infos.
+    const Array<PropertyInfo> &GetList() const { return infos; }
+
+                            /// Returns index of the property info with the given name. Returns -1 if not found.
+    int                     FindIndex(const char *name) const;
+
+                            /// Returns property info with the given name. Returns nullptr if not found.
+    const PropertyInfo *    Find(const char *name) const;
+
+                            /// Appends property info. Returns false if the name is already in the table.
+    bool                    Append(const PropertyInfo &propInfo);
+
+                            /// Removes all the property infos.
+    void                    Clear();
+
+private:
+    Array<PropertyInfo>     infos;
+    HashIndex               nameHash;
+};
+
+BE_INLINE int PropertyInfoTable::FindIndex(const char *name) const {
+    if (!name || !name[0]) {
+        return -1;
+    }
+
+    int hash = nameHash.GenerateHash(name, false);
+    for (int i = nameHash.First(hash); i != -1; i = nameHash.Next(i)) {
+        if (!Str::Cmp(infos[i].GetName(), name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+BE_INLINE const PropertyInfo *PropertyInfoTable::Find(const char *name) const {
+    int index = FindIndex(name);
+    return index >= 0 ? &infos[index] : nullptr;
+}
+
+BE_INLINE bool PropertyInfoTable::Append(const PropertyInfo &propInfo) {
+    if (FindIndex(propInfo.GetName()) >= 0) {
+        return false;
+    }
+
+    int index = infos.Append(propInfo);
+    nameHash.Add(nameHash.GenerateHash(propInfo.GetName(), false), index);
+    return true;
+}
+
+BE_INLINE void PropertyInfoTable::Clear() {
+    infos.Clear();
+    nameHash.Clear();
+}
+
 /// Property type trait (default use const reference for object type).
 template <typename T, typename = void>
 struct PropertyTrait {
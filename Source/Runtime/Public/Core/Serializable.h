@@ -15,28 +15,48 @@
 #pragma once
 
 #include "jsoncpp/include/json/json.h"
+#include "Containers/HashTable.h"
 #include "Variant.h"
 #include "Signal.h"
 
 BE_NAMESPACE_BEGIN
 
 class PropertyInfo;
+class PropertyInfoTable;
+class BinarySerializer;
+class BinaryObject;
 
 /// Interface for objects with automatic serialization through properties.
 class BE_API Serializable : public SignalObject {
 public:
+                            /// Finds property info by name. Returns nullptr if not found.
+    const PropertyInfo *    FindPropertyInfo(const char *name) const;
+                            /// Finds property info by index. Returns nullptr if not found.
+    const PropertyInfo *    FindPropertyInfo(int index) const;
                             /// Gets property info by name. Returns false if not found.
     bool                    GetPropertyInfo(const char *name, PropertyInfo &propertyInfo) const;
                             /// Gets property info by index. Returns false if not found.
     bool                    GetPropertyInfo(int index, PropertyInfo &propertyInfo) const;
                             /// Gets property info array.
-    virtual void            GetPropertyInfoList(Array<PropertyInfo> &propertyInfoList) const = 0;
+    void                    GetPropertyInfoList(Array<PropertyInfo> &propertyInfoList) const;
+                            /// Returns flattened property info table.
+                            /// The table must not be changed while (de)serializing.
+    virtual const PropertyInfoTable &GetPropertyInfoTable() const = 0;
 
                             /// Serialize to JSON value.
     virtual void            Serialize(Json::Value &out) const;
                             /// Deserialize from JSON value.
     virtual void            Deserialize(const Json::Value &in);
 
+                            /// Serialize properties into the current object of binary serializer.
+    virtual void            SerializeBinary(BinarySerializer &out) const;
+                            /// Deserialize from binary object.
+    virtual void            DeserializeBinary(const BinaryObject &in);
+
+                            /// Copies property values from the source object of the same class without serialization.
+                            /// GUID values found in remapGuidMap are replaced by the mapped ones.
+    virtual void            CopyProperties(const Serializable &source, const HashTable<Guid, Guid> *remapGuidMap = nullptr);
+
                             /// Returns a property default value by name. Returns empty variant if not found.
     Variant                 GetPropertyDefault(const char *name) const;
                             /// Returns a property default value by index. Returns empty variant if not found.
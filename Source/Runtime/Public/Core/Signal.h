@@ -63,21 +63,23 @@ class BE_API Signal {
     friend class SignalSystem;
 
 public:
+    Signal() = default;
     ~Signal();
     
     byte *                  GetData() { return data; }
 
 private:
-    const SignalDef *       signalDef;
-    byte *                  data;
-    SignalObject *          receiver;
-    SignalCallback          callback;
-    LinkList<Signal>        node;
+    const SignalDef *       signalDef = nullptr;
+    byte *                  data = nullptr;
+    SignalObject *          receiver = nullptr;
+    SignalCallback          callback = nullptr;
+    LinkList<Signal>        node;               ///< Node in the signal queue or the free signal list
+    LinkList<Signal>        receiverNode;       ///< Node in the pending signal list of the receiver
 };
 
 class BE_API SignalSystem {
 public:
-    static const int MaxSignals = 4096;
+    static const int SignalBlockSize = 1024;
 
     static void             Init();
     static void             Shutdown();
@@ -85,10 +87,10 @@ public:
     static void             Clear();
 
                             /// Create a new signal with the given signal def and arguments
-    static Signal *         AllocSignal(const SignalDef *signalDef, const SignalCallback callback, int numArgs, va_list args);
+    static Signal *         AllocSignal(const SignalDef *signalDef, const SignalCallback callback, int numArgs, const VariantArg *args);
     static void             FreeSignal(Signal *signal);
 
-    static void             CopyArgPtrs(const SignalDef *signalDef, int numArgs, va_list args, intptr_t data[EventDef::MaxArgs]);
+    static void             CopyArgPtrs(const SignalDef *signalDef, int numArgs, const VariantArg *args, intptr_t data[EventDef::MaxArgs]);
 
     static void             ScheduleSignal(Signal *signal, SignalObject *receiver);
 
@@ -100,7 +102,9 @@ public:
     static bool             initialized;
 
 private:
-    static Signal           signalPool[MaxSignals];
+    static void             AllocSignalBlock();
+
+    static Array<Signal *>  signalBlocks;       ///< Signal pool grows by SignalBlockSize signals
     static LinkList<Signal> freeSignals;
     static LinkList<Signal> signalQueue;
 };
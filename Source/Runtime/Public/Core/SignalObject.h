@@ -15,6 +15,7 @@
 #pragma once
 
 #include "Containers/Array.h"
+#include "Containers/LinkList.h"
 #include "VariantArg.h"
 
 BE_NAMESPACE_BEGIN
@@ -62,6 +63,8 @@ public:
                                 /// Emits a signal
     template <typename... Args>
     bool                        EmitSignal(const SignalDef *sigdef, Args&&... args);
+                                /// Emits a signal without arguments
+    bool                        EmitSignal(const SignalDef *sigdef);
         
                                 /// Tests if all signals are blocked on this object
     bool                        SignalsBlocked() const { return signalBlocked; }
@@ -69,9 +72,6 @@ public:
     bool                        BlockSignals(bool block);
 
 private:
-    bool                        ExecuteCallback(const SignalCallback &callback, const SignalDef *sigdef, intptr_t *data);
-    bool                        EmitSignalArgs(const SignalDef *sigdef, int numArgs, ...);
-
     struct Connection {
         const SignalDef *       signalDef;
         int                     connectionType;
@@ -79,9 +79,21 @@ private:
         SignalObject *          receiver;
         SignalCallback          function;
     };
-    
+
+    /// Connections of the same signal def
+    struct ConnectionList {
+        const SignalDef *       signalDef;
+        Array<Connection *>     connections;
+    };
+
+    bool                        ExecuteCallback(const SignalCallback &callback, const SignalDef *sigdef, intptr_t *data);
+    bool                        EmitSignalArgs(const SignalDef *sigdef, int numArgs, const VariantArg *args);
+    int                         FindPublications(const SignalDef *sigdef) const;
+    void                        RemovePublication(int listIndex, int connectionIndex);
+
     Array<Connection *>         subscriptions;
-    Array<Connection *>         publications;
+    Array<ConnectionList>       publications;       ///< Connections bucketed by signal def. Lists are not removed even if they become empty
+    LinkList<Signal>            pendingSignals;     ///< Queued signals to be received
     bool                        signalBlocked;
 };
 
@@ -92,7 +104,19 @@ BE_INLINE SignalObject::SignalObject() {
 template <typename... Args>
 BE_INLINE bool SignalObject::EmitSignal(const SignalDef *sigdef, Args&&... args) {
     static_assert(is_assignable_all<VariantArg, Args...>::value, "args is not assignable to VariantArg");
-    return EmitSignalArgs(sigdef, sizeof...(args), address_of(VariantArg(std::forward<Args>(args)))...);
+    // Early exit before packing arguments
+    if (publications.Count() == 0) {
+        return !signalBlocked;
+    }
+    const VariantArg argArray[] = { VariantArg(std::forward<Args>(args))... };
+    return EmitSignalArgs(sigdef, sizeof...(args), argArray);
+}
+
+BE_INLINE bool SignalObject::EmitSignal(const SignalDef *sigdef) {
+    if (publications.Count() == 0) {
+        return !signalBlocked;
+    }
+    return EmitSignalArgs(sigdef, 0, nullptr);
 }
 
 BE_NAMESPACE_END
@@ -311,7 +311,7 @@ BE_INLINE Variant &Variant::operator=(float rhs) {
 
 BE_INLINE Variant &Variant::operator=(double rhs) {
     SetType(Type::DoubleType);
-    value.f1 = rhs;
+    value.d1 = rhs;
     return *this;
 }
 
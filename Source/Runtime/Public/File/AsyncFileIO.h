@@ -0,0 +1,181 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Asynchronous file I/O
+
+    Read requests are queued and served by a small pool of I/O threads.
+    Requests are picked by priority (FIFO within the same priority) and a
+    request can be cancelled or reprioritized until its read begins.
+
+    An I/O thread extends the request it picks with the pending requests that
+    follow it in the same file, or in the same archive, and reads them as one
+    batch through a single open file. The total size of the requests that have
+    been started but not yet delivered is capped, and the read bandwidth can
+    be limited.
+
+    Completion callbacks are only called from DispatchCompletions(), on the
+    thread that initialized the system, once per frame.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/Array.h"
+#include "Platform/PlatformThread.h"
+
+BE_NAMESPACE_BEGIN
+
+struct AsyncIORequest;
+
+struct AsyncIOPriority {
+    enum Enum {
+        Low,
+        Normal,
+        High,
+        Critical
+    };
+};
+
+struct AsyncIOStatus {
+    enum Enum {
+        Pending,
+        InFlight,
+        Completed,
+        Failed,
+        Cancelled
+    };
+};
+
+/// Handle to an async read request.
+/// Stays safe to query after the request has been delivered, in which case the request is reported as finished.
+class AsyncIOHandle {
+    friend class AsyncFileIO;
+
+public:
+    AsyncIOHandle() : request(nullptr), generation(0) {}
+
+    bool                    IsValid() const { return request != nullptr; }
+
+private:
+    AsyncIORequest *        request;
+    uint32_t                generation;
+};
+
+struct AsyncIOResult {
+                            /// Takes ownership of the data allocated by the I/O system. The data must be freed with Mem_Free().
+                            /// Otherwise the data is freed after the callback returns.
+    void *                  DetachData() { ownsData = false; return data; }
+
+    AsyncIOHandle           handle;
+    const char *            filename;
+    AsyncIOStatus::Enum     status;         ///< Completed, Failed or Cancelled
+    void *                  data;           ///< Caller's buffer or the buffer allocated by the I/O system (null terminated)
+    size_t                  size;
+    bool                    ownsData;
+};
+
+typedef void (*asyncIOCallback_t)(AsyncIOResult &result, void *userData);
+
+class BE_API AsyncFileIO {
+public:
+    enum {
+        MaxThreads          = 8,
+        MaxBatchRequests    = 64,
+        MaxBatchSize        = 8 * 1024 * 1024,
+        MaxCoalesceGap      = 64 * 1024,        ///< Largest gap between two entries of an archive read in the same batch
+        ReadChunkSize       = 1024 * 1024       ///< Cancellation is checked between chunks
+    };
+
+    AsyncFileIO();
+
+                            /// Initializes the I/O threads. The calling thread is the one that receives completions.
+    void                    Init(int numThreads = 2);
+    void                    Shutdown();
+
+    bool                    IsInitialized() const { return initialized; }
+
+                            /// Queues a read of size bytes at offset in the file. If size is 0, reads to the end of the file.
+                            /// If buffer is nullptr, a buffer is allocated by the I/O system.
+                            /// The file is found in the search paths the same way as FileSystem::OpenFileRead does.
+    AsyncIOHandle           Read(const char *filename, uint64_t offset, size_t size, void *buffer, AsyncIOPriority::Enum priority, asyncIOCallback_t callback, void *userData);
+
+                            /// Queues a read of the whole file.
+    AsyncIOHandle           ReadFile(const char *filename, AsyncIOPriority::Enum priority, asyncIOCallback_t callback, void *userData);
+
+                            /// Cancels the request. The callback is still called, with the Cancelled status.
+                            /// A read in flight stops at the next chunk. Returns false if the request is already delivered.
+    bool                    Cancel(const AsyncIOHandle &handle);
+
+                            /// Changes the priority of a request that has not started yet.
+    bool                    SetPriority(const AsyncIOHandle &handle, AsyncIOPriority::Enum priority);
+
+                            /// Returns true if the read is done, or the request is already delivered.
+    bool                    IsFinished(const AsyncIOHandle &handle) const;
+
+                            /// Blocks until the read is done. The request is raised to the highest priority while waiting.
+                            /// Called from the completion thread, the callback is called before returning.
+    void                    Wait(const AsyncIOHandle &handle);
+
+                            /// Calls the callbacks of finished requests. Must be called from the thread that initialized the system.
+    void                    DispatchCompletions();
+
+                            /// Limits the bytes of the requests that are read or being read but not delivered yet, 0 for no limit.
+                            /// A request bigger than the limit is still read when nothing else is outstanding.
+    void                    SetMaxOutstandingBytes(size_t bytes);
+                            /// Limits the read bandwidth in bytes per second, 0 for no limit.
+    void                    SetBandwidthLimit(size_t bytesPerSecond);
+
+    int                     NumPendingRequests() const;
+    size_t                  GetOutstandingBytes() const;
+
+private:
+    AsyncIORequest *        AllocRequest();
+    void                    FreeRequest(AsyncIORequest *request);
+    AsyncIORequest *        GetRequest(const AsyncIOHandle &handle) const;
+    AsyncIORequest *        PickRequest() const;
+    void                    BuildBatch(AsyncIORequest *head, Array<AsyncIORequest *> &batch);
+    void                    ResolveRequests();
+    void                    ProcessBatch(const Array<AsyncIORequest *> &batch);
+    void                    Deliver(AsyncIORequest *request);
+
+    static void             IOThreadProc(void *param);
+
+    bool                    initialized;
+    bool                    terminate;
+    uint64_t                sequence;
+
+    Array<AsyncIORequest *> pendingRequests;
+    Array<AsyncIORequest *> finishedRequests;       ///< Requests waiting to be delivered
+    Array<AsyncIORequest *> freeRequests;
+    Array<AsyncIORequest *> allRequests;
+
+    size_t                  outstandingBytes;
+    size_t                  maxOutstandingBytes;
+    size_t                  bandwidthLimit;
+    uint64_t                throttleTime;           ///< Time in microseconds until which the read bandwidth is already used
+
+    PlatformMutex *         mutex;
+    PlatformCondition *     requestCondition;       ///< Signaled when requests are queued or outstanding bytes are released
+    PlatformCondition *     finishCondition;        ///< Signaled when reads are done
+    Array<PlatformThread *> ioThreads;
+};
+
+extern AsyncFileIO          asyncFileIO;
+
+BE_NAMESPACE_END
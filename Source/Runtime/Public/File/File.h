@@ -111,11 +111,14 @@ protected:
     size_t                  size;
 };
 
+/// File entry in a ZIP archive. Reads directly from the memory mapped archive data,
+/// deflated entries are inflated with a stream owned by this file so entries can be read concurrently.
+/// CRC-32 of deflated entries is checked when the end of the entry is inflated.
 class BE_API FileInZip : public File {
     friend class FileSystem;
     
 public:
-    FileInZip(const char *filename, void *pointer);
+    FileInZip(const char *filename, const byte *data, size_t compressedSize, size_t size, bool deflated, uint32_t expectedChecksum);
     virtual ~FileInZip();
     
     virtual const char *    GetFilePath() const override { return filename; }
@@ -134,9 +137,17 @@ public:
     virtual bool            Write(const void *buffer, size_t bytesToWrite) override;
     
 protected:
+    bool                    ResetStream() const;
+
     char                    filename[MaxAbsolutePath];
-    void *                  pointer;
+    const byte *            data;               ///< Stored or compressed data in the archive mapping
+    size_t                  compressedSize;
     size_t                  size;
+    bool                    deflated;
+    mutable size_t          offset;             ///< Uncompressed read offset
+    mutable void *          stream;             ///< z_stream for deflated entries, created on first read
+    uint32_t                expectedChecksum;   ///< CRC-32 of the uncompressed data in the central directory
+    mutable uint32_t        checksum;           ///< CRC-32 of the data inflated so far
 };
 
 BE_NAMESPACE_END
@@ -28,7 +28,15 @@
 BE_NAMESPACE_BEGIN
 
 class CmdArgs;
-struct ZipArchive;
+class ZipArchive;
+
+/// Where a file is read from.
+struct FileLocation {
+    const ZipArchive *  archive;        ///< Archive containing the file, nullptr if the file is on disk
+    int                 entryIndex;     ///< Entry index in the archive
+    Str                 path;           ///< Path of the file on disk
+    size_t              size;
+};
 
 struct ProgressCallback {
     virtual void        SetText(const char *text) = 0;
@@ -88,12 +96,19 @@ public:
         
     File *              OpenFile(const char *filename, File::Mode mode, bool searchDirs = true);
     File *              OpenFileRead(const char *filename, bool useSearchPath, size_t *fileSize = nullptr);
+                        /// Finds where OpenFileRead would read the file from, without opening it.
+    bool                LocateFile(const char *filename, bool useSearchPath, FileLocation &location) const;
     File *              OpenFileWrite(const char *filename);
     File *              OpenFileAppend(const char *filename);
     void                CloseFile(File *f);
 
     size_t              LoadFile(const char *filename, bool searchDirs, void **buffer);
     void                FreeFile(void *buffer) const;
+
+                        /// Like LoadFile, but returns a pointer into the archive mapping for entries stored without compression.
+                        /// The data must be released with UnmapFile.
+    size_t              MapFile(const char *filename, bool searchDirs, const void **data);
+    void                UnmapFile(const void *data) const;
     
     void                WriteFile(const char *filename, const void *buffer, int size);
 
@@ -0,0 +1,101 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    ZIP archive reader
+
+    The central directory is parsed once into a hashed index of the entries.
+    The archive is memory mapped and every opened entry reads (or inflates)
+    its own range of the mapping, so any number of threads can read from the
+    same archive concurrently. Stored entries are not copied at all.
+
+    CRC-32 is checked for deflated entries only, while they are inflated.
+    Stored entries are used in place of the mapping without a pass over the
+    data, and checking them would add that pass to every load.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/Array.h"
+#include "Containers/HashIndex.h"
+#include "File/FileMapping.h"
+
+BE_NAMESPACE_BEGIN
+
+class File;
+
+struct ZipEntry {
+    enum Method {
+        Stored              = 0,
+        Deflated            = 8
+    };
+
+    Str                     name;
+    uint64_t                localHeaderOffset;
+    uint64_t                compressedSize;
+    uint64_t                uncompressedSize;
+    uint32_t                crc32;
+    int                     method;
+};
+
+class BE_API ZipArchive {
+public:
+    ZipArchive() = default;
+    ~ZipArchive();
+
+                            /// Maps the archive and reads the central directory.
+    bool                    Open(const char *filename);
+    void                    Close();
+
+    const char *            GetName() const { return name; }
+
+    int                     NumEntries() const { return entries.Count(); }
+    const ZipEntry &        GetEntry(int index) const { return entries[index]; }
+
+                            /// Returns the entry index with the given name (case insensitive), -1 if not found.
+    int                     FindEntry(const char *entryName) const;
+
+                            /// Returns pointer to the stored or compressed data of the entry in the mapping.
+                            /// Returns nullptr if the local header is corrupted.
+    const byte *            GetEntryData(int index) const;
+
+                            /// Opens the entry for reading. Safe to call from any thread.
+    File *                  OpenEntry(int index, const char *filename) const;
+
+                            /// Returns true if the pointer is inside the mapping of this archive.
+    bool                    IsMappedData(const void *ptr) const;
+
+private:
+    bool                    ReadCentralDirectory();
+
+    Str                     name;
+    FileMapping             mapping;
+    Array<ZipEntry>         entries;
+    HashIndex               entryHash;
+};
+
+BE_INLINE ZipArchive::~ZipArchive() {
+    Close();
+}
+
+BE_INLINE bool ZipArchive::IsMappedData(const void *ptr) const {
+    const char *base = mapping.GetData();
+    return base && (const char *)ptr >= base && (const char *)ptr < base + mapping.GetSize();
+}
+
+BE_NAMESPACE_END
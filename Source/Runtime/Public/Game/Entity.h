@@ -34,6 +34,9 @@ class ComTransform;
 class GameWorld;
 class Prefab;
 class Entity;
+class EntityPool;
+class BinarySerializer;
+class BinaryObject;
 
 using EntityPtr = Entity*;
 using EntityPtrArray = Array<EntityPtr>;
@@ -44,6 +47,7 @@ class Entity : public Object {
     friend class GameEdit;
     friend class Prefab;
     friend class Component;
+    friend class EntityPool;
 
 public:
     enum WorldPosTrait {
@@ -95,6 +99,9 @@ public:
 
     int                         GetEntityNum() const { return entityNum; }
 
+                                /// Returns true if this entity is recycled by an entity pool.
+    bool                        IsPooled() const { return pool != nullptr; }
+
                                 /// Returns hierarchy node.
     const Hierarchy<Entity> &   GetNode() const { return node; }
 
@@ -194,6 +201,13 @@ public:
                                 /// Serializes given entity hierarchy to JSON value.
     static void                 SerializeHierarchy(const Entity *entity, Json::Value &entitiesValue);
 
+                                /// Serializes entity to binary serializer.
+    virtual void                SerializeBinary(BinarySerializer &out) const override;
+                                /// Deserializes entity from binary object.
+    virtual void                DeserializeBinary(const BinaryObject &in) override;
+                                /// Serializes given entity hierarchy as indexed objects of the current object property.
+    static void                 SerializeHierarchyBinary(const Entity *entity, BinarySerializer &out);
+
                                 /// Returns if this entity is active. 
                                 /// Note that an entity may be inactive because a parent is not active, even if this returns true.
                                 /// Use IsActiveInHierarchy() if you want to check if the entity is actually treated as active in the scene.
@@ -217,8 +231,18 @@ public:
                                 /// Ray cast to this entity.
     bool                        RayIntersection(const Vec3 &start, const Vec3 &dir, bool backFaceCull, float &lastScale) const;
 
+                                /// Marks world bounds used by the spatial queries of the game world to be updated.
+                                /// Called when the transform or the bounds of the components are changed.
+    void                        InvalidateQueryBounds();
+
                                 /// Creates an entity by JSON text.
     static Entity *             CreateEntity(Json::Value &data, GameWorld *gameWorld = nullptr, int sceneIndex = 0);
+                                /// Creates an entity by binary object.
+    static Entity *             CreateEntity(const BinaryObject &object, GameWorld *gameWorld = nullptr, int sceneIndex = 0);
+                                /// Creates an entity by copying properties and components of the source entity.
+                                /// GUIDs of the new entity and components are taken from remapGuidMap with the source GUIDs,
+                                /// and GUID references found in remapGuidMap are replaced.
+    static Entity *             CreateEntity(const Entity *sourceEntity, const HashTable<Guid, Guid> &remapGuidMap, GameWorld *gameWorld = nullptr, int sceneIndex = 0);
 
                                 /// Makes copy of JSON value of an entity and then replace each GUIDs of entity/components to the new ones.
     static Json::Value          CloneEntityValue(const Json::Value &entityValue, HashTable<Guid, Guid> &oldToNewGuidMap);
@@ -273,6 +297,12 @@ protected:
 
     GameWorld *                 gameWorld;
     int                         sceneIndex = -1;
+    EntityPool *                pool = nullptr;     ///< Entity pool that recycles this entity
+    int                         poolFreeIndex = -1; ///< Index in the free entities of the pool, -1 if not free
+
+    AABB                        queryBounds;        ///< World bounds in GameWorld::entityDbvt
+    int32_t                     queryProxyId = -1;  ///< Proxy id in GameWorld::entityDbvt
+    bool                        queryBoundsInvalidated = false;
 
     ComponentPtrArray           components;         ///< 0'th component is always transform component
 };
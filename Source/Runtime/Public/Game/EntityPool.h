@@ -0,0 +1,73 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Entity Pool
+
+    Recycles copies of an original entity (usually a prefab). Pooled entities
+    are instantiated and registered once, and stay registered while they are
+    free. Releasing deactivates the entity instead of destroying it, so render
+    objects are just hidden, rigid bodies are just removed from the physics
+    world and script sandboxes are kept alive.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "EntityTemplate.h"
+
+BE_NAMESPACE_BEGIN
+
+class GameWorld;
+
+class BE_API EntityPool {
+public:
+    EntityPool(GameWorld *gameWorld, const Entity *originalEntity, int sceneIndex);
+    ~EntityPool();
+
+    const Guid &                GetOriginalGuid() const { return originalGuid; }
+
+                                /// Returns number of entities created by this pool including acquired ones.
+    int                         NumEntities() const { return entities.Count(); }
+
+                                /// Returns number of entities ready to be acquired.
+    int                         NumFreeEntities() const { return freeEntities.Count(); }
+
+                                /// Pre-instantiates inactive entities until at least 'count' entities are free.
+    void                        WarmUp(int count);
+
+                                /// Activates a free entity with the given transform. Pool is grown if there is no free entity.
+    Entity *                    Acquire(const Vec3 &origin, const Quat &rotation);
+
+                                /// Deactivates the entity and puts it back to the free list.
+    void                        Release(Entity *entity);
+
+                                /// Called when a pooled entity is unregistered from the game world.
+    void                        Forget(Entity *entity);
+
+private:
+    bool                        Grow(int count);
+
+    GameWorld *                 gameWorld;
+    int                         sceneIndex;
+    Guid                        originalGuid;
+    EntityTemplate              entityTemplate;
+    EntityPtrArray              entities;           ///< All the root entities created by this pool
+    EntityPtrArray              freeEntities;
+};
+
+BE_NAMESPACE_END
@@ -0,0 +1,74 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Entity Template
+
+    Cached source entity hierarchy (usually a prefab) to stamp out copies
+    without serialization. Property values are copied object to object, and
+    GUID references between the source entities are remapped to the copies
+    with the table prebuilt in Init().
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/HashTable.h"
+#include "Entity.h"
+
+BE_NAMESPACE_BEGIN
+
+class GameWorld;
+
+class BE_API EntityTemplate {
+public:
+    EntityTemplate() {}
+    explicit EntityTemplate(const Entity *rootEntity) { Init(rootEntity); }
+
+                                /// Caches the given entity and its descendants.
+                                /// Source entities must stay alive while this template is used, and
+                                /// this should be initialized again if the source hierarchy changed.
+    void                        Init(const Entity *rootEntity);
+
+    void                        Clear();
+
+    bool                        IsValid() const { return sourceEntities.Count() > 0; }
+
+                                /// Returns the root source entity.
+    const Entity *              GetRootEntity() const { return sourceEntities.Count() > 0 ? sourceEntities[0] : nullptr; }
+
+                                /// Returns number of entities in the source hierarchy.
+    int                         NumEntities() const { return sourceEntities.Count(); }
+
+                                /// Creates uninitialized copies of the source entities in the same order as the source.
+                                /// Not thread safe, the GUID table is reused for each copy.
+    void                        CreateEntities(GameWorld *gameWorld, int sceneIndex, EntityPtrArray &entities) const;
+
+                                /// Creates initialized copy of the source hierarchy and returns the root entity of it.
+                                /// Copies are not registered to the game world.
+    Entity *                    Instantiate(GameWorld *gameWorld, int sceneIndex) const;
+
+private:
+    void                        GenerateGuids() const;
+    Entity *                    CreateEntity(int entityIndex, GameWorld *gameWorld, int sceneIndex) const;
+
+    Array<const Entity *>       sourceEntities;     ///< Root entity and the descendants in depth-first order
+    Array<Guid>                 sourceGuids;        ///< GUIDs of the source entities and components
+    mutable HashTable<Guid, Guid> guidMap;          ///< Source GUID to the GUID of the latest copy
+};
+
+BE_NAMESPACE_END
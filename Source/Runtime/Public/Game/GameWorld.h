@@ -23,7 +23,9 @@
 */
 
 #include "Containers/StaticArray.h"
+#include "Core/DynamicAABBTree.h"
 #include "Entity.h"
+#include "TransformSystem.h"
 #include "Scripting/LuaVM.h"
 
 BE_NAMESPACE_BEGIN
@@ -37,6 +39,10 @@ class PhysicsSettings;
 class MapRenderSettings;
 class PlayerSettings;
 class GameWorld;
+class EntityTemplate;
+class EntityPool;
+class BinaryObject;
+class BinaryDeserializer;
 
 struct GameScene {
     Hierarchy<Entity>           root;
@@ -44,6 +50,7 @@ struct GameScene {
 
 class GameWorld : public Object {
     friend class GameEdit;
+    friend class EntityPool;
 
 public:
     enum {
@@ -61,6 +68,11 @@ public:
         Editor
     };
 
+    struct EntityPoolSetting {
+        Str                     prefabFilename;     ///< Prefab to be pooled
+        int                     warmUpCount;        ///< Number of entities pre-instantiated when map loaded
+    };
+
     OBJECT_PROTOTYPE(GameWorld);
 
     GameWorld();
@@ -73,6 +85,13 @@ public:
 
     LuaVM &                     GetLuaVM() { return luaVM; }
 
+    TransformSystem *           GetTransformSystem() { return &transformSystem; }
+
+                                /// Returns true if world matrices of the transforms are updated in batch once per frame.
+    bool                        IsBatchedTransformsEnabled() const { return transformSystem.IsEnabled(); }
+                                /// Enables or disables batched world matrix update for all the transforms.
+    void                        SetBatchedTransformsEnabled(bool enable);
+
     Random &                    GetRandom() { return random; }
 
     void                        SetDebuggable(bool isDebuggable) { this->isDebuggable = isDebuggable; }
@@ -101,6 +120,14 @@ public:
                                 /// Ray intersection test for all entities.
     Entity *                    RayIntersection(const Vec3 &start, const Vec3 &dir, int layerMask, const Array<Entity *> &excludingList, float *scale) const;
 
+                                /// Returns entities that have world bounds overlapping the given sphere.
+    const EntityPtrArray        OverlapSphere(const Sphere &sphere, int layerMask) const;
+                                /// Returns entities that have world bounds overlapping the given AABB.
+    const EntityPtrArray        OverlapAABB(const AABB &aabb, int layerMask) const;
+
+                                /// Marks world bounds of the entity to be updated before the next spatial query.
+    void                        InvalidateEntityQueryBounds(Entity *ent);
+
                                 /// Render camera component from all registered entities.
     void                        Render();
 
@@ -142,9 +169,34 @@ public:
     Entity *                    InstantiateEntity(const Entity *originalEntity);
     Entity *                    InstantiateEntityWithTransform(const Entity *originalEntity, const Vec3 &origin, const Quat &rotation);
 
+                                /// Creates and registers a copy of the entity template.
+    Entity *                    InstantiateTemplate(const EntityTemplate &entityTemplate);
+                                /// Creates and registers copies of the entity template in a batch.
+    void                        InstantiateTemplate(const EntityTemplate &entityTemplate, int count, EntityPtrArray &rootEntities);
+
+                                /// Pre-instantiates inactive copies of the original entity until at least 'count' copies are free in its pool.
+    void                        WarmUpEntityPool(const Entity *originalEntity, int count);
+                                /// Returns recycled copy of the original entity from its pool. Pool is grown if there is no free entity.
+    Entity *                    AcquireEntity(const Entity *originalEntity);
+    Entity *                    AcquireEntityWithTransform(const Entity *originalEntity, const Vec3 &origin, const Quat &rotation);
+                                /// Returns the entity to its pool. Entities not acquired from a pool are destroyed.
+    void                        ReleaseEntity(Entity *entity);
+                                /// Destroys all entity pools. Pooled entities are left in the game world as ordinary entities.
+    void                        ClearEntityPools();
+                                /// Returns the pool of the original entity, nullptr if it has no pool yet.
+    const EntityPool *          FindEntityPool(const Entity *originalEntity) const;
+
+                                /// Pool settings of the current map. Applied when the map is loaded.
+    const Array<EntityPoolSetting> &GetEntityPoolSettings() const { return entityPoolSettings; }
+    void                        SetEntityPoolSettings(const Array<EntityPoolSetting> &settings) { entityPoolSettings = settings; }
+
     Entity *                    SpawnEntityFromJson(Json::Value &entityValue, int sceneIndex = 0);
     void                        SpawnEntitiesFromJson(Json::Value &entitiesValue, int sceneIndex = 0);
 
+    Entity *                    SpawnEntityFromBinary(const BinaryObject &entityObject, int sceneIndex = 0);
+                                /// Spawns all the entities listed in the entity index of the binary data.
+    void                        SpawnEntitiesFromBinary(const BinaryDeserializer &reader, int sceneIndex = 0);
+
     void                        SaveSnapshot();
     void                        RestoreSnapshot();
     
@@ -164,8 +216,10 @@ public:
     const char *                MapName() const { return mapName.c_str(); }
 
     void                        NewMap();
+                                /// Loads a map. Both JSON and binary map files are accepted.
     bool                        LoadMap(const char *filename, LoadSceneMode mode);
-    void                        SaveMap(const char *filename);
+                                /// Saves current map. Binary map files are memory mapped and decoded without JSON parsing when loading.
+    void                        SaveMap(const char *filename, bool binary = false);
 
     static const SignalDef      SIG_EntityRegistered;
     static const SignalDef      SIG_EntityUnregistered;
@@ -177,11 +231,18 @@ private:
     Entity *                    FindEntityRelativePath(const Entity *entity, const char *path) const;
     void                        BeginMapLoading();
     void                        FinishMapLoading();
+    bool                        LoadMapJson(const char *text, size_t size, int sceneIndex);
+    bool                        LoadMapBinary(const char *data, size_t size, int sceneIndex);
     Entity *                    CloneEntity(const Entity *originalEntity);
+    void                        RegisterEntityHierarchy(Entity *rootEntity);
+    EntityPool *                GetEntityPool(const Entity *originalEntity, int sceneIndex);
+    void                        WarmUpEntityPools(int sceneIndex);
     void                        FixedUpdateEntities(float timeStep);
     void                        FixedLateUpdateEntities(float timeStep);
     void                        UpdateEntities();
     void                        LateUpdateEntities();
+    void                        UpdateEntityQueryProxies() const;
+    Entity *                    RayCastEntities(const Vec3 &start, const Vec3 &dir, int layerMask, const Array<Entity *> *excludingArray, float &scale) const;
 
     Entity *                    entities[MaxEntities];
     HashIndex                   entityHash;
@@ -190,12 +251,20 @@ private:
 
     GameScene                   scenes[MaxScenes];
 
+    mutable DynamicAABBTree     entityDbvt;         ///< World bounds of the entities for ray casts and overlap queries
+    mutable Array<int>          queryBoundsInvalidatedEntities; ///< Entity numbers of which world bounds need to be updated in entityDbvt
+
+    HashTable<Guid, EntityPool *> entityPools;      ///< Entity pools by the GUID of the original entity
+    Array<EntityPoolSetting>    entityPoolSettings;
+
     Json::Value                 snapshotValues;
 
     Random                      random;
 
     LuaVM                       luaVM;
 
+    TransformSystem             transformSystem;
+
     Str                         mapName;
 
     MapRenderSettings *         mapRenderSettings;
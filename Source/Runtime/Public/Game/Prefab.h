@@ -20,6 +20,7 @@
 BE_NAMESPACE_BEGIN
 
 class Component;
+class BinaryDeserializer;
 
 class Prefab : public Object {
     friend class PrefabManager;
@@ -38,9 +39,11 @@ public:
 
     void                        Clear();
     bool                        Create(const Json::Value &entitiesValue);
+    bool                        Create(const BinaryDeserializer &reader);
 
+                                /// Loads prefab from JSON or binary file.
     bool                        Load(const char *filename);
-    void                        Write(const char *filename);
+    void                        Write(const char *filename, bool binary = false);
 
     bool                        Reload();
 
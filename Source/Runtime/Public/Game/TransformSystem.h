@@ -0,0 +1,106 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Transform System
+
+    Optional batched update of world transform matrices. Local and world
+    matrices of the registered transforms are kept in contiguous arrays.
+    Every root subtree occupies a contiguous range of the arrays and is
+    ordered by hierarchy depth, so parents are always stored before their
+    children.
+
+    Setting a local transform only marks it dirty. Update() recomputes the
+    world matrices of all dirty transforms and their descendants in a single
+    pass per subtree, with batches of subtrees split across job threads, and
+    notifies each changed transform once. World matrices requested before
+    the update are resolved on demand by walking up the parent chain.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/Array.h"
+#include "Math/Math.h"
+
+BE_NAMESPACE_BEGIN
+
+class ComTransform;
+
+class BE_API TransformSystem {
+public:
+    TransformSystem();
+
+    bool                        IsEnabled() const { return enabled; }
+    void                        SetEnabled(bool enabled) { this->enabled = enabled; }
+
+                                /// Removes all registered transforms.
+    void                        Clear();
+
+                                /// Returns number of registered transforms.
+    int                         NumTransforms() const { return transforms.Count() - numFreeSlots; }
+
+                                /// Registers a transform component. Sets transformIndex of the component.
+    void                        Register(ComTransform *transform);
+                                /// Unregisters a transform component. Resets transformIndex of the component.
+    void                        Unregister(ComTransform *transform);
+
+                                /// Sets local matrix of the transform at the given index and marks it dirty.
+    void                        SetLocalMatrix(int index, const Mat3x4 &localMatrix);
+
+                                /// Marks hierarchy order to be rebuilt. Called when the parent of the transform at the given index is changed.
+    void                        InvalidateHierarchy(int index);
+
+                                /// Returns world matrix of the transform at the given index, resolving pending changes of its ancestors if needed.
+                                /// Doesn't modify the system, the hierarchy order is rebuilt only by Update().
+    Mat3x4                      GetWorldMatrix(int index) const;
+
+                                /// Recomputes world matrices of the dirty transforms and their descendants.
+                                /// Then SIG_TransformUpdated is emitted once for each changed transform in hierarchy order.
+    void                        Update();
+
+private:
+    struct Batch {
+        int                     first;
+        int                     last;
+    };
+
+    void                        RebuildHierarchy();
+    int                         ParentIndex(int index) const;
+    Mat3x4                      ResolveWorldMatrix(int index, int topIndex) const;
+    void                        UpdateBatch(const Batch &batch);
+
+    static const int            MinBatchSize = 256;
+
+    Array<ComTransform *>       transforms;         ///< Owner components, nullptr for the free slots until the hierarchy is rebuilt
+    Array<Mat3x4>               localMatrices;
+    Array<Mat3x4>               worldMatrices;
+    Array<int>                  parents;            ///< Parent indices, -1 for roots
+    Array<byte>                 dirtyFlags;         ///< Local matrix has been changed since the last update
+    Array<byte>                 changedFlags;       ///< World matrix has been changed by the current update
+    Array<Batch>                batches;            ///< Contiguous ranges of whole root subtrees
+
+    Array<int>                  updatedIndexes;     ///< Indexes of the transforms to be notified
+
+    int                         numDirty;
+    int                         numFreeSlots;
+    bool                        hierarchyInvalidated;
+    bool                        notifying;
+    bool                        enabled;
+};
+
+BE_NAMESPACE_END
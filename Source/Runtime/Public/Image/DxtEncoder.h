@@ -27,22 +27,35 @@ BE_NAMESPACE_BEGIN
 
 class BE_API DXTEncoder : public DXTCodec {
 public:
-    static void             CompressImageDXT1Fast(const byte *src, const int width, const int height, const int depth, byte *dst);
-    static void             CompressImageDXT1HQ(const byte *src, const int width, const int height, const int depth, byte *dst);
+    struct Flag {
+        enum Enum {
+            NoSIMD          = BIT(0),   ///< Encodes with the scalar block encoders
+            SingleThread    = BIT(1),   ///< Encodes on the calling thread only
+            NoRefinement    = BIT(2)    ///< Skips the least squares refinement of the color end points in HQ encoding
+        };
+    };
+
+                            /// Rows of 4x4 blocks are encoded in parallel on the job threads, unless Flag::SingleThread is given.
+    static void             CompressImageDXT1Fast(const byte *src, const int width, const int height, const int depth, byte *dst, int flags = 0);
+    static void             CompressImageDXT1HQ(const byte *src, const int width, const int height, const int depth, byte *dst, int flags = 0);
     
-    static void             CompressImageDXT3Fast(const byte *src, const int width, const int height, const int depth, byte *dst);
-    static void             CompressImageDXT3HQ(const byte *src, const int width, const int height, const int depth, byte *dst);
+    static void             CompressImageDXT3Fast(const byte *src, const int width, const int height, const int depth, byte *dst, int flags = 0);
+    static void             CompressImageDXT3HQ(const byte *src, const int width, const int height, const int depth, byte *dst, int flags = 0);
     
-    static void             CompressImageDXT5Fast(const byte *src, const int width, const int height, const int depth, byte *dst);
-    static void             CompressImageDXT5HQ(const byte *src, const int width, const int height, const int depth, byte *dst);
+    static void             CompressImageDXT5Fast(const byte *src, const int width, const int height, const int depth, byte *dst, int flags = 0);
+    static void             CompressImageDXT5HQ(const byte *src, const int width, const int height, const int depth, byte *dst, int flags = 0);
     
-    static void             CompressImageDXN2Fast(const byte *src, const int width, const int height, const int depth, byte *dst);
-    static void             CompressImageDXN2HQ(const byte *src, const int width, const int height, const int depth, byte *dst);
+    static void             CompressImageDXN2Fast(const byte *src, const int width, const int height, const int depth, byte *dst, int flags = 0);
+    static void             CompressImageDXN2HQ(const byte *src, const int width, const int height, const int depth, byte *dst, int flags = 0);
 
 private:
                             /// Extracts a 4x4 block from the texture and stores it in a fixed size buffer.
     static void             ExtractBlock(const byte *src, int srcPitch, int blockWidth, int blockHeight, byte *colorBlock);
 
+                            /// Encodes all blocks of the image with encodeBlock, which writes blockSize bytes per block.
+    template <typename EncodeBlockFunc>
+    static void             CompressImage(const byte *src, const int width, const int height, const int depth, byte *dst, const int blockSize, const int flags, const EncodeBlockFunc &encodeBlock);
+
                             /// Takes the extents of the bounding box of the colors in the 4x4 block in RGB space. 
                             /// Also finds the minimum and maximum alpha values.
     static void             GetMinMaxBBox(const byte *colorBlock, byte *minColor, byte *maxColor);
@@ -66,15 +79,33 @@ private:
     static void             ComputeColorIndicesFast(const byte *colorBlock, const byte *maxColor, const byte *minColor, uint32_t *out);
     static int              ComputeColorIndices(const byte *colorBlock, const uint16_t color0, const uint16_t color1, uint32_t &result);
 
+                            /// Fits the 4-color end points to the colors by least squares for the current indexes, and repeats
+                            /// as long as the error gets lower. Returns the error of the resulting end points.
+    static int              RefineColorEndPoints(const byte *colorBlock, uint16_t &color0, uint16_t &color1, uint32_t &indexes, int error);
+
     static void             EncodeDXT1BlockFast(const byte *src, byte **dstPtr);
     static void             EncodeDXT3BlockFast(const byte *src, byte **dstPtr);
     static void             EncodeDXT5BlockFast(const byte *src, byte **dstPtr);
     static void             EncodeDXN2BlockFast(const byte *src, byte **dstPtr);
 
-    static void             EncodeDXT1BlockHQ(const byte *src, byte **dstPtr);
-    static void             EncodeDXT3BlockHQ(const byte *src, byte **dstPtr);
-    static void             EncodeDXT5BlockHQ(const byte *src, byte **dstPtr);
+    static void             EncodeDXT1BlockHQ(const byte *src, byte **dstPtr, bool refine);
+    static void             EncodeDXT3BlockHQ(const byte *src, byte **dstPtr, bool refine);
+    static void             EncodeDXT5BlockHQ(const byte *src, byte **dstPtr, bool refine);
     static void             EncodeDXN2BlockHQ(const byte *src, byte **dstPtr);
+
+#if defined(__X86__)
+                            /// SSE2 versions of the fast path, processing the 16 pixels of a block at once.
+                            /// These give the same results as the scalar versions.
+    static void             GetMinMaxBBoxSSE2(const byte *colorBlock, byte *minColor, byte *maxColor);
+    static void             InsetColorsBBoxSSE2(byte *minColor, byte *maxColor);
+    static void             ComputeAlphaIndicesFastSSE2(const byte *colorBlock, const int alphaOffset, const byte maxAlpha, const byte minAlpha, byte *out);
+    static void             ComputeColorIndicesFastSSE2(const byte *colorBlock, const byte *maxColor, const byte *minColor, uint32_t *out);
+
+    static void             EncodeDXT1BlockFastSSE2(const byte *src, byte **dstPtr);
+    static void             EncodeDXT3BlockFastSSE2(const byte *src, byte **dstPtr);
+    static void             EncodeDXT5BlockFastSSE2(const byte *src, byte **dstPtr);
+    static void             EncodeDXN2BlockFastSSE2(const byte *src, byte **dstPtr);
+#endif
 };
 
 BE_INLINE unsigned int DXTEncoder::AlphaDistance(const byte a1, const byte a2) {
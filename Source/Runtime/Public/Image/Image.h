@@ -317,6 +317,10 @@ public:
                         /// Loads image from the file.
     bool                Load(const char *filename);
 
+                        /// Reads the size of the image from the file header without decoding the image.
+                        /// Returns false if the format is unknown or the header can't be parsed.
+    static bool         LoadDimensions(const char *filename, int *width, int *height);
+
                         /// Writes image to the file.
     bool                Write(const char *filename) const;
 
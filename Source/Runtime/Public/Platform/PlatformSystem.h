@@ -25,6 +25,9 @@ public:
     static const char *     UserDocumentDir();
     static const char *     UserAppDataDir();
     static const char *     UserTempDir();
+
+    static int32_t          CaptureCallStack(void **frames, int32_t maxFrames, int32_t skipFrames);
+    static void             AddressToSymbol(const void *address, char *symbol, uint32_t symbolLength);
 };
 
 BE_NAMESPACE_END
@@ -18,6 +18,8 @@ BE_NAMESPACE_BEGIN
 
 class BE_API PlatformPosixProcess : public PlatformBaseProcess {
 public:
+    static int                  NumberOfLogicalProcessors();
+
     static void                 Sleep(float seconds);
 
     // Loads a shared library
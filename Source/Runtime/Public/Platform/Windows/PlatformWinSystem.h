@@ -26,6 +26,9 @@ public:
     static const char *     UserAppDataDir();
     static const char *     UserTempDir();
 
+    static int32_t          CaptureCallStack(void **frames, int32_t maxFrames, int32_t skipFrames);
+    static void             AddressToSymbol(const void *address, char *symbol, uint32_t symbolLength);
+
     static int32_t          NumCPUCores();
     static int32_t          NumCPUCoresIncludingHyperthreads();
 };
@@ -0,0 +1,360 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+/*
+===============================================================================
+
+    Null Rendering Hardware Interface
+
+    Implements RHI without a GPU, to run the renderer on headless machines.
+    It hands out handles, keeps buffer memory in system memory so that it can
+    be mapped, tracks buffer and texture memory, and counts state changes,
+    draw calls and uploaded bytes per frame.
+
+    The call stream can optionally be recorded to a file and replayed later.
+
+===============================================================================
+*/
+
+#include "Containers/Array.h"
+#include "Image/Image.h"
+#include "RHI.h"
+
+BE_NAMESPACE_BEGIN
+
+class Rect;
+class Vec2;
+class Vec4;
+class Color4;
+class Mat2;
+class Mat3;
+class Mat4;
+class File;
+
+struct NullRHIContext;
+struct NullRHIStencilState;
+struct NullRHIBuffer;
+struct NullRHITexture;
+struct NullRHIShader;
+struct NullRHIVertexFormat;
+struct NullRHIRenderTarget;
+struct NullRHIQuery;
+struct NullRHISync;
+struct NullRHIReplayState;
+
+class NullRHI : public RHI {
+public:
+    struct FrameStats {
+        int                 numDrawCalls;
+        int                 numInstances;
+        int                 numVerts;           ///< Number of vertices or indices drawn
+        int                 numStateChanges;    ///< Number of calls which actually changed render states
+        int                 numShaderChanges;
+        int                 numTextureChanges;
+        int                 numBufferChanges;
+        int                 numRenderTargetChanges;
+        int                 numConstantUpdates;
+        int64_t             bufferUploadBytes;
+        int64_t             textureUploadBytes;
+    };
+
+    struct MemoryStats {
+        int                 numBuffers;
+        int                 numTextures;
+        int64_t             bufferBytes;
+        int64_t             textureBytes;
+    };
+
+    NullRHI();
+
+    void                    Init(WindowHandle windowHandle, const Settings *settings);
+    void                    Shutdown();
+
+    bool                    IsInitialized() const { return initialized; }
+
+    bool                    SupportsPolygonMode() const;
+    bool                    SupportsPackedFloat() const;
+    bool                    SupportsDepthBufferFloat() const;
+    bool                    SupportsPixelBufferObject() const;
+    bool                    SupportsTextureRectangle() const;
+    bool                    SupportsTextureArray() const;
+    bool                    SupportsTextureBufferObject() const;
+    bool                    SupportsTextureCompressionS3TC() const;
+    bool                    SupportsTextureCompressionLATC() const;
+    bool                    SupportsTextureCompressionETC2() const;
+    bool                    SupportsInstancedArrays() const;
+    bool                    SupportsBufferStorage() const;
+    bool                    SupportsMultiDrawIndirect() const;
+    bool                    SupportsDebugLabel() const;
+
+    Handle                  CreateContext(WindowHandle windowHandle, bool useSharedContext);
+    void                    DestroyContext(Handle ctxHandle);
+    void                    ActivateSurface(Handle ctxHandle, WindowHandle windowHandle);
+    void                    DeactivateSurface(Handle ctxHandle);
+    void                    SetContext(Handle ctxHandle);
+    void                    SetContextDisplayFunc(Handle ctxHandle, DisplayContextFunc displayFunc, void *dataPtr, bool onDemandDrawing);
+    void                    DisplayContext(Handle ctxHandle);
+    WindowHandle            GetWindowHandleFromContext(Handle ctxHandle);
+    void                    GetDisplayMetrics(Handle ctxHandle, DisplayMetrics *displayMetrics) const;
+
+    bool                    IsFullscreen() const;
+    bool                    SetFullscreen(Handle windowHandle, int width, int height);
+    void                    ResetFullscreen(Handle windowHandle);
+
+    void                    GetGammaRamp(unsigned short ramp[768]) const;
+    void                    SetGammaRamp(unsigned short ramp[768]) const;
+
+    bool                    SwapBuffers();
+    void                    SwapInterval(int interval) const;
+
+    void                    Clear(int clearBits, const Color4 &color, float depth, unsigned int stencil);
+    void                    ReadPixels(int x, int y, int width, int height, Image::Format imageFormat, byte *data);
+
+    unsigned int            GetStateBits() const;
+    const Rect &            GetViewport() const;
+    int                     GetCullFace() const;
+    const Rect &            GetScissor() const;
+
+    void                    SetDefaultState();
+    void                    SetStateBits(unsigned int state);
+    void                    SetCullFace(int cull);
+    void                    SetDepthBias(float slopeScaleBias, float constantBias);
+    void                    SetDepthRange(float znear, float zfar);
+    void                    SetDepthClamp(bool enable);
+    void                    SetDepthBounds(float zmin, float zmax);
+    void                    SetViewport(const Rect &viewportRect);
+    void                    SetScissor(const Rect &scissorRect);
+    void                    SetSRGBWrite(bool enable);
+
+    void                    EnableLineSmooth(bool enable);
+    float                   GetLineWidth() const;
+    void                    SetLineWidth(float width);
+
+    Handle                  CreateStencilState(int readMask, int writeMask, StencilFunc funcBack, int failBack, int zfailBack, int zpassBack, StencilFunc funcFront, int failFront, int zfailFront, int zpassFront);
+    void                    DestroyStencilState(Handle stencilStateHandle);
+    void                    SetStencilState(Handle stencilStateHandle, int ref);
+
+    Handle                  CreateTexture(TextureType type);
+    void                    DestroyTexture(Handle textureHandle);
+    void                    SelectTextureUnit(unsigned int unit);
+    void                    BindTexture(Handle textureHandle);
+
+    void                    AdjustTextureSize(TextureType type, bool useNPOT, int inWidth, int inHeight, int inDepth, int *outWidth, int *outHeight, int *outDepth);
+    void                    AdjustTextureFormat(TextureType type, bool useCompression, bool useNormalMap, Image::Format inFormat, Image::Format *outFormat);
+
+    void                    SetTextureFilter(TextureFilter filter);
+    void                    SetTextureAddressMode(AddressMode addressMode);
+    void                    SetTextureAnisotropy(int aniso);
+    void                    SetTextureBorderColor(const Color4 &rgba);
+    void                    SetTextureShadowFunc(bool set);
+    void                    SetTextureLODBias(float bias);
+    void                    SetTextureLevel(int baseLevel, int maxLevel = 1000);
+    void                    GenerateMipmap();
+
+    void                    SetTextureImage(TextureType textureType, const Image *srcImage, Image::Format dstFormat, bool useMipmaps, bool useSRGB);
+    void                    SetTextureImageBuffer(Image::Format dstFormat, bool sRGB, int bufferHandle);
+
+    void                    SetTextureSubImage2D(int level, int xoffset, int yoffset, int width, int height, Image::Format srcFormat, const void *pixels);
+    void                    SetTextureSubImage3D(int level, int xoffset, int yoffset, int zoffset, int width, int height, int depth, Image::Format srcFormat, const void *pixels);
+    void                    SetTextureSubImage2DArray(int level, int xoffset, int yoffset, int zoffset, int width, int height, int arrays, Image::Format srcFormat, const void *pixels);
+    void                    SetTextureSubImageCube(CubeMapFace face, int level, int xoffset, int yoffset, int width, int height, Image::Format srcFormat, const void *pixels);
+    void                    SetTextureSubImageRect(int xoffset, int yoffset, int width, int height, Image::Format srcFormat, const void *pixels);
+
+    void                    CopyTextureSubImage2D(int xoffset, int yoffset, int x, int y, int width, int height);
+
+    void                    GetTextureImage2D(int level, Image::Format format, void *pixels);
+    void                    GetTextureImage3D(int level, Image::Format format, void *pixels);
+    void                    GetTextureImageCube(CubeMapFace face, int level, Image::Format format, void *pixels);
+    void                    GetTextureImageRect(Image::Format format, void *pixels);
+
+    Handle                  CreateRenderTarget(RenderTargetType type, int width, int height, int numColorTextures, Handle *colorTextureHandles, Handle depthTextureHandle, bool sRGB, int flags);
+    void                    DestroyRenderTarget(Handle renderTargetHandle);
+    void                    BeginRenderTarget(Handle renderTargetHandle, int level = 0, int sliceIndex = 0, unsigned int mrtBitMask = 0);
+    void                    EndRenderTarget();
+    void                    BlitRenderTarget(Handle srcRenderTargetHandle, const Rect &srcRect, Handle dstRenderTargetHandle, const Rect &dstRect, int mask, int filter) const;
+
+    Handle                  CreateShader(const char *name, const char *vsText, const char *fsText);
+    void                    DestroyShader(Handle shaderHandle);
+    void                    BindShader(Handle shaderHandle);
+
+    int                     GetSamplerUnit(Handle shaderHandle, const char *name) const;
+    void                    SetTexture(int unit, Handle textureHandle);
+
+                            /// Returns the index of shader constant with the given name.
+    int                     GetShaderConstantIndex(int shaderHandle, const char *name) const;
+
+                            /// Returns the block index of shader constant with the given name.
+    int                     GetShaderConstantBlockIndex(int shaderHandle, const char *name) const;
+
+                            /// Sets the value of integer constant variable for the current bound shader.
+    void                    SetShaderConstant1i(int index, const int constant) const;
+    void                    SetShaderConstant2i(int index, const int *constant) const;
+    void                    SetShaderConstant3i(int index, const int *constant) const;
+    void                    SetShaderConstant4i(int index, const int *constant) const;
+
+                            /// Sets the value of float constant variable for the current bound shader.
+    void                    SetShaderConstant1f(int index, const float constant) const;
+    void                    SetShaderConstant2f(int index, const float *constant) const;
+    void                    SetShaderConstant3f(int index, const float *constant) const;
+    void                    SetShaderConstant4f(int index, const float *constant) const;
+    void                    SetShaderConstant2f(int index, const Vec2 &constant) const;
+    void                    SetShaderConstant3f(int index, const Vec3 &constant) const;
+    void                    SetShaderConstant4f(int index, const Vec4 &constant) const;
+
+                            /// Sets the value of float matrix constant variable for the current bound shader.
+    void                    SetShaderConstant2x2f(int index, bool rowMajor, const Mat2 &constant) const;
+    void                    SetShaderConstant3x3f(int index, bool rowMajor, const Mat3 &constant) const;
+    void                    SetShaderConstant4x4f(int index, bool rowMajor, const Mat4 &constant) const;
+    void                    SetShaderConstant4x3f(int index, bool rowMajor, const Mat3x4 &constant) const;
+
+                            /// Sets the value of integer constant array variable for the current bound shader.
+    void                    SetShaderConstantArray1i(int index, int count, const int *constant) const;
+    void                    SetShaderConstantArray2i(int index, int count, const int *constant) const;
+    void                    SetShaderConstantArray3i(int index, int count, const int *constant) const;
+    void                    SetShaderConstantArray4i(int index, int count, const int *constant) const;
+
+                            /// Sets the value of float array constant variable for the current bound shader.
+    void                    SetShaderConstantArray1f(int index, int count, const float *constant) const;
+    void                    SetShaderConstantArray2f(int index, int count, const float *constant) const;
+    void                    SetShaderConstantArray3f(int index, int count, const float *constant) const;
+    void                    SetShaderConstantArray4f(int index, int count, const float *constant) const;
+    void                    SetShaderConstantArray2f(int index, int count, const Vec2 *constant) const;
+    void                    SetShaderConstantArray3f(int index, int count, const Vec3 *constant) const;
+    void                    SetShaderConstantArray4f(int index, int count, const Vec4 *constant) const;
+
+                            /// Sets the value of float matrix constant array variable for the current bound shader.
+    void                    SetShaderConstantArray2x2f(int index, bool rowMajor, int count, const Mat2 *constant) const;
+    void                    SetShaderConstantArray3x3f(int index, bool rowMajor, int count, const Mat3 *constant) const;
+    void                    SetShaderConstantArray4x4f(int index, bool rowMajor, int count, const Mat4 *constant) const;
+    void                    SetShaderConstantArray4x3f(int index, bool rowMajor, int count, const Mat3x4 *constant) const;
+
+    void                    SetShaderConstantBlock(int index, int bindingIndex);
+
+    Handle                  CreateBuffer(BufferType type, BufferUsage usage, int size, int pitch = 0, const void *data = nullptr);
+    void                    DestroyBuffer(Handle bufferHandle);
+    void                    BindBuffer(BufferType type, Handle bufferHandle);
+
+    void                    BindIndexedBuffer(BufferType type, int bindingIndex, Handle bufferHandle);
+    void                    BindIndexedBufferRange(BufferType type, int bindingIndex, Handle bufferHandle, int offset, int size);
+
+    void *                  MapBufferRange(Handle bufferHandle, BufferLockMode lockMode, int offset = 0, int size = -1);
+    bool                    UnmapBuffer(Handle bufferHandle);
+    void                    FlushMappedBufferRange(Handle bufferHandle, int offset = 0, int size = -1);
+
+                            /// Discards the buffer and writes data to the new one. Returns written start offset (always 0).
+    int                     BufferDiscardWrite(Handle bufferHandle, int size, const void *data);
+                            /// Appends data to the buffer. Returns written start offset, or -1 if the buffer overflows.
+                            /// If data is nullptr, only reserves the space.
+    int                     BufferWrite(Handle bufferHandle, int alignSize, int size, const void *data);
+                            /// Appends contents of the buffer created with CopyReadBuffer type.
+    int                     BufferCopy(Handle readBufferHandle, Handle writeBufferHandle, int alignSize, int size);
+                            /// Resets write offset to 0.
+    void                    BufferRewind(Handle bufferHandle);
+
+    Handle                  CreateSync();
+    void                    DestroySync(Handle syncHandle);
+    bool                    IsSync(Handle syncHandle) const;
+    void                    FenceSync(Handle syncHandle);
+    void                    DeleteSync(Handle syncHandle);
+    void                    WaitSync(Handle syncHandle);
+
+    Handle                  CreateVertexFormat(int numElements, const VertexElement *elements);
+    void                    DestroyVertexFormat(Handle vertexFormatHandle);
+    void                    SetVertexFormat(Handle vertexFormatHandle);
+                            /// Must be called after SetVertexFormat().
+    void                    SetStreamSource(int stream, Handle vertexBufferHandle, int base, int stride);
+
+    void                    DrawArrays(Primitive primitives, int startVertex, int numVerts) const;
+    void                    DrawArraysInstanced(Primitive primitives, int startVertex, int numVerts, int instanceCount) const;
+    void                    DrawElements(Primitive primitives, int startIndex, int numIndices, int indexSize, const void *ptr) const;
+    void                    DrawElementsInstanced(Primitive primitives, int startIndex, int numIndices, int indexSize, const void *ptr, int instanceCount) const;
+    void                    DrawElementsBaseVertex(Primitive primitives, int startIndex, int numIndices, int indexSize, const void *ptr, int baseVertexIndex) const;
+    void                    DrawElementsInstancedBaseVertex(Primitive primitives, int startIndex, int numIndices, int indexSize, const void *ptr, int instanceCount, int baseVertexIndex) const;
+    void                    DrawElementsIndirect(Primitive primitives, int indexSize, int indirectBufferOffset) const;
+    void                    MultiDrawElementsIndirect(Primitive primitives, int indexSize, int indirectBufferOffset, int drawCount, int stride) const;
+
+    Handle                  CreateQuery();
+    void                    DestroyQuery(Handle queryHandle);
+    void                    BeginQuery(Handle queryHandle);
+    void                    EndQuery();
+    bool                    QueryResultAvailable(Handle queryHandle) const;
+    unsigned int            QueryResult(Handle queryHandle) const;
+
+    void                    CheckError(const char *fmt, ...) const;
+
+                            /// Returns statistics of the last presented frame.
+    const FrameStats &      GetFrameStats() const { return lastFrameStats; }
+
+                            /// Returns statistics of the frame being rendered.
+    const FrameStats &      GetCurrentFrameStats() const { return frameStats; }
+
+                            /// Returns memory currently allocated by buffers and textures.
+    const MemoryStats &     GetMemoryStats() const { return memoryStats; }
+
+                            /// Starts recording the call stream to the given file.
+    bool                    BeginRecording(const char *filename);
+    void                    EndRecording();
+    bool                    IsRecording() const { return recordFile != nullptr; }
+
+                            /// Replays the recorded call stream. Returns number of replayed frames, -1 on failure.
+                            /// Statistics of the replayed frames are accumulated as if the calls were made directly.
+    int                     Replay(const char *filename);
+
+    Str                     GetGPUString() const;
+
+    const HWLimit &         HWLimit() const { return hwLimit; }
+
+protected:
+    void                    InitHandles();
+    void                    FreeHandles();
+
+    void                    EndFrame();
+
+    int                     GetTypeSize(const VertexElement::Type type) const;
+    void                    SetShaderConstantGeneric(int index, int bytes) const;
+    void                    SetTextureStorage(TextureType type, int width, int height, int depth, int numMipmaps, int numSlices, Image::Format format, int64_t uploadBytes);
+    void                    CountDrawCall(int numVerts, int instanceCount) const;
+
+    void                    Record(int cmd, int numArgs, const int32_t *args) const;
+    bool                    ReplayCommand(NullRHIReplayState *replayState, int cmd, int numArgs, const int32_t *args);
+
+    bool                    initialized;
+
+    RHI::HWLimit            hwLimit;
+
+    NullRHIContext *        mainContext;
+    Array<NullRHIContext *> contextList;
+    NullRHIContext *        currentContext;
+
+    Array<NullRHIStencilState *> stencilStateList;
+    Array<NullRHIBuffer *>  bufferList;
+    Array<NullRHISync *>    syncList;
+    Array<NullRHITexture *> textureList;
+    Array<NullRHIShader *>  shaderList;
+    Array<NullRHIVertexFormat *> vertexFormatList;
+    Array<NullRHIRenderTarget *> renderTargetList;
+    Array<NullRHIQuery *>   queryList;
+
+    mutable FrameStats      frameStats;
+    FrameStats              lastFrameStats;
+    MemoryStats             memoryStats;
+
+    File *                  recordFile;
+    bool                    replaying;
+};
+
+extern NullRHI              rhi;
+
+BE_NAMESPACE_END
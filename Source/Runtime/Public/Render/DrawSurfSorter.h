@@ -0,0 +1,64 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    DrawSurf Sorter
+
+    Sorts the 64 bit sort keys of drawSurfs with a stable LSD radix sort.
+
+    Keys are sorted as compact (sortKey, index) pairs, so the caller can
+    reorder its drawSurfs by the indexes afterwards. All eight byte histograms
+    are counted at once, and the byte passes that every key shares are skipped.
+    Large key sets are counted and scattered in parallel chunks with the job
+    system. Buffers are kept between sorts.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/Array.h"
+
+BE_NAMESPACE_BEGIN
+
+class BE_API DrawSurfSorter {
+public:
+    enum {
+        MinParallelKeys     = 4096,         ///< Minimum number of keys to sort in parallel
+        MaxChunks           = 16            ///< Maximum number of chunks that keys are split into for parallel sorting
+    };
+
+    struct SortKey {
+        uint64_t            sortKey;
+        int32_t             index;          ///< Index in the unsorted keys
+    };
+
+                            /// Resizes the key buffer and returns it to be filled with count keys.
+    SortKey *               SetKeys(int count);
+
+                            /// Sorts the keys set by SetKeys() in increasing order of sort key. Keys of the same sort key keep their order.
+                            /// Returns the sorted keys, which are valid until the next call of SetKeys().
+    const SortKey *         Sort(bool allowParallel = true);
+
+    int                     NumKeys() const { return keys[0].Count(); }
+
+private:
+    Array<SortKey>          keys[2];
+    Array<uint32_t>         histograms;
+    Array<uint32_t>         offsets;
+};
+
+BE_NAMESPACE_END
@@ -0,0 +1,154 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Light Cluster Grid
+
+    Divides the view frustum into a 3D grid of clusters and bins light
+    volumes into them on the CPU.
+
+    Clusters are uniform tiles in screen space and exponential slices in view
+    depth. Lights are binned slice by slice (in parallel with the job system)
+    by testing their bounding sphere against four clusters of a row at a time,
+    and spot lights are refined with a cone test against the bounding sphere
+    of each cluster. The result is a light bit mask and a compact light index
+    list for every cluster, so objects can look up the lights which may touch
+    them without querying the lights one by one.
+
+    All positions are given in world space. The view axis is [FORWARD, LEFT, UP]
+    like in RenderView.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/Array.h"
+#include "Math/Math.h"
+
+BE_NAMESPACE_BEGIN
+
+class BE_API LightClusterGrid {
+public:
+    enum {
+        MaxLights           = 4096
+    };
+
+    /// Light bounding volume to be binned.
+    struct LightVolume {
+                            /// Makes a sphere volume.
+        static LightVolume  FromSphere(const Vec3 &center, float radius);
+                            /// Makes a cone volume with the given half angle in radians.
+        static LightVolume  FromCone(const Vec3 &apex, const Vec3 &direction, float range, float halfAngle);
+
+        Vec3                origin;         ///< Sphere center or cone apex
+        Vec3                direction;      ///< Normalized cone direction
+        float               radius;         ///< Sphere radius or cone range (distance to the flat cap)
+        float               cosAngle;       ///< Cosine of the cone half angle
+        float               sinAngle;       ///< Sine of the cone half angle
+        bool                isCone;
+    };
+
+    LightClusterGrid();
+    ~LightClusterGrid();
+
+                            /// Allocates the grid with the given number of tiles and depth slices.
+    void                    Init(int numTilesX, int numTilesY, int numSlices);
+    void                    Shutdown();
+
+    int                     NumTilesX() const { return numTilesX; }
+    int                     NumTilesY() const { return numTilesY; }
+    int                     NumSlices() const { return numSlices; }
+    int                     NumClusters() const { return numTilesX * numTilesY * numSlices; }
+
+                            /// Sets the perspective view to build the grid for.
+    void                    SetView(const Vec3 &origin, const Mat3 &axis, float tanHalfFovX, float tanHalfFovY, float zNear, float zFar);
+
+                            /// Bins lights into clusters. Lights after MaxLights are ignored.
+                            /// The far end of the grid is fitted to the farthest light to spend the slices on the lit range.
+    void                    Build(const LightVolume *lights, int numLights, bool parallel);
+
+                            /// Returns number of binned lights.
+    int                     NumLights() const { return numLights; }
+
+                            /// Returns distance of the far end of the slices from the last Build().
+    float                   GetGridFar() const { return gridFar; }
+
+    int                     GetClusterIndex(int x, int y, int z) const { return (z * numTilesY + y) * numTilesX + x; }
+
+                            /// Returns index of the cluster which contains the given world point, or -1 if outside of the grid.
+    int                     FindCluster(const Vec3 &worldPoint) const;
+
+                            /// Returns number of lights in the cluster.
+    int                     NumClusterLights(int clusterIndex) const { return clusterOffsets[clusterIndex + 1] - clusterOffsets[clusterIndex]; }
+
+                            /// Returns light indexes of the cluster in ascending order.
+    const int32_t *         GetClusterLights(int clusterIndex) const { return clusterLightIndexes.Ptr() + clusterOffsets[clusterIndex]; }
+
+                            /// Returns total number of light indexes in all clusters.
+    int                     NumClusterLightIndexes() const { return clusterLightIndexes.Count(); }
+
+                            /// Finds lights in the clusters which the given world AABB overlaps.
+                            /// Light indexes are returned in ascending order without duplicates.
+    int                     FindLights(const AABB &worldAABB, Array<int32_t> &lightIndexes) const;
+
+private:
+    struct ClusterLight {
+        float               center[3];      ///< Bounding sphere center in view space (depth, left, up)
+        float               radius;
+        float               apex[3];        ///< Cone apex in view space
+        float               direction[3];   ///< Cone direction in view space
+        float               range;
+        float               cosAngle;
+        float               sinAngle;
+        bool                isCone;
+        int                 minSlice, maxSlice;
+        int                 minTileX, maxTileX;
+        int                 minTileY, maxTileY;
+    };
+
+    void                    ToViewSpace(const Vec3 &worldPoint, float viewPoint[3]) const;
+    void                    SetupSlices(float gridFar);
+    int                     SliceFromDepth(float depth) const;
+    void                    BinSlice(int slice);
+    void                    CompactSlice(int slice);
+
+    int                     numTilesX;
+    int                     numTilesY;
+    int                     numSlices;
+    int                     numLights;
+    int                     numLightWords;  ///< Number of 32 bits words in the light mask of a cluster
+
+    Vec3                    viewOrigin;
+    Vec3                    viewAxis[3];
+    float                   tanHalfFovX;
+    float                   tanHalfFovY;
+    float                   zNear;
+    float                   zFar;
+    float                   gridFar;
+    float                   sliceScale;     ///< numSlices / log(gridFar / zNear)
+
+    Array<float>            tileMinX;       ///< Normalized screen x of tile edges, padded to a multiple of 4
+    Array<float>            tileMaxX;
+    Array<float>            sliceDepths;    ///< Depth of the slice boundaries (numSlices + 1)
+
+    Array<ClusterLight>     clusterLights;
+    Array<uint32_t>         clusterMasks;   ///< Light bit mask for each cluster
+    Array<int32_t>          clusterOffsets; ///< Start of each cluster in clusterLightIndexes (NumClusters() + 1)
+    Array<int32_t>          clusterLightIndexes;
+};
+
+BE_NAMESPACE_END
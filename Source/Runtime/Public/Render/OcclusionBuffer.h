@@ -0,0 +1,118 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Occlusion Buffer
+
+    Low resolution software depth buffer for CPU occlusion culling.
+
+    Occluder triangles are transformed, clipped against the near plane and
+    binned into screen tiles. Each tile is then rasterized independently
+    (in parallel with the job system), and a min/max depth hierarchy of
+    8x8 pixel blocks is built from the result.
+
+    Depth is stored as 1/w so that it interpolates linearly in screen space.
+    Larger values are nearer, and the cleared buffer is 0 (infinitely far).
+    Since every pixel only keeps the nearest depth written, the result does
+    not depend on the order of rasterization.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/Array.h"
+#include "Core/Vertex.h"
+
+BE_NAMESPACE_BEGIN
+
+class Mat4;
+class AABB;
+
+class BE_API OcclusionBuffer {
+public:
+    enum {
+        TileWidth           = 32,
+        TileHeight          = 32,
+        BlockSize           = 8     ///< Size of a block in the depth hierarchy
+    };
+
+    OcclusionBuffer();
+    ~OcclusionBuffer();
+
+                            /// Allocates the depth buffer. The size is rounded up to a multiple of the tile size.
+    void                    Init(int width, int height);
+    void                    Shutdown();
+
+    int                     GetWidth() const { return width; }
+    int                     GetHeight() const { return height; }
+
+                            /// Clears depth and binned triangles.
+    void                    Clear();
+
+                            /// Transforms, clips and bins triangles of an occluder mesh. Back facing triangles are culled.
+    void                    AddOccluder(const Mat4 &modelViewProjMatrix, const Vec3 *positions, int positionStride, int numVerts, const TriIndex *indexes, int numIndexes);
+
+                            /// Returns number of triangles binned since the last Clear().
+    int                     NumTriangles() const { return triangles.Count(); }
+
+                            /// Rasterizes binned triangles tile by tile and builds the depth hierarchy.
+    void                    Rasterize(bool parallel);
+
+                            /// Returns true if the given world AABB is completely hidden behind rasterized occluders.
+                            /// Safe to call from multiple threads after Rasterize().
+    bool                    IsOccluded(const AABB &worldAABB, const Mat4 &viewProjMatrix) const;
+
+                            /// Returns the depth (1/w) at the given pixel.
+    float                   GetDepth(int x, int y) const { return depthBuffer[y * width + x]; }
+
+                            /// Returns pointer to the depth buffer, rows are stored from bottom to top.
+    const float *           GetDepthBuffer() const { return depthBuffer; }
+
+private:
+    struct ScreenTriangle {
+        float               edgeA[3];       ///< Edge functions A * x + B * y + C, positive inside
+        float               edgeB[3];
+        float               edgeC[3];
+        float               depthA;         ///< Depth plane A * x + B * y + C
+        float               depthB;
+        float               depthC;
+        int                 minX, minY;     ///< Pixel bounds
+        int                 maxX, maxY;
+    };
+
+    void                    AddTriangle(const Vec4 &clip0, const Vec4 &clip1, const Vec4 &clip2);
+    void                    BinTriangle(const Vec3 &v0, const Vec3 &v1, const Vec3 &v2);
+    void                    RasterizeTile(int tileIndex);
+    void                    UpdateHierarchy(int tileIndex);
+
+    int                     width;
+    int                     height;
+    int                     numTilesX;
+    int                     numTilesY;
+    int                     numBlocksX;
+    int                     numBlocksY;
+
+    float *                 depthBuffer;
+    float *                 blockMinDepth;      ///< Farthest depth in each block
+    float *                 blockMaxDepth;      ///< Nearest depth in each block
+
+    Array<Vec4>             clipVerts;          ///< Scratch buffer for transformed occluder vertices
+    Array<ScreenTriangle>   triangles;
+    Array<int32_t> *        tileBins;           ///< Triangle indexes for each tile in submission order
+};
+
+BE_NAMESPACE_END
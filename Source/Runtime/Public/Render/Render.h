@@ -14,9 +14,15 @@
 
 #pragma once
 
+#ifdef USE_NULL_RHI
+#include "RHI/RHINull.h"
+#else
 #include "RHI/RHIOpenGL.h"
+#endif
 #include "Render/BufferCache.h"
 #include "Render/SkinningJointCache.h"
+#include "Render/TextureStreamer.h"
+#include "Render/TextureCache.h"
 #include "Render/Texture.h"
 #include "Render/Shader.h"
 #include "Render/Material.h"
@@ -32,6 +38,9 @@
 #include "Render/RenderLight.h"
 #include "Render/ReflectionProbe.h"
 #include "Render/RenderView.h"
+#include "Render/OcclusionBuffer.h"
+#include "Render/LightClusterGrid.h"
+#include "Render/DrawSurfSorter.h"
 #include "Render/RenderWorld.h"
 #include "Render/RenderContext.h"
 #include "Render/RenderSystem.h"
@@ -186,6 +186,9 @@ public:
     void                    InitShadowMapRT();
     void                    FreeShadowMapRT();
 
+                            // Copies the counters of the back end into renderCounter
+    void                    GatherBackEndCounter();
+
     RHI::Handle             contextHandle;
 
     int                     flags;
@@ -214,6 +217,7 @@ public:
     int                     currLumTarget;
 
     RenderCounter           renderCounter;
+    RenderCounter           backEndCounter;         // written only by the back end, which may run on the render thread
     int                     startFrameMsec;
 
     Texture *               screenColorTexture;
@@ -149,6 +149,8 @@ public:
 
     int                     index;
     bool                    firstUpdate;
+    bool                    hidden;                     // unlinked from the DBVTs by RenderWorld::HideRenderObject()
+    int                     occluderIndex;              // index in the occluder objects of the render world, -1 if not linked
 
     State                   state;
 
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include "Platform/PlatformThread.h"
+
 BE_NAMESPACE_BEGIN
 
 /*
@@ -26,11 +28,13 @@ BE_NAMESPACE_BEGIN
 
 class CmdArgs;
 class VisibleView;
+struct UploadTextureRenderCommand;
 
 class RenderSystem {
     friend class RenderContext;
     friend class RenderWorld;
     friend class PhysDebugDraw;
+    friend class Texture;
 
 public:
     RenderSystem();
@@ -60,6 +64,13 @@ public:
 
     void                    CheckModifiedCVars();
 
+                            /// Returns true if the back end runs on the render thread (r_smp).
+    bool                    IsRenderThreadRunning() const { return renderThread != nullptr; }
+
+                            /// Waits until the render thread has finished executing the issued commands.
+                            /// Must be called before the front end touches the resources used by the back end.
+    void                    SyncRenderThread();
+
 private:
     void                    RecreateScreenMapRT();
     void                    RecreateHDRMapRT();
@@ -69,6 +80,12 @@ private:
 
     void                    CmdDrawView(const VisibleView *visView);
     void                    CmdScreenshot(int x, int y, int width, int height, const char *filename);
+                            // Returns nullptr if the command buffer is full. width and height are the size of the full image
+    UploadTextureRenderCommand *CmdUploadTexture(Texture *texture, const Image &mips, Image::Format format, bool useSRGB, int width, int height);
+
+    void                    StartRenderThread();
+    void                    StopRenderThread();
+    static void             RenderThreadProc(void *param);
 
     bool                    initialized;
     unsigned short          savedGammaRamp[768];
@@ -79,11 +96,29 @@ private:
     RenderContext *         currentContext;
     RenderContext *         mainContext;
 
+    PlatformThread *        renderThread;
+    PlatformMutex *         renderThreadMutex;
+    PlatformCondition *     renderThreadCondition;      ///< Signaled when commands are issued to the render thread
+    PlatformCondition *     backEndFinishedCondition;   ///< Signaled when the render thread finished the issued commands
+    const void *            renderThreadCommands;       ///< Commands being executed by the render thread, nullptr if idle
+    bool                    renderThreadTerminate;
+
     static void             Cmd_ScreenShot(const CmdArgs &args);
+#ifdef USE_NULL_RHI
+    static void             Cmd_RecordRHI(const CmdArgs &args);
+    static void             Cmd_ReplayRHI(const CmdArgs &args);
+    static void             Cmd_RHIStats(const CmdArgs &args);
+#endif
 };
 
 BE_INLINE RenderSystem::RenderSystem() {
     initialized = false;
+    renderThread = nullptr;
+    renderThreadMutex = nullptr;
+    renderThreadCondition = nullptr;
+    backEndFinishedCondition = nullptr;
+    renderThreadCommands = nullptr;
+    renderThreadTerminate = false;
 }
 
 extern RenderSystem         renderSystem;
@@ -54,6 +54,10 @@ public:
     int                         AddRenderObject(const RenderObject::State *objectDef);
     void                        UpdateRenderObject(int handle, const RenderObject::State *objectDef);
     void                        RemoveRenderObject(int handle);
+                                /// Unlinks render object from the scene but keeps it allocated.
+    void                        HideRenderObject(int handle);
+                                /// Relinks render object hidden by HideRenderObject() to the scene.
+    void                        ShowRenderObject(int handle);
 
     const RenderLight *         GetRenderLight(int handle) const;
     int                         AddRenderLight(const RenderLight::State *lightDef);
@@ -108,7 +112,12 @@ public:
 private:
     VisibleObject *             RegisterVisibleObject(VisibleView *visView, RenderObject *renderObject);
     VisibleLight *              RegisterVisibleLight(VisibleView *visView, RenderLight *renderLight);
+    void                        UpdateSkinningJointCache(VisibleObject *visObject);
+    int                         GetVisibilitySubtrees(const DynamicAABBTree &tree, int32_t *subtreeRoots) const;
     void                        FindVisibleLightsAndObjects(VisibleView *visView);
+    bool                        RasterizeOccluders(const VisibleView *visView);
+    void                        UpdateOccluderLink(RenderObject *renderObject);
+    void                        UnlinkOccluder(RenderObject *renderObject);
     void                        AddStaticMeshes(VisibleView *visView);
     void                        AddSkinnedMeshes(VisibleView *visView);
     void                        AddParticleMeshes(VisibleView *visView);
@@ -116,9 +125,16 @@ private:
     void                        AddSkyBoxMeshes(VisibleView *visView);
     void                        AddStaticMeshesForLights(VisibleView *visView);
     void                        AddSkinnedMeshesForLights(VisibleView *visView);
+    void                        AssignLightsToClusters(VisibleView *visView);
+    void                        AddMeshesForClusteredLights(VisibleView *visView);
+    void                        AddClusteredLitSurf(VisibleView *visView, const AABB &surfAABB, const DrawSurf *ambientDrawSurf);
     void                        CacheInstanceBuffer(VisibleView *visView);
     void                        OptimizeLights(VisibleView *visView);
+    const Material *            CacheDrawSurfSubMesh(const VisibleObject *visObject, const Material *material, SubMesh *subMesh);
+    DrawSurf *                  AllocDrawSurf(const VisibleView *visView, const VisibleLight *visLight, VisibleObject *visObject, const Material *actualMaterial, SubMesh *subMesh, int flags) const;
     void                        AddDrawSurf(VisibleView *visView, VisibleLight *light, VisibleObject *entity, const Material *material, SubMesh *subMesh, int flags);
+    void                        RequestAmbientSurf(VisibleObject *visObject, const Material *material, MeshSurf *surf, int flags);
+    void                        AddAmbientSurfs(VisibleView *visView);
     void                        AddDrawSurfFromAmbient(VisibleView *visView, const VisibleLight *light, bool isShadowCaster, const DrawSurf *ambientDrawSurf);
     void                        SortDrawSurfs(VisibleView *visView);
 
@@ -150,6 +166,50 @@ private:
     DynamicAABBTree             objectDbvt;         ///< Dynamic bounding volume tree for render objects
     DynamicAABBTree             lightDbvt;          ///< Dynamic bounding volume tree for render lights and reflection probes
     DynamicAABBTree             staticMeshDbvt;     ///< Dynamic bounding volume tree for static meshes
+
+    Array<RenderObject *>       occluderObjects;    ///< Shown render objects with OccluderFlag, rasterized before querying the objectDbvt
+
+                                /// Maximum number of subtrees that a dbvt query is split into for multithreaded visibility determination.
+    enum { MaxVisibilitySubtrees = 64 };
+
+    struct VisibleLightCandidate {
+        RenderLight *           renderLight;
+        Rect                    screenClipRect;
+    };
+
+    struct VisibleObjectCandidate {
+        DbvtProxy *             proxy;
+        Mat4                    modelViewMatrix;
+        Mat4                    modelViewProjMatrix;
+    };
+
+                                // Per subtree query results, which are merged in subtree order after the parallel query.
+    Array<VisibleLightCandidate> visLightCandidates[MaxVisibilitySubtrees];
+    Array<VisibleObjectCandidate> visObjectCandidates[MaxVisibilitySubtrees];
+    Array<int32_t>              staticMeshCandidates[MaxVisibilitySubtrees];
+
+    struct AmbientSurfRequest {
+        VisibleObject *         visObject;
+        const Material *        material;
+        MeshSurf *              surf;
+        int                     flags;
+        DrawSurf *              drawSurf;       ///< Generated in parallel by AddAmbientSurfs()
+    };
+
+                                // Ambient drawSurfs of the static and skinned meshes, registered in request order after the parallel generation.
+    Array<AmbientSurfRequest>   ambientSurfRequests;
+
+    OcclusionBuffer             occlusionBuffer;    ///< Software depth buffer for occlusion culling
+
+    LightClusterGrid            lightClusterGrid;   ///< Light cluster grid of the current view
+    Array<VisibleLight *>       clusteredLights;    ///< Visible lights binned in the light cluster grid
+    Array<LightClusterGrid::LightVolume> clusteredLightVolumes;
+    Array<int32_t>              clusterLightIndexes;
+
+    DrawSurfSorter              drawSurfSorter;     ///< Radix sorter of the drawSurf sort keys
+                                // Buffers for reordering drawSurfs after sorting, reused every frame
+    Array<DrawSurf *>           unsortedDrawSurfs;
+    Array<VisibleLight *>       drawSurfSortLights;
 };
 
 BE_NAMESPACE_END
@@ -41,6 +41,10 @@ public:
 
     void                Update(const Skeleton *skeleton, const Mat3x4 *jointMats);
 
+                        // Returns a copy allocated in the frame data for the back end.
+                        // The front end keeps updating this cache while the back end draws the previous frame.
+    const SkinningJointCache *CopyToFrameData() const;
+
     static bool         CapableGPUJointSkinning(SkinningMethod skinningMethod, int numJoints);
 
 private:
@@ -27,13 +27,18 @@
 #include "Core/CVars.h"
 #include "Image/Image.h"
 #include "RHI/RHI.h"
+#include "Render/TextureStreamer.h"
+#include "Render/TextureCache.h"
 
 BE_NAMESPACE_BEGIN
 
+struct UploadTextureRenderCommand;
+
 class Texture {
     friend class TextureManager;
     friend class RenderTarget;
     friend class Shader;
+    friend class TextureStreamingBackend;
 
 public:
     enum Flag {
@@ -117,7 +122,32 @@ public:
 
     void                    Bind() const;
 
+                            /// Returns true if the mips of this texture are streamed in the background.
+    bool                    IsStreamed() const { return streamedTexture != nullptr; }
+
+                            /// Reports the size in pixels this texture covers on screen, to choose the mips to keep resident.
+    void                    ReportScreenSize(float size) const { if (streamedTexture) streamedTexture->ReportScreenSize(size); }
+
+                            /// Recreates the texture with the resident mips of the streamed texture, and sets the image properties of the full image.
+                            /// Called by the back end.
+    void                    CreateStreamedMips(const Image &mips, Image::Format dstFormat, bool useSRGB, int fullWidth, int fullHeight);
+
 private:
+                            // Marks the texture as used by the back end, for the textures which are not reported by the front end
+    void                    MarkUsed() const { if (streamedTexture) streamedTexture->MarkUsed(); }
+
+    bool                    StartStreaming(const char *filename, int flags);
+    bool                    LoadCooked(const TextureCache::Key &key, int flags);
+    bool                    Cook(const TextureCache::Key &key, const Image &srcImage, int flags);
+    void                    CreateCooked(const Image &cookedImage, int srcWidth, int srcHeight, int flags);
+                            // Returns the size and the format Upload() would give to the image
+    static void             GetCookParms(const Image &srcImage, int flags, TextureCookParms &parms);
+    static void             GetCookSize(int srcWidth, int srcHeight, int flags, int &width, int &height);
+    void                    StopStreaming();
+    void                    UploadStreamedMips(const Image &mips);
+    void                    CancelQueuedUpload();
+    void                    SetSamplerState();
+
     Str                     hashName;                   // texture filename including path
     Str                     name;
     mutable int             refCount;                   // reference count
@@ -141,6 +171,12 @@ private:
     int                     depth;                      // scaled depth
 
     bool                    hasMipmaps;
+
+    int                     gpuMemSize;                 // GPU memory accounted to MemTag::Texture
+
+    StreamedTexture *       streamedTexture;            // streaming state, null if not streamed
+    UploadTextureRenderCommand *queuedUpload;           // last upload of the streamed mips queued to the back end
+    uint32_t                queuedUploadFrame;          // frame count of the frame data when queuedUpload is queued
 };
 
 BE_INLINE Texture::Texture() {
@@ -159,9 +195,14 @@ BE_INLINE Texture::Texture() {
     height                  = 0;
     depth                   = 0;
     hasMipmaps              = false;
+    gpuMemSize              = 0;
+    streamedTexture         = nullptr;
+    queuedUpload            = nullptr;
+    queuedUploadFrame       = 0;
 }
 
 BE_INLINE Texture::~Texture() {
+    StopStreaming();
     Purge();
 }
 
@@ -183,6 +224,7 @@ public:
 
 class TextureManager {
     friend class Texture;
+    friend class TextureStreamingBackend;
 
 public:
     void                    Init();
@@ -208,6 +250,16 @@ public:
     void                    SetAnisotropy(float anisotropy);
     void                    SetLodBias(float lodBias) const;
 
+                            // Updates residency of the streamed textures. Called once per frame
+    void                    UpdateStreaming();
+
+    const TextureStreamer & GetStreamer() const { return textureStreamer; }
+
+                            // Cooks the textures in the given directory into the texture cache in parallel. Returns number of cooked textures
+    int                     CookTextures(const char *dirname, bool recursive);
+
+    const TextureCache &    GetCache() const { return textureCache; }
+
                             // pre-defined textures
     Texture *               defaultTexture;
     Texture *               zeroClampTexture;
@@ -233,19 +285,33 @@ public:
     static CVar             texture_useCompression;
     static CVar             texture_useNormalCompression;
     static CVar             texture_mipLevel;
+    static CVar             texture_streaming;
+    static CVar             texture_streamingUploadBudget;
+    static CVar             texture_streamingMemoryBudget;
+    static CVar             texture_streamingTailSize;
+    static CVar             texture_streamingMaxRequests;
+    static CVar             texture_streamingMipBias;
+    static CVar             texture_cache;
 
 private:
     void                    CreateEngineTextures();
     int                     LoadTextureInfo(const char *filename) const;
+                            // Computes the texture cache key of the given file loaded with the given texture flags
+    bool                    ComputeCacheKey(const char *filename, int flags, TextureCache::Key &key) const;
 
     static void             Cmd_ListTextures(const CmdArgs &args);
     static void             Cmd_ReloadTexture(const CmdArgs &args);
     static void             Cmd_ConvertNormalAR2RGB(const CmdArgs &args);
+    static void             Cmd_CookTextures(const CmdArgs &args);
+    static void             Cmd_ClearTextureCache(const CmdArgs &args);
 
     friend void             RB_DrawDebugTextures();
 
     StrIHashMap<Texture *>  textureHashMap;
 
+    TextureStreamer         textureStreamer;
+    TextureCache            textureCache;
+
     RHI::TextureFilter      textureFilter;
     int                     textureAnisotropy;
 };
@@ -0,0 +1,116 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Texture Cache
+
+    Content addressed cache of cooked textures.
+
+    A cooked texture is the final mip chain of a texture, resized and stored in
+    the format it is uploaded in, so that loading it skips resizing, mipmap
+    generation and compression. Entries are named after the MD5 digest of the
+    source file and of a target string which holds every setting that changes
+    the cooked image, so a changed source or setting never hits a stale entry.
+
+    Entries are stored in .btex files, which are memory-mapped and uploaded
+    without copying the texels.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Core/Str.h"
+#include "File/FileMapping.h"
+#include "Image/Image.h"
+
+BE_NAMESPACE_BEGIN
+
+/// Final size and format of a cooked texture.
+struct TextureCookParms {
+    int                     width;                  ///< Width of mip 0
+    int                     height;                 ///< Height of mip 0
+    Image::Format           format;                 ///< Format to store the texels in
+    bool                    useMipmaps;             ///< Builds the full mip chain
+};
+
+/// Cooked texture mapped from the cache.
+class BE_API CookedTexture {
+    friend class TextureCache;
+
+public:
+    CookedTexture();
+    ~CookedTexture() { Close(); }
+
+    void                    Close();
+
+                            /// Returns the cooked mip chain. Texels point into the mapping.
+    const Image &           GetImage() const { return image; }
+
+                            /// Size of the source image.
+    int                     GetSrcWidth() const { return srcWidth; }
+    int                     GetSrcHeight() const { return srcHeight; }
+
+private:
+    FileMapping             mapping;
+    Image                   image;
+    int                     srcWidth;
+    int                     srcHeight;
+};
+
+class BE_API TextureCache {
+public:
+    struct Key {
+        byte                digest[16];
+
+                            /// Returns the digest as a hex string, used as the entry filename.
+        Str                 ToString() const;
+    };
+
+    TextureCache();
+
+                            /// Entries are kept in cacheDir, relative to the base directory of the file system.
+    void                    Init(const char *cacheDir);
+    void                    Shutdown();
+
+    const char *            GetCacheDir() const { return cacheDir; }
+
+                            /// Computes the key of the given source file cooked for the given target.
+                            /// Returns false if the source file doesn't exist.
+    static bool             ComputeKey(const char *filename, const char *target, Key &key);
+
+    bool                    Contains(const Key &key) const;
+
+                            /// Maps the entry of the given key. Returns false on cache miss.
+    bool                    Load(const Key &key, CookedTexture &cookedTexture) const;
+
+                            /// Stores the cooked image as the entry of the given key. Thread safe.
+    bool                    Store(const Key &key, const Image &cookedImage, int srcWidth, int srcHeight) const;
+
+                            /// Removes all entries.
+    void                    Clear() const;
+
+                            /// Resizes, mipmaps and converts the source image as given in parms.
+    static bool             CookImage(const Image &srcImage, const TextureCookParms &parms, Image &cookedImage);
+
+private:
+    Str                     EntryFilename(const Key &key) const;
+
+    Str                     cacheDir;
+};
+
+BE_NAMESPACE_END
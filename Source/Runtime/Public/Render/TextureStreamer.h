@@ -0,0 +1,216 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Texture Streamer
+
+    Streams the mip levels of 2D textures in the background.
+
+    Images are loaded, scaled, mipmapped and converted to their final format
+    on job threads, unless the back end has the mips cooked already. The mip tail (mips no larger than the tail size) is kept in
+    system memory and made resident as soon as the first decode is done. Finer
+    mips are made resident by Update() within a per-frame byte budget, down to
+    the desired mip which is chosen from the screen size reported by the render
+    front end. When the resident mips exceed the memory budget, the least
+    recently used textures are dropped back to their mip tail.
+
+    The streamer never touches the GPU. Residency changes are handed over to a
+    TextureStreamerBackend, so the streaming policy runs without a renderer.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Core/Str.h"
+#include "Containers/Array.h"
+#include "Core/JobSystem.h"
+#include "Image/Image.h"
+#include <atomic>
+
+BE_NAMESPACE_BEGIN
+
+class StreamedTexture;
+struct StreamingRequest;
+
+/// Interface between the texture streamer and the texture resources.
+class TextureStreamerBackend {
+public:
+    virtual ~TextureStreamerBackend() {}
+
+                            /// Chooses the size and the format to store the decoded image in. Called from job threads.
+    virtual void            AdjustImage(const StreamedTexture *streamedTexture, const Image &srcImage, int &width, int &height, Image::Format &format) const = 0;
+
+                            /// Loads the mip chain from firstMip, clamped to the coarsest mip, out of the full chain kept by StoreCookedMips() in a previous run.
+                            /// width, height and format are of the mip level 0. Called from job threads.
+    virtual bool            LoadCookedMips(const StreamedTexture *streamedTexture, int firstMip, int &width, int &height, Image::Format &format, Image &mips) const { return false; }
+
+                            /// Keeps the full mip chain prepared from srcImage, so that later runs can skip preparing it. Called from job threads.
+    virtual void            StoreCookedMips(const StreamedTexture *streamedTexture, const Image &srcImage, const Image &mips) const {}
+
+                            /// Makes the given mip chain resident. The level 0 of mips is the finest resident mip.
+                            /// If the texture can't be streamed, mips is the whole source image as loaded.
+    virtual void            UploadMips(StreamedTexture *streamedTexture, const Image &mips) = 0;
+};
+
+/// Streaming state of a texture.
+class StreamedTexture {
+    friend class TextureStreamer;
+
+public:
+    const char *            GetFilename() const { return filename; }
+    void *                  GetUserData() const { return userData; }
+
+                            /// Returns true after the first decode is done.
+    bool                    IsReady() const { return numMips > 0; }
+                            /// Returns false if the image has to stay resident as a whole (cube map, 3D or array image).
+    bool                    IsStreamable() const { return streamable; }
+    bool                    IsFailed() const { return failed; }
+
+                            /// Size of mip 0.
+    int                     GetWidth() const { return width; }
+    int                     GetHeight() const { return height; }
+    Image::Format           GetFormat() const { return format; }
+    int                     NumMips() const { return numMips; }
+
+                            /// First mip of the always resident mip tail.
+    int                     GetTailMip() const { return tailMip; }
+                            /// Finest resident mip.
+    int                     GetResidentMip() const { return residentMip; }
+    int                     GetDesiredMip() const { return desiredMip; }
+    int                     GetLastUsedFrame() const { return lastUsedFrame; }
+
+                            /// Returns memory size of the mip chain from the given mip.
+    size_t                  MipChainSize(int firstMip) const;
+                            /// Returns memory size of the resident mips.
+    size_t                  ResidentSize() const { return residentMip < numMips ? MipChainSize(residentMip) : 0; }
+
+                            /// Reports the size in pixels this texture covers on screen. Thread safe.
+    void                    ReportScreenSize(float size);
+                            /// Marks this texture as used with unknown screen size, so that it will be streamed in fully. Thread safe.
+    void                    MarkUsed() { used.store(true, std::memory_order_relaxed); }
+
+private:
+    StreamedTexture();
+
+    Str                     filename;
+    void *                  userData;
+    int                     index;                  // index in TextureStreamer::textures
+
+    bool                    streamable;
+    bool                    failed;
+
+    int                     width;
+    int                     height;
+    Image::Format           format;
+    int                     numMips;
+    int                     tailMip;
+    int                     residentMip;
+    int                     desiredMip;
+    int                     screenSize;             // last reported screen size
+    int                     lastReportedFrame;
+    int                     lastUsedFrame;
+
+    Image                   tailMips;               // mip tail kept in system memory to fall back on eviction
+    Image                   preparedMips;           // mips waiting for upload
+    int                     preparedMip;            // mip level of preparedMips level 0, -1 if nothing is prepared
+
+    StreamingRequest *      request;                // decode in flight
+
+    std::atomic<int32_t>    reportedSize;           // largest screen size reported since the last update
+    std::atomic<bool>       used;
+};
+
+class BE_API TextureStreamer {
+public:
+    struct Stats {
+        int                 numTextures;
+        int                 numRequests;            ///< Decodes in flight
+        size_t              residentSize;           ///< Memory size of all resident mips
+        size_t              preparedSize;           ///< Memory size of the mips waiting for upload
+        size_t              uploadedSize;           ///< Uploaded bytes in the last update
+        int                 numEvicted;             ///< Textures dropped back to the mip tail in the last update
+    };
+
+    TextureStreamer();
+    ~TextureStreamer();
+
+    void                    Init(TextureStreamerBackend *backend);
+    void                    Shutdown();
+
+                            /// Sets the upload budget in bytes per update. One mip is uploaded per update at least.
+    void                    SetUploadBudget(size_t bytesPerUpdate) { uploadBudget = bytesPerUpdate; }
+                            /// Sets the budget for the resident mips of all streamed textures.
+    void                    SetMemoryBudget(size_t bytes) { memoryBudget = bytes; }
+                            /// Mips no larger than the given size are always resident.
+    void                    SetTailSize(int size) { tailSize = Max(size, 1); }
+                            /// Sets the maximum number of decodes in flight.
+    void                    SetMaxRequests(int count) { maxRequests = Max(count, 1); }
+                            /// Biases the desired mip. Positive values select coarser mips.
+    void                    SetMipBias(float bias) { mipBias = bias; }
+
+                            /// Starts streaming of the given image file. userData is passed back through StreamedTexture::GetUserData().
+    StreamedTexture *       Register(const char *filename, void *userData);
+    void                    Unregister(StreamedTexture *streamedTexture);
+
+                            /// Collects finished decodes, and updates residency of the textures.
+                            /// Must be called once per frame, after the front end reported the screen sizes of the last frame.
+    void                    Update();
+
+                            /// Blocks until all decodes in flight are done.
+    void                    WaitRequests();
+
+    int                     GetFrameCount() const { return frameCount; }
+
+    const Stats &           GetStats() const { return stats; }
+
+                            /// Builds the full mip chain of the given size and format from the source image.
+    static bool             PrepareMips(const Image &srcImage, int width, int height, Image::Format format, Image &mips);
+
+                            /// Copies the mip chain of a 2D image from firstLevel.
+    static void             CopyMipChain(const Image &srcMips, int firstLevel, Image &dstMips);
+
+                            /// Returns the mip level to sample a texture of the given size at the given screen size.
+    static int              DesiredMip(int width, int height, float screenSize, float mipBias, int coarsestMip);
+
+private:
+    void                    StartRequest(StreamedTexture *streamedTexture, int firstMip);
+    void                    FinishRequest(StreamedTexture *streamedTexture);
+    void                    UpdateDesiredMip(StreamedTexture *streamedTexture);
+    void                    StartRequests();
+    void                    UploadMips();
+    bool                    MakeRoom(size_t size, const StreamedTexture *exclude);
+    void                    Evict(StreamedTexture *streamedTexture);
+    void                    MakeResident(StreamedTexture *streamedTexture, int mip, const Image &mips);
+
+    static void             PrepareJob(void *data);
+
+    TextureStreamerBackend *backend;
+    Array<StreamedTexture *> textures;
+
+    size_t                  uploadBudget;
+    size_t                  memoryBudget;
+    int                     tailSize;
+    int                     maxRequests;
+    float                   mipBias;
+
+    size_t                  residentSize;
+
+    int                     frameCount;
+    Stats                   stats;
+};
+
+BE_NAMESPACE_END
@@ -18,6 +18,26 @@
 #include "TestSIMD.h"
 #include "TestCUDA.h"
 #include "TestLua.h"
+#include "TestJobSystem.h"
+#include "TestProfiler.h"
+#include "TestNullRHI.h"
+#include "TestDynamicAABBTree.h"
+#include "TestOcclusionBuffer.h"
+#include "TestLightClusterGrid.h"
+#include "TestDrawSurfSorter.h"
+#include "TestFrameData.h"
+#include "TestBinarySerializer.h"
+#include "TestEntityTemplate.h"
+#include "TestEntityPool.h"
+#include "TestEventSystem.h"
+#include "TestSignalSystem.h"
+#include "TestHeap.h"
+#include "TestAsyncFileIO.h"
+#include "TestZipArchive.h"
+#include "TestTextureStreaming.h"
+#include "TestTextureCache.h"
+#include "TestDXTEncoder.h"
+#include "TestTransformSystem.h"
 
 void SystemLog(const int logLevel, const wchar_t *msg) {
     printf("%ls", msg);
@@ -59,5 +79,40 @@ int main(int argc, char *argv[]) {
 
     TestLua();
 
+    TestJobSystem();
+
+    TestProfiler();
+
+    TestNullRHI();
+
+    TestDynamicAABBTree();
+
+    TestOcclusionBuffer();
+
+    TestLightClusterGrid();
+
+    TestDrawSurfSorter();
+    TestFrameData();
+
+    TestBinarySerializer();
+
+    TestEntityTemplate();
+    TestEntityPool();
+
+    TestEventSystem();
+    TestSignalSystem();
+
+    TestHeap();
+
+    TestAsyncFileIO();
+    TestZipArchive();
+
+    TestTextureStreaming();
+    TestTextureCache();
+
+    TestDXTEncoder();
+
+    TestTransformSystem();
+
     BE1::Engine::ShutdownBase();
 }
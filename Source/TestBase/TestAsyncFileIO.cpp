@@ -0,0 +1,155 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "BlueshiftEngine.h"
+#include "TestAsyncFileIO.h"
+
+#define TEST_FILENAME       "TestAsyncFileIO.bin"
+#define TEST_FILE_SIZE      (4 * 1024 * 1024)
+#define NUM_CHUNKS          256
+
+struct ChunkRead {
+    int                     index;
+    int                     numCompleted;
+    int                     numCancelled;
+    int                     numFailed;
+    int                     numMismatches;
+};
+
+static byte *referenceData;
+
+static void ChunkCallback(BE1::AsyncIOResult &result, void *userData) {
+    ChunkRead *read = (ChunkRead *)userData;
+
+    switch (result.status) {
+    case BE1::AsyncIOStatus::Completed:
+        read->numCompleted++;
+        if (result.size != TEST_FILE_SIZE / NUM_CHUNKS || memcmp(result.data, referenceData + read->index * result.size, result.size)) {
+            read->numMismatches++;
+        }
+        break;
+    case BE1::AsyncIOStatus::Cancelled:
+        read->numCancelled++;
+        break;
+    default:
+        read->numFailed++;
+        break;
+    }
+}
+
+static void WholeFileCallback(BE1::AsyncIOResult &result, void *userData) {
+    ChunkRead *read = (ChunkRead *)userData;
+    if (result.status == BE1::AsyncIOStatus::Completed && result.size == TEST_FILE_SIZE && !memcmp(result.data, referenceData, TEST_FILE_SIZE)) {
+        read->numCompleted++;
+    } else {
+        read->numFailed++;
+    }
+}
+
+static void WaitAll(const BE1::Array<BE1::AsyncIOHandle> &handles) {
+    for (int i = 0; i < handles.Count(); i++) {
+        BE1::asyncFileIO.Wait(handles[i]);
+    }
+    BE1::asyncFileIO.DispatchCompletions();
+}
+
+void TestAsyncFileIO() {
+    BE_LOG(L"--- TestAsyncFileIO ---\n");
+
+    referenceData = (byte *)BE1::Mem_Alloc(TEST_FILE_SIZE);
+    for (int i = 0; i < TEST_FILE_SIZE; i++) {
+        referenceData[i] = (byte)((i * 2654435761u) >> 13);
+    }
+    BE1::fileSystem.WriteFile(TEST_FILENAME, referenceData, TEST_FILE_SIZE);
+
+    const size_t chunkSize = TEST_FILE_SIZE / NUM_CHUNKS;
+
+    // Adjacent range reads, submitted in reverse order so that they are coalesced
+    ChunkRead reads[NUM_CHUNKS];
+    BE1::Array<BE1::AsyncIOHandle> handles;
+
+    uint64_t startTime = BE1::PlatformTime::Microseconds();
+
+    for (int i = NUM_CHUNKS - 1; i >= 0; i--) {
+        memset(&reads[i], 0, sizeof(reads[i]));
+        reads[i].index = i;
+        handles.Append(BE1::asyncFileIO.Read(TEST_FILENAME, i * chunkSize, chunkSize, nullptr, BE1::AsyncIOPriority::Normal, ChunkCallback, &reads[i]));
+    }
+    WaitAll(handles);
+
+    uint64_t elapsed = BE1::PlatformTime::Microseconds() - startTime;
+
+    int numCompleted = 0;
+    int numMismatches = 0;
+    for (int i = 0; i < NUM_CHUNKS; i++) {
+        numCompleted += reads[i].numCompleted;
+        numMismatches += reads[i].numMismatches;
+    }
+    BE_LOG(L"%i chunk reads: %i completed, %i mismatches, %.2f ms\n", NUM_CHUNKS, numCompleted, numMismatches, elapsed / 1000.0f);
+
+    // Whole file read with a buffer allocated by the I/O system
+    ChunkRead wholeRead;
+    memset(&wholeRead, 0, sizeof(wholeRead));
+    BE1::AsyncIOHandle handle = BE1::asyncFileIO.ReadFile(TEST_FILENAME, BE1::AsyncIOPriority::High, WholeFileCallback, &wholeRead);
+    BE1::asyncFileIO.Wait(handle);
+    BE_LOG(L"whole file read: %ls\n", wholeRead.numCompleted == 1 ? L"OK" : L"FAILED");
+
+    // Cancellation: every request is delivered exactly once, either completed or cancelled
+    handles.Clear();
+    for (int i = 0; i < NUM_CHUNKS; i++) {
+        memset(&reads[i], 0, sizeof(reads[i]));
+        reads[i].index = i;
+        handles.Append(BE1::asyncFileIO.Read(TEST_FILENAME, i * chunkSize, chunkSize, nullptr, BE1::AsyncIOPriority::Low, ChunkCallback, &reads[i]));
+    }
+    for (int i = 0; i < NUM_CHUNKS; i += 2) {
+        BE1::asyncFileIO.Cancel(handles[i]);
+    }
+    WaitAll(handles);
+
+    int numDelivered = 0;
+    int numCancelled = 0;
+    numMismatches = 0;
+    for (int i = 0; i < NUM_CHUNKS; i++) {
+        numDelivered += reads[i].numCompleted + reads[i].numCancelled + reads[i].numFailed;
+        numCancelled += reads[i].numCancelled;
+        numMismatches += reads[i].numMismatches;
+        if (i & 1) {
+            numMismatches += reads[i].numCancelled;
+        }
+    }
+    BE_LOG(L"cancellation: %i delivered, %i cancelled, %i errors\n", numDelivered, numCancelled, numMismatches);
+
+    // Missing files fail
+    ChunkRead missingRead;
+    memset(&missingRead, 0, sizeof(missingRead));
+    handle = BE1::asyncFileIO.ReadFile("TestAsyncFileIO_missing.bin", BE1::AsyncIOPriority::Normal, WholeFileCallback, &missingRead);
+    BE1::asyncFileIO.Wait(handle);
+    BE_LOG(L"missing file: %ls\n", missingRead.numFailed == 1 ? L"OK" : L"FAILED");
+
+    // Bandwidth limit
+    BE1::asyncFileIO.SetBandwidthLimit(TEST_FILE_SIZE * 4);
+    startTime = BE1::PlatformTime::Microseconds();
+    handles.Clear();
+    for (int i = 0; i < 4; i++) {
+        handles.Append(BE1::asyncFileIO.ReadFile(TEST_FILENAME, BE1::AsyncIOPriority::Normal, WholeFileCallback, &wholeRead));
+    }
+    WaitAll(handles);
+    elapsed = BE1::PlatformTime::Microseconds() - startTime;
+    BE1::asyncFileIO.SetBandwidthLimit(0);
+    BE_LOG(L"bandwidth limited to %i MB/s: 4 reads of %i MB in %.2f ms\n", TEST_FILE_SIZE * 4 / (1024 * 1024), TEST_FILE_SIZE / (1024 * 1024), elapsed / 1000.0f);
+
+    BE1::fileSystem.RemoveFile(TEST_FILENAME, false);
+    BE1::Mem_Free(referenceData);
+}
@@ -0,0 +1,378 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestBinarySerializer.h"
+#include "TestEntityTemplate.h"
+
+#define ENTITY_COUNT        5000
+#define LOAD_COUNT          10
+#define SPAWN_ENTITY_COUNT  100
+#define MAP_FILENAME        "TestBinarySerializer.map"
+
+static BE1::Str RandomVec3String() {
+    return BE1::Vec3(BE1::Math::Random(-100.0f, 100.0f), BE1::Math::Random(-100.0f, 100.0f), BE1::Math::Random(-100.0f, 100.0f)).ToString();
+}
+
+static void MakeMapValue(Json::Value &map) {
+    map["version"] = 1;
+
+    Json::Value &renderSettings = map["renderSettings"];
+    renderSettings["classname"] = "MapRenderSettings";
+    renderSettings["guid"] = BE1::Guid::CreateGuid().ToString();
+    renderSettings["ambientColor"] = "0.2 0.2 0.2";
+
+    // Arrays that don't have a single element type
+    Json::Value &editorData = map["editorData"];
+    Json::Reader jsonReader;
+    jsonReader.parse("[1, 2.5, 3000000000, -4, 5]", editorData["mixedNumbers"]);
+    jsonReader.parse("[-1, 3000000000, 9000000000]", editorData["mixedIntegers"]);
+    jsonReader.parse("[[1, 2], [[3.5], []], [\"a\", null, {\"b\": true}], null]", editorData["nestedArrays"]);
+
+    BE1::Guid parentGuid;
+
+    for (int i = 0; i < ENTITY_COUNT; i++) {
+        Json::Value entityValue;
+        BE1::Guid entityGuid = BE1::Guid::CreateGuid();
+
+        entityValue["classname"] = "Entity";
+        entityValue["guid"] = entityGuid.ToString();
+        entityValue["parent"] = (i % 10) ? parentGuid.ToString() : BE1::Guid::zero.ToString();
+        entityValue["name"] = BE1::va("Entity %i", i);
+        entityValue["tag"] = "Untagged";
+        entityValue["layer"] = i % 4;
+        entityValue["frozen"] = false;
+        entityValue["spawn_entnum"] = i;
+
+        Json::Value transformValue;
+        transformValue["classname"] = "ComTransform";
+        transformValue["guid"] = BE1::Guid::CreateGuid().ToString();
+        transformValue["origin"] = RandomVec3String().c_str();
+        transformValue["angles"] = RandomVec3String().c_str();
+        transformValue["scale"] = "1 1 1";
+        entityValue["components"].append(transformValue);
+
+        Json::Value rendererValue;
+        rendererValue["classname"] = "ComStaticMeshRenderer";
+        rendererValue["guid"] = BE1::Guid::CreateGuid().ToString();
+        rendererValue["mesh"] = BE1::Guid::CreateGuid().ToString();
+        rendererValue["materials"].append(BE1::Guid::CreateGuid().ToString());
+        rendererValue["materials"].append(BE1::Guid::CreateGuid().ToString());
+        rendererValue["castShadows"] = true;
+        rendererValue["maxVisDist"] = 1000.5;
+        entityValue["components"].append(rendererValue);
+
+        map["entities"].append(entityValue);
+
+        if (i % 10 == 0) {
+            parentGuid = entityGuid;
+        }
+    }
+}
+
+// Reads the values that spawning entities would read
+static int WalkEntities(const BE1::BinaryDeserializer &reader) {
+    int numValues = 0;
+    BE1::Variant value;
+
+    for (int i = 0; i < reader.NumEntities(); i++) {
+        const BE1::BinaryObject entityObject = reader.GetEntity(i);
+
+        BE1::BinaryProperty prop = entityObject.FindProperty("guid");
+        numValues += prop.GetValue(value);
+        prop = entityObject.FindProperty("name", prop);
+        numValues += prop.GetValue(value);
+
+        const BE1::BinaryProperty componentsProp = entityObject.FindProperty("components", prop);
+        for (int componentIndex = 0; componentIndex < componentsProp.Count(); componentIndex++) {
+            const BE1::BinaryObject componentObject = componentsProp.GetObject(componentIndex);
+
+            for (prop = componentObject.FirstProperty(); prop.IsValid(); prop = prop.Next()) {
+                if (!prop.IsObject()) {
+                    numValues += prop.GetValue(value);
+                }
+            }
+        }
+    }
+    return numValues;
+}
+
+static int WalkEntities(const Json::Value &map) {
+    int numValues = 0;
+
+    const Json::Value &entitiesValue = map["entities"];
+    for (int i = 0; i < entitiesValue.size(); i++) {
+        const Json::Value &entityValue = entitiesValue[i];
+
+        numValues += !entityValue["guid"].isNull();
+        numValues += !entityValue["name"].isNull();
+
+        const Json::Value &componentsValue = entityValue["components"];
+        for (int componentIndex = 0; componentIndex < componentsValue.size(); componentIndex++) {
+            numValues += componentsValue[componentIndex].size();
+        }
+    }
+    return numValues;
+}
+
+// Creates entities which have the components that can be spawned without game world
+static void MakeEntitiesValue(Json::Value &entitiesValue) {
+    BE1::Guid parentGuid;
+
+    for (int i = 0; i < SPAWN_ENTITY_COUNT; i++) {
+        BE1::Guid entityGuid = BE1::Guid::CreateGuid();
+
+        Json::Value entityValue;
+        entityValue["classname"] = BE1::Entity::metaObject.ClassName();
+        entityValue["guid"] = entityGuid.ToString();
+        entityValue["parent"] = (i % 10) ? parentGuid.ToString() : BE1::Guid::zero.ToString();
+        entityValue["name"] = BE1::va("Entity %i", i);
+        entityValue["layer"] = i % 4;
+        entityValue["frozen"] = (i % 3) == 0;
+
+        Json::Value &transformValue = entityValue["components"][0];
+        transformValue["classname"] = BE1::ComTransform::metaObject.ClassName();
+        transformValue["guid"] = BE1::Guid::CreateGuid().ToString();
+        transformValue["origin"] = RandomVec3String().c_str();
+        transformValue["angles"] = RandomVec3String().c_str();
+        transformValue["scale"] = BE1::Vec3(1, 2, 3).ToString();
+
+        entitiesValue.append(entityValue);
+
+        if (i % 10 == 0) {
+            parentGuid = entityGuid;
+        }
+    }
+}
+
+// Spawned entities should have the values in JSON
+static bool CheckSpawnedEntities(const BE1::EntityPtrArray &entities, const Json::Value &entitiesValue) {
+    for (int i = 0; i < entities.Count(); i++) {
+        const BE1::Entity *entity = entities[i];
+        const Json::Value &entityValue = entitiesValue[i];
+        const Json::Value &transformValue = entityValue["components"][0];
+
+        const BE1::Entity *parentEntity = entity->GetParent();
+        const BE1::Guid parentGuid = parentEntity ? parentEntity->GetGuid() : BE1::Guid::zero;
+        const BE1::ComTransform *transform = entity->GetTransform();
+
+        if (entity->GetName() != entityValue["name"].asCString() ||
+            parentGuid != BE1::Guid::FromString(entityValue["parent"].asCString()) ||
+            !transform || !transform->GetLocalOrigin().Equals(BE1::Vec3::FromString(transformValue["origin"].asCString()), 0.001f) ||
+            !transform->GetLocalAxis().Equals(BE1::Angles::FromString(transformValue["angles"].asCString()).ToMat3(), 0.001f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void SerializeAndDestroyEntities(BE1::EntityPtrArray &entities, Json::Value &entitiesValue) {
+    for (int i = 0; i < entities.Count(); i++) {
+        entities[i]->Serialize(entitiesValue[i]);
+    }
+
+    // Destroy children first
+    for (int i = entities.Count() - 1; i >= 0; i--) {
+        BE1::Entity::DestroyInstanceImmediate(entities[i]);
+    }
+    entities.Clear();
+}
+
+// Entities spawned from binary data should have the same properties as the ones spawned from JSON
+static bool TestSpawnEntities() {
+    Json::Value entitiesValue;
+    MakeEntitiesValue(entitiesValue);
+
+    BE1::EntityPtrArray entities;
+
+    // Spawn from JSON, as GameWorld::SpawnEntitiesFromJson() does
+    for (int i = 0; i < entitiesValue.size(); i++) {
+        entities.Append(BE1::Entity::CreateEntity(entitiesValue[i]));
+    }
+
+    bool spawnedValues = CheckSpawnedEntities(entities, entitiesValue);
+
+    Json::Value jsonSpawnedValue;
+    SerializeAndDestroyEntities(entities, jsonSpawnedValue);
+
+    // Spawn from binary, as GameWorld::SpawnEntitiesFromBinary() does
+    BE1::Array<byte> data;
+    BE1::BinarySerializer::FromJson(entitiesValue, data);
+
+    BE1::BinaryDeserializer reader;
+    if (!reader.Open(data.Ptr(), data.Count()) || reader.NumEntities() != entitiesValue.size()) {
+        return false;
+    }
+
+    for (int i = 0; i < reader.NumEntities(); i++) {
+        entities.Append(BE1::Entity::CreateEntity(reader.GetEntity(i)));
+    }
+
+    spawnedValues = spawnedValues && CheckSpawnedEntities(entities, entitiesValue);
+
+    Json::Value binarySpawnedValue;
+    SerializeAndDestroyEntities(entities, binarySpawnedValue);
+
+    return spawnedValues && jsonSpawnedValue == binarySpawnedValue;
+}
+
+// Binary map without render settings should be loaded with the default render settings like JSON map
+static bool TestLoadMapWithoutRenderSettings() {
+    Json::Value mapValue;
+    mapValue["version"] = 1;
+    MakeEntitiesValue(mapValue["entities"]);
+
+    BE1::Array<byte> data;
+    BE1::BinarySerializer::FromJson(mapValue, data);
+
+    BE1::BinaryDeserializer reader;
+    if (!reader.Open(data.Ptr(), data.Count())) {
+        return false;
+    }
+
+    // Accessors of the missing property should return empty values
+    const BE1::BinaryProperty missingProp = reader.GetRoot().FindProperty("renderSettings");
+    BE1::Variant value;
+    if (missingProp.IsValid() || missingProp.IsObject() || missingProp.Count() != 0 || missingProp.GetValue(value) ||
+        missingProp.GetObject().IsValid() || missingProp.GetObject().FirstProperty().IsValid() || missingProp.Next().IsValid()) {
+        return false;
+    }
+
+    BE1::fileSystem.WriteFile(MAP_FILENAME, data.Ptr(), data.Count());
+
+    BE1::GameWorld *gameWorld = (BE1::GameWorld *)BE1::GameWorld::CreateInstance();
+
+    bool loaded = gameWorld->LoadMap(MAP_FILENAME, BE1::GameWorld::LoadSceneMode::Single) &&
+        gameWorld->FindEntityByName("Entity 0") && gameWorld->FindEntityByName(BE1::va("Entity %i", SPAWN_ENTITY_COUNT - 1));
+
+    BE1::GameWorld::DestroyInstanceImmediate(gameWorld);
+
+    BE1::fileSystem.RemoveFile(MAP_FILENAME, false);
+
+    return loaded;
+}
+
+void TestBinarySerializer() {
+    RegisterTestObjectProperties();
+
+    Json::Value map;
+    MakeMapValue(map);
+
+    Json::FastWriter jsonWriter;
+    const std::string jsonText = jsonWriter.write(map);
+
+    BE1::Array<byte> data;
+    BE1::BinarySerializer::FromJson(map, data);
+
+    // JSON -> binary -> JSON should be lossless
+    BE1::BinaryDeserializer reader;
+    bool opened = reader.Open(data.Ptr(), data.Count());
+
+    Json::Value convertedMap;
+    if (opened) {
+        reader.ToJson(convertedMap);
+    }
+
+    bool identical = opened && convertedMap == map;
+
+    BE_LOG(L"BinarySerializer: %i entities, JSON %i bytes, binary %i bytes, round trip %ls\n",
+        reader.NumEntities(), (int)jsonText.length(), data.Count(), identical ? L"ok" : L"FAILED");
+
+    // Binary data from a JSON array root should give back the array
+    BE1::Array<byte> prefabData;
+    BE1::BinarySerializer::FromJson(map["entities"], prefabData);
+
+    Json::Value convertedEntities;
+    BE1::BinaryDeserializer prefabReader;
+    if (prefabReader.Open(prefabData.Ptr(), prefabData.Count())) {
+        prefabReader.ToJson(convertedEntities);
+    }
+
+    BE_LOG(L"BinarySerializer: array root round trip %ls\n", convertedEntities == map["entities"] ? L"ok" : L"FAILED");
+
+    // Lists of mixed types and nested arrays are read as the registered property type
+    BE1::Variant value;
+    BE1::BinaryProperty mixedProp = reader.GetRoot().FindProperty("editorData").GetObject().FindProperty("mixedNumbers");
+    bool listOK = mixedProp.IsList() && mixedProp.Count() == 5 &&
+        mixedProp.GetValue(BE1::Variant::FloatType, value, 1) && value.As<float>() == 2.5f &&
+        mixedProp.GetValue(BE1::Variant::Int64Type, value, 2) && value.As<int64_t>() == 3000000000LL;
+    BE1::BinaryProperty nestedProp = reader.GetRoot().FindProperty("editorData").GetObject().FindProperty("nestedArrays");
+    listOK = listOK && nestedProp.IsList() && nestedProp.GetListElement(0).IsArray() && !nestedProp.GetValue(value, 0) &&
+        nestedProp.GetListElement(2).GetObject(2).FindProperty("b").IsValid();
+
+    BE_LOG(L"BinarySerializer: mixed type and nested arrays %ls\n", listOK ? L"ok" : L"FAILED");
+
+    BE_LOG(L"BinarySerializer: spawning %i entities from binary %ls\n", SPAWN_ENTITY_COUNT, TestSpawnEntities() ? L"ok" : L"FAILED");
+
+    BE_LOG(L"BinarySerializer: loading map without render settings %ls\n", TestLoadMapWithoutRenderSettings() ? L"ok" : L"FAILED");
+
+    // Truncated or corrupted data should be rejected
+    BE1::BinaryDeserializer badReader;
+    bool rejected = !badReader.Open(data.Ptr(), data.Count() / 2);
+
+    const BE1::BinaryDeserializer::Header *header = (const BE1::BinaryDeserializer::Header *)data.Ptr();
+    const int headerSize = sizeof(BE1::BinaryDeserializer::Header);
+
+    // Offsets in the data to be corrupted: root object size, payload size of the first property in the root object,
+    // first and last entity index, first string offset, entity index offset in the header
+    const int corruptedOffsets[] = {
+        headerSize, headerSize + 8 + 8,
+        (int)header->entityIndexOffset, (int)(header->entityIndexOffset + (header->numEntities - 1) * sizeof(uint32_t)),
+        (int)header->stringTableOffset, (int)offsetof(BE1::BinaryDeserializer::Header, entityIndexOffset)
+    };
+    const uint32_t corruptedValues[] = { 0xFFFFFF00, 0xFFFFFFF0, 2 };
+
+    for (int i = 0; i < COUNT_OF(corruptedOffsets); i++) {
+        for (int j = 0; j < COUNT_OF(corruptedValues); j++) {
+            BE1::Array<byte> corruptedData = data;
+            *(uint32_t *)&corruptedData[corruptedOffsets[i]] = corruptedValues[j];
+            rejected &= !badReader.Open(corruptedData.Ptr(), corruptedData.Count());
+        }
+    }
+
+    // Entity index pointing into the middle of a record
+    BE1::Array<byte> corruptedData = data;
+    *(uint32_t *)&corruptedData[header->entityIndexOffset] += 4;
+    rejected &= !badReader.Open(corruptedData.Ptr(), corruptedData.Count());
+
+    BE_LOG(L"BinarySerializer: bad data %ls\n", rejected ? L"rejected" : L"ACCEPTED");
+
+    // Compare parsing and reading the entities
+    uint64_t jsonTime = 0;
+    uint64_t binaryTime = 0;
+    int jsonValues = 0;
+    int binaryValues = 0;
+
+    for (int i = 0; i < LOAD_COUNT; i++) {
+        uint64_t start = BE1::PlatformTime::Microseconds();
+
+        Json::Value parsedMap;
+        Json::Reader jsonReader;
+        jsonReader.parse(jsonText.c_str(), jsonText.c_str() + jsonText.length(), parsedMap);
+        jsonValues = WalkEntities(parsedMap);
+
+        jsonTime += BE1::PlatformTime::Microseconds() - start;
+
+        start = BE1::PlatformTime::Microseconds();
+
+        BE1::BinaryDeserializer loadReader;
+        loadReader.Open(data.Ptr(), data.Count());
+        binaryValues = WalkEntities(loadReader);
+
+        binaryTime += BE1::PlatformTime::Microseconds() - start;
+    }
+
+    BE_LOG(L"BinarySerializer: JSON parse + read %.2f ms (%i values), binary open + read %.2f ms (%i values), %.1fx\n",
+        jsonTime / 1000.0f / LOAD_COUNT, jsonValues, binaryTime / 1000.0f / LOAD_COUNT, binaryValues, (float)jsonTime / (binaryTime ? binaryTime : 1));
+}
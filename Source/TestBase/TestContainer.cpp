@@ -64,6 +64,313 @@ static void TestHashLinkMap() {
     }
 }
 
+#define GROWTH_COUNT        10000
+
+// Counts constructions, copies and moves of the elements
+class TrackedStr {
+public:
+    TrackedStr() { numConstructs++; }
+    TrackedStr(const char *s) : str(s) { numConstructs++; }
+    TrackedStr(const TrackedStr &rhs) : str(rhs.str) { numCopies++; }
+    TrackedStr(TrackedStr &&rhs) noexcept : str(std::move(rhs.str)) { numMoves++; }
+
+    TrackedStr &operator=(const TrackedStr &rhs) { str = rhs.str; numCopies++; return *this; }
+    TrackedStr &operator=(TrackedStr &&rhs) noexcept { str = std::move(rhs.str); numMoves++; return *this; }
+
+    bool operator==(const TrackedStr &rhs) const { return str == rhs.str; }
+
+    static void ResetCounts() { numConstructs = numCopies = numMoves = 0; }
+
+    BE1::Str str;
+
+    static int numConstructs;
+    static int numCopies;
+    static int numMoves;
+};
+
+int TrackedStr::numConstructs = 0;
+int TrackedStr::numCopies = 0;
+int TrackedStr::numMoves = 0;
+
+// Growth of the previous Array implementation, which default-constructs every slot of 
+// the new storage with new T[] and then copy-assigns the elements one at a time.
+template <typename T>
+class CopyGrowthArray {
+public:
+    CopyGrowthArray() : count(0), capacity(0), numAllocs(0), elements(nullptr) {}
+    ~CopyGrowthArray() { delete [] elements; }
+
+    void Append(const T &value) {
+        if (count == capacity) {
+            T *temp = elements;
+            capacity += BE1::Array<T>::DefaultGranularity;
+            elements = new T[capacity];
+            numAllocs++;
+            for (int i = 0; i < count; i++) {
+                elements[i] = temp[i];
+            }
+            delete [] temp;
+        }
+        elements[count++] = value;
+    }
+
+    int count;
+    int capacity;
+    int numAllocs;
+    T *elements;
+};
+
+// Counts reallocations of Array by watching the capacity.
+template <typename T>
+static int AppendCounting(BE1::Array<T> &array, T &&value) {
+    int capacity = array.Capacity();
+    array.Append(std::move(value));
+    return array.Capacity() != capacity ? 1 : 0;
+}
+
+static const char *LongString(int i) {
+    // Longer than the base buffer of Str to allocate on every deep copy
+    return BE1::va("element string number %i with some padding", i);
+}
+
+static void TestArrayGrowth() {
+    // Array<Str> growth
+    {
+        TrackedStr::ResetCounts();
+
+        uint64_t start = BE1::PlatformTime::Microseconds();
+        CopyGrowthArray<TrackedStr> before;
+        for (int i = 0; i < GROWTH_COUNT; i++) {
+            before.Append(TrackedStr(LongString(i)));
+        }
+        uint64_t beforeTime = BE1::PlatformTime::Microseconds() - start;
+
+        BE_LOG(L"Array<Str> growth before (%i elements): %.2f ms, %i reallocations, %i constructions, %i copies, %i moves\n",
+            GROWTH_COUNT, beforeTime / 1000.0f, before.numAllocs, TrackedStr::numConstructs, TrackedStr::numCopies, TrackedStr::numMoves);
+
+        TrackedStr::ResetCounts();
+
+        int numAllocs = 0;
+        start = BE1::PlatformTime::Microseconds();
+        BE1::Array<TrackedStr> after;
+        for (int i = 0; i < GROWTH_COUNT; i++) {
+            numAllocs += AppendCounting(after, TrackedStr(LongString(i)));
+        }
+        uint64_t afterTime = BE1::PlatformTime::Microseconds() - start;
+
+        BE_LOG(L"Array<Str> growth after (%i elements): %.2f ms, %i reallocations, %i constructions, %i copies, %i moves\n",
+            GROWTH_COUNT, afterTime / 1000.0f, numAllocs, TrackedStr::numConstructs, TrackedStr::numCopies, TrackedStr::numMoves);
+    }
+
+    // Array<Vec3> growth
+    {
+        uint64_t start = BE1::PlatformTime::Microseconds();
+        CopyGrowthArray<BE1::Vec3> before;
+        for (int i = 0; i < GROWTH_COUNT; i++) {
+            before.Append(BE1::Vec3((float)i));
+        }
+        uint64_t beforeTime = BE1::PlatformTime::Microseconds() - start;
+
+        int numAllocs = 0;
+        start = BE1::PlatformTime::Microseconds();
+        BE1::Array<BE1::Vec3> after;
+        for (int i = 0; i < GROWTH_COUNT; i++) {
+            numAllocs += AppendCounting(after, BE1::Vec3((float)i));
+        }
+        uint64_t afterTime = BE1::PlatformTime::Microseconds() - start;
+
+        BE_LOG(L"Array<Vec3> growth (%i elements, %i reallocations): before %.2f ms, after %.2f ms\n",
+            GROWTH_COUNT, numAllocs, beforeTime / 1000.0f, afterTime / 1000.0f);
+    }
+}
+
+static void TestArrayEmplace() {
+    BE1::Array<BE1::Str> array;
+    array.Emplace("b");
+    array.Emplace("d");
+    array.EmplaceAt(0, "a");
+    array.EmplaceAt(2, "c");
+    array.Append(BE1::Str("e"));
+
+    // Appending an element of the array itself while growing
+    for (int i = 0; i < 20; i++) {
+        array.Append(array[0]);
+    }
+
+    BE1::Array<BE1::Str> tail = { "x", "y" };
+    array.InsertArray(tail, 1);
+    array.RemoveIndex(0);
+    array.RemoveIndexFast(array.Count() - 1);
+
+    BE1::Str joined;
+    for (int i = 0; i < 6; i++) {
+        joined += array[i];
+    }
+
+    BE1::Array<BE1::Str> moved(std::move(array));
+
+    bool ok = joined == "xybcde" && moved.Count() == 25 && moved[24] == "a" && array.Count() == 0;
+    BE_LOG(L"Array emplace/insert/remove: %ls\n", ok ? L"ok" : L"FAILED");
+}
+
+static void TestPropertyInfoTable() {
+    const int NUM_PROPERTIES = 40;
+    const int NUM_LOOKUPS = 10000;
+
+    BE1::Array<BE1::PropertyInfo> registered;
+    for (int i = 0; i < NUM_PROPERTIES; i++) {
+        BE1::Str name = BE1::Str("property") + BE1::Str(i);
+        registered.Append(BE1::PropertyInfo(name.c_str(), name.c_str(), BE1::Variant::IntType, i * sizeof(int), 0, "", 0));
+    }
+
+    BE1::PropertyInfoTable table;
+    for (int i = 0; i < registered.Count(); i++) {
+        table.Append(registered[i]);
+    }
+
+    bool ok = !table.Append(registered[3]) && table.Count() == NUM_PROPERTIES && !table.Find("property") && !table.Find("");
+    for (int i = 0; i < NUM_PROPERTIES; i++) {
+        ok = ok && table.FindIndex(registered[i].GetName()) == i;
+    }
+    BE_LOG(L"PropertyInfoTable lookup: %ls\n", ok ? L"ok" : L"FAILED");
+
+    // Previous lookup: flattened copy with de-duplication for each call, then linear search
+    int found = 0;
+    uint64_t start = BE1::PlatformTime::Microseconds();
+    for (int i = 0; i < NUM_LOOKUPS; i++) {
+        BE1::Array<BE1::Str> names;
+        BE1::Array<BE1::PropertyInfo> list;
+        for (int j = 0; j < registered.Count(); j++) {
+            if (!names.Find(registered[j].GetName())) {
+                names.Append(registered[j].GetName());
+                list.Append(registered[j]);
+            }
+        }
+        const char *name = registered[i % NUM_PROPERTIES].GetName();
+        for (int j = 0; j < list.Count(); j++) {
+            if (!BE1::Str::Cmp(list[j].GetName(), name)) {
+                found++;
+                break;
+            }
+        }
+    }
+    uint64_t beforeTime = BE1::PlatformTime::Microseconds() - start;
+
+    start = BE1::PlatformTime::Microseconds();
+    for (int i = 0; i < NUM_LOOKUPS; i++) {
+        if (table.Find(registered[i % NUM_PROPERTIES].GetName())) {
+            found++;
+        }
+    }
+    uint64_t afterTime = BE1::PlatformTime::Microseconds() - start;
+
+    BE_LOG(L"PropertyInfoTable (%i lookups in %i properties, %i found): before %.2f ms, after %.2f ms\n",
+        NUM_LOOKUPS, NUM_PROPERTIES, found, beforeTime / 1000.0f, afterTime / 1000.0f);
+}
+
+class TestPropertyBase : public BE1::Object {
+public:
+    OBJECT_PROTOTYPE(TestPropertyBase);
+
+    TestPropertyBase() {}
+
+    int                     shared = 0;
+    int                     baseOnly = 0;
+    int                     late = 0;
+};
+
+class TestPropertyDerived : public TestPropertyBase {
+public:
+    OBJECT_PROTOTYPE(TestPropertyDerived);
+
+    TestPropertyDerived() {}
+
+    int                     derivedOnly = 0;
+};
+
+BEGIN_EVENTS(TestPropertyBase)
+END_EVENTS
+
+BEGIN_EVENTS(TestPropertyDerived)
+END_EVENTS
+
+OBJECT_DECLARATION("TestPropertyBase", TestPropertyBase, Object)
+OBJECT_DECLARATION("TestPropertyDerived", TestPropertyDerived, TestPropertyBase)
+
+void TestPropertyBase::RegisterProperties() {
+    REGISTER_PROPERTY("shared", "Base Shared", int, shared, 0, "", 0);
+    REGISTER_PROPERTY("baseOnly", "Base Only", int, baseOnly, 0, "", 0);
+}
+
+void TestPropertyDerived::RegisterProperties() {
+    REGISTER_PROPERTY("derivedOnly", "Derived Only", int, derivedOnly, 0, "", 0);
+    REGISTER_PROPERTY("shared", "Derived Shared", int, shared, 0, "", 0);
+}
+
+static bool HasOrder(const BE1::PropertyInfoTable &table, const char **names, int count) {
+    if (table.Count() != count) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (BE1::Str::Cmp(table[i].GetName(), names[i]) || table.FindIndex(names[i]) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void TestMetaObjectPropertyTable() {
+    TestPropertyBase::RegisterProperties();
+    TestPropertyDerived::RegisterProperties();
+
+    const BE1::PropertyInfoTable &baseTable = TestPropertyBase::metaObject.GetPropertyInfoTable();
+    const BE1::PropertyInfoTable &derivedTable = TestPropertyDerived::metaObject.GetPropertyInfoTable();
+
+    // Properties of the derived class come first, then the ones of the base class that are not overridden
+    const char *baseNames[] = { "shared", "baseOnly" };
+    const char *derivedNames[] = { "derivedOnly", "shared", "baseOnly" };
+
+    bool flattenOK = HasOrder(baseTable, baseNames, COUNT_OF(baseNames)) && HasOrder(derivedTable, derivedNames, COUNT_OF(derivedNames));
+
+    bool overrideOK = derivedTable.Find("shared") && !BE1::Str::Cmp(derivedTable.Find("shared")->GetLabel(), "Derived Shared") &&
+        baseTable.Find("shared") && !BE1::Str::Cmp(baseTable.Find("shared")->GetLabel(), "Base Shared");
+
+    // Registering a property afterwards invalidates the tables of the class and its derived classes
+    TestPropertyBase::metaObject.RegisterProperty(BE1::PropertyInfo("late", "Late", BE1::Variant::IntType, ::offset_of(&TestPropertyBase::late), 0, "", 0));
+
+    const int numThreads = BE1::jobSystem.IsInitialized() ? BE1::jobSystem.NumThreads() : 1;
+    std::atomic<int> numStaleTables(0);
+
+    // Tables are rebuilt once even if they are requested from multiple threads at the same time
+    auto getTables = [&numStaleTables](int first, int last) {
+        for (int i = first; i < last; i++) {
+            if (TestPropertyDerived::metaObject.GetPropertyInfoTable().Count() != 4 || TestPropertyBase::metaObject.GetPropertyInfoTable().Count() != 3) {
+                numStaleTables++;
+            }
+        }
+    };
+
+    if (numThreads > 1) {
+        BE1::jobSystem.ParallelFor(numThreads * 16, 1, getTables);
+    } else {
+        getTables(0, 16);
+    }
+
+    const char *invalidatedNames[] = { "derivedOnly", "shared", "baseOnly", "late" };
+    bool invalidateOK = numStaleTables == 0 && HasOrder(TestPropertyDerived::metaObject.GetPropertyInfoTable(), invalidatedNames, COUNT_OF(invalidatedNames));
+
+    BE_LOG(L"MetaObject property table: flatten %ls, override %ls, invalidate %ls\n",
+        flattenOK ? L"ok" : L"FAILED", overrideOK ? L"ok" : L"FAILED", invalidateOK ? L"ok" : L"FAILED");
+}
+
 void TestContainer() {
     TestHashLinkMap();
+
+    TestArrayEmplace();
+
+    TestArrayGrowth();
+
+    TestPropertyInfoTable();
+
+    TestMetaObjectPropertyTable();
 }
\ No newline at end of file
@@ -0,0 +1,179 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "BlueshiftEngine.h"
+#include "TestDXTEncoder.h"
+
+#define TEST_IMAGE_SIZE     1024
+
+typedef void (*compressImageFunction_t)(const byte *src, const int width, const int height, const int depth, byte *dst, int flags);
+typedef void (*decompressImageFunction_t)(const BE1::DXTBlock *dxtBlock, const int width, const int height, const int depth, byte *out);
+
+struct EncoderTest {
+    const wchar_t *             name;
+    int                         blockSize;
+    int                         numChannels;        // channels to measure the error
+    compressImageFunction_t     compressFast;
+    compressImageFunction_t     compressHQ;
+    decompressImageFunction_t   decompress;
+};
+
+// Smooth gradients with noise, hard edges and an alpha ramp
+static void MakeTestImage(byte *dst, int width, int height) {
+    uint32_t seed = 12345;
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            seed = seed * 1664525 + 1013904223;
+            int noise = (int)(seed >> 28) - 8;
+
+            dst[0] = (byte)BE1::Clamp(x * 255 / width + noise, 0, 255);
+            dst[1] = (byte)(127.5f + 127.5f * BE1::Math::Sin(y * 0.05f) * BE1::Math::Cos(x * 0.03f));
+            dst[2] = ((x / 24) ^ (y / 24)) & 1 ? 220 : 30;
+            dst[3] = (byte)((x + y) * 255 / (width + height));
+            dst += 4;
+        }
+    }
+}
+
+static float PSNR(const byte *image1, const byte *image2, int numPixels, int numChannels) {
+    double sum = 0.0;
+
+    for (int i = 0; i < numPixels; i++) {
+        for (int c = 0; c < numChannels; c++) {
+            int d = (int)image1[i * 4 + c] - (int)image2[i * 4 + c];
+            sum += d * d;
+        }
+    }
+
+    double rmse = sqrt(sum / (numPixels * numChannels));
+    return rmse > 0.0 ? (float)(20.0 * log10(255.0 / rmse)) : 99.0f;
+}
+
+// Returns throughput in MPix/s
+static float Encode(compressImageFunction_t compress, const byte *src, int width, int height, int depth, byte *dst, int flags) {
+    uint64_t start = BE1::PlatformTime::Microseconds();
+    compress(src, width, height, depth, dst, flags);
+    uint64_t usec = BE1::Max(BE1::PlatformTime::Microseconds() - start, (uint64_t)1);
+
+    return (float)width * height * depth / usec;
+}
+
+static float Encode(compressImageFunction_t compress, const byte *src, byte *dst, int flags) {
+    return Encode(compress, src, TEST_IMAGE_SIZE, TEST_IMAGE_SIZE, 1, dst, flags);
+}
+
+static float Decode(const EncoderTest &test, const byte *src, const byte *encoded, byte *decoded) {
+    test.decompress((const BE1::DXTBlock *)encoded, TEST_IMAGE_SIZE, TEST_IMAGE_SIZE, 1, decoded);
+
+    return PSNR(src, decoded, TEST_IMAGE_SIZE * TEST_IMAGE_SIZE, test.numChannels);
+}
+
+// The scalar single threaded encoder is the reference, SIMD and threads must give the same blocks.
+// Edge blocks of the sizes which are not multiple of 4 and the slices of 3D images are encoded too.
+static bool TestIdenticalOutput(const EncoderTest &test, const byte *src, byte *reference, byte *encoded, float &referenceRate, float &simdRate, float &parallelRate) {
+    struct ImageSize {
+        int width;
+        int height;
+        int depth;
+    };
+    const ImageSize sizes[] = {
+        { TEST_IMAGE_SIZE, TEST_IMAGE_SIZE, 1 },
+        { 301, 203, 1 },
+        { 66, 50, 5 }
+    };
+
+    bool identical = true;
+
+    for (int i = 0; i < COUNT_OF(sizes); i++) {
+        const ImageSize &size = sizes[i];
+        const int encodedSize = ((size.width + 3) / 4) * ((size.height + 3) / 4) * size.depth * test.blockSize;
+
+        float rate = Encode(test.compressFast, src, size.width, size.height, size.depth, reference, BE1::DXTEncoder::Flag::NoSIMD | BE1::DXTEncoder::Flag::SingleThread);
+
+        memset(encoded, 0, encodedSize);
+        float simd = Encode(test.compressFast, src, size.width, size.height, size.depth, encoded, BE1::DXTEncoder::Flag::SingleThread);
+        bool simdIdentical = !memcmp(reference, encoded, encodedSize);
+
+        memset(encoded, 0, encodedSize);
+        float parallel = Encode(test.compressFast, src, size.width, size.height, size.depth, encoded, 0);
+        bool parallelIdentical = !memcmp(reference, encoded, encodedSize);
+
+        if (!simdIdentical || !parallelIdentical) {
+            BE_LOG(L"%ls fast %ix%ix%i: %ls differs from scalar\n", test.name, size.width, size.height, size.depth,
+                !simdIdentical ? L"SIMD" : L"SIMD + threads");
+            identical = false;
+        }
+
+        // Throughput is reported for the first size
+        if (i == 0) {
+            referenceRate = rate;
+            simdRate = simd;
+            parallelRate = parallel;
+        }
+    }
+
+    return identical;
+}
+
+void TestDXTEncoder() {
+    BE_LOG(L"--- TestDXTEncoder ---\n");
+
+    const EncoderTest tests[] = {
+        { L"DXT1", 8, 3, BE1::DXTEncoder::CompressImageDXT1Fast, BE1::DXTEncoder::CompressImageDXT1HQ, BE1::DXTDecoder::DecompressImageDXT1 },
+        { L"DXT3", 16, 4, BE1::DXTEncoder::CompressImageDXT3Fast, BE1::DXTEncoder::CompressImageDXT3HQ, BE1::DXTDecoder::DecompressImageDXT3 },
+        { L"DXT5", 16, 4, BE1::DXTEncoder::CompressImageDXT5Fast, BE1::DXTEncoder::CompressImageDXT5HQ, BE1::DXTDecoder::DecompressImageDXT5 },
+        { L"DXN2", 16, 2, BE1::DXTEncoder::CompressImageDXN2Fast, BE1::DXTEncoder::CompressImageDXN2HQ, BE1::DXTDecoder::DecompressImageDXN2 }
+    };
+
+    const int numPixels = TEST_IMAGE_SIZE * TEST_IMAGE_SIZE;
+    const int maxEncodedSize = numPixels;
+
+    byte *src = (byte *)BE1::Mem_Alloc16(numPixels * 4);
+    byte *decoded = (byte *)BE1::Mem_Alloc16(numPixels * 4);
+    byte *reference = (byte *)BE1::Mem_Alloc16(maxEncodedSize);
+    byte *encoded = (byte *)BE1::Mem_Alloc16(maxEncodedSize);
+
+    MakeTestImage(src, TEST_IMAGE_SIZE, TEST_IMAGE_SIZE);
+
+    for (int i = 0; i < COUNT_OF(tests); i++) {
+        const EncoderTest &test = tests[i];
+
+        // Fast path
+        float referenceRate, simdRate, parallelRate;
+        bool identical = TestIdenticalOutput(test, src, reference, encoded, referenceRate, simdRate, parallelRate);
+
+        Encode(test.compressFast, src, reference, BE1::DXTEncoder::Flag::NoSIMD | BE1::DXTEncoder::Flag::SingleThread);
+        float referencePSNR = Decode(test, src, reference, decoded);
+
+        BE_LOG(L"%ls fast: %ls (%.2f dB, scalar %.1f MPix/s, SIMD %.1f MPix/s, SIMD + threads %.1f MPix/s)\n", test.name,
+            identical ? L"OK" : L"FAILED", referencePSNR, referenceRate, simdRate, parallelRate);
+
+        // HQ path: least squares refinement never makes the error worse
+        referenceRate = Encode(test.compressHQ, src, reference, BE1::DXTEncoder::Flag::NoRefinement | BE1::DXTEncoder::Flag::SingleThread);
+        referencePSNR = Decode(test, src, reference, decoded);
+
+        float hqRate = Encode(test.compressHQ, src, encoded, 0);
+        float hqPSNR = Decode(test, src, encoded, decoded);
+
+        BE_LOG(L"%ls HQ: %ls (%.2f dB -> %.2f dB, %.1f MPix/s -> %.1f MPix/s)\n", test.name,
+            hqPSNR >= referencePSNR ? L"OK" : L"FAILED", referencePSNR, hqPSNR, referenceRate, hqRate);
+    }
+
+    BE1::Mem_AlignedFree(src);
+    BE1::Mem_AlignedFree(decoded);
+    BE1::Mem_AlignedFree(reference);
+    BE1::Mem_AlignedFree(encoded);
+}
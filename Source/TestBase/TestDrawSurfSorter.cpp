@@ -0,0 +1,133 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestDrawSurfSorter.h"
+
+#define SORT_COUNT          20
+
+// Keys laid out like the drawSurf sort keys: light index, then sort order, material and entity.
+// Only a few distinct values per field, so that there are many equal keys and shared bytes.
+static void MakeSortKeys(BE1::Array<uint64_t> &sortKeys, int count) {
+    BE1::Random random(count);
+
+    sortKeys.SetCount(count);
+
+    for (int i = 0; i < count; i++) {
+        uint64_t lightIndex = random.RandomInt(32);
+        uint64_t sortOrder = random.RandomInt(4);
+        uint64_t materialIndex = random.RandomInt(200);
+        uint64_t entityIndex = random.RandomInt(count / 4);
+
+        sortKeys[i] = (lightIndex << 52) | (sortOrder << 44) | (materialIndex << 24) | entityIndex;
+    }
+}
+
+static int CompareSortKeys(const void *a, const void *b) {
+    const uint64_t *key1 = *(const uint64_t **)a;
+    const uint64_t *key2 = *(const uint64_t **)b;
+
+    if (*key1 != *key2) {
+        return *key1 < *key2 ? -1 : 1;
+    }
+    return key1 < key2 ? -1 : (key1 > key2 ? 1 : 0);
+}
+
+// Returns the number of keys which are not in the order of a stable sort.
+static int CountMisplacedKeys(const BE1::DrawSurfSorter::SortKey *sortedKeys, const uint64_t *const *expected, const uint64_t *sortKeys, int count) {
+    int numMisplaced = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (sortedKeys[i].index != (int32_t)(expected[i] - sortKeys) || sortedKeys[i].sortKey != *expected[i]) {
+            numMisplaced++;
+        }
+    }
+    return numMisplaced;
+}
+
+static void TestSort(BE1::DrawSurfSorter &sorter, int count) {
+    BE1::Array<uint64_t> sortKeys;
+    MakeSortKeys(sortKeys, count);
+
+    // Reference: qsort of key pointers, which orders equal keys by their index
+    BE1::Array<const uint64_t *> expected;
+    expected.SetCount(count);
+    for (int i = 0; i < count; i++) {
+        expected[i] = &sortKeys[i];
+    }
+
+    uint64_t start = BE1::PlatformTime::Microseconds();
+    for (int n = 0; n < SORT_COUNT; n++) {
+        for (int i = 0; i < count; i++) {
+            expected[i] = &sortKeys[i];
+        }
+        qsort(expected.Ptr(), count, sizeof(expected[0]), CompareSortKeys);
+    }
+    uint64_t qsortTime = BE1::PlatformTime::Microseconds() - start;
+
+    uint64_t sortTime[2] = { 0, 0 };
+    int numMisplaced[2] = { 0, 0 };
+
+    for (int pass = 0; pass < 2; pass++) {
+        bool parallel = pass == 1;
+
+        start = BE1::PlatformTime::Microseconds();
+        for (int n = 0; n < SORT_COUNT; n++) {
+            BE1::DrawSurfSorter::SortKey *keys = sorter.SetKeys(count);
+            for (int i = 0; i < count; i++) {
+                keys[i].sortKey = sortKeys[i];
+                keys[i].index = i;
+            }
+            sorter.Sort(parallel);
+        }
+        sortTime[pass] = BE1::PlatformTime::Microseconds() - start;
+
+        BE1::DrawSurfSorter::SortKey *keys = sorter.SetKeys(count);
+        for (int i = 0; i < count; i++) {
+            keys[i].sortKey = sortKeys[i];
+            keys[i].index = i;
+        }
+        numMisplaced[pass] = CountMisplacedKeys(sorter.Sort(parallel), expected.Ptr(), sortKeys.Ptr(), count);
+    }
+
+    BE_LOG(L"DrawSurfSorter::Sort (%i keys): %i/%i misplaced keys %ls, qsort %.1f us, radix %.1f us, radix parallel %.1f us\n",
+        count, numMisplaced[0], numMisplaced[1], numMisplaced[0] == 0 && numMisplaced[1] == 0 ? L"OK" : L"FAILED",
+        (float)qsortTime / SORT_COUNT, (float)sortTime[0] / SORT_COUNT, (float)sortTime[1] / SORT_COUNT);
+}
+
+void TestDrawSurfSorter() {
+    BE_LOG(L"--- TestDrawSurfSorter ---\n");
+
+    BE1::DrawSurfSorter sorter;
+
+    // Equal keys only, all the passes are skipped
+    BE1::DrawSurfSorter::SortKey *keys = sorter.SetKeys(100);
+    for (int i = 0; i < 100; i++) {
+        keys[i].sortKey = 0x1234;
+        keys[i].index = i;
+    }
+    const BE1::DrawSurfSorter::SortKey *sortedKeys = sorter.Sort();
+    int numMisplaced = 0;
+    for (int i = 0; i < 100; i++) {
+        if (sortedKeys[i].index != i) {
+            numMisplaced++;
+        }
+    }
+    BE_LOG(L"DrawSurfSorter::Sort (equal keys): %i misplaced keys %ls\n", numMisplaced, numMisplaced == 0 ? L"OK" : L"FAILED");
+
+    // Sizes below and above the parallel threshold
+    TestSort(sorter, 1000);
+    TestSort(sorter, 16384);
+    TestSort(sorter, 100000);
+}
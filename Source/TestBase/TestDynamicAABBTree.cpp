@@ -0,0 +1,240 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestDynamicAABBTree.h"
+
+#define PROXY_COUNT         100000
+#define QUERY_COUNT         256
+#define WORLD_EXTENT        2000.0f
+
+static uint64_t TestFrustumQuery(const BE1::DynamicAABBTree &tree, const BE1::Frustum *frustums, BE1::DynamicAABBTree::FrustumCullMethod cullMethod, int &numVisitedNodes, int &numHits) {
+    numVisitedNodes = 0;
+    numHits = 0;
+
+    auto callback = [&numHits](int32_t proxyId) -> bool {
+        numHits++;
+        return true;
+    };
+
+    uint64_t start = BE1::PlatformTime::Microseconds();
+
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        numVisitedNodes += tree.QueryFrustum(frustums[i], callback, cullMethod);
+    }
+
+    return BE1::PlatformTime::Microseconds() - start;
+}
+
+// Returns the number of frustums for which the culling methods don't find the same proxies.
+static int CompareFrustumQueries(const BE1::DynamicAABBTree &tree, const BE1::Frustum *frustums) {
+    BE1::Array<int32_t> allPlanesProxies;
+    BE1::Array<int32_t> planeMaskProxies;
+    int numMismatches = 0;
+
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        allPlanesProxies.SetCount(0, false);
+        planeMaskProxies.SetCount(0, false);
+
+        auto allPlanesCallback = [&allPlanesProxies](int32_t proxyId) -> bool {
+            allPlanesProxies.Append(proxyId);
+            return true;
+        };
+        auto planeMaskCallback = [&planeMaskProxies](int32_t proxyId) -> bool {
+            planeMaskProxies.Append(proxyId);
+            return true;
+        };
+
+        tree.QueryFrustum(frustums[i], allPlanesCallback, BE1::DynamicAABBTree::AllPlanesCull);
+        tree.QueryFrustum(frustums[i], planeMaskCallback, BE1::DynamicAABBTree::PlaneMaskCull);
+
+        allPlanesProxies.Sort();
+        planeMaskProxies.Sort();
+
+        if (allPlanesProxies.Count() != planeMaskProxies.Count() ||
+            memcmp(allPlanesProxies.Ptr(), planeMaskProxies.Ptr(), allPlanesProxies.Count() * sizeof(int32_t))) {
+            numMismatches++;
+        }
+    }
+
+    return numMismatches;
+}
+
+// Returns the number of frustums for which the query that skips the nodes on the negative x side
+// doesn't find the same proxies on the positive x side as the plain query, or finds a proxy that the plain query doesn't.
+static int CompareCulledFrustumQueries(const BE1::DynamicAABBTree &tree, const BE1::Frustum *frustums) {
+    BE1::Array<int32_t> plainProxies;
+    BE1::Array<int32_t> culledProxies;
+    int32_t root;
+    int numMismatches = 0;
+
+    tree.GetSubtreeRoots(1, &root);
+
+    auto cullNode = [](const BE1::AABB &aabb) -> bool {
+        return aabb[1].x < 0.0f;
+    };
+
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        plainProxies.SetCount(0, false);
+        culledProxies.SetCount(0, false);
+
+        auto plainCallback = [&plainProxies](int32_t proxyId) -> bool {
+            plainProxies.Append(proxyId);
+            return true;
+        };
+        auto culledCallback = [&culledProxies](int32_t proxyId) -> bool {
+            culledProxies.Append(proxyId);
+            return true;
+        };
+
+        tree.Query(frustums[i], plainCallback);
+        tree.Query(frustums[i], culledCallback, cullNode, root);
+
+        plainProxies.Sort();
+        culledProxies.Sort();
+
+        bool mismatch = false;
+
+        // Culled nodes must not hide the proxies outside of them
+        for (int j = 0; j < plainProxies.Count() && !mismatch; j++) {
+            if (tree.GetFatAABB(plainProxies[j])[1].x >= 0.0f && !std::binary_search(culledProxies.Ptr(), culledProxies.Ptr() + culledProxies.Count(), plainProxies[j])) {
+                mismatch = true;
+            }
+        }
+
+        for (int j = 0; j < culledProxies.Count() && !mismatch; j++) {
+            if (!std::binary_search(plainProxies.Ptr(), plainProxies.Ptr() + plainProxies.Count(), culledProxies[j])) {
+                mismatch = true;
+            }
+        }
+
+        if (mismatch) {
+            numMismatches++;
+        }
+    }
+
+    return numMismatches;
+}
+
+static void TestRayCast(const BE1::DynamicAABBTree &tree, const BE1::AABB *aabbs) {
+    BE1::Vec3 *starts = new BE1::Vec3[QUERY_COUNT];
+    BE1::Vec3 *dirs = new BE1::Vec3[QUERY_COUNT];
+    int *closestProxies = new int[QUERY_COUNT];
+
+    // Picking rays looking down from above the scene
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        starts[i].Set(BE1::Math::Random(-WORLD_EXTENT, WORLD_EXTENT), BE1::Math::Random(-WORLD_EXTENT, WORLD_EXTENT), 200.0f);
+        dirs[i].Set(BE1::Math::Random(-1.0f, 1.0f), BE1::Math::Random(-1.0f, 1.0f), -1.0f);
+        dirs[i].Normalize();
+    }
+
+    // Brute force
+    uint64_t start = BE1::PlatformTime::Microseconds();
+
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        float minScale = FLT_MAX;
+        closestProxies[i] = -1;
+
+        for (int j = 0; j < PROXY_COUNT; j++) {
+            float scale = aabbs[j].RayIntersection(starts[i], dirs[i]);
+            if (scale < minScale) {
+                minScale = scale;
+                closestProxies[i] = j;
+            }
+        }
+    }
+
+    uint64_t bruteForceTime = BE1::PlatformTime::Microseconds() - start;
+
+    // Front-to-back traversal with early termination
+    int numMismatches = 0;
+
+    start = BE1::PlatformTime::Microseconds();
+
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        int closestProxy = -1;
+
+        auto callback = [&](int32_t proxyId, float maxScale) -> float {
+            int index = (int)(intptr_t)tree.GetUserData(proxyId);
+            float scale = aabbs[index].RayIntersection(starts[i], dirs[i]);
+            if (scale < maxScale) {
+                closestProxy = index;
+                return scale;
+            }
+            return maxScale;
+        };
+
+        tree.RayCast(starts[i], dirs[i], FLT_MAX, callback);
+
+        if (closestProxy != closestProxies[i]) {
+            numMismatches++;
+        }
+    }
+
+    uint64_t rayCastTime = BE1::PlatformTime::Microseconds() - start;
+
+    BE_LOG(L"DynamicAABBTree::RayCast: %.0f ns/query (brute force %.0f ns/query), %i mismatches\n",
+        rayCastTime * 1000.0f / QUERY_COUNT, bruteForceTime * 1000.0f / QUERY_COUNT, numMismatches);
+
+    delete [] starts;
+    delete [] dirs;
+    delete [] closestProxies;
+}
+
+void TestDynamicAABBTree() {
+    BE1::DynamicAABBTree tree;
+    BE1::AABB *aabbs = new BE1::AABB[PROXY_COUNT];
+
+    // Synthetic scene of small objects scattered over a wide flat area
+    for (int i = 0; i < PROXY_COUNT; i++) {
+        BE1::Vec3 center(BE1::Math::Random(-WORLD_EXTENT, WORLD_EXTENT), BE1::Math::Random(-WORLD_EXTENT, WORLD_EXTENT), BE1::Math::Random(0.0f, 100.0f));
+        BE1::Vec3 extents(BE1::Math::Random(0.5f, 4.0f), BE1::Math::Random(0.5f, 4.0f), BE1::Math::Random(0.5f, 4.0f));
+        aabbs[i] = BE1::AABB(center - extents, center + extents);
+        tree.CreateProxy(aabbs[i], 0.1f, (void *)(intptr_t)i);
+    }
+
+    // Cameras looking horizontally in random directions
+    BE1::Frustum *frustums = new BE1::Frustum[QUERY_COUNT];
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        BE1::Vec3 origin(BE1::Math::Random(-WORLD_EXTENT, WORLD_EXTENT), BE1::Math::Random(-WORLD_EXTENT, WORLD_EXTENT), 50.0f);
+        BE1::Angles angles(0.0f, BE1::Math::Random(0.0f, 360.0f), 0.0f);
+        float zFar = 1000.0f;
+
+        frustums[i].SetOrigin(origin);
+        frustums[i].SetAxis(angles.ToMat3());
+        frustums[i].SetSize(1.0f, zFar, zFar * BE1::Math::Tan(DEG2RAD(90.0f) * 0.5f), zFar * BE1::Math::Tan(DEG2RAD(60.0f) * 0.5f));
+    }
+
+    int numVisitedNodes, numHits;
+
+    uint64_t allPlanesTime = TestFrustumQuery(tree, frustums, BE1::DynamicAABBTree::AllPlanesCull, numVisitedNodes, numHits);
+    BE_LOG(L"DynamicAABBTree::Query(Frustum) all planes: %i nodes visited, %i proxies/query, %.0f ns/query\n", 
+        numVisitedNodes / QUERY_COUNT, numHits / QUERY_COUNT, allPlanesTime * 1000.0f / QUERY_COUNT);
+
+    uint64_t planeMaskTime = TestFrustumQuery(tree, frustums, BE1::DynamicAABBTree::PlaneMaskCull, numVisitedNodes, numHits);
+    BE_LOG(L"DynamicAABBTree::Query(Frustum) plane mask: %i nodes visited, %i proxies/query, %.0f ns/query (%.2fx faster)\n", 
+        numVisitedNodes / QUERY_COUNT, numHits / QUERY_COUNT, planeMaskTime * 1000.0f / QUERY_COUNT, (float)allPlanesTime / BE1::Max(planeMaskTime, (uint64_t)1));
+
+    int numMismatches = CompareFrustumQueries(tree, frustums);
+    BE_LOG(L"DynamicAABBTree::Query(Frustum) proxy sets: %i mismatches %ls\n", numMismatches, numMismatches == 0 ? L"OK" : L"FAILED");
+
+    numMismatches = CompareCulledFrustumQueries(tree, frustums);
+    BE_LOG(L"DynamicAABBTree::Query(Frustum) with culled nodes: %i mismatches %ls\n", numMismatches, numMismatches == 0 ? L"OK" : L"FAILED");
+
+    delete [] frustums;
+
+    TestRayCast(tree, aabbs);
+
+    delete [] aabbs;
+}
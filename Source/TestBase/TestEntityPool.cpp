@@ -0,0 +1,183 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestEntityPool.h"
+#include "TestEntityTemplate.h"
+
+#define WARM_UP_COUNT       4
+
+// Renderable without mesh, to see what happens to the render object on deactivation
+class TestRenderable : public BE1::ComRenderable {
+public:
+    OBJECT_PROTOTYPE(TestRenderable);
+
+    TestRenderable() {}
+    virtual ~TestRenderable() {}
+
+    int                     GetRenderObjectHandle() const { return renderObjectHandle; }
+    bool                    IsRenderObjectHidden() const { return renderWorld->GetRenderObject(renderObjectHandle)->hidden; }
+};
+
+BEGIN_EVENTS(TestRenderable)
+END_EVENTS
+
+OBJECT_DECLARATION("TestRenderable", TestRenderable, ComRenderable)
+
+void TestRenderable::RegisterProperties() {
+}
+
+static Json::Value EntityValue(const BE1::Guid &entityGuid, const BE1::Guid &parentGuid, const char *name) {
+    Json::Value entityValue;
+    entityValue["classname"] = BE1::Entity::metaObject.ClassName();
+    entityValue["guid"] = entityGuid.ToString();
+    entityValue["parent"] = parentGuid.ToString();
+    entityValue["name"] = name;
+
+    Json::Value &transformValue = entityValue["components"][0];
+    transformValue["classname"] = BE1::ComTransform::metaObject.ClassName();
+    transformValue["guid"] = BE1::Guid::CreateGuid().ToString();
+    transformValue["origin"] = BE1::Vec3::zero.ToString();
+
+    Json::Value &renderableValue = entityValue["components"][1];
+    renderableValue["classname"] = TestRenderable::metaObject.ClassName();
+    renderableValue["guid"] = BE1::Guid::CreateGuid().ToString();
+
+    return entityValue;
+}
+
+// Original entity with a child, both have a renderable
+static BE1::Entity *CreateOriginalEntity(BE1::Entity *&childEntity) {
+    BE1::Guid rootGuid = BE1::Guid::CreateGuid();
+
+    Json::Value rootValue = EntityValue(rootGuid, BE1::Guid::zero, "Pooled");
+    BE1::Entity *rootEntity = BE1::Entity::CreateEntity(rootValue);
+    rootEntity->Init();
+
+    Json::Value childValue = EntityValue(BE1::Guid::CreateGuid(), rootGuid, "Pooled Child");
+    childEntity = BE1::Entity::CreateEntity(childValue);
+    childEntity->Init();
+
+    return rootEntity;
+}
+
+static TestRenderable *GetRenderable(const BE1::Entity *entity) {
+    return entity->GetComponent<TestRenderable>();
+}
+
+// Pooled entity and its child are active with visible render objects
+static bool IsAcquired(const BE1::Entity *entity) {
+    const BE1::Entity *childEntity = entity->FindChild("Pooled Child");
+
+    return entity->IsActiveInHierarchy() && childEntity && childEntity->IsActiveInHierarchy() &&
+        GetRenderable(entity)->GetRenderObjectHandle() != -1 && !GetRenderable(entity)->IsRenderObjectHidden() &&
+        GetRenderable(childEntity)->GetRenderObjectHandle() != -1 && !GetRenderable(childEntity)->IsRenderObjectHidden();
+}
+
+// Pooled entity and its child are inactive, their render objects are hidden but still allocated
+static bool IsReleased(const BE1::Entity *entity) {
+    const BE1::Entity *childEntity = entity->FindChild("Pooled Child");
+
+    return !entity->IsActiveInHierarchy() && childEntity && !childEntity->IsActiveInHierarchy() &&
+        GetRenderable(entity)->GetRenderObjectHandle() != -1 && GetRenderable(entity)->IsRenderObjectHidden() &&
+        GetRenderable(childEntity)->GetRenderObjectHandle() != -1 && GetRenderable(childEntity)->IsRenderObjectHidden();
+}
+
+void TestEntityPool() {
+    RegisterTestObjectProperties();
+    TestRenderable::RegisterProperties();
+
+    BE1::GameWorld *gameWorld = (BE1::GameWorld *)BE1::GameWorld::CreateInstance();
+
+    BE1::Entity *originalChildEntity;
+    BE1::Entity *originalEntity = CreateOriginalEntity(originalChildEntity);
+
+    gameWorld->WarmUpEntityPool(originalEntity, WARM_UP_COUNT);
+
+    const BE1::EntityPool *pool = gameWorld->FindEntityPool(originalEntity);
+
+    // Warmed up entities are registered inactive with their render objects hidden
+    bool warmUpOK = pool && pool->NumEntities() == WARM_UP_COUNT && pool->NumFreeEntities() == WARM_UP_COUNT;
+
+    BE1::Entity *entities[WARM_UP_COUNT];
+    for (int i = 0; i < WARM_UP_COUNT; i++) {
+        entities[i] = gameWorld->AcquireEntityWithTransform(originalEntity, BE1::Vec3(i, 0, 0), BE1::Quat::identity);
+        warmUpOK &= entities[i] && entities[i]->IsPooled() && gameWorld->IsRegisteredEntity(entities[i]);
+    }
+    warmUpOK &= pool->NumEntities() == WARM_UP_COUNT && pool->NumFreeEntities() == 0;
+
+    // Acquired entities are placed at the given transform and shown
+    bool acquireOK = true;
+    for (int i = 0; i < WARM_UP_COUNT; i++) {
+        acquireOK &= IsAcquired(entities[i]) && entities[i]->GetTransform()->GetLocalOrigin() == BE1::Vec3(i, 0, 0);
+    }
+
+    // Changed state while acquired
+    BE1::Entity *entity = entities[0];
+    entity->GetTransform()->SetLocalOriginRotation(BE1::Vec3(10, 20, 30), BE1::Angles(0, 0, 90).ToQuat());
+    entity->SetParentGuid(entities[1]->GetGuid());
+
+    // Released entity is detached from the parent, deactivated and hidden, and released once only
+    gameWorld->ReleaseEntity(entity);
+    gameWorld->ReleaseEntity(entity);
+
+    bool releaseOK = IsReleased(entity) && !entity->GetParent() && pool->NumFreeEntities() == 1 &&
+        gameWorld->IsRegisteredEntity(entity);
+
+    // Reacquiring gives back the same entity with its transform reset and the same render objects shown again
+    int renderObjectHandle = GetRenderable(entity)->GetRenderObjectHandle();
+
+    BE1::Entity *reusedEntity = gameWorld->AcquireEntityWithTransform(originalEntity, BE1::Vec3(5, 0, 0), BE1::Quat::identity);
+
+    bool reuseOK = reusedEntity == entity && IsAcquired(reusedEntity) && pool->NumEntities() == WARM_UP_COUNT &&
+        pool->NumFreeEntities() == 0 && GetRenderable(reusedEntity)->GetRenderObjectHandle() == renderObjectHandle &&
+        reusedEntity->GetTransform()->GetLocalOrigin() == BE1::Vec3(5, 0, 0) &&
+        reusedEntity->GetTransform()->GetLocalRotation().Equals(BE1::Quat::identity, 0.0001f);
+
+    // Pool grows when it runs out of free entities
+    BE1::Entity *grownEntity = gameWorld->AcquireEntity(originalEntity);
+    reuseOK &= grownEntity && IsAcquired(grownEntity) && pool->NumEntities() == WARM_UP_COUNT + 1;
+
+    BE_LOG(L"EntityPool: warm up %ls, acquire %ls, release %ls, reuse %ls\n", warmUpOK ? L"OK" : L"FAILED",
+        acquireOK ? L"OK" : L"FAILED", releaseOK ? L"OK" : L"FAILED", reuseOK ? L"OK" : L"FAILED");
+
+    // Destroyed free entity is forgotten by the pool, and the others are still free
+    for (int i = 0; i < WARM_UP_COUNT; i++) {
+        gameWorld->ReleaseEntity(entities[i]);
+    }
+
+    BE1::Entity::DestroyInstanceImmediate(entities[1]->FindChild("Pooled Child"));
+    BE1::Entity::DestroyInstanceImmediate(entities[1]);
+
+    bool forgetOK = pool->NumEntities() == WARM_UP_COUNT && pool->NumFreeEntities() == WARM_UP_COUNT - 1;
+    for (int i = 0; i < WARM_UP_COUNT - 1; i++) {
+        BE1::Entity *acquiredEntity = gameWorld->AcquireEntity(originalEntity);
+        forgetOK &= acquiredEntity && acquiredEntity != entities[1] && IsAcquired(acquiredEntity);
+    }
+    forgetOK &= pool->NumFreeEntities() == 0;
+
+    // Deactivated entities out of pools don't keep their render objects
+    BE1::Entity *instantiatedEntity = gameWorld->InstantiateEntity(originalEntity);
+    instantiatedEntity->SetActive(false);
+
+    bool removeOK = !instantiatedEntity->IsPooled() && GetRenderable(instantiatedEntity)->GetRenderObjectHandle() == -1 &&
+        GetRenderable(instantiatedEntity->FindChild("Pooled Child"))->GetRenderObjectHandle() == -1;
+
+    BE_LOG(L"EntityPool: destroy free entity %ls, deactivate entity out of pool %ls\n", forgetOK ? L"OK" : L"FAILED", removeOK ? L"OK" : L"FAILED");
+
+    BE1::GameWorld::DestroyInstanceImmediate(gameWorld);
+
+    BE1::Entity::DestroyInstanceImmediate(originalChildEntity);
+    BE1::Entity::DestroyInstanceImmediate(originalEntity);
+}
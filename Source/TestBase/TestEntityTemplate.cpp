@@ -0,0 +1,221 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestEntityTemplate.h"
+
+#define PREFAB_ENTITY_COUNT 20
+#define INSTANCE_COUNT      1000
+
+// Creates a prefab like hierarchy of entities which have transform components only
+static BE1::Entity *CreateSourceHierarchy() {
+    BE1::Array<BE1::Guid> entityGuids;
+
+    BE1::Entity *rootEntity = nullptr;
+
+    for (int i = 0; i < PREFAB_ENTITY_COUNT; i++) {
+        BE1::Guid entityGuid = BE1::Guid::CreateGuid();
+
+        Json::Value entityValue;
+        entityValue["classname"] = BE1::Entity::metaObject.ClassName();
+        entityValue["guid"] = entityGuid.ToString();
+        entityValue["parent"] = i > 0 ? entityGuids[(i - 1) / 3].ToString() : BE1::Guid::zero.ToString();
+        entityValue["prefab"] = true;
+        entityValue["name"] = BE1::va("Entity %i", i);
+
+        Json::Value &transformValue = entityValue["components"][0];
+        transformValue["classname"] = BE1::ComTransform::metaObject.ClassName();
+        transformValue["guid"] = BE1::Guid::CreateGuid().ToString();
+        transformValue["origin"] = BE1::Vec3(i, i * 2, i * 3).ToString();
+        transformValue["scale"] = BE1::Vec3(1, 2, 3).ToString();
+
+        BE1::Entity *entity = BE1::Entity::CreateEntity(entityValue);
+        entity->Init();
+
+        if (!rootEntity) {
+            rootEntity = entity;
+        }
+        entityGuids.Append(entityGuid);
+    }
+
+    return rootEntity;
+}
+
+// Same as cloning in GameWorld before entity template was introduced
+static void CloneEntitiesByJson(const BE1::Entity *sourceEntity, BE1::EntityPtrArray &entities) {
+    Json::Value originalEntitiesValue;
+    BE1::Entity::SerializeHierarchy(sourceEntity, originalEntitiesValue);
+
+    BE1::HashTable<BE1::Guid, BE1::Guid> guidMap;
+    Json::Value clonedEntitiesValue = BE1::Entity::CloneEntitiesValue(originalEntitiesValue, guidMap);
+
+    for (int i = 0; i < clonedEntitiesValue.size(); i++) {
+        BE1::Entity *clonedEntity = BE1::Entity::CreateEntity(clonedEntitiesValue[i]);
+        BE1::Entity::RemapGuids(clonedEntity, guidMap);
+
+        if (originalEntitiesValue[i]["prefab"].asBool()) {
+            clonedEntity->SetProperty("prefabSource", BE1::Guid::FromString(originalEntitiesValue[i]["guid"].asCString()));
+            clonedEntity->SetProperty("prefab", false);
+        }
+
+        entities.Append(clonedEntity);
+    }
+}
+
+static void DestroyEntities(BE1::EntityPtrArray &entities) {
+    // Destroy children first
+    for (int i = entities.Count() - 1; i >= 0; i--) {
+        BE1::Entity::DestroyInstanceImmediate(entities[i]);
+    }
+    entities.Clear();
+}
+
+// Replaces GUID strings found in the map, and removes members that differ by cloning
+static void NormalizeCopiedValue(Json::Value &value, const BE1::HashTable<BE1::Guid, BE1::Guid> &copyToSourceGuidMap) {
+    BE1::Guid sourceGuid;
+
+    if (value.isString()) {
+        if (copyToSourceGuidMap.Get(BE1::Guid::FromString(value.asCString()), &sourceGuid)) {
+            value = sourceGuid.ToString();
+        }
+    } else if (value.isArray()) {
+        for (int i = 0; i < value.size(); i++) {
+            NormalizeCopiedValue(value[i], copyToSourceGuidMap);
+        }
+    } else if (value.isObject()) {
+        value.removeMember("guid");
+        value.removeMember("prefab");
+        value.removeMember("prefabSource");
+
+        for (Json::Value::iterator it = value.begin(); it != value.end(); ++it) {
+            NormalizeCopiedValue(*it, copyToSourceGuidMap);
+        }
+    }
+}
+
+// Returns true if the copies have the same properties except for GUIDs and the references are remapped to the copies
+static bool IsIdenticalCopy(const BE1::EntityPtrArray &sourceEntities, const BE1::EntityPtrArray &copiedEntities) {
+    if (sourceEntities.Count() != copiedEntities.Count()) {
+        return false;
+    }
+
+    BE1::HashTable<BE1::Guid, BE1::Guid> copyToSourceGuidMap;
+    BE1::HashTable<BE1::Guid, BE1::Guid> emptyGuidMap;
+
+    for (int i = 0; i < sourceEntities.Count(); i++) {
+        BE1::Guid sourceGuid = sourceEntities[i]->GetGuid();
+        if (copiedEntities[i]->GetGuid() == sourceGuid || copiedEntities[i]->NumComponents() != sourceEntities[i]->NumComponents()) {
+            return false;
+        }
+        copyToSourceGuidMap.Set(copiedEntities[i]->GetGuid(), sourceGuid);
+
+        if (copiedEntities[i]->GetProperty("prefabSource").As<BE1::Guid>() != sourceGuid) {
+            return false;
+        }
+
+        for (int componentIndex = 0; componentIndex < sourceEntities[i]->NumComponents(); componentIndex++) {
+            BE1::Guid sourceComponentGuid = sourceEntities[i]->GetComponent(componentIndex)->GetGuid();
+            copyToSourceGuidMap.Set(copiedEntities[i]->GetComponent(componentIndex)->GetGuid(), sourceComponentGuid);
+        }
+    }
+
+    for (int i = 0; i < sourceEntities.Count(); i++) {
+        Json::Value sourceValue;
+        Json::Value copiedValue;
+        sourceEntities[i]->Serialize(sourceValue);
+        copiedEntities[i]->Serialize(copiedValue);
+
+        NormalizeCopiedValue(sourceValue, emptyGuidMap);
+        NormalizeCopiedValue(copiedValue, copyToSourceGuidMap);
+
+        if (sourceValue != copiedValue) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void RegisterTestObjectProperties() {
+    static bool registered = false;
+    if (registered) {
+        return;
+    }
+    registered = true;
+
+    BE1::Object::RegisterProperties();
+    BE1::Component::RegisterProperties();
+    BE1::ComTransform::RegisterProperties();
+    BE1::Entity::RegisterProperties();
+    BE1::GameWorld::RegisterProperties();
+    BE1::MapRenderSettings::RegisterProperties();
+    BE1::Object::InitPropertyInfoTables();
+}
+
+void TestEntityTemplate() {
+    RegisterTestObjectProperties();
+
+    BE1::Entity *sourceRootEntity = CreateSourceHierarchy();
+
+    BE1::EntityPtrArray sourceEntities;
+    sourceEntities.Append(sourceRootEntity);
+    sourceRootEntity->GetChildren(sourceEntities);
+
+    BE1::EntityTemplate entityTemplate(sourceRootEntity);
+
+    // Direct copies should be the same as the source hierarchy
+    BE1::EntityPtrArray copiedEntities;
+    entityTemplate.CreateEntities(nullptr, 0, copiedEntities);
+
+    bool copiedHierarchy = copiedEntities.Count() == PREFAB_ENTITY_COUNT;
+    for (int i = 1; i < copiedEntities.Count() && copiedHierarchy; i++) {
+        int parentIndex = sourceEntities.FindIndex(sourceEntities[i]->GetParent());
+        copiedHierarchy = parentIndex >= 0 && copiedEntities[i]->GetParent() == copiedEntities[parentIndex];
+    }
+    copiedHierarchy = copiedHierarchy && !copiedEntities[0]->GetParent();
+
+    BE_LOG(L"EntityTemplate: %i entities, hierarchy %ls, properties %ls\n", entityTemplate.NumEntities(),
+        copiedHierarchy ? L"ok" : L"FAILED", IsIdenticalCopy(sourceEntities, copiedEntities) ? L"ok" : L"FAILED");
+
+    DestroyEntities(copiedEntities);
+
+    // Compare with cloning through JSON
+    uint64_t jsonTime = 0;
+    uint64_t templateTime = 0;
+
+    BE1::EntityPtrArray entities;
+    entities.Resize(PREFAB_ENTITY_COUNT * INSTANCE_COUNT);
+
+    uint64_t start = BE1::PlatformTime::Microseconds();
+    for (int i = 0; i < INSTANCE_COUNT; i++) {
+        CloneEntitiesByJson(sourceRootEntity, entities);
+    }
+    jsonTime = BE1::PlatformTime::Microseconds() - start;
+
+    DestroyEntities(entities);
+
+    start = BE1::PlatformTime::Microseconds();
+    BE1::EntityTemplate batchTemplate(sourceRootEntity);
+    for (int i = 0; i < INSTANCE_COUNT; i++) {
+        batchTemplate.CreateEntities(nullptr, 0, entities);
+    }
+    templateTime = BE1::PlatformTime::Microseconds() - start;
+
+    DestroyEntities(entities);
+
+    BE_LOG(L"EntityTemplate: %i instances of %i entities, JSON clone %.2f ms, template %.2f ms, %.1fx\n",
+        INSTANCE_COUNT, PREFAB_ENTITY_COUNT, jsonTime / 1000.0f, templateTime / 1000.0f, (float)jsonTime / (templateTime ? templateTime : 1));
+
+    DestroyEntities(sourceEntities);
+}
@@ -0,0 +1,145 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestEventSystem.h"
+
+#define SENDER_COUNT        1000
+#define EVENT_COUNT         100000
+#define MAX_DELAY_MSEC      1000
+#define FRAME_MSEC          16
+
+using BE1::Object;
+
+struct EventRecord {
+    int                     dueTime;
+    bool                    cancelled;
+    bool                    fired;
+};
+
+static EventRecord          eventRecords[EVENT_COUNT];
+static int                  lastDueTime;
+static int                  numFired;
+static int                  numDisordered;
+
+static const BE1::EventDef  EV_TestTick("testTick", false, "a");
+
+class TestEventObject : public BE1::Object {
+public:
+    OBJECT_PROTOTYPE(TestEventObject);
+
+    TestEventObject() = default;
+
+    void                    Event_Tick(EventRecord *record);
+};
+
+OBJECT_DECLARATION("TestEventObject", TestEventObject, Object)
+BEGIN_EVENTS(TestEventObject)
+    EVENT(EV_TestTick, TestEventObject::Event_Tick),
+END_EVENTS
+
+void TestEventObject::RegisterProperties() {
+}
+
+void TestEventObject::Event_Tick(EventRecord *record) {
+    if (record->cancelled || record->fired || record->dueTime < lastDueTime || record->dueTime > BE1::common.realTime) {
+        numDisordered++;
+    }
+
+    lastDueTime = record->dueTime;
+    record->fired = true;
+    numFired++;
+}
+
+static void PostEvents(TestEventObject **senders, int count) {
+    BE1::Random random;
+
+    for (int i = 0; i < count; i++) {
+        int delay = 1 + random.RandomInt(MAX_DELAY_MSEC - 1);
+
+        eventRecords[i].dueTime = BE1::common.realTime + delay;
+        eventRecords[i].cancelled = false;
+        eventRecords[i].fired = false;
+
+        senders[i % SENDER_COUNT]->PostEventMS(&EV_TestTick, delay, (const void *)&eventRecords[i]);
+    }
+}
+
+void TestEventSystem() {
+    BE1::Object::Init();
+    BE1::EventSystem::Init();
+
+    BE1::common.realTime = 0;
+
+    TestEventObject *senders[SENDER_COUNT];
+    for (int i = 0; i < SENDER_COUNT; i++) {
+        senders[i] = (TestEventObject *)TestEventObject::CreateInstance();
+    }
+
+    // Scheduling cost should grow (almost) linearly with the number of pending events
+    uint64_t startTime = BE1::PlatformTime::Microseconds();
+    PostEvents(senders, EVENT_COUNT / 10);
+    uint64_t schedule10Time = BE1::PlatformTime::Microseconds() - startTime;
+
+    BE1::EventSystem::Clear();
+
+    startTime = BE1::PlatformTime::Microseconds();
+    PostEvents(senders, EVENT_COUNT);
+    uint64_t scheduleTime = BE1::PlatformTime::Microseconds() - startTime;
+
+    int numPending = BE1::EventSystem::NumPendingEvents();
+
+    // Cancel all the events of every other sender
+    startTime = BE1::PlatformTime::Microseconds();
+    for (int i = 0; i < SENDER_COUNT; i += 2) {
+        senders[i]->CancelEvents(&EV_TestTick);
+    }
+    uint64_t cancelTime = BE1::PlatformTime::Microseconds() - startTime;
+
+    int numExpected = 0;
+    for (int i = 0; i < EVENT_COUNT; i++) {
+        eventRecords[i].cancelled = (i % SENDER_COUNT) % 2 == 0;
+        if (!eventRecords[i].cancelled) {
+            numExpected++;
+        }
+    }
+
+    lastDueTime = 0;
+    numFired = 0;
+    numDisordered = 0;
+
+    // Service events frame by frame
+    startTime = BE1::PlatformTime::Microseconds();
+    while (BE1::EventSystem::NumPendingEvents() > 0) {
+        BE1::common.realTime += FRAME_MSEC;
+        BE1::EventSystem::ServiceEvents();
+    }
+    uint64_t serviceTime = BE1::PlatformTime::Microseconds() - startTime;
+
+    BE_LOG(L"EventSystem: %i pending events, %i fired (expected %i), order %ls\n", 
+        numPending, numFired, numExpected, numDisordered == 0 && numFired == numExpected ? L"ok" : L"FAILED");
+    BE_LOG(L"EventSystem: schedule %i events %.2f ms, %i events %.2f ms, cancel %i senders %.2f ms, service %.2f ms\n",
+        EVENT_COUNT / 10, schedule10Time / 1000.0f, EVENT_COUNT, scheduleTime / 1000.0f, SENDER_COUNT / 2, cancelTime / 1000.0f, serviceTime / 1000.0f);
+
+    // Destroying sender should cancel its pending events
+    senders[1]->PostEventMS(&EV_TestTick, 1, (const void *)&eventRecords[1]);
+    for (int i = 0; i < SENDER_COUNT; i++) {
+        BE1::Object::DestroyInstanceImmediate(senders[i]);
+    }
+
+    BE_LOG(L"EventSystem: pending events after destroying senders %i\n", BE1::EventSystem::NumPendingEvents());
+
+    BE1::EventSystem::Shutdown();
+    BE1::Object::Shutdown();
+}
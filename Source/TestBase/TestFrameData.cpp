@@ -0,0 +1,59 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestFrameData.h"
+// Frame data is private to the renderer
+#include "../Runtime/Private/Render/RenderInternal.h"
+
+static const wchar_t *Result(bool value) {
+    return value ? L"OK" : L"FAILED";
+}
+
+void TestFrameData() {
+    // Render system is not initialized in the test, so the frame data is not initialized yet
+    bool nullBeforeInit = BE1::frameData.Alloc(16) == nullptr && BE1::frameData.Alloc(0) == nullptr && BE1::frameData.ClearedAlloc(16) == nullptr;
+
+    BE1::frameData.Init();
+
+    bool allocated = true;
+    bool cleared = true;
+
+    for (int frameIndex = 0; frameIndex < BE1::FrameData::NumFrames * 2; frameIndex++) {
+        byte *small = (byte *)BE1::frameData.ClearedAlloc(64);
+        byte *large = (byte *)BE1::frameData.Alloc(1024 * 1024);
+
+        if (!small || !large || ((intptr_t)small & 15) || ((intptr_t)large & 15)) {
+            allocated = false;
+        } else {
+            for (int i = 0; i < 64; i++) {
+                if (small[i]) {
+                    cleared = false;
+                }
+            }
+            memset(small, 0xff, 64);
+            memset(large, 0xff, 1024 * 1024);
+        }
+
+        BE1::frameData.ToggleFrame();
+    }
+
+    BE1::frameData.Shutdown();
+
+    // Blocks of the calling thread are freed by Shutdown()
+    bool nullAfterShutdown = BE1::frameData.Alloc(16) == nullptr;
+
+    BE_LOG(L"FrameData: alloc before init %ls, alloc %ls, cleared alloc %ls, alloc after shutdown %ls\n",
+        Result(nullBeforeInit), Result(allocated), Result(cleared), Result(nullAfterShutdown));
+}
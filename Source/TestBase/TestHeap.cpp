@@ -0,0 +1,125 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestHeap.h"
+
+#define ALLOC_COUNT         4096
+#define ALLOC_MAX_SIZE      1024
+#define BENCH_COUNT         1000000
+
+static bool CheckTagStats(BE1::MemTag::Enum tag, const BE1::MemTagStats &base, int64_t expectedBytes, int64_t expectedLiveAllocs) {
+    BE1::MemTagStats stats;
+    BE1::Mem_GetTagStats(tag, stats);
+    return stats.currentBytes - base.currentBytes == expectedBytes && stats.numLiveAllocs - base.numLiveAllocs == expectedLiveAllocs;
+}
+
+void TestHeap() {
+    static void *ptrs[ALLOC_COUNT];
+    BE1::Random random;
+    bool ok = true;
+
+    BE1::MemTagStats base;
+    BE1::Mem_GetTagStats(BE1::MemTag::Mesh, base);
+
+    // Allocations are accounted to the tag of the innermost scope
+    int64_t totalBytes = 0;
+    {
+        BE1::MemTagScope memTagScope(BE1::MemTag::Mesh);
+
+        for (int i = 0; i < ALLOC_COUNT; i++) {
+            size_t size = 1 + random.RandomInt(ALLOC_MAX_SIZE - 1);
+            ptrs[i] = (i & 1) ? BE1::Mem_Alloc16(size) : BE1::Mem_Alloc(size);
+            totalBytes += size;
+        }
+
+        BE1::MemTagScope innerScope(BE1::MemTag::Anim);
+        BE1::Mem_Free(BE1::Mem_Alloc(ALLOC_MAX_SIZE));
+    }
+    ok &= BE1::Mem_GetThreadTag() == BE1::MemTag::General;
+
+    // Aligned allocations have some padding
+    BE1::MemTagStats stats;
+    BE1::Mem_GetTagStats(BE1::MemTag::Mesh, stats);
+    ok &= stats.numLiveAllocs - base.numLiveAllocs == ALLOC_COUNT;
+    ok &= stats.currentBytes - base.currentBytes >= totalBytes;
+    ok &= stats.peakBytes >= stats.currentBytes;
+
+    // Reallocation moves the bytes to the tag of the current scope
+    BE1::MemTagStats luaBase;
+    BE1::Mem_GetTagStats(BE1::MemTag::Lua, luaBase);
+    int64_t meshBytes = stats.currentBytes - base.currentBytes;
+    {
+        BE1::MemTagScope memTagScope(BE1::MemTag::Lua);
+
+        void *ptr = BE1::Mem_Alloc(100);
+        ptr = BE1::Mem_Realloc(ptr, 3000);
+        ok &= CheckTagStats(BE1::MemTag::Lua, luaBase, 3000, 1);
+        BE1::Mem_Free(ptr);
+    }
+    ok &= CheckTagStats(BE1::MemTag::Lua, luaBase, 0, 0);
+
+    // Sampled allocations are reported with their call stacks
+    BE1::Mem_SetSampleRate(64);
+    {
+        BE1::MemTagScope memTagScope(BE1::MemTag::Mesh);
+
+        for (int i = 0; i < ALLOC_COUNT; i += 2) {
+            BE1::Mem_AlignedFree(ptrs[i + 1]);
+            ptrs[i + 1] = BE1::Mem_Alloc16(ALLOC_MAX_SIZE);
+        }
+    }
+    BE1::Mem_Report(true, 3);
+    BE1::Mem_SetSampleRate(0);
+
+    for (int i = 0; i < ALLOC_COUNT; i++) {
+        if (i & 1) {
+            BE1::Mem_AlignedFree(ptrs[i]);
+        } else {
+            BE1::Mem_Free(ptrs[i]);
+        }
+        ptrs[i] = nullptr;
+    }
+    ok &= CheckTagStats(BE1::MemTag::Mesh, base, 0, 0);
+
+    // Cost of the accounting compared to the system allocator
+    uint64_t startTime = BE1::PlatformTime::Microseconds();
+    for (int i = 0; i < BENCH_COUNT; i++) {
+        int index = i & (ALLOC_COUNT - 1);
+        if (ptrs[index]) {
+            free(ptrs[index]);
+        }
+        ptrs[index] = malloc(16 + (i & 255));
+    }
+    for (int i = 0; i < ALLOC_COUNT; i++) {
+        free(ptrs[i]);
+        ptrs[i] = nullptr;
+    }
+    uint64_t mallocTime = BE1::PlatformTime::Microseconds() - startTime;
+
+    startTime = BE1::PlatformTime::Microseconds();
+    for (int i = 0; i < BENCH_COUNT; i++) {
+        int index = i & (ALLOC_COUNT - 1);
+        BE1::Mem_Free(ptrs[index]);
+        ptrs[index] = BE1::Mem_Alloc(16 + (i & 255));
+    }
+    for (int i = 0; i < ALLOC_COUNT; i++) {
+        BE1::Mem_Free(ptrs[i]);
+        ptrs[i] = nullptr;
+    }
+    uint64_t memAllocTime = BE1::PlatformTime::Microseconds() - startTime;
+
+    BE_LOG(L"Heap: tagged accounting %ls (%lld bytes in %i allocs)\n", ok ? L"ok" : L"FAILED", (long long)meshBytes, ALLOC_COUNT);
+    BE_LOG(L"Heap: %i alloc/free pairs malloc %.2f ms, Mem_Alloc %.2f ms\n", BENCH_COUNT, mallocTime / 1000.0f, memAllocTime / 1000.0f);
+}
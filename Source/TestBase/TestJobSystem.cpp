@@ -0,0 +1,120 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestJobSystem.h"
+
+#define TASK_COUNT          65536
+#define TASK_ITERATIONS     256
+#define JOBS_PER_BATCH      1024
+
+static float taskResults[TASK_COUNT];
+
+static void DoWork(int index) {
+    float x = (float)index;
+    for (int i = 0; i < TASK_ITERATIONS; i++) {
+        x = BE1::Math::Sqrt(x * x + 1.0f);
+    }
+    taskResults[index] = x;
+}
+
+static void TaskFunc(void *data) {
+    DoWork((int)(intptr_t)data);
+}
+
+static void EmptyJobFunc(void *data) {
+}
+
+static void ParallelForFunc(int first, int last, void *data) {
+    for (int i = first; i < last; i++) {
+        DoWork(i);
+    }
+}
+
+static void PrintThroughput(const wchar_t *name, int numThreads, uint64_t usec) {
+    BE_LOG(L"%ls (%i threads): %.2f ms, %.0f tasks/ms\n", name, numThreads, usec / 1000.0f, TASK_COUNT * 1000.0f / BE1::Max(usec, (uint64_t)1));
+}
+
+// Tasks are run by numThreads worker threads while the calling thread waits.
+static uint64_t TestTaskScheduler(int numThreads) {
+    BE1::TaskScheduler taskScheduler(numThreads);
+
+    uint64_t start = BE1::PlatformTime::Microseconds();
+
+    for (int i = 0; i < TASK_COUNT; i++) {
+        taskScheduler.AddTask(TaskFunc, (void *)(intptr_t)i);
+    }
+    taskScheduler.WaitFinish();
+
+    return BE1::PlatformTime::Microseconds() - start;
+}
+
+// The calling thread runs jobs while waiting, so numThreads - 1 worker threads are created.
+static uint64_t TestJobs(int numThreads) {
+    BE1::jobSystem.Shutdown();
+    BE1::jobSystem.Init(numThreads - 1);
+
+    uint64_t start = BE1::PlatformTime::Microseconds();
+
+    // Submit children in batches so that no more than MaxJobsPerThread jobs are unfinished at once
+    for (int batchStart = 0; batchStart < TASK_COUNT; batchStart += JOBS_PER_BATCH) {
+        BE1::JobHandle root = BE1::jobSystem.CreateJob(EmptyJobFunc, nullptr);
+
+        for (int i = batchStart; i < batchStart + JOBS_PER_BATCH; i++) {
+            BE1::JobHandle child = BE1::jobSystem.CreateChildJob(root, TaskFunc, (void *)(intptr_t)i);
+            BE1::jobSystem.Run(child);
+        }
+
+        BE1::jobSystem.Run(root);
+        BE1::jobSystem.Wait(root);
+    }
+
+    return BE1::PlatformTime::Microseconds() - start;
+}
+
+static uint64_t TestParallelFor(int numThreads) {
+    BE1::jobSystem.Shutdown();
+    BE1::jobSystem.Init(numThreads - 1);
+
+    uint64_t start = BE1::PlatformTime::Microseconds();
+
+    BE1::jobSystem.ParallelFor(TASK_COUNT, 64, ParallelForFunc, nullptr);
+
+    return BE1::PlatformTime::Microseconds() - start;
+}
+
+void TestJobSystem() {
+    // Both are compared with the same number of threads running the tasks
+    static const int numThreadsList[] = { 1, 4, 16, 64 };
+
+    for (int i = 0; i < COUNT_OF(numThreadsList); i++) {
+        int numThreads = numThreadsList[i];
+
+        uint64_t taskSchedulerTime = TestTaskScheduler(numThreads);
+        PrintThroughput(L"TaskScheduler", numThreads, taskSchedulerTime);
+
+        uint64_t jobSystemTime = TestJobs(numThreads);
+        PrintThroughput(L"JobSystem", numThreads, jobSystemTime);
+
+        uint64_t parallelForTime = TestParallelFor(numThreads);
+        PrintThroughput(L"JobSystem::ParallelFor", numThreads, parallelForTime);
+
+        BE_LOG(L"JobSystem: %.2fx, ParallelFor: %.2fx faster than TaskScheduler\n", 
+            (float)taskSchedulerTime / BE1::Max(jobSystemTime, (uint64_t)1), (float)taskSchedulerTime / BE1::Max(parallelForTime, (uint64_t)1));
+    }
+
+    // Restore default job system configuration
+    BE1::jobSystem.Shutdown();
+    BE1::jobSystem.Init();
+}
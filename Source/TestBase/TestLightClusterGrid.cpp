@@ -0,0 +1,191 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestLightClusterGrid.h"
+
+#define TILES_X             16
+#define TILES_Y             8
+#define SLICES              24
+#define LIGHT_COUNT         256
+#define POINT_COUNT         100000
+#define OBJECT_COUNT        10000
+#define BUILD_COUNT         100
+
+static bool IsPointInLight(const BE1::LightClusterGrid::LightVolume &light, const BE1::Vec3 &point) {
+    BE1::Vec3 v = point - light.origin;
+
+    if (!light.isCone) {
+        return v.LengthSqr() <= light.radius * light.radius;
+    }
+
+    float t = v.Dot(light.direction);
+    return t >= 0.0f && t <= light.radius && t >= v.Length() * light.cosAngle;
+}
+
+static bool IsLightInCluster(const BE1::LightClusterGrid &grid, int clusterIndex, int lightIndex) {
+    const int32_t *lights = grid.GetClusterLights(clusterIndex);
+    return std::binary_search(lights, lights + grid.NumClusterLights(clusterIndex), lightIndex);
+}
+
+void TestLightClusterGrid() {
+    const float zNear = 0.1f;
+    const float zFar = 1000.0f;
+    const float tanHalfFovX = 1.0f;
+    const float tanHalfFovY = 0.5f;
+
+    BE1::LightClusterGrid grid;
+    grid.Init(TILES_X, TILES_Y, SLICES);
+    grid.SetView(BE1::Vec3::origin, BE1::Mat3::identity, tanHalfFovX, tanHalfFovY, zNear, zFar);
+
+    // Small point lights and a few spot lights scattered in the view frustum
+    BE1::Array<BE1::LightClusterGrid::LightVolume> lights;
+    for (int i = 0; i < LIGHT_COUNT; i++) {
+        float depth = BE1::Math::Random(1.0f, 200.0f);
+        BE1::Vec3 origin(depth, BE1::Math::Random(-depth, depth) * tanHalfFovX, BE1::Math::Random(-depth, depth) * tanHalfFovY);
+
+        if (i % 4 == 3) {
+            BE1::Vec3 direction(BE1::Math::Random(-1.0f, 1.0f), BE1::Math::Random(-1.0f, 1.0f), BE1::Math::Random(-1.0f, 1.0f));
+            direction.Normalize();
+            lights.Append(BE1::LightClusterGrid::LightVolume::FromCone(origin, direction, BE1::Math::Random(5.0f, 20.0f), DEG2RAD(BE1::Math::Random(10.0f, 60.0f))));
+        } else {
+            lights.Append(BE1::LightClusterGrid::LightVolume::FromSphere(origin, BE1::Math::Random(1.0f, 5.0f)));
+        }
+    }
+
+    // Serial and parallel binning should produce the same clusters
+    grid.Build(lights.Ptr(), lights.Count(), false);
+
+    BE1::Array<int32_t> serialIndexes;
+    for (int clusterIndex = 0; clusterIndex < grid.NumClusters(); clusterIndex++) {
+        serialIndexes.Append(grid.NumClusterLights(clusterIndex));
+        for (int i = 0; i < grid.NumClusterLights(clusterIndex); i++) {
+            serialIndexes.Append(grid.GetClusterLights(clusterIndex)[i]);
+        }
+    }
+
+    uint64_t serialTime = 0;
+    uint64_t parallelTime = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        bool parallel = pass == 1;
+
+        uint64_t start = BE1::PlatformTime::Microseconds();
+        for (int i = 0; i < BUILD_COUNT; i++) {
+            grid.Build(lights.Ptr(), lights.Count(), parallel);
+        }
+        (parallel ? parallelTime : serialTime) += BE1::PlatformTime::Microseconds() - start;
+    }
+
+    BE1::Array<int32_t> parallelIndexes;
+    for (int clusterIndex = 0; clusterIndex < grid.NumClusters(); clusterIndex++) {
+        parallelIndexes.Append(grid.NumClusterLights(clusterIndex));
+        for (int i = 0; i < grid.NumClusterLights(clusterIndex); i++) {
+            parallelIndexes.Append(grid.GetClusterLights(clusterIndex)[i]);
+        }
+    }
+
+    bool identical = serialIndexes.Count() == parallelIndexes.Count() &&
+        memcmp(serialIndexes.Ptr(), parallelIndexes.Ptr(), serialIndexes.MemoryUsed()) == 0;
+
+    BE_LOG(L"LightClusterGrid::Build (%i lights, %ix%ix%i clusters): serial %.1f us, parallel %.1f us, results %ls\n",
+        LIGHT_COUNT, TILES_X, TILES_Y, SLICES, (float)serialTime / BUILD_COUNT, (float)parallelTime / BUILD_COUNT, identical ? L"identical" : L"DIFFERENT");
+
+    BE_LOG(L"LightClusterGrid: %.2f lights per cluster on average, grid far %.1f\n",
+        (float)grid.NumClusterLightIndexes() / grid.NumClusters(), grid.GetGridFar());
+
+    // Every light containing a point should be in the cluster of the point
+    int numMissed = 0;
+    int numTested = 0;
+
+    for (int i = 0; i < POINT_COUNT; i++) {
+        float depth = BE1::Math::Random(zNear, 220.0f);
+        BE1::Vec3 point(depth, BE1::Math::Random(-depth, depth) * tanHalfFovX, BE1::Math::Random(-depth, depth) * tanHalfFovY);
+
+        int clusterIndex = grid.FindCluster(point);
+        if (clusterIndex < 0) {
+            continue;
+        }
+
+        for (int lightIndex = 0; lightIndex < lights.Count(); lightIndex++) {
+            if (IsPointInLight(lights[lightIndex], point)) {
+                numTested++;
+                if (!IsLightInCluster(grid, clusterIndex, lightIndex)) {
+                    numMissed++;
+                }
+            }
+        }
+    }
+
+    BE_LOG(L"LightClusterGrid: %i lit points, %i missed lights %ls\n", numTested, numMissed, numMissed == 0 ? L"ok" : L"FAILED");
+
+    // Object lookups should find every light sphere intersecting the object bounds
+    BE1::AABB *objects = new BE1::AABB[OBJECT_COUNT];
+    for (int i = 0; i < OBJECT_COUNT; i++) {
+        float depth = BE1::Math::Random(1.0f, 220.0f);
+        BE1::Vec3 center(depth, BE1::Math::Random(-depth, depth) * tanHalfFovX, BE1::Math::Random(-depth, depth) * tanHalfFovY);
+        BE1::Vec3 extents(BE1::Math::Random(0.5f, 4.0f), BE1::Math::Random(0.5f, 4.0f), BE1::Math::Random(0.5f, 4.0f));
+        objects[i] = BE1::AABB(center - extents, center + extents);
+    }
+
+    BE1::Array<int32_t> lightIndexes;
+    int numFound = 0;
+    numMissed = 0;
+
+    uint64_t start = BE1::PlatformTime::Microseconds();
+
+    for (int i = 0; i < OBJECT_COUNT; i++) {
+        numFound += grid.FindLights(objects[i], lightIndexes);
+    }
+
+    uint64_t findTime = BE1::PlatformTime::Microseconds() - start;
+
+    int numIntersecting = 0;
+
+    start = BE1::PlatformTime::Microseconds();
+
+    for (int i = 0; i < OBJECT_COUNT; i++) {
+        for (int lightIndex = 0; lightIndex < lights.Count(); lightIndex++) {
+            const BE1::LightClusterGrid::LightVolume &light = lights[lightIndex];
+            if (light.isCone) {
+                continue;
+            }
+            if (objects[i].IsIntersectSphere(BE1::Sphere(light.origin, light.radius))) {
+                numIntersecting++;
+            }
+        }
+    }
+
+    uint64_t bruteForceTime = BE1::PlatformTime::Microseconds() - start;
+
+    for (int i = 0; i < OBJECT_COUNT; i++) {
+        grid.FindLights(objects[i], lightIndexes);
+
+        for (int lightIndex = 0; lightIndex < lights.Count(); lightIndex++) {
+            const BE1::LightClusterGrid::LightVolume &light = lights[lightIndex];
+            if (light.isCone || !objects[i].IsIntersectSphere(BE1::Sphere(light.origin, light.radius))) {
+                continue;
+            }
+            if (!std::binary_search(lightIndexes.Ptr(), lightIndexes.Ptr() + lightIndexes.Count(), lightIndex)) {
+                numMissed++;
+            }
+        }
+    }
+
+    BE_LOG(L"LightClusterGrid::FindLights: %.1f lights per object, %i missed lights %ls, %.0f ns/object (brute force sphere tests %.1f lights per object, %.0f ns/object)\n",
+        (float)numFound / OBJECT_COUNT, numMissed, numMissed == 0 ? L"ok" : L"FAILED", findTime * 1000.0f / OBJECT_COUNT, 
+        (float)numIntersecting / OBJECT_COUNT, bruteForceTime * 1000.0f / OBJECT_COUNT);
+
+    delete [] objects;
+}
@@ -0,0 +1,161 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestNullRHI.h"
+
+#ifdef USE_NULL_RHI
+
+#define RECORD_FILENAME     "TestNullRHI.rec"
+#define NUM_QUADS           64
+#define NUM_FRAMES          3
+
+static const char *vsText =
+    "uniform mat4 modelViewProjectionMatrix;\n"
+    "in vec4 in_position;\n"
+    "void main() { gl_Position = modelViewProjectionMatrix * in_position; }\n";
+
+static const char *fsText =
+    "uniform sampler2D albedoMap;\n"
+    "uniform highp vec4 constantColor;\n"
+    "out vec4 o_fragColor;\n"
+    "void main() { o_fragColor = texture(albedoMap, vec2(0.0)) * constantColor; }\n";
+
+struct QuadVertex {
+    BE1::Vec3 xyz;
+};
+
+// Renders a frame the way the back end does: render target, state, shader, constants, streams and draws.
+static void RenderFrame(BE1::RHI::Handle shader, BE1::RHI::Handle texture, BE1::RHI::Handle vertexFormat, BE1::RHI::Handle vertexBuffer, BE1::RHI::Handle indexBuffer) {
+    BE1::rhi.BeginRenderTarget(BE1::RHI::NullRenderTarget);
+    BE1::rhi.SetViewport(BE1::Rect(0, 0, 1280, 720));
+    BE1::rhi.Clear(BE1::RHI::ColorBit | BE1::RHI::DepthBit, BE1::Color4::black, 1.0f, 0);
+
+    BE1::rhi.SetStateBits(BE1::RHI::ColorWrite | BE1::RHI::DepthWrite | BE1::RHI::DF_LEqual);
+    BE1::rhi.SetCullFace(BE1::RHI::BackCull);
+
+    BE1::rhi.BindShader(shader);
+    BE1::rhi.SetTexture(BE1::rhi.GetSamplerUnit(shader, "albedoMap"), texture);
+
+    int mvpIndex = BE1::rhi.GetShaderConstantIndex(shader, "modelViewProjectionMatrix");
+    int colorIndex = BE1::rhi.GetShaderConstantIndex(shader, "constantColor");
+
+    BE1::rhi.SetVertexFormat(vertexFormat);
+    BE1::rhi.SetStreamSource(0, vertexBuffer, 0, sizeof(QuadVertex));
+    BE1::rhi.BindBuffer(BE1::RHI::IndexBuffer, indexBuffer);
+
+    for (int i = 0; i < NUM_QUADS; i++) {
+        BE1::rhi.SetShaderConstant4x4f(mvpIndex, true, BE1::Mat4::identity);
+        BE1::rhi.SetShaderConstant4f(colorIndex, BE1::Vec4(1, 1, 1, 1));
+        BE1::rhi.DrawElements(BE1::RHI::TrianglesPrim, i * 6, 6, sizeof(BE1::TriIndex), nullptr);
+    }
+
+    BE1::rhi.EndRenderTarget();
+    BE1::rhi.SwapBuffers();
+}
+
+static const wchar_t *Result(bool ok) {
+    return ok ? L"OK" : L"FAILED";
+}
+
+void TestNullRHI() {
+    BE1::rhi.Init(nullptr, nullptr);
+
+    BE1::rhi.BeginRecording(RECORD_FILENAME);
+
+    BE1::RHI::Handle shader = BE1::rhi.CreateShader("TestShader", vsText, fsText);
+
+    BE1::Image image;
+    image.Create2D(64, 64, 1, BE1::Image::RGBA_8_8_8_8, nullptr, 0);
+    BE1::RHI::Handle texture = BE1::rhi.CreateTexture(BE1::RHI::Texture2D);
+    BE1::rhi.BindTexture(texture);
+    BE1::rhi.SetTextureImage(BE1::RHI::Texture2D, &image, image.GetFormat(), false, false);
+
+    BE1::RHI::VertexElement element;
+    element.stream = 0;
+    element.offset = 0;
+    element.usage = BE1::RHI::VertexElement::Position;
+    element.components = 3;
+    element.type = BE1::RHI::VertexElement::FloatType;
+    element.normalize = false;
+    element.divisor = 0;
+    BE1::RHI::Handle vertexFormat = BE1::rhi.CreateVertexFormat(1, &element);
+
+    QuadVertex verts[NUM_QUADS * 4];
+    BE1::TriIndex indexes[NUM_QUADS * 6];
+    for (int i = 0; i < NUM_QUADS; i++) {
+        verts[i * 4 + 0].xyz.Set(i, 0, 0);
+        verts[i * 4 + 1].xyz.Set(i + 1, 0, 0);
+        verts[i * 4 + 2].xyz.Set(i + 1, 1, 0);
+        verts[i * 4 + 3].xyz.Set(i, 1, 0);
+
+        const BE1::TriIndex quadIndexes[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int j = 0; j < 6; j++) {
+            indexes[i * 6 + j] = i * 4 + quadIndexes[j];
+        }
+    }
+    BE1::RHI::Handle vertexBuffer = BE1::rhi.CreateBuffer(BE1::RHI::VertexBuffer, BE1::RHI::Static, sizeof(verts), 0, verts);
+    BE1::RHI::Handle indexBuffer = BE1::rhi.CreateBuffer(BE1::RHI::IndexBuffer, BE1::RHI::Static, sizeof(indexes), 0, indexes);
+
+    for (int frame = 0; frame < NUM_FRAMES; frame++) {
+        RenderFrame(shader, texture, vertexFormat, vertexBuffer, indexBuffer);
+    }
+
+    BE1::NullRHI::FrameStats recordedStats = BE1::rhi.GetFrameStats();
+    BE1::NullRHI::MemoryStats memoryStats = BE1::rhi.GetMemoryStats();
+
+    BE1::rhi.DestroyBuffer(indexBuffer);
+    BE1::rhi.DestroyBuffer(vertexBuffer);
+    BE1::rhi.DestroyVertexFormat(vertexFormat);
+    BE1::rhi.DestroyTexture(texture);
+    BE1::rhi.DestroyShader(shader);
+
+    BE1::rhi.EndRecording();
+
+    bool drawsOK = recordedStats.numDrawCalls == NUM_QUADS && recordedStats.numVerts == NUM_QUADS * 6;
+    bool constantsOK = recordedStats.numConstantUpdates == NUM_QUADS * 2;
+    bool memoryOK = memoryStats.numBuffers == 2 && memoryStats.bufferBytes == sizeof(verts) + sizeof(indexes) &&
+        memoryStats.numTextures == 1 && memoryStats.textureBytes == image.GetSize();
+    bool releasedOK = BE1::rhi.GetMemoryStats().numBuffers == 0 && BE1::rhi.GetMemoryStats().numTextures == 0;
+
+    BE_LOG(L"NullRHI frame: %i draws, %i verts, %i state changes, %i constant updates\n",
+        recordedStats.numDrawCalls, recordedStats.numVerts, recordedStats.numStateChanges, recordedStats.numConstantUpdates);
+    BE_LOG(L"NullRHI stats: draws %ls, constants %ls, memory %ls, release %ls\n",
+        Result(drawsOK), Result(constantsOK), Result(memoryOK), Result(releasedOK));
+
+    // Replaying the recorded stream should reproduce the statistics of the last frame
+    int numFrames = BE1::rhi.Replay(RECORD_FILENAME);
+    const BE1::NullRHI::FrameStats &replayedStats = BE1::rhi.GetFrameStats();
+
+    bool replayOK = numFrames == NUM_FRAMES &&
+        replayedStats.numDrawCalls == recordedStats.numDrawCalls &&
+        replayedStats.numVerts == recordedStats.numVerts &&
+        replayedStats.numShaderChanges == recordedStats.numShaderChanges &&
+        replayedStats.numTextureChanges == recordedStats.numTextureChanges &&
+        replayedStats.numBufferChanges == recordedStats.numBufferChanges;
+
+    BE_LOG(L"NullRHI replay: %i frames, %i draws %ls\n", numFrames, replayedStats.numDrawCalls, Result(replayOK));
+
+    BE1::fileSystem.RemoveFile(RECORD_FILENAME, false);
+
+    BE1::rhi.Shutdown();
+}
+
+#else
+
+void TestNullRHI() {
+    BE_LOG(L"NullRHI: skipped, USE_NULL_RHI is not defined\n");
+}
+
+#endif
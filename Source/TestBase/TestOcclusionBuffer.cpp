@@ -0,0 +1,153 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestOcclusionBuffer.h"
+
+#define BUFFER_WIDTH        256
+#define BUFFER_HEIGHT       128
+#define WALL_COUNT          256
+#define OCCLUDEE_COUNT      10000
+#define RASTERIZE_COUNT     100
+
+// Projection looking down -z axis in OpenGL clip space
+static BE1::Mat4 PerspectiveMatrix(float fovY, float aspect, float zNear, float zFar) {
+    float f = 1.0f / BE1::Math::Tan(DEG2RAD(fovY) * 0.5f);
+    return BE1::Mat4(
+        f / aspect, 0, 0, 0,
+        0, f, 0, 0,
+        0, 0, (zFar + zNear) / (zNear - zFar), 2.0f * zFar * zNear / (zNear - zFar),
+        0, 0, -1, 0);
+}
+
+// Adds a front facing quad at depth z.
+static void AddWall(BE1::OcclusionBuffer &buffer, const BE1::Mat4 &viewProjMatrix, float x0, float y0, float x1, float y1, float z) {
+    const BE1::Vec3 verts[4] = { BE1::Vec3(x0, y0, z), BE1::Vec3(x1, y0, z), BE1::Vec3(x1, y1, z), BE1::Vec3(x0, y1, z) };
+    const BE1::TriIndex indexes[6] = { 0, 1, 2, 0, 2, 3 };
+
+    buffer.AddOccluder(viewProjMatrix, verts, sizeof(verts[0]), 4, indexes, 6);
+}
+
+static const wchar_t *Result(bool value, bool expected) {
+    return value == expected ? L"ok" : L"FAILED";
+}
+
+void TestOcclusionBuffer() {
+    BE1::Mat4 viewProjMatrix = PerspectiveMatrix(60.0f, 2.0f, 0.1f, 1000.0f);
+
+    BE1::OcclusionBuffer buffer;
+    buffer.Init(BUFFER_WIDTH, BUFFER_HEIGHT);
+
+    // Single wall in front of the camera
+    AddWall(buffer, viewProjMatrix, -5.0f, -5.0f, 5.0f, 5.0f, -10.0f);
+    buffer.Rasterize(false);
+
+    bool behind = buffer.IsOccluded(BE1::AABB(BE1::Vec3(-1, -1, -20), BE1::Vec3(1, 1, -15)), viewProjMatrix);
+    bool inFront = buffer.IsOccluded(BE1::AABB(BE1::Vec3(-1, -1, -5), BE1::Vec3(1, 1, -4)), viewProjMatrix);
+    bool beside = buffer.IsOccluded(BE1::AABB(BE1::Vec3(4, -1, -20), BE1::Vec3(12, 1, -15)), viewProjMatrix);
+    bool crossing = buffer.IsOccluded(BE1::AABB(BE1::Vec3(-1, -1, -20), BE1::Vec3(1, 1, 1)), viewProjMatrix);
+
+    BE_LOG(L"OcclusionBuffer: behind wall %ls, in front of wall %ls, beside wall %ls, crossing near plane %ls\n", 
+        Result(behind, true), Result(inFront, false), Result(beside, false), Result(crossing, false));
+
+    // Back facing wall doesn't occlude
+    buffer.Clear();
+    AddWall(buffer, viewProjMatrix, 5.0f, -5.0f, -5.0f, 5.0f, -10.0f);
+    buffer.Rasterize(false);
+
+    bool backFacing = buffer.IsOccluded(BE1::AABB(BE1::Vec3(-1, -1, -20), BE1::Vec3(1, 1, -15)), viewProjMatrix);
+    BE_LOG(L"OcclusionBuffer: back facing wall %ls\n", Result(backFacing, false));
+
+    // Vertex projected with w near 0 goes far out of the int range in screen space
+    buffer.Clear();
+    const BE1::Mat4 wFromZMatrix(
+        1, 0, 0, 0,
+        0, 1, 0, 0,
+        0, 0, 1, 0,
+        0, 0, 1, 0);
+    const BE1::Vec3 farVerts[3] = { BE1::Vec3(0.0f, 0.0f, 1.0f), BE1::Vec3(0.5f, 0.0f, 1.0f), BE1::Vec3(1.0f, 1.0f, 1e-30f) };
+    const BE1::TriIndex farIndexes[3] = { 0, 1, 2 };
+    buffer.AddOccluder(wFromZMatrix, farVerts, sizeof(farVerts[0]), 3, farIndexes, 3);
+    buffer.Rasterize(false);
+
+    BE_LOG(L"OcclusionBuffer: vertex near w = 0 %ls\n", Result(buffer.NumTriangles() == 1, true));
+
+    // Random walls, serial and parallel rasterization should produce the same depth buffer
+    struct Wall { float x0, y0, x1, y1, z; };
+    Wall *walls = new Wall[WALL_COUNT];
+    for (int i = 0; i < WALL_COUNT; i++) {
+        float z = BE1::Math::Random(-200.0f, -5.0f);
+        float x = BE1::Math::Random(z, -z);
+        float y = BE1::Math::Random(z * 0.5f, -z * 0.5f);
+        float size = BE1::Math::Random(1.0f, 10.0f);
+        walls[i] = { x - size, y - size, x + size, y + size, z };
+    }
+
+    BE1::AABB *occludees = new BE1::AABB[OCCLUDEE_COUNT];
+    for (int i = 0; i < OCCLUDEE_COUNT; i++) {
+        float z = BE1::Math::Random(-300.0f, -5.0f);
+        BE1::Vec3 center(BE1::Math::Random(z, -z), BE1::Math::Random(z * 0.5f, -z * 0.5f), z);
+        BE1::Vec3 extents(BE1::Math::Random(0.5f, 2.0f));
+        occludees[i] = BE1::AABB(center - extents, center + extents);
+    }
+
+    float *serialDepth = new float[buffer.GetWidth() * buffer.GetHeight()];
+
+    uint64_t serialTime = 0;
+    uint64_t parallelTime = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        bool parallel = pass == 1;
+
+        for (int i = 0; i < RASTERIZE_COUNT; i++) {
+            buffer.Clear();
+            for (int wallIndex = 0; wallIndex < WALL_COUNT; wallIndex++) {
+                const Wall &w = walls[wallIndex];
+                AddWall(buffer, viewProjMatrix, w.x0, w.y0, w.x1, w.y1, w.z);
+            }
+
+            uint64_t start = BE1::PlatformTime::Microseconds();
+            buffer.Rasterize(parallel);
+            (parallel ? parallelTime : serialTime) += BE1::PlatformTime::Microseconds() - start;
+        }
+
+        if (!parallel) {
+            memcpy(serialDepth, buffer.GetDepthBuffer(), sizeof(float) * buffer.GetWidth() * buffer.GetHeight());
+        }
+    }
+
+    bool identical = memcmp(serialDepth, buffer.GetDepthBuffer(), sizeof(float) * buffer.GetWidth() * buffer.GetHeight()) == 0;
+
+    BE_LOG(L"OcclusionBuffer::Rasterize (%i walls, %ix%i): serial %.1f us, parallel %.1f us, results %ls\n", 
+        WALL_COUNT, buffer.GetWidth(), buffer.GetHeight(), (float)serialTime / RASTERIZE_COUNT, (float)parallelTime / RASTERIZE_COUNT, identical ? L"identical" : L"DIFFERENT");
+
+    int numOccluded = 0;
+
+    uint64_t start = BE1::PlatformTime::Microseconds();
+
+    for (int i = 0; i < OCCLUDEE_COUNT; i++) {
+        if (buffer.IsOccluded(occludees[i], viewProjMatrix)) {
+            numOccluded++;
+        }
+    }
+
+    uint64_t testTime = BE1::PlatformTime::Microseconds() - start;
+
+    BE_LOG(L"OcclusionBuffer::IsOccluded: %i/%i occluded, %.0f ns/test\n", 
+        numOccluded, OCCLUDEE_COUNT, testTime * 1000.0f / OCCLUDEE_COUNT);
+
+    delete [] serialDepth;
+    delete [] occludees;
+    delete [] walls;
+}
@@ -0,0 +1,92 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestProfiler.h"
+
+#define ZONE_COUNT          2000        // Zones per frame, 2 events each fit in the ring buffer
+#define ZONE_ITERATIONS     4096
+#define FRAME_COUNT         10
+#define MAX_OVERHEAD        0.01
+
+static volatile float workResult;
+
+static float DoWork(float x) {
+    for (int i = 0; i < ZONE_ITERATIONS; i++) {
+        x = BE1::Math::Sqrt(x * x + 1.0f);
+    }
+    return x;
+}
+
+static uint64_t RunFrame(bool instrumented) {
+    float x = workResult;
+
+    uint64_t start = BE1::PlatformTime::Microseconds();
+
+    if (instrumented) {
+        for (int i = 0; i < ZONE_COUNT; i++) {
+            BE_PROFILE_SCOPE("TestProfiler::Zone");
+            x = DoWork(x);
+        }
+    } else {
+        for (int i = 0; i < ZONE_COUNT; i++) {
+            x = DoWork(x);
+        }
+    }
+
+    uint64_t time = BE1::PlatformTime::Microseconds() - start;
+
+    workResult = x;
+
+    BE1::profiler.SyncFrame();
+
+    return time;
+}
+
+static int ZoneCalls(const char *name) {
+    const BE1::Array<BE1::Profiler::ZoneStats> &frameStats = BE1::profiler.GetFrameStats();
+    for (int i = 0; i < frameStats.Count(); i++) {
+        if (!BE1::Str::Cmp(frameStats[i].name, name)) {
+            return frameStats[i].calls;
+        }
+    }
+    return 0;
+}
+
+void TestProfiler() {
+    // Fastest frame of each, interleaved so that the clock changes affect them equally
+    uint64_t plainTime = UINT64_MAX;
+    uint64_t idleTime = UINT64_MAX;
+    uint64_t recordingTime = UINT64_MAX;
+    bool callsOK = true;
+
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        plainTime = BE1::Min(plainTime, RunFrame(false));
+        idleTime = BE1::Min(idleTime, RunFrame(true));
+
+        BE1::profiler.EnableFrameStats(true);
+        recordingTime = BE1::Min(recordingTime, RunFrame(true));
+        callsOK &= ZoneCalls("TestProfiler::Zone") == ZONE_COUNT;
+        BE1::profiler.EnableFrameStats(false);
+    }
+
+    double idleOverhead = (double)idleTime / BE1::Max(plainTime, (uint64_t)1) - 1.0;
+    double recordingOverhead = (double)recordingTime / BE1::Max(plainTime, (uint64_t)1) - 1.0;
+
+    BE_LOG(L"Profiler: %i zones/frame, uninstrumented %.2f ms, idle %.2f ms (%+.2f%%) %ls, recording %.2f ms (%+.2f%%) %ls, zone calls %ls\n",
+        ZONE_COUNT, plainTime / 1000.0f,
+        idleTime / 1000.0f, idleOverhead * 100.0, idleOverhead < MAX_OVERHEAD ? L"OK" : L"FAILED",
+        recordingTime / 1000.0f, recordingOverhead * 100.0, recordingOverhead < MAX_OVERHEAD ? L"OK" : L"FAILED",
+        callsOK ? L"OK" : L"FAILED");
+}
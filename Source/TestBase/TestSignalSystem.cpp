@@ -0,0 +1,125 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestSignalSystem.h"
+
+#define RECEIVER_COUNT      100
+
+static const BE1::SignalDef SIG_TestNone("TestSignal::None");
+static const BE1::SignalDef SIG_TestInt("TestSignal::Int", "i");
+static const BE1::SignalDef SIG_TestIntFloat("TestSignal::IntFloat", "if");
+
+class TestSignalReceiver : public BE1::SignalObject {
+public:
+    void                    None() { numNone++; }
+    void                    Int(const intptr_t value) { numInt++; intSum += value; }
+    void                    IntFloat(const intptr_t intValue, const float floatValue) { numIntFloat++; intSum += intValue; floatSum += floatValue; }
+
+    int                     numNone = 0;
+    int                     numInt = 0;
+    int                     numIntFloat = 0;
+    intptr_t                intSum = 0;
+    float                   floatSum = 0.0f;
+};
+
+static const wchar_t *Result(bool value) {
+    return value ? L"OK" : L"FAILED";
+}
+
+void TestSignalSystem() {
+    bool initialized = BE1::SignalSystem::initialized;
+    if (!initialized) {
+        BE1::SignalSystem::Init();
+    }
+
+    BE1::SignalObject sender;
+    TestSignalReceiver *receivers = new TestSignalReceiver[RECEIVER_COUNT];
+
+    // Nothing is connected yet
+    bool unconnectedOK = sender.EmitSignal(&SIG_TestNone) && sender.EmitSignal(&SIG_TestInt, 1);
+
+    // Every receiver gets SIG_TestInt, even ones also get SIG_TestIntFloat and the first one gets SIG_TestNone
+    for (int i = 0; i < RECEIVER_COUNT; i++) {
+        sender.Connect(&SIG_TestInt, &receivers[i], (BE1::SignalCallback)&TestSignalReceiver::Int);
+        if ((i & 1) == 0) {
+            sender.Connect(&SIG_TestIntFloat, &receivers[i], (BE1::SignalCallback)&TestSignalReceiver::IntFloat);
+        }
+    }
+    sender.Connect(&SIG_TestNone, &receivers[0], (BE1::SignalCallback)&TestSignalReceiver::None);
+
+    // Unique connection to the same callback fails
+    bool uniqueOK = !sender.Connect(&SIG_TestNone, &receivers[0], (BE1::SignalCallback)&TestSignalReceiver::None, BE1::SignalObject::Unique);
+
+    sender.EmitSignal(&SIG_TestInt, 7);
+    sender.EmitSignal(&SIG_TestIntFloat, 3, 0.5f);
+    sender.EmitSignal(&SIG_TestNone);
+
+    // Only the receivers connected to each signal def are called
+    bool directOK = true;
+    for (int i = 0; i < RECEIVER_COUNT; i++) {
+        const TestSignalReceiver &r = receivers[i];
+        bool even = (i & 1) == 0;
+
+        if (r.numInt != 1 || r.numIntFloat != (even ? 1 : 0) || r.numNone != (i == 0 ? 1 : 0) ||
+            r.intSum != (even ? 10 : 7) || r.floatSum != (even ? 0.5f : 0.0f)) {
+            directOK = false;
+        }
+    }
+
+    // Queued callbacks are called by ServiceSignals() with the copied arguments
+    TestSignalReceiver queuedReceiver;
+    sender.Connect(&SIG_TestIntFloat, &queuedReceiver, (BE1::SignalCallback)&TestSignalReceiver::IntFloat, BE1::SignalObject::Queued);
+
+    sender.EmitSignal(&SIG_TestIntFloat, 5, 2.25f);
+
+    bool queuedOK = queuedReceiver.numIntFloat == 0;
+    BE1::SignalSystem::ServiceSignals();
+    queuedOK = queuedOK && queuedReceiver.numIntFloat == 1 && queuedReceiver.intSum == 5 && queuedReceiver.floatSum == 2.25f;
+
+    // Pending signals of a destroyed receiver are canceled
+    TestSignalReceiver *destroyedReceiver = new TestSignalReceiver;
+    sender.Connect(&SIG_TestIntFloat, destroyedReceiver, (BE1::SignalCallback)&TestSignalReceiver::IntFloat, BE1::SignalObject::Queued);
+    sender.EmitSignal(&SIG_TestIntFloat, 1, 1.0f);
+    delete destroyedReceiver;
+    BE1::SignalSystem::ServiceSignals();
+    queuedOK = queuedOK && queuedReceiver.numIntFloat == 2;
+
+    // Disconnecting a signal def keeps the others
+    sender.Disconnect(&SIG_TestInt);
+    sender.EmitSignal(&SIG_TestInt, 100);
+    sender.EmitSignal(&SIG_TestNone);
+
+    bool disconnectOK = !sender.IsConnected(&SIG_TestInt, &receivers[0]) && sender.IsConnected(&SIG_TestIntFloat, &receivers[0]);
+    for (int i = 0; i < RECEIVER_COUNT; i++) {
+        if (receivers[i].numInt != 1 || receivers[i].numNone != (i == 0 ? 2 : 0)) {
+            disconnectOK = false;
+        }
+    }
+
+    // Blocked sender doesn't emit
+    sender.BlockSignals(true);
+    bool blockedOK = !sender.EmitSignal(&SIG_TestNone) && receivers[0].numNone == 2;
+    sender.BlockSignals(false);
+
+    BE_LOG(L"SignalSystem: unconnected %ls, unique %ls, direct %ls, queued %ls, disconnect %ls, blocked %ls\n",
+        Result(unconnectedOK), Result(uniqueOK), Result(directOK), Result(queuedOK), Result(disconnectOK), Result(blockedOK));
+
+    // Receivers disconnect themselves from the sender
+    delete [] receivers;
+
+    if (!initialized) {
+        BE1::SignalSystem::Shutdown();
+    }
+}
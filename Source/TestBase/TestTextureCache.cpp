@@ -0,0 +1,217 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "BlueshiftEngine.h"
+#include "TestTextureCache.h"
+
+#define TEST_CACHE_DIR      "TestTextureCache"
+
+// Streams through the texture cache instead of uploading to the GPU
+class TestCachedBackend : public BE1::TextureStreamerBackend {
+public:
+    TestCachedBackend(const BE1::TextureCache &cache) : cache(cache), numCookedLoads(0), numCookedStores(0) {}
+
+    virtual void AdjustImage(const BE1::StreamedTexture *streamedTexture, const BE1::Image &srcImage, int &width, int &height, BE1::Image::Format &format) const override {
+        width = BE1::Math::CeilPowerOfTwo(srcImage.GetWidth());
+        height = BE1::Math::CeilPowerOfTwo(srcImage.GetHeight());
+        format = BE1::Image::RGBA_8_8_8_8;
+    }
+
+    virtual bool LoadCookedMips(const BE1::StreamedTexture *streamedTexture, int firstMip, int &width, int &height, BE1::Image::Format &format, BE1::Image &mips) const override {
+        BE1::TextureCache::Key key;
+        BE1::CookedTexture cookedTexture;
+        if (!BE1::TextureCache::ComputeKey(streamedTexture->GetFilename(), "stream", key) || !cache.Load(key, cookedTexture)) {
+            return false;
+        }
+        const BE1::Image &cookedImage = cookedTexture.GetImage();
+        width = cookedImage.GetWidth();
+        height = cookedImage.GetHeight();
+        format = cookedImage.GetFormat();
+        BE1::TextureStreamer::CopyMipChain(cookedImage, BE1::Min(firstMip, cookedImage.NumMipmaps() - 1), mips);
+        numCookedLoads++;
+        return true;
+    }
+
+    virtual void StoreCookedMips(const BE1::StreamedTexture *streamedTexture, const BE1::Image &srcImage, const BE1::Image &mips) const override {
+        BE1::TextureCache::Key key;
+        if (BE1::TextureCache::ComputeKey(streamedTexture->GetFilename(), "stream", key) && cache.Store(key, mips, srcImage.GetWidth(), srcImage.GetHeight())) {
+            numCookedStores++;
+        }
+    }
+
+    virtual void UploadMips(BE1::StreamedTexture *streamedTexture, const BE1::Image &mips) override {}
+
+    const BE1::TextureCache &cache;
+    mutable std::atomic<int> numCookedLoads;
+    mutable std::atomic<int> numCookedStores;
+};
+
+static void WriteTestImage(const char *filename, int width, int height, int seed) {
+    BE1::Image image;
+    image.Create2D(width, height, 1, BE1::Image::RGBA_8_8_8_8, nullptr, 0);
+    byte *dst = image.GetPixels();
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            dst[0] = (byte)(x + seed);
+            dst[1] = (byte)y;
+            dst[2] = (byte)(x ^ y);
+            dst[3] = 255;
+            dst += 4;
+        }
+    }
+
+    image.Write(filename);
+}
+
+void TestTextureCache() {
+    BE_LOG(L"--- TestTextureCache ---\n");
+
+    const char *filename = "TestTextureCache_source.tga";
+
+    WriteTestImage(filename, 300, 200, 0);
+
+    BE1::Image srcImage;
+    srcImage.Load(filename);
+
+    // Cooking
+    BE1::TextureCookParms parms;
+    parms.width = 256;
+    parms.height = 256;
+    parms.format = BE1::Image::RGBA_8_8_8_8;
+    parms.useMipmaps = true;
+
+    BE1::Image cookedImage;
+    bool cookOK = BE1::TextureCache::CookImage(srcImage, parms, cookedImage) &&
+        cookedImage.GetWidth() == 256 && cookedImage.GetHeight() == 256 && cookedImage.NumMipmaps() == 9 && cookedImage.GetFormat() == BE1::Image::RGBA_8_8_8_8;
+
+    BE1::TextureCookParms noMipmapsParms = parms;
+    noMipmapsParms.width = 64;
+    noMipmapsParms.height = 32;
+    noMipmapsParms.format = BE1::Image::RGB_8_8_8;
+    noMipmapsParms.useMipmaps = false;
+
+    BE1::Image cookedImage2;
+    cookOK = cookOK && BE1::TextureCache::CookImage(srcImage, noMipmapsParms, cookedImage2) &&
+        cookedImage2.GetWidth() == 64 && cookedImage2.GetHeight() == 32 && cookedImage2.NumMipmaps() == 1 && cookedImage2.GetFormat() == BE1::Image::RGB_8_8_8;
+    BE_LOG(L"CookImage: %ls\n", cookOK ? L"OK" : L"FAILED");
+
+    // Keys depend on the target and on the content of the source
+    BE1::TextureCache::Key key, key2, key3;
+    BE1::TextureCache::ComputeKey(filename, "target", key);
+    BE1::TextureCache::ComputeKey(filename, "target2", key2);
+    bool keyOK = memcmp(key.digest, key2.digest, sizeof(key.digest)) != 0;
+
+    BE1::TextureCache::ComputeKey(filename, "target", key3);
+    keyOK = keyOK && memcmp(key.digest, key3.digest, sizeof(key.digest)) == 0;
+
+    WriteTestImage(filename, 300, 200, 1);
+    BE1::TextureCache::ComputeKey(filename, "target", key3);
+    keyOK = keyOK && memcmp(key.digest, key3.digest, sizeof(key.digest)) != 0;
+
+    keyOK = keyOK && !BE1::TextureCache::ComputeKey("TestTextureCache_missing.tga", "target", key3);
+    BE_LOG(L"ComputeKey: %ls (%hs)\n", keyOK ? L"OK" : L"FAILED", key.ToString().c_str());
+
+    // Store and load back through the mapping
+    BE1::TextureCache cache;
+    cache.Init(TEST_CACHE_DIR);
+    cache.Clear();
+
+    bool storeOK = !cache.Contains(key) && cache.Store(key, cookedImage, 300, 200) && cache.Contains(key);
+
+    BE1::CookedTexture cookedTexture;
+    bool loadOK = cache.Load(key, cookedTexture);
+    if (loadOK) {
+        const BE1::Image &image = cookedTexture.GetImage();
+        loadOK = image.GetWidth() == 256 && image.GetHeight() == 256 && image.NumMipmaps() == 9 && image.GetFormat() == cookedImage.GetFormat() &&
+            cookedTexture.GetSrcWidth() == 300 && cookedTexture.GetSrcHeight() == 200 &&
+            memcmp(image.GetPixels(), cookedImage.GetPixels(), cookedImage.GetSize(0, cookedImage.NumMipmaps())) == 0;
+    }
+    cookedTexture.Close();
+    BE_LOG(L"Store/Load: %ls\n", storeOK && loadOK ? L"OK" : L"FAILED");
+
+    // Misses and broken entries are not loaded
+    bool missOK = !cache.Load(key2, cookedTexture);
+
+    BE1::Str entryFilename = TEST_CACHE_DIR;
+    entryFilename.AppendPath(key2.ToString());
+    entryFilename.SetFileExtension(".btex");
+    BE1::fileSystem.WriteFile(entryFilename, "broken", 6);
+    missOK = missOK && cache.Contains(key2) && !cache.Load(key2, cookedTexture);
+    BE_LOG(L"miss: %ls\n", missOK ? L"OK" : L"FAILED");
+
+    // The source has been changed since the entry was stored, so its new key must not hit the stale entry
+    BE1::TextureCache::Key staleKey;
+    bool staleOK = BE1::TextureCache::ComputeKey(filename, "target", staleKey) && cache.Contains(key) &&
+        !cache.Contains(staleKey) && !cache.Load(staleKey, cookedTexture);
+    BE_LOG(L"stale key: %ls\n", staleOK ? L"OK" : L"FAILED");
+
+    // Entries with a corrupted header are rejected
+    BE1::Str keyFilename = TEST_CACHE_DIR;
+    keyFilename.AppendPath(key.ToString());
+    keyFilename.SetFileExtension(".btex");
+
+    bool corruptOK = true;
+    const int corruptOffsets[] = { 0, 4, 8, 16, 20, 24 }; // magic, version, format, width, height, numMipmaps
+
+    for (int i = 0; i < COUNT_OF(corruptOffsets); i++) {
+        BE1::fileSystem.RemoveFile(keyFilename, false);
+        corruptOK = corruptOK && cache.Store(key, cookedImage, 300, 200) && cache.Load(key, cookedTexture);
+        cookedTexture.Close();
+
+        byte *data;
+        size_t size = BE1::fileSystem.LoadFile(keyFilename, false, (void **)&data);
+        if (size < 32) {
+            corruptOK = false;
+            break;
+        }
+        BE1::Array<byte> corruptedData;
+        corruptedData.SetCount((int)size);
+        memcpy(corruptedData.Ptr(), data, size);
+        BE1::fileSystem.FreeFile(data);
+
+        *(uint32_t *)&corruptedData[corruptOffsets[i]] ^= 0x5A5A5A5A;
+        BE1::fileSystem.WriteFile(keyFilename, corruptedData.Ptr(), corruptedData.Count());
+
+        corruptOK = corruptOK && !cache.Load(key, cookedTexture);
+    }
+    BE_LOG(L"corrupt header: %ls\n", corruptOK ? L"OK" : L"FAILED");
+
+    // Streamed textures prepare their mips once
+    cache.Clear();
+
+    TestCachedBackend backend(cache);
+    BE1::TextureStreamer streamer;
+    streamer.Init(&backend);
+
+    int numMips[2] = { 0, 0 };
+    for (int pass = 0; pass < 2; pass++) {
+        BE1::StreamedTexture *streamedTexture = streamer.Register(filename, nullptr);
+        streamer.WaitRequests();
+        streamer.Update();
+        numMips[pass] = streamedTexture->NumMips();
+        streamer.Unregister(streamedTexture);
+    }
+    streamer.Shutdown();
+
+    bool streamOK = backend.numCookedStores == 1 && backend.numCookedLoads == 1 && numMips[0] == 10 && numMips[1] == 10;
+    BE_LOG(L"streaming: %ls (%i stored, %i loaded)\n", streamOK ? L"OK" : L"FAILED", (int)backend.numCookedStores, (int)backend.numCookedLoads);
+
+    cache.Clear();
+    cache.Shutdown();
+
+    BE1::fileSystem.RemoveFile(filename, false);
+    BE1::PlatformFile::RemoveDirectory(TEST_CACHE_DIR);
+}
@@ -0,0 +1,209 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestTextureStreaming.h"
+
+#define TEST_IMAGE_SIZE     256
+#define TAIL_SIZE           16
+#define UPLOAD_BUDGET       (64 * 1024)
+
+// Keeps track of the resident mips instead of uploading them to the GPU
+class TestStreamingBackend : public BE1::TextureStreamerBackend {
+public:
+    TestStreamingBackend() : numUploads(0), maxUploadSize(0) {}
+
+    virtual void AdjustImage(const BE1::StreamedTexture *streamedTexture, const BE1::Image &srcImage, int &width, int &height, BE1::Image::Format &format) const override {
+        width = BE1::Math::CeilPowerOfTwo(srcImage.GetWidth());
+        height = BE1::Math::CeilPowerOfTwo(srcImage.GetHeight());
+        format = BE1::Image::RGBA_8_8_8_8;
+    }
+
+    virtual void UploadMips(BE1::StreamedTexture *streamedTexture, const BE1::Image &mips) override {
+        numUploads++;
+        maxUploadSize = BE1::Max(maxUploadSize, mips.GetWidth());
+    }
+
+    int numUploads;
+    int maxUploadSize;
+};
+
+static void WriteTestImage(const char *filename, int width, int height) {
+    BE1::Image image;
+    image.Create2D(width, height, 1, BE1::Image::RGBA_8_8_8_8, nullptr, 0);
+    byte *dst = image.GetPixels();
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            dst[0] = (byte)x;
+            dst[1] = (byte)y;
+            dst[2] = (byte)(x ^ y);
+            dst[3] = 255;
+            dst += 4;
+        }
+    }
+
+    image.Write(filename);
+}
+
+// Updates until all decodes are done, reporting the given screen size for the textures
+static int UpdateUntilSettled(BE1::TextureStreamer &streamer, BE1::StreamedTexture **textures, int numTextures, float screenSize, size_t memoryBudget, bool &withinBudgets) {
+    int numFrames = 0;
+
+    for (; numFrames < 100; numFrames++) {
+        for (int i = 0; i < numTextures; i++) {
+            textures[i]->ReportScreenSize(screenSize);
+        }
+
+        streamer.WaitRequests();
+        streamer.Update();
+
+        const BE1::TextureStreamer::Stats &stats = streamer.GetStats();
+        if (stats.residentSize > memoryBudget) {
+            withinBudgets = false;
+        }
+
+        if (stats.numRequests == 0 && stats.preparedSize == 0) {
+            bool settled = true;
+            for (int i = 0; i < numTextures; i++) {
+                if (textures[i]->GetResidentMip() > textures[i]->GetDesiredMip()) {
+                    settled = false;
+                }
+            }
+            if (settled) {
+                break;
+            }
+        }
+    }
+
+    return numFrames;
+}
+
+void TestTextureStreaming() {
+    BE_LOG(L"--- TestTextureStreaming ---\n");
+
+    // Mip chain preparation
+    BE1::Image srcImage;
+    srcImage.Create2D(300, 200, 1, BE1::Image::RGB_8_8_8, nullptr, 0);
+    memset(srcImage.GetPixels(), 0x80, srcImage.GetSize());
+
+    BE1::Image mips;
+    bool prepared = BE1::TextureStreamer::PrepareMips(srcImage, 256, 256, BE1::Image::RGBA_8_8_8_8, mips);
+    BE_LOG(L"PrepareMips: %ls (%i mips, %ix%i)\n", prepared && mips.NumMipmaps() == 9 && mips.GetWidth() == 256 && mips.GetPixels(8)[0] == 0x80 ? L"OK" : L"FAILED",
+        mips.NumMipmaps(), mips.GetWidth(), mips.GetHeight());
+
+    // Desired mip selection
+    bool desiredMipOK =
+        BE1::TextureStreamer::DesiredMip(1024, 1024, 256.0f, 0.0f, 6) == 2 &&
+        BE1::TextureStreamer::DesiredMip(1024, 512, 2048.0f, 0.0f, 6) == 0 &&
+        BE1::TextureStreamer::DesiredMip(1024, 1024, 0.0f, 0.0f, 6) == 6 &&
+        BE1::TextureStreamer::DesiredMip(1024, 1024, 256.0f, 1.0f, 6) == 3;
+    BE_LOG(L"DesiredMip: %ls\n", desiredMipOK ? L"OK" : L"FAILED");
+
+    const char *filenames[3] = { "TestTextureStreaming0.tga", "TestTextureStreaming1.tga", "TestTextureStreaming2.tga" };
+    for (int i = 0; i < COUNT_OF(filenames); i++) {
+        WriteTestImage(filenames[i], TEST_IMAGE_SIZE, TEST_IMAGE_SIZE);
+    }
+
+    TestStreamingBackend backend;
+    BE1::TextureStreamer streamer;
+    streamer.Init(&backend);
+    streamer.SetTailSize(TAIL_SIZE);
+    streamer.SetUploadBudget(UPLOAD_BUDGET);
+
+    // The mip tail is resident after the first decode, and the rest is uploaded within the budget
+    BE1::StreamedTexture *textures[3];
+    textures[0] = streamer.Register(filenames[0], nullptr);
+    streamer.WaitRequests();
+    streamer.Update();
+
+    bool tailOK = textures[0]->IsReady() && textures[0]->GetResidentMip() == textures[0]->GetTailMip() && backend.maxUploadSize == TAIL_SIZE;
+    BE_LOG(L"mip tail: %ls (%i mips, tail mip %i)\n", tailOK ? L"OK" : L"FAILED", textures[0]->NumMips(), textures[0]->GetTailMip());
+
+    bool budgetOK = true;
+    int numFrames = 0;
+    while (textures[0]->GetResidentMip() > 0 && numFrames < 100) {
+        int prevResidentMip = textures[0]->GetResidentMip();
+
+        textures[0]->ReportScreenSize(TEST_IMAGE_SIZE);
+        streamer.WaitRequests();
+        streamer.Update();
+        numFrames++;
+
+        // More than the budget is uploaded only to make progress by one mip
+        size_t uploadedSize = streamer.GetStats().uploadedSize;
+        if (uploadedSize > UPLOAD_BUDGET && textures[0]->GetResidentMip() != prevResidentMip - 1) {
+            budgetOK = false;
+        }
+    }
+    BE_LOG(L"upload budget: %ls (fully resident in %i frames, %i uploads)\n", budgetOK && textures[0]->GetResidentMip() == 0 ? L"OK" : L"FAILED", numFrames, backend.numUploads);
+
+    // LRU eviction under memory pressure
+    size_t fullSize = textures[0]->MipChainSize(0);
+    size_t memoryBudget = fullSize + fullSize / 2;
+    streamer.SetMemoryBudget(memoryBudget);
+
+    textures[1] = streamer.Register(filenames[1], nullptr);
+    textures[2] = streamer.Register(filenames[2], nullptr);
+
+    bool withinBudgets = true;
+    UpdateUntilSettled(streamer, &textures[1], 1, TEST_IMAGE_SIZE, memoryBudget, withinBudgets);
+
+    bool evictionOK = withinBudgets &&
+        textures[0]->GetResidentMip() == textures[0]->GetTailMip() &&
+        textures[1]->GetResidentMip() == 0 &&
+        textures[2]->GetResidentMip() == textures[2]->GetTailMip();
+    BE_LOG(L"LRU eviction: %ls (%hs resident)\n", evictionOK ? L"OK" : L"FAILED", BE1::Str::FormatBytes((int)streamer.GetStats().residentSize).c_str());
+
+    // Textures used in the last frame are never evicted, they stay at the mips that fit
+    withinBudgets = true;
+    UpdateUntilSettled(streamer, &textures[1], 2, TEST_IMAGE_SIZE, memoryBudget, withinBudgets);
+    BE_LOG(L"memory budget: %ls (mips %i, %i)\n", withinBudgets && textures[1]->GetResidentMip() == 0 ? L"OK" : L"FAILED",
+        textures[1]->GetResidentMip(), textures[2]->GetResidentMip());
+
+    // Smaller screen size doesn't ask finer mips
+    BE1::StreamedTexture *smallTexture = textures[0];
+    withinBudgets = true;
+    streamer.SetMemoryBudget(fullSize * 4);
+    UpdateUntilSettled(streamer, &smallTexture, 1, TEST_IMAGE_SIZE / 4, fullSize * 4, withinBudgets);
+    BE_LOG(L"screen size: %ls (resident mip %i)\n", smallTexture->GetResidentMip() == 2 ? L"OK" : L"FAILED", smallTexture->GetResidentMip());
+
+    // Missing files fail
+    BE1::StreamedTexture *missingTexture = streamer.Register("TestTextureStreaming_missing.tga", nullptr);
+    streamer.WaitRequests();
+    streamer.Update();
+    BE_LOG(L"missing file: %ls\n", missingTexture->IsFailed() ? L"OK" : L"FAILED");
+
+    streamer.Shutdown();
+
+    for (int i = 0; i < COUNT_OF(filenames); i++) {
+        BE1::fileSystem.RemoveFile(filenames[i], false);
+    }
+
+    // Streamed textures report their size from the file header before the first decode
+    const char *headerFilenames[] = { "TestTextureStreaming.tga", "TestTextureStreaming.png", "TestTextureStreaming.jpg", "TestTextureStreaming.bmp", "TestTextureStreaming.dds" };
+    bool dimensionsOK = true;
+    for (int i = 0; i < COUNT_OF(headerFilenames); i++) {
+        WriteTestImage(headerFilenames[i], 300, 200);
+
+        int width = 0, height = 0;
+        if (!BE1::Image::LoadDimensions(headerFilenames[i], &width, &height) || width != 300 || height != 200) {
+            BE_LOG(L"LoadDimensions: '%hs' %ix%i\n", headerFilenames[i], width, height);
+            dimensionsOK = false;
+        }
+
+        BE1::fileSystem.RemoveFile(headerFilenames[i], false);
+    }
+    BE_LOG(L"image dimensions: %ls\n", dimensionsOK ? L"OK" : L"FAILED");
+}
@@ -0,0 +1,151 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestTransformSystem.h"
+
+#define ENTITY_COUNT        50000
+#define CHAIN_LENGTH        10
+#define FRAME_COUNT         10
+
+static BE1::Vec3 RandomVec3(float extent) {
+    return BE1::Vec3(BE1::Math::Random(-extent, extent), BE1::Math::Random(-extent, extent), BE1::Math::Random(-extent, extent));
+}
+
+// Every CHAIN_LENGTH entities make a chain of parent and child
+static void SpawnEntities(BE1::EntityPtrArray &entities) {
+    BE1::Guid parentGuid;
+
+    for (int i = 0; i < ENTITY_COUNT; i++) {
+        BE1::Guid entityGuid = BE1::Guid::CreateGuid();
+
+        Json::Value entityValue;
+        entityValue["classname"] = BE1::Entity::metaObject.ClassName();
+        entityValue["guid"] = entityGuid.ToString();
+        entityValue["parent"] = (i % CHAIN_LENGTH) ? parentGuid.ToString() : BE1::Guid::zero.ToString();
+        entityValue["name"] = BE1::va("Entity %i", i);
+
+        Json::Value &transformValue = entityValue["components"][0];
+        transformValue["classname"] = BE1::ComTransform::metaObject.ClassName();
+        transformValue["guid"] = BE1::Guid::CreateGuid().ToString();
+        transformValue["origin"] = RandomVec3(10.0f).ToString();
+        transformValue["angles"] = RandomVec3(30.0f).ToString();
+
+        entities.Append(BE1::Entity::CreateEntity(entityValue));
+
+        parentGuid = entityGuid;
+    }
+}
+
+// World matrix computed from the local matrices of the whole parent chain
+static BE1::Mat3x4 ExpectedWorldMatrix(const BE1::ComTransform *transform) {
+    BE1::Mat3x4 worldMatrix = transform->GetLocalMatrix();
+    for (const BE1::ComTransform *parent = transform->GetParent(); parent; parent = parent->GetParent()) {
+        worldMatrix = parent->GetLocalMatrix() * worldMatrix;
+    }
+    return worldMatrix;
+}
+
+static bool CheckWorldMatrices(const BE1::EntityPtrArray &entities) {
+    for (int i = 0; i < entities.Count(); i++) {
+        const BE1::ComTransform *transform = entities[i]->GetTransform();
+        if (!transform->GetMatrix().Equals(ExpectedWorldMatrix(transform), 0.01f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Moves all root transforms and reads back every world matrix, as a frame of the game would do
+static uint64_t MoveEntities(const BE1::EntityPtrArray &entities, BE1::TransformSystem *transformSystem, float offset) {
+    uint64_t start = BE1::PlatformTime::Microseconds();
+
+    for (int i = 0; i < entities.Count(); i += CHAIN_LENGTH) {
+        BE1::ComTransform *transform = entities[i]->GetTransform();
+        transform->SetLocalOrigin(transform->GetLocalOrigin() + BE1::Vec3(offset, 0, 0));
+    }
+
+    if (transformSystem) {
+        transformSystem->Update();
+    }
+
+    for (int i = 0; i < entities.Count(); i++) {
+        entities[i]->GetTransform()->GetMatrix();
+    }
+
+    return BE1::PlatformTime::Microseconds() - start;
+}
+
+void TestTransformSystem() {
+    BE1::EntityPtrArray entities;
+    SpawnEntities(entities);
+
+    // Recursive world matrix update
+    uint64_t recursiveTime = 0;
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        recursiveTime += MoveEntities(entities, nullptr, 1.0f);
+    }
+
+    // Attaching reads the world matrix of each new transform while the hierarchy order is pending,
+    // it should stay linear with the number of transforms.
+    BE1::TransformSystem transformSystem;
+    transformSystem.SetEnabled(true);
+
+    bool resolvedOK = true;
+
+    uint64_t start = BE1::PlatformTime::Microseconds();
+
+    for (int i = 0; i < entities.Count(); i++) {
+        BE1::ComTransform *transform = entities[i]->GetTransform();
+        transform->AttachTransformSystem(&transformSystem);
+
+        transform->SetLocalOrigin(transform->GetLocalOrigin() - BE1::Vec3(1.0f, 0, 0));
+        resolvedOK &= transform->GetMatrix().Equals(ExpectedWorldMatrix(transform), 0.01f);
+    }
+
+    uint64_t attachTime = BE1::PlatformTime::Microseconds() - start;
+
+    // Batched world matrix update
+    uint64_t batchedTime = 0;
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        batchedTime += MoveEntities(entities, &transformSystem, 1.0f);
+    }
+
+    bool updatedOK = CheckWorldMatrices(entities);
+
+    // Changes pending before the update should be resolved on demand
+    for (int i = 0; i < entities.Count(); i += CHAIN_LENGTH) {
+        BE1::ComTransform *transform = entities[i]->GetTransform();
+        transform->SetLocalOrigin(transform->GetLocalOrigin() + BE1::Vec3(0, 1.0f, 0));
+    }
+
+    bool pendingOK = CheckWorldMatrices(entities);
+
+    // Detach children first, so they can still resolve the pending changes of their parents
+    for (int i = entities.Count() - 1; i >= 0; i--) {
+        entities[i]->GetTransform()->DetachTransformSystem();
+    }
+
+    bool detachedOK = transformSystem.NumTransforms() == 0 && CheckWorldMatrices(entities);
+
+    BE_LOG(L"TransformSystem: %i transforms, attach %ls, update %ls, pending %ls, detach %ls\n", ENTITY_COUNT,
+        resolvedOK ? L"OK" : L"FAILED", updatedOK ? L"OK" : L"FAILED", pendingOK ? L"OK" : L"FAILED", detachedOK ? L"OK" : L"FAILED");
+    BE_LOG(L"TransformSystem: attach %llu us, recursive %llu us/frame, batched %llu us/frame\n",
+        attachTime, recursiveTime / FRAME_COUNT, batchedTime / FRAME_COUNT);
+
+    // Destroy children first
+    for (int i = entities.Count() - 1; i >= 0; i--) {
+        BE1::Entity::DestroyInstanceImmediate(entities[i]);
+    }
+}
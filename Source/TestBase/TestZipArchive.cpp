@@ -0,0 +1,193 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestZipArchive.h"
+
+#define ZIP_FILENAME        "TestZipArchive.zip"
+#define CORRUPTED_FILENAME  "TestZipArchive_Corrupted.zip"
+#define STORED_FILENAME     "TestZipArchive_Stored.bin"
+#define DEFLATED_FILENAME   "TestZipArchive_Deflated.bin"
+#define STORED_SIZE         (256 * 1024)
+#define DEFLATED_SIZE       (1024 * 1024)
+#define NUM_READS           64
+
+// Returns the offset of the end of central directory record, -1 if not found.
+static int FindEndOfCentralDir(const BE1::Array<byte> &data) {
+    for (int offset = data.Count() - 22; offset >= 0; offset--) {
+        if (!memcmp(&data[offset], "PK\x05\x06", 4)) {
+            return offset;
+        }
+    }
+    return -1;
+}
+
+// Returns the offset of the central header of the entry, -1 if not found.
+static int FindCentralHeader(const BE1::Array<byte> &data, const char *entryName) {
+    int eocdOffset = FindEndOfCentralDir(data);
+    if (eocdOffset < 0) {
+        return -1;
+    }
+
+    uint32_t centralDirOffset;
+    memcpy(&centralDirOffset, &data[eocdOffset + 16], sizeof(centralDirOffset));
+
+    for (int offset = centralDirOffset; offset + 46 <= eocdOffset; ) {
+        uint16_t lengths[3];
+        memcpy(lengths, &data[offset + 28], sizeof(lengths));
+
+        if (lengths[0] == strlen(entryName) && !memcmp(&data[offset + 46], entryName, lengths[0])) {
+            return offset;
+        }
+        offset += 46 + lengths[0] + lengths[1] + lengths[2];
+    }
+    return -1;
+}
+
+// Writes the archive with the 4 bytes at the offset replaced, and tries to open it.
+static bool OpenCorrupted(const BE1::Array<byte> &data, int offset, uint32_t value, int size, BE1::ZipArchive &archive) {
+    BE1::Array<byte> corruptedData = data;
+    memcpy(&corruptedData[offset], &value, sizeof(value));
+    BE1::fileSystem.WriteFile(CORRUPTED_FILENAME, corruptedData.Ptr(), size);
+
+    return archive.Open(BE1::fileSystem.ToAbsolutePath(CORRUPTED_FILENAME));
+}
+
+static bool ReadEntry(const BE1::ZipArchive &archive, int index, const byte *referenceData, size_t size, byte *buffer) {
+    BE1::File *file = archive.OpenEntry(index, archive.GetEntry(index).name);
+    if (!file) {
+        return false;
+    }
+
+    bool matched = file->Size() == size && file->Read(buffer, size) == size && !memcmp(buffer, referenceData, size);
+
+    // Seeking backward restarts inflating from the start
+    matched = matched && file->Seek(size / 2) == 0 && file->Read(buffer, size - size / 2) == size - size / 2 &&
+        !memcmp(buffer, referenceData + size / 2, size - size / 2);
+
+    BE1::fileSystem.CloseFile(file);
+    return matched;
+}
+
+void TestZipArchive() {
+    BE_LOG(L"--- TestZipArchive ---\n");
+
+    // Random data is stored, and repeating data is deflated
+    byte *storedData = (byte *)BE1::Mem_Alloc(STORED_SIZE);
+    for (int i = 0; i < STORED_SIZE; i++) {
+        storedData[i] = (byte)((i * 2654435761u) >> 13);
+    }
+    byte *deflatedData = (byte *)BE1::Mem_Alloc(DEFLATED_SIZE);
+    for (int i = 0; i < DEFLATED_SIZE; i++) {
+        deflatedData[i] = (byte)((i % 251) ^ (i / 4096));
+    }
+
+    BE1::fileSystem.WriteFile(STORED_FILENAME, storedData, STORED_SIZE);
+    BE1::fileSystem.WriteFile(DEFLATED_FILENAME, deflatedData, DEFLATED_SIZE);
+
+    BE1::ZipArchiver archiver;
+    bool archived = archiver.Open(ZIP_FILENAME) &&
+        archiver.AddFile(STORED_FILENAME, BE1::ZipArchiver::NoCompression) &&
+        archiver.AddFile(DEFLATED_FILENAME, BE1::ZipArchiver::DefaultCompression);
+    archiver.Close();
+
+    // Open and lookup
+    BE1::ZipArchive archive;
+    bool opened = archived && archive.Open(BE1::fileSystem.ToAbsolutePath(ZIP_FILENAME));
+
+    // Names are case insensitive
+    BE1::Str upperDeflatedFilename = DEFLATED_FILENAME;
+    upperDeflatedFilename.ToUpper();
+
+    int storedIndex = opened ? archive.FindEntry(STORED_FILENAME) : -1;
+    int deflatedIndex = opened ? archive.FindEntry(upperDeflatedFilename) : -1;
+
+    bool found = opened && archive.NumEntries() == 2 && storedIndex >= 0 && deflatedIndex >= 0 && archive.FindEntry("TestZipArchive_Missing.bin") == -1 &&
+        archive.GetEntry(storedIndex).method == BE1::ZipEntry::Stored && archive.GetEntry(deflatedIndex).method == BE1::ZipEntry::Deflated;
+
+    BE_LOG(L"open and lookup: %ls\n", found ? L"OK" : L"FAILED");
+
+    // Concurrent reads of the entries, stored entries are read from the mapping
+    std::atomic<int> numFailed(0);
+
+    if (found) {
+        bool mapped = archive.IsMappedData(archive.GetEntryData(storedIndex)) && archive.IsMappedData(archive.GetEntryData(deflatedIndex));
+        numFailed += mapped ? 0 : 1;
+
+        BE1::jobSystem.ParallelFor(NUM_READS, 1, [&](int first, int last) {
+            byte *buffer = (byte *)BE1::Mem_Alloc(DEFLATED_SIZE);
+            for (int i = first; i < last; i++) {
+                bool matched = (i & 1) ?
+                    ReadEntry(archive, storedIndex, storedData, STORED_SIZE, buffer) :
+                    ReadEntry(archive, deflatedIndex, deflatedData, DEFLATED_SIZE, buffer);
+                numFailed += matched ? 0 : 1;
+            }
+            BE1::Mem_Free(buffer);
+        });
+    }
+
+    BE_LOG(L"%i concurrent reads: %ls\n", NUM_READS, found && numFailed == 0 ? L"OK" : L"FAILED");
+
+    // Corrupted archives
+    BE1::Array<byte> data;
+    byte *loadedData = nullptr;
+    size_t loadedSize = BE1::fileSystem.LoadFile(ZIP_FILENAME, false, (void **)&loadedData);
+    if (loadedData) {
+        data.SetCount((int)loadedSize);
+        memcpy(data.Ptr(), loadedData, loadedSize);
+        BE1::fileSystem.FreeFile(loadedData);
+    }
+
+    archive.Close();
+
+    int eocdOffset = FindEndOfCentralDir(data);
+    int deflatedHeaderOffset = FindCentralHeader(data, DEFLATED_FILENAME);
+
+    BE1::ZipArchive corruptedArchive;
+    bool rejected = eocdOffset >= 0 && deflatedHeaderOffset >= 0;
+    if (rejected) {
+        // More entries than the central directory can hold
+        rejected &= !OpenCorrupted(data, eocdOffset + 8, 0xFFFFFFFF, data.Count(), corruptedArchive);
+        // Central directory outside of the file
+        rejected &= !OpenCorrupted(data, eocdOffset + 16, 0xFFFFFFF0, data.Count(), corruptedArchive);
+        // Truncated file without the end of central directory record
+        rejected &= !OpenCorrupted(data, 0, 0x04034b50, eocdOffset, corruptedArchive);
+    }
+
+    BE_LOG(L"corrupted directory: %ls\n", rejected ? L"rejected" : L"ACCEPTED");
+
+    // Deflated entry with a wrong CRC-32 fails to be read to the end
+    bool crcChecked = false;
+    if (deflatedHeaderOffset >= 0 && OpenCorrupted(data, deflatedHeaderOffset + 16, 0x12345678, data.Count(), corruptedArchive)) {
+        byte *buffer = (byte *)BE1::Mem_Alloc(DEFLATED_SIZE);
+        int index = corruptedArchive.FindEntry(DEFLATED_FILENAME);
+        BE1::File *file = index >= 0 ? corruptedArchive.OpenEntry(index, DEFLATED_FILENAME) : nullptr;
+        if (file) {
+            crcChecked = file->Read(buffer, DEFLATED_SIZE) != DEFLATED_SIZE;
+            BE1::fileSystem.CloseFile(file);
+        }
+        BE1::Mem_Free(buffer);
+        corruptedArchive.Close();
+    }
+
+    BE_LOG(L"CRC mismatch: %ls\n", crcChecked ? L"detected" : L"NOT DETECTED");
+
+    BE1::fileSystem.RemoveFile(ZIP_FILENAME, false);
+    BE1::fileSystem.RemoveFile(CORRUPTED_FILENAME, false);
+    BE1::fileSystem.RemoveFile(STORED_FILENAME, false);
+    BE1::fileSystem.RemoveFile(DEFLATED_FILENAME, false);
+
+    BE1::Mem_Free(storedData);
+    BE1::Mem_Free(deflatedData);
+}
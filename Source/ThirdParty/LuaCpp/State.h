@@ -20,6 +20,24 @@ public:
         HandleExceptionsPrintingToStdOut();
     }
     
+    State(lua_Alloc alloc, void *ud, bool should_open_libs) : 
+        _l(nullptr), 
+        _l_owner(true), 
+        _exception_handler(new ExceptionHandler) {
+        _l = lua_newstate(alloc, ud);
+        if (_l == nullptr) {
+            // LuaJIT on 64 bit platforms doesn't allow custom allocators
+            _l = luaL_newstate();
+        } else {
+            lua_atpanic(_l, _panic);
+        }
+        if (should_open_libs) {
+            luaL_openlibs(_l);
+        }
+        _registry.reset(new Registry(_l));
+        HandleExceptionsPrintingToStdOut();
+    }
+
     State(lua_State *l) : 
         _l(l), 
         _l_owner(false), 
@@ -151,6 +169,12 @@ public:
     friend std::ostream &operator<<(std::ostream &os, const State &state);
 
 private:
+    static int _panic(lua_State *l) {
+        const char *msg = lua_tostring(l, -1);
+        _print(std::string("PANIC: unprotected error in call to Lua API (") + (msg ? msg : "?") + ")");
+        return 0;
+    }
+
     static int _ldump_writer(lua_State *l, const void *p, size_t size, void *buff) {
         luaL_addlstring((luaL_Buffer *)buff, (const char *)p, size);
         return 0;